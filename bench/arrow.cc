@@ -0,0 +1,99 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief Arrow C Data Interface export benchmarks.
+ *
+ *  Arrays are copied from a prototype with timing paused, since the
+ *  export takes ownership of them, and released with timing paused,
+ *  so only the export itself is measured.
+ */
+
+#include <autocom.h>
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace com = autocom;
+
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Export copy of `prototype`, and release the result.
+ */
+void exportCopy(benchmark::State &state,
+    SAFEARRAY *prototype)
+{
+    for (auto _: state) {
+        state.PauseTiming();
+        SAFEARRAY *array = nullptr;
+        SafeArrayCopy(prototype, &array);
+        state.ResumeTiming();
+
+        ArrowArray out;
+        ArrowSchema schema;
+        com::exportArrow(std::move(array), &out, &schema);
+        benchmark::DoNotOptimize(out.buffers);
+
+        state.PauseTiming();
+        out.release(&out);
+        schema.release(&schema);
+        state.ResumeTiming();
+    }
+}
+
+}   /* anonymous */
+
+// BENCHMARKS
+// ----------
+
+
+/** \brief Export VT_R8 array, which is shared without copying.
+ */
+static void ArrowExportNumeric(benchmark::State &state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    SAFEARRAY *prototype = SafeArrayCreateVector(VT_R8, 0, static_cast<ULONG>(size));
+    DOUBLE *data;
+    SafeArrayAccessData(prototype, (void**) &data);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<DOUBLE>(i);
+    }
+    SafeArrayUnaccessData(prototype);
+
+    exportCopy(state, prototype);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    SafeArrayDestroy(prototype);
+}
+
+BENCHMARK(ArrowExportNumeric)->Range(1 << 10, 1 << 20);
+
+
+/** \brief Export VT_BSTR array, transcoded to UTF-8.
+ *
+ *  \param range(1)             Characters per string.
+ */
+static void ArrowExportBstr(benchmark::State &state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    const size_t length = static_cast<size_t>(state.range(1));
+    const std::wstring text(length, L'a');
+    SAFEARRAY *prototype = SafeArrayCreateVector(VT_BSTR, 0, static_cast<ULONG>(size));
+    BSTR *data;
+    SafeArrayAccessData(prototype, (void**) &data);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = SysAllocStringLen(text.data(), static_cast<UINT>(length));
+    }
+    SafeArrayUnaccessData(prototype);
+
+    exportCopy(state, prototype);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1) * sizeof(wchar_t));
+    SafeArrayDestroy(prototype);
+}
+
+BENCHMARK(ArrowExportBstr)->Args({1 << 10, 16})->Args({1 << 16, 16})->Args({1 << 10, 1024});
@@ -0,0 +1,257 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief IDispatch, enumeration and type information benchmarks.
+ */
+
+#include "fake.h"
+
+#include <autocom.h>
+#include <benchmark/benchmark.h>
+
+namespace com = autocom;
+
+
+// HELPERS
+// -------
+
+
+/** \brief Create fake server options from the benchmark arguments.
+ *
+ *  \param latency              Index of the latency, in nanoseconds.
+ *  \param payload              Index of the payload size, or -1.
+ */
+FakeOptions fakeOptions(const benchmark::State &state,
+    const int latency = 0,
+    const int payload = -1)
+{
+    FakeOptions options;
+    options.latency = std::chrono::nanoseconds(state.range(latency));
+    if (payload >= 0) {
+        options.payload = static_cast<size_t>(state.range(payload));
+        options.elements = options.payload;
+    }
+    return options;
+}
+
+// BENCHMARKS
+// ----------
+
+
+static void InvokeById(benchmark::State &state)
+{
+    com::DispatchBase dispatch(new FakeDispatch(fakeOptions(state)));
+    const com::Function id = FAKE_VALUE;
+    LONG value = 0;
+    for (auto _: state) {
+        dispatch.get(id, value);
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+BENCHMARK(InvokeById)->Arg(0)->Arg(1000)->Arg(10000);
+
+
+/** \brief Call by name, which resolves the DISPID before each call.
+ */
+static void InvokeByName(benchmark::State &state)
+{
+    com::DispatchBase dispatch(new FakeDispatch(fakeOptions(state)));
+    LONG value = 0;
+    for (auto _: state) {
+        dispatch.get(L"Value", value);
+        benchmark::DoNotOptimize(value);
+    }
+}
+
+BENCHMARK(InvokeByName)->Arg(0)->Arg(1000)->Arg(10000);
+
+
+static void InvokePut(benchmark::State &state)
+{
+    com::DispatchBase dispatch(new FakeDispatch(fakeOptions(state)));
+    const com::Function id = FAKE_VALUE;
+    LONG value = 0;
+    for (auto _: state) {
+        dispatch.put(id, ++value);
+    }
+}
+
+BENCHMARK(InvokePut)->Arg(0);
+
+
+/** \brief Call with three arguments, copied back from the server.
+ */
+static void InvokeEcho(benchmark::State &state)
+{
+    com::DispatchBase dispatch(new FakeDispatch(fakeOptions(state)));
+    const com::Function id = FAKE_ECHO;
+    com::Bstr text(std::string(64, 'a'));
+    for (auto _: state) {
+        dispatch.method(id, text, 1.0, LONG(2));
+    }
+}
+
+BENCHMARK(InvokeEcho)->Arg(0);
+
+
+/** \brief Fetch a string of `payload` characters.
+ */
+static void InvokeText(benchmark::State &state)
+{
+    com::DispatchBase dispatch(new FakeDispatch(fakeOptions(state, 0, 1)));
+    const com::Function id = FAKE_TEXT;
+    com::Bstr text;
+    for (auto _: state) {
+        dispatch.get(id, text);
+        benchmark::DoNotOptimize(text.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1) * sizeof(wchar_t));
+}
+
+BENCHMARK(InvokeText)->Args({0, 16})->Args({0, 4096})->Args({0, 1 << 20});
+
+
+/** \brief Fetch an array of `payload` doubles, and sum it.
+ *
+ *  The SafeArray takes ownership of the result.
+ */
+static void InvokeArray(benchmark::State &state)
+{
+    FakeDispatch *fake = new FakeDispatch(fakeOptions(state, 0, 1));
+    com::DispatchBase dispatch(fake);
+    DISPPARAMS params = {nullptr, nullptr, 0, 0};
+    for (auto _: state) {
+        VARIANT result;
+        VariantInit(&result);
+        fake->Invoke(FAKE_ARRAY, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_PROPERTYGET, &params, &result, nullptr, nullptr);
+        com::SafeArray<DOUBLE> array(result);
+        DOUBLE sum = 0;
+        for (DOUBLE value: array) {
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+BENCHMARK(InvokeArray)->Args({0, 16})->Args({0, 4096})->Args({0, 1 << 20});
+
+
+/** \brief Call by DISPID with tracing disabled or enabled.
+ */
+static void InvokeTraced(benchmark::State &state)
+{
+    com::DispatchBase dispatch(new FakeDispatch());
+    const com::Function id = FAKE_VALUE;
+    LONG value = 0;
+    com::trace::enable(state.range(0) != 0);
+    for (auto _: state) {
+        dispatch.get(id, value);
+        benchmark::DoNotOptimize(value);
+    }
+    com::trace::enable(false);
+    com::trace::clear();
+}
+
+BENCHMARK(InvokeTraced)->Arg(0)->Arg(1);
+
+
+/** \brief Probe a property which is missing for half the calls.
+ *
+ *  Compares catching the exception thrown by `getV` (0) to checking
+ *  the HRESULT from `tryGet` (1).
+ */
+static void InvokeProbe(benchmark::State &state)
+{
+    com::DispatchBase dispatch(new FakeDispatch());
+    const com::Function ids[2] = {FAKE_VALUE, 100};
+    const bool throwing = state.range(0) == 0;
+    size_t index = 0;
+    LONG failures = 0;
+    for (auto _: state) {
+        const com::Function id = ids[index++ & 1];
+        if (throwing) {
+            LONG value = 0;
+            try {
+                dispatch.getV(id, value);
+            } catch (std::exception&) {
+                ++failures;
+            }
+            benchmark::DoNotOptimize(value);
+        } else {
+            auto value = dispatch.tryGet<LONG>(id);
+            failures += value.failed();
+            benchmark::DoNotOptimize(value);
+        }
+    }
+    benchmark::DoNotOptimize(failures);
+}
+
+BENCHMARK(InvokeProbe)->Arg(0)->Arg(1);
+
+
+static void DispParamsConstruct(benchmark::State &state)
+{
+    for (auto _: state) {
+        com::DispParams dp;
+        dp.setArgs(LONG(1), 2.0);
+        benchmark::DoNotOptimize(dp.params());
+    }
+}
+
+BENCHMARK(DispParamsConstruct);
+
+
+/** \brief Construct parameters with a string argument, which is copied.
+ */
+static void DispParamsString(benchmark::State &state)
+{
+    com::Bstr text(std::string(static_cast<size_t>(state.range(0)), 'a'));
+    for (auto _: state) {
+        com::DispParams dp;
+        dp.setArgs(text, LONG(1));
+        benchmark::DoNotOptimize(dp.params());
+    }
+}
+
+BENCHMARK(DispParamsString)->Arg(16)->Arg(4096);
+
+
+/** \brief Iterate over `elements` items from a fake enumerator.
+ */
+static void Enumerate(benchmark::State &state)
+{
+    FakeDispatch *fake = new FakeDispatch(fakeOptions(state, 0, 1));
+    com::DispatchBase dispatch(fake);
+    for (auto _: state) {
+        com::EnumVariant items(com::newEnumVariant(fake));
+        size_t count = 0;
+        for (auto it = items.begin(); it != items.end(); ++it) {
+            ++count;
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+BENCHMARK(Enumerate)->Args({0, 1024})->Args({1000, 1024});
+
+
+static void TypeInfoAttributes(benchmark::State &state)
+{
+    FakeDispatch *fake = new FakeDispatch();
+    com::DispatchBase dispatch(fake);
+    com::TypeInfo info(com::newTypeInfo(fake));
+    for (auto _: state) {
+        auto attr = info.attr();
+        for (WORD i = 0; i < attr.functions(); ++i) {
+            auto desc = info.funcdesc(i);
+            benchmark::DoNotOptimize(info.names(desc.id()));
+            benchmark::DoNotOptimize(info.documentation(desc.id()));
+        }
+    }
+}
+
+BENCHMARK(TypeInfoAttributes);
@@ -0,0 +1,115 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief Event sink benchmarks.
+ *
+ *  Events are delivered straight to the sink's `IDispatch::Invoke`,
+ *  as a connection point would, to measure handler lookup and the
+ *  cost of queueing arguments.
+ */
+
+#include <autocom.h>
+#include <benchmark/benchmark.h>
+
+namespace com = autocom;
+
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Raise event with a number and a string.
+ */
+HRESULT raiseEvent(IDispatch *sink,
+    const DISPID id,
+    VARIANT *arguments)
+{
+    DISPPARAMS params = {arguments, nullptr, 2, 0};
+    return sink->Invoke(id, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &params, nullptr, nullptr, nullptr);
+}
+
+}   /* anonymous */
+
+// BENCHMARKS
+// ----------
+
+
+/** \brief Deliver event to a handler, among `range(0)` handlers.
+ */
+static void EventSinkInvoke(benchmark::State &state)
+{
+    com::EventSink sink;
+    LONG total = 0;
+    const DISPID count = static_cast<DISPID>(state.range(0));
+    for (DISPID id = 1; id <= count; ++id) {
+        sink.on(id, [&total](DISPPARAMS &params) {
+            total += params.rgvarg[1].lVal;
+        });
+    }
+
+    VARIANT arguments[2];
+    arguments[0].vt = VT_BSTR;
+    arguments[0].bstrVal = SysAllocString(L"status");
+    arguments[1].vt = VT_I4;
+    arguments[1].lVal = 1;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(raiseEvent(sink.dispatch(), count, arguments));
+    }
+    benchmark::DoNotOptimize(total);
+
+    SysFreeString(arguments[0].bstrVal);
+}
+
+BENCHMARK(EventSinkInvoke)->Arg(1)->Arg(16)->Arg(256);
+
+
+/** \brief Deliver event to a queue, drained by the same thread.
+ */
+static void EventSinkForward(benchmark::State &state)
+{
+    com::EventQueue queue(64);
+    com::EventSink sink;
+    sink.forward(&queue);
+
+    VARIANT arguments[2];
+    arguments[0].vt = VT_BSTR;
+    arguments[0].bstrVal = SysAllocString(L"status");
+    arguments[1].vt = VT_I4;
+    arguments[1].lVal = 1;
+    com::Event event;
+    for (auto _: state) {
+        raiseEvent(sink.dispatch(), 1, arguments);
+        queue.pop(event);
+    }
+    benchmark::DoNotOptimize(event.arguments.data());
+
+    SysFreeString(arguments[0].bstrVal);
+}
+
+BENCHMARK(EventSinkForward);
+
+
+/** \brief Push and pop numeric events, without string copies.
+ */
+static void EventQueuePushPop(benchmark::State &state)
+{
+    com::EventQueue queue(64);
+    VARIANT arguments[2];
+    arguments[0].vt = VT_R8;
+    arguments[0].dblVal = 0.5;
+    arguments[1].vt = VT_I4;
+    arguments[1].lVal = 1;
+    DISPPARAMS params = {arguments, nullptr, 2, 0};
+
+    com::Event event;
+    for (auto _: state) {
+        queue.push(1, params);
+        queue.pop(event);
+    }
+    benchmark::DoNotOptimize(event.arguments.data());
+}
+
+BENCHMARK(EventQueuePushPop);
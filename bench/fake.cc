@@ -0,0 +1,604 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief In-process fake automation server.
+ */
+
+#include "fake.h"
+
+#include <cwctype>
+
+
+namespace
+{
+// OBJECTS
+// -------
+
+
+/** \brief Description of a member of the fake server.
+ */
+struct Member
+{
+    DISPID id;
+    const wchar_t *name;
+    const wchar_t *doc;
+    INVOKEKIND kind;
+    VARTYPE vt;
+    SHORT parameters;
+};
+
+// CONSTANTS
+// ---------
+
+const Member MEMBERS[] = {
+    {FAKE_VALUE, L"Value", L"Integer property.", INVOKE_PROPERTYGET, VT_I4, 0},
+    {FAKE_TEXT, L"Text", L"String property.", INVOKE_PROPERTYGET, VT_BSTR, 0},
+    {FAKE_ARRAY, L"Array", L"Array property.", INVOKE_PROPERTYGET, VT_ARRAY | VT_R8, 0},
+    {FAKE_ECHO, L"Echo", L"Return the first argument.", INVOKE_FUNC, VT_VARIANT, 1},
+};
+
+const size_t MEMBER_COUNT = sizeof(MEMBERS) / sizeof(Member);
+
+// HELPERS
+// -------
+
+
+/** \brief Compare member names, ignoring case, like most servers.
+ */
+bool equalName(const wchar_t *left,
+    const wchar_t *right)
+{
+    for (; *left && *right; ++left, ++right) {
+        if (std::towlower(*left) != std::towlower(*right)) {
+            return false;
+        }
+    }
+    return *left == *right;
+}
+
+
+/** \brief Find member by name, or null if not found.
+ */
+const Member * findMember(const wchar_t *name)
+{
+    for (const Member &member: MEMBERS) {
+        if (equalName(member.name, name)) {
+            return &member;
+        }
+    }
+    return nullptr;
+}
+
+
+/** \brief Find member by identifier, or null if not found.
+ */
+const Member * findMember(const MEMBERID id)
+{
+    for (const Member &member: MEMBERS) {
+        if (member.id == id) {
+            return &member;
+        }
+    }
+    return nullptr;
+}
+
+
+/** \brief Create string of `length` characters.
+ */
+BSTR newText(const size_t length)
+{
+    BSTR text = SysAllocStringLen(nullptr, static_cast<UINT>(length));
+    for (size_t i = 0; i < length; ++i) {
+        text[i] = L'a' + static_cast<wchar_t>(i % 26);
+    }
+    return text;
+}
+
+
+/** \brief Create VT_R8 array of `length` elements.
+ */
+SAFEARRAY * newArray(const size_t length)
+{
+    SAFEARRAY *array = SafeArrayCreateVector(VT_R8, 0, static_cast<ULONG>(length));
+    DOUBLE *data;
+    SafeArrayAccessData(array, reinterpret_cast<void**>(&data));
+    for (size_t i = 0; i < length; ++i) {
+        data[i] = static_cast<DOUBLE>(i);
+    }
+    SafeArrayUnaccessData(array);
+
+    return array;
+}
+
+}   /* anonymous */
+
+// OBJECTS
+// -------
+
+
+FakeDispatch::FakeDispatch(const FakeOptions &options):
+    FakeObject<IDispatch>(options)
+{}
+
+
+HRESULT STDMETHODCALLTYPE FakeDispatch::QueryInterface(REFIID iid,
+    void **ppv)
+{
+    if (IsEqualIID(iid, IID_IUnknown) || IsEqualIID(iid, IID_IDispatch)) {
+        AddRef();
+        *ppv = static_cast<IDispatch*>(this);
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeDispatch::GetTypeInfoCount(UINT *count)
+{
+    *count = 1;
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeDispatch::GetTypeInfo(UINT index,
+    LCID locale,
+    ITypeInfo **info)
+{
+    if (index != 0) {
+        *info = nullptr;
+        return DISP_E_BADINDEX;
+    }
+
+    *info = new FakeTypeInfo(options);
+    return S_OK;
+}
+
+
+/** \brief Resolve member names, ignoring case.
+ */
+HRESULT STDMETHODCALLTYPE FakeDispatch::GetIDsOfNames(REFIID iid,
+    LPOLESTR *names,
+    UINT count,
+    LCID locale,
+    DISPID *ids)
+{
+    wait();
+
+    HRESULT hr = S_OK;
+    for (UINT i = 0; i < count; ++i) {
+        const Member *member = findMember(names[i]);
+        if (member) {
+            ids[i] = member->id;
+        } else {
+            ids[i] = DISPID_UNKNOWN;
+            hr = DISP_E_UNKNOWNNAME;
+        }
+    }
+
+    return hr;
+}
+
+
+/** \brief Call member, after waiting for the configured latency.
+ */
+HRESULT STDMETHODCALLTYPE FakeDispatch::Invoke(DISPID member,
+    REFIID iid,
+    LCID locale,
+    WORD flags,
+    DISPPARAMS *params,
+    VARIANT *result,
+    EXCEPINFO *exception,
+    UINT *error)
+{
+    wait();
+
+    const bool put = (flags & (DISPATCH_PROPERTYPUT | DISPATCH_PROPERTYPUTREF)) != 0;
+    VARIANT scratch;
+    if (!result) {
+        result = &scratch;
+    }
+    VariantInit(result);
+
+    switch (member) {
+        case DISPID_NEWENUM:
+            result->vt = VT_UNKNOWN;
+            result->punkVal = new FakeEnum(this, options);
+            break;
+        case FAKE_VALUE:
+            if (put) {
+                VARIANT converted;
+                VariantInit(&converted);
+                if (params->cArgs < 1 || FAILED(VariantChangeType(&converted, &params->rgvarg[0], 0, VT_I4))) {
+                    return DISP_E_TYPEMISMATCH;
+                }
+                value = converted.lVal;
+            } else {
+                result->vt = VT_I4;
+                result->lVal = value;
+            }
+            break;
+        case FAKE_TEXT:
+            if (!put) {
+                result->vt = VT_BSTR;
+                result->bstrVal = newText(options.payload);
+            }
+            break;
+        case FAKE_ARRAY:
+            if (!put) {
+                result->vt = VT_ARRAY | VT_R8;
+                result->parray = newArray(options.payload);
+            }
+            break;
+        case FAKE_ECHO:
+            if (params->cArgs > 0) {
+                // arguments are stored in reverse order
+                VariantCopy(result, &params->rgvarg[params->cArgs - 1]);
+            }
+            break;
+        default:
+            return DISP_E_MEMBERNOTFOUND;
+    }
+
+    if (result == &scratch) {
+        VariantClear(&scratch);
+    }
+
+    return S_OK;
+}
+
+
+FakeEnum::FakeEnum(IDispatch *item,
+        const FakeOptions &options):
+    FakeObject<IEnumVARIANT>(options),
+    item(item)
+{
+    item->AddRef();
+}
+
+
+FakeEnum::~FakeEnum()
+{
+    item->Release();
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeEnum::QueryInterface(REFIID iid,
+    void **ppv)
+{
+    if (IsEqualIID(iid, IID_IUnknown) || IsEqualIID(iid, IID_IEnumVARIANT)) {
+        AddRef();
+        *ppv = static_cast<IEnumVARIANT*>(this);
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+
+/** \brief Fetch up to `count` items.
+ *
+ *  Items past the end of the enumeration are set to VT_EMPTY.
+ */
+HRESULT STDMETHODCALLTYPE FakeEnum::Next(ULONG count,
+    VARIANT *items,
+    ULONG *fetched)
+{
+    wait();
+
+    ULONG index = 0;
+    for (; index < count && position < options.elements; ++index, ++position) {
+        item->AddRef();
+        items[index].vt = VT_DISPATCH;
+        items[index].pdispVal = item;
+    }
+    for (ULONG i = index; i < count; ++i) {
+        VariantInit(&items[i]);
+    }
+
+    if (fetched) {
+        *fetched = index;
+    }
+    return index == count ? S_OK : S_FALSE;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeEnum::Skip(ULONG count)
+{
+    const ULONG remaining = static_cast<ULONG>(options.elements) - position;
+    if (count > remaining) {
+        position += remaining;
+        return S_FALSE;
+    }
+
+    position += count;
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeEnum::Reset()
+{
+    position = 0;
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeEnum::Clone(IEnumVARIANT **ppv)
+{
+    FakeEnum *clone = new FakeEnum(item, options);
+    clone->position = position;
+    *ppv = clone;
+
+    return S_OK;
+}
+
+
+FakeTypeInfo::FakeTypeInfo(const FakeOptions &options):
+    FakeObject<ITypeInfo>(options)
+{}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::QueryInterface(REFIID iid,
+    void **ppv)
+{
+    if (IsEqualIID(iid, IID_IUnknown) || IsEqualIID(iid, IID_ITypeInfo)) {
+        AddRef();
+        *ppv = static_cast<ITypeInfo*>(this);
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetTypeAttr(TYPEATTR **attr)
+{
+    wait();
+
+    TYPEATTR *value = new TYPEATTR();
+    value->lcid = LOCALE_USER_DEFAULT;
+    value->memidConstructor = MEMBERID_NIL;
+    value->memidDestructor = MEMBERID_NIL;
+    value->cbSizeInstance = sizeof(void*);
+    value->typekind = TKIND_DISPATCH;
+    value->cFuncs = static_cast<WORD>(MEMBER_COUNT);
+    value->cbSizeVft = 7 * sizeof(void*);
+    value->cbAlignment = sizeof(void*);
+    value->wMajorVerNum = 1;
+    *attr = value;
+
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetTypeComp(ITypeComp **comp)
+{
+    *comp = nullptr;
+    return E_NOTIMPL;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetFuncDesc(UINT index,
+    FUNCDESC **desc)
+{
+    wait();
+
+    if (index >= MEMBER_COUNT) {
+        *desc = nullptr;
+        return TYPE_E_ELEMENTNOTFOUND;
+    }
+
+    const Member &member = MEMBERS[index];
+    FUNCDESC *value = new FUNCDESC();
+    value->memid = member.id;
+    value->funckind = FUNC_DISPATCH;
+    value->invkind = member.kind;
+    value->callconv = CC_STDCALL;
+    value->cParams = member.parameters;
+    value->elemdescFunc.tdesc.vt = member.vt;
+    if (member.parameters) {
+        value->lprgelemdescParam = new ELEMDESC[member.parameters]();
+        for (SHORT i = 0; i < member.parameters; ++i) {
+            value->lprgelemdescParam[i].tdesc.vt = VT_VARIANT;
+        }
+    }
+    *desc = value;
+
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetVarDesc(UINT index,
+    VARDESC **desc)
+{
+    *desc = nullptr;
+    return TYPE_E_ELEMENTNOTFOUND;
+}
+
+
+/** \brief Get member name, and the names of its parameters.
+ */
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetNames(MEMBERID id,
+    BSTR *names,
+    UINT maximum,
+    UINT *count)
+{
+    wait();
+
+    const Member *member = findMember(id);
+    if (!member) {
+        *count = 0;
+        return TYPE_E_ELEMENTNOTFOUND;
+    }
+
+    UINT index = 0;
+    if (index < maximum) {
+        names[index++] = SysAllocString(member->name);
+    }
+    for (SHORT i = 0; i < member->parameters && index < maximum; ++i) {
+        names[index++] = SysAllocString(L"value");
+    }
+    *count = index;
+
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetRefTypeOfImplType(UINT index,
+    HREFTYPE *type)
+{
+    return TYPE_E_ELEMENTNOTFOUND;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetImplTypeFlags(UINT index,
+    INT *flags)
+{
+    return TYPE_E_ELEMENTNOTFOUND;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetIDsOfNames(LPOLESTR *names,
+    UINT count,
+    MEMBERID *ids)
+{
+    wait();
+
+    HRESULT hr = S_OK;
+    for (UINT i = 0; i < count; ++i) {
+        const Member *member = findMember(names[i]);
+        if (member) {
+            ids[i] = member->id;
+        } else {
+            ids[i] = MEMBERID_NIL;
+            hr = DISP_E_UNKNOWNNAME;
+        }
+    }
+
+    return hr;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::Invoke(PVOID instance,
+    MEMBERID member,
+    WORD flags,
+    DISPPARAMS *params,
+    VARIANT *result,
+    EXCEPINFO *exception,
+    UINT *error)
+{
+    return E_NOTIMPL;
+}
+
+
+/** \brief Get documentation for a member, or the type for MEMBERID_NIL.
+ */
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetDocumentation(MEMBERID id,
+    BSTR *name,
+    BSTR *doc,
+    DWORD *context,
+    BSTR *file)
+{
+    wait();
+
+    const wchar_t *memberName = L"FakeDispatch";
+    const wchar_t *memberDoc = L"In-process fake automation server.";
+    if (id != MEMBERID_NIL) {
+        const Member *member = findMember(id);
+        if (!member) {
+            return TYPE_E_ELEMENTNOTFOUND;
+        }
+        memberName = member->name;
+        memberDoc = member->doc;
+    }
+
+    if (name) {
+        *name = SysAllocString(memberName);
+    }
+    if (doc) {
+        *doc = SysAllocString(memberDoc);
+    }
+    if (context) {
+        *context = 0;
+    }
+    if (file) {
+        *file = nullptr;
+    }
+
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetDllEntry(MEMBERID member,
+    INVOKEKIND kind,
+    BSTR *dll,
+    BSTR *name,
+    WORD *ordinal)
+{
+    return TYPE_E_BADMODULEKIND;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetRefTypeInfo(HREFTYPE type,
+    ITypeInfo **info)
+{
+    *info = nullptr;
+    return E_NOTIMPL;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::AddressOfMember(MEMBERID member,
+    INVOKEKIND kind,
+    PVOID *ppv)
+{
+    *ppv = nullptr;
+    return E_NOTIMPL;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::CreateInstance(IUnknown *outer,
+    REFIID iid,
+    PVOID *ppv)
+{
+    *ppv = nullptr;
+    return E_NOTIMPL;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetMops(MEMBERID member,
+    BSTR *mops)
+{
+    *mops = nullptr;
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE FakeTypeInfo::GetContainingTypeLib(ITypeLib **tlib,
+    UINT *index)
+{
+    *tlib = nullptr;
+    return E_NOTIMPL;
+}
+
+
+void STDMETHODCALLTYPE FakeTypeInfo::ReleaseTypeAttr(TYPEATTR *attr)
+{
+    delete attr;
+}
+
+
+void STDMETHODCALLTYPE FakeTypeInfo::ReleaseFuncDesc(FUNCDESC *desc)
+{
+    delete[] desc->lprgelemdescParam;
+    delete desc;
+}
+
+
+void STDMETHODCALLTYPE FakeTypeInfo::ReleaseVarDesc(VARDESC *desc)
+{
+    delete desc;
+}
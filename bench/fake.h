@@ -0,0 +1,251 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief In-process fake automation server.
+ *
+ *  The fake server implements IDispatch, IEnumVARIANT and ITypeInfo
+ *  in-process, with a configurable latency per call and payload size,
+ *  so benchmarks measure AutoCOM rather than a registered server.
+ */
+
+#pragma once
+
+#include <oaidl.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+// CONSTANTS
+// ---------
+
+/** Members exposed by the fake server.
+ *
+ *  \param FAKE_VALUE           VT_I4 property.
+ *  \param FAKE_TEXT            VT_BSTR property of `payload` characters.
+ *  \param FAKE_ARRAY           VT_R8 array property of `payload` elements.
+ *  \param FAKE_ECHO            Method returning its first argument.
+ */
+enum FakeMember: DISPID
+{
+    FAKE_VALUE  = 1,
+    FAKE_TEXT   = 2,
+    FAKE_ARRAY  = 3,
+    FAKE_ECHO   = 4,
+};
+
+// OBJECTS
+// -------
+
+
+/** \brief Cost of each call to the fake server.
+ *
+ *  \param latency              Busy-wait before each call returns.
+ *  \param payload              Characters in Text, and elements in Array.
+ *  \param elements             Items returned by the enumerator.
+ */
+struct FakeOptions
+{
+    std::chrono::nanoseconds latency = std::chrono::nanoseconds(0);
+    size_t payload = 64;
+    size_t elements = 1024;
+};
+
+
+/** \brief Reference-counted base for fake COM objects.
+ */
+template <typename Base>
+class FakeObject: public Base
+{
+protected:
+    std::atomic<ULONG> references;
+    FakeOptions options;
+
+    void wait() const;
+
+public:
+    FakeObject(const FakeOptions &options);
+    virtual ~FakeObject() = default;
+
+    virtual ULONG STDMETHODCALLTYPE AddRef() override;
+    virtual ULONG STDMETHODCALLTYPE Release() override;
+};
+
+
+/** \brief Fake automation server, with the members in `FakeMember`.
+ *
+ *  Objects are created with a single reference, owned by the caller.
+ */
+class FakeDispatch: public FakeObject<IDispatch>
+{
+protected:
+    LONG value = 0;
+
+public:
+    FakeDispatch(const FakeOptions &options = FakeOptions());
+
+    // IUNKNOWN
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override;
+
+    // IDISPATCH
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfoCount(UINT *count) override;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfo(UINT index,
+        LCID locale,
+        ITypeInfo **info) override;
+    virtual HRESULT STDMETHODCALLTYPE GetIDsOfNames(REFIID iid,
+        LPOLESTR *names,
+        UINT count,
+        LCID locale,
+        DISPID *ids) override;
+    virtual HRESULT STDMETHODCALLTYPE Invoke(DISPID member,
+        REFIID iid,
+        LCID locale,
+        WORD flags,
+        DISPPARAMS *params,
+        VARIANT *result,
+        EXCEPINFO *exception,
+        UINT *error) override;
+};
+
+
+/** \brief Fake enumerator, yielding `elements` references to a server.
+ */
+class FakeEnum: public FakeObject<IEnumVARIANT>
+{
+protected:
+    IDispatch *item;
+    ULONG position = 0;
+
+public:
+    FakeEnum(IDispatch *item,
+        const FakeOptions &options = FakeOptions());
+    ~FakeEnum();
+
+    // IUNKNOWN
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override;
+
+    // IENUMVARIANT
+    virtual HRESULT STDMETHODCALLTYPE Next(ULONG count,
+        VARIANT *items,
+        ULONG *fetched) override;
+    virtual HRESULT STDMETHODCALLTYPE Skip(ULONG count) override;
+    virtual HRESULT STDMETHODCALLTYPE Reset() override;
+    virtual HRESULT STDMETHODCALLTYPE Clone(IEnumVARIANT **ppv) override;
+};
+
+
+/** \brief Fake type information, describing the members in `FakeMember`.
+ *
+ *  Type attributes, function descriptions, names and documentation
+ *  are supported, other methods return E_NOTIMPL.
+ */
+class FakeTypeInfo: public FakeObject<ITypeInfo>
+{
+public:
+    FakeTypeInfo(const FakeOptions &options = FakeOptions());
+
+    // IUNKNOWN
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override;
+
+    // ITYPEINFO
+    virtual HRESULT STDMETHODCALLTYPE GetTypeAttr(TYPEATTR **attr) override;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeComp(ITypeComp **comp) override;
+    virtual HRESULT STDMETHODCALLTYPE GetFuncDesc(UINT index,
+        FUNCDESC **desc) override;
+    virtual HRESULT STDMETHODCALLTYPE GetVarDesc(UINT index,
+        VARDESC **desc) override;
+    virtual HRESULT STDMETHODCALLTYPE GetNames(MEMBERID member,
+        BSTR *names,
+        UINT maximum,
+        UINT *count) override;
+    virtual HRESULT STDMETHODCALLTYPE GetRefTypeOfImplType(UINT index,
+        HREFTYPE *type) override;
+    virtual HRESULT STDMETHODCALLTYPE GetImplTypeFlags(UINT index,
+        INT *flags) override;
+    virtual HRESULT STDMETHODCALLTYPE GetIDsOfNames(LPOLESTR *names,
+        UINT count,
+        MEMBERID *ids) override;
+    virtual HRESULT STDMETHODCALLTYPE Invoke(PVOID instance,
+        MEMBERID member,
+        WORD flags,
+        DISPPARAMS *params,
+        VARIANT *result,
+        EXCEPINFO *exception,
+        UINT *error) override;
+    virtual HRESULT STDMETHODCALLTYPE GetDocumentation(MEMBERID member,
+        BSTR *name,
+        BSTR *doc,
+        DWORD *context,
+        BSTR *file) override;
+    virtual HRESULT STDMETHODCALLTYPE GetDllEntry(MEMBERID member,
+        INVOKEKIND kind,
+        BSTR *dll,
+        BSTR *name,
+        WORD *ordinal) override;
+    virtual HRESULT STDMETHODCALLTYPE GetRefTypeInfo(HREFTYPE type,
+        ITypeInfo **info) override;
+    virtual HRESULT STDMETHODCALLTYPE AddressOfMember(MEMBERID member,
+        INVOKEKIND kind,
+        PVOID *ppv) override;
+    virtual HRESULT STDMETHODCALLTYPE CreateInstance(IUnknown *outer,
+        REFIID iid,
+        PVOID *ppv) override;
+    virtual HRESULT STDMETHODCALLTYPE GetMops(MEMBERID member,
+        BSTR *mops) override;
+    virtual HRESULT STDMETHODCALLTYPE GetContainingTypeLib(ITypeLib **tlib,
+        UINT *index) override;
+    virtual void STDMETHODCALLTYPE ReleaseTypeAttr(TYPEATTR *attr) override;
+    virtual void STDMETHODCALLTYPE ReleaseFuncDesc(FUNCDESC *desc) override;
+    virtual void STDMETHODCALLTYPE ReleaseVarDesc(VARDESC *desc) override;
+};
+
+// IMPLEMENTATION
+// --------------
+
+
+/** \brief Busy-wait for the configured latency.
+ *
+ *  Sleeping has a resolution far coarser than a local COM call, so
+ *  the latency is spun instead.
+ */
+template <typename Base>
+void FakeObject<Base>::wait() const
+{
+    if (options.latency.count() == 0) {
+        return;
+    }
+
+    auto until = std::chrono::steady_clock::now() + options.latency;
+    while (std::chrono::steady_clock::now() < until)
+        ;
+}
+
+
+template <typename Base>
+FakeObject<Base>::FakeObject(const FakeOptions &options):
+    references(1),
+    options(options)
+{}
+
+
+template <typename Base>
+ULONG STDMETHODCALLTYPE FakeObject<Base>::AddRef()
+{
+    return ++references;
+}
+
+
+template <typename Base>
+ULONG STDMETHODCALLTYPE FakeObject<Base>::Release()
+{
+    ULONG count = --references;
+    if (count == 0) {
+        delete this;
+    }
+    return count;
+}
@@ -0,0 +1,163 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief Header layouts for the consumer compile-time benchmark.
+ *
+ *  Writes monolithic and sharded headers for a synthetic type library
+ *  into `monolithic` and `sharded` below the working directory, and a
+ *  consumer translation unit for each, which uses a single interface.
+ *  The build compiles both consumers with `--time` as the compiler
+ *  launcher, which reports the best of `REPEATS` compilations.
+ */
+
+#include <write.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace com = autocom;
+
+
+namespace
+{
+// CONSTANTS
+// ---------
+
+const int TYPES = 400;
+const int METHODS = 8;
+const int REPEATS = 5;
+
+// HELPERS
+// -------
+
+
+/** \brief Create description with `TYPES` records, interfaces and coclasses.
+ */
+com::TypeLibDescription createDescription()
+{
+    com::TypeLibDescription tlib;
+    GUID id = {0x12345678, 0x1234, 0x5678, {1, 2, 3, 4, 5, 6, 7, 8}};
+    tlib.guid = com::Guid(id);
+    tlib.documentation.name = "Shapes";
+
+    auto &description = tlib.description;
+    for (int i = 0; i < TYPES; ++i) {
+        auto suffix = std::to_string(i);
+
+        com::detail::Record record;
+        record.name = "Record" + suffix;
+        record.size = 16;
+        record.fields.emplace_back("LONG", "", "x");
+        record.fields.emplace_back("DOUBLE", "", "y");
+        description.records.emplace_back(record);
+
+        com::detail::Interface shape;
+        shape.name = "IShape" + suffix;
+        shape.flags = 0;
+        shape.base = "IUnknown";
+        shape.object = "IUnknown";
+        for (int j = 0; j < METHODS; ++j) {
+            com::detail::Function function;
+            function.returns = com::detail::Parameter("HRESULT");
+            function.name = "Method" + std::to_string(j);
+            function.id = j + 1;
+            function.offset = static_cast<SHORT>(24 + 8 * j);
+            function.args.emplace_back(record.name, "", "arg0");
+            function.args.emplace_back("LONG", "", "arg1");
+            function.args.emplace_back(shape.name + "*", "", "arg2");
+            shape.functions.emplace_back(function);
+        }
+        description.interfaces.emplace_back(shape);
+
+        com::detail::CoClass coclass;
+        coclass.name = "Shape" + suffix;
+        coclass.flags = 0;
+        coclass.interfaces.emplace_back(shape.name);
+        description.coclasses.emplace_back(coclass);
+    }
+
+    return tlib;
+}
+
+
+/** \brief Write consumer translation unit including `header`.
+ */
+void writeConsumer(const std::string &path,
+    const std::string &header)
+{
+    std::ofstream stream(path, std::ios::binary);
+    stream << "#include \"" << header << "\"\n\n"
+           << "ULONG release(shapes::IShape0 *shape)\n"
+           << "{\n"
+           << "    return shape->Release();\n"
+           << "}\n";
+}
+
+
+/** \brief Run compiler command `REPEATS` times and report the best time.
+ */
+int timeCommand(int argc,
+    char *argv[])
+{
+    std::string command;
+    std::string source;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.size() > 3 && arg.compare(arg.size() - 3, 3, ".cc") == 0) {
+            source = arg;
+        }
+        command += (i ? " \"" : "\"") + arg + "\"";
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto best = clock::duration::max();
+    for (int i = 0; i < REPEATS; ++i) {
+        auto start = clock::now();
+        if (std::system(command.data()) != 0) {
+            return EXIT_FAILURE;
+        }
+        best = std::min(best, clock::now() - start);
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(best);
+    std::cout << source << ": " << ms.count() << " ms (best of " << REPEATS << ")" << std::endl;
+
+    return EXIT_SUCCESS;
+}
+
+}   /* anonymous */
+
+// MAIN
+// ----
+
+
+/** \brief Write both header layouts and their consumers, or time a command.
+ */
+int main(int argc,
+    char *argv[])
+{
+    if (argc > 2 && std::strcmp(argv[1], "--time") == 0) {
+        return timeCommand(argc - 2, argv + 2);
+    }
+
+    auto tlib = createDescription();
+    std::string ns = "shapes";
+
+    com::Files monolithic;
+    std::string directory = "monolithic";
+    com::writeHeaders(tlib, ns, directory, monolithic);
+    writeConsumer("monolithic.cc", tlib.guid.uuid() + ".hpp");
+
+    com::Files sharded;
+    directory = "sharded";
+    com::writeShardedHeaders(tlib, ns, directory, sharded);
+    writeConsumer("sharded.cc", tlib.guid.uuid() + "_IShape0.hpp");
+
+    return EXIT_SUCCESS;
+}
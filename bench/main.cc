@@ -0,0 +1,32 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief AutoCom benchmark runner.
+ */
+
+#include <autocom.h>
+#include <benchmark/benchmark.h>
+
+namespace com = autocom;
+
+
+// SUITE
+// -----
+
+
+/** \brief Execute benchmark suite.
+ */
+int main(int argc, char *argv[])
+{
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    com::initialize();
+    ::benchmark::RunSpecifiedBenchmarks();
+    com::uninitialize();
+
+    return 0;
+}
@@ -0,0 +1,352 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief Type library parser benchmarks.
+ *
+ *  Parses a synthetic MSFT type library, read without COM, with
+ *  `range(0)` records and as many interfaces. Each record embeds the
+ *  previous one, and each method takes a record from another part of
+ *  the library, so most types are reached through many references.
+ */
+
+#include <msft.h>
+#include <parse.h>
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace com = autocom;
+
+
+namespace
+{
+// CONSTANTS
+// ---------
+
+const INT METHODS = 8;
+const INT TYPEINFO_SIZE = 0x64;
+
+// HELPERS
+// -------
+
+/** \brief Little-endian byte buffer for a synthetic MSFT image.
+ */
+struct Buffer
+{
+    std::string bytes;
+
+    INT size() const
+    {
+        return INT(bytes.size());
+    }
+
+    void i32(const INT value)
+    {
+        bytes.append(reinterpret_cast<const char*>(&value), 4);
+    }
+
+    void i16(const SHORT value)
+    {
+        bytes.append(reinterpret_cast<const char*>(&value), 2);
+    }
+
+    void raw(const std::string &value)
+    {
+        bytes += value;
+        while (bytes.size() % 4) {
+            bytes.push_back('\0');
+        }
+    }
+};
+
+
+/** \brief Add name table entry and return its offset.
+ */
+INT addName(Buffer &table,
+    INT &count,
+    const std::string &name)
+{
+    INT offset = table.size();
+    table.i32(-1);
+    table.i32(-1);
+    table.i32(INT(name.size()));
+    table.raw(name);
+    ++count;
+    return offset;
+}
+
+
+/** \brief Add GUID table entry and return its offset.
+ */
+INT addGuid(Buffer &table,
+    const GUID &guid)
+{
+    INT offset = table.size();
+    table.bytes.append(reinterpret_cast<const char*>(&guid), sizeof(GUID));
+    table.i32(-1);
+    table.i32(-1);
+    return offset;
+}
+
+
+/** \brief Inline data type for a base VARTYPE.
+ */
+INT inlineType(const VARTYPE vt)
+{
+    return INT(0x80000000 | (vt << 16) | vt);
+}
+
+
+/** \brief Create MSFT image with `types` records and interfaces.
+ *
+ *  The library defines, for each `i`:
+ *      struct Record{i} { LONG x; DOUBLE y; Record{i-1} prev; };
+ *      interface IShape{i}: IDispatch
+ *      {
+ *          HRESULT Method{j}([in] Record{i+j}, [out, retval] DOUBLE*);
+ *      };
+ */
+std::string createImage(const INT types)
+{
+    const GUID libid = {0x12345678, 0x1234, 0x5678, {1, 2, 3, 4, 5, 6, 7, 8}};
+    const INT count = 2 * types;
+
+    Buffer names, guids, typedescs, impinfo, impfiles;
+    INT nameCount = 0;
+    INT library = addName(names, nameCount, "BenchLib");
+    INT x = addName(names, nameCount, "x");
+    INT y = addName(names, nameCount, "y");
+    INT prev = addName(names, nameCount, "prev");
+    INT arg = addName(names, nameCount, "arg");
+    INT out = addName(names, nameCount, "out");
+    std::vector<INT> methodNames;
+    for (INT j = 0; j < METHODS; ++j) {
+        methodNames.push_back(addName(names, nameCount, "Method" + std::to_string(j)));
+    }
+    INT libguid = addGuid(guids, libid);
+    INT dispatchguid = addGuid(guids, IID_IDispatch);
+
+    // DOUBLE*, then one user-defined type per record
+    typedescs.i16(VT_PTR);
+    typedescs.i16(0);
+    typedescs.i16(VT_R8);
+    typedescs.i16(-1);
+    for (INT i = 0; i < types; ++i) {
+        typedescs.i16(VT_USERDEFINED);
+        typedescs.i16(0);
+        typedescs.i32(i * TYPEINFO_SIZE);
+    }
+    auto record = [](const INT i) {
+        return 8 * (i + 1);
+    };
+
+    // IDispatch imported from stdole2.tlb by GUID
+    impinfo.i32(0x010000);
+    impinfo.i32(0);
+    impinfo.i32(dispatchguid);
+    impfiles.i32(-1);
+    impfiles.i32(0);
+    impfiles.i32(0x00020002);
+    impfiles.i16(SHORT(11 << 2));
+    impfiles.raw("stdole2.tlb");
+
+    // type infos, with member blocks of records, then member IDs,
+    // names and record offsets
+    struct Info
+    {
+        TYPEKIND kind;
+        INT elements;
+        INT guid;
+        INT name;
+        SHORT interfaces;
+        SHORT vtbl;
+        INT size;
+        INT datatype;
+        Buffer members;
+    };
+    std::vector<Info> infos(count);
+    for (INT i = 0; i < types; ++i) {
+        auto &info = infos[i];
+        INT fields = i ? 3 : 2;
+        INT kinds[3] = {inlineType(VT_I4), inlineType(VT_R8), record(i - 1)};
+        INT fieldNames[3] = {x, y, prev};
+        info = {TKIND_RECORD, MAKELONG(0, fields), -1, 0, 0, 0, 16 * (i + 1), -1, {}};
+        info.name = addName(names, nameCount, "Record" + std::to_string(i));
+        info.members.i32(20 * fields);
+        for (INT k = 0; k < fields; ++k) {
+            info.members.i16(20);
+            info.members.i16(0);
+            info.members.i32(kinds[k]);
+            info.members.i32(0);
+            info.members.i16(VAR_PERINSTANCE);
+            info.members.i16(0);
+            info.members.i32(8 * k);
+        }
+        for (INT k = 0; k < fields; ++k) {
+            info.members.i32(0x40000000 + k);
+        }
+        for (INT k = 0; k < fields; ++k) {
+            info.members.i32(fieldNames[k]);
+        }
+        for (INT k = 0; k < fields; ++k) {
+            info.members.i32(20 * k);
+        }
+    }
+
+    for (INT i = 0; i < types; ++i) {
+        auto &info = infos[types + i];
+        GUID iid = {0x87654321, 0x4321, 0x8765, {8, 7, 6, 5, 4, 3, 2, 1}};
+        iid.Data1 += ULONG(i);
+        info = {TKIND_INTERFACE, MAKELONG(METHODS, 0), addGuid(guids, iid), 0, 1, SHORT(28 + 4 * METHODS), 4, 1, {}};
+        info.name = addName(names, nameCount, "IShape" + std::to_string(i));
+        info.members.i32(48 * METHODS);
+        for (INT j = 0; j < METHODS; ++j) {
+            info.members.i32(48);
+            info.members.i32(inlineType(VT_HRESULT));
+            info.members.i32(0);
+            info.members.i16(SHORT(28 + 4 * j));
+            info.members.i16(0);
+            info.members.i32(FUNC_PUREVIRTUAL | (INVOKE_FUNC << 3) | (CC_STDCALL << 8));
+            info.members.i16(2);
+            info.members.i16(0);
+            info.members.i32(record((i + j) % types));
+            info.members.i32(arg);
+            info.members.i32(PARAMFLAG_FIN);
+            info.members.i32(0);
+            info.members.i32(out);
+            info.members.i32(PARAMFLAG_FOUT | PARAMFLAG_FRETVAL);
+        }
+        for (INT j = 0; j < METHODS; ++j) {
+            info.members.i32(0x60000000 + j);
+        }
+        for (INT j = 0; j < METHODS; ++j) {
+            info.members.i32(methodNames[j]);
+        }
+        for (INT j = 0; j < METHODS; ++j) {
+            info.members.i32(48 * j);
+        }
+    }
+
+    // layout: header, typeinfo offsets, segment directory, segments
+    Buffer typeinfos, arrays;
+    typeinfos.bytes.resize(count * TYPEINFO_SIZE);
+    std::vector<Buffer*> segments = {
+        &typeinfos, &impinfo, &impfiles, nullptr,
+        nullptr, &guids, nullptr, &names,
+        nullptr, &typedescs, &arrays, nullptr,
+        nullptr, nullptr, nullptr,
+    };
+    INT position = 0x54 + 4 * count + 15 * 16;
+    std::vector<INT> starts;
+    for (auto *segment: segments) {
+        starts.push_back(segment ? position : -1);
+        position += segment ? segment->size() : 0;
+    }
+
+    Buffer image;
+    image.i32(0x5446534D);
+    image.i32(0x00010002);
+    image.i32(libguid);
+    image.i32(0x409);
+    image.i32(0);
+    image.i32(SYS_WIN32);
+    image.i32(MAKELONG(1, 0));
+    image.i32(0);
+    image.i32(count);
+    image.i32(-1);
+    image.i32(0);
+    image.i32(0);
+    image.i32(nameCount);
+    image.i32(names.size());
+    image.i32(library);
+    image.i32(-1);
+    image.i32(-1);
+    image.i32(0);
+    image.i32(0);
+    image.i32(-1);
+    image.i32(1);
+    for (INT i = 0; i < count; ++i) {
+        image.i32(i * TYPEINFO_SIZE);
+    }
+    for (size_t i = 0; i < segments.size(); ++i) {
+        image.i32(starts[i]);
+        image.i32(segments[i] ? segments[i]->size() : 0);
+        image.i32(-1);
+        image.i32(0x0F);
+    }
+
+    typeinfos.bytes.clear();
+    for (const auto &info: infos) {
+        Buffer entry;
+        entry.i32(info.kind | (3 << 11));
+        entry.i32(position);
+        for (size_t i = 0; i < 4; ++i) {
+            entry.i32(0);
+        }
+        entry.i32(info.elements);
+        for (size_t i = 0; i < 4; ++i) {
+            entry.i32(0);
+        }
+        entry.i32(info.guid);
+        entry.i32(0);
+        entry.i32(info.name);
+        entry.i32(MAKELONG(1, 0));
+        entry.i32(-1);
+        entry.i32(0);
+        entry.i32(0);
+        entry.i32(-1);
+        entry.i16(info.interfaces);
+        entry.i16(info.vtbl);
+        entry.i32(info.size);
+        entry.i32(info.datatype);
+        entry.i32(-1);
+        entry.i32(0);
+        entry.i32(0);
+        typeinfos.bytes += entry.bytes;
+        position += info.members.size();
+    }
+    for (auto *segment: segments) {
+        if (segment) {
+            image.bytes += segment->bytes;
+        }
+    }
+    for (const auto &info: infos) {
+        image.bytes += info.members.bytes;
+    }
+
+    return image.bytes;
+}
+
+}   /* anonymous */
+
+// BENCHMARKS
+// ----------
+
+
+/** \brief Parse description of library read from an MSFT image.
+ */
+static void ParseTypeLib(benchmark::State &state)
+{
+    const std::string path = "bench_parse.tlb";
+    {
+        auto image = createImage(INT(state.range(0)));
+        std::ofstream stream(path, std::ios::binary);
+        stream.write(image.data(), image.size());
+    }
+
+    com::msft::TypeLib tlib(path);
+    for (auto _: state) {
+        com::TypeLibDescription description;
+        description.parse(tlib);
+        benchmark::DoNotOptimize(description.description.interfaces.data());
+    }
+    state.SetItemsProcessed(state.iterations() * 2 * state.range(0));
+
+    std::remove(path.data());
+}
+
+BENCHMARK(ParseTypeLib)->Arg(64)->Arg(1024)->Unit(benchmark::kMillisecond);
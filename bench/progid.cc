@@ -0,0 +1,122 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief ProgID resolution cache benchmarks.
+ *
+ *  ProgIDs are resolved by an in-memory backend, so the benchmarks
+ *  measure the cache rather than the registry.
+ */
+
+#include <autocom.h>
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace com = autocom;
+
+
+namespace
+{
+// OBJECTS
+// -------
+
+
+/** \brief Resolve any "Prog." ProgID to a fixed CLSID.
+ */
+struct MemoryResolver: com::ProgIdResolver
+{
+    virtual HRESULT resolve(const std::wstring &progid,
+        GUID &clsid) override
+    {
+        if (progid.compare(0, 5, L"Prog.") != 0) {
+            return CO_E_CLASSSTRING;
+        }
+        clsid = com::parseGuid("{3F4DACA4-160D-11D2-A8E9-00104B365C9F}", 38);
+        return S_OK;
+    }
+};
+
+// HELPERS
+// -------
+
+
+/** \brief Create ProgIDs "Prog.0" through "Prog.<count - 1>".
+ */
+std::vector<std::wstring> createProgIds(const size_t count)
+{
+    std::vector<std::wstring> progids;
+    for (size_t i = 0; i < count; ++i) {
+        progids.push_back(L"Prog." + std::to_wstring(i));
+    }
+    return progids;
+}
+
+
+/** \brief Cache shared by every benchmark thread.
+ */
+com::ProgIdCache & sharedCache()
+{
+    static com::ProgIdCache cache(std::make_shared<MemoryResolver>());
+    return cache;
+}
+
+}   /* anonymous */
+
+// BENCHMARKS
+// ----------
+
+
+/** \brief Resolve through the backend alone, as a baseline.
+ */
+static void ProgIdResolver(benchmark::State &state)
+{
+    MemoryResolver resolver;
+    const std::wstring progid = L"Prog.0";
+    GUID clsid;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(resolver.resolve(progid, clsid));
+    }
+}
+
+BENCHMARK(ProgIdResolver);
+
+
+/** \brief Resolve cached ProgIDs, among `range(0)` entries.
+ */
+static void ProgIdCacheHit(benchmark::State &state)
+{
+    auto progids = createProgIds(static_cast<size_t>(state.range(0)));
+    auto &cache = sharedCache();
+    GUID clsid;
+    for (const auto &progid: progids) {
+        cache.resolve(progid, clsid);
+    }
+
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(cache.resolve(progids[i], clsid));
+        i = i + 1 == progids.size() ? 0 : i + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(ProgIdCacheHit)->Arg(1)->Arg(64)->Arg(1024)->Threads(1)->Threads(4);
+
+
+/** \brief Resolve ProgIDs whose entries have always expired.
+ */
+static void ProgIdCacheMiss(benchmark::State &state)
+{
+    com::ProgIdCache cache(std::make_shared<MemoryResolver>(), com::ProgIdCache::Duration::zero(), com::ProgIdCache::Duration::zero());
+    const std::wstring progid = L"Prog.0";
+    GUID clsid;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(cache.resolve(progid, clsid));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(ProgIdCacheMiss);
@@ -0,0 +1,264 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief SafeArray construction, iteration and conversion benchmarks.
+ */
+
+#include <autocom.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace com = autocom;
+
+
+// HELPERS
+// -------
+
+
+/** \brief Create array of `size` elements.
+ */
+template <typename T>
+std::vector<T> range(const size_t size)
+{
+    std::vector<T> vector(size);
+    std::iota(vector.begin(), vector.end(), T(0));
+    return vector;
+}
+
+
+/** \brief Create `vt` array of `size` elements, element `i` set to `fill(i)`.
+ */
+template <typename T, typename Fill>
+SAFEARRAY * createVector(const VARTYPE vt,
+    const size_t size,
+    Fill fill)
+{
+    SAFEARRAY *array = SafeArrayCreateVector(vt, 0, static_cast<ULONG>(size));
+    T *data;
+    SafeArrayAccessData(array, (void**) &data);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = fill(i);
+    }
+    SafeArrayUnaccessData(array);
+    return array;
+}
+
+
+/** \brief Convert `array` to `To` elements, and release it.
+ */
+template <typename To>
+void convertVector(benchmark::State &state,
+    SAFEARRAY *array)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    std::unique_ptr<To[]> output(new To[size]);
+    for (auto _: state) {
+        com::convertElements(array, output.get());
+        benchmark::DoNotOptimize(output.get());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    SafeArrayDestroy(array);
+}
+
+// BENCHMARKS
+// ----------
+
+
+template <typename T>
+static void SafeArrayFromVector(benchmark::State &state)
+{
+    auto vector = range<T>(static_cast<size_t>(state.range(0)));
+    for (auto _: state) {
+        com::SafeArray<T> array(vector);
+        benchmark::DoNotOptimize(array.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+BENCHMARK_TEMPLATE(SafeArrayFromVector, LONG)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(SafeArrayFromVector, DOUBLE)->Range(16, 1 << 20);
+
+
+template <typename T>
+static void SafeArrayIterate(benchmark::State &state)
+{
+    com::SafeArray<T> array(range<T>(static_cast<size_t>(state.range(0))));
+    for (auto _: state) {
+        T sum = 0;
+        for (const T &value: array) {
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(SafeArrayIterate, LONG)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(SafeArrayIterate, DOUBLE)->Range(16, 1 << 20);
+
+
+/** \brief Index the array, which checks bounds through the view.
+ */
+static void SafeArrayIndex(benchmark::State &state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    com::SafeArray<DOUBLE> array(range<DOUBLE>(size));
+    for (auto _: state) {
+        DOUBLE sum = 0;
+        for (size_t i = 0; i < size; ++i) {
+            sum += array[i];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(SafeArrayIndex)->Range(16, 1 << 20);
+
+
+/** \brief Write array to a spill file.
+ */
+static void SafeArraySpill(benchmark::State &state)
+{
+    const std::string path = "bench_spill.bin";
+    com::SafeArray<DOUBLE> array(range<DOUBLE>(static_cast<size_t>(state.range(0))));
+    for (auto _: state) {
+        array.spill(path);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(DOUBLE));
+    std::remove(path.data());
+}
+
+BENCHMARK(SafeArraySpill)->Range(1 << 10, 1 << 22)->UseRealTime();
+
+
+/** \brief Map a spill file and iterate over it.
+ *
+ *  The file is in the page cache after the first iteration, so this
+ *  measures mapping and iteration rather than disk reads.
+ */
+static void MappedSafeArrayIterate(benchmark::State &state)
+{
+    const std::string path = "bench_mapped.bin";
+    com::SafeArray<DOUBLE>(range<DOUBLE>(static_cast<size_t>(state.range(0)))).spill(path);
+    for (auto _: state) {
+        com::MappedSafeArray<DOUBLE> mapped(path);
+        DOUBLE sum = 0;
+        for (const DOUBLE &value: mapped) {
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::remove(path.data());
+}
+
+BENCHMARK(MappedSafeArrayIterate)->Range(1 << 10, 1 << 22)->UseRealTime();
+
+
+/** \brief Widen a VT_I4 array to doubles.
+ */
+static void ConvertElements(benchmark::State &state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    com::SafeArray<LONG> array(range<LONG>(size));
+    std::vector<DOUBLE> output(size);
+    for (auto _: state) {
+        com::convertElements(array.array, output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(ConvertElements)->Range(16, 1 << 20);
+
+
+/** \brief Widen a VT_R4 array to doubles.
+ */
+static void ConvertFloatToDouble(benchmark::State &state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    convertVector<DOUBLE>(state, createVector<FLOAT>(VT_R4, size, [](size_t i) {
+        return FLOAT(i) * 0.5f;
+    }));
+}
+
+BENCHMARK(ConvertFloatToDouble)->Range(16, 1 << 20);
+
+
+/** \brief Sign-extend a VT_I2 array to 32-bit integers.
+ */
+static void ConvertShortToLong(benchmark::State &state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    convertVector<LONG>(state, createVector<SHORT>(VT_I2, size, [](size_t i) {
+        return SHORT(i) - 1024;
+    }));
+}
+
+BENCHMARK(ConvertShortToLong)->Range(16, 1 << 20);
+
+
+/** \brief Convert a VT_BOOL array to `bool`.
+ */
+static void ConvertBool(benchmark::State &state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    convertVector<bool>(state, createVector<VARIANT_BOOL>(VT_BOOL, size, [](size_t i) {
+        return i % 3 ? VARIANT_TRUE : VARIANT_FALSE;
+    }));
+}
+
+BENCHMARK(ConvertBool)->Range(16, 1 << 20);
+
+
+/** \brief Convert a VT_DATE array to time points.
+ */
+static void ConvertDateToTimePoint(benchmark::State &state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    convertVector<com::TimePoint>(state, createVector<DATE>(VT_DATE, size, [](size_t i) {
+        return 25569.0 + DATE(i) / 1440.0;
+    }));
+}
+
+BENCHMARK(ConvertDateToTimePoint)->Range(16, 1 << 20);
+
+
+/** \brief Sum `range(0)` doubles on a pool of `range(1)` threads.
+ */
+static void ParallelSum(benchmark::State &state)
+{
+    com::SafeArray<DOUBLE> array(range<DOUBLE>(static_cast<size_t>(state.range(0))));
+    com::SafeArrayView<DOUBLE> view(array);
+    com::parallel::ThreadPool pool(static_cast<size_t>(state.range(1)));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(com::parallel::sum(view, pool));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(DOUBLE));
+}
+
+
+/** \brief Scale from 1 thread to every hardware thread.
+ */
+static void parallelSumArguments(benchmark::internal::Benchmark *benchmark)
+{
+    const int64_t cores = std::max<int64_t>(1, std::thread::hardware_concurrency());
+    for (int64_t size: {int64_t(1) << 16, int64_t(10000000)}) {
+        for (int64_t threads = 1; threads < cores; threads *= 2) {
+            benchmark->Args({size, threads});
+        }
+        benchmark->Args({size, cores});
+    }
+}
+
+BENCHMARK(ParallelSum)->Apply(parallelSumArguments)->UseRealTime();
@@ -0,0 +1,193 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief IDispatch server benchmarks.
+ *
+ *  Calls go straight to `IDispatch::Invoke`, to measure the cost of
+ *  the dispatch table and argument unpacking, and are compared to
+ *  the hand-written switch of the fake server.
+ */
+
+#include "fake.h"
+
+#include <autocom.h>
+#include <benchmark/benchmark.h>
+
+namespace com = autocom;
+
+
+namespace
+{
+// OBJECTS
+// -------
+
+
+/** \brief Server with members of increasing arity.
+ */
+class BenchServer: public com::DispatchImpl<BenchServer>
+{
+public:
+    LONG value = 0;
+
+    LONG zero()
+    {
+        return value;
+    }
+
+    LONG one(LONG a)
+    {
+        return a;
+    }
+
+    DOUBLE two(LONG a, DOUBLE b)
+    {
+        return a + b;
+    }
+
+    LONG three(LONG a, LONG b, BSTR c)
+    {
+        return a + b + static_cast<LONG>(SysStringLen(c));
+    }
+
+    AUTOCOM_DISPATCH_BEGIN(BenchServer)
+        AUTOCOM_DISPATCH_PROPERTY(L"Value", 1, &BenchServer::value)
+        AUTOCOM_DISPATCH_METHOD(L"Zero", 2, &BenchServer::zero)
+        AUTOCOM_DISPATCH_METHOD(L"One", 3, &BenchServer::one)
+        AUTOCOM_DISPATCH_METHOD(L"Two", 4, &BenchServer::two)
+        AUTOCOM_DISPATCH_METHOD(L"Three", 5, &BenchServer::three)
+    AUTOCOM_DISPATCH_END()
+};
+
+// HELPERS
+// -------
+
+
+/** \brief Invoke member with arguments in DISPPARAMS order.
+ */
+HRESULT invokeServer(IDispatch *dispatch,
+    const DISPID id,
+    VARIANT *arguments,
+    const UINT count,
+    const WORD flags = DISPATCH_METHOD)
+{
+    DISPPARAMS params = {arguments, nullptr, count, 0};
+    VARIANT result;
+    VariantInit(&result);
+    HRESULT hr = dispatch->Invoke(id, IID_NULL, LOCALE_USER_DEFAULT, flags, &params, &result, nullptr, nullptr);
+    VariantClear(&result);
+    return hr;
+}
+
+}   /* anonymous */
+
+// BENCHMARKS
+// ----------
+
+
+/** \brief Call with `range(0)` arguments, of the expected types.
+ */
+static void ServerInvoke(benchmark::State &state)
+{
+    BenchServer *server = new BenchServer;
+    const UINT count = static_cast<UINT>(state.range(0));
+    VARIANT arguments[3];
+    arguments[0].vt = VT_BSTR;
+    arguments[0].bstrVal = SysAllocString(L"text");
+    arguments[1].vt = VT_I4;
+    arguments[1].lVal = 2;
+    arguments[2].vt = VT_I4;
+    arguments[2].lVal = 1;
+    if (count == 2) {
+        arguments[1].vt = VT_R8;
+        arguments[1].dblVal = 2;
+    }
+
+    // last argument is first in DISPPARAMS
+    VARIANT *first = arguments + 3 - count;
+    const DISPID id = 2 + static_cast<DISPID>(count);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(invokeServer(server, id, first, count));
+    }
+
+    SysFreeString(arguments[0].bstrVal);
+    server->Release();
+}
+
+BENCHMARK(ServerInvoke)->DenseRange(0, 3);
+
+
+/** \brief Call with arguments coerced to the parameter types.
+ */
+static void ServerInvokeCoerce(benchmark::State &state)
+{
+    BenchServer *server = new BenchServer;
+    VARIANT arguments[2];
+    arguments[0].vt = VT_I2;
+    arguments[0].iVal = 2;
+    arguments[1].vt = VT_R8;
+    arguments[1].dblVal = 1;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(invokeServer(server, 4, arguments, 2));
+    }
+    server->Release();
+}
+
+BENCHMARK(ServerInvokeCoerce);
+
+
+/** \brief Get a data member, compared to the fake server.
+ */
+static void ServerInvokeGet(benchmark::State &state)
+{
+    IDispatch *server;
+    if (state.range(0)) {
+        server = new BenchServer;
+    } else {
+        server = new FakeDispatch;
+    }
+    for (auto _: state) {
+        benchmark::DoNotOptimize(invokeServer(server, 1, nullptr, 0, DISPATCH_PROPERTYGET));
+    }
+    server->Release();
+}
+
+BENCHMARK(ServerInvokeGet)->Arg(0)->Arg(1);
+
+
+/** \brief Resolve a name, compared to the fake server's linear search.
+ */
+static void ServerGetIDsOfNames(benchmark::State &state)
+{
+    IDispatch *server;
+    LPOLESTR name;
+    if (state.range(0)) {
+        server = new BenchServer;
+        name = const_cast<LPOLESTR>(L"three");
+    } else {
+        server = new FakeDispatch;
+        name = const_cast<LPOLESTR>(L"echo");
+    }
+    DISPID id;
+    for (auto _: state) {
+        server->GetIDsOfNames(IID_NULL, &name, 1, LOCALE_USER_DEFAULT, &id);
+        benchmark::DoNotOptimize(id);
+    }
+    server->Release();
+}
+
+BENCHMARK(ServerGetIDsOfNames)->Arg(0)->Arg(1);
+
+
+/** \brief Round-trip through DispatchBase, including DISPPARAMS packing.
+ */
+static void ServerDispatchBase(benchmark::State &state)
+{
+    com::DispatchBase dispatch(new BenchServer);
+    const com::Function id = 4;
+    for (auto _: state) {
+        dispatch.method(id, LONG(1), 2.0);
+    }
+}
+
+BENCHMARK(ServerDispatchBase);
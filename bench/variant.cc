@@ -0,0 +1,242 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComBenchmarks
+ *  \brief Bstr, Guid and Variant benchmarks.
+ */
+
+#include <autocom.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace com = autocom;
+
+
+namespace
+{
+// CONSTANTS
+// ---------
+
+const size_t GUIDS = 10000000;
+
+// HELPERS
+// -------
+
+
+/** \brief Get `GUIDS` random GUIDs, created on first use.
+ */
+const std::vector<GUID> &randomGuids()
+{
+    static const std::vector<GUID> ids = [] {
+        std::mt19937_64 engine(0x1D23188D);
+        std::vector<GUID> ids(GUIDS);
+        for (auto &id: ids) {
+            uint64_t words[2] = {engine(), engine()};
+            std::memcpy(&id, words, sizeof(GUID));
+        }
+        return ids;
+    }();
+    return ids;
+}
+
+
+/** \brief Get number of characters in a GUID written as `format`.
+ */
+size_t formatWidth(const com::GuidFormat format)
+{
+    return format == com::GUID_BRACED_UPPER || format == com::GUID_BRACED_LOWER ? 38 : 36;
+}
+
+}   /* anonymous */
+
+// BENCHMARKS
+// ----------
+
+
+static void BstrFromString(benchmark::State &state)
+{
+    std::string string(static_cast<size_t>(state.range(0)), 'a');
+    for (auto _: state) {
+        com::Bstr bstr(string);
+        benchmark::DoNotOptimize(bstr.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BstrFromString)->Arg(16)->Arg(4096)->Arg(1 << 20);
+
+
+static void BstrFromWstring(benchmark::State &state)
+{
+    std::wstring string(static_cast<size_t>(state.range(0)), L'a');
+    for (auto _: state) {
+        com::Bstr bstr(string);
+        benchmark::DoNotOptimize(bstr.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(wchar_t));
+}
+
+BENCHMARK(BstrFromWstring)->Arg(16)->Arg(4096)->Arg(1 << 20);
+
+
+static void BstrToString(benchmark::State &state)
+{
+    com::Bstr bstr(std::string(static_cast<size_t>(state.range(0)), 'a'));
+    for (auto _: state) {
+        std::string string(bstr);
+        benchmark::DoNotOptimize(string.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BstrToString)->Arg(16)->Arg(4096)->Arg(1 << 20);
+
+
+static void GuidFormat(benchmark::State &state)
+{
+    const auto &ids = randomGuids();
+    const auto format = static_cast<com::GuidFormat>(state.range(0));
+    char buffer[40];
+    for (auto _: state) {
+        size_t length = 0;
+        for (const auto &id: ids) {
+            length += com::formatGuid(id, buffer, format);
+        }
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+BENCHMARK(GuidFormat)->DenseRange(com::GUID_UPPER, com::GUID_BRACED_LOWER)->Unit(benchmark::kMillisecond);
+
+
+static void GuidParse(benchmark::State &state)
+{
+    const auto &ids = randomGuids();
+    const auto format = static_cast<com::GuidFormat>(state.range(0));
+    const size_t width = formatWidth(format);
+    std::string strings(ids.size() * width, '\0');
+    for (size_t i = 0; i < ids.size(); ++i) {
+        com::formatGuid(ids[i], &strings[i * width], format);
+    }
+
+    GUID id;
+    for (auto _: state) {
+        size_t parsed = 0;
+        for (size_t offset = 0; offset < strings.size(); offset += width) {
+            parsed += com::readGuid(strings.data() + offset, width, id);
+        }
+        benchmark::DoNotOptimize(parsed);
+        benchmark::DoNotOptimize(id);
+    }
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+BENCHMARK(GuidParse)->DenseRange(com::GUID_UPPER, com::GUID_BRACED_LOWER)->Unit(benchmark::kMillisecond);
+
+
+static void GuidHash(benchmark::State &state)
+{
+    const auto &ids = randomGuids();
+    std::hash<com::Guid> hasher;
+    for (auto _: state) {
+        size_t combined = 0;
+        for (const auto &id: ids) {
+            combined ^= hasher(com::Guid(id));
+        }
+        benchmark::DoNotOptimize(combined);
+    }
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+BENCHMARK(GuidHash)->Unit(benchmark::kMillisecond);
+
+
+/** \brief Look up every random GUID in a map holding `range(0)` of them.
+ */
+static void GuidLookup(benchmark::State &state)
+{
+    const auto &ids = randomGuids();
+    const size_t size = std::min<size_t>(state.range(0), ids.size());
+    std::unordered_map<com::Guid, size_t> map;
+    map.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        map.emplace(com::Guid(ids[i]), i);
+    }
+
+    for (auto _: state) {
+        size_t found = 0;
+        for (const auto &id: ids) {
+            found += map.count(com::Guid(id));
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+BENCHMARK(GuidLookup)->Arg(1 << 10)->Arg(1 << 20)->Arg(GUIDS)->Unit(benchmark::kMillisecond);
+
+
+static void VariantInteger(benchmark::State &state)
+{
+    com::Variant variant;
+    LONG value = 0;
+    for (auto _: state) {
+        variant.set(value + 1);
+        variant.get(value);
+    }
+    benchmark::DoNotOptimize(value);
+}
+
+BENCHMARK(VariantInteger);
+
+
+static void VariantDouble(benchmark::State &state)
+{
+    com::Variant variant;
+    DOUBLE value = 0;
+    for (auto _: state) {
+        variant.set(value + 1);
+        variant.get(value);
+    }
+    benchmark::DoNotOptimize(value);
+}
+
+BENCHMARK(VariantDouble);
+
+
+/** \brief Store and fetch a string, which copies it on each set.
+ */
+static void VariantString(benchmark::State &state)
+{
+    com::Variant variant;
+    com::Bstr input(std::string(static_cast<size_t>(state.range(0)), 'a'));
+    com::Bstr output;
+    for (auto _: state) {
+        variant.set(input);
+        variant.get(output);
+        benchmark::DoNotOptimize(output.data());
+    }
+}
+
+BENCHMARK(VariantString)->Arg(16)->Arg(4096);
+
+
+static void VariantDuplicate(benchmark::State &state)
+{
+    com::Variant variant;
+    variant.set(com::Bstr(std::string(64, 'a')));
+    for (auto _: state) {
+        com::Variant copy(variant);
+        benchmark::DoNotOptimize(copy.bstrVal);
+    }
+}
+
+BENCHMARK(VariantDuplicate);
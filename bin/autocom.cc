@@ -6,21 +6,40 @@
  *
  *  Modes:
  *Query COM interface and generate compile-time interface
+ *
+ *  With `-tlb`, the type library is read from a `.tlb` file or PE
+ *  image instead of a registered COM object.
+ *
+ *  Parsed descriptions are cached outside the header directory, in
+ *  `-cache_dir` or the temporary directory, keyed by the library
+ *  identity, hashes of the type library and its resolved imports,
+ *  and the generator build. Headers are only rewritten when their
+ *  contents change.
  */
 
+#include "cache.h"
 #include "options.h"
 #include "parse.h"
 #include "write.h"
 
+#include <cstdlib>
+#include <cstring>
+
 namespace com = autocom;
 
 // OPTIONS
 // -------
 
 DEFINE_string(progid, "", "Program ID or CLSID for COM object");
+DEFINE_string(tlb, "", "Type library or PE image to read without COM.");
+DEFINE_string(tlbpath, "", "Semicolon-separated directories for imported type libraries.");
 DEFINE_string(ns, "", "Namespace to store COM definitions.");
 DEFINE_string(header, "./", "Directory to store generated header.");
 DEFINE_string(mode, "generate", "Enumerated modes for AutoCOM, ['generate', 'progid', 'clsid']");
+DEFINE_bool(cache, true, "Reuse the parsed type library cached in the cache directory, see -cache_dir.");
+DEFINE_string(cache_dir, "", "Directory to store parsed type libraries, the temporary directory if empty.");
+DEFINE_bool(shard, false, "Write one header per interface and coclass, with an umbrella header.");
+DEFINE_bool(constexpr_guid, false, "Write GUIDs as constexpr constants, rather than DEFINE_GUID.");
 DEFINE_validator(progid, &ValidateProgId);
 DEFINE_validator(ns, &ValidateNamespace);
 DEFINE_validator(mode, &ValidateMode);
@@ -28,59 +47,192 @@ DEFINE_validator(mode, &ValidateMode);
 // FUNCTIONS
 // ---------
 
-/** \brief Generate C++ headers from interface.
+/** \brief Get directory for cached descriptions.
+ *
+ *  The header directory is usually on the include path, so caches
+ *  are kept out of it.
+ */
+std::string cacheDirectory()
+{
+    if (!FLAGS_cache_dir.empty()) {
+        return FLAGS_cache_dir;
+    }
+
+#if defined(_WIN32)
+    char path[MAX_PATH + 1];
+    DWORD length = GetTempPathA(MAX_PATH + 1, path);
+    if (length && length <= MAX_PATH) {
+        return std::string(path, length);
+    }
+#else
+    const char *path = std::getenv("TMPDIR");
+    if (path && *path) {
+        return path;
+    }
+    return "/tmp";
+#endif
+
+    return ".";
+}
+
+
+/** \brief Get paths of the imported libraries of a native type library.
+ */
+const std::vector<std::string> & importPaths(const com::msft::TypeLib &tlib)
+{
+    return tlib.imports();
+}
+
+
+/** \brief Imports of libraries loaded by oleaut32 are not resolved.
  */
-void generate(com::Dispatch &dispatch)
+std::vector<std::string> importPaths(const com::TypeLib&)
 {
-    // parse descriptions
+    return {};
+}
+
+
+/** \brief Generate C++ headers from type library.
+ *
+ *  \param path                 Path to type library file, empty if unknown.
+ */
+template <typename TypeLib>
+void generate(const TypeLib &tlib,
+    const std::string &path)
+{
+    // parse descriptions, unless cached
     com::TypeLibDescription description;
-    description.parse(dispatch.info().typelib());
+    if (!FLAGS_cache || path.empty()) {
+        description.parse(tlib);
+    } else {
+        com::DescriptionKey key(tlib.attr(), path, importPaths(tlib));
+        auto cache = cacheDirectory() + "/" + key.filename();
+        if (!com::readDescriptionCache(cache, key, description)) {
+            description.parse(tlib);
+            com::writeDescriptionCache(cache, key, description);
+        }
+    }
 
     // write to file
+    com::detail::CONSTEXPR_GUIDS = FLAGS_constexpr_guid;
     com::Files files;
-    writeHeaders(description, FLAGS_ns, FLAGS_header, files);
+    if (FLAGS_shard) {
+        writeShardedHeaders(description, FLAGS_ns, FLAGS_header, files);
+    } else {
+        writeHeaders(description, FLAGS_ns, FLAGS_header, files);
+    }
 }
 
 
 /** \brief Get preferred CLSID.
  */
-void getCLSID(com::Dispatch &dispatch)
+template <typename TypeLib>
+void getCLSID(const TypeLib &tlib)
 {
-    auto attr = dispatch.info().typelib().attr();
+    auto attr = tlib.attr();
     printf("%s", attr.guid().uuid().data());
 }
 
 
 /** \brief Get preferred ProgID
  */
-void getProgID(com::Dispatch &dispatch)
+template <typename TypeLib>
+void getProgID(const TypeLib &tlib)
 {
-    auto tlib = dispatch.info().typelib();
     printf("%s", tlib.documentation(-1).name.data());
 }
 
 
+/** \brief Split semicolon-separated search path.
+ */
+std::vector<std::string> splitPaths(const std::string &paths)
+{
+    std::vector<std::string> list;
+    size_t start = 0;
+    while (start <= paths.size()) {
+        size_t end = paths.find(';', start);
+        if (end == std::string::npos) {
+            end = paths.size();
+        }
+        if (end > start) {
+            list.emplace_back(paths.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+
+    return list;
+}
+
+
+/** \brief Get path to the file of a registered type library.
+ *
+ *  Type libraries embedded in a PE image may be registered with a
+ *  trailing resource index, which is removed. Returns an empty
+ *  string if the library is not registered.
+ */
+std::string registeredPath(const com::TypeLibAttr &attr)
+{
+    GUID guid;
+    auto id = attr.guid();
+    std::memcpy(&guid, &id, sizeof(GUID));
+
+    com::Bstr bstr;
+    if (FAILED(QueryPathOfRegTypeLib(guid, attr.major(), attr.minor(), attr.lcid(), &bstr.data()))) {
+        return "";
+    }
+
+    std::string path(bstr);
+    size_t separator = path.find_last_of('\\');
+    if (separator != std::string::npos && separator + 1 < path.size()) {
+        auto suffix = path.substr(separator + 1);
+        if (suffix.find_first_not_of("0123456789") == std::string::npos) {
+            path.erase(separator);
+        }
+    }
+
+    return path;
+}
+
+
+/** \brief Run selected mode on type library.
+ */
+template <typename TypeLib>
+void run(const TypeLib &tlib,
+    const std::string &path)
+{
+    switch (AutoComModes[FLAGS_mode]) {
+        case AUTOCOM_GENERATE:
+            generate(tlib, path);
+            break;
+        case AUTOCOM_PROGID:
+            getProgID(tlib);
+            break;
+        case AUTOCOM_CLSID:
+            getCLSID(tlib);
+            break;
+        default:
+            throw std::invalid_argument("Unrecognized option.");
+    }
+}
+
+
 /** \brief Execute main code block.
  */
 int main(int argc, char *argv[])
 {
     gflags::ParseCommandLineFlags(&argc, &argv, true);
 
+    if (!FLAGS_tlb.empty()) {
+        // read type library directly, without creating the COM object
+        com::msft::TypeLib tlib(FLAGS_tlb, splitPaths(FLAGS_tlbpath));
+        run(tlib, FLAGS_tlb);
+        exit(EXIT_SUCCESS);
+    }
+
     com::Dispatch dispatch(FLAGS_progid);
     if (dispatch) {
-        switch (AutoComModes[FLAGS_mode]) {
-            case AUTOCOM_GENERATE:
-                generate(dispatch);
-                break;
-            case AUTOCOM_PROGID:
-                getProgID(dispatch);
-                break;
-            case AUTOCOM_CLSID:
-                getCLSID(dispatch);
-                break;
-            default:
-                throw std::invalid_argument("Unrecognized option.");
-        }
+        auto tlib = dispatch.info().typelib();
+        run(tlib, registeredPath(tlib.attr()));
         exit(EXIT_SUCCESS);
     }
 
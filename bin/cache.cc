@@ -0,0 +1,661 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Binary cache of parsed type library descriptions.
+ */
+
+#include "cache.h"
+#include "write.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+// CONSTANTS
+// ---------
+
+const uint32_t DESCRIPTION_CACHE_VERSION = 3;
+
+namespace
+{
+// CONSTANTS
+// ---------
+
+/** All fields are little-endian, and strings and lists are prefixed
+ *  by a 32-bit count.
+ */
+const char CACHE_MAGIC[8] = {'A', 'C', 'O', 'M', 'D', 'E', 'S', 'C'};
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+static_assert(sizeof(Guid) == sizeof(GUID), "Guid must wrap a GUID.");
+
+// HELPERS
+// -------
+
+
+/** \brief Add bytes to an FNV-1a hash.
+ */
+void mixHash(uint64_t &hash,
+    const void *data,
+    const size_t length)
+{
+    auto bytes = reinterpret_cast<const BYTE*>(data);
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+}
+
+// WRITER
+// ------
+
+
+/** \brief Append-only binary serializer.
+ */
+struct Writer
+{
+    std::string buffer;
+
+    template <typename T>
+    void scalar(const T value);
+
+    void bytes(const void *data,
+        const size_t length);
+};
+
+
+template <typename T>
+void Writer::scalar(const T value)
+{
+    static_assert(std::is_arithmetic<T>::value, "Expected arithmetic type.");
+    bytes(&value, sizeof(T));
+}
+
+
+void Writer::bytes(const void *data,
+    const size_t length)
+{
+    buffer.append(reinterpret_cast<const char*>(data), length);
+}
+
+// READER
+// ------
+
+
+/** \brief Bounds-checked sequential binary deserializer.
+ */
+struct Reader
+{
+    const char *data;
+    size_t size;
+    size_t offset = 0;
+
+    template <typename T>
+    T scalar();
+
+    uint32_t count();
+    void bytes(void *dst,
+        const size_t length);
+    const char * view(const size_t length);
+};
+
+
+template <typename T>
+T Reader::scalar()
+{
+    static_assert(std::is_arithmetic<T>::value, "Expected arithmetic type.");
+    T value;
+    bytes(&value, sizeof(T));
+    return value;
+}
+
+
+/** \brief Read list length. Every item takes at least one byte,
+ *  so longer lists must be corrupt.
+ */
+uint32_t Reader::count()
+{
+    auto value = scalar<uint32_t>();
+    if (value > size - offset) {
+        throw std::runtime_error("Truncated description cache.");
+    }
+    return value;
+}
+
+
+void Reader::bytes(void *dst,
+    const size_t length)
+{
+    std::memcpy(dst, view(length), length);
+}
+
+
+const char * Reader::view(const size_t length)
+{
+    if (size - offset < length) {
+        throw std::runtime_error("Truncated description cache.");
+    }
+    const char *pointer = data + offset;
+    offset += length;
+    return pointer;
+}
+
+// SERIALIZE
+// ---------
+
+
+void write(Writer &writer, const std::string &string)
+{
+    writer.scalar(uint32_t(string.size()));
+    writer.bytes(string.data(), string.size());
+}
+
+
+void write(Writer &writer, const Guid &guid)
+{
+    writer.bytes(&guid, sizeof(GUID));
+}
+
+
+template <typename T>
+void write(Writer &writer, const std::vector<T> &list)
+{
+    writer.scalar(uint32_t(list.size()));
+    for (const auto &item: list) {
+        write(writer, item);
+    }
+}
+
+
+void write(Writer &writer, const Documentation &documentation)
+{
+    write(writer, documentation.name);
+    write(writer, documentation.doc);
+    writer.scalar(uint32_t(documentation.help));
+    write(writer, documentation.file);
+}
+
+
+void write(Writer &writer, const detail::EnumValue &value)
+{
+    write(writer, value.name);
+    write(writer, value.value);
+}
+
+
+void write(Writer &writer, const detail::Parameter &parameter)
+{
+    write(writer, parameter.type);
+    write(writer, parameter.array);
+    write(writer, parameter.name);
+    writer.scalar(uint16_t(parameter.flags));
+    write(writer, parameter.element);
+}
+
+
+void write(Writer &writer, const detail::Variable &variable)
+{
+    write(writer, static_cast<const detail::Parameter&>(variable));
+    write(writer, variable.value);
+}
+
+
+void write(Writer &writer, const detail::Function &function)
+{
+    write(writer, function.decorator);
+    write(writer, function.returns);
+    write(writer, function.name);
+    write(writer, function.doc);
+    writer.scalar(int32_t(function.id));
+    writer.scalar(int16_t(function.offset));
+    write(writer, function.args);
+}
+
+
+void write(Writer &writer, const detail::Enum &item)
+{
+    write(writer, item.name);
+    write(writer, item.values);
+}
+
+
+void write(Writer &writer, const detail::Record &item)
+{
+    write(writer, item.name);
+    writer.scalar(uint32_t(item.size));
+    write(writer, item.fields);
+    writer.scalar(uint32_t(item.offsets.size()));
+    for (const auto offset: item.offsets) {
+        writer.scalar(uint32_t(offset));
+    }
+}
+
+
+void write(Writer &writer, const detail::Module &item)
+{
+    write(writer, item.functions);
+    write(writer, item.constants);
+}
+
+
+void write(Writer &writer, const detail::Interface &item)
+{
+    write(writer, item.name);
+    write(writer, item.iid);
+    writer.scalar(uint16_t(item.flags));
+    write(writer, item.base);
+    write(writer, item.object);
+    write(writer, item.functions);
+}
+
+
+void write(Writer &writer, const detail::CoClass &item)
+{
+    write(writer, item.name);
+    write(writer, item.clsid);
+    writer.scalar(uint16_t(item.flags));
+    write(writer, item.interfaces);
+}
+
+
+void write(Writer &writer, const detail::Alias &item)
+{
+    write(writer, item.parameter);
+    write(writer, item.name);
+}
+
+
+void write(Writer &writer, const detail::Union &item)
+{
+    write(writer, item.name);
+    write(writer, item.fields);
+}
+
+
+void write(Writer &writer, const detail::Description &description)
+{
+    write(writer, description.enums);
+    write(writer, description.records);
+    write(writer, description.modules);
+    write(writer, description.interfaces);
+    write(writer, description.dispatchers);
+    write(writer, description.coclasses);
+    write(writer, description.aliases);
+    write(writer, description.unions);
+
+    // sort the bases, so identical descriptions give identical files
+    std::vector<std::pair<detail::Type, detail::Type>> bases(description.bases.begin(), description.bases.end());
+    std::sort(bases.begin(), bases.end());
+    writer.scalar(uint32_t(bases.size()));
+    for (const auto &base: bases) {
+        write(writer, base.first);
+        write(writer, base.second);
+    }
+}
+
+
+void write(Writer &writer, const DescriptionKey &key)
+{
+    write(writer, key.guid);
+    writer.scalar(uint16_t(key.major));
+    writer.scalar(uint16_t(key.minor));
+    writer.scalar(uint32_t(key.lcid));
+    writer.scalar(key.size);
+    writer.scalar(key.hash);
+    writer.scalar(key.imports);
+    writer.scalar(key.generator);
+}
+
+// DESERIALIZE
+// -----------
+
+
+void read(Reader &reader, std::string &string)
+{
+    auto length = reader.scalar<uint32_t>();
+    string.assign(reader.view(length), length);
+}
+
+
+void read(Reader &reader, Guid &guid)
+{
+    GUID id;
+    reader.bytes(&id, sizeof(GUID));
+    guid = Guid(id);
+}
+
+
+template <typename T>
+void read(Reader &reader, std::vector<T> &list)
+{
+    list.clear();
+    list.resize(reader.count());
+    for (auto &item: list) {
+        read(reader, item);
+    }
+}
+
+
+void read(Reader &reader, Documentation &documentation)
+{
+    read(reader, documentation.name);
+    read(reader, documentation.doc);
+    documentation.help = reader.scalar<uint32_t>();
+    read(reader, documentation.file);
+}
+
+
+void read(Reader &reader, detail::EnumValue &value)
+{
+    read(reader, value.name);
+    read(reader, value.value);
+}
+
+
+void read(Reader &reader, detail::Parameter &parameter)
+{
+    read(reader, parameter.type);
+    read(reader, parameter.array);
+    read(reader, parameter.name);
+    parameter.flags = reader.scalar<uint16_t>();
+    read(reader, parameter.element);
+}
+
+
+void read(Reader &reader, detail::Variable &variable)
+{
+    read(reader, static_cast<detail::Parameter&>(variable));
+    read(reader, variable.value);
+}
+
+
+void read(Reader &reader, detail::Function &function)
+{
+    read(reader, function.decorator);
+    read(reader, function.returns);
+    read(reader, function.name);
+    read(reader, function.doc);
+    function.id = reader.scalar<int32_t>();
+    function.offset = reader.scalar<int16_t>();
+    read(reader, function.args);
+}
+
+
+void read(Reader &reader, detail::Enum &item)
+{
+    read(reader, item.name);
+    read(reader, item.values);
+}
+
+
+void read(Reader &reader, detail::Record &item)
+{
+    read(reader, item.name);
+    item.size = reader.scalar<uint32_t>();
+    read(reader, item.fields);
+    auto count = reader.count();
+    item.offsets.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        item.offsets.emplace_back(reader.scalar<uint32_t>());
+    }
+}
+
+
+void read(Reader &reader, detail::Module &item)
+{
+    read(reader, item.functions);
+    read(reader, item.constants);
+}
+
+
+void read(Reader &reader, detail::Interface &item)
+{
+    read(reader, item.name);
+    read(reader, item.iid);
+    item.flags = reader.scalar<uint16_t>();
+    read(reader, item.base);
+    read(reader, item.object);
+    read(reader, item.functions);
+}
+
+
+void read(Reader &reader, detail::CoClass &item)
+{
+    read(reader, item.name);
+    read(reader, item.clsid);
+    item.flags = reader.scalar<uint16_t>();
+    read(reader, item.interfaces);
+    item.added = std::unordered_set<detail::Type>(item.interfaces.begin(), item.interfaces.end());
+}
+
+
+void read(Reader &reader, detail::Alias &item)
+{
+    read(reader, item.parameter);
+    read(reader, item.name);
+}
+
+
+void read(Reader &reader, detail::Union &item)
+{
+    read(reader, item.name);
+    read(reader, item.fields);
+}
+
+
+void read(Reader &reader, detail::Description &description)
+{
+    read(reader, description.enums);
+    read(reader, description.records);
+    read(reader, description.modules);
+    read(reader, description.interfaces);
+    read(reader, description.dispatchers);
+    read(reader, description.coclasses);
+    read(reader, description.aliases);
+    read(reader, description.unions);
+
+    auto count = reader.count();
+    description.bases.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        detail::Type derived, base;
+        read(reader, derived);
+        read(reader, base);
+        description.bases.emplace(std::move(derived), std::move(base));
+    }
+}
+
+
+void read(Reader &reader, DescriptionKey &key)
+{
+    read(reader, key.guid);
+    key.major = reader.scalar<uint16_t>();
+    key.minor = reader.scalar<uint16_t>();
+    key.lcid = reader.scalar<uint32_t>();
+    key.size = reader.scalar<uint64_t>();
+    key.hash = reader.scalar<uint64_t>();
+    key.imports = reader.scalar<uint64_t>();
+    key.generator = reader.scalar<uint64_t>();
+}
+
+}   /* anonymous */
+
+// OBJECTS
+// -------
+
+
+/** \brief Get cache file name, unique for each library and version.
+ */
+std::string DescriptionKey::filename() const
+{
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "-%u.%u-%04x.cache", unsigned(major), unsigned(minor), unsigned(lcid));
+    return "autocom-" + guid.uuid() + suffix;
+}
+
+
+bool operator==(const DescriptionKey &left,
+    const DescriptionKey &right)
+{
+    return (
+        left.guid == right.guid &&
+        left.major == right.major &&
+        left.minor == right.minor &&
+        left.lcid == right.lcid &&
+        left.size == right.size &&
+        left.hash == right.hash &&
+        left.imports == right.imports &&
+        left.generator == right.generator
+    );
+}
+
+
+bool operator!=(const DescriptionKey &left,
+    const DescriptionKey &right)
+{
+    return !(left == right);
+}
+
+// FUNCTIONS
+// ---------
+
+
+uint64_t hashFile(const std::string &path,
+    uint64_t &size)
+{
+    MappedFile file(path);
+    size = file.size();
+
+    uint64_t hash = FNV_OFFSET;
+    mixHash(hash, file.data(), file.size());
+
+    return hash;
+}
+
+
+uint64_t hashFiles(const std::vector<std::string> &paths)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (const auto &path: paths) {
+        uint64_t size;
+        uint64_t contents = hashFile(path, size);
+        mixHash(hash, path.data(), path.size() + 1);
+        mixHash(hash, &size, sizeof(size));
+        mixHash(hash, &contents, sizeof(contents));
+    }
+
+    return hash;
+}
+
+
+uint64_t generatorBuildId()
+{
+    static const uint64_t id = []() -> uint64_t {
+#if defined(_WIN32)
+        char path[MAX_PATH];
+        DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+        std::string executable(path, length);
+#else
+        std::string executable = "/proc/self/exe";
+#endif
+        try {
+            uint64_t size;
+            return hashFile(executable, size);
+        } catch (std::runtime_error&) {
+            // unreadable executable, rely on the cache version
+            return 0;
+        }
+    }();
+
+    return id;
+}
+
+
+std::string serializeDescription(const DescriptionKey &key,
+    const TypeLibDescription &tlib)
+{
+    Writer writer;
+    writer.bytes(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    writer.scalar(DESCRIPTION_CACHE_VERSION);
+    write(writer, key);
+
+    write(writer, tlib.guid);
+    writer.scalar(uint16_t(tlib.major));
+    writer.scalar(uint16_t(tlib.minor));
+    write(writer, tlib.documentation);
+    write(writer, tlib.description);
+
+    return std::move(writer.buffer);
+}
+
+
+bool deserializeDescription(const void *data,
+    const size_t size,
+    const DescriptionKey &key,
+    TypeLibDescription &tlib)
+{
+    Reader reader {reinterpret_cast<const char*>(data), size};
+    if (size < sizeof(CACHE_MAGIC) || std::memcmp(reader.view(sizeof(CACHE_MAGIC)), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        return false;
+    } else if (reader.scalar<uint32_t>() != DESCRIPTION_CACHE_VERSION) {
+        return false;
+    }
+
+    DescriptionKey stored;
+    read(reader, stored);
+    if (stored != key) {
+        return false;
+    }
+
+    read(reader, tlib.guid);
+    tlib.major = reader.scalar<uint16_t>();
+    tlib.minor = reader.scalar<uint16_t>();
+    read(reader, tlib.documentation);
+    read(reader, tlib.description);
+
+    return true;
+}
+
+
+bool readDescriptionCache(const std::string &path,
+    const DescriptionKey &key,
+    TypeLibDescription &tlib)
+{
+    if (!std::ifstream(path, std::ios::binary)) {
+        return false;
+    }
+
+    try {
+        MappedFile file(path);
+        return deserializeDescription(file.data(), file.size(), key, tlib);
+    } catch (std::runtime_error&) {
+        // corrupt cache, reparse the type library
+        tlib = TypeLibDescription();
+        return false;
+    }
+}
+
+
+void writeDescriptionCache(const std::string &path,
+    const DescriptionKey &key,
+    const TypeLibDescription &tlib)
+{
+    writeIfChanged(path, serializeDescription(key, tlib));
+}
+
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
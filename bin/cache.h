@@ -0,0 +1,157 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Binary cache of parsed type library descriptions.
+ *
+ *  The cache stores a TypeLibDescription behind a versioned header
+ *  and the key of the type library it was parsed from. Cache files
+ *  are read through a memory mapping, and any mismatch in the magic,
+ *  format version or key is treated as a miss.
+ */
+
+#pragma once
+
+#include "parse.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace autocom
+{
+// CONSTANTS
+// ---------
+
+/** \brief Version of the cache layout and of the parsed description.
+ *
+ *  Increment whenever the serialized layout changes, or whenever the
+ *  parser produces different descriptions from the same type library.
+ */
+extern const uint32_t DESCRIPTION_CACHE_VERSION;
+
+// OBJECTS
+// -------
+
+
+/** \brief Identity of the type library a description was parsed from.
+ *
+ *  \param guid                 Type library GUID.
+ *  \param major                Major version of the type library.
+ *  \param minor                Minor version of the type library.
+ *  \param lcid                 Locale of the type library.
+ *  \param size                 Size of the type library file.
+ *  \param hash                 FNV-1a hash of the type library file.
+ *  \param imports              Hash of the imported type library files.
+ *  \param generator            Build ID of the generator.
+ */
+struct DescriptionKey
+{
+    Guid guid;
+    WORD major = 0;
+    WORD minor = 0;
+    LCID lcid = 0;
+    uint64_t size = 0;
+    uint64_t hash = 0;
+    uint64_t imports = 0;
+    uint64_t generator = 0;
+
+    DescriptionKey() = default;
+    DescriptionKey(const DescriptionKey&) = default;
+    DescriptionKey & operator=(const DescriptionKey&) = default;
+    DescriptionKey(DescriptionKey&&) = default;
+    DescriptionKey & operator=(DescriptionKey&&) = default;
+
+    template <typename Attr>
+    DescriptionKey(const Attr &attr,
+        const std::string &path,
+        const std::vector<std::string> &imports = {});
+
+    std::string filename() const;
+
+    friend bool operator==(const DescriptionKey &left,
+        const DescriptionKey &right);
+    friend bool operator!=(const DescriptionKey &left,
+        const DescriptionKey &right);
+};
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Get FNV-1a hash and size of file contents.
+ */
+uint64_t hashFile(const std::string &path,
+    uint64_t &size);
+
+
+/** \brief Get combined hash of the paths, sizes and contents of files.
+ */
+uint64_t hashFiles(const std::vector<std::string> &paths);
+
+
+/** \brief Get build ID of the running generator.
+ *
+ *  The ID is a hash of the executable, so rebuilding the generator
+ *  invalidates descriptions cached by the previous build.
+ */
+uint64_t generatorBuildId();
+
+
+/** \brief Serialize description and its key to a binary buffer.
+ */
+std::string serializeDescription(const DescriptionKey &key,
+    const TypeLibDescription &tlib);
+
+
+/** \brief Deserialize description from a binary buffer.
+ *
+ *  \return                     False if the buffer was written for a
+ *                              different format version or key.
+ */
+bool deserializeDescription(const void *data,
+    const size_t size,
+    const DescriptionKey &key,
+    TypeLibDescription &tlib);
+
+
+/** \brief Load description from a cache file.
+ *
+ *  \return                     False if the file is missing, corrupt
+ *                              or stale.
+ */
+bool readDescriptionCache(const std::string &path,
+    const DescriptionKey &key,
+    TypeLibDescription &tlib);
+
+
+/** \brief Store description in a cache file, if it changed.
+ */
+void writeDescriptionCache(const std::string &path,
+    const DescriptionKey &key,
+    const TypeLibDescription &tlib);
+
+// IMPLEMENTATION
+// --------------
+
+
+/** \brief Initialize key from type library attributes and files.
+ *
+ *  \param imports              Paths of the resolved imported libraries.
+ */
+template <typename Attr>
+DescriptionKey::DescriptionKey(const Attr &attr,
+        const std::string &path,
+        const std::vector<std::string> &imports):
+    guid(attr.guid()),
+    major(attr.major()),
+    minor(attr.minor()),
+    lcid(attr.lcid()),
+    imports(hashFiles(imports)),
+    generator(generatorBuildId())
+{
+    hash = hashFile(path, size);
+}
+
+}   /* autocom */
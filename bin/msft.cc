@@ -0,0 +1,2008 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Native reader for MSFT type libraries.
+ */
+
+#include "msft.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+namespace msft
+{
+namespace
+{
+// CONSTANTS
+// ---------
+
+/** The MSFT layout follows the one documented by Wine's typelib.h.
+ *  All fields are little-endian.
+ */
+const INT MSFT_MAGIC = 0x5446534D;
+const INT SLTG_MAGIC = 0x47544C53;
+const size_t HEADER_SIZE = 0x54;
+const size_t TYPEINFO_SIZE = 0x64;
+const size_t SEGMENT_SIZE = 16;
+const size_t IMPINFO_SIZE = 12;
+const INT HELPDLL_FLAG = 0x100;
+const INT IMPINFO_GUID_FLAG = 0x010000;
+const size_t MAX_IMPORT_DEPTH = 8;
+
+/** \brief Segment indexes in the segment directory.
+ */
+enum Segment
+{
+    SEGMENT_TYPEINFO = 0,
+    SEGMENT_IMPINFO = 1,
+    SEGMENT_IMPFILES = 2,
+    SEGMENT_REFTAB = 3,
+    SEGMENT_GUIDHASH = 4,
+    SEGMENT_GUID = 5,
+    SEGMENT_NAMEHASH = 6,
+    SEGMENT_NAME = 7,
+    SEGMENT_STRING = 8,
+    SEGMENT_TYPEDESC = 9,
+    SEGMENT_ARRAYDESC = 10,
+    SEGMENT_CUSTDATA = 11,
+    SEGMENT_COUNT = 15,
+};
+
+}   /* anonymous */
+
+// OBJECTS
+// -------
+
+
+/** \brief Parsed type descriptor, with indexes into the library tables.
+ */
+struct TypeDescEntry
+{
+    VARTYPE vt = VT_EMPTY;
+    size_t pointee = 0;
+    size_t array = 0;
+    HREFTYPE href = 0;
+};
+
+
+/** \brief Parsed C-style array descriptor.
+ */
+struct ArrayEntry
+{
+    size_t element = 0;
+    std::vector<SafeArrayBound> bounds;
+};
+
+
+/** \brief Parsed function parameter.
+ */
+struct ParamEntry
+{
+    size_t type = 0;
+    USHORT flags = 0;
+    std::string name;
+};
+
+
+/** \brief Parsed function description.
+ */
+struct FuncEntry
+{
+    MEMBERID id = MEMBERID_NIL;
+    FUNCKIND kind = FUNC_PUREVIRTUAL;
+    INVOKEKIND invocation = INVOKE_FUNC;
+    CALLCONV callconv = CC_STDCALL;
+    SHORT offset = 0;
+    SHORT optional = 0;
+    WORD flags = 0;
+    size_t returns = 0;
+    std::vector<ParamEntry> params;
+    Documentation documentation;
+};
+
+
+/** \brief Parsed variable description.
+ */
+struct VarEntry
+{
+    MEMBERID id = MEMBERID_NIL;
+    VARKIND kind = VAR_PERINSTANCE;
+    WORD flags = 0;
+    size_t type = 0;
+    ULONG offset = 0;
+    Variant value;
+    Documentation documentation;
+};
+
+
+/** \brief Parsed type description.
+ */
+struct TypeEntry
+{
+    TYPEKIND kind = TKIND_INTERFACE;
+    GUID guid = GUID_NULL;
+    ULONG size = 0;
+    WORD flags = 0;
+    WORD alignment = 0;
+    WORD vtbl = 0;
+    WORD major = 0;
+    WORD minor = 0;
+    INT base = -1;
+    size_t alias = 0;
+    std::vector<HREFTYPE> impltypes;
+    std::vector<INT> implflags;
+    std::vector<FuncEntry> functions;
+    std::vector<VarEntry> variables;
+    Documentation documentation;
+};
+
+
+/** \brief Resolved reference to a type in an imported library.
+ *
+ *  A null library refers to a placeholder in the importing library.
+ */
+struct ImportEntry
+{
+    LibraryPtr lib;
+    size_t index = 0;
+};
+
+
+/** \brief Parsed MSFT type library.
+ *
+ *  Entries past `count` are placeholders for well-known imported
+ *  interfaces, which are not returned by TypeLib::info. `files` holds
+ *  the paths of the imported libraries, and of their own imports.
+ */
+struct Library
+{
+    GUID guid = GUID_NULL;
+    LCID lcid = 0;
+    SYSKIND syskind = SYS_WIN32;
+    WORD major = 0;
+    WORD minor = 0;
+    WORD flags = 0;
+    Documentation documentation;
+    HREFTYPE dispatch = HREFTYPE(-1);
+
+    size_t count = 0;
+    std::vector<TypeEntry> entries;
+    std::vector<TypeDescEntry> typedescs;
+    std::vector<ArrayEntry> arrays;
+    std::unordered_map<HREFTYPE, ImportEntry> imports;
+    std::vector<std::string> files;
+
+    const TypeEntry & entry(const size_t index) const;
+};
+
+
+/** \brief Get type entry, checking bounds.
+ */
+const TypeEntry & Library::entry(const size_t index) const
+{
+    if (index >= entries.size()) {
+        throw std::out_of_range("Type index out of range.");
+    }
+    return entries[index];
+}
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Bounds-checked little-endian reader over a mapped image.
+ */
+struct Reader
+{
+    const BYTE *data;
+    size_t size;
+
+    template <typename T>
+    T read(const size_t offset) const;
+
+    INT i32(const size_t offset) const;
+    SHORT i16(const size_t offset) const;
+    GUID guid(const size_t offset) const;
+    std::string chars(const size_t offset,
+        const size_t length) const;
+};
+
+
+template <typename T>
+T Reader::read(const size_t offset) const
+{
+    if (offset > size || size - offset < sizeof(T)) {
+        throw std::runtime_error("Truncated MSFT type library.");
+    }
+
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+
+INT Reader::i32(const size_t offset) const
+{
+    return read<INT>(offset);
+}
+
+
+SHORT Reader::i16(const size_t offset) const
+{
+    return read<SHORT>(offset);
+}
+
+
+GUID Reader::guid(const size_t offset) const
+{
+    return read<GUID>(offset);
+}
+
+
+std::string Reader::chars(const size_t offset,
+    const size_t length) const
+{
+    if (offset > size || size - offset < length) {
+        throw std::runtime_error("Truncated MSFT type library.");
+    }
+    return std::string(reinterpret_cast<const char*>(data + offset), length);
+}
+
+
+/** \brief Get file name from a path with either separator.
+ */
+std::string basename(const std::string &path)
+{
+    auto index = path.find_last_of("\\/");
+    return index == std::string::npos ? path : path.substr(index + 1);
+}
+
+
+/** \brief Find an imported type library in the search paths.
+ */
+std::string findImport(const std::string &file,
+    const std::vector<std::string> &paths)
+{
+    auto name = basename(file);
+    for (const auto &directory: paths) {
+        auto path = directory + "/" + name;
+        if (std::ifstream(path, std::ios::binary).good()) {
+            return path;
+        }
+    }
+
+    return std::ifstream(file, std::ios::binary).good() ? file : "";
+}
+
+
+/** \brief Well-known interfaces imported from stdole.
+ */
+const char * wellKnownName(const GUID &guid)
+{
+    if (IsEqualGUID(guid, IID_IUnknown)) {
+        return "IUnknown";
+    } else if (IsEqualGUID(guid, IID_IDispatch)) {
+        return "IDispatch";
+    } else if (IsEqualGUID(guid, IID_IEnumVARIANT)) {
+        return "IEnumVARIANT";
+    }
+    return nullptr;
+}
+
+
+LibraryPtr load(const std::string &path,
+    const std::vector<std::string> &paths,
+    const size_t depth);
+
+
+/** \brief Parse an MSFT image into a library.
+ */
+class Parser
+{
+protected:
+    Reader reader;
+    const std::vector<std::string> &paths;
+    size_t depth;
+    INT segments[SEGMENT_COUNT][2];
+    size_t ptrsize = 4;
+    std::unordered_map<VARTYPE, size_t> inlined;
+    std::shared_ptr<Library> lib;
+
+    size_t segment(const Segment index) const;
+    size_t segmentLength(const Segment index) const;
+
+    // TABLES
+    std::string name(const INT offset) const;
+    std::string string(const INT offset) const;
+    GUID guid(const INT offset) const;
+    size_t type(const INT datatype);
+    size_t inlineType(const VARTYPE vt);
+    Variant value(const INT offset) const;
+
+    // SECTIONS
+    void header();
+    void typedescs();
+    void typeinfo(const size_t index);
+    void members(TypeEntry &entry,
+        const size_t offset,
+        const size_t functions,
+        const size_t variables);
+    void imports();
+
+public:
+    Parser(const BYTE *data,
+        const size_t size,
+        const std::vector<std::string> &paths,
+        const size_t depth);
+
+    LibraryPtr parse();
+};
+
+
+Parser::Parser(const BYTE *data,
+        const size_t size,
+        const std::vector<std::string> &paths,
+        const size_t depth):
+    reader{data, size},
+    paths(paths),
+    depth(depth),
+    lib(std::make_shared<Library>())
+{}
+
+
+/** \brief Get absolute offset of a segment.
+ */
+size_t Parser::segment(const Segment index) const
+{
+    return size_t(segments[index][0]);
+}
+
+
+/** \brief Get length of a segment, 0 if absent.
+ */
+size_t Parser::segmentLength(const Segment index) const
+{
+    return segments[index][0] < 0 || segments[index][1] < 0 ? 0 : size_t(segments[index][1]);
+}
+
+
+/** \brief Read name from the name table.
+ */
+std::string Parser::name(const INT offset) const
+{
+    if (offset < 0) {
+        return "";
+    }
+
+    size_t position = segment(SEGMENT_NAME) + offset;
+    size_t length = reader.i32(position + 8) & 0xFF;
+    return reader.chars(position + 12, length);
+}
+
+
+/** \brief Read string from the string table.
+ */
+std::string Parser::string(const INT offset) const
+{
+    if (offset < 0) {
+        return "";
+    }
+
+    size_t position = segment(SEGMENT_STRING) + offset;
+    SHORT length = reader.i16(position);
+    return length <= 0 ? "" : reader.chars(position + 2, length);
+}
+
+
+/** \brief Read GUID from the GUID table.
+ */
+GUID Parser::guid(const INT offset) const
+{
+    if (offset < 0) {
+        return GUID_NULL;
+    }
+    return reader.guid(segment(SEGMENT_GUID) + offset);
+}
+
+
+/** \brief Resolve a data type to an index in the type descriptor table.
+ *
+ *  Negative data types store a base VARTYPE inline.
+ */
+size_t Parser::type(const INT datatype)
+{
+    if (datatype < 0) {
+        return inlineType(VARTYPE(datatype & VT_TYPEMASK));
+    }
+
+    size_t index = size_t(datatype) / 8;
+    if (index >= segmentLength(SEGMENT_TYPEDESC) / 8) {
+        throw std::runtime_error("Invalid MSFT type descriptor offset.");
+    }
+    return index;
+}
+
+
+/** \brief Add descriptor for an inline VARTYPE, once per type.
+ */
+size_t Parser::inlineType(const VARTYPE vt)
+{
+    auto it = inlined.find(vt);
+    if (it != inlined.end()) {
+        return it->second;
+    }
+
+    TypeDescEntry entry;
+    entry.vt = vt;
+    lib->typedescs.emplace_back(entry);
+    inlined.emplace(vt, lib->typedescs.size() - 1);
+
+    return lib->typedescs.size() - 1;
+}
+
+
+/** \brief Read constant value, packed inline or from custom data.
+ */
+Variant Parser::value(const INT offset) const
+{
+    Variant variant;
+    if (offset < 0) {
+        variant.vt = VARTYPE((offset & 0x7C000000) >> 26);
+        variant.lVal = offset & 0x3FFFFFF;
+        return variant;
+    }
+
+    size_t position = segment(SEGMENT_CUSTDATA) + offset;
+    VARTYPE vt = reader.read<VARTYPE>(position);
+    size_t size = 0;
+    switch (vt) {
+        case VT_EMPTY:
+        case VT_NULL:
+            break;
+        case VT_I1:
+        case VT_UI1:
+        case VT_I2:
+        case VT_UI2:
+        case VT_I4:
+        case VT_UI4:
+        case VT_INT:
+        case VT_UINT:
+        case VT_R4:
+        case VT_BOOL:
+        case VT_ERROR:
+        case VT_HRESULT:
+            size = 4;
+            break;
+        case VT_I8:
+        case VT_UI8:
+        case VT_R8:
+        case VT_CY:
+        case VT_DATE:
+            size = 8;
+            break;
+        case VT_BSTR: {
+            INT length = reader.i32(position + 2);
+            variant.vt = VT_BSTR;
+            if (length >= 0) {
+                auto chars = reader.chars(position + 6, length);
+                variant.bstrVal = SysAllocStringLen(nullptr, length);
+                for (INT i = 0; i < length; ++i) {
+                    variant.bstrVal[i] = WCHAR(BYTE(chars[i]));
+                }
+            } else {
+                variant.bstrVal = nullptr;
+            }
+            return variant;
+        }
+        default:
+            throw std::runtime_error("Unsupported MSFT constant type: " + std::to_string(vt));
+    }
+
+    variant.vt = vt;
+    variant.llVal = 0;
+    if (size) {
+        auto bytes = reader.chars(position + 2, size);
+        std::memcpy(&variant.llVal, bytes.data(), size);
+    }
+
+    return variant;
+}
+
+
+/** \brief Read library header and segment directory.
+ */
+void Parser::header()
+{
+    if (reader.i32(0) == SLTG_MAGIC) {
+        throw std::runtime_error("SLTG type libraries cannot be read without COM, use -progid instead of -tlb.");
+    } else if (reader.i32(0) != MSFT_MAGIC) {
+        throw std::runtime_error("Not an MSFT type library.");
+    }
+
+    INT varflags = reader.i32(0x14);
+    size_t position = HEADER_SIZE + (varflags & HELPDLL_FLAG ? 4 : 0);
+    lib->count = size_t(reader.i32(0x20));
+    position += 4 * lib->count;
+    for (size_t index = 0; index < SEGMENT_COUNT; ++index) {
+        segments[index][0] = reader.i32(position + index * SEGMENT_SIZE);
+        segments[index][1] = reader.i32(position + index * SEGMENT_SIZE + 4);
+    }
+
+    INT version = reader.i32(0x18);
+    lib->guid = guid(reader.i32(0x08));
+    lib->lcid = LCID(reader.i32(0x0C));
+    lib->syskind = SYSKIND(varflags & 0xF);
+    lib->major = LOWORD(version);
+    lib->minor = HIWORD(version);
+    lib->flags = WORD(reader.i32(0x1C));
+    lib->dispatch = HREFTYPE(reader.i32(0x4C));
+    lib->documentation.name = name(reader.i32(0x38));
+    lib->documentation.doc = string(reader.i32(0x24));
+    lib->documentation.help = DWORD(reader.i32(0x2C));
+    lib->documentation.file = string(reader.i32(0x3C));
+    ptrsize = lib->syskind == SYS_WIN64 ? 8 : 4;
+}
+
+
+/** \brief Read type descriptor and array descriptor tables.
+ */
+void Parser::typedescs()
+{
+    size_t count = segmentLength(SEGMENT_TYPEDESC) / 8;
+    lib->typedescs.resize(count);
+    std::vector<INT> arrays(count, -1);
+
+    size_t position = segment(SEGMENT_TYPEDESC);
+    for (size_t index = 0; index < count; ++index, position += 8) {
+        SHORT td[4];
+        for (size_t i = 0; i < 4; ++i) {
+            td[i] = reader.i16(position + 2 * i);
+        }
+
+        // inline types are appended, so copy the entry back last
+        TypeDescEntry entry;
+        entry.vt = VARTYPE(td[0] & VT_TYPEMASK);
+        if (entry.vt == VT_PTR || entry.vt == VT_SAFEARRAY) {
+            entry.pointee = td[3] < 0 ? inlineType(VARTYPE(td[2] & VT_TYPEMASK)) : type(td[2]);
+        } else if (entry.vt == VT_CARRAY) {
+            arrays[index] = td[2];
+        } else if (entry.vt == VT_USERDEFINED) {
+            entry.href = HREFTYPE(reader.i32(position + 4));
+        }
+        lib->typedescs[index] = entry;
+    }
+
+    for (size_t index = 0; index < count; ++index) {
+        if (arrays[index] < 0) {
+            continue;
+        }
+
+        position = segment(SEGMENT_ARRAYDESC) + arrays[index];
+        ArrayEntry array;
+        SHORT element = reader.i16(position);
+        SHORT inline_ = reader.i16(position + 2);
+        array.element = inline_ < 0 ? inlineType(VARTYPE(element & VT_TYPEMASK)) : type(element);
+        USHORT dimensions = USHORT(reader.i16(position + 4));
+        position += 8;
+        for (USHORT i = 0; i < dimensions; ++i, position += 8) {
+            SafeArrayBound bound;
+            bound.cElements = ULONG(reader.i32(position));
+            bound.lLbound = LONG(reader.i32(position + 4));
+            array.bounds.emplace_back(bound);
+        }
+
+        lib->arrays.emplace_back(std::move(array));
+        lib->typedescs[index].array = lib->arrays.size() - 1;
+    }
+}
+
+
+/** \brief Read a type description from the type info table.
+ */
+void Parser::typeinfo(const size_t index)
+{
+    size_t position = segment(SEGMENT_TYPEINFO) + index * TYPEINFO_SIZE;
+    INT typekind = reader.i32(position);
+    INT elements = reader.i32(position + 0x18);
+    INT version = reader.i32(position + 0x38);
+    INT datatype = reader.i32(position + 0x54);
+
+    auto &entry = lib->entries[index];
+    entry.kind = TYPEKIND(typekind & 0xF);
+    entry.alignment = WORD((typekind >> 11) & 0x1F);
+    entry.guid = guid(reader.i32(position + 0x2C));
+    entry.flags = WORD(reader.i32(position + 0x30));
+    entry.major = LOWORD(version);
+    entry.minor = HIWORD(version);
+    entry.vtbl = WORD(reader.i16(position + 0x4E) * sizeof(void*) / ptrsize);
+    entry.size = ULONG(reader.i32(position + 0x50));
+    entry.base = datatype;
+    entry.documentation.name = name(reader.i32(position + 0x34));
+    entry.documentation.doc = string(reader.i32(position + 0x3C));
+    entry.documentation.help = DWORD(reader.i32(position + 0x44));
+    entry.documentation.file = lib->documentation.file;
+
+    // implemented interfaces
+    SHORT implemented = reader.i16(position + 0x4C);
+    if (entry.kind == TKIND_COCLASS) {
+        INT offset = datatype;
+        for (SHORT i = 0; i < implemented && offset >= 0; ++i) {
+            size_t record = segment(SEGMENT_REFTAB) + offset;
+            entry.impltypes.emplace_back(HREFTYPE(reader.i32(record)));
+            entry.implflags.emplace_back(reader.i32(record + 4));
+            offset = reader.i32(record + 12);
+        }
+    } else if (implemented > 0) {
+        bool dispatch = entry.kind == TKIND_DISPATCH && datatype == -1;
+        entry.impltypes.emplace_back(dispatch ? lib->dispatch : HREFTYPE(datatype));
+        entry.implflags.emplace_back(0);
+    }
+    if (entry.kind == TKIND_ALIAS) {
+        entry.alias = type(datatype);
+    }
+
+    size_t functions = LOWORD(elements);
+    size_t variables = HIWORD(elements);
+    if (functions + variables) {
+        members(entry, size_t(reader.i32(position + 0x04)), functions, variables);
+    }
+}
+
+
+/** \brief Read function and variable records of a type.
+ *
+ *  The records are followed by arrays of member IDs, name offsets
+ *  and record offsets, each with one entry per member.
+ */
+void Parser::members(TypeEntry &entry,
+    const size_t offset,
+    const size_t functions,
+    const size_t variables)
+{
+    size_t total = functions + variables;
+    size_t infolen = size_t(reader.i32(offset));
+    size_t ids = offset + infolen + 4;
+    size_t names = ids + 4 * total;
+    size_t records = names + 4 * total;
+
+    for (size_t i = 0; i < functions; ++i) {
+        size_t record = offset + 4 + reader.i32(records + 4 * i);
+        size_t length = size_t(reader.i32(record)) & 0xFFFF;
+        INT fkccic = reader.i32(record + 16);
+        SHORT args = reader.i16(record + 20);
+
+        FuncEntry function;
+        function.id = reader.i32(ids + 4 * i);
+        function.kind = FUNCKIND(fkccic & 0x7);
+        function.invocation = INVOKEKIND((fkccic >> 3) & 0xF);
+        function.callconv = CALLCONV((fkccic >> 8) & 0xF);
+        function.offset = SHORT((reader.i16(record + 12) & ~1) * sizeof(void*) / ptrsize);
+        function.optional = reader.i16(record + 22);
+        function.flags = LOWORD(reader.i32(record + 8));
+        function.returns = type(reader.i32(record + 4));
+
+        // optional attributes precede the parameter records
+        INT nameoffset = reader.i32(names + 4 * i);
+        if (nameoffset == -1 && i > 0) {
+            // second half of a property get/put pair
+            function.documentation.name = entry.functions.back().documentation.name;
+        } else {
+            function.documentation.name = name(nameoffset);
+        }
+        size_t optional = length - args * 12 - (fkccic & 0x1000 ? args * 4 : 0);
+        if (optional > 24) {
+            function.documentation.help = DWORD(reader.i32(record + 24));
+        }
+        if (optional > 28) {
+            function.documentation.doc = string(reader.i32(record + 28));
+        }
+
+        size_t param = record + length - args * 12;
+        for (SHORT j = 0; j < args; ++j, param += 12) {
+            ParamEntry parameter;
+            parameter.type = type(reader.i32(param));
+            parameter.name = name(reader.i32(param + 4));
+            parameter.flags = USHORT(reader.i32(param + 8));
+            function.params.emplace_back(std::move(parameter));
+        }
+
+        entry.functions.emplace_back(std::move(function));
+    }
+
+    for (size_t i = 0; i < variables; ++i) {
+        size_t record = offset + 4 + reader.i32(records + 4 * (functions + i));
+        size_t length = size_t(reader.i16(record)) & 0xFF;
+
+        VarEntry variable;
+        variable.id = reader.i32(ids + 4 * (functions + i));
+        variable.type = type(reader.i32(record + 4));
+        variable.flags = LOWORD(reader.i32(record + 8));
+        variable.kind = VARKIND(reader.i16(record + 12));
+        variable.documentation.name = name(reader.i32(names + 4 * (functions + i)));
+        if (length > 20) {
+            variable.documentation.help = DWORD(reader.i32(record + 20));
+        }
+        if (length > 24) {
+            variable.documentation.doc = string(reader.i32(record + 24));
+        }
+
+        INT value = reader.i32(record + 16);
+        if (variable.kind == VAR_CONST) {
+            variable.value = this->value(value);
+        } else {
+            variable.offset = ULONG(value);
+        }
+
+        entry.variables.emplace_back(std::move(variable));
+    }
+}
+
+
+/** \brief Resolve types imported from other libraries.
+ *
+ *  Imported libraries are opened from the search paths, and the
+ *  stdole interfaces required by every dual or dispatch interface
+ *  are added as placeholders when stdole cannot be found.
+ */
+void Parser::imports()
+{
+    std::unordered_map<std::string, LibraryPtr> opened;
+    auto addFile = [this](const std::string &file) {
+        if (std::find(lib->files.begin(), lib->files.end(), file) == lib->files.end()) {
+            lib->files.emplace_back(file);
+        }
+    };
+    size_t count = segmentLength(SEGMENT_IMPINFO) / IMPINFO_SIZE;
+    for (size_t index = 0; index < count; ++index) {
+        size_t position = segment(SEGMENT_IMPINFO) + index * IMPINFO_SIZE;
+        INT flags = reader.i32(position);
+        INT file = reader.i32(position + 4);
+        INT reference = reader.i32(position + 8);
+        HREFTYPE href = HREFTYPE(index * IMPINFO_SIZE);
+
+        // find type in imported library
+        size_t record = segment(SEGMENT_IMPFILES) + file;
+        size_t length = USHORT(reader.i16(record + 12)) >> 2;
+        auto path = findImport(reader.chars(record + 14, length), paths);
+        GUID guid = flags & IMPINFO_GUID_FLAG ? this->guid(reference) : GUID_NULL;
+        if (!path.empty() && depth < MAX_IMPORT_DEPTH) {
+            auto &imported = opened[path];
+            if (!imported) {
+                imported = load(path, paths, depth + 1);
+                addFile(path);
+                for (const auto &file: imported->files) {
+                    addFile(file);
+                }
+            }
+            for (size_t i = 0; i < imported->count; ++i) {
+                bool match = flags & IMPINFO_GUID_FLAG ? IsEqualGUID(imported->entries[i].guid, guid) : i == size_t(reference);
+                if (match) {
+                    lib->imports[href] = ImportEntry {imported, i};
+                    break;
+                }
+            }
+        }
+
+        auto *name = wellKnownName(guid);
+        if (lib->imports.find(href) == lib->imports.end() && name) {
+            TypeEntry entry;
+            entry.guid = guid;
+            entry.documentation.name = name;
+            lib->entries.emplace_back(std::move(entry));
+            lib->imports[href] = ImportEntry {nullptr, lib->entries.size() - 1};
+        }
+    }
+}
+
+
+/** \brief Parse the full image.
+ */
+LibraryPtr Parser::parse()
+{
+    header();
+    typedescs();
+    lib->entries.resize(lib->count);
+    for (size_t index = 0; index < lib->count; ++index) {
+        typeinfo(index);
+    }
+    imports();
+
+    return lib;
+}
+
+
+/** \brief Load `.tlb` file, or the TYPELIB resource of a PE image.
+ */
+LibraryPtr load(const std::string &path,
+    const std::vector<std::string> &paths,
+    const size_t depth)
+{
+    MappedFile file(path);
+    auto *data = reinterpret_cast<const BYTE*>(file.data());
+    size_t offset = 0;
+    size_t size = file.size();
+    if (size >= 2 && data[0] == 'M' && data[1] == 'Z') {
+        std::tie(offset, size) = findTypeLibResource(data, size);
+        if (offset > file.size() || file.size() - offset < size) {
+            throw std::runtime_error("Truncated TYPELIB resource.");
+        }
+    }
+
+    return Parser(data + offset, size, paths, depth).parse();
+}
+
+
+/** \brief Read UTF-16 resource name as ASCII.
+ */
+std::string resourceName(const Reader &reader,
+    const size_t offset)
+{
+    USHORT length = reader.read<USHORT>(offset);
+    std::string name;
+    for (USHORT i = 0; i < length; ++i) {
+        name.push_back(char(reader.read<USHORT>(offset + 2 + 2 * i)));
+    }
+    return name;
+}
+
+}   /* anonymous */
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Find the TYPELIB resource in a PE image.
+ *
+ *  Walks the type, name and language levels of the resource
+ *  directory, and maps the data RVA back to a file offset.
+ */
+std::pair<size_t, size_t> findTypeLibResource(const void *data,
+    const size_t size,
+    const WORD index)
+{
+    Reader reader {reinterpret_cast<const BYTE*>(data), size};
+    if (reader.read<WORD>(0) != 0x5A4D) {
+        throw std::runtime_error("Not a PE image.");
+    }
+    size_t pe = size_t(reader.i32(0x3C));
+    if (reader.i32(pe) != 0x00004550) {
+        throw std::runtime_error("Not a PE image.");
+    }
+
+    // find resource directory
+    WORD sections = reader.read<WORD>(pe + 6);
+    WORD optionalSize = reader.read<WORD>(pe + 20);
+    size_t optional = pe + 24;
+    WORD magic = reader.read<WORD>(optional);
+    size_t directories = optional + (magic == 0x20B ? 112 : 96);
+    DWORD rva = reader.read<DWORD>(directories + 2 * 8);
+
+    size_t root = 0;
+    DWORD base = 0;
+    size_t table = optional + optionalSize;
+    for (WORD i = 0; i < sections; ++i) {
+        size_t section = table + i * 40;
+        DWORD virtualSize = reader.read<DWORD>(section + 8);
+        DWORD address = reader.read<DWORD>(section + 12);
+        DWORD raw = reader.read<DWORD>(section + 20);
+        if (rva >= address && rva < address + virtualSize) {
+            root = raw + (rva - address);
+            base = address - raw;
+            break;
+        }
+    }
+    if (!root) {
+        throw std::runtime_error("PE image has no resources.");
+    }
+
+    // walk type, name and language levels
+    auto find = [&](size_t directory, std::function<bool(DWORD)> match) -> DWORD {
+        WORD named = reader.read<WORD>(directory + 12);
+        WORD ids = reader.read<WORD>(directory + 14);
+        for (WORD i = 0; i < named + ids; ++i) {
+            size_t entry = directory + 16 + i * 8;
+            if (match(reader.read<DWORD>(entry))) {
+                return reader.read<DWORD>(entry + 4);
+            }
+        }
+        throw std::runtime_error("PE image has no TYPELIB resource.");
+    };
+
+    DWORD names = find(root, [&](DWORD name) {
+        return (name & 0x80000000) && resourceName(reader, root + (name & 0x7FFFFFFF)) == "TYPELIB";
+    });
+    DWORD languages = find(root + (names & 0x7FFFFFFF), [&](DWORD name) {
+        return index == 0 || (!(name & 0x80000000) && name == index);
+    });
+    DWORD leaf = find(root + (languages & 0x7FFFFFFF), [](DWORD) {
+        return true;
+    });
+
+    size_t entry = root + (leaf & 0x7FFFFFFF);
+    DWORD address = reader.read<DWORD>(entry);
+    DWORD length = reader.read<DWORD>(entry + 4);
+    return std::make_pair(size_t(address - base), size_t(length));
+}
+
+// OBJECTS
+// -------
+
+
+/** \brief Equality operator, true if both refer to the same library.
+ */
+bool operator==(const TypeLib &left,
+    const TypeLib &right)
+{
+    return left.lib == right.lib;
+}
+
+
+/** \brief Inequality operator.
+ */
+bool operator!=(const TypeLib &left,
+    const TypeLib &right)
+{
+    return !operator==(left, right);
+}
+
+
+/** \brief Equality operator, true if both describe the same type view.
+ */
+bool operator==(const TypeInfo &left,
+    const TypeInfo &right)
+{
+    return left.lib == right.lib && left.index == right.index && left.dual == right.dual;
+}
+
+
+/** \brief Inequality operator.
+ */
+bool operator!=(const TypeInfo &left,
+    const TypeInfo &right)
+{
+    return !operator==(left, right);
+}
+
+
+/** \brief Initialize from parsed library.
+ */
+TypeLib::TypeLib(const LibraryPtr &lib):
+    lib(lib)
+{}
+
+
+/** \brief Open type library from file.
+ */
+TypeLib::TypeLib(const std::string &path,
+    const std::vector<std::string> &paths)
+{
+    open(path, paths);
+}
+
+
+/** \brief Open `.tlb` file, or the TYPELIB resource of a PE image.
+ */
+void TypeLib::open(const std::string &path,
+    const std::vector<std::string> &paths)
+{
+    lib = load(path, paths, 0);
+}
+
+
+/** \brief Check if library is open.
+ */
+TypeLib::operator bool() const
+{
+    return bool(lib);
+}
+
+
+/** \brief Get library attributes.
+ */
+TypeLibAttr TypeLib::attr() const
+{
+    return TypeLibAttr(lib);
+}
+
+
+/** \brief Get documentation for library, or a type if index >= 0.
+ */
+Documentation TypeLib::documentation(const INT index) const
+{
+    if (index < 0) {
+        return lib->documentation;
+    }
+    return lib->entry(index).documentation;
+}
+
+
+/** \brief Get number of types in library.
+ */
+UINT TypeLib::count() const
+{
+    return UINT(lib->count);
+}
+
+
+/** \brief Get paths of the imported type libraries found on the search path.
+ */
+const std::vector<std::string> & TypeLib::imports() const
+{
+    return lib->files;
+}
+
+
+/** \brief Get type description by index.
+ */
+TypeInfo TypeLib::info(const UINT index) const
+{
+    if (index >= lib->count) {
+        throw ComMethodError("ITypeLib", "GetTypeInfo(...)");
+    }
+    return TypeInfo(lib, index);
+}
+
+
+/** \brief Get documentation for library, or a type if index >= 0.
+ */
+Documentation TypeLib::GetDocumentation(const INT index) const
+{
+    return documentation(index);
+}
+
+
+/** \brief Get number of types in library.
+ */
+UINT TypeLib::GetTypeInfoCount() const
+{
+    return count();
+}
+
+
+/** \brief Get type description by index.
+ */
+TypeInfo TypeLib::GetTypeInfo(const UINT index) const
+{
+    return info(index);
+}
+
+
+/** \brief Initialize from library and type index.
+ */
+TypeInfo::TypeInfo(const LibraryPtr &lib,
+        const size_t index,
+        const bool dual):
+    lib(lib),
+    index(index),
+    dual(dual)
+{}
+
+
+/** \brief Get containing type library.
+ */
+TypeLib TypeInfo::typelib() const
+{
+    return TypeLib(lib);
+}
+
+
+/** \brief Get type attributes.
+ */
+TypeAttr TypeInfo::attr() const
+{
+    return TypeAttr(lib, index, dual);
+}
+
+
+/** \brief Get documentation for the type, or a member by ID.
+ */
+Documentation TypeInfo::documentation(const MEMBERID id) const
+{
+    const auto &entry = lib->entry(index);
+    if (id == MEMBERID_NIL) {
+        return entry.documentation;
+    }
+    for (const auto &function: entry.functions) {
+        if (function.id == id) {
+            return function.documentation;
+        }
+    }
+    for (const auto &variable: entry.variables) {
+        if (variable.id == id) {
+            return variable.documentation;
+        }
+    }
+
+    throw ComMethodError("ITypeInfo", "GetDocumentation(...)");
+}
+
+
+/** \brief Get variable description by index.
+ */
+VarDesc TypeInfo::vardesc(const UINT index) const
+{
+    if (index >= lib->entry(this->index).variables.size()) {
+        throw ComMethodError("ITypeInfo", "GetVarDesc(...)");
+    }
+    return VarDesc(lib, this->index, index);
+}
+
+
+/** \brief Get function description by index.
+ */
+FuncDesc TypeInfo::funcdesc(const UINT index) const
+{
+    if (index >= lib->entry(this->index).functions.size()) {
+        throw ComMethodError("ITypeInfo", "GetFuncDesc(...)");
+    }
+    return FuncDesc(lib, this->index, index);
+}
+
+
+/** \brief Get referenced type description.
+ *
+ *  References within the library are offsets into the type info
+ *  table, and references with the low bits set are imported.
+ */
+TypeInfo TypeInfo::info(const HREFTYPE type) const
+{
+    if (type == DUAL_HREFTYPE) {
+        return TypeInfo(lib, index, true);
+    } else if (!(type & 3)) {
+        size_t offset = type / TYPEINFO_SIZE;
+        if (type % TYPEINFO_SIZE || offset >= lib->count) {
+            throw ComMethodError("ITypeInfo", "GetRefTypeInfo(...)");
+        }
+        return TypeInfo(lib, offset);
+    }
+
+    auto it = lib->imports.find(type & ~HREFTYPE(3));
+    if (it == lib->imports.end()) {
+        throw ComMethodError("ITypeInfo", "GetRefTypeInfo(...)");
+    }
+    return TypeInfo(it->second.lib ? it->second.lib : lib, it->second.index);
+}
+
+
+/** \brief Get reference to implemented interface.
+ *
+ *  Index -1 returns the TKIND_INTERFACE half of a dual interface,
+ *  and dispatch interfaces always derive from IDispatch.
+ */
+HREFTYPE TypeInfo::reference(const UINT index) const
+{
+    const auto &entry = lib->entry(this->index);
+    if (index == UINT(-1)) {
+        if (!dual && entry.kind == TKIND_DISPATCH && (entry.flags & TYPEFLAG_FDUAL)) {
+            return DUAL_HREFTYPE;
+        }
+    } else if (dual && index == 0) {
+        return entry.base == -1 ? lib->dispatch : HREFTYPE(entry.base);
+    } else if (entry.kind == TKIND_DISPATCH && index == 0) {
+        return lib->dispatch;
+    } else if (index < entry.impltypes.size()) {
+        return entry.impltypes[index];
+    }
+
+    throw ComMethodError("ITypeInfo", "GetRefTypeOfImplType(...)");
+}
+
+
+/** \brief Get flags of implemented interface.
+ */
+INT TypeInfo::flags(const UINT index) const
+{
+    const auto &entry = lib->entry(this->index);
+    if (index >= entry.implflags.size()) {
+        throw ComMethodError("ITypeInfo", "GetImplTypeFlags(...)");
+    }
+    return entry.implflags[index];
+}
+
+
+/** \brief Get name of a member, followed by its parameter names.
+ */
+std::vector<std::string> TypeInfo::names(const MEMBERID id) const
+{
+    const auto &entry = lib->entry(index);
+    for (const auto &function: entry.functions) {
+        if (function.id == id) {
+            std::vector<std::string> list = {function.documentation.name};
+            for (const auto &parameter: function.params) {
+                list.emplace_back(parameter.name);
+            }
+            return list;
+        }
+    }
+    for (const auto &variable: entry.variables) {
+        if (variable.id == id) {
+            return {variable.documentation.name};
+        }
+    }
+
+    throw ComMethodError("ITypeInfo", "GetNames(...)");
+}
+
+
+/** \brief Get documentation for the type, or a member by ID.
+ */
+Documentation TypeInfo::GetDocumentation(const MEMBERID id) const
+{
+    return documentation(id);
+}
+
+
+/** \brief Get name of a member, followed by its parameter names.
+ */
+std::vector<std::string> TypeInfo::GetNames(const MEMBERID id) const
+{
+    return names(id);
+}
+
+
+/** \brief Get referenced type description.
+ */
+TypeInfo TypeInfo::GetRefTypeInfo(const HREFTYPE type) const
+{
+    return info(type);
+}
+
+
+/** \brief Get reference to implemented interface.
+ */
+HREFTYPE TypeInfo::GetRefTypeOfImplType(const UINT index) const
+{
+    return reference(index);
+}
+
+
+/** \brief Get flags of implemented interface.
+ */
+INT TypeInfo::GetImplTypeFlags(const UINT index) const
+{
+    return flags(index);
+}
+
+
+/** \brief Initialize from library and type index.
+ */
+TypeAttr::TypeAttr(const LibraryPtr &lib,
+        const size_t index,
+        const bool dual):
+    lib(lib),
+    index(index),
+    dual(dual)
+{}
+
+
+/** \brief Get GUID of type.
+ */
+Guid TypeAttr::guid() const
+{
+    return Guid(lib->entry(index).guid);
+}
+
+
+/** \brief Get size of an instance of the type.
+ */
+ULONG TypeAttr::size() const
+{
+    return lib->entry(index).size;
+}
+
+
+/** \brief Get kind of type.
+ */
+TYPEKIND TypeAttr::kind() const
+{
+    return dual ? TKIND_INTERFACE : lib->entry(index).kind;
+}
+
+
+/** \brief Get number of functions.
+ */
+WORD TypeAttr::functions() const
+{
+    return WORD(lib->entry(index).functions.size());
+}
+
+
+/** \brief Get number of variables.
+ */
+WORD TypeAttr::variables() const
+{
+    return WORD(lib->entry(index).variables.size());
+}
+
+
+/** \brief Get number of implemented interfaces.
+ */
+WORD TypeAttr::interfaces() const
+{
+    return dual ? 1 : WORD(lib->entry(index).impltypes.size());
+}
+
+
+/** \brief Get size of the virtual function table.
+ */
+WORD TypeAttr::vtblSize() const
+{
+    return lib->entry(index).vtbl;
+}
+
+
+/** \brief Get byte alignment of an instance of the type.
+ */
+WORD TypeAttr::alignment() const
+{
+    return lib->entry(index).alignment;
+}
+
+
+/** \brief Get type flags.
+ */
+WORD TypeAttr::flags() const
+{
+    return lib->entry(index).flags;
+}
+
+
+/** \brief Get major version of type.
+ */
+WORD TypeAttr::major() const
+{
+    return lib->entry(index).major;
+}
+
+
+/** \brief Get minor version of type.
+ */
+WORD TypeAttr::minor() const
+{
+    return lib->entry(index).minor;
+}
+
+
+/** \brief Get aliased type for TKIND_ALIAS.
+ */
+TypeDesc TypeAttr::alias() const
+{
+    return TypeDesc(lib, lib->entry(index).alias);
+}
+
+
+/** \brief Get size of an instance of the type.
+ */
+ULONG TypeAttr::cbSizeInstance() const
+{
+    return size();
+}
+
+
+/** \brief Get kind of type.
+ */
+TYPEKIND TypeAttr::typekind() const
+{
+    return kind();
+}
+
+
+/** \brief Get number of functions.
+ */
+WORD TypeAttr::cFuncs() const
+{
+    return functions();
+}
+
+
+/** \brief Get number of variables.
+ */
+WORD TypeAttr::cVars() const
+{
+    return variables();
+}
+
+
+/** \brief Get number of implemented interfaces.
+ */
+WORD TypeAttr::cImplTypes() const
+{
+    return interfaces();
+}
+
+
+/** \brief Get size of the virtual function table.
+ */
+WORD TypeAttr::cbSizeVft() const
+{
+    return vtblSize();
+}
+
+
+/** \brief Get byte alignment of an instance of the type.
+ */
+WORD TypeAttr::cbAlignment() const
+{
+    return alignment();
+}
+
+
+/** \brief Get type flags.
+ */
+WORD TypeAttr::wTypeFlags() const
+{
+    return flags();
+}
+
+
+/** \brief Get major version of type.
+ */
+WORD TypeAttr::wMajorVerNum() const
+{
+    return major();
+}
+
+
+/** \brief Get minor version of type.
+ */
+WORD TypeAttr::wMinorVerNum() const
+{
+    return minor();
+}
+
+
+/** \brief Get aliased type for TKIND_ALIAS.
+ */
+TypeDesc TypeAttr::tdescAlias() const
+{
+    return alias();
+}
+
+
+/** \brief Initialize from parsed library.
+ */
+TypeLibAttr::TypeLibAttr(const LibraryPtr &lib):
+    lib(lib)
+{}
+
+
+/** \brief Get GUID of library.
+ */
+Guid TypeLibAttr::guid() const
+{
+    return Guid(lib->guid);
+}
+
+
+/** \brief Get locale of library.
+ */
+LCID TypeLibAttr::lcid() const
+{
+    return lib->lcid;
+}
+
+
+/** \brief Get target platform of library.
+ */
+SYSKIND TypeLibAttr::syskind() const
+{
+    return lib->syskind;
+}
+
+
+/** \brief Get major version of library.
+ */
+WORD TypeLibAttr::major() const
+{
+    return lib->major;
+}
+
+
+/** \brief Get minor version of library.
+ */
+WORD TypeLibAttr::minor() const
+{
+    return lib->minor;
+}
+
+
+/** \brief Get library flags.
+ */
+WORD TypeLibAttr::flags() const
+{
+    return lib->flags;
+}
+
+
+/** \brief Get major version of library.
+ */
+WORD TypeLibAttr::wMajorVerNum() const
+{
+    return major();
+}
+
+
+/** \brief Get minor version of library.
+ */
+WORD TypeLibAttr::wMinorVerNum() const
+{
+    return minor();
+}
+
+
+/** \brief Get library flags.
+ */
+WORD TypeLibAttr::wLibFlags() const
+{
+    return flags();
+}
+
+
+/** \brief Initialize from type and variable index.
+ */
+VarDesc::VarDesc(const LibraryPtr &lib,
+        const size_t type,
+        const size_t index):
+    lib(lib),
+    type(type),
+    index(index)
+{}
+
+
+/** \brief Get member ID of variable.
+ */
+MEMBERID VarDesc::id() const
+{
+    return lib->entry(type).variables[index].id;
+}
+
+
+/** \brief Get element description of variable.
+ */
+ElemDesc VarDesc::element() const
+{
+    return ElemDesc(lib, lib->entry(type).variables[index].type);
+}
+
+
+/** \brief Get value of VAR_CONST variable.
+ */
+const VARIANT & VarDesc::variant() const
+{
+    return lib->entry(type).variables[index].value;
+}
+
+
+/** \brief Get variable flags.
+ */
+WORD VarDesc::flags() const
+{
+    return lib->entry(type).variables[index].flags;
+}
+
+
+/** \brief Get kind of variable.
+ */
+VARKIND VarDesc::kind() const
+{
+    return lib->entry(type).variables[index].kind;
+}
+
+
+/** \brief Get offset of VAR_PERINSTANCE variable.
+ */
+ULONG VarDesc::offset() const
+{
+    return lib->entry(type).variables[index].offset;
+}
+
+
+/** \brief Get member ID of variable.
+ */
+MEMBERID VarDesc::memid() const
+{
+    return id();
+}
+
+
+/** \brief Get element description of variable.
+ */
+ElemDesc VarDesc::elemdescVar() const
+{
+    return element();
+}
+
+
+/** \brief Get value of VAR_CONST variable.
+ */
+const VARIANT & VarDesc::lpvarValue() const
+{
+    return variant();
+}
+
+
+/** \brief Get variable flags.
+ */
+WORD VarDesc::wVarFlags() const
+{
+    return flags();
+}
+
+
+/** \brief Get kind of variable.
+ */
+VARKIND VarDesc::varkind() const
+{
+    return kind();
+}
+
+
+/** \brief Get offset of VAR_PERINSTANCE variable.
+ */
+ULONG VarDesc::oInst() const
+{
+    return offset();
+}
+
+
+/** \brief Initialize from type and function index.
+ */
+FuncDesc::FuncDesc(const LibraryPtr &lib,
+        const size_t type,
+        const size_t index):
+    lib(lib),
+    type(type),
+    index(index)
+{}
+
+
+/** \brief Get member ID of function.
+ */
+MEMBERID FuncDesc::id() const
+{
+    return lib->entry(type).functions[index].id;
+}
+
+
+/** \brief Get kind of function.
+ */
+FUNCKIND FuncDesc::kind() const
+{
+    return lib->entry(type).functions[index].kind;
+}
+
+
+/** \brief Get invocation kind of function.
+ */
+INVOKEKIND FuncDesc::invocation() const
+{
+    return lib->entry(type).functions[index].invocation;
+}
+
+
+/** \brief Get calling convention of function.
+ */
+CALLCONV FuncDesc::decoration() const
+{
+    return lib->entry(type).functions[index].callconv;
+}
+
+
+/** \brief Get description of argument by index.
+ */
+ElemDesc FuncDesc::arg(const SHORT index) const
+{
+    const auto &params = lib->entry(type).functions[this->index].params;
+    if (index < 0 || size_t(index) >= params.size()) {
+        throw std::out_of_range("Argument index out of range.");
+    }
+    return ElemDesc(lib, params[index].type, params[index].flags);
+}
+
+
+/** \brief Get number of arguments.
+ */
+SHORT FuncDesc::args() const
+{
+    return SHORT(lib->entry(type).functions[index].params.size());
+}
+
+
+/** \brief Get number of optional arguments.
+ */
+SHORT FuncDesc::optional() const
+{
+    return lib->entry(type).functions[index].optional;
+}
+
+
+/** \brief Get offset in virtual function table.
+ */
+SHORT FuncDesc::offset() const
+{
+    return lib->entry(type).functions[index].offset;
+}
+
+
+/** \brief Get description of return type.
+ */
+ElemDesc FuncDesc::returnType() const
+{
+    return ElemDesc(lib, lib->entry(type).functions[index].returns);
+}
+
+
+/** \brief Get function flags.
+ */
+WORD FuncDesc::flags() const
+{
+    return lib->entry(type).functions[index].flags;
+}
+
+
+/** \brief Get member ID of function.
+ */
+MEMBERID FuncDesc::memid() const
+{
+    return id();
+}
+
+
+/** \brief Get kind of function.
+ */
+FUNCKIND FuncDesc::funckind() const
+{
+    return kind();
+}
+
+
+/** \brief Get invocation kind of function.
+ */
+INVOKEKIND FuncDesc::invkind() const
+{
+    return invocation();
+}
+
+
+/** \brief Get calling convention of function.
+ */
+CALLCONV FuncDesc::callconv() const
+{
+    return decoration();
+}
+
+
+/** \brief Get description of argument by index.
+ */
+ElemDesc FuncDesc::lprgelemdescParam(const SHORT index) const
+{
+    return arg(index);
+}
+
+
+/** \brief Get number of arguments.
+ */
+SHORT FuncDesc::cParams() const
+{
+    return args();
+}
+
+
+/** \brief Get number of optional arguments.
+ */
+SHORT FuncDesc::cParamsOpt() const
+{
+    return optional();
+}
+
+
+/** \brief Get offset in virtual function table.
+ */
+SHORT FuncDesc::oVft() const
+{
+    return offset();
+}
+
+
+/** \brief Get description of return type.
+ */
+ElemDesc FuncDesc::elemdescFunc() const
+{
+    return returnType();
+}
+
+
+/** \brief Get function flags.
+ */
+WORD FuncDesc::wFuncFlags() const
+{
+    return flags();
+}
+
+
+/** \brief Initialize from type descriptor index.
+ */
+TypeDesc::TypeDesc(const LibraryPtr &lib,
+        const size_t index):
+    lib(lib),
+    index(index)
+{}
+
+
+/** \brief Get variant type.
+ */
+VARTYPE TypeDesc::vt() const
+{
+    return lib->typedescs.at(index).vt;
+}
+
+
+/** \brief Get type pointed to for VT_PTR and VT_SAFEARRAY.
+ */
+TypeDesc TypeDesc::pointer() const
+{
+    return TypeDesc(lib, lib->typedescs.at(index).pointee);
+}
+
+
+/** \brief Get array description for VT_CARRAY.
+ */
+ArrayDesc TypeDesc::array() const
+{
+    return ArrayDesc(lib, lib->typedescs.at(index).array);
+}
+
+
+/** \brief Get type reference for VT_USERDEFINED.
+ */
+HREFTYPE TypeDesc::reference() const
+{
+    return lib->typedescs.at(index).href;
+}
+
+
+/** \brief Get type pointed to for VT_PTR and VT_SAFEARRAY.
+ */
+TypeDesc TypeDesc::lptdesc() const
+{
+    return pointer();
+}
+
+
+/** \brief Get type reference for VT_USERDEFINED.
+ */
+HREFTYPE TypeDesc::hreftype() const
+{
+    return reference();
+}
+
+
+/** \brief Get array description for VT_CARRAY.
+ */
+ArrayDesc TypeDesc::lpadesc() const
+{
+    return array();
+}
+
+
+/** \brief Initialize from array descriptor index.
+ */
+ArrayDesc::ArrayDesc(const LibraryPtr &lib,
+        const size_t index):
+    lib(lib),
+    index(index)
+{}
+
+
+/** \brief Get element type.
+ */
+TypeDesc ArrayDesc::type() const
+{
+    return TypeDesc(lib, lib->arrays.at(index).element);
+}
+
+
+/** \brief Get number of dimensions.
+ */
+USHORT ArrayDesc::count() const
+{
+    return USHORT(lib->arrays.at(index).bounds.size());
+}
+
+
+/** \brief Get bounds of a dimension.
+ */
+SafeArrayBound ArrayDesc::bound(const USHORT index) const
+{
+    return lib->arrays.at(this->index).bounds.at(index);
+}
+
+
+/** \brief Get element type.
+ */
+TypeDesc ArrayDesc::tdescElem() const
+{
+    return type();
+}
+
+
+/** \brief Get number of dimensions.
+ */
+USHORT ArrayDesc::cDims() const
+{
+    return count();
+}
+
+
+/** \brief Get bounds of a dimension.
+ */
+SafeArrayBound ArrayDesc::rgbounds(const USHORT index) const
+{
+    return bound(index);
+}
+
+
+/** \brief Initialize from type descriptor index and parameter flags.
+ */
+ElemDesc::ElemDesc(const LibraryPtr &lib,
+        const size_t index,
+        const USHORT paramflags):
+    lib(lib),
+    index(index),
+    paramflags(paramflags)
+{}
+
+
+/** \brief Get element type.
+ */
+TypeDesc ElemDesc::type() const
+{
+    return TypeDesc(lib, index);
+}
+
+
+/** \brief Get parameter flags.
+ */
+USHORT ElemDesc::flags() const
+{
+    return paramflags;
+}
+
+
+/** \brief Get element type.
+ */
+TypeDesc ElemDesc::tdesc() const
+{
+    return type();
+}
+
+
+/** \brief Get parameter flags.
+ */
+USHORT ElemDesc::wParamFlags() const
+{
+    return flags();
+}
+
+}   /* msft */
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
@@ -0,0 +1,416 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Native reader for MSFT type libraries.
+ *
+ *  Reads `.tlb` files, and TYPELIB resources embedded in PE images,
+ *  from a memory-mapped file without loading oleaut32 or the COM
+ *  server. The classes mirror the subset of the TypeLib and TypeInfo
+ *  wrappers used by the header generator.
+ */
+
+#pragma once
+
+#include <autocom.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace autocom
+{
+namespace msft
+{
+// FORWARD
+// -------
+
+struct Library;
+class TypeInfo;
+class TypeAttr;
+class TypeLib;
+class TypeLibAttr;
+class VarDesc;
+class FuncDesc;
+class TypeDesc;
+class ArrayDesc;
+class ElemDesc;
+
+// TYPES
+// -----
+
+typedef std::shared_ptr<const Library> LibraryPtr;
+
+// CONSTANTS
+// ---------
+
+/** \brief Reference to the TKIND_INTERFACE half of a dual interface.
+ */
+static constexpr HREFTYPE DUAL_HREFTYPE = HREFTYPE(-2);
+
+// FUNCTIONS
+// ---------
+
+/** \brief Find the TYPELIB resource in a PE image.
+ *
+ *  Returns the offset and length of the resource, with `index`
+ *  matching the resource ID, or the first resource if 0.
+ */
+std::pair<size_t, size_t> findTypeLibResource(const void *data,
+    const size_t size,
+    const WORD index = 0);
+
+// OBJECTS
+// -------
+
+
+/** \brief Type library read from an MSFT image.
+ *
+ *  Imported type libraries are resolved from `paths`, and the
+ *  IUnknown and IDispatch interfaces from stdole are known without
+ *  a search path. Images in the older SLTG format are not read, and
+ *  throw `std::runtime_error`.
+ */
+class TypeLib
+{
+protected:
+    LibraryPtr lib;
+
+    friend class TypeInfo;
+    friend bool operator==(const TypeLib &left,
+        const TypeLib &right);
+    friend bool operator!=(const TypeLib &left,
+        const TypeLib &right);
+
+public:
+    TypeLib() = default;
+    TypeLib(const TypeLib&) = default;
+    TypeLib & operator=(const TypeLib&) = default;
+    TypeLib(TypeLib&&) = default;
+    TypeLib & operator=(TypeLib&&) = default;
+
+    TypeLib(const LibraryPtr &lib);
+    TypeLib(const std::string &path,
+        const std::vector<std::string> &paths = {});
+    void open(const std::string &path,
+        const std::vector<std::string> &paths = {});
+
+    // DATA
+    explicit operator bool() const;
+    TypeLibAttr attr() const;
+    Documentation documentation(const INT index) const;
+    UINT count() const;
+    TypeInfo info(const UINT index) const;
+    const std::vector<std::string> & imports() const;
+
+    // WINAPI
+    Documentation GetDocumentation(const INT index) const;
+    UINT GetTypeInfoCount() const;
+    TypeInfo GetTypeInfo(const UINT index) const;
+};
+
+
+/** \brief Type description read from an MSFT image.
+ *
+ *  `dual` selects the TKIND_INTERFACE view of a dual interface.
+ */
+class TypeInfo
+{
+protected:
+    LibraryPtr lib;
+    size_t index = 0;
+    bool dual = false;
+
+    friend bool operator==(const TypeInfo &left,
+        const TypeInfo &right);
+    friend bool operator!=(const TypeInfo &left,
+        const TypeInfo &right);
+
+public:
+    TypeInfo() = default;
+    TypeInfo(const TypeInfo&) = default;
+    TypeInfo & operator=(const TypeInfo&) = default;
+    TypeInfo(TypeInfo&&) = default;
+    TypeInfo & operator=(TypeInfo&&) = default;
+
+    TypeInfo(const LibraryPtr &lib,
+        const size_t index,
+        const bool dual = false);
+
+    // DATA
+    TypeLib typelib() const;
+    TypeAttr attr() const;
+    Documentation documentation(const MEMBERID id) const;
+    VarDesc vardesc(const UINT index) const;
+    FuncDesc funcdesc(const UINT index) const;
+    TypeInfo info(const HREFTYPE type) const;
+    HREFTYPE reference(const UINT index) const;
+    INT flags(const UINT index) const;
+    std::vector<std::string> names(const MEMBERID id) const;
+
+    // WINAPI
+    Documentation GetDocumentation(const MEMBERID id) const;
+    std::vector<std::string> GetNames(const MEMBERID id) const;
+    TypeInfo GetRefTypeInfo(const HREFTYPE type) const;
+    HREFTYPE GetRefTypeOfImplType(const UINT index) const;
+    INT GetImplTypeFlags(const UINT index) const;
+};
+
+
+/** \brief Attributes of a type read from an MSFT image.
+ */
+class TypeAttr
+{
+protected:
+    LibraryPtr lib;
+    size_t index = 0;
+    bool dual = false;
+
+public:
+    TypeAttr() = default;
+    TypeAttr(const TypeAttr&) = default;
+    TypeAttr & operator=(const TypeAttr&) = default;
+    TypeAttr(TypeAttr&&) = default;
+    TypeAttr & operator=(TypeAttr&&) = default;
+
+    TypeAttr(const LibraryPtr &lib,
+        const size_t index,
+        const bool dual);
+
+    // DATA
+    Guid guid() const;
+    ULONG size() const;
+    TYPEKIND kind() const;
+    WORD functions() const;
+    WORD variables() const;
+    WORD interfaces() const;
+    WORD vtblSize() const;
+    WORD alignment() const;
+    WORD flags() const;
+    WORD major() const;
+    WORD minor() const;
+    TypeDesc alias() const;
+
+    // WINAPI
+    ULONG cbSizeInstance() const;
+    TYPEKIND typekind() const;
+    WORD cFuncs() const;
+    WORD cVars() const;
+    WORD cImplTypes() const;
+    WORD cbSizeVft() const;
+    WORD cbAlignment() const;
+    WORD wTypeFlags() const;
+    WORD wMajorVerNum() const;
+    WORD wMinorVerNum() const;
+    TypeDesc tdescAlias() const;
+};
+
+
+/** \brief Attributes of a type library read from an MSFT image.
+ */
+class TypeLibAttr
+{
+protected:
+    LibraryPtr lib;
+
+public:
+    TypeLibAttr() = default;
+    TypeLibAttr(const TypeLibAttr&) = default;
+    TypeLibAttr & operator=(const TypeLibAttr&) = default;
+    TypeLibAttr(TypeLibAttr&&) = default;
+    TypeLibAttr & operator=(TypeLibAttr&&) = default;
+
+    TypeLibAttr(const LibraryPtr &lib);
+
+    // DATA
+    Guid guid() const;
+    LCID lcid() const;
+    SYSKIND syskind() const;
+    WORD major() const;
+    WORD minor() const;
+    WORD flags() const;
+
+    // WINAPI
+    WORD wMajorVerNum() const;
+    WORD wMinorVerNum() const;
+    WORD wLibFlags() const;
+};
+
+
+/** \brief Variable description read from an MSFT image.
+ */
+class VarDesc
+{
+protected:
+    LibraryPtr lib;
+    size_t type = 0;
+    size_t index = 0;
+
+public:
+    VarDesc() = default;
+    VarDesc(const VarDesc&) = default;
+    VarDesc & operator=(const VarDesc&) = default;
+    VarDesc(VarDesc&&) = default;
+    VarDesc & operator=(VarDesc&&) = default;
+
+    VarDesc(const LibraryPtr &lib,
+        const size_t type,
+        const size_t index);
+
+    // DATA
+    MEMBERID id() const;
+    ElemDesc element() const;
+    const VARIANT & variant() const;
+    WORD flags() const;
+    VARKIND kind() const;
+    ULONG offset() const;
+
+    // WINAPI
+    MEMBERID memid() const;
+    ElemDesc elemdescVar() const;
+    const VARIANT & lpvarValue() const;
+    WORD wVarFlags() const;
+    VARKIND varkind() const;
+    ULONG oInst() const;
+};
+
+
+/** \brief Function description read from an MSFT image.
+ */
+class FuncDesc
+{
+protected:
+    LibraryPtr lib;
+    size_t type = 0;
+    size_t index = 0;
+
+public:
+    FuncDesc() = default;
+    FuncDesc(const FuncDesc&) = default;
+    FuncDesc & operator=(const FuncDesc&) = default;
+    FuncDesc(FuncDesc&&) = default;
+    FuncDesc & operator=(FuncDesc&&) = default;
+
+    FuncDesc(const LibraryPtr &lib,
+        const size_t type,
+        const size_t index);
+
+    // DATA
+    MEMBERID id() const;
+    FUNCKIND kind() const;
+    INVOKEKIND invocation() const;
+    CALLCONV decoration() const;
+    ElemDesc arg(const SHORT index) const;
+    SHORT args() const;
+    SHORT optional() const;
+    SHORT offset() const;
+    ElemDesc returnType() const;
+    WORD flags() const;
+
+    // WINAPI
+    MEMBERID memid() const;
+    FUNCKIND funckind() const;
+    INVOKEKIND invkind() const;
+    CALLCONV callconv() const;
+    ElemDesc lprgelemdescParam(const SHORT index) const;
+    SHORT cParams() const;
+    SHORT cParamsOpt() const;
+    SHORT oVft() const;
+    ElemDesc elemdescFunc() const;
+    WORD wFuncFlags() const;
+};
+
+
+/** \brief Type descriptor read from an MSFT image.
+ */
+class TypeDesc
+{
+protected:
+    LibraryPtr lib;
+    size_t index = 0;
+
+public:
+    TypeDesc() = default;
+    TypeDesc(const TypeDesc&) = default;
+    TypeDesc & operator=(const TypeDesc&) = default;
+    TypeDesc(TypeDesc&&) = default;
+    TypeDesc & operator=(TypeDesc&&) = default;
+
+    TypeDesc(const LibraryPtr &lib,
+        const size_t index);
+
+    // DATA
+    VARTYPE vt() const;
+    TypeDesc pointer() const;
+    ArrayDesc array() const;
+    HREFTYPE reference() const;
+
+    // WINAPI
+    TypeDesc lptdesc() const;
+    HREFTYPE hreftype() const;
+    ArrayDesc lpadesc() const;
+};
+
+
+/** \brief C-style array descriptor read from an MSFT image.
+ */
+class ArrayDesc
+{
+protected:
+    LibraryPtr lib;
+    size_t index = 0;
+
+public:
+    ArrayDesc() = default;
+    ArrayDesc(const ArrayDesc&) = default;
+    ArrayDesc & operator=(const ArrayDesc&) = default;
+    ArrayDesc(ArrayDesc&&) = default;
+    ArrayDesc & operator=(ArrayDesc&&) = default;
+
+    ArrayDesc(const LibraryPtr &lib,
+        const size_t index);
+
+    // DATA
+    TypeDesc type() const;
+    USHORT count() const;
+    SafeArrayBound bound(const USHORT index) const;
+
+    // WINAPI
+    TypeDesc tdescElem() const;
+    USHORT cDims() const;
+    SafeArrayBound rgbounds(const USHORT index) const;
+};
+
+
+/** \brief Element descriptor read from an MSFT image.
+ */
+class ElemDesc
+{
+protected:
+    LibraryPtr lib;
+    size_t index = 0;
+    USHORT paramflags = 0;
+
+public:
+    ElemDesc() = default;
+    ElemDesc(const ElemDesc&) = default;
+    ElemDesc & operator=(const ElemDesc&) = default;
+    ElemDesc(ElemDesc&&) = default;
+    ElemDesc & operator=(ElemDesc&&) = default;
+
+    ElemDesc(const LibraryPtr &lib,
+        const size_t index,
+        const USHORT paramflags = 0);
+
+    // DATA
+    TypeDesc type() const;
+    USHORT flags() const;
+
+    // WINAPI
+    TypeDesc tdesc() const;
+    USHORT wParamFlags() const;
+};
+
+}   /* msft */
+}   /* autocom */
@@ -6,9 +6,12 @@
  */
 
 #include "parse.h"
+#include "typecache.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
 
@@ -48,6 +51,44 @@ std::unordered_map<VARTYPE, std::string> TYPE_NAMES = {
     { VT_VOID,      "void"          },
 };
 
+/** \brief SAFEARRAY element types that map back to the same VARTYPE
+ *  through `SafeArray<T>`.
+ */
+std::unordered_map<VARTYPE, std::string> SAFEARRAY_ELEMENTS = {
+    { VT_I2,        "SHORT"         },
+    { VT_I4,        "LONG"          },
+    { VT_I8,        "LONGLONG"      },
+    { VT_R4,        "FLOAT"         },
+    { VT_R8,        "DOUBLE"        },
+    { VT_BSTR,      "BSTR"          },
+    { VT_VARIANT,   "VARIANT"       },
+};
+
+/** \brief Names which cannot be used for generated parameters.
+ *
+ *  Includes C++ keywords, macros from the Windows headers, and the
+ *  locals declared by generated wrappers.
+ */
+std::unordered_set<Name> RESERVED_NAMES = {
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand",
+    "bitor", "bool", "break", "case", "catch", "char", "char16_t",
+    "char32_t", "class", "compl", "const", "const_cast", "constexpr",
+    "continue", "decltype", "default", "delete", "do", "double",
+    "dynamic_cast", "else", "enum", "explicit", "export", "extern",
+    "false", "float", "for", "friend", "goto", "if", "inline", "int",
+    "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+    "nullptr", "operator", "or", "or_eq", "private", "protected",
+    "public", "register", "reinterpret_cast", "return", "short",
+    "signed", "sizeof", "static", "static_assert", "static_cast",
+    "struct", "switch", "template", "this", "thread_local", "throw",
+    "true", "try", "typedef", "typeid", "typename", "union", "unsigned",
+    "using", "virtual", "void", "volatile", "wchar_t", "while", "xor",
+    "xor_eq",
+    "interface", "far", "near", "small", "hyper", "IN", "OUT",
+    "OPTIONAL", "CONST",
+    "hr_", "retval_",
+};
+
 std::unordered_map<CALLCONV, std::string, EnumHash> DECORATIONS = {
     { CC_FASTCALL,   "__fastcall" },
     { CC_CDECL,      "__cdecl"    },
@@ -91,6 +132,11 @@ std::unordered_map<Type, IgnoredMethods> IGNORED = {
 };
 
 
+// OPTIONS
+// -------
+
+bool CONSTEXPR_GUIDS = false;
+
 // SORTING
 // -------
 
@@ -108,11 +154,24 @@ bool functionKey(const Function &left,
 // ---------
 
 
+/** \brief Write GUID definition for header, in the selected style.
+ */
+std::string defineGuid(const Guid &guid,
+    const std::string &prefix,
+    const std::string &name)
+{
+    if (CONSTEXPR_GUIDS) {
+        return guid.constant(prefix, name);
+    }
+    return guid.define(prefix, name);
+}
+
+
 /** \brief Parse description from a typelib.
  */
-template <typename Description>
+template <typename Description, typename Library>
 void parseDescription(Description &description,
-    const TypeLib &tlib)
+    const Library &tlib)
 {
     auto attr = tlib.attr();
     description.guid = attr.guid();
@@ -124,9 +183,9 @@ void parseDescription(Description &description,
 
 /** \brief Parse item from TypeInfo of subelement.
  */
-template <typename Description>
+template <typename Description, typename Info>
 void parseItem(Description &desc,
-    const TypeInfo &info)
+    const Info &info)
 {
     switch (info.attr().kind()) {
         case TKIND_ENUM:
@@ -164,10 +223,40 @@ void parseItem(Description &desc,
 }
 
 
+/** \brief Move items parsed from one TypeInfo into the description.
+ *
+ *  Interfaces are resolved against the interfaces merged before them.
+ */
+void mergeItem(Description &desc,
+    Description &item)
+{
+    auto append = [](auto &list, auto &items) {
+        std::move(items.begin(), items.end(), std::back_inserter(list));
+    };
+
+    for (auto &value: item.interfaces) {
+        value.resolve(desc.bases);
+    }
+    for (auto &value: item.dispatchers) {
+        value.resolve(desc.bases);
+    }
+    append(desc.enums, item.enums);
+    append(desc.records, item.records);
+    append(desc.modules, item.modules);
+    append(desc.interfaces, item.interfaces);
+    append(desc.dispatchers, item.dispatchers);
+    append(desc.coclasses, item.coclasses);
+    append(desc.aliases, item.aliases);
+    append(desc.unions, item.unions);
+    append(desc.externals, item.externals);
+}
+
+
 /** \brief Get variable type name from VARTYPE descriptor.
  */
-Parameter getTypeName(const TypeInfo &info,
-    const TypeDesc &desc)
+template <typename Info, typename Desc>
+Parameter getTypeName(const Info &info,
+    const Desc &desc)
 {
     Parameter parameter;
     auto it = TYPE_NAMES.find(desc.vt());
@@ -189,6 +278,10 @@ Parameter getTypeName(const TypeInfo &info,
         parameter.type = info.info(desc.reference()).documentation(-1).name;
     } else if (desc.vt() == VT_SAFEARRAY) {
         parameter.type = "SAFEARRAY";
+        auto element = SAFEARRAY_ELEMENTS.find(desc.pointer().vt());
+        if (element != SAFEARRAY_ELEMENTS.end()) {
+            parameter.element = element->second;
+        }
     } else {
         // VT_VOID
         throw std::invalid_argument("Invalid type: " + std::to_string(desc.vt()));
@@ -198,6 +291,60 @@ Parameter getTypeName(const TypeInfo &info,
 }
 
 
+/** \brief Get base type name, without pointers.
+ */
+Type getBaseType(const Type &type)
+{
+    auto last = type.find_last_not_of(" *");
+    return last == std::string::npos ? "" : type.substr(0, last + 1);
+}
+
+
+/** \brief Check if a name can be used as a C++ identifier.
+ */
+bool isIdentifier(const Name &name)
+{
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name.front()))) {
+        return false;
+    }
+    for (unsigned char c: name) {
+        if (!std::isalnum(c) && c != '_') {
+            return false;
+        }
+    }
+
+    return RESERVED_NAMES.find(name) == RESERVED_NAMES.end();
+}
+
+
+/** \brief Name arguments from `GetNames`, falling back to "arg0"...
+ *
+ *  Names that are not identifiers, are repeated, or shadow the type
+ *  of another argument keep the positional name.
+ */
+void setArgumentNames(std::vector<Parameter> &args,
+    const std::vector<std::string> &names)
+{
+    std::unordered_set<Name> types;
+    for (const auto &arg: args) {
+        types.emplace(getBaseType(arg.type));
+    }
+
+    std::unordered_set<Name> used;
+    for (size_t index = 0; index < args.size(); ++index) {
+        Name name;
+        if (index + 1 < names.size()) {
+            name = names[index + 1];
+        }
+        if (!isIdentifier(name) || types.count(name) || used.count(name)) {
+            name = "arg" + std::to_string(index);
+        }
+        used.emplace(name);
+        args[index].name = name;
+    }
+}
+
+
 /** \brief Get value name from variant.
  */
 std::string getValueName(const VARIANT &variant)
@@ -275,11 +422,12 @@ std::string CppCode::header() const
 
 /** \brief Extract enum value data.
  */
-EnumValue::EnumValue(const TypeInfo &info,
+template <typename Info>
+EnumValue::EnumValue(const Info &info,
     const WORD index)
 {
     // get descriptors
-    auto vd = info.vardesc(index);
+    const auto &vd = info.vardesc(index);
     auto variant = vd.variant();
 
     name = info.documentation(vd.id()).name;
@@ -297,11 +445,12 @@ std::string EnumValue::header() const
 
 /** \brief Parse variable without assigned value.
  */
-Parameter::Parameter(const TypeInfo &info,
+template <typename Info>
+Parameter::Parameter(const Info &info,
     const WORD index)
 {
     // get descriptors
-    auto vd = info.vardesc(index);
+    const auto &vd = info.vardesc(index);
     assert(vd.kind() == VAR_PERINSTANCE);
 
     *this = getTypeName(info, vd.element().type());
@@ -352,11 +501,12 @@ std::string Parameter::anonymous() const
 
 /** \brief Parse variable with assigned value.
  */
-Variable::Variable(const TypeInfo &info,
+template <typename Info>
+Variable::Variable(const Info &info,
     const WORD index)
 {
     // get descriptors
-    auto vd = info.vardesc(index);
+    const auto &vd = info.vardesc(index);
     assert(vd.kind() == VAR_CONST);
 
     reinterpret_cast<Parameter&>(*this) = getTypeName(info, vd.element().type());
@@ -375,7 +525,8 @@ std::string Variable::header() const
 
 /** \brief Parse dispatch property definition.
  */
-Property::Property(const TypeInfo &info,
+template <typename Info>
+Property::Property(const Info &info,
     const WORD index)
 {}
 
@@ -391,14 +542,16 @@ std::string Property::header() const
 
 /** \brief Parse function definition.
  */
-Function::Function(const TypeInfo &info,
+template <typename Info>
+Function::Function(const Info &info,
     const WORD index)
 {
     // get descriptors
-    auto fd = info.funcdesc(index);
-    auto documentation = info.documentation(fd.id());
+    const auto &fd = info.funcdesc(index);
+    const auto &documentation = info.documentation(fd.id());
 
-    decorator = DECORATIONS[fd.decoration()];
+    auto it = DECORATIONS.find(fd.decoration());
+    decorator = it == DECORATIONS.end() ? "" : it->second;
     returns = getTypeName(info, fd.returnType().type());
     name = documentation.name;
     doc = documentation.doc;
@@ -406,9 +559,11 @@ Function::Function(const TypeInfo &info,
     offset = fd.offset();
     args.resize(fd.args());
     for (SHORT index = 0; index < fd.args(); ++index) {
-        args[index] = getTypeName(info, fd.arg(index).type());
-        args[index].name = "arg" + std::to_string(index);
+        const auto &arg = fd.arg(index);
+        args[index] = getTypeName(info, arg.type());
+        args[index].flags = arg.flags();
     }
+    setArgumentNames(args, info.names(fd.id()));
 }
 
 
@@ -430,6 +585,89 @@ std::string Function::definition() const
 }
 
 
+/** \brief Get type the wrapper stores the output parameter in.
+ *
+ *  The wrapper is emitted for functions returning an HRESULT whose
+ *  last parameter is `[retval]`, or the only `[out]` parameter, so
+ *  the output is that parameter's pointee. Otherwise, returns an
+ *  empty type.
+ */
+Type Function::output() const
+{
+    if (returns.type != "HRESULT" || args.empty()) {
+        return "";
+    }
+
+    const auto &out = args.back();
+    auto isOutput = [](const Parameter &arg) {
+        return (arg.flags & PARAMFLAG_FOUT) && !(arg.flags & PARAMFLAG_FIN);
+    };
+    auto outputs = std::count_if(args.begin(), args.end(), isOutput);
+    bool retval = out.flags & PARAMFLAG_FRETVAL;
+    if (!(retval || (isOutput(out) && outputs == 1))) {
+        return "";
+    } else if (out.type.empty() || out.type.back() != '*' || !out.array.empty()) {
+        return "";
+    }
+
+    auto storage = out.type.substr(0, out.type.size() - 1);
+    storage.erase(storage.find_last_not_of(' ') + 1);
+
+    return storage;
+}
+
+
+/** \brief Get inline wrapper returning the output parameter.
+ *
+ *  The wrapper drops the output parameter, makes a single call to
+ *  the virtual function, and returns the value with the HRESULT.
+ *  BSTR, VARIANT and typed SAFEARRAY values are moved into their
+ *  owning wrappers. Returns an empty string without an output.
+ */
+std::string Function::wrapper() const
+{
+    auto storage = output();
+    if (storage.empty()) {
+        return "";
+    }
+
+    // get the type returned
+    const auto &out = args.back();
+    auto value = storage;
+    auto result = std::string("retval_");
+    if (storage == "BSTR") {
+        value = "autocom::Bstr";
+        result = "autocom::Bstr(std::move(retval_))";
+    } else if (storage == "VARIANT") {
+        storage = value = "autocom::Variant";
+        result = "std::move(retval_)";
+    } else if (storage == "SAFEARRAY*" && !out.element.empty()) {
+        value = "autocom::SafeArray<" + out.element + ">";
+        result = value + "(std::move(retval_))";
+    }
+    auto type = "autocom::Result<" + value + ">";
+
+    // indented for the body of the interface
+    std::ostringstream stream;
+    stream << "    inline " << type << " " << name << "(";
+    for (size_t index = 0; index + 1 < args.size(); ++index) {
+        stream << (index ? ", " : "") << args[index].header();
+    }
+    stream << ")\r\n"
+           << "    {\r\n"
+           << "        " << storage << " retval_ {};\r\n"
+           << "        HRESULT hr_ = " << name << "(";
+    for (size_t index = 0; index + 1 < args.size(); ++index) {
+        stream << args[index].name << ", ";
+    }
+    stream << "&retval_);\r\n"
+           << "        return " << type << "(hr_, " << result << ");\r\n"
+           << "    }\r\n";
+
+    return stream.str();
+}
+
+
 /** \brief Get representation in header.
  */
 std::string Function::header() const
@@ -444,7 +682,8 @@ std::string Function::header() const
 
 /** \brief Initialize Enum method description from TypeInfo.
  */
-Enum::Enum(const TypeInfo &info,
+template <typename Info>
+Enum::Enum(const Info &info,
     Description & /*description*/)
 {
     name = info.documentation(-1).name;
@@ -472,14 +711,16 @@ std::string Enum::header() const
 
 /** \brief Initialize Record method description from TypeInfo.
  */
-Record::Record(const TypeInfo &info,
+template <typename Info>
+Record::Record(const Info &info,
     Description & /*description*/)
 {
-    auto attr = info.attr();
+    const auto &attr = info.attr();
     name = info.documentation(-1).name;
     size = attr.size();
     for (WORD index = 0; index < attr.variables(); ++index) {
         fields.emplace_back(Parameter(info, index));
+        offsets.emplace_back(info.vardesc(index).offset());
     }
 }
 
@@ -506,6 +747,59 @@ std::string Record::header() const
     stream << "static_assert(sizeof(" << name
            << ") == " << size
            << ", \"AutoCOM: Invalid struct size.\");\r\n";
+    if (offsets.size() == fields.size()) {
+        for (size_t i = 0; i < fields.size(); ++i) {
+            stream << "static_assert(offsetof(" << name
+                   << ", " << fields[i].name
+                   << ") == " << offsets[i]
+                   << ", \"AutoCOM: Invalid field offset.\");\r\n";
+        }
+    }
+    stream << columns();
+
+    return stream.str();
+}
+
+
+/** \brief Write struct-of-arrays columns and transpose helpers.
+ */
+std::string Record::columns() const
+{
+    if (fields.empty()) {
+        return "";
+    }
+
+    std::ostringstream stream;
+    stream << "\r\n"
+           << "struct " << name << "Columns\r\n"
+           << "{\r\n";
+    for (const auto &field: fields) {
+        stream << "    autocom::Column<decltype(" << name << "::"
+               << field.name << ")> " << field.name << ";\r\n";
+    }
+    stream << "};\r\n";
+
+    std::ostringstream list;
+    stream << "constexpr size_t " << name << "Offsets[] = {";
+    for (size_t i = 0; i < fields.size(); ++i) {
+        const char *separator = i ? ", " : "";
+        stream << separator << "offsetof(" << name << ", " << fields[i].name << ")";
+        list << ", columns." << fields[i].name;
+    }
+    stream << "};\r\n\r\n";
+
+    stream << "inline void toColumns(const " << name << " *records, size_t count, "
+           << name << "Columns &columns)\r\n"
+           << "{\r\n"
+           << "    autocom::gatherColumns(records, count, " << name << "Offsets"
+           << list.str() << ");\r\n"
+           << "}\r\n\r\n"
+           << "inline void fromColumns(const " << name << "Columns &columns, "
+           << name << " *records)\r\n"
+           << "{\r\n"
+           << "    autocom::scatterColumns(records, " << name << "Offsets"
+           << list.str() << ");\r\n"
+           << "}\r\n";
 
     return stream.str();
 }
@@ -516,10 +810,11 @@ std::string Record::header() const
  *  \warning This code should be assumed to be buggy, since no COM
  *  DLLs installed on Wine use TKIND_MODULE.
  */
-Module::Module(const TypeInfo &info,
+template <typename Info>
+Module::Module(const Info &info,
     Description & /*description*/)
 {
-    auto attr = info.attr();
+    const auto &attr = info.attr();
 
     // functions
     for (WORD index = 0; index < attr.functions(); ++index) {
@@ -552,20 +847,36 @@ std::string Module::header() const
 
 /** \brief Initialize Interface method description from TypeInfo.
  */
-Interface::Interface(const TypeInfo &info,
-    Description &description)
+template <typename Info>
+Interface::Interface(const Info &info,
+    Description & /*description*/)
 {
-    auto attr = info.attr();
-    auto &bases = description.bases;
+    const auto &attr = info.attr();
 
     // parse interface attributes
     name = info.documentation(-1).name;
     iid = attr.guid();
     flags = attr.flags();
 
-    // parse base classes
+    // parse base classes, resolved once preceding interfaces are known
     if (attr.interfaces()) {
         base = info.info(info.reference(0)).documentation(-1).name;
+    }
+
+    for (WORD index = 0; index < attr.functions(); ++index) {
+        functions.emplace_back(Function(info, index));
+    }
+}
+
+
+/** \brief Resolve Windows base interface and remove its methods.
+ *
+ *  Must be called in declaration order, since the object of an
+ *  interface is found from the object of its base.
+ */
+void Interface::resolve(InterfaceMap &bases)
+{
+    if (!base.empty()) {
         object = base;
         while (IGNORED.find(object) == IGNORED.end()) {
             object = bases.at(object);
@@ -573,12 +884,11 @@ Interface::Interface(const TypeInfo &info,
         bases[name] = object;
     }
 
-    for (WORD index = 0; index < attr.functions(); ++index) {
-        Function function(info, index);
-        if (ignored().find(function.name) == ignored().end())  {
-            functions.emplace_back(std::move(function));
-        }
-    }
+    const auto &methods = ignored();
+    auto ignore = [&methods](const Function &function) {
+        return methods.find(function.name) != methods.end();
+    };
+    functions.erase(std::remove_if(functions.begin(), functions.end(), ignore), functions.end());
     std::sort(functions.begin(), functions.end(), functionKey);
 }
 
@@ -605,7 +915,7 @@ std::string Interface::header() const
 {
     std::ostringstream stream;
 
-    stream << iid.define("IID", name) << "\r\n\r\n";
+    stream << defineGuid(iid, "IID", name) << "\r\n\r\n";
     stream << "struct " << name;
     if (!base.empty()) {
         stream << ": " << base;
@@ -623,6 +933,10 @@ std::string Interface::header() const
     for (const auto &item: functions) {
         stream << "    " << item.header() << "\r\n";
     }
+    // wrappers
+    for (const auto &item: functions) {
+        stream << item.wrapper();
+    }
 
     stream << "};\r\n";
 
@@ -664,11 +978,12 @@ std::string Interface::signatures() const
 
 /** \brief Initialize Dispatch method description from TypeInfo.
  */
-Dispatch::Dispatch(const TypeInfo &info,
+template <typename Info>
+Dispatch::Dispatch(const Info &info,
         Description &description):
     Interface(info, description)
 {
-    auto attr = info.attr();
+    const auto &attr = info.attr();
     for (WORD index = 0; index < attr.variables(); ++index) {
         assert(false);
         //properties.emplace_back(Property(info, index));
@@ -678,11 +993,12 @@ Dispatch::Dispatch(const TypeInfo &info,
 
 /** \brief Initialize CoClass method description from TypeInfo.
  */
-CoClass::CoClass(const TypeInfo &info,
+template <typename Info>
+CoClass::CoClass(const Info &info,
     Description &description)
 {
     // parse interface attributes
-    auto attr = info.attr();
+    const auto &attr = info.attr();
     name = info.documentation(-1).name;
     clsid = attr.guid();
     flags = attr.flags();
@@ -717,7 +1033,7 @@ std::string CoClass::header() const
     assert(interfaces.size());
 
     std::ostringstream stream;
-    stream << clsid.define("CLSID", name) << "\r\n\r\n";
+    stream << defineGuid(clsid, "CLSID", name) << "\r\n\r\n";
     stream << "struct " << name << ": ";
 
     for (auto it = interfaces.begin(); it < interfaces.end() - 1; ++it) {
@@ -737,7 +1053,8 @@ std::string CoClass::header() const
 
 /** \brief Initialize Alias method description from TypeInfo.
  */
-Alias::Alias(const TypeInfo &info,
+template <typename Info>
+Alias::Alias(const Info &info,
     Description &description)
 {
     parameter = getTypeName(info, info.attr().alias());
@@ -755,13 +1072,14 @@ std::string Alias::header() const
 
 /** \brief Initialize Union method description from TypeInfo.
  */
-Union::Union(const TypeInfo &info,
+template <typename Info>
+Union::Union(const Info &info,
     Description & /*description*/)
 {
     name = info.documentation(-1).name;
 
     // parse interface attributes
-    auto attr = info.attr();
+    const auto &attr = info.attr();
     for (WORD index = 0; index < attr.variables(); ++index) {
         fields.emplace_back(Parameter(info, index));
     }
@@ -807,26 +1125,95 @@ std::string External::header() const
 // ------
 
 
-/** \brief Parse TypeLib from COM object.
+/** \brief COM context held while a pool task reads a type library.
+ *
+ *  Native libraries are read without COM.
+ */
+template <typename Library>
+struct ChunkContext
+{};
+
+
+/** \brief Initialize COM for the duration of a task reading a TypeLib.
+ *
+ *  Pool workers never initialize COM themselves, so each task joins
+ *  the thread's apartment, or the multithreaded apartment, and leaves
+ *  it when done. Type libraries loaded by oleaut32 are free-threaded.
+ */
+template <>
+struct ChunkContext<TypeLib>
+{
+    ChunkContext()
+    {
+        initialize();
+    }
+
+    ~ChunkContext()
+    {
+        uninitialize();
+    }
+};
+
+
+/** \brief Parse all items from a TypeLib or native type library.
+ *
+ *  Each TypeInfo is extracted independently on the thread pool, with
+ *  a memoizing cache per chunk of types, and the items are then
+ *  merged serially in declaration order, so the description matches
+ *  a serial parse. Native libraries are immutable once read.
  */
-void TypeLibDescription::parse(const TypeLib &tlib)
+template <typename Library>
+void parseLibrary(TypeLibDescription &library,
+    const Library &tlib,
+    parallel::ThreadPool &pool)
 {
+    typedef typename std::decay<decltype(tlib.info(0))>::type Info;
+
     // get library definitions
-    detail::parseDescription(*this, tlib);
-    for (UINT index = 0; index < tlib.count(); ++index) {
-        auto info = tlib.info(index);
-        auto name = info.documentation(-1).name;
-
-        // get items
-        auto lib = info.typelib();
-        if (lib != tlib) {
-            // never seen an external symbol before
-            assert(false);
-        } else {
-            detail::parseItem(description, info);
+    detail::parseDescription(library, tlib);
+
+    // extract items
+    const size_t count = tlib.count();
+    const size_t chunks = std::min(count, 4 * pool.size());
+    std::vector<detail::Description> items(count);
+    pool.run(chunks, [&](const size_t chunk) {
+        ChunkContext<Library> context;
+        TypeInfoCache<Info> cache;
+        for (size_t index = chunk * count / chunks; index < (chunk + 1) * count / chunks; ++index) {
+            auto info = cache.add(tlib.info(UINT(index)));
+            auto lib = info.typelib();
+            if (lib != tlib) {
+                // never seen an external symbol before
+                assert(false);
+            } else {
+                detail::parseItem(items[index], info);
+            }
         }
+    });
+
+    // resolve base interfaces
+    for (auto &item: items) {
+        detail::mergeItem(library.description, item);
     }
 }
 
 
+/** \brief Parse TypeLib from COM object.
+ */
+void TypeLibDescription::parse(const TypeLib &tlib,
+    parallel::ThreadPool &pool)
+{
+    parseLibrary(*this, tlib, pool);
+}
+
+
+/** \brief Parse TypeLib read directly from a `.tlb` file or PE image.
+ */
+void TypeLibDescription::parse(const msft::TypeLib &tlib,
+    parallel::ThreadPool &pool)
+{
+    parseLibrary(*this, tlib, pool);
+}
+
+
 }   /* autocom */
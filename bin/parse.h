@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "msft.h"
+
 #include <autocom.h>
 
 #include <string>
@@ -59,6 +61,22 @@ typedef std::unordered_map<Name, Type> Memo;
 typedef std::unordered_map<Type, Type> InterfaceMap;
 typedef std::unordered_map<Type, Guid> GUIDMap;
 
+// OPTIONS
+// -------
+
+/** \brief Write GUIDs as constexpr constants, rather than DEFINE_GUID.
+ */
+extern bool CONSTEXPR_GUIDS;
+
+// FUNCTIONS
+// ---------
+
+/** \brief Write GUID definition for header, in the selected style.
+ */
+std::string defineGuid(const Guid &guid,
+    const std::string &prefix,
+    const std::string &name);
+
 // OBJECTS
 // -------
 
@@ -85,7 +103,8 @@ struct EnumValue: CppCode
     EnumValue(EnumValue&&) = default;
     EnumValue & operator=(EnumValue&&) = default;
 
-    EnumValue(const TypeInfo &info,
+    template <typename Info>
+    EnumValue(const Info &info,
         const WORD index);
 
     virtual std::string header() const;
@@ -93,12 +112,17 @@ struct EnumValue: CppCode
 
 
 /** \brief Description for a variable without value.
+ *
+ *  \param flags                PARAMFLAG values for function arguments.
+ *  \param element              Element type of a SAFEARRAY, if known.
  */
 struct Parameter: CppCode
 {
     Type type;
     Array array;
     Name name;
+    USHORT flags = 0;
+    Type element;
 
     Parameter() = default;
     Parameter(const Parameter&) = default;
@@ -106,7 +130,8 @@ struct Parameter: CppCode
     Parameter(Parameter&&) = default;
     Parameter & operator=(Parameter&&) = default;
 
-    Parameter(const TypeInfo &info,
+    template <typename Info>
+    Parameter(const Info &info,
         const WORD index);
     Parameter(const Type &type,
         const Array &array = "",
@@ -130,7 +155,8 @@ struct Variable: Parameter
     Variable(Variable&&) = default;
     Variable & operator=(Variable&&) = default;
 
-    Variable(const TypeInfo &info,
+    template <typename Info>
+    Variable(const Info &info,
         const WORD index);
 
     virtual std::string header() const;
@@ -148,7 +174,8 @@ struct Property: CppCode
     Property(Property&&) = default;
     Property & operator=(Property&&) = default;
 
-    Property(const TypeInfo &info,
+    template <typename Info>
+    Property(const Info &info,
         const WORD index);
 
     virtual std::string header() const;
@@ -173,10 +200,13 @@ struct Function: CppCode
     Function(Function&&) = default;
     Function & operator=(Function&&) = default;
 
-    Function(const TypeInfo &info,
+    template <typename Info>
+    Function(const Info &info,
         const WORD index);
 
     std::string definition() const;
+    Type output() const;
+    std::string wrapper() const;
     virtual std::string header() const;
 };
 
@@ -194,7 +224,8 @@ struct Enum: CppCode
     Enum(Enum&&) = default;
     Enum & operator=(Enum&&) = default;
 
-    Enum(const TypeInfo &info,
+    template <typename Info>
+    Enum(const Info &info,
         Description & /*description*/);
 
     virtual std::string header() const;
@@ -208,6 +239,7 @@ struct Record: CppCode
     Name name;
     ULONG size;
     std::vector<Parameter> fields;
+    std::vector<ULONG> offsets;
 
     Record() = default;
     Record(const Record&) = default;
@@ -215,11 +247,13 @@ struct Record: CppCode
     Record(Record&&) = default;
     Record & operator=(Record&&) = default;
 
-    Record(const TypeInfo &info,
+    template <typename Info>
+    Record(const Info &info,
         Description & /*description*/);
 
     virtual std::string forward() const;
     virtual std::string header() const;
+    std::string columns() const;
 };
 
 
@@ -236,7 +270,8 @@ struct Module: CppCode
     Module(Module&&) = default;
     Module & operator=(Module&&) = default;
 
-    Module(const TypeInfo &info,
+    template <typename Info>
+    Module(const Info &info,
         Description & /*description*/);
 
     virtual std::string header() const;
@@ -267,9 +302,11 @@ struct Interface: CppCode
     Interface(Interface&&) = default;
     Interface & operator=(Interface&&) = default;
 
-    Interface(const TypeInfo &info,
+    template <typename Info>
+    Interface(const Info &info,
         Description &description);
 
+    void resolve(InterfaceMap &bases);
     IgnoredMethods & ignored() const;
     virtual std::string forward() const;
     virtual std::string header() const;
@@ -287,7 +324,8 @@ struct Dispatch: Interface
     Dispatch(Dispatch&&) = default;
     Dispatch & operator=(Dispatch&&) = default;
 
-    Dispatch(const TypeInfo &info,
+    template <typename Info>
+    Dispatch(const Info &info,
         Description &description);
 };
 
@@ -312,7 +350,8 @@ struct CoClass: CppCode
     CoClass(CoClass&&) = default;
     CoClass & operator=(CoClass&&) = default;
 
-    CoClass(const TypeInfo &info,
+    template <typename Info>
+    CoClass(const Info &info,
         Description &description);
 
     virtual std::string forward() const;
@@ -333,7 +372,8 @@ struct Alias: CppCode
     Alias(Alias&&) = default;
     Alias & operator=(Alias&&) = default;
 
-    Alias(const TypeInfo &info,
+    template <typename Info>
+    Alias(const Info &info,
         Description & /*description*/);
 
     virtual std::string header() const;
@@ -353,7 +393,8 @@ struct Union: CppCode
     Union(Union&&) = default;
     Union & operator=(Union&&) = default;
 
-    Union(const TypeInfo &info,
+    template <typename Info>
+    Union(const Info &info,
         Description & /*description*/);
 
     virtual std::string forward() const;
@@ -405,7 +446,10 @@ struct TypeLibDescription
     Documentation documentation;
     detail::Description description;
 
-    void parse(const TypeLib &tlib);
+    void parse(const TypeLib &tlib,
+        parallel::ThreadPool &pool = parallel::ThreadPool::global());
+    void parse(const msft::TypeLib &tlib,
+        parallel::ThreadPool &pool = parallel::ThreadPool::global());
 };
 
 
@@ -0,0 +1,355 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Memoized type description lookups for the header generator.
+ *
+ *  Each FUNCDESC, VARDESC and documentation string is fetched once
+ *  per type and member, rather than once per call site, which avoids
+ *  repeated GetFuncDesc calls and BSTR transcoding while parsing a
+ *  type library. Types reached through several references share a
+ *  single entry.
+ */
+
+#pragma once
+
+#include <autocom.h>
+
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace autocom
+{
+// FORWARD
+// -------
+
+template <typename Info>
+class TypeInfoCache;
+
+// OBJECTS
+// -------
+
+
+/** \brief Handle to a type description stored in a TypeInfoCache.
+ *
+ *  Provides the subset of the TypeInfo interface used by the parser,
+ *  returning references into the cache. The handle is valid for the
+ *  lifetime of the cache.
+ */
+template <typename Info>
+class CachedTypeInfo
+{
+protected:
+    typedef TypeInfoCache<Info> Cache;
+
+    Cache *cache = nullptr;
+    size_t slot = 0;
+
+    friend Cache;
+
+public:
+    typedef typename Cache::Lib Lib;
+    typedef typename Cache::Attr Attr;
+    typedef typename Cache::Var Var;
+    typedef typename Cache::Func Func;
+
+    CachedTypeInfo() = default;
+    CachedTypeInfo(const CachedTypeInfo&) = default;
+    CachedTypeInfo & operator=(const CachedTypeInfo&) = default;
+    CachedTypeInfo(CachedTypeInfo&&) = default;
+    CachedTypeInfo & operator=(CachedTypeInfo&&) = default;
+
+    CachedTypeInfo(Cache &cache,
+        const size_t slot);
+
+    // DATA
+    const Info & get() const;
+    Lib typelib() const;
+    const Attr & attr() const;
+    const Documentation & documentation(const MEMBERID id) const;
+    const Var & vardesc(const UINT index) const;
+    const Func & funcdesc(const UINT index) const;
+    CachedTypeInfo info(const HREFTYPE type) const;
+    HREFTYPE reference(const UINT index) const;
+    INT flags(const UINT index) const;
+    std::vector<std::string> names(const MEMBERID id) const;
+};
+
+
+/** \brief Flat table of memoized type descriptions.
+ *
+ *  Types are stored in slots, either added directly or reached
+ *  through a type reference, and member documentation is keyed by
+ *  (slot, MEMBERID). A type is identified by its GUID and TYPEKIND,
+ *  since both halves of a dual interface share an IID, or by its
+ *  name and type library if the GUID is null, as for most records
+ *  and aliases. The cache is not thread-safe.
+ */
+template <typename Info>
+class TypeInfoCache
+{
+public:
+    typedef typename std::decay<decltype(std::declval<const Info&>().typelib())>::type Lib;
+    typedef typename std::decay<decltype(std::declval<const Info&>().attr())>::type Attr;
+    typedef typename std::decay<decltype(std::declval<const Info&>().vardesc(0))>::type Var;
+    typedef typename std::decay<decltype(std::declval<const Info&>().funcdesc(0))>::type Func;
+    typedef CachedTypeInfo<Info> Handle;
+
+protected:
+    /** \brief Memoized data for a single type.
+     */
+    struct Entry
+    {
+        Info info;
+        Attr attr;
+        std::vector<Var> variables;
+        std::vector<Func> functions;
+        std::vector<bool> loadedVariables;
+        std::vector<bool> loadedFunctions;
+        std::unordered_map<HREFTYPE, size_t> references;
+    };
+
+    std::deque<Entry> entries;
+    std::unordered_multimap<Guid, size_t> guids;
+    std::unordered_multimap<std::string, size_t> names;
+    std::unordered_map<uint64_t, Documentation> documentation;
+
+    friend Handle;
+
+    static uint64_t key(const size_t slot,
+        const MEMBERID id);
+    size_t insert(const Info &info);
+
+public:
+    TypeInfoCache() = default;
+    TypeInfoCache(const TypeInfoCache&) = delete;
+    TypeInfoCache & operator=(const TypeInfoCache&) = delete;
+
+    Handle add(const Info &info);
+    size_t size() const;
+};
+
+// IMPLEMENTATION
+// --------------
+
+
+/** \brief Initialize handle from cache slot.
+ */
+template <typename Info>
+CachedTypeInfo<Info>::CachedTypeInfo(Cache &cache,
+        const size_t slot):
+    cache(&cache),
+    slot(slot)
+{}
+
+
+/** \brief Get underlying type description.
+ */
+template <typename Info>
+auto CachedTypeInfo<Info>::get() const
+    -> const Info &
+{
+    return cache->entries[slot].info;
+}
+
+
+/** \brief Get containing type library.
+ */
+template <typename Info>
+auto CachedTypeInfo<Info>::typelib() const
+    -> Lib
+{
+    return get().typelib();
+}
+
+
+/** \brief Get memoized type attributes.
+ */
+template <typename Info>
+auto CachedTypeInfo<Info>::attr() const
+    -> const Attr &
+{
+    return cache->entries[slot].attr;
+}
+
+
+/** \brief Get memoized documentation for the type or a member.
+ */
+template <typename Info>
+const Documentation & CachedTypeInfo<Info>::documentation(const MEMBERID id) const
+{
+    auto key = Cache::key(slot, id);
+    auto it = cache->documentation.find(key);
+    if (it == cache->documentation.end()) {
+        it = cache->documentation.emplace(key, get().documentation(id)).first;
+    }
+
+    return it->second;
+}
+
+
+/** \brief Get memoized variable description.
+ */
+template <typename Info>
+auto CachedTypeInfo<Info>::vardesc(const UINT index) const
+    -> const Var &
+{
+    auto &entry = cache->entries[slot];
+    if (index >= entry.variables.size()) {
+        throw std::out_of_range("Variable index out of range.");
+    } else if (!entry.loadedVariables[index]) {
+        entry.variables[index] = entry.info.vardesc(index);
+        entry.loadedVariables[index] = true;
+    }
+
+    return entry.variables[index];
+}
+
+
+/** \brief Get memoized function description.
+ */
+template <typename Info>
+auto CachedTypeInfo<Info>::funcdesc(const UINT index) const
+    -> const Func &
+{
+    auto &entry = cache->entries[slot];
+    if (index >= entry.functions.size()) {
+        throw std::out_of_range("Function index out of range.");
+    } else if (!entry.loadedFunctions[index]) {
+        entry.functions[index] = entry.info.funcdesc(index);
+        entry.loadedFunctions[index] = true;
+    }
+
+    return entry.functions[index];
+}
+
+
+/** \brief Get memoized handle to referenced type.
+ */
+template <typename Info>
+auto CachedTypeInfo<Info>::info(const HREFTYPE type) const
+    -> CachedTypeInfo
+{
+    auto &references = cache->entries[slot].references;
+    auto it = references.find(type);
+    if (it == references.end()) {
+        size_t other = cache->insert(get().info(type));
+        it = cache->entries[slot].references.emplace(type, other).first;
+    }
+
+    return CachedTypeInfo(*cache, it->second);
+}
+
+
+/** \brief Get reference to implemented interface.
+ */
+template <typename Info>
+HREFTYPE CachedTypeInfo<Info>::reference(const UINT index) const
+{
+    return get().reference(index);
+}
+
+
+/** \brief Get flags of implemented interface.
+ */
+template <typename Info>
+INT CachedTypeInfo<Info>::flags(const UINT index) const
+{
+    return get().flags(index);
+}
+
+
+/** \brief Get member and parameter names, which are read once per
+ *  function and so are not memoized.
+ */
+template <typename Info>
+std::vector<std::string> CachedTypeInfo<Info>::names(const MEMBERID id) const
+{
+    return get().names(id);
+}
+
+
+/** \brief Combine slot and member ID into a documentation key.
+ */
+template <typename Info>
+uint64_t TypeInfoCache<Info>::key(const size_t slot,
+    const MEMBERID id)
+{
+    return (uint64_t(slot) << 32) | uint32_t(id);
+}
+
+
+/** \brief Find or store type description, fetching its attributes.
+ */
+template <typename Info>
+size_t TypeInfoCache<Info>::insert(const Info &info)
+{
+    Entry entry;
+    entry.info = info;
+    entry.attr = info.attr();
+
+    // find existing entry for the type
+    Guid guid = entry.attr.guid();
+    bool anonymous = guid == Guid(GUID_NULL);
+    Documentation name;
+    if (!anonymous) {
+        auto range = guids.equal_range(guid);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (entries[it->second].attr.kind() == entry.attr.kind()) {
+                return it->second;
+            }
+        }
+    } else {
+        name = info.documentation(MEMBERID_NIL);
+        auto range = names.equal_range(name.name);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (entries[it->second].info.typelib() == info.typelib()) {
+                return it->second;
+            }
+        }
+    }
+
+    entry.variables.resize(entry.attr.variables());
+    entry.functions.resize(entry.attr.functions());
+    entry.loadedVariables.resize(entry.variables.size());
+    entry.loadedFunctions.resize(entry.functions.size());
+    entries.emplace_back(std::move(entry));
+
+    size_t slot = entries.size() - 1;
+    if (!anonymous) {
+        guids.emplace(guid, slot);
+    } else {
+        names.emplace(name.name, slot);
+        documentation.emplace(key(slot, MEMBERID_NIL), std::move(name));
+    }
+
+    return slot;
+}
+
+
+/** \brief Add type description to cache, or get its existing entry.
+ */
+template <typename Info>
+auto TypeInfoCache<Info>::add(const Info &info)
+    -> Handle
+{
+    return Handle(*this, insert(info));
+}
+
+
+/** \brief Get number of cached types.
+ */
+template <typename Info>
+size_t TypeInfoCache<Info>::size() const
+{
+    return entries.size();
+}
+
+}   /* autocom */
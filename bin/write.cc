@@ -7,8 +7,11 @@
 
 #include "write.h"
 
+#include <algorithm>
 #include <fstream>
 #include <ostream>
+#include <sstream>
+#include <stdexcept>
 
 
 namespace autocom
@@ -17,6 +20,39 @@ namespace autocom
 // ---------
 
 
+/** \brief Write contents to file, unless the file already holds them.
+ *
+ *  Leaving identical files untouched preserves their modification
+ *  time, so regenerating headers does not trigger downstream rebuilds.
+ */
+bool writeIfChanged(const std::string &path,
+    const std::string &contents)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (input) {
+        input.seekg(0, std::ios::end);
+        auto size = input.tellg();
+        if (size >= 0 && size_t(size) == contents.size()) {
+            input.seekg(0, std::ios::beg);
+            std::string existing(contents.size(), '\0');
+            input.read(&existing[0], existing.size());
+            if (input && existing == contents) {
+                return false;
+            }
+        }
+        input.close();
+    }
+
+    std::ofstream output(path, std::ios::binary);
+    output.write(contents.data(), contents.size());
+    if (!output) {
+        throw std::runtime_error("Unable to write file: " + path);
+    }
+
+    return true;
+}
+
+
 /** \brief Write documentation string for library to file.
  */
 void writeDocString(std::ostream &stream)
@@ -114,17 +150,22 @@ void writeMethodSignatures(std::ostream &stream,
 /** \brief Write human-friendly import library.
  */
 std::string writeImportHeader(TypeLibDescription &tlib,
-    std::string &directory)
+    std::string &directory,
+    Files &files)
 {
     // get path
     auto name = tlib.documentation.name + ".hpp";
-    std::string path = directory + "\\" + name;
-    std::ofstream stream(path, std::ios::binary);
+    std::string path = directory + "/" + name;
+    std::ostringstream stream;
 
     // write import
     writeDocString(stream);
     writeImportStatement(stream, tlib);
 
+    if (writeIfChanged(path, stream.str())) {
+        files.changed.emplace_back(path);
+    }
+
     return path;
 }
 
@@ -133,20 +174,22 @@ std::string writeImportHeader(TypeLibDescription &tlib,
  */
 std::string writeClsidHeader(TypeLibDescription &tlib,
     std::string &ns,
-    std::string &directory)
+    std::string &directory,
+    Files &files)
 {
     auto name = tlib.guid.uuid() + ".hpp";
-    std::string path = directory + "\\" + name;
-    std::ofstream stream(path, std::ios::binary);
+    std::string path = directory + "/" + name;
+    std::ostringstream stream;
 
     // write data
     writeDocString(stream);
-    stream << "#include <autocom.h>\r\n\r\n";
+    stream << "#include <autocom.h>\r\n"
+           << "#include <cstddef>\r\n\r\n";
     if (!ns.empty()) {
         stream << "namespace " << ns << "\r\n"
                << "{\r\n\r\n";
     }
-    stream << tlib.guid.define("CLSID", tlib.documentation.name) << "\r\n\r\n";
+    stream << detail::defineGuid(tlib.guid, "CLSID", tlib.documentation.name) << "\r\n\r\n";
 
     // SIMPLE
     writeSection(stream, tlib.description.enums, "ENUMS");
@@ -166,6 +209,10 @@ std::string writeClsidHeader(TypeLibDescription &tlib,
         stream << "}   /* " << ns << " */\r\n";
     }
 
+    if (writeIfChanged(path, stream.str())) {
+        files.changed.emplace_back(path);
+    }
+
     return path;
 }
 
@@ -177,8 +224,274 @@ void writeHeaders(TypeLibDescription &tlib,
     std::string &directory,
     Files &files)
 {
-    files.headers.emplace_back(writeImportHeader(tlib, directory));
-    files.headers.emplace_back(writeClsidHeader(tlib, ns, directory));
+    files.headers.emplace_back(writeImportHeader(tlib, directory, files));
+    files.headers.emplace_back(writeClsidHeader(tlib, ns, directory, files));
+}
+
+
+/** \brief Get name of shard header for a type.
+ */
+std::string shardName(TypeLibDescription &tlib,
+    const std::string &name)
+{
+    return tlib.guid.uuid() + "_" + name + ".hpp";
+}
+
+
+/** \brief Write header contents, and record the file.
+ */
+void writeShardFile(const std::string &path,
+    const std::string &contents,
+    Files &files)
+{
+    if (writeIfChanged(path, contents)) {
+        files.changed.emplace_back(path);
+    }
+    files.headers.emplace_back(path);
+}
+
+
+/** \brief Open optional namespace.
+ */
+void writeNamespaceOpen(std::ostream &stream,
+    const std::string &ns)
+{
+    if (!ns.empty()) {
+        stream << "namespace " << ns << "\r\n"
+               << "{\r\n\r\n";
+    }
+}
+
+
+/** \brief Close optional namespace.
+ */
+void writeNamespaceClose(std::ostream &stream,
+    const std::string &ns)
+{
+    if (!ns.empty()) {
+        stream << "}   /* " << ns << " */\r\n";
+    }
+}
+
+
+/** \brief Types without methods have no signatures.
+ */
+void writeShardSignatures(std::ostream & /*stream*/,
+    const detail::CppCode & /*item*/)
+{}
+
+
+/** \brief Write typedefs for interface function signatures.
+ */
+void writeShardSignatures(std::ostream &stream,
+    const detail::Interface &item)
+{
+    stream << "namespace signatures\r\n"
+           << "{\r\n"
+           << item.signatures()
+           << "}   /* signatures */\r\n\r\n";
+}
+
+
+/** \brief Write one header per type in container.
+ */
+template <typename Container>
+void writeShards(TypeLibDescription &tlib,
+    const Container &container,
+    const ShardGraph &graph,
+    std::string &ns,
+    std::string &directory,
+    Files &files)
+{
+    for (const auto &item: container) {
+        std::ostringstream stream;
+        writeDocString(stream);
+        stream << "#pragma once\r\n\r\n"
+               << "#include \"" << shardName(tlib, "forward") << "\"\r\n";
+        auto it = graph.find(item.name);
+        if (it != graph.end()) {
+            for (const auto &dependency: it->second) {
+                stream << "#include \"" << shardName(tlib, dependency) << "\"\r\n";
+            }
+        }
+        stream << "\r\n";
+
+        writeNamespaceOpen(stream, ns);
+        stream << item.header() << "\r\n";
+        writeShardSignatures(stream, item);
+        writeNamespaceClose(stream, ns);
+
+        writeShardFile(directory + "/" + shardName(tlib, item.name), stream.str(), files);
+    }
+}
+
+
+/** \brief Write shared enums and forward declarations.
+ */
+void writeForwardHeader(TypeLibDescription &tlib,
+    std::string &ns,
+    std::string &directory,
+    Files &files)
+{
+    std::ostringstream stream;
+    writeDocString(stream);
+    stream << "#pragma once\r\n\r\n"
+           << "#include <autocom.h>\r\n"
+           << "#include <cstddef>\r\n\r\n";
+
+    writeNamespaceOpen(stream, ns);
+    stream << detail::defineGuid(tlib.guid, "CLSID", tlib.documentation.name) << "\r\n\r\n";
+    writeSection(stream, tlib.description.enums, "ENUMS");
+    writeForwardDeclarations(stream, tlib);
+    writeNamespaceClose(stream, ns);
+
+    writeShardFile(directory + "/" + shardName(tlib, "forward"), stream.str(), files);
+}
+
+
+/** \brief Write umbrella header including every shard.
+ *
+ *  The umbrella has a stable include order, and is suitable as a
+ *  precompiled header.
+ */
+void writeUmbrellaHeader(TypeLibDescription &tlib,
+    std::string &directory,
+    Files &files)
+{
+    std::ostringstream stream;
+    writeDocString(stream);
+    stream << "#pragma once\r\n\r\n"
+           << "#include \"" << shardName(tlib, "forward") << "\"\r\n";
+
+    auto include = [&](const auto &container) {
+        for (const auto &item: container) {
+            stream << "#include \"" << shardName(tlib, item.name) << "\"\r\n";
+        }
+    };
+    include(tlib.description.unions);
+    include(tlib.description.records);
+    include(tlib.description.interfaces);
+    include(tlib.description.dispatchers);
+    include(tlib.description.coclasses);
+
+    writeShardFile(directory + "/" + tlib.guid.uuid() + ".hpp", stream.str(), files);
+}
+
+
+/** \brief Get shards each type must include to be complete.
+ *
+ *  A type depends on the types it uses by value, after resolving
+ *  aliases: fields of records and unions, bases of interfaces and
+ *  coclasses, return and argument types of interface methods, and
+ *  outputs returned by their inline wrappers. Types used through
+ *  pointers only need the forward declarations.
+ */
+ShardGraph shardDependencies(const TypeLibDescription &tlib)
+{
+    const auto &description = tlib.description;
+    std::unordered_map<detail::Name, detail::Type> aliases;
+    for (const auto &item: description.aliases) {
+        if (item.parameter.type != item.name) {
+            aliases.emplace(item.name, item.parameter.type);
+        }
+    }
+
+    std::unordered_set<detail::Name> shards;
+    auto add = [&](const auto &container) {
+        for (const auto &item: container) {
+            shards.emplace(item.name);
+        }
+    };
+    add(description.unions);
+    add(description.records);
+    add(description.interfaces);
+    add(description.dispatchers);
+    add(description.coclasses);
+
+    // resolve a type to the shard it requires, or an empty name
+    auto resolve = [&](detail::Type type) {
+        for (size_t depth = 0; depth <= aliases.size(); ++depth) {
+            if (type.empty() || type.back() == '*') {
+                return detail::Type();
+            }
+            auto it = aliases.find(type);
+            if (it == aliases.end()) {
+                break;
+            }
+            type = it->second;
+        }
+        return shards.count(type) ? type : detail::Type();
+    };
+
+    ShardGraph graph;
+    auto link = [&](const detail::Name &name, const detail::Type &type) {
+        auto dependency = resolve(type);
+        auto &list = graph[name];
+        if (!dependency.empty() && dependency != name) {
+            if (std::find(list.begin(), list.end(), dependency) == list.end()) {
+                list.emplace_back(dependency);
+            }
+        }
+    };
+    auto fields = [&](const auto &container) {
+        for (const auto &item: container) {
+            link(item.name, "");
+            for (const auto &field: item.fields) {
+                link(item.name, field.type);
+            }
+        }
+    };
+    auto methods = [&](const auto &container) {
+        for (const auto &item: container) {
+            link(item.name, item.base);
+            for (const auto &function: item.functions) {
+                link(item.name, function.returns.type);
+                for (const auto &arg: function.args) {
+                    link(item.name, arg.type);
+                }
+                // the inline wrapper stores the output by value
+                link(item.name, function.output());
+            }
+        }
+    };
+
+    fields(description.unions);
+    fields(description.records);
+    methods(description.interfaces);
+    methods(description.dispatchers);
+    for (const auto &item: description.coclasses) {
+        link(item.name, "");
+        for (const auto &type: item.interfaces) {
+            link(item.name, type);
+        }
+    }
+
+    return graph;
+}
+
+
+/** \brief Write one C++ header per type from TypeLib description.
+ *
+ *  Writes a shared header with enums and forward declarations, one
+ *  header per union, struct, interface and coclass including only
+ *  the headers it depends on, and an umbrella header in place of
+ *  the monolithic CLSID header.
+ */
+void writeShardedHeaders(TypeLibDescription &tlib,
+    std::string &ns,
+    std::string &directory,
+    Files &files)
+{
+    auto graph = shardDependencies(tlib);
+
+    files.headers.emplace_back(writeImportHeader(tlib, directory, files));
+    writeForwardHeader(tlib, ns, directory, files);
+    writeShards(tlib, tlib.description.unions, graph, ns, directory, files);
+    writeShards(tlib, tlib.description.records, graph, ns, directory, files);
+    writeShards(tlib, tlib.description.interfaces, graph, ns, directory, files);
+    writeShards(tlib, tlib.description.dispatchers, graph, ns, directory, files);
+    writeShards(tlib, tlib.description.coclasses, graph, ns, directory, files);
+    writeUmbrellaHeader(tlib, directory, files);
 }
 
 
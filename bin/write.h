@@ -10,26 +10,46 @@
 #include "parse.h"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 
 namespace autocom
 {
+// TYPES
+// -----
+
+/** \brief Shards each type header must include, in declaration order.
+ */
+typedef std::unordered_map<detail::Name, std::vector<detail::Name>> ShardGraph;
+
 // OBJECTS
 // -------
 
 
 /** \brief Documents written to file.
+ *
+ *  \param headers              All generated headers.
+ *  \param changed              Headers whose contents were updated.
  */
 struct Files
 {
     std::vector<std::string> headers;
+    std::vector<std::string> changed;
 };
 
 // FUNCTIONS
 // ---------
 
 
+/** \brief Write contents to file if they differ from the file on disk.
+ *
+ *  \return                     If the file was written.
+ */
+bool writeIfChanged(const std::string &path,
+    const std::string &contents);
+
+
 /** \brief Write C++ header file from file description.
  */
 void writeHeaders(TypeLibDescription &tlib,
@@ -37,4 +57,17 @@ void writeHeaders(TypeLibDescription &tlib,
     std::string &directory,
     Files &files);
 
+
+/** \brief Get dependencies between per-type headers.
+ */
+ShardGraph shardDependencies(const TypeLibDescription &tlib);
+
+
+/** \brief Write one C++ header per type from file description.
+ */
+void writeShardedHeaders(TypeLibDescription &tlib,
+    std::string &ns,
+    std::string &directory,
+    Files &files);
+
 }   /* autocom */
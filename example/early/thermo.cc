@@ -51,6 +51,13 @@ int main(int argc, char *argv[])
                   << ")\n";
     }
 
+    // project monoisotopic m/z values without copying the records
+    com::SafeArrayView<MS_PrecursorInfo> view(array);
+    auto mz = view.column(&MS_PrecursorInfo::dMonoIsoMZ);
+    for (auto it = mz.begin(); it < mz.begin() + size; ++it) {
+        std::cout << "dMonoIsoMZ=" << *it << "\n";
+    }
+
     raw->Close();
 
     return 0;
@@ -13,6 +13,7 @@
  */
 
 #include <autocom.h>
+#include <cstddef>
 #include <iostream>
 
 namespace com = autocom;
@@ -27,6 +28,9 @@ struct MS_PrecursorInfo
     long nScanNumber;
 };
 
+static_assert(sizeof(MS_PrecursorInfo) == 24, "Invalid struct size.");
+static_assert(offsetof(MS_PrecursorInfo, nChargeState) == 16, "Invalid field offset.");
+
 
 
 /** \brief Execute main code block.
@@ -55,6 +59,13 @@ int main(int argc, char *argv[])
                   << ")\n";
     }
 
+    // project monoisotopic m/z values without copying the records
+    com::SafeArrayView<MS_PrecursorInfo> view(array);
+    auto mz = view.column(&MS_PrecursorInfo::dMonoIsoMZ);
+    for (auto it = mz.begin(); it < mz.begin() + size; ++it) {
+        std::cout << "dMonoIsoMZ=" << *it << "\n";
+    }
+
     dispatch.method(L"Close");
 
     return 0;
@@ -5,13 +5,30 @@
  *  \brief Public AutoCOM header.
  */
 
+#include <autocom/accounting.h>
+#include <autocom/apartment.h>
+#include <autocom/arrow.h>
 #include <autocom/bstr.h>
+#include <autocom/columns.h>
 #include <autocom/com.h>
+#include <autocom/convert.h>
 #include <autocom/dispatch.h>
 #include <autocom/dispparams.h>
 #include <autocom/enum.h>
+#include <autocom/events.h>
 #include <autocom/guid.h>
+#include <autocom/mapped.h>
+#include <autocom/parallel.h>
+#include <autocom/pool.h>
+#include <autocom/progid.h>
+#include <autocom/record.h>
 #include <autocom/safearray.h>
+#include <autocom/server.h>
+#include <autocom/trace.h>
 #include <autocom/typeinfo.h>
 #include <autocom/util.h>
 #include <autocom/variant.h>
+#include <autocom/view.h>
+#if defined(_WIN32)
+#   include <autocom/worker.h>
+#endif
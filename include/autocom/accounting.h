@@ -0,0 +1,236 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Allocation accounting for Bstr, Variant and SafeArray lifetimes.
+ *
+ *  When AutoCOM is compiled with `AUTOCOM_ACCOUNTING`, BSTR, SAFEARRAY
+ *  and VARIANT allocation calls made by the wrappers are counted per
+ *  thread and per call site. Otherwise, the wrappers forward directly
+ *  to the OLE Automation API, and every count is zero.
+ */
+
+#pragma once
+
+#include <oaidl.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace autocom
+{
+namespace accounting
+{
+// ENUMS
+// -----
+
+
+/** \brief Counted OLE Automation calls.
+ */
+enum AccountedCall
+{
+    ACCOUNT_SYSALLOCSTRING      = 0,
+    ACCOUNT_SYSFREESTRING       = 1,
+    ACCOUNT_SAFEARRAYCREATE     = 2,
+    ACCOUNT_SAFEARRAYDESTROY    = 3,
+    ACCOUNT_SAFEARRAYCOPY       = 4,
+    ACCOUNT_VARIANTCLEAR        = 5,
+    ACCOUNT_VARIANTCOPY         = 6,
+    ACCOUNT_CALLS               = 7,
+};
+
+// CONSTANTS
+// ---------
+
+/** Set if calls are counted.
+ */
+#ifdef AUTOCOM_ACCOUNTING
+const bool ENABLED = true;
+#else
+const bool ENABLED = false;
+#endif
+
+// OBJECTS
+// -------
+
+
+/** \brief Number of calls of each kind.
+ */
+struct Counts
+{
+    std::array<uint64_t, ACCOUNT_CALLS> calls = {};
+
+    uint64_t & operator[](const AccountedCall call);
+    const uint64_t & operator[](const AccountedCall call) const;
+
+    uint64_t allocations() const;
+    uint64_t total() const;
+};
+
+
+/** \brief Calls made from a single call site.
+ */
+struct Site
+{
+    std::string tag;
+    Counts counts;
+};
+
+
+/** \brief Count calls made by the current thread while in scope.
+ *
+ *  Scopes snapshot the thread's counters on construction, so scopes
+ *  may be nested, and each reports the calls made since it started.
+ *
+ *  \code
+ *      accounting::Scope scope;
+ *      Bstr copy(other);
+ *      assert(scope.count(accounting::ACCOUNT_SYSALLOCSTRING) <= 1);
+ *  \endcode
+ */
+class Scope
+{
+protected:
+    std::vector<std::pair<const char*, Counts>> start;
+
+public:
+    Scope();
+    Scope(const Scope&) = delete;
+    Scope & operator=(const Scope&) = delete;
+
+    void reset();
+
+    Counts counts() const;
+    uint64_t count(const AccountedCall call) const;
+    uint64_t count(const AccountedCall call,
+        const std::string &tag) const;
+    std::vector<Site> sites() const;
+    std::string report() const;
+};
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Record call from tagged call site, on the current thread.
+ *
+ *  \param tag                  String literal naming the call site.
+ */
+void record(const AccountedCall call,
+    const char *tag);
+
+/** \brief Get name of counted call.
+ */
+const char * name(const AccountedCall call);
+
+/** \brief Get cumulative counts of the current thread, by call site.
+ */
+std::vector<Site> threadSites();
+
+/** \brief Record call if accounting is enabled.
+ */
+inline void account(const AccountedCall call,
+    const char *tag)
+{
+#ifdef AUTOCOM_ACCOUNTING
+    record(call, tag);
+#else
+    (void) call;
+    (void) tag;
+#endif
+}
+
+
+/** \brief Counted SysAllocStringLen.
+ */
+inline BSTR sysAllocStringLen(const OLECHAR *string,
+    const size_t length,
+    const char *tag)
+{
+    account(ACCOUNT_SYSALLOCSTRING, tag);
+    return SysAllocStringLen(string, static_cast<UINT>(length));
+}
+
+
+/** \brief Counted SysFreeString.
+ */
+inline void sysFreeString(BSTR string,
+    const char *tag)
+{
+    account(ACCOUNT_SYSFREESTRING, tag);
+    SysFreeString(string);
+}
+
+
+/** \brief Counted SafeArrayCreate.
+ */
+inline SAFEARRAY * safeArrayCreate(const VARTYPE vt,
+    const UINT dimensions,
+    SAFEARRAYBOUND *bounds,
+    const char *tag)
+{
+    account(ACCOUNT_SAFEARRAYCREATE, tag);
+    return SafeArrayCreate(vt, dimensions, bounds);
+}
+
+
+/** \brief Counted SafeArrayCreateEx.
+ */
+inline SAFEARRAY * safeArrayCreateEx(const VARTYPE vt,
+    const UINT dimensions,
+    SAFEARRAYBOUND *bounds,
+    PVOID extra,
+    const char *tag)
+{
+    account(ACCOUNT_SAFEARRAYCREATE, tag);
+    return SafeArrayCreateEx(vt, dimensions, bounds, extra);
+}
+
+
+/** \brief Counted SafeArrayDestroy.
+ */
+inline HRESULT safeArrayDestroy(SAFEARRAY *array,
+    const char *tag)
+{
+    account(ACCOUNT_SAFEARRAYDESTROY, tag);
+    return SafeArrayDestroy(array);
+}
+
+
+/** \brief Counted SafeArrayCopy.
+ */
+inline HRESULT safeArrayCopy(const SAFEARRAY *in,
+    SAFEARRAY **out,
+    const char *tag)
+{
+    account(ACCOUNT_SAFEARRAYCOPY, tag);
+    return SafeArrayCopy(const_cast<SAFEARRAY*>(in), out);
+}
+
+
+/** \brief Counted VariantClear.
+ */
+inline HRESULT variantClear(VARIANT *variant,
+    const char *tag)
+{
+    account(ACCOUNT_VARIANTCLEAR, tag);
+    return VariantClear(variant);
+}
+
+
+/** \brief Counted VariantCopy.
+ */
+inline HRESULT variantCopy(VARIANT *destination,
+    const VARIANT *source,
+    const char *tag)
+{
+    account(ACCOUNT_VARIANTCOPY, tag);
+    return VariantCopy(destination, const_cast<VARIANT*>(source));
+}
+
+}   /* accounting */
+}   /* autocom */
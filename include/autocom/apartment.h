@@ -0,0 +1,223 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Cross-apartment interface references.
+ *
+ *  COM interface pointers are only valid in the apartment which
+ *  created them. An `ApartmentHandle` registers an interface once
+ *  in an interface table (by default, the Global Interface Table),
+ *  and each consuming thread unmarshals its own proxy on first use,
+ *  which is cached in thread-local storage.
+ */
+
+#pragma once
+
+#include <autocom/util/shared_ptr.h>
+
+#include <oaidl.h>
+#include <objidl.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+
+namespace autocom
+{
+// OBJECTS
+// -------
+
+
+/** \brief Backend which marshals interfaces between apartments.
+ */
+class InterfaceTable
+{
+public:
+    virtual ~InterfaceTable() = default;
+
+    /** \brief Register interface, from the apartment which owns it.
+     */
+    virtual HRESULT registerInterface(IUnknown *unknown,
+        REFIID iid,
+        DWORD &cookie) = 0;
+
+    /** \brief Get proxy to interface, valid in the calling apartment.
+     */
+    virtual HRESULT getInterface(DWORD cookie,
+        REFIID iid,
+        void **ppv) = 0;
+
+    /** \brief Remove interface registration.
+     */
+    virtual HRESULT revokeInterface(DWORD cookie) = 0;
+};
+
+
+/** \brief Marshal interfaces through the process Global Interface Table.
+ */
+class GlobalInterfaceTable: public InterfaceTable
+{
+protected:
+    IGlobalInterfaceTable *table = nullptr;
+    std::mutex mutex;
+
+    HRESULT open();
+
+public:
+    GlobalInterfaceTable() = default;
+    GlobalInterfaceTable(const GlobalInterfaceTable&) = delete;
+    GlobalInterfaceTable & operator=(const GlobalInterfaceTable&) = delete;
+    ~GlobalInterfaceTable();
+
+    static std::shared_ptr<InterfaceTable> global();
+
+    virtual HRESULT registerInterface(IUnknown *unknown,
+        REFIID iid,
+        DWORD &cookie) override;
+    virtual HRESULT getInterface(DWORD cookie,
+        REFIID iid,
+        void **ppv) override;
+    virtual HRESULT revokeInterface(DWORD cookie) override;
+};
+
+
+/** \brief Interface registered for use from any apartment.
+ *
+ *  Copies share the registration, which is revoked with the last
+ *  copy. Cached proxies are released by their own thread, from
+ *  `clearThread()` or when the thread's last COM context is
+ *  uninitialized.
+ */
+class ApartmentHandle
+{
+protected:
+    struct State;
+    std::shared_ptr<State> state;
+
+public:
+    ApartmentHandle() = default;
+    ApartmentHandle(const ApartmentHandle&) = default;
+    ApartmentHandle & operator=(const ApartmentHandle&) = default;
+    ApartmentHandle(ApartmentHandle&&) = default;
+    ApartmentHandle & operator=(ApartmentHandle&&) = default;
+
+    ApartmentHandle(IUnknown *unknown,
+        REFIID iid,
+        std::shared_ptr<InterfaceTable> table = GlobalInterfaceTable::global());
+
+    void open(IUnknown *unknown,
+        REFIID iid,
+        std::shared_ptr<InterfaceTable> table = GlobalInterfaceTable::global());
+    void reset();
+
+    // DATA
+    SharedPointer<IUnknown> get() const;
+    explicit operator bool() const;
+
+    // THREAD
+    static void clearThread();
+};
+
+
+/** \brief Get interface ID of a COM interface type.
+ */
+template <typename T>
+struct InterfaceId
+{
+    static const IID & get()
+    {
+        return T::iid;
+    }
+};
+
+
+template <>
+struct InterfaceId<IUnknown>
+{
+    static const IID & get()
+    {
+        return IID_IUnknown;
+    }
+};
+
+
+template <>
+struct InterfaceId<IDispatch>
+{
+    static const IID & get()
+    {
+        return IID_IDispatch;
+    }
+};
+
+
+/** \brief Typed, agile reference to a COM interface.
+ */
+template <typename T>
+class AgileRef
+{
+protected:
+    ApartmentHandle handle;
+
+public:
+    AgileRef() = default;
+    AgileRef(const AgileRef&) = default;
+    AgileRef & operator=(const AgileRef&) = default;
+    AgileRef(AgileRef&&) = default;
+    AgileRef & operator=(AgileRef&&) = default;
+
+    AgileRef(T *object,
+        REFIID iid = InterfaceId<T>::get(),
+        std::shared_ptr<InterfaceTable> table = GlobalInterfaceTable::global());
+
+    void reset();
+
+    // DATA
+    std::shared_ptr<T> get() const;
+    explicit operator bool() const;
+};
+
+
+// IMPLEMENTATION
+// --------------
+
+
+/** \brief Register interface in the calling apartment.
+ */
+template <typename T>
+AgileRef<T>::AgileRef(T *object,
+        REFIID iid,
+        std::shared_ptr<InterfaceTable> table):
+    handle(object, iid, std::move(table))
+{}
+
+
+/** \brief Release registration.
+ */
+template <typename T>
+void AgileRef<T>::reset()
+{
+    handle.reset();
+}
+
+
+/** \brief Get proxy for the calling thread.
+ */
+template <typename T>
+std::shared_ptr<T> AgileRef<T>::get() const
+{
+    std::shared_ptr<IUnknown> proxy = handle.get();
+    return std::shared_ptr<T>(proxy, static_cast<T*>(proxy.get()));
+}
+
+
+/** \brief Check if reference holds an interface.
+ */
+template <typename T>
+AgileRef<T>::operator bool() const
+{
+    return bool(handle);
+}
+
+}   /* autocom */
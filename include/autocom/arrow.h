@@ -0,0 +1,129 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Apache Arrow C Data Interface export.
+ *
+ *  Exports SAFEARRAYs and VARIANT columns to `ArrowArray` and
+ *  `ArrowSchema` structures. Numeric arrays are exported without
+ *  copies: the SAFEARRAY is owned by the exported array and destroyed
+ *  by the release callback.
+ */
+
+#pragma once
+
+#include <autocom/safearray.h>
+#include <autocom/variant.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// ARROW
+// -----
+
+/** Definitions from the Arrow C Data Interface specification, guarded
+ *  so they can coexist with `arrow/c/abi.h`.
+ */
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema
+{
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+    void (*release)(struct ArrowSchema *);
+    void *private_data;
+};
+
+
+struct ArrowArray
+{
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+    void (*release)(struct ArrowArray *);
+    void *private_data;
+};
+
+}   /* extern "C" */
+
+#endif          // ARROW_C_DATA_INTERFACE
+
+
+namespace autocom
+{
+// FUNCTIONS
+// ---------
+
+/** \brief Get Arrow format string for a VARTYPE.
+ *
+ *  \return             Format string, or null if the type has no
+ *                      Arrow equivalent.
+ */
+const char * arrowFormat(const VARTYPE vt);
+
+/** \brief Export SAFEARRAY to Arrow, taking ownership of the array.
+ *
+ *  Numeric arrays are exported zero-copy, VT_BOOL arrays are packed
+ *  to bitmaps, VT_BSTR arrays are transcoded to UTF-8, and
+ *  VT_VARIANT arrays are exported as a column of the first non-null
+ *  type. Multi-dimensional arrays are flattened in storage order.
+ *
+ *  \warning The array must not be locked by the caller.
+ */
+void exportArrow(SAFEARRAY *&&array,
+    ArrowArray *out,
+    ArrowSchema *schema,
+    const std::string &name = "");
+
+/** \brief Export VARIANT column to Arrow.
+ *
+ *  VT_EMPTY and VT_NULL values are exported as nulls, and all other
+ *  values are coerced to the type of the first non-null value.
+ */
+void exportArrow(const VARIANT *column,
+    const size_t length,
+    ArrowArray *out,
+    ArrowSchema *schema,
+    const std::string &name = "");
+
+/** \brief Export Variant rows to an Arrow struct array.
+ *
+ *  Each row must contain one value per name, and each field is
+ *  exported as a child column.
+ */
+void exportArrow(const std::vector<VariantList> &rows,
+    const std::vector<std::string> &names,
+    ArrowArray *out,
+    ArrowSchema *schema);
+
+/** \brief Export SafeArray to Arrow, taking ownership of the array.
+ */
+template <typename T>
+void exportArrow(SafeArray<T> &&array,
+    ArrowArray *out,
+    ArrowSchema *schema,
+    const std::string &name = "")
+{
+    exportArrow(array.release(), out, schema, name);
+}
+
+}   /* autocom */
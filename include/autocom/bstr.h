@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <autocom/accounting.h>
+
 #include <wtypes.h>
 
 #include <iterator>
@@ -148,7 +150,7 @@ Bstr & Bstr::operator+=(Ts&&... ts)
     std::wstring wide(*this);
     wide.append(AUTOCOM_FWD(ts)...);
     clear();
-    string = SysAllocStringLen(wide.data(), wide.size());
+    string = accounting::sysAllocStringLen(wide.data(), wide.size(), "Bstr::operator+=()");
 
     return *this;
 }
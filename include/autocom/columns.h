@@ -0,0 +1,303 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Transpose arrays of records into struct-of-arrays columns.
+ *
+ *  Generated headers declare a `<Record>Columns` struct and an offset
+ *  table for each record, and forward to these helpers. Records are
+ *  transposed in blocks of `COLUMN_BLOCK` rows, so each block stays in
+ *  cache while every column is filled. 32- and 64-bit numeric fields
+ *  are gathered with AVX2 where the target supports it.
+ *
+ *  Columns are bitwise copies: BSTR, VARIANT and pointer fields are
+ *  still owned by the records.
+ */
+
+#pragma once
+
+#include <autocom/safearray.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+
+namespace autocom
+{
+// CONSTANTS
+// ---------
+
+/** \brief Number of records transposed at a time.
+ */
+constexpr size_t COLUMN_BLOCK = 64;
+
+// TYPES
+// -----
+
+
+/** \brief Column element for a record field, with arrays as `std::array`.
+ */
+template <typename T>
+struct ColumnValue
+{
+    typedef T type;
+};
+
+
+template <typename T, size_t N>
+struct ColumnValue<T[N]>
+{
+    typedef std::array<typename ColumnValue<T>::type, N> type;
+};
+
+
+template <typename T>
+using Column = std::vector<typename ColumnValue<T>::type>;
+
+
+/** \brief Width of fields which may be gathered with SIMD, otherwise 0.
+ */
+template <typename T>
+using GatherWidth = std::integral_constant<size_t,
+    (std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value) ? sizeof(T) : 0
+>;
+
+// FUNCTIONS
+// ---------
+
+/** \brief Copy a 32-bit field from `count` records `stride` bytes apart.
+ */
+void gatherColumn32(const void *records,
+    const size_t stride,
+    const size_t count,
+    void *column);
+
+/** \brief Copy a 64-bit field from `count` records `stride` bytes apart.
+ */
+void gatherColumn64(const void *records,
+    const size_t stride,
+    const size_t count,
+    void *column);
+
+template <typename T>
+void gatherColumn(const void *records,
+    const size_t stride,
+    const size_t count,
+    T *column);
+
+template <typename T>
+void scatterColumn(const T *column,
+    const size_t stride,
+    const size_t count,
+    void *records);
+
+template <typename Record, typename... Ts>
+void gatherColumns(const Record *records,
+    const size_t count,
+    const size_t *offsets,
+    std::vector<Ts>&... columns);
+
+template <typename Record, typename... Ts>
+void scatterColumns(Record *records,
+    const size_t *offsets,
+    const std::vector<Ts>&... columns);
+
+template <typename T, typename Columns>
+void toColumns(const SafeArray<T> &array,
+    Columns &columns);
+
+// IMPLEMENTATION
+// --------------
+
+namespace columns
+{
+
+/** \brief Copy field bytewise, for fields without a SIMD kernel.
+ */
+template <typename T, size_t N>
+void gather(const BYTE *records,
+    const size_t stride,
+    const size_t count,
+    T *column,
+    std::integral_constant<size_t, N>)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Record fields must be trivially copyable.");
+
+    for (size_t i = 0; i < count; ++i) {
+        std::memcpy(column + i, records + i * stride, sizeof(T));
+    }
+}
+
+
+/** \brief Gather 32-bit numeric fields.
+ */
+template <typename T>
+void gather(const BYTE *records,
+    const size_t stride,
+    const size_t count,
+    T *column,
+    std::integral_constant<size_t, 4>)
+{
+    gatherColumn32(records, stride, count, column);
+}
+
+
+/** \brief Gather 64-bit numeric fields.
+ */
+template <typename T>
+void gather(const BYTE *records,
+    const size_t stride,
+    const size_t count,
+    T *column,
+    std::integral_constant<size_t, 8>)
+{
+    gatherColumn64(records, stride, count, column);
+}
+
+
+/** \brief Fill no more columns, ends recursion.
+ */
+inline void gatherBlock(const BYTE * /*records*/,
+    const size_t /*stride*/,
+    const size_t /*count*/,
+    const size_t * /*offsets*/)
+{}
+
+
+/** \brief Fill each column for a block of records.
+ */
+template <typename T, typename... Ts>
+void gatherBlock(const BYTE *records,
+    const size_t stride,
+    const size_t count,
+    const size_t *offsets,
+    T *column,
+    Ts*... columns)
+{
+    gatherColumn(records + offsets[0], stride, count, column);
+    gatherBlock(records, stride, count, offsets + 1, columns...);
+}
+
+
+/** \brief Copy no more columns, ends recursion.
+ */
+inline void scatterBlock(BYTE * /*records*/,
+    const size_t /*stride*/,
+    const size_t /*count*/,
+    const size_t * /*offsets*/)
+{}
+
+
+/** \brief Copy each column back into a block of records.
+ */
+template <typename T, typename... Ts>
+void scatterBlock(BYTE *records,
+    const size_t stride,
+    const size_t count,
+    const size_t *offsets,
+    const T *column,
+    const Ts*... columns)
+{
+    scatterColumn(column, stride, count, records + offsets[0]);
+    scatterBlock(records, stride, count, offsets + 1, columns...);
+}
+
+}   /* columns */
+
+
+/** \brief Copy a field from `count` records `stride` bytes apart.
+ *
+ *  \param records              Address of the field in the first record.
+ */
+template <typename T>
+void gatherColumn(const void *records,
+    const size_t stride,
+    const size_t count,
+    T *column)
+{
+    columns::gather(static_cast<const BYTE*>(records), stride, count, column, GatherWidth<T>());
+}
+
+
+/** \brief Copy a column into a field of `count` records.
+ *
+ *  \param records              Address of the field in the first record.
+ */
+template <typename T>
+void scatterColumn(const T *column,
+    const size_t stride,
+    const size_t count,
+    void *records)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Record fields must be trivially copyable.");
+
+    auto *bytes = static_cast<BYTE*>(records);
+    for (size_t i = 0; i < count; ++i) {
+        std::memcpy(bytes + i * stride, column + i, sizeof(T));
+    }
+}
+
+
+/** \brief Transpose records into one column per field.
+ *
+ *  \param offsets              Offset of each field, in column order.
+ */
+template <typename Record, typename... Ts>
+void gatherColumns(const Record *records,
+    const size_t count,
+    const size_t *offsets,
+    std::vector<Ts>&... columns)
+{
+    int expand[] = {0, (columns.resize(count), 0)...};
+    (void) expand;
+
+    auto *bytes = reinterpret_cast<const BYTE*>(records);
+    for (size_t first = 0; first < count; first += COLUMN_BLOCK) {
+        size_t rows = std::min(count - first, COLUMN_BLOCK);
+        columns::gatherBlock(bytes + first * sizeof(Record), sizeof(Record), rows, offsets, columns.data() + first...);
+    }
+}
+
+
+/** \brief Transpose columns back into records.
+ *
+ *  \param records              Buffer holding at least as many records
+ *                              as there are rows in each column.
+ *  \param offsets              Offset of each field, in column order.
+ */
+template <typename Record, typename... Ts>
+void scatterColumns(Record *records,
+    const size_t *offsets,
+    const std::vector<Ts>&... columns)
+{
+    const size_t sizes[] = {columns.size()...};
+    const size_t count = sizes[0];
+    for (const size_t size: sizes) {
+        if (size != count) {
+            throw std::invalid_argument("Record columns must have the same number of rows.");
+        }
+    }
+
+    auto *bytes = reinterpret_cast<BYTE*>(records);
+    for (size_t first = 0; first < count; first += COLUMN_BLOCK) {
+        size_t rows = std::min(count - first, COLUMN_BLOCK);
+        columns::scatterBlock(bytes + first * sizeof(Record), sizeof(Record), rows, offsets, columns.data() + first...);
+    }
+}
+
+
+/** \brief Transpose SafeArray of records, using the generated overload.
+ */
+template <typename T, typename Columns>
+void toColumns(const SafeArray<T> &array,
+    Columns &columns)
+{
+    toColumns(array.data(), array.size(), columns);
+}
+
+}   /* autocom */
@@ -8,13 +8,17 @@
 #pragma once
 
 #include <autocom/dispparams.h>
+#include <autocom/trace.h>
 #include <autocom/util/define.h>
 #include <autocom/util/exception.h>
+#include <autocom/util/result.h>
 #include <autocom/util/shared_ptr.h>
 
 #include <initguid.h>
 #include <dispex.h>
 
+#include <string>
+
 
 namespace autocom
 {
@@ -26,10 +30,57 @@ typedef std::string Name;
 typedef std::wstring WName;
 typedef std::pair<Variant, bool> MethodResult;
 
+// FORWARD
+// -------
+
+class DispatchBase;
+
+// ENUMS
+// -----
+
+/** \brief COM apartment joined by a thread.
+ *
+ *  Threads cannot enter the neutral apartment directly: a neutral
+ *  thread joins the multithreaded apartment, unless it already
+ *  belongs to another apartment, which it then keeps.
+ */
+enum ApartmentModel
+{
+    APARTMENT_NEUTRAL   = 0,
+    APARTMENT_MTA       = 1,
+    APARTMENT_STA       = 2,
+};
+
+// OBJECTS
+// -------
+
+
+/** \brief Apartment settings applied when a thread initializes COM.
+ *
+ *  \param model                Apartment to join.
+ *  \param flags                Additional COINIT flags, such as
+ *                              COINIT_DISABLE_OLE1DDE.
+ */
+struct ApartmentConfig
+{
+    ApartmentModel model = APARTMENT_NEUTRAL;
+    DWORD flags = 0;
+};
+
 // FUNCTIONS
 // ---------
 
 
+/** \brief Set apartment for the current thread.
+ *
+ *  Must be called before the thread initializes COM.
+ */
+void configureApartment(const ApartmentConfig &config);
+
+/** \brief Get apartment settings for the current thread.
+ */
+ApartmentConfig apartmentConfig();
+
 /** \brief Initialize COM context for current thread.
  */
 void initialize();
@@ -90,6 +141,85 @@ bool equalObject(ObjectPtr left,
 // -------
 
 
+/** \brief Details of a failed IDispatch call, read on demand.
+ *
+ *  Failures only record the member, the index of a bad argument, and
+ *  the exception or error object left by the server, so checking
+ *  them never allocates. Descriptions are converted, and deferred
+ *  exceptions filled in, when first requested.
+ */
+class DispatchError
+{
+protected:
+    Function id = DISPID_UNKNOWN;
+    UINT index = 0;
+    mutable EXCEPINFO exception;
+    SharedPointer<IErrorInfo> info;
+
+    void capture(IDispatch *dispatch,
+        const HRESULT hr);
+    void fillIn() const;
+
+    friend class DispatchBase;
+
+public:
+    DispatchError();
+    DispatchError(const DispatchError &other);
+    DispatchError & operator=(const DispatchError &other);
+    DispatchError(DispatchError &&other);
+    DispatchError & operator=(DispatchError &&other);
+    ~DispatchError();
+
+    DispatchError(const Function id);
+
+    // DATA
+    Function member() const;
+    UINT argument() const;
+    std::wstring source() const;
+    std::wstring description() const;
+};
+
+
+/** \brief Value from an IDispatch call, or the HRESULT and error details.
+ */
+template <typename T>
+class DispatchResult: public Result<T>,
+    public DispatchError
+{
+protected:
+    void assign(IDispatch *dispatch,
+        const HRESULT hr,
+        Variant &value);
+
+    friend class DispatchBase;
+
+public:
+    DispatchResult() = default;
+    DispatchResult(const HRESULT hr,
+        const Function id);
+};
+
+
+/** \brief HRESULT and error details from an IDispatch call.
+ */
+template <>
+class DispatchResult<void>: public Result<void>,
+    public DispatchError
+{
+protected:
+    void assign(IDispatch *dispatch,
+        const HRESULT hr,
+        Variant &value);
+
+    friend class DispatchBase;
+
+public:
+    DispatchResult() = default;
+    DispatchResult(const HRESULT hr,
+        const Function id);
+};
+
+
 /** \brief COM object wrapper for the IDispatch (late-binding) model.
  */
 class DispatchBase
@@ -98,6 +228,17 @@ protected:
     SharedPointer<IDispatch> ppv;
 
     Function getFunction(const Bstr &name);
+    HRESULT getFunction(const Bstr &name,
+        Function &id);
+
+    template <typename... Ts>
+    HRESULT invokeMember(DispatchFlags flags,
+        VARIANT *result,
+        const Function id,
+        const Bstr *name,
+        EXCEPINFO *exception,
+        UINT *error,
+        Ts&&... ts);
 
     template <typename... Ts>
     bool invoke(DispatchFlags flags,
@@ -111,6 +252,16 @@ protected:
         const Bstr &name,
         Ts&&... ts);
 
+    template <typename T, typename... Ts>
+    DispatchResult<T> tryInvoke(DispatchFlags flags,
+        const Function id,
+        Ts&&... ts);
+
+    template <typename T, typename... Ts>
+    DispatchResult<T> tryInvoke(DispatchFlags flags,
+        const Bstr &name,
+        Ts&&... ts);
+
     template <typename... Ts>
     MethodResult get_(Ts&&... ts);
 
@@ -166,6 +317,19 @@ public:
     template <typename... Ts>
     Variant methodV(Ts&&... ts);
 
+    // RESULT
+    template <typename T = Variant, typename... Ts>
+    DispatchResult<T> tryGet(Ts&&... ts);
+
+    template <typename... Ts>
+    DispatchResult<void> tryPut(Ts&&... ts);
+
+    template <typename... Ts>
+    DispatchResult<void> tryPutref(Ts&&... ts);
+
+    template <typename T = Variant, typename... Ts>
+    DispatchResult<T> tryMethod(Ts&&... ts);
+
     explicit operator bool() const;
     IDispatch & operator*();
     const IDispatch & operator*() const;
@@ -199,23 +363,133 @@ public:
 };
 
 
+// HELPERS
+// -------
+
+namespace detail
+{
+
+/** \brief Convert result of a call, without throwing on type mismatch.
+ */
+template <typename T>
+HRESULT getResult(Variant &variant,
+    T &value)
+{
+    const VARTYPE vt = VariantType<T>::vt;
+    if (vt != VT_USERDEFINED && variant.vt != vt) {
+        HRESULT hr = VariantChangeType(&variant, &variant, 0, vt);
+        if (FAILED(hr)) {
+            return hr;
+        }
+    }
+    autocom::get(variant, value);
+    return S_OK;
+}
+
+
+/** \brief Move result of a call, without conversion.
+ */
+inline HRESULT getResult(Variant &variant,
+    Variant &value)
+{
+    value = std::move(variant);
+    return S_OK;
+}
+
+}   /* detail */
+
 // IMPLEMENTATION
 // --------------
 
 
-/** \brief Call dispatch method by function ID.
+/** \brief Initialize failed result for member.
+ */
+template <typename T>
+DispatchResult<T>::DispatchResult(const HRESULT hr,
+        const Function id):
+    Result<T>(hr),
+    DispatchError(id)
+{}
+
+
+/** \brief Store status of a call, and convert its result.
+ *
+ *  Conversion failures keep the result as the HRESULT.
+ */
+template <typename T>
+void DispatchResult<T>::assign(IDispatch *dispatch,
+    const HRESULT hr,
+    Variant &value)
+{
+    this->hr = hr;
+    if (FAILED(hr)) {
+        capture(dispatch, hr);
+    } else {
+        HRESULT status = detail::getResult(value, this->item);
+        if (FAILED(status)) {
+            this->hr = status;
+        }
+    }
+}
+
+
+/** \brief Initialize failed result for member.
+ */
+inline DispatchResult<void>::DispatchResult(const HRESULT hr,
+        const Function id):
+    Result<void>(hr),
+    DispatchError(id)
+{}
+
+
+/** \brief Store status of a call, ignoring its result.
+ */
+inline void DispatchResult<void>::assign(IDispatch *dispatch,
+    const HRESULT hr,
+    Variant &value)
+{
+    this->hr = hr;
+    if (FAILED(hr)) {
+        capture(dispatch, hr);
+    }
+}
+
+
+/** \brief Call dispatch method, recording the call while tracing.
+ *
+ *  \param name                 Member name, or null if called by ID.
+ *  \param exception            Exception filled by the server, or null.
+ *  \param error                Index of a bad argument, or null.
  */
 template <typename... Ts>
-bool DispatchBase::invoke(DispatchFlags flags,
+HRESULT DispatchBase::invokeMember(DispatchFlags flags,
     VARIANT *result,
     const Function id,
+    const Bstr *name,
+    EXCEPINFO *exception,
+    UINT *error,
     Ts&&... ts)
 {
     DispParams dp;
     dp.setArgs(AUTOCOM_FWD(ts)...);
     dp.setFlags(flags);
 
-    return SUCCEEDED(ppv->Invoke(id, IID_NULL, LOCALE_USER_DEFAULT, FROM_ENUM(flags), dp.params(), result, nullptr, nullptr));
+    if (trace::enabled()) {
+        return trace::invoke(ppv.get(), id, name ? name->data() : nullptr, FROM_ENUM(flags), dp.params(), result, exception, error);
+    }
+    return ppv->Invoke(id, IID_NULL, LOCALE_USER_DEFAULT, FROM_ENUM(flags), dp.params(), result, exception, error);
+}
+
+
+/** \brief Call dispatch method by function ID.
+ */
+template <typename... Ts>
+bool DispatchBase::invoke(DispatchFlags flags,
+    VARIANT *result,
+    const Function id,
+    Ts&&... ts)
+{
+    return SUCCEEDED(invokeMember(flags, result, id, nullptr, nullptr, nullptr, AUTOCOM_FWD(ts)...));
 }
 
 
@@ -227,7 +501,47 @@ bool DispatchBase::invoke(DispatchFlags flags,
     const Bstr &name,
     Ts&&... ts)
 {
-    return invoke(flags, result, getFunction(name), AUTOCOM_FWD(ts)...);
+    return SUCCEEDED(invokeMember(flags, result, getFunction(name), &name, nullptr, nullptr, AUTOCOM_FWD(ts)...));
+}
+
+
+/** \brief Call dispatch method by function ID, keeping the HRESULT.
+ */
+template <typename T, typename... Ts>
+DispatchResult<T> DispatchBase::tryInvoke(DispatchFlags flags,
+    const Function id,
+    Ts&&... ts)
+{
+    DispatchResult<T> result(S_OK, id);
+    Variant value;
+    HRESULT hr = invokeMember(flags, &value, id, nullptr, &result.exception, &result.index, AUTOCOM_FWD(ts)...);
+    result.assign(ppv.get(), hr, value);
+
+    return result;
+}
+
+
+/** \brief Call dispatch method by function name, keeping the HRESULT.
+ *
+ *  Unknown names fail with the HRESULT from `GetIDsOfNames`.
+ */
+template <typename T, typename... Ts>
+DispatchResult<T> DispatchBase::tryInvoke(DispatchFlags flags,
+    const Bstr &name,
+    Ts&&... ts)
+{
+    Function id;
+    HRESULT hr = getFunction(name, id);
+    if (FAILED(hr)) {
+        return DispatchResult<T>(hr, DISPID_UNKNOWN);
+    }
+
+    DispatchResult<T> result(S_OK, id);
+    Variant value;
+    hr = invokeMember(flags, &value, id, &name, &result.exception, &result.index, AUTOCOM_FWD(ts)...);
+    result.assign(ppv.get(), hr, value);
+
+    return result;
 }
 
 
@@ -374,6 +688,50 @@ Variant DispatchBase::methodV(Ts&&... ts)
 }
 
 
+/** \brief Call get, keeping the HRESULT on failure.
+ *
+ *  The value is converted to `T`, unless `T` is Variant.
+ */
+template <typename T, typename... Ts>
+DispatchResult<T> DispatchBase::tryGet(Ts&&... ts)
+{
+    static_assert(sizeof...(Ts) >= 1, "Must provide function identifier");
+    return tryInvoke<T>(GET, AUTOCOM_FWD(ts)...);
+}
+
+
+/** \brief Call put, keeping the HRESULT on failure.
+ */
+template <typename... Ts>
+DispatchResult<void> DispatchBase::tryPut(Ts&&... ts)
+{
+    static_assert(sizeof...(Ts) >= 1, "Must provide function identifier");
+    return tryInvoke<void>(PUT, AUTOCOM_FWD(ts)...);
+}
+
+
+/** \brief Call putref, keeping the HRESULT on failure.
+ */
+template <typename... Ts>
+DispatchResult<void> DispatchBase::tryPutref(Ts&&... ts)
+{
+    static_assert(sizeof...(Ts) >= 1, "Must provide function identifier");
+    return tryInvoke<void>(PUTREF, AUTOCOM_FWD(ts)...);
+}
+
+
+/** \brief Call method, keeping the HRESULT on failure.
+ *
+ *  The return value is converted to `T`, unless `T` is Variant or void.
+ */
+template <typename T, typename... Ts>
+DispatchResult<T> DispatchBase::tryMethod(Ts&&... ts)
+{
+    static_assert(sizeof...(Ts) >= 1, "Must provide function identifier");
+    return tryInvoke<T>(METHOD, AUTOCOM_FWD(ts)...);
+}
+
+
 /** \brief Initialize interface on construction.
  */
 template <
@@ -0,0 +1,248 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Typed SafeArray element conversions.
+ *
+ *  Widens or narrows numeric SAFEARRAY elements in a single pass over
+ *  the locked data, without boxing each element in a VARIANT.
+ *  Lossless widening pairs (`float` to `double`, 16-bit to 32-bit
+ *  integers, `VARIANT_BOOL` to `bool`) use SIMD kernels where the
+ *  target supports AVX2.
+ */
+
+#pragma once
+
+#include <autocom/safearray.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+
+namespace autocom
+{
+// OBJECTS
+// -------
+
+typedef std::chrono::system_clock::time_point TimePoint;
+
+
+/** \brief Handling of values outside the range of the target type.
+ *
+ *  \param Throw            Throw std::overflow_error after the pass.
+ *  \param Saturate         Clamp to the nearest representable value.
+ *  \param Wrap             Truncate modulo the width of the target.
+ */
+enum class OverflowPolicy: int
+{
+    Throw = 0,
+    Saturate = 1,
+    Wrap = 2,
+};
+
+
+/** \brief Handling of NaN values in floating-point sources.
+ *
+ *  \param Propagate        Keep NaN for floating-point targets, and
+ *                          defer to the OverflowPolicy otherwise.
+ *  \param Throw            Throw std::domain_error after the pass.
+ *  \param Zero             Replace NaN with zero.
+ */
+enum class NanPolicy: int
+{
+    Propagate = 0,
+    Throw = 1,
+    Zero = 2,
+};
+
+
+/** \brief Options for SafeArray element conversions.
+ */
+struct ConvertOptions
+{
+    OverflowPolicy overflow = OverflowPolicy::Throw;
+    NanPolicy nan = NanPolicy::Propagate;
+};
+
+// FUNCTIONS
+// ---------
+
+/** \brief Get total number of elements in all dimensions of a SAFEARRAY.
+ */
+size_t safeArrayElements(const SAFEARRAY *array);
+
+/** \brief Convert OLE Automation date to a system clock time point.
+ */
+TimePoint dateToTimePoint(const DATE date);
+
+/** \brief Convert system clock time point to an OLE Automation date.
+ */
+DATE timePointToDate(const TimePoint &point);
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ *
+ *  `out` must hold `safeArrayElements(array)` values. Sources may be
+ *  any integer, floating-point, VT_BOOL or VT_DATE array; VT_BOOL
+ *  elements convert to 1 or 0, and VT_DATE elements to days since
+ *  1899-12-30.
+ */
+void convertElements(const SAFEARRAY *array,
+    CHAR *out,
+    const ConvertOptions &options = ConvertOptions());
+
+void convertElements(const SAFEARRAY *array,
+    UCHAR *out,
+    const ConvertOptions &options = ConvertOptions());
+
+void convertElements(const SAFEARRAY *array,
+    SHORT *out,
+    const ConvertOptions &options = ConvertOptions());
+
+void convertElements(const SAFEARRAY *array,
+    USHORT *out,
+    const ConvertOptions &options = ConvertOptions());
+
+#if !defined(AUTOCOM_LONG_IS_INT)
+void convertElements(const SAFEARRAY *array,
+    INT *out,
+    const ConvertOptions &options = ConvertOptions());
+
+void convertElements(const SAFEARRAY *array,
+    UINT *out,
+    const ConvertOptions &options = ConvertOptions());
+#endif          // AUTOCOM_LONG_IS_INT
+
+void convertElements(const SAFEARRAY *array,
+    LONG *out,
+    const ConvertOptions &options = ConvertOptions());
+
+void convertElements(const SAFEARRAY *array,
+    ULONG *out,
+    const ConvertOptions &options = ConvertOptions());
+
+void convertElements(const SAFEARRAY *array,
+    LONGLONG *out,
+    const ConvertOptions &options = ConvertOptions());
+
+void convertElements(const SAFEARRAY *array,
+    ULONGLONG *out,
+    const ConvertOptions &options = ConvertOptions());
+
+void convertElements(const SAFEARRAY *array,
+    FLOAT *out,
+    const ConvertOptions &options = ConvertOptions());
+
+void convertElements(const SAFEARRAY *array,
+    DOUBLE *out,
+    const ConvertOptions &options = ConvertOptions());
+
+/** \brief Convert SAFEARRAY elements to `bool`, any non-zero is true.
+ */
+void convertElements(const SAFEARRAY *array,
+    bool *out,
+    const ConvertOptions &options = ConvertOptions());
+
+/** \brief Convert VT_DATE SAFEARRAY elements to time points.
+ *
+ *  Dates outside the range of the system clock are handled by the
+ *  OverflowPolicy.
+ */
+void convertElements(const SAFEARRAY *array,
+    TimePoint *out,
+    const ConvertOptions &options = ConvertOptions());
+
+
+/** \brief Convert SAFEARRAY elements to a new vector.
+ */
+template <typename T>
+std::vector<T> convertArray(const SAFEARRAY *array,
+    const ConvertOptions &options = ConvertOptions())
+{
+    std::vector<T> vector(safeArrayElements(array));
+    convertElements(array, vector.data(), options);
+    return vector;
+}
+
+// IMPLEMENTATION
+// --------------
+
+namespace detail
+{
+
+/** \brief Convert SAFEARRAY elements into the locked data of a new array.
+ */
+template <typename T>
+void convertData(const SAFEARRAY *array,
+    void *data,
+    const ConvertOptions &options)
+{
+    convertElements(array, static_cast<T*>(data), options);
+}
+
+
+/** \brief Convert SAFEARRAY elements into VT_BOOL data.
+ *
+ *  VT_BOOL arrays store 2-byte VARIANT_BOOL values, so the elements
+ *  are converted to `bool` and written as VARIANT_TRUE or
+ *  VARIANT_FALSE.
+ */
+template <>
+inline void convertData<bool>(const SAFEARRAY *array,
+    void *data,
+    const ConvertOptions &options)
+{
+    const size_t count = safeArrayElements(array);
+    std::unique_ptr<bool[]> values(new bool[count]);
+    convertElements(array, values.get(), options);
+
+    VARIANT_BOOL *out = static_cast<VARIANT_BOOL*>(data);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = values[i] ? VARIANT_TRUE : VARIANT_FALSE;
+    }
+}
+
+}   /* detail */
+
+
+/** \brief Convert elements from a SAFEARRAY of another numeric type.
+ *
+ *  The new array has the same dimensions and lower bounds as the
+ *  source. Arrays of the same type are copied.
+ */
+template <typename T>
+auto SafeArray<T>::convertFrom(const SAFEARRAY *other,
+    const ConvertOptions &options)
+    -> This
+{
+    if (!other) {
+        throw std::invalid_argument("Cannot convert null SAFEARRAY.");
+    } else if (getSafeArrayType(other) == vt) {
+        return This(other);
+    }
+
+    // SAFEARRAY stores bounds from the rightmost dimension
+    std::vector<SafeArrayBound> bounds(other->rgsabound, other->rgsabound + other->cDims);
+    std::reverse(bounds.begin(), bounds.end());
+
+    This converted(nullptr);
+    converted.create(other->cDims, bounds.data());
+    converted.lock();
+    detail::convertData<T>(other, converted.begin(), options);
+
+    return converted;
+}
+
+
+/** \brief Convert elements with the default policies.
+ */
+template <typename T>
+auto SafeArray<T>::convertFrom(const SAFEARRAY *other)
+    -> This
+{
+    return convertFrom(other, ConvertOptions());
+}
+
+}   /* autocom */
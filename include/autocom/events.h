@@ -0,0 +1,166 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Event sinks for connection points.
+ *
+ *  An event sink advises a server's outgoing (source) interface, and
+ *  dispatches incoming calls by DISPID to C++ handlers, without name
+ *  lookups. Events can also be copied into a bounded queue, to be
+ *  processed away from the thread delivering them.
+ */
+
+#pragma once
+
+#include <autocom/guid.h>
+#include <autocom/variant.h>
+#include <autocom/util/shared_ptr.h>
+
+#include <ocidl.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace autocom
+{
+// FORWARD
+// -------
+
+class EventDispatch;
+
+// TYPES
+// -----
+
+/** \brief Handler for an event.
+ *
+ *  Arguments are in DISPPARAMS (reverse) order, and are only valid
+ *  for the duration of the call.
+ */
+typedef std::function<void(DISPPARAMS &params)> EventHandler;
+
+// FUNCTIONS
+// ---------
+
+/** \brief Create new handle to the default source interface of an object.
+ *
+ *  The coclass is found with IProvideClassInfo, or by searching the
+ *  type library for a coclass whose default interface is the type
+ *  of `dispatch`.
+ */
+ITypeInfo * newSourceTypeInfo(IDispatch *dispatch);
+
+// OBJECTS
+// -------
+
+
+/** \brief Event copied out of DISPPARAMS, with arguments in call order.
+ */
+struct Event
+{
+    DISPID id = DISPID_UNKNOWN;
+    VariantList arguments;
+};
+
+
+/** \brief Bounded, multi-producer, single-consumer queue.
+ *
+ *  A sink in the multithreaded apartment may receive events on
+ *  several threads at once. Each slot of the ring carries a sequence
+ *  number, so producers only contend to claim the tail, then copy
+ *  arguments concurrently, and publish their slot. The consumer
+ *  takes no locks, and waits for slots in order.
+ *
+ *  Slots are reused, so after warm-up, queueing an event only
+ *  allocates for copies of strings, arrays and records. Events are
+ *  dropped, and counted, when the queue is full or their arguments
+ *  cannot be copied.
+ */
+class EventQueue
+{
+protected:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        bool copied = false;
+        Event event;
+    };
+
+    std::vector<Slot> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    std::atomic<size_t> drops;
+
+public:
+    EventQueue(const size_t capacity);
+    EventQueue(const EventQueue&) = delete;
+    EventQueue & operator=(const EventQueue&) = delete;
+
+    // PRODUCER
+    bool push(const DISPID id,
+        const DISPPARAMS &params);
+
+    // CONSUMER
+    bool pop(Event &event);
+
+    // CAPACITY
+    bool empty() const;
+    size_t size() const;
+    size_t capacity() const;
+    size_t dropped() const;
+};
+
+
+/** \brief Sink for the events of a connection point.
+ *
+ *  Handlers must be registered before advising, since they are
+ *  looked up without locking. Events without a handler are ignored,
+ *  unless forwarded to a queue.
+ */
+class EventSink
+{
+protected:
+    SharedPointer<EventDispatch> sink;
+    SharedPointer<IConnectionPoint> point;
+    SharedPointer<ITypeInfo> info;
+    DWORD cookie = 0;
+
+public:
+    EventSink();
+    EventSink(const EventSink&) = delete;
+    EventSink & operator=(const EventSink&) = delete;
+    EventSink(EventSink &&other);
+    EventSink & operator=(EventSink &&other);
+    ~EventSink();
+
+    EventSink(IDispatch *source);
+    EventSink(IUnknown *source,
+        const Guid &iid);
+
+    void open(IDispatch *source);
+    void open(IUnknown *source,
+        const Guid &iid);
+    void close();
+
+    // HANDLERS
+    void on(const DISPID id,
+        EventHandler handler);
+    void on(const std::wstring &name,
+        EventHandler handler);
+    void forward(EventQueue *queue);
+
+    // CONNECTION
+    void advise();
+    void unadvise();
+    bool advised() const;
+
+    // DATA
+    explicit operator bool() const;
+    Guid iid() const;
+    IDispatch * dispatch() const;
+};
+
+}   /* autocom */
@@ -9,9 +9,49 @@
 
 #include <autocom/bstr.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
 
 namespace autocom
 {
+// ENUMS
+// -----
+
+/** \brief String representations of a GUID.
+ */
+enum GuidFormat
+{
+    GUID_UPPER          = 0,
+    GUID_LOWER          = 1,
+    GUID_BRACED_UPPER   = 2,
+    GUID_BRACED_LOWER   = 3,
+};
+
+// FUNCTIONS
+// ---------
+
+constexpr GUID parseGuid(const char *string,
+    const size_t length);
+
+/** \brief Parse GUID string, with or without braces, at runtime.
+ *
+ *  \return                     False if the string is not a GUID.
+ */
+bool readGuid(const char *string,
+    const size_t length,
+    GUID &id);
+
+/** \brief Write GUID to buffer of at least 38 characters.
+ *
+ *  \return                     Number of characters written.
+ */
+size_t formatGuid(const GUID &id,
+    char *buffer,
+    const GuidFormat format = GUID_UPPER);
+
 // OBJECTS
 // -------
 
@@ -26,6 +66,8 @@ protected:
     friend class Dispatch;
 
     void open(const Bstr &string);
+    void open(const char *array,
+        const size_t length);
 
 public:
     Guid() = default;
@@ -34,7 +76,7 @@ public:
     Guid(Guid&&) = default;
     Guid & operator=(Guid&&) = default;
 
-    Guid(const GUID &guid);
+    constexpr Guid(const GUID &guid);
     Guid(const Bstr &string);
     Guid(const char *cstring);
     Guid(const char *array,
@@ -56,15 +98,258 @@ public:
     static Guid fromIid(const std::wstring &string);
     std::string toIid();
 
-    std::string uuid() const;
+    constexpr const GUID & get() const;
+    constexpr uint64_t hash() const;
+    std::string uuid(const GuidFormat format = GUID_UPPER) const;
     std::string define(const std::string &prefix,
         const std::string &name) const;
+    std::string constant(const std::string &prefix,
+        const std::string &name) const;
 
-    friend bool operator==(const Guid &left,
+    friend constexpr bool operator==(const Guid &left,
+        const Guid &right);
+    friend constexpr bool operator!=(const Guid &left,
+        const Guid &right);
+    friend constexpr bool operator<(const Guid &left,
         const Guid &right);
-    friend bool operator!=(const Guid &left,
+    friend constexpr bool operator<=(const Guid &left,
+        const Guid &right);
+    friend constexpr bool operator>(const Guid &left,
+        const Guid &right);
+    friend constexpr bool operator>=(const Guid &left,
         const Guid &right);
 };
 
+// LITERALS
+// --------
+
+inline namespace literals
+{
+
+constexpr Guid operator"" _guid(const char *string,
+    size_t length);
+
+}   /* literals */
+
+// IMPLEMENTATION
+// --------------
+
+namespace detail
+{
+
+/** \brief Get value of hexadecimal digit.
+ */
+constexpr unsigned hexDigit(const char c)
+{
+    return (c >= '0' && c <= '9') ? unsigned(c - '0')
+        : (c >= 'a' && c <= 'f') ? unsigned(c - 'a' + 10)
+        : (c >= 'A' && c <= 'F') ? unsigned(c - 'A' + 10)
+        : throw std::invalid_argument("Invalid hex digit in GUID.");
+}
+
+
+/** \brief Finalize 64-bit hash, from MurmurHash3.
+ */
+constexpr uint64_t mixHash(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+
+/** \brief Compare GUIDs in the order of their string representation.
+ */
+constexpr int compareGuid(const GUID &left,
+    const GUID &right)
+{
+    if (left.Data1 != right.Data1) {
+        return left.Data1 < right.Data1 ? -1 : 1;
+    }
+    if (left.Data2 != right.Data2) {
+        return left.Data2 < right.Data2 ? -1 : 1;
+    }
+    if (left.Data3 != right.Data3) {
+        return left.Data3 < right.Data3 ? -1 : 1;
+    }
+    for (size_t i = 0; i < 8; ++i) {
+        if (left.Data4[i] != right.Data4[i]) {
+            return left.Data4[i] < right.Data4[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+
+/** \brief Parse fixed number of hexadecimal digits.
+ */
+constexpr unsigned long hexValue(const char *string,
+    const size_t digits)
+{
+    unsigned long value = 0;
+    for (size_t i = 0; i < digits; ++i) {
+        value = (value << 4) | hexDigit(string[i]);
+    }
+    return value;
+}
+
+}   /* detail */
+
+
+/** \brief Parse GUID from "{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}".
+ *
+ *  The braces are optional, and digits may be either case. Invalid
+ *  strings throw, so a constant expression with an invalid GUID
+ *  fails to compile.
+ */
+constexpr GUID parseGuid(const char *string,
+    const size_t length)
+{
+    if (length == 38) {
+        if (string[0] != '{' || string[37] != '}') {
+            throw std::invalid_argument("Invalid GUID braces.");
+        }
+        return parseGuid(string + 1, 36);
+    }
+    if (length != 36 || string[8] != '-' || string[13] != '-' || string[18] != '-' || string[23] != '-') {
+        throw std::invalid_argument("Invalid GUID format.");
+    }
+
+    GUID id = {};
+    id.Data1 = detail::hexValue(string, 8);
+    id.Data2 = static_cast<unsigned short>(detail::hexValue(string + 9, 4));
+    id.Data3 = static_cast<unsigned short>(detail::hexValue(string + 14, 4));
+    id.Data4[0] = static_cast<unsigned char>(detail::hexValue(string + 19, 2));
+    id.Data4[1] = static_cast<unsigned char>(detail::hexValue(string + 21, 2));
+    for (size_t i = 0; i < 6; ++i) {
+        id.Data4[i + 2] = static_cast<unsigned char>(detail::hexValue(string + 24 + 2 * i, 2));
+    }
+
+    return id;
+}
+
+
+/** \brief Initializer list constructor.
+ */
+constexpr Guid::Guid(const GUID &guid):
+    id(guid)
+{}
+
+
+/** \brief Get underlying GUID.
+ */
+constexpr const GUID & Guid::get() const
+{
+    return id;
+}
+
+
+/** \brief Get 64-bit hash of GUID.
+ *
+ *  Both halves are mixed, so sequential GUIDs which differ in only a
+ *  few bytes hash to unrelated values.
+ */
+constexpr uint64_t Guid::hash() const
+{
+    uint64_t low = uint64_t(uint32_t(id.Data1)) | (uint64_t(id.Data2) << 32) | (uint64_t(id.Data3) << 48);
+    uint64_t high = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        high |= uint64_t(id.Data4[i]) << (8 * i);
+    }
+    return detail::mixHash(low ^ detail::mixHash(high));
+}
+
+
+/** \brief Equality operator.
+ */
+constexpr bool operator==(const Guid &left,
+    const Guid &right)
+{
+    return detail::compareGuid(left.id, right.id) == 0;
+}
+
+
+/** \brief Inequality operator.
+ */
+constexpr bool operator!=(const Guid &left,
+    const Guid &right)
+{
+    return !operator==(left, right);
+}
+
+
+/** \brief Less-than operator, ordered like the string representation.
+ */
+constexpr bool operator<(const Guid &left,
+    const Guid &right)
+{
+    return detail::compareGuid(left.id, right.id) < 0;
+}
+
+
+/** \brief Less-than-or-equal-to operator.
+ */
+constexpr bool operator<=(const Guid &left,
+    const Guid &right)
+{
+    return detail::compareGuid(left.id, right.id) <= 0;
+}
+
+
+/** \brief Greater-than operator.
+ */
+constexpr bool operator>(const Guid &left,
+    const Guid &right)
+{
+    return detail::compareGuid(left.id, right.id) > 0;
+}
+
+
+/** \brief Greater-than-or-equal-to operator.
+ */
+constexpr bool operator>=(const Guid &left,
+    const Guid &right)
+{
+    return detail::compareGuid(left.id, right.id) >= 0;
+}
+
+
+inline namespace literals
+{
+
+/** \brief Parse GUID literal at compile time.
+ *
+ *  "{1D23188D-53FE-4C25-B032-DC70ACDBDC02}"_guid
+ */
+constexpr Guid operator"" _guid(const char *string,
+    size_t length)
+{
+    return Guid(parseGuid(string, length));
+}
+
+}   /* literals */
 
 }   /* autocom */
+
+
+namespace std
+{
+// SPECIALIZATION
+// --------------
+
+
+/** \brief Hash Guid with its 64-bit hash.
+ */
+template <>
+struct hash<autocom::Guid>
+{
+    size_t operator()(const autocom::Guid &guid) const
+    {
+        return static_cast<size_t>(guid.hash());
+    }
+};
+
+}   /* std */
@@ -0,0 +1,160 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Memory-mapped SafeArray spill files.
+ *
+ *  `SafeArray<T>::spill` writes the array type, dimensions, bounds
+ *  and data to a self-describing binary file, and `MappedSafeArray<T>`
+ *  maps it back read-only. Mapped pages are clean and file-backed, so
+ *  the operating system may evict them under memory pressure, keeping
+ *  the resident set bounded while iteration stays zero-copy.
+ */
+
+#pragma once
+
+#include <autocom/view.h>
+
+#include <string>
+#include <vector>
+
+
+namespace autocom
+{
+// OBJECTS
+// -------
+
+
+/** \brief Read-only memory mapping of an entire file.
+ */
+class MappedFile
+{
+protected:
+    void *address = nullptr;
+    size_t length = 0;
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile & operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile &&other);
+    MappedFile & operator=(MappedFile &&other);
+    ~MappedFile();
+
+    MappedFile(const std::string &path);
+    void open(const std::string &path);
+    void close();
+
+    // DATA
+    const void * data() const;
+    size_t size() const;
+    bool isOpen() const;
+};
+
+
+/** \brief Parsed layout of a SafeArray spill file.
+ */
+struct SpillLayout
+{
+    VARTYPE vt = VT_EMPTY;
+    ULONG element = 0;
+    const void *data = nullptr;
+    std::vector<SafeArrayBound> bounds;
+};
+
+
+/** \brief Memory-mapped, read-only SafeArray loaded from a spill file.
+ *
+ *  Exposes the SafeArrayView interface, and can be passed wherever a
+ *  `const SafeArrayView<T>&` is expected.
+ */
+template <typename T>
+class MappedSafeArray: public SafeArrayView<T>
+{
+protected:
+    typedef MappedSafeArray<T> This;
+    typedef SafeArrayView<T> Base;
+
+    MappedFile file;
+
+public:
+    MappedSafeArray() = default;
+    MappedSafeArray(const This&) = delete;
+    This & operator=(const This&) = delete;
+    MappedSafeArray(This&&) = default;
+    This & operator=(This&&) = default;
+
+    MappedSafeArray(const std::string &path);
+    void open(const std::string &path);
+    void close();
+    bool isOpen() const;
+
+    const Base & view() const;
+};
+
+// FUNCTIONS
+// ---------
+
+/** \brief Validate and parse the header of a mapped spill file.
+ */
+SpillLayout readSpill(const MappedFile &file);
+
+// IMPLEMENTATION
+// --------------
+
+
+/** \brief Map spill file from path.
+ */
+template <typename T>
+MappedSafeArray<T>::MappedSafeArray(const std::string &path)
+{
+    open(path);
+}
+
+
+/** \brief Map spill file, and check it matches the value type.
+ */
+template <typename T>
+void MappedSafeArray<T>::open(const std::string &path)
+{
+    close();
+    file.open(path);
+
+    auto layout = readSpill(file);
+    if (layout.vt != Base::vt || layout.element != sizeof(T)) {
+        file.close();
+        throw std::invalid_argument("Spill file type does not match MappedSafeArray.");
+    }
+    Base::operator=(Base(reinterpret_cast<const T*>(layout.data), std::move(layout.bounds)));
+}
+
+
+/** \brief Unmap file and reset view.
+ */
+template <typename T>
+void MappedSafeArray<T>::close()
+{
+    Base::operator=(Base());
+    file.close();
+}
+
+
+/** \brief Check if a spill file is mapped.
+ */
+template <typename T>
+bool MappedSafeArray<T>::isOpen() const
+{
+    return file.isOpen();
+}
+
+
+/** \brief Get view over mapped data.
+ */
+template <typename T>
+auto MappedSafeArray<T>::view() const
+    -> const Base &
+{
+    return *this;
+}
+
+}   /* autocom */
@@ -0,0 +1,24 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable dispatch extensions, for non-Windows builds.
+ */
+
+#pragma once
+
+#include <objbase.h>
+
+// OBJECTS
+// -------
+
+
+struct IObjectIdentity: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE IsEqualObject(IUnknown *object) = 0;
+};
+
+// GUIDS
+// -----
+
+extern const IID IID_IObjectIdentity;
@@ -0,0 +1,21 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Define, rather than declare, GUIDs from DEFINE_GUID.
+ *
+ *  Definitions are weak, like `__declspec(selectany)`, so headers
+ *  generated by autocomconf may be included from many sources.
+ */
+
+#pragma once
+
+#include <wtypes.h>
+
+// MACROS
+// ------
+
+#undef DEFINE_GUID
+#define DEFINE_GUID(name, l, w1, w2, b1, b2, b3, b4, b5, b6, b7, b8)   \
+    extern const GUID name __attribute__((weak));                       \
+    const GUID name = {l, w1, w2, {b1, b2, b3, b4, b5, b6, b7, b8}}
@@ -0,0 +1,640 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable OLE Automation interfaces, for non-Windows builds.
+ */
+
+#pragma once
+
+#include <unknwn.h>
+
+// OBJECTS
+// -------
+
+struct ITypeInfo;
+struct ITypeLib;
+struct ITypeComp;
+
+
+/** \brief Tagged union of automation values, with the Windows layout.
+ */
+struct tagVARIANT
+{
+    union
+    {
+        struct
+        {
+            VARTYPE vt;
+            WORD wReserved1;
+            WORD wReserved2;
+            WORD wReserved3;
+            union
+            {
+                LONGLONG llVal;
+                LONG lVal;
+                BYTE bVal;
+                SHORT iVal;
+                FLOAT fltVal;
+                DOUBLE dblVal;
+                VARIANT_BOOL boolVal;
+                SCODE scode;
+                CY cyVal;
+                DATE date;
+                BSTR bstrVal;
+                IUnknown *punkVal;
+                IDispatch *pdispVal;
+                SAFEARRAY *parray;
+                BYTE *pbVal;
+                SHORT *piVal;
+                LONG *plVal;
+                LONGLONG *pllVal;
+                FLOAT *pfltVal;
+                DOUBLE *pdblVal;
+                VARIANT_BOOL *pboolVal;
+                SCODE *pscode;
+                CY *pcyVal;
+                DATE *pdate;
+                BSTR *pbstrVal;
+                IUnknown **ppunkVal;
+                IDispatch **ppdispVal;
+                SAFEARRAY **pparray;
+                VARIANT *pvarVal;
+                PVOID byref;
+                CHAR cVal;
+                USHORT uiVal;
+                ULONG ulVal;
+                ULONGLONG ullVal;
+                INT intVal;
+                UINT uintVal;
+                DECIMAL *pdecVal;
+                CHAR *pcVal;
+                USHORT *puiVal;
+                ULONG *pulVal;
+                ULONGLONG *pullVal;
+                INT *pintVal;
+                UINT *puintVal;
+                struct
+                {
+                    PVOID pvRecord;
+                    IRecordInfo *pRecInfo;
+                };
+            };
+        };
+        DECIMAL decVal;
+    };
+};
+
+typedef VARIANT *LPVARIANT;
+typedef VARIANTARG *LPVARIANTARG;
+
+static_assert(sizeof(VARIANT) == 8 + 2 * sizeof(void*), "Unexpected VARIANT layout.");
+
+
+/** \brief Arguments to IDispatch::Invoke, in reverse order.
+ */
+struct DISPPARAMS
+{
+    VARIANTARG *rgvarg;
+    DISPID *rgdispidNamedArgs;
+    UINT cArgs;
+    UINT cNamedArgs;
+};
+
+
+/** \brief Exception raised by IDispatch::Invoke.
+ */
+struct EXCEPINFO
+{
+    WORD wCode;
+    WORD wReserved;
+    BSTR bstrSource;
+    BSTR bstrDescription;
+    BSTR bstrHelpFile;
+    DWORD dwHelpContext;
+    PVOID pvReserved;
+    HRESULT (STDMETHODCALLTYPE *pfnDeferredFillIn)(EXCEPINFO *);
+    SCODE scode;
+};
+
+typedef EXCEPINFO *LPEXCEPINFO;
+
+// TYPE DESCRIPTIONS
+// -----------------
+
+struct ARRAYDESC;
+
+
+enum TYPEKIND
+{
+    TKIND_ENUM          = 0,
+    TKIND_RECORD        = 1,
+    TKIND_MODULE        = 2,
+    TKIND_INTERFACE     = 3,
+    TKIND_DISPATCH      = 4,
+    TKIND_COCLASS       = 5,
+    TKIND_ALIAS         = 6,
+    TKIND_UNION         = 7,
+    TKIND_MAX           = 8,
+};
+
+
+enum SYSKIND
+{
+    SYS_WIN16           = 0,
+    SYS_WIN32           = 1,
+    SYS_MAC             = 2,
+    SYS_WIN64           = 3,
+};
+
+
+enum CALLCONV
+{
+    CC_FASTCALL         = 0,
+    CC_CDECL            = 1,
+    CC_MSCPASCAL        = 2,
+    CC_PASCAL           = CC_MSCPASCAL,
+    CC_MACPASCAL        = 3,
+    CC_STDCALL          = 4,
+    CC_FPFASTCALL       = 5,
+    CC_SYSCALL          = 6,
+    CC_MPWCDECL         = 7,
+    CC_MPWPASCAL        = 8,
+    CC_MAX              = 9,
+};
+
+
+enum FUNCKIND
+{
+    FUNC_VIRTUAL        = 0,
+    FUNC_PUREVIRTUAL    = 1,
+    FUNC_NONVIRTUAL     = 2,
+    FUNC_STATIC         = 3,
+    FUNC_DISPATCH       = 4,
+};
+
+
+enum INVOKEKIND
+{
+    INVOKE_FUNC             = 1,
+    INVOKE_PROPERTYGET      = 2,
+    INVOKE_PROPERTYPUT      = 4,
+    INVOKE_PROPERTYPUTREF   = 8,
+};
+
+
+enum VARKIND
+{
+    VAR_PERINSTANCE     = 0,
+    VAR_STATIC          = 1,
+    VAR_CONST           = 2,
+    VAR_DISPATCH        = 3,
+};
+
+
+enum DESCKIND
+{
+    DESCKIND_NONE           = 0,
+    DESCKIND_FUNCDESC       = 1,
+    DESCKIND_VARDESC        = 2,
+    DESCKIND_TYPECOMP       = 3,
+    DESCKIND_IMPLICITAPPOBJ = 4,
+    DESCKIND_MAX            = 5,
+};
+
+
+enum REGKIND
+{
+    REGKIND_DEFAULT     = 0,
+    REGKIND_REGISTER    = 1,
+    REGKIND_NONE        = 2,
+};
+
+
+enum TYPEFLAGS
+{
+    TYPEFLAG_FAPPOBJECT     = 0x0001,
+    TYPEFLAG_FCANCREATE     = 0x0002,
+    TYPEFLAG_FLICENSED      = 0x0004,
+    TYPEFLAG_FPREDECLID     = 0x0008,
+    TYPEFLAG_FHIDDEN        = 0x0010,
+    TYPEFLAG_FCONTROL       = 0x0020,
+    TYPEFLAG_FDUAL          = 0x0040,
+    TYPEFLAG_FNONEXTENSIBLE = 0x0080,
+    TYPEFLAG_FOLEAUTOMATION = 0x0100,
+    TYPEFLAG_FRESTRICTED    = 0x0200,
+    TYPEFLAG_FAGGREGATABLE  = 0x0400,
+    TYPEFLAG_FREPLACEABLE   = 0x0800,
+    TYPEFLAG_FDISPATCHABLE  = 0x1000,
+    TYPEFLAG_FREVERSEBIND   = 0x2000,
+    TYPEFLAG_FPROXY         = 0x4000,
+};
+
+
+enum FUNCFLAGS
+{
+    FUNCFLAG_FRESTRICTED        = 0x0001,
+    FUNCFLAG_FSOURCE            = 0x0002,
+    FUNCFLAG_FBINDABLE          = 0x0004,
+    FUNCFLAG_FREQUESTEDIT       = 0x0008,
+    FUNCFLAG_FDISPLAYBIND       = 0x0010,
+    FUNCFLAG_FDEFAULTBIND       = 0x0020,
+    FUNCFLAG_FHIDDEN            = 0x0040,
+    FUNCFLAG_FUSESGETLASTERROR  = 0x0080,
+    FUNCFLAG_FDEFAULTCOLLELEM   = 0x0100,
+    FUNCFLAG_FUIDEFAULT         = 0x0200,
+    FUNCFLAG_FNONBROWSABLE      = 0x0400,
+    FUNCFLAG_FREPLACEABLE       = 0x0800,
+    FUNCFLAG_FIMMEDIATEBIND     = 0x1000,
+};
+
+
+enum VARFLAGS
+{
+    VARFLAG_FREADONLY           = 0x0001,
+    VARFLAG_FSOURCE             = 0x0002,
+    VARFLAG_FBINDABLE           = 0x0004,
+    VARFLAG_FREQUESTEDIT        = 0x0008,
+    VARFLAG_FDISPLAYBIND        = 0x0010,
+    VARFLAG_FDEFAULTBIND        = 0x0020,
+    VARFLAG_FHIDDEN             = 0x0040,
+    VARFLAG_FRESTRICTED         = 0x0080,
+    VARFLAG_FDEFAULTCOLLELEM    = 0x0100,
+    VARFLAG_FUIDEFAULT          = 0x0200,
+    VARFLAG_FNONBROWSABLE       = 0x0400,
+    VARFLAG_FREPLACEABLE        = 0x0800,
+    VARFLAG_FIMMEDIATEBIND      = 0x1000,
+};
+
+
+enum LIBFLAGS
+{
+    LIBFLAG_FRESTRICTED     = 0x01,
+    LIBFLAG_FCONTROL        = 0x02,
+    LIBFLAG_FHIDDEN         = 0x04,
+    LIBFLAG_FHASDISKIMAGE   = 0x08,
+};
+
+#define IMPLTYPEFLAG_FDEFAULT 0x1
+#define IMPLTYPEFLAG_FSOURCE 0x2
+#define IMPLTYPEFLAG_FRESTRICTED 0x4
+#define IMPLTYPEFLAG_FDEFAULTVTABLE 0x8
+
+#define PARAMFLAG_NONE 0x00
+#define PARAMFLAG_FIN 0x01
+#define PARAMFLAG_FOUT 0x02
+#define PARAMFLAG_FLCID 0x04
+#define PARAMFLAG_FRETVAL 0x08
+#define PARAMFLAG_FOPT 0x10
+#define PARAMFLAG_FHASDEFAULT 0x20
+#define PARAMFLAG_FHASCUSTDATA 0x40
+
+#define IDLFLAG_NONE PARAMFLAG_NONE
+#define IDLFLAG_FIN PARAMFLAG_FIN
+#define IDLFLAG_FOUT PARAMFLAG_FOUT
+#define IDLFLAG_FLCID PARAMFLAG_FLCID
+#define IDLFLAG_FRETVAL PARAMFLAG_FRETVAL
+
+
+struct TYPEDESC
+{
+    union
+    {
+        TYPEDESC *lptdesc;
+        ARRAYDESC *lpadesc;
+        HREFTYPE hreftype;
+    };
+    VARTYPE vt;
+};
+
+
+struct ARRAYDESC
+{
+    TYPEDESC tdescElem;
+    USHORT cDims;
+    SAFEARRAYBOUND rgbounds[1];
+};
+
+
+struct PARAMDESCEX
+{
+    ULONG cBytes;
+    VARIANTARG varDefaultValue;
+};
+
+typedef PARAMDESCEX *LPPARAMDESCEX;
+
+
+struct PARAMDESC
+{
+    LPPARAMDESCEX pparamdescex;
+    USHORT wParamFlags;
+};
+
+
+struct IDLDESC
+{
+    ULONG_PTR dwReserved;
+    USHORT wIDLFlags;
+};
+
+
+struct ELEMDESC
+{
+    TYPEDESC tdesc;
+    union
+    {
+        IDLDESC idldesc;
+        PARAMDESC paramdesc;
+    };
+};
+
+
+struct TYPEATTR
+{
+    GUID guid;
+    LCID lcid;
+    DWORD dwReserved;
+    MEMBERID memidConstructor;
+    MEMBERID memidDestructor;
+    LPOLESTR lpstrSchema;
+    ULONG cbSizeInstance;
+    TYPEKIND typekind;
+    WORD cFuncs;
+    WORD cVars;
+    WORD cImplTypes;
+    WORD cbSizeVft;
+    WORD cbAlignment;
+    WORD wTypeFlags;
+    WORD wMajorVerNum;
+    WORD wMinorVerNum;
+    TYPEDESC tdescAlias;
+    IDLDESC idldescType;
+};
+
+
+struct FUNCDESC
+{
+    MEMBERID memid;
+    SCODE *lprgscode;
+    ELEMDESC *lprgelemdescParam;
+    FUNCKIND funckind;
+    INVOKEKIND invkind;
+    CALLCONV callconv;
+    SHORT cParams;
+    SHORT cParamsOpt;
+    SHORT oVft;
+    SHORT cScodes;
+    ELEMDESC elemdescFunc;
+    WORD wFuncFlags;
+};
+
+
+struct VARDESC
+{
+    MEMBERID memid;
+    LPOLESTR lpstrSchema;
+    union
+    {
+        ULONG oInst;
+        VARIANT *lpvarValue;
+    };
+    ELEMDESC elemdescVar;
+    WORD wVarFlags;
+    VARKIND varkind;
+};
+
+
+struct TLIBATTR
+{
+    GUID guid;
+    LCID lcid;
+    SYSKIND syskind;
+    WORD wMajorVerNum;
+    WORD wMinorVerNum;
+    WORD wLibFlags;
+};
+
+
+union BINDPTR
+{
+    FUNCDESC *lpfuncdesc;
+    VARDESC *lpvardesc;
+    ITypeComp *lptcomp;
+};
+
+// INTERFACES
+// ----------
+
+
+struct IDispatch: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfoCount(UINT *count) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfo(UINT index,
+        LCID locale,
+        ITypeInfo **info) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetIDsOfNames(REFIID iid,
+        LPOLESTR *names,
+        UINT count,
+        LCID locale,
+        DISPID *ids) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Invoke(DISPID member,
+        REFIID iid,
+        LCID locale,
+        WORD flags,
+        DISPPARAMS *params,
+        VARIANT *result,
+        EXCEPINFO *exception,
+        UINT *error) = 0;
+};
+
+
+struct IEnumVARIANT: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE Next(ULONG count,
+        VARIANT *items,
+        ULONG *fetched) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Skip(ULONG count) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Reset() = 0;
+    virtual HRESULT STDMETHODCALLTYPE Clone(IEnumVARIANT **ppv) = 0;
+};
+
+
+struct ITypeComp: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE Bind(LPOLESTR name,
+        ULONG hash,
+        WORD flags,
+        ITypeInfo **info,
+        DESCKIND *kind,
+        BINDPTR *bind) = 0;
+    virtual HRESULT STDMETHODCALLTYPE BindType(LPOLESTR name,
+        ULONG hash,
+        ITypeInfo **info,
+        ITypeComp **comp) = 0;
+};
+
+
+struct ITypeInfo: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE GetTypeAttr(TYPEATTR **attr) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeComp(ITypeComp **comp) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetFuncDesc(UINT index,
+        FUNCDESC **desc) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetVarDesc(UINT index,
+        VARDESC **desc) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetNames(MEMBERID member,
+        BSTR *names,
+        UINT maximum,
+        UINT *count) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetRefTypeOfImplType(UINT index,
+        HREFTYPE *type) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetImplTypeFlags(UINT index,
+        INT *flags) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetIDsOfNames(LPOLESTR *names,
+        UINT count,
+        MEMBERID *ids) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Invoke(PVOID instance,
+        MEMBERID member,
+        WORD flags,
+        DISPPARAMS *params,
+        VARIANT *result,
+        EXCEPINFO *exception,
+        UINT *error) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetDocumentation(MEMBERID member,
+        BSTR *name,
+        BSTR *doc,
+        DWORD *context,
+        BSTR *file) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetDllEntry(MEMBERID member,
+        INVOKEKIND kind,
+        BSTR *dll,
+        BSTR *name,
+        WORD *ordinal) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetRefTypeInfo(HREFTYPE type,
+        ITypeInfo **info) = 0;
+    virtual HRESULT STDMETHODCALLTYPE AddressOfMember(MEMBERID member,
+        INVOKEKIND kind,
+        PVOID *ppv) = 0;
+    virtual HRESULT STDMETHODCALLTYPE CreateInstance(IUnknown *outer,
+        REFIID iid,
+        PVOID *ppv) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetMops(MEMBERID member,
+        BSTR *mops) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetContainingTypeLib(ITypeLib **tlib,
+        UINT *index) = 0;
+    virtual void STDMETHODCALLTYPE ReleaseTypeAttr(TYPEATTR *attr) = 0;
+    virtual void STDMETHODCALLTYPE ReleaseFuncDesc(FUNCDESC *desc) = 0;
+    virtual void STDMETHODCALLTYPE ReleaseVarDesc(VARDESC *desc) = 0;
+};
+
+
+struct ITypeLib: IUnknown
+{
+    virtual UINT STDMETHODCALLTYPE GetTypeInfoCount() = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfo(UINT index,
+        ITypeInfo **info) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfoType(UINT index,
+        TYPEKIND *kind) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfoOfGuid(REFGUID guid,
+        ITypeInfo **info) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetLibAttr(TLIBATTR **attr) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeComp(ITypeComp **comp) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetDocumentation(INT index,
+        BSTR *name,
+        BSTR *doc,
+        DWORD *context,
+        BSTR *file) = 0;
+    virtual HRESULT STDMETHODCALLTYPE IsName(LPOLESTR name,
+        ULONG hash,
+        BOOL *found) = 0;
+    virtual HRESULT STDMETHODCALLTYPE FindName(LPOLESTR name,
+        ULONG hash,
+        ITypeInfo **info,
+        MEMBERID *members,
+        USHORT *found) = 0;
+    virtual void STDMETHODCALLTYPE ReleaseTLibAttr(TLIBATTR *attr) = 0;
+};
+
+
+struct IRecordInfo: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE RecordInit(PVOID record) = 0;
+    virtual HRESULT STDMETHODCALLTYPE RecordClear(PVOID record) = 0;
+    virtual HRESULT STDMETHODCALLTYPE RecordCopy(PVOID source,
+        PVOID destination) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetGuid(GUID *guid) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetName(BSTR *name) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetSize(ULONG *size) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfo(ITypeInfo **info) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetField(PVOID data,
+        LPCOLESTR name,
+        VARIANT *field) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetFieldNoCopy(PVOID data,
+        LPCOLESTR name,
+        VARIANT *field,
+        PVOID *array) = 0;
+    virtual HRESULT STDMETHODCALLTYPE PutField(ULONG flags,
+        PVOID data,
+        LPCOLESTR name,
+        VARIANT *field) = 0;
+    virtual HRESULT STDMETHODCALLTYPE PutFieldNoCopy(ULONG flags,
+        PVOID data,
+        LPCOLESTR name,
+        VARIANT *field) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetFieldNames(ULONG *count,
+        BSTR *names) = 0;
+    virtual BOOL STDMETHODCALLTYPE IsMatchingType(IRecordInfo *info) = 0;
+    virtual PVOID STDMETHODCALLTYPE RecordCreate() = 0;
+    virtual HRESULT STDMETHODCALLTYPE RecordCreateCopy(PVOID source,
+        PVOID *destination) = 0;
+    virtual HRESULT STDMETHODCALLTYPE RecordDestroy(PVOID record) = 0;
+};
+
+
+struct IErrorInfo: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE GetGUID(GUID *guid) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetSource(BSTR *source) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetDescription(BSTR *description) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetHelpFile(BSTR *file) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetHelpContext(DWORD *context) = 0;
+};
+
+
+struct ISupportErrorInfo: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE InterfaceSupportsErrorInfo(REFIID iid) = 0;
+};
+
+// CONSTANTS
+// ---------
+
+#define DISPATCH_METHOD 0x1
+#define DISPATCH_PROPERTYGET 0x2
+#define DISPATCH_PROPERTYPUT 0x4
+#define DISPATCH_PROPERTYPUTREF 0x8
+
+#define DISPID_UNKNOWN (-1)
+#define DISPID_VALUE 0
+#define DISPID_PROPERTYPUT (-3)
+#define DISPID_NEWENUM (-4)
+#define DISPID_EVALUATE (-5)
+#define DISPID_CONSTRUCTOR (-6)
+#define DISPID_DESTRUCTOR (-7)
+#define DISPID_COLLECT (-8)
+#define MEMBERID_NIL DISPID_UNKNOWN
+
+// GUIDS
+// -----
+
+extern const IID IID_IDispatch;
+extern const IID IID_IEnumVARIANT;
+extern const IID IID_ITypeComp;
+extern const IID IID_ITypeInfo;
+extern const IID IID_ITypeLib;
+extern const IID IID_IRecordInfo;
+extern const IID IID_IErrorInfo;
+extern const IID IID_ISupportErrorInfo;
+
+#include <oleauto.h>
@@ -0,0 +1,79 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable COM runtime, for non-Windows builds.
+ *
+ *  There are no apartments, proxies or registry outside of Windows:
+ *  initialization only counts calls per thread, class activation
+ *  only knows the standard Global Interface Table, which hands out
+ *  the registered object itself, and ProgID lookups fail with
+ *  REGDB_E_CLASSNOTREG or CO_E_CLASSSTRING.
+ */
+
+#pragma once
+
+#include <oaidl.h>
+#include <objidl.h>
+
+// ENUMS
+// -----
+
+
+enum COINIT
+{
+    COINIT_MULTITHREADED        = 0x0,
+    COINIT_APARTMENTTHREADED    = 0x2,
+    COINIT_DISABLE_OLE1DDE      = 0x4,
+    COINIT_SPEED_OVER_MEMORY    = 0x8,
+};
+
+
+enum CLSCTX
+{
+    CLSCTX_INPROC_SERVER    = 0x1,
+    CLSCTX_INPROC_HANDLER   = 0x2,
+    CLSCTX_LOCAL_SERVER     = 0x4,
+    CLSCTX_REMOTE_SERVER    = 0x10,
+    CLSCTX_SERVER           = 0x15,
+    CLSCTX_ALL              = 0x17,
+};
+
+// FUNCTIONS
+// ---------
+
+HRESULT CoInitialize(LPVOID reserved);
+HRESULT CoInitializeEx(LPVOID reserved,
+    DWORD flags);
+void CoUninitialize();
+HRESULT CoCreateInstance(REFCLSID clsid,
+    LPUNKNOWN outer,
+    DWORD context,
+    REFIID iid,
+    LPVOID *ppv);
+
+LPVOID CoTaskMemAlloc(size_t size);
+LPVOID CoTaskMemRealloc(LPVOID pointer,
+    size_t size);
+void CoTaskMemFree(LPVOID pointer);
+
+HRESULT CLSIDFromProgID(LPCOLESTR progid,
+    LPCLSID clsid);
+HRESULT ProgIDFromCLSID(REFCLSID clsid,
+    LPOLESTR *progid);
+HRESULT CLSIDFromString(LPCOLESTR string,
+    LPCLSID clsid);
+HRESULT StringFromCLSID(REFCLSID clsid,
+    LPOLESTR *string);
+HRESULT IIDFromString(LPCOLESTR string,
+    LPIID iid);
+HRESULT StringFromIID(REFIID iid,
+    LPOLESTR *string);
+int StringFromGUID2(REFGUID guid,
+    LPOLESTR string,
+    int length);
+
+// GUIDS
+// -----
+
+extern const CLSID CLSID_StdGlobalInterfaceTable;
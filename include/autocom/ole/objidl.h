@@ -0,0 +1,40 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable COM object interfaces, for non-Windows builds.
+ */
+
+#pragma once
+
+#include <unknwn.h>
+
+// OBJECTS
+// -------
+
+
+struct IGlobalInterfaceTable: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE RegisterInterfaceInGlobal(IUnknown *object,
+        REFIID iid,
+        DWORD *cookie) = 0;
+    virtual HRESULT STDMETHODCALLTYPE RevokeInterfaceFromGlobal(DWORD cookie) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetInterfaceFromGlobal(DWORD cookie,
+        REFIID iid,
+        void **ppv) = 0;
+};
+
+
+struct IClassFactory: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE CreateInstance(IUnknown *outer,
+        REFIID iid,
+        void **ppv) = 0;
+    virtual HRESULT STDMETHODCALLTYPE LockServer(BOOL lock) = 0;
+};
+
+// GUIDS
+// -----
+
+extern const IID IID_IGlobalInterfaceTable;
+extern const IID IID_IClassFactory;
@@ -0,0 +1,80 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable connection point interfaces, for non-Windows builds.
+ */
+
+#pragma once
+
+#include <oaidl.h>
+
+// OBJECTS
+// -------
+
+struct IConnectionPointContainer;
+
+
+struct CONNECTDATA
+{
+    IUnknown *pUnk;
+    DWORD dwCookie;
+};
+
+typedef CONNECTDATA *LPCONNECTDATA;
+
+
+struct IEnumConnections: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE Next(ULONG count,
+        CONNECTDATA *connections,
+        ULONG *fetched) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Skip(ULONG count) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Reset() = 0;
+    virtual HRESULT STDMETHODCALLTYPE Clone(IEnumConnections **ppv) = 0;
+};
+
+
+struct IConnectionPoint: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE GetConnectionInterface(IID *iid) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetConnectionPointContainer(IConnectionPointContainer **container) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Advise(IUnknown *sink,
+        DWORD *cookie) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Unadvise(DWORD cookie) = 0;
+    virtual HRESULT STDMETHODCALLTYPE EnumConnections(IEnumConnections **connections) = 0;
+};
+
+
+struct IEnumConnectionPoints: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE Next(ULONG count,
+        IConnectionPoint **points,
+        ULONG *fetched) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Skip(ULONG count) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Reset() = 0;
+    virtual HRESULT STDMETHODCALLTYPE Clone(IEnumConnectionPoints **ppv) = 0;
+};
+
+
+struct IConnectionPointContainer: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE EnumConnectionPoints(IEnumConnectionPoints **points) = 0;
+    virtual HRESULT STDMETHODCALLTYPE FindConnectionPoint(REFIID iid,
+        IConnectionPoint **point) = 0;
+};
+
+
+struct IProvideClassInfo: IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE GetClassInfo(ITypeInfo **info) = 0;
+};
+
+// GUIDS
+// -----
+
+extern const IID IID_IConnectionPointContainer;
+extern const IID IID_IConnectionPoint;
+extern const IID IID_IEnumConnections;
+extern const IID IID_IEnumConnectionPoints;
+extern const IID IID_IProvideClassInfo;
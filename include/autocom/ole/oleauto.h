@@ -0,0 +1,147 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable OLE Automation API, for non-Windows builds.
+ *
+ *  BSTRs and SAFEARRAYs use the Windows memory layout, with the
+ *  allocations served from per-thread caches of fixed size classes.
+ *  Type libraries and the registry are unavailable, and the related
+ *  functions fail with the documented HRESULT.
+ */
+
+#pragma once
+
+#include <oaidl.h>
+
+// CONSTANTS
+// ---------
+
+#define VARIANT_NOVALUEPROP 0x01
+#define VARIANT_ALPHABOOL 0x02
+#define VARIANT_NOUSEROVERRIDE 0x04
+#define VARIANT_LOCALBOOL 0x10
+
+// BSTR
+// ----
+
+BSTR SysAllocString(const OLECHAR *string);
+BSTR SysAllocStringLen(const OLECHAR *string,
+    UINT length);
+BSTR SysAllocStringByteLen(LPCSTR string,
+    UINT length);
+INT SysReAllocStringLen(BSTR *bstr,
+    const OLECHAR *string,
+    UINT length);
+void SysFreeString(BSTR string);
+UINT SysStringLen(BSTR string);
+UINT SysStringByteLen(BSTR string);
+
+// VARIANT
+// -------
+
+void VariantInit(VARIANTARG *variant);
+HRESULT VariantClear(VARIANTARG *variant);
+HRESULT VariantCopy(VARIANTARG *destination,
+    const VARIANTARG *source);
+HRESULT VariantCopyInd(VARIANT *destination,
+    const VARIANTARG *source);
+HRESULT VariantChangeType(VARIANTARG *destination,
+    const VARIANTARG *source,
+    USHORT flags,
+    VARTYPE vt);
+HRESULT VariantChangeTypeEx(VARIANTARG *destination,
+    const VARIANTARG *source,
+    LCID locale,
+    USHORT flags,
+    VARTYPE vt);
+
+// SAFEARRAY
+// ---------
+
+SAFEARRAY * SafeArrayCreate(VARTYPE vt,
+    UINT dimensions,
+    SAFEARRAYBOUND *bounds);
+SAFEARRAY * SafeArrayCreateEx(VARTYPE vt,
+    UINT dimensions,
+    SAFEARRAYBOUND *bounds,
+    PVOID extra);
+SAFEARRAY * SafeArrayCreateVector(VARTYPE vt,
+    LONG lower,
+    ULONG elements);
+HRESULT SafeArrayAllocDescriptor(UINT dimensions,
+    SAFEARRAY **out);
+HRESULT SafeArrayAllocDescriptorEx(VARTYPE vt,
+    UINT dimensions,
+    SAFEARRAY **out);
+HRESULT SafeArrayAllocData(SAFEARRAY *array);
+HRESULT SafeArrayDestroyDescriptor(SAFEARRAY *array);
+HRESULT SafeArrayDestroyData(SAFEARRAY *array);
+HRESULT SafeArrayDestroy(SAFEARRAY *array);
+HRESULT SafeArrayCopy(SAFEARRAY *array,
+    SAFEARRAY **out);
+HRESULT SafeArrayCopyData(SAFEARRAY *source,
+    SAFEARRAY *destination);
+HRESULT SafeArrayRedim(SAFEARRAY *array,
+    SAFEARRAYBOUND *bound);
+UINT SafeArrayGetDim(SAFEARRAY *array);
+UINT SafeArrayGetElemsize(SAFEARRAY *array);
+HRESULT SafeArrayGetUBound(SAFEARRAY *array,
+    UINT dimension,
+    LONG *bound);
+HRESULT SafeArrayGetLBound(SAFEARRAY *array,
+    UINT dimension,
+    LONG *bound);
+HRESULT SafeArrayLock(SAFEARRAY *array);
+HRESULT SafeArrayUnlock(SAFEARRAY *array);
+HRESULT SafeArrayAccessData(SAFEARRAY *array,
+    void **data);
+HRESULT SafeArrayUnaccessData(SAFEARRAY *array);
+HRESULT SafeArrayPtrOfIndex(SAFEARRAY *array,
+    LONG *indices,
+    void **data);
+HRESULT SafeArrayGetElement(SAFEARRAY *array,
+    LONG *indices,
+    void *value);
+HRESULT SafeArrayPutElement(SAFEARRAY *array,
+    LONG *indices,
+    void *value);
+HRESULT SafeArrayGetVartype(SAFEARRAY *array,
+    VARTYPE *vt);
+HRESULT SafeArraySetRecordInfo(SAFEARRAY *array,
+    IRecordInfo *info);
+HRESULT SafeArrayGetRecordInfo(SAFEARRAY *array,
+    IRecordInfo **info);
+HRESULT SafeArraySetIID(SAFEARRAY *array,
+    REFGUID iid);
+HRESULT SafeArrayGetIID(SAFEARRAY *array,
+    GUID *iid);
+
+// TYPE LIBRARIES
+// --------------
+
+HRESULT GetRecordInfoFromTypeInfo(ITypeInfo *info,
+    IRecordInfo **record);
+HRESULT LoadTypeLib(LPCOLESTR file,
+    ITypeLib **tlib);
+HRESULT LoadTypeLibEx(LPCOLESTR file,
+    REGKIND kind,
+    ITypeLib **tlib);
+HRESULT LoadRegTypeLib(REFGUID guid,
+    WORD major,
+    WORD minor,
+    LCID locale,
+    ITypeLib **tlib);
+HRESULT QueryPathOfRegTypeLib(REFGUID guid,
+    USHORT major,
+    USHORT minor,
+    LCID locale,
+    BSTR *path);
+
+// ERRORS
+// ------
+
+HRESULT GetErrorInfo(ULONG reserved,
+    IErrorInfo **info);
+HRESULT SetErrorInfo(ULONG reserved,
+    IErrorInfo *info);
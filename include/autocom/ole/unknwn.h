@@ -0,0 +1,32 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable IUnknown, for non-Windows builds.
+ *
+ *  Interfaces are abstract classes with the methods in vtable order,
+ *  which the Itanium C++ ABI lays out like a COM vtable.
+ */
+
+#pragma once
+
+#include <wtypes.h>
+
+// OBJECTS
+// -------
+
+
+struct IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) = 0;
+    virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+    virtual ULONG STDMETHODCALLTYPE Release() = 0;
+};
+
+typedef IUnknown *LPUNKNOWN;
+
+// GUIDS
+// -----
+
+extern const IID IID_IUnknown;
@@ -0,0 +1,10 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable subset of the Windows API, for non-Windows builds.
+ */
+
+#pragma once
+
+#include <objbase.h>
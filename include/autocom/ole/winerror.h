@@ -0,0 +1,84 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable HRESULT codes, for non-Windows builds.
+ */
+
+#pragma once
+
+#include <wtypes.h>
+
+// MACROS
+// ------
+
+#define SEVERITY_SUCCESS 0
+#define SEVERITY_ERROR 1
+#define FACILITY_NULL 0
+#define FACILITY_RPC 1
+#define FACILITY_DISPATCH 2
+#define FACILITY_ITF 4
+#define FACILITY_WIN32 7
+
+#define MAKE_HRESULT(sev, fac, code)                                    \
+    ((HRESULT) (((uint32_t) (sev) << 31) | ((uint32_t) (fac) << 16) | ((uint32_t) (code))))
+#define HRESULT_CODE(hr) ((hr) & 0xFFFF)
+#define HRESULT_FACILITY(hr) (((hr) >> 16) & 0x1FFF)
+#define HRESULT_SEVERITY(hr) (((hr) >> 31) & 0x1)
+#define HRESULT_FROM_WIN32(x)                                           \
+    ((HRESULT) (x) <= 0 ? ((HRESULT) (x)) : ((HRESULT) (((x) & 0x0000FFFF) | (FACILITY_WIN32 << 16) | 0x80000000)))
+
+// CONSTANTS
+// ---------
+
+#define S_OK ((HRESULT) 0x00000000)
+#define S_FALSE ((HRESULT) 0x00000001)
+#define NOERROR S_OK
+
+#define E_NOTIMPL ((HRESULT) 0x80004001)
+#define E_NOINTERFACE ((HRESULT) 0x80004002)
+#define E_POINTER ((HRESULT) 0x80004003)
+#define E_ABORT ((HRESULT) 0x80004004)
+#define E_FAIL ((HRESULT) 0x80004005)
+#define E_UNEXPECTED ((HRESULT) 0x8000FFFF)
+#define E_ACCESSDENIED ((HRESULT) 0x80070005)
+#define E_HANDLE ((HRESULT) 0x80070006)
+#define E_OUTOFMEMORY ((HRESULT) 0x8007000E)
+#define E_INVALIDARG ((HRESULT) 0x80070057)
+
+#define CLASS_E_NOAGGREGATION ((HRESULT) 0x80040110)
+#define CLASS_E_CLASSNOTAVAILABLE ((HRESULT) 0x80040111)
+#define CONNECT_E_NOCONNECTION ((HRESULT) 0x80040200)
+#define CONNECT_E_ADVISELIMIT ((HRESULT) 0x80040201)
+#define CONNECT_E_CANNOTCONNECT ((HRESULT) 0x80040202)
+#define REGDB_E_CLASSNOTREG ((HRESULT) 0x80040154)
+#define REGDB_E_IIDNOTREG ((HRESULT) 0x80040155)
+#define CO_E_NOTINITIALIZED ((HRESULT) 0x800401F0)
+#define CO_E_CLASSSTRING ((HRESULT) 0x800401F3)
+#define CO_E_IIDSTRING ((HRESULT) 0x800401F4)
+#define RPC_E_CHANGED_MODE ((HRESULT) 0x80010106)
+#define RPC_E_WRONG_THREAD ((HRESULT) 0x8001010E)
+
+#define DISP_E_UNKNOWNINTERFACE ((HRESULT) 0x80020001)
+#define DISP_E_MEMBERNOTFOUND ((HRESULT) 0x80020003)
+#define DISP_E_PARAMNOTFOUND ((HRESULT) 0x80020004)
+#define DISP_E_TYPEMISMATCH ((HRESULT) 0x80020005)
+#define DISP_E_UNKNOWNNAME ((HRESULT) 0x80020006)
+#define DISP_E_NONAMEDARGS ((HRESULT) 0x80020007)
+#define DISP_E_BADVARTYPE ((HRESULT) 0x80020008)
+#define DISP_E_EXCEPTION ((HRESULT) 0x80020009)
+#define DISP_E_OVERFLOW ((HRESULT) 0x8002000A)
+#define DISP_E_BADINDEX ((HRESULT) 0x8002000B)
+#define DISP_E_UNKNOWNLCID ((HRESULT) 0x8002000C)
+#define DISP_E_ARRAYISLOCKED ((HRESULT) 0x8002000D)
+#define DISP_E_BADPARAMCOUNT ((HRESULT) 0x8002000E)
+#define DISP_E_PARAMNOTOPTIONAL ((HRESULT) 0x8002000F)
+#define DISP_E_BADCALLEE ((HRESULT) 0x80020010)
+#define DISP_E_NOTACOLLECTION ((HRESULT) 0x80020011)
+#define DISP_E_DIVBYZERO ((HRESULT) 0x80020012)
+
+#define TYPE_E_LIBNOTREGISTERED ((HRESULT) 0x8002801D)
+#define TYPE_E_WRONGTYPEKIND ((HRESULT) 0x8002802A)
+#define TYPE_E_ELEMENTNOTFOUND ((HRESULT) 0x8002802B)
+#define TYPE_E_BADMODULEKIND ((HRESULT) 0x800288BD)
+#define TYPE_E_CANTLOADLIBRARY ((HRESULT) 0x80029C4A)
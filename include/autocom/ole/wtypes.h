@@ -0,0 +1,346 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable OLE Automation base types, for non-Windows builds.
+ *
+ *  The shim headers in this directory stand in for the Windows SDK
+ *  headers of the same name, and are only on the include path when
+ *  building outside of Windows. Integer types keep their Windows
+ *  widths, so VARIANT, SAFEARRAY, DECIMAL and GUID have the same
+ *  layout as under the LLP64 data model. OLECHAR is `wchar_t`, to stay
+ *  source-compatible with the wide-string overloads, and is therefore
+ *  4 bytes wide on Linux.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// MACROS
+// ------
+
+#define STDMETHODCALLTYPE
+#define WINAPI
+#define CALLBACK
+
+#define FAILED(hr) (static_cast<HRESULT>(hr) < 0)
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+
+#define LOWORD(l) ((WORD) (((ULONG_PTR) (l)) & 0xffff))
+#define HIWORD(l) ((WORD) ((((ULONG_PTR) (l)) >> 16) & 0xffff))
+#define LOBYTE(w) ((BYTE) (((ULONG_PTR) (w)) & 0xff))
+#define HIBYTE(w) ((BYTE) ((((ULONG_PTR) (w)) >> 8) & 0xff))
+#define MAKEWORD(a, b) ((WORD) (((BYTE) (a)) | (((WORD) ((BYTE) (b))) << 8)))
+#define MAKELONG(a, b) ((LONG) (((WORD) (a)) | (((DWORD) ((WORD) (b))) << 16)))
+
+/** LONG is 32 bits outside of Windows, so it is the same type as
+ *  INT, and ULONG is UINT. Overloads and specializations for INT and
+ *  UINT must be omitted, leaving VT_I4 and VT_UI4.
+ */
+#define AUTOCOM_LONG_IS_INT
+
+// TYPES
+// -----
+
+typedef void VOID;
+typedef void *PVOID;
+typedef void *LPVOID;
+typedef void *HANDLE;
+typedef int BOOL;
+typedef char CHAR;
+typedef unsigned char UCHAR;
+typedef unsigned char BYTE;
+typedef short SHORT;
+typedef unsigned short USHORT;
+typedef unsigned short WORD;
+typedef int INT;
+typedef unsigned int UINT;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef uint32_t DWORD;
+typedef long long LONGLONG;
+typedef unsigned long long ULONGLONG;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t ULONG_PTR;
+typedef uintptr_t UINT_PTR;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef float FLOAT;
+typedef double DOUBLE;
+
+typedef char *LPSTR;
+typedef const char *LPCSTR;
+typedef wchar_t WCHAR;
+typedef WCHAR *LPWSTR;
+typedef const WCHAR *LPCWSTR;
+typedef WCHAR OLECHAR;
+typedef OLECHAR *LPOLESTR;
+typedef const OLECHAR *LPCOLESTR;
+typedef OLECHAR *BSTR;
+
+typedef LONG HRESULT;
+typedef LONG SCODE;
+typedef DWORD LCID;
+typedef LONG DISPID;
+typedef DISPID MEMBERID;
+typedef DWORD HREFTYPE;
+typedef unsigned short VARTYPE;
+typedef short VARIANT_BOOL;
+typedef double DATE;
+
+static_assert(sizeof(LONG) == 4, "LONG must be 32 bits.");
+static_assert(sizeof(LONGLONG) == 8, "LONGLONG must be 64 bits.");
+
+// CONSTANTS
+// ---------
+
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+
+#define VARIANT_TRUE ((VARIANT_BOOL) -1)
+#define VARIANT_FALSE ((VARIANT_BOOL) 0)
+
+#define LOCALE_NEUTRAL 0x0000
+#define LOCALE_USER_DEFAULT 0x0400
+#define LOCALE_SYSTEM_DEFAULT 0x0800
+
+// OBJECTS
+// -------
+
+
+/** \brief Globally unique identifier, with the Windows layout.
+ */
+struct GUID
+{
+    uint32_t Data1;
+    uint16_t Data2;
+    uint16_t Data3;
+    uint8_t Data4[8];
+};
+
+typedef GUID IID;
+typedef GUID CLSID;
+typedef IID *LPIID;
+typedef CLSID *LPCLSID;
+typedef const GUID &REFGUID;
+typedef const IID &REFIID;
+typedef const CLSID &REFCLSID;
+
+
+/** \brief Fixed-point currency, scaled by 10,000.
+ */
+union CY
+{
+    struct
+    {
+        ULONG Lo;
+        LONG Hi;
+    };
+    LONGLONG int64;
+};
+
+typedef CY CURRENCY;
+
+
+/** \brief 96-bit unsigned integer, with a sign and a decimal scale.
+ *
+ *  The first word overlaps VARIANT::vt, when stored in a VARIANT.
+ */
+struct DECIMAL
+{
+    USHORT wReserved;
+    union
+    {
+        struct
+        {
+            BYTE scale;
+            BYTE sign;
+        };
+        USHORT signscale;
+    };
+    ULONG Hi32;
+    union
+    {
+        struct
+        {
+            ULONG Lo32;
+            ULONG Mid32;
+        };
+        ULONGLONG Lo64;
+    };
+};
+
+#define DECIMAL_NEG ((BYTE) 0x80)
+
+
+/** \brief Bounds of a single SAFEARRAY dimension.
+ */
+struct SAFEARRAYBOUND
+{
+    ULONG cElements;
+    LONG lLbound;
+};
+
+typedef SAFEARRAYBOUND *LPSAFEARRAYBOUND;
+
+
+/** \brief Self-describing array, with bounds stored in reverse order.
+ */
+struct SAFEARRAY
+{
+    USHORT cDims;
+    USHORT fFeatures;
+    ULONG cbElements;
+    ULONG cLocks;
+    PVOID pvData;
+    SAFEARRAYBOUND rgsabound[1];
+};
+
+typedef SAFEARRAY *LPSAFEARRAY;
+
+// FORWARD
+// -------
+
+struct IUnknown;
+struct IDispatch;
+struct IRecordInfo;
+struct tagVARIANT;
+typedef tagVARIANT VARIANT;
+typedef tagVARIANT VARIANTARG;
+
+// ENUMS
+// -----
+
+
+/** \brief Variant and SAFEARRAY element types.
+ */
+enum VARENUM
+{
+    VT_EMPTY            = 0,
+    VT_NULL             = 1,
+    VT_I2               = 2,
+    VT_I4               = 3,
+    VT_R4               = 4,
+    VT_R8               = 5,
+    VT_CY               = 6,
+    VT_DATE             = 7,
+    VT_BSTR             = 8,
+    VT_DISPATCH         = 9,
+    VT_ERROR            = 10,
+    VT_BOOL             = 11,
+    VT_VARIANT          = 12,
+    VT_UNKNOWN          = 13,
+    VT_DECIMAL          = 14,
+    VT_I1               = 16,
+    VT_UI1              = 17,
+    VT_UI2              = 18,
+    VT_UI4              = 19,
+    VT_I8               = 20,
+    VT_UI8              = 21,
+    VT_INT              = 22,
+    VT_UINT             = 23,
+    VT_VOID             = 24,
+    VT_HRESULT          = 25,
+    VT_PTR              = 26,
+    VT_SAFEARRAY        = 27,
+    VT_CARRAY           = 28,
+    VT_USERDEFINED      = 29,
+    VT_LPSTR            = 30,
+    VT_LPWSTR           = 31,
+    VT_RECORD           = 36,
+    VT_INT_PTR          = 37,
+    VT_UINT_PTR         = 38,
+    VT_FILETIME         = 64,
+    VT_BLOB             = 65,
+    VT_STREAM           = 66,
+    VT_STORAGE          = 67,
+    VT_STREAMED_OBJECT  = 68,
+    VT_STORED_OBJECT    = 69,
+    VT_BLOB_OBJECT      = 70,
+    VT_CF               = 71,
+    VT_CLSID            = 72,
+    VT_VERSIONED_STREAM = 73,
+    VT_BSTR_BLOB        = 0xfff,
+    VT_VECTOR           = 0x1000,
+    VT_ARRAY            = 0x2000,
+    VT_BYREF            = 0x4000,
+    VT_RESERVED         = 0x8000,
+    VT_ILLEGAL          = 0xffff,
+    VT_ILLEGALMASKED    = 0xfff,
+    VT_TYPEMASK         = 0xfff,
+};
+
+
+/** \brief SAFEARRAY feature flags.
+ */
+enum
+{
+    FADF_AUTO           = 0x0001,
+    FADF_STATIC         = 0x0002,
+    FADF_EMBEDDED       = 0x0004,
+    FADF_FIXEDSIZE      = 0x0010,
+    FADF_RECORD         = 0x0020,
+    FADF_HAVEIID        = 0x0040,
+    FADF_HAVEVARTYPE    = 0x0080,
+    FADF_BSTR           = 0x0100,
+    FADF_UNKNOWN        = 0x0200,
+    FADF_DISPATCH       = 0x0400,
+    FADF_VARIANT        = 0x0800,
+    FADF_RESERVED       = 0xF008,
+};
+
+// FUNCTIONS
+// ---------
+
+
+inline bool IsEqualGUID(REFGUID left,
+    REFGUID right)
+{
+    return std::memcmp(&left, &right, sizeof(GUID)) == 0;
+}
+
+
+inline bool IsEqualIID(REFIID left,
+    REFIID right)
+{
+    return IsEqualGUID(left, right);
+}
+
+
+inline bool IsEqualCLSID(REFCLSID left,
+    REFCLSID right)
+{
+    return IsEqualGUID(left, right);
+}
+
+
+inline bool operator==(REFGUID left,
+    REFGUID right)
+{
+    return IsEqualGUID(left, right);
+}
+
+
+inline bool operator!=(REFGUID left,
+    REFGUID right)
+{
+    return !IsEqualGUID(left, right);
+}
+
+// GUIDS
+// -----
+
+#ifndef DEFINE_GUID
+#   define DEFINE_GUID(name, l, w1, w2, b1, b2, b3, b4, b5, b6, b7, b8) \
+        extern const GUID name
+#endif
+
+extern const GUID GUID_NULL;
+extern const IID IID_NULL;
+extern const CLSID CLSID_NULL;
+
+#include <winerror.h>
@@ -0,0 +1,533 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Parallel element-wise algorithms over SafeArray data.
+ *
+ *  Locked array data is split into cache-line-aligned chunks, which
+ *  are scheduled on a work-stealing thread pool. Reductions over
+ *  `float`, `double` and 32-bit integers use SIMD kernels where the
+ *  target supports AVX2.
+ */
+
+#pragma once
+
+#include <autocom/view.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace autocom
+{
+namespace parallel
+{
+// OBJECTS
+// -------
+
+struct WorkQueue;
+
+
+/** \brief Half-open range of element indexes.
+ */
+struct Chunk
+{
+    size_t begin;
+    size_t end;
+};
+
+
+/** \brief Fixed-size, work-stealing thread pool.
+ *
+ *  Each worker owns a queue of task indexes, pops from the front of
+ *  its own queue, and steals from the back of other queues when idle.
+ *  The calling thread participates as a worker, and nested calls from
+ *  within a task run serially.
+ */
+class ThreadPool
+{
+protected:
+    typedef std::function<void(size_t)> Task;
+
+    struct Job
+    {
+        const Task *task;
+        std::atomic<size_t> remaining;
+        std::exception_ptr error;
+    };
+
+    std::vector<std::thread> threads;
+    std::unique_ptr<WorkQueue[]> queues;
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    Job *job = nullptr;
+    size_t generation = 0;
+    size_t active = 0;
+    bool stop = false;
+
+    void worker(const size_t index);
+    void work(Job &job, const size_t index);
+    bool pop(const size_t index, size_t &task);
+
+public:
+    explicit ThreadPool(size_t size = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool & operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    size_t size() const;
+    void run(const size_t count, const Task &task);
+
+    static ThreadPool & global();
+};
+
+// FUNCTIONS
+// ---------
+
+/** \brief Split elements into cache-line-aligned chunks.
+ *
+ *  Every chunk after the first begins on a 64-byte boundary, and
+ *  chunks are sized to give each thread several chunks to balance
+ *  load through stealing.
+ */
+std::vector<Chunk> chunks(const void *data,
+    const size_t count,
+    const size_t element,
+    const size_t threads);
+
+// KERNELS
+// -------
+
+namespace kernel
+{
+
+/** \brief Accumulator type for sums.
+ */
+template <typename T>
+using Accumulator = typename std::conditional<
+    std::is_floating_point<T>::value,
+    double,
+    typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type
+>::type;
+
+
+/** \brief Canonical type for kernel dispatch, mapping 32-bit signed
+ *  integers (INT, LONG) to a single type.
+ */
+template <typename T>
+using Canonical = typename std::conditional<
+    std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) == 4,
+    int32_t,
+    T
+>::type;
+
+
+/** \brief Sum elements.
+ */
+template <typename T>
+Accumulator<T> sum(const T *data,
+    const size_t count)
+{
+    Accumulator<T> total[4] = {};
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        total[0] += data[i];
+        total[1] += data[i+1];
+        total[2] += data[i+2];
+        total[3] += data[i+3];
+    }
+    for (; i < count; ++i) {
+        total[0] += data[i];
+    }
+
+    return (total[0] + total[1]) + (total[2] + total[3]);
+}
+
+
+/** \brief Minimum element, ignoring NaN. Requires a non-empty range.
+ */
+template <typename T>
+T minimum(const T *data,
+    const size_t count)
+{
+    T best = data[0];
+    for (size_t i = 1; i < count; ++i) {
+        if (data[i] < best || best != best) {
+            best = data[i];
+        }
+    }
+    return best;
+}
+
+
+/** \brief Maximum element, ignoring NaN. Requires a non-empty range.
+ */
+template <typename T>
+T maximum(const T *data,
+    const size_t count)
+{
+    T best = data[0];
+    for (size_t i = 1; i < count; ++i) {
+        if (data[i] > best || best != best) {
+            best = data[i];
+        }
+    }
+    return best;
+}
+
+
+/** \brief Index of first maximum element, ignoring NaN.
+ *
+ *  \return             Index, or `count` if every element is NaN.
+ */
+template <typename T>
+size_t argmax(const T *data,
+    const size_t count)
+{
+    size_t best = count;
+    for (size_t i = 0; i < count; ++i) {
+        if (data[i] != data[i]) {
+            continue;
+        } else if (best == count || data[i] > data[best]) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+
+// Overloads for common element types, vectorized where supported.
+double sum(const double *data, const size_t count);
+double sum(const float *data, const size_t count);
+int64_t sum(const int32_t *data, const size_t count);
+double minimum(const double *data, const size_t count);
+float minimum(const float *data, const size_t count);
+int32_t minimum(const int32_t *data, const size_t count);
+double maximum(const double *data, const size_t count);
+float maximum(const float *data, const size_t count);
+int32_t maximum(const int32_t *data, const size_t count);
+size_t argmax(const double *data, const size_t count);
+size_t argmax(const float *data, const size_t count);
+size_t argmax(const int32_t *data, const size_t count);
+
+}   /* kernel */
+
+// ALGORITHMS
+// ----------
+
+
+/** \brief Run function over each chunk, in parallel.
+ *
+ *  A single chunk runs on the calling thread.
+ */
+template <typename Fn>
+void chunked(const std::vector<Chunk> &list,
+    Fn fn,
+    ThreadPool &pool = ThreadPool::global())
+{
+    if (list.size() == 1) {
+        fn(size_t(0), list.front());
+        return;
+    }
+
+    pool.run(list.size(), [&](size_t index) {
+        fn(index, list[index]);
+    });
+}
+
+
+/** \brief Call function on each element of view.
+ */
+template <typename T, typename Fn>
+void for_each(const SafeArrayView<T> &view,
+    Fn fn,
+    ThreadPool &pool = ThreadPool::global())
+{
+    const T *data = view.data();
+    chunked(chunks(data, view.size(), sizeof(T), pool.size()), [&](size_t, Chunk chunk) {
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            fn(data[i]);
+        }
+    }, pool);
+}
+
+
+/** \brief Call function on each element of array, allowing mutation.
+ */
+template <typename T, typename Fn>
+void for_each(SafeArray<T> &array,
+    Fn fn,
+    ThreadPool &pool = ThreadPool::global())
+{
+    T *data = array.begin();
+    chunked(chunks(data, array.size(), sizeof(T), pool.size()), [&](size_t, Chunk chunk) {
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            fn(data[i]);
+        }
+    }, pool);
+}
+
+
+/** \brief Transform each element of array in place.
+ */
+template <typename T, typename Fn>
+void transform(SafeArray<T> &array,
+    Fn fn,
+    ThreadPool &pool = ThreadPool::global())
+{
+    T *data = array.begin();
+    chunked(chunks(data, array.size(), sizeof(T), pool.size()), [&](size_t, Chunk chunk) {
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            data[i] = fn(data[i]);
+        }
+    }, pool);
+}
+
+
+/** \brief Transform each element of view into output array.
+ *
+ *  \warning The output array must hold at least as many elements
+ *  as the input.
+ */
+template <typename T, typename U, typename Fn>
+void transform(const SafeArrayView<T> &input,
+    SafeArray<U> &output,
+    Fn fn,
+    ThreadPool &pool = ThreadPool::global())
+{
+    if (output.size() < input.size()) {
+        throw std::invalid_argument("Output SafeArray is smaller than input.");
+    }
+
+    const T *src = input.data();
+    U *dst = output.begin();
+    chunked(chunks(src, input.size(), sizeof(T), pool.size()), [&](size_t, Chunk chunk) {
+        for (size_t i = chunk.begin; i < chunk.end; ++i) {
+            dst[i] = fn(src[i]);
+        }
+    }, pool);
+}
+
+
+/** \brief Transform each element of array into output array.
+ */
+template <typename T, typename U, typename Fn>
+void transform(const SafeArray<T> &input,
+    SafeArray<U> &output,
+    Fn fn,
+    ThreadPool &pool = ThreadPool::global())
+{
+    transform(SafeArrayView<T>(input), output, fn, pool);
+}
+
+
+/** \brief Reduce elements with an associative operation.
+ *
+ *  Chunks are reduced in parallel, and partial results are combined
+ *  in order, starting from `init`.
+ */
+template <typename T, typename Op>
+T reduce(const SafeArrayView<T> &view,
+    T init,
+    Op op,
+    ThreadPool &pool = ThreadPool::global())
+{
+    const T *data = view.data();
+    const size_t count = view.size();
+    if (count == 0) {
+        return init;
+    }
+
+    auto list = chunks(data, count, sizeof(T), pool.size());
+    std::vector<T> partial(list.size());
+    chunked(list, [&](size_t index, Chunk chunk) {
+        T value = data[chunk.begin];
+        for (size_t i = chunk.begin + 1; i < chunk.end; ++i) {
+            value = op(value, data[i]);
+        }
+        partial[index] = value;
+    }, pool);
+
+    for (const T &value: partial) {
+        init = op(init, value);
+    }
+    return init;
+}
+
+
+/** \brief Reduce elements of array with an associative operation.
+ */
+template <typename T, typename Op>
+T reduce(const SafeArray<T> &array,
+    T init,
+    Op op,
+    ThreadPool &pool = ThreadPool::global())
+{
+    return reduce(SafeArrayView<T>(array), init, op, pool);
+}
+
+
+/** \brief Sum elements, accumulating in double or 64-bit integers.
+ */
+template <typename T>
+kernel::Accumulator<T> sum(const SafeArrayView<T> &view,
+    ThreadPool &pool = ThreadPool::global())
+{
+    typedef kernel::Canonical<T> C;
+    const C *data = reinterpret_cast<const C*>(view.data());
+    const size_t count = view.size();
+    if (count == 0) {
+        return 0;
+    }
+
+    auto list = chunks(data, count, sizeof(T), pool.size());
+    std::vector<kernel::Accumulator<T>> partial(list.size());
+    chunked(list, [&](size_t index, Chunk chunk) {
+        partial[index] = kernel::sum(data + chunk.begin, chunk.end - chunk.begin);
+    }, pool);
+
+    kernel::Accumulator<T> total = 0;
+    for (const auto &value: partial) {
+        total += value;
+    }
+    return total;
+}
+
+
+/** \brief Minimum element, ignoring NaN.
+ */
+template <typename T>
+T minimum(const SafeArrayView<T> &view,
+    ThreadPool &pool = ThreadPool::global())
+{
+    typedef kernel::Canonical<T> C;
+    const C *data = reinterpret_cast<const C*>(view.data());
+    const size_t count = view.size();
+    if (count == 0) {
+        throw std::out_of_range("Cannot get minimum of empty array.");
+    }
+
+    auto list = chunks(data, count, sizeof(T), pool.size());
+    std::vector<C> partial(list.size());
+    chunked(list, [&](size_t index, Chunk chunk) {
+        partial[index] = kernel::minimum(data + chunk.begin, chunk.end - chunk.begin);
+    }, pool);
+
+    return static_cast<T>(kernel::minimum(partial.data(), partial.size()));
+}
+
+
+/** \brief Maximum element, ignoring NaN.
+ */
+template <typename T>
+T maximum(const SafeArrayView<T> &view,
+    ThreadPool &pool = ThreadPool::global())
+{
+    typedef kernel::Canonical<T> C;
+    const C *data = reinterpret_cast<const C*>(view.data());
+    const size_t count = view.size();
+    if (count == 0) {
+        throw std::out_of_range("Cannot get maximum of empty array.");
+    }
+
+    auto list = chunks(data, count, sizeof(T), pool.size());
+    std::vector<C> partial(list.size());
+    chunked(list, [&](size_t index, Chunk chunk) {
+        partial[index] = kernel::maximum(data + chunk.begin, chunk.end - chunk.begin);
+    }, pool);
+
+    return static_cast<T>(kernel::maximum(partial.data(), partial.size()));
+}
+
+
+/** \brief Index of first maximum element, ignoring NaN.
+ *
+ *  Used for base-peak detection.
+ *
+ *  \return             Index, or `view.size()` if every element is NaN,
+ *                      like `kernel::argmax`.
+ */
+template <typename T>
+size_t argmax(const SafeArrayView<T> &view,
+    ThreadPool &pool = ThreadPool::global())
+{
+    typedef kernel::Canonical<T> C;
+    const C *data = reinterpret_cast<const C*>(view.data());
+    const size_t count = view.size();
+    if (count == 0) {
+        throw std::out_of_range("Cannot get maximum of empty array.");
+    }
+
+    auto list = chunks(data, count, sizeof(T), pool.size());
+    std::vector<size_t> partial(list.size());
+    chunked(list, [&](size_t index, Chunk chunk) {
+        size_t found = kernel::argmax(data + chunk.begin, chunk.end - chunk.begin);
+        partial[index] = chunk.begin + found;
+    }, pool);
+
+    size_t best = count;
+    for (size_t i = 0; i < partial.size(); ++i) {
+        size_t index = partial[i];
+        if (index >= list[i].end) {
+            continue;
+        } else if (best == count || data[index] > data[best]) {
+            best = index;
+        }
+    }
+    return best;
+}
+
+
+/** \brief Sum elements of array.
+ */
+template <typename T>
+kernel::Accumulator<T> sum(const SafeArray<T> &array,
+    ThreadPool &pool = ThreadPool::global())
+{
+    return sum(SafeArrayView<T>(array), pool);
+}
+
+
+/** \brief Minimum element of array, ignoring NaN.
+ */
+template <typename T>
+T minimum(const SafeArray<T> &array,
+    ThreadPool &pool = ThreadPool::global())
+{
+    return minimum(SafeArrayView<T>(array), pool);
+}
+
+
+/** \brief Maximum element of array, ignoring NaN.
+ */
+template <typename T>
+T maximum(const SafeArray<T> &array,
+    ThreadPool &pool = ThreadPool::global())
+{
+    return maximum(SafeArrayView<T>(array), pool);
+}
+
+
+/** \brief Index of first maximum element of array, ignoring NaN.
+ *
+ *  \return             Index, or `array.size()` if every element is NaN.
+ */
+template <typename T>
+size_t argmax(const SafeArray<T> &array,
+    ThreadPool &pool = ThreadPool::global())
+{
+    return argmax(SafeArrayView<T>(array), pool);
+}
+
+}   /* parallel */
+}   /* autocom */
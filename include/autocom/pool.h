@@ -0,0 +1,502 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Pool of warm, expensive-to-create COM objects.
+ *
+ *  Objects are handed out as RAII leases, and returned to the pool
+ *  when the lease is destroyed. Apartment-threaded servers must be
+ *  used from the thread which created them, so pools with thread
+ *  affinity keep separate idle instances for each thread.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+namespace autocom
+{
+// ENUMS
+// -----
+
+/** \brief Threads which may share a pooled instance.
+ */
+enum PoolAffinity
+{
+    POOL_SHARED     = 0,
+    POOL_THREAD     = 1,
+};
+
+// OBJECTS
+// -------
+
+
+/** \brief Snapshot of pool usage.
+ *
+ *  \param created              Live instances, leased or idle.
+ *  \param idle                 Instances waiting in the pool.
+ *  \param leased               Instances currently leased.
+ *  \param acquisitions         Successful acquisitions.
+ *  \param waits                Acquisitions which waited for capacity.
+ *  \param timeouts             Acquisitions which timed out.
+ *  \param waitSeconds          Total time spent waiting.
+ *  \param maxWaitSeconds       Longest single wait.
+ *  \param utilization          Fraction of instance lifetime spent leased.
+ */
+struct PoolStatistics
+{
+    size_t created = 0;
+    size_t idle = 0;
+    size_t leased = 0;
+    uint64_t acquisitions = 0;
+    uint64_t waits = 0;
+    uint64_t timeouts = 0;
+    double waitSeconds = 0;
+    double maxWaitSeconds = 0;
+    double utilization = 0;
+};
+
+
+/** \brief Pool of reusable objects, with an optional cap on instances.
+ *
+ *  The pool must outlive every lease.
+ */
+template <typename T>
+class ObjectPool
+{
+public:
+    typedef std::unique_ptr<T> Pointer;
+    typedef std::function<Pointer()> Factory;
+    typedef std::function<void(T&)> Reset;
+    class Lease;
+
+protected:
+    typedef std::chrono::steady_clock Clock;
+
+    Factory factory;
+    Reset reset;
+    size_t capacity;
+    PoolAffinity affinity;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::unordered_map<std::thread::id, std::vector<Pointer>> idle;
+    size_t created = 0;
+    size_t leased = 0;
+    uint64_t acquisitions = 0;
+    uint64_t waits = 0;
+    uint64_t timeouts = 0;
+    Clock::duration waitTime = Clock::duration::zero();
+    Clock::duration maxWait = Clock::duration::zero();
+    double leasedTime = 0;
+    double createdTime = 0;
+    Clock::time_point last = Clock::now();
+
+    std::thread::id key() const;
+    void account(const Clock::time_point now);
+    Lease acquire(const Clock::time_point *deadline);
+    void release(Pointer &&item,
+        bool discard);
+
+public:
+    ObjectPool(const size_t capacity = 0,
+        const PoolAffinity affinity = POOL_SHARED);
+    ObjectPool(Factory factory,
+        const size_t capacity = 0,
+        const PoolAffinity affinity = POOL_SHARED,
+        Reset reset = Reset());
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool & operator=(const ObjectPool&) = delete;
+
+    // LEASES
+    Lease acquire();
+    template <typename Rep, typename Period>
+    Lease acquire(const std::chrono::duration<Rep, Period> &timeout);
+    void clear();
+
+    // STATISTICS
+    PoolStatistics statistics() const;
+};
+
+
+/** \brief Exclusive use of a pooled object, returned on destruction.
+ */
+template <typename T>
+class ObjectPool<T>::Lease
+{
+protected:
+    friend class ObjectPool<T>;
+
+    ObjectPool<T> *pool = nullptr;
+    Pointer item;
+
+    Lease(ObjectPool<T> *pool,
+        Pointer &&item);
+
+public:
+    Lease() = default;
+    Lease(const Lease&) = delete;
+    Lease & operator=(const Lease&) = delete;
+    Lease(Lease &&other);
+    Lease & operator=(Lease &&other);
+    ~Lease();
+
+    // DATA
+    explicit operator bool() const;
+    T * get() const;
+    T & operator*() const;
+    T * operator->() const;
+
+    // MODIFIERS
+    void release();
+    void discard();
+};
+
+// IMPLEMENTATION
+// --------------
+
+
+/** \brief Get key of idle list for the calling thread.
+ */
+template <typename T>
+std::thread::id ObjectPool<T>::key() const
+{
+    return affinity == POOL_THREAD ? std::this_thread::get_id() : std::thread::id();
+}
+
+
+/** \brief Integrate leased and live instance counts over time.
+ */
+template <typename T>
+void ObjectPool<T>::account(const Clock::time_point now)
+{
+    const double elapsed = std::chrono::duration<double>(now - last).count();
+    leasedTime += leased * elapsed;
+    createdTime += created * elapsed;
+    last = now;
+}
+
+
+/** \brief Lease idle instance, or create one if under capacity.
+ *
+ *  \param deadline             Time to stop waiting, or null to wait
+ *                              indefinitely.
+ */
+template <typename T>
+auto ObjectPool<T>::acquire(const Clock::time_point *deadline)
+    -> Lease
+{
+    const auto start = Clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+
+    Pointer item;
+    bool waited = false;
+    bool expired = false;
+    while (true) {
+        auto &list = idle[key()];
+        if (!list.empty()) {
+            item = std::move(list.back());
+            list.pop_back();
+            break;
+        } else if (!capacity || created < capacity) {
+            // reserve slot, and create without the lock
+            account(Clock::now());
+            ++created;
+            lock.unlock();
+            try {
+                item = factory();
+                if (!item) {
+                    throw std::runtime_error("Object pool factory returned null.");
+                }
+            } catch (...) {
+                lock.lock();
+                account(Clock::now());
+                --created;
+                available.notify_all();
+                throw;
+            }
+            lock.lock();
+            break;
+        } else if (expired) {
+            ++timeouts;
+            return Lease();
+        }
+
+        waited = true;
+        if (deadline) {
+            expired = available.wait_until(lock, *deadline) == std::cv_status::timeout;
+        } else {
+            available.wait(lock);
+        }
+    }
+
+    const auto now = Clock::now();
+    account(now);
+    ++leased;
+    ++acquisitions;
+    if (waited) {
+        ++waits;
+        waitTime += now - start;
+        maxWait = std::max(maxWait, now - start);
+    }
+
+    return Lease(this, std::move(item));
+}
+
+
+/** \brief Reset and return instance to pool, or destroy it.
+ */
+template <typename T>
+void ObjectPool<T>::release(Pointer &&item,
+    bool discard)
+{
+    if (!discard && reset) {
+        try {
+            reset(*item);
+        } catch (...) {
+            discard = true;
+        }
+    }
+    if (discard) {
+        item.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    account(Clock::now());
+    --leased;
+    if (discard) {
+        --created;
+    } else {
+        idle[key()].emplace_back(std::move(item));
+    }
+    available.notify_all();
+}
+
+
+/** \brief Initialize pool of default-constructed objects.
+ *
+ *  \param capacity             Maximum live instances, 0 for no limit.
+ */
+template <typename T>
+ObjectPool<T>::ObjectPool(const size_t capacity,
+        const PoolAffinity affinity):
+    ObjectPool([]() { return Pointer(new T()); }, capacity, affinity)
+{}
+
+
+/** \brief Initialize pool from factory and reset hook.
+ *
+ *  \param capacity             Maximum live instances, 0 for no limit.
+ *                              Must be 0 with POOL_THREAD, since idle
+ *                              instances of other threads would count
+ *                              against it without being leasable.
+ *  \param reset                Called on instances returned to the
+ *                              pool. Instances are destroyed if it
+ *                              throws.
+ */
+template <typename T>
+ObjectPool<T>::ObjectPool(Factory factory,
+        const size_t capacity,
+        const PoolAffinity affinity,
+        Reset reset):
+    factory(std::move(factory)),
+    reset(std::move(reset)),
+    capacity(capacity),
+    affinity(affinity)
+{
+    if (affinity == POOL_THREAD && capacity) {
+        throw std::invalid_argument("Object pools with thread affinity cannot have a capacity.");
+    }
+}
+
+
+/** \brief Lease instance, waiting while the pool is at capacity.
+ */
+template <typename T>
+auto ObjectPool<T>::acquire()
+    -> Lease
+{
+    return acquire(nullptr);
+}
+
+
+/** \brief Lease instance, or return an empty lease after timeout.
+ */
+template <typename T>
+template <typename Rep, typename Period>
+auto ObjectPool<T>::acquire(const std::chrono::duration<Rep, Period> &timeout)
+    -> Lease
+{
+    const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(timeout);
+    return acquire(&deadline);
+}
+
+
+/** \brief Destroy idle instances owned by the calling thread.
+ *
+ *  Shared pools destroy every idle instance. Pools with thread
+ *  affinity should be cleared from each thread before it exits, or
+ *  its instances are released from the thread destroying the pool.
+ */
+template <typename T>
+void ObjectPool<T>::clear()
+{
+    std::vector<Pointer> items;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = idle.find(key());
+        if (it == idle.end()) {
+            return;
+        }
+        items = std::move(it->second);
+        idle.erase(it);
+        account(Clock::now());
+        created -= items.size();
+        available.notify_all();
+    }
+}
+
+
+/** \brief Get snapshot of pool usage.
+ */
+template <typename T>
+PoolStatistics ObjectPool<T>::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const double elapsed = std::chrono::duration<double>(Clock::now() - last).count();
+    const double leasedTotal = leasedTime + leased * elapsed;
+    const double createdTotal = createdTime + created * elapsed;
+
+    PoolStatistics statistics;
+    statistics.created = created;
+    statistics.leased = leased;
+    statistics.idle = created - leased;
+    statistics.acquisitions = acquisitions;
+    statistics.waits = waits;
+    statistics.timeouts = timeouts;
+    statistics.waitSeconds = std::chrono::duration<double>(waitTime).count();
+    statistics.maxWaitSeconds = std::chrono::duration<double>(maxWait).count();
+    statistics.utilization = createdTotal > 0 ? leasedTotal / createdTotal : 0;
+
+    return statistics;
+}
+
+
+/** \brief Initialize lease of pooled instance.
+ */
+template <typename T>
+ObjectPool<T>::Lease::Lease(ObjectPool<T> *pool,
+        Pointer &&item):
+    pool(pool),
+    item(std::move(item))
+{}
+
+
+/** \brief Move constructor.
+ */
+template <typename T>
+ObjectPool<T>::Lease::Lease(Lease &&other):
+    pool(other.pool),
+    item(std::move(other.item))
+{
+    other.pool = nullptr;
+}
+
+
+/** \brief Move assignment operator.
+ */
+template <typename T>
+auto ObjectPool<T>::Lease::operator=(Lease &&other)
+    -> Lease &
+{
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        item = std::move(other.item);
+        other.pool = nullptr;
+    }
+    return *this;
+}
+
+
+/** \brief Return instance to pool.
+ */
+template <typename T>
+ObjectPool<T>::Lease::~Lease()
+{
+    release();
+}
+
+
+/** \brief Check if lease holds an instance.
+ */
+template <typename T>
+ObjectPool<T>::Lease::operator bool() const
+{
+    return bool(item);
+}
+
+
+/** \brief Get leased instance.
+ */
+template <typename T>
+T * ObjectPool<T>::Lease::get() const
+{
+    return item.get();
+}
+
+
+/** \brief Dereference leased instance.
+ */
+template <typename T>
+T & ObjectPool<T>::Lease::operator*() const
+{
+    return *item;
+}
+
+
+/** \brief Access members of leased instance.
+ */
+template <typename T>
+T * ObjectPool<T>::Lease::operator->() const
+{
+    return item.get();
+}
+
+
+/** \brief Return instance to pool early.
+ */
+template <typename T>
+void ObjectPool<T>::Lease::release()
+{
+    if (pool && item) {
+        pool->release(std::move(item), false);
+    }
+    pool = nullptr;
+}
+
+
+/** \brief Destroy instance rather than returning it, such as after
+ *  the server fails.
+ */
+template <typename T>
+void ObjectPool<T>::Lease::discard()
+{
+    if (pool && item) {
+        pool->release(std::move(item), true);
+    }
+    pool = nullptr;
+}
+
+}   /* autocom */
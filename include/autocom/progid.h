@@ -0,0 +1,119 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Cached ProgID to CLSID resolution.
+ *
+ *  `CLSIDFromProgID` reads the registry on every call. The cache
+ *  remembers both successful and failed lookups for a limited time,
+ *  and lookups of cached entries take no locks: entries are never
+ *  removed while the cache is alive, and their values are published
+ *  through a sequence lock.
+ */
+
+#pragma once
+
+#include <wtypes.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+
+namespace autocom
+{
+// OBJECTS
+// -------
+
+
+/** \brief Backend which resolves a ProgID to a CLSID.
+ */
+class ProgIdResolver
+{
+public:
+    virtual ~ProgIdResolver() = default;
+
+    /** \brief Resolve ProgID, returning the HRESULT of the lookup.
+     */
+    virtual HRESULT resolve(const std::wstring &progid,
+        GUID &clsid) = 0;
+};
+
+
+/** \brief Resolve ProgIDs from the registry, through CLSIDFromProgID.
+ */
+class RegistryResolver: public ProgIdResolver
+{
+public:
+    virtual HRESULT resolve(const std::wstring &progid,
+        GUID &clsid) override;
+};
+
+
+/** \brief Process-wide, thread-safe cache of ProgID lookups.
+ */
+class ProgIdCache
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef Clock::duration Duration;
+
+protected:
+    struct Entry;
+
+    static const size_t BUCKETS = 64;
+
+    std::atomic<Entry*> buckets[BUCKETS];
+    std::shared_ptr<ProgIdResolver> backend;
+    std::atomic<int64_t> positive;
+    std::atomic<int64_t> negative;
+    std::atomic<uint64_t> hitCount;
+    std::atomic<uint64_t> missCount;
+    uint64_t generation = 0;
+    mutable std::mutex mutex;
+
+    Entry * find(const wchar_t *progid,
+        const size_t length,
+        const size_t hash) const;
+    void store(const wchar_t *progid,
+        const size_t length,
+        const size_t hash,
+        const GUID &clsid,
+        const HRESULT hr,
+        const int64_t expires,
+        const uint64_t version);
+
+public:
+    ProgIdCache(std::shared_ptr<ProgIdResolver> resolver = std::make_shared<RegistryResolver>(),
+        const Duration ttl = std::chrono::minutes(10),
+        const Duration negativeTtl = std::chrono::seconds(30));
+    ProgIdCache(const ProgIdCache&) = delete;
+    ProgIdCache & operator=(const ProgIdCache&) = delete;
+    ~ProgIdCache();
+
+    static ProgIdCache & global();
+
+    // LOOKUP
+    HRESULT resolve(const wchar_t *progid,
+        const size_t length,
+        GUID &clsid);
+    HRESULT resolve(const std::wstring &progid,
+        GUID &clsid);
+
+    // MODIFIERS
+    void invalidate(const std::wstring &progid);
+    void clear();
+    void ttl(const Duration ttl,
+        const Duration negativeTtl);
+    void resolver(std::shared_ptr<ProgIdResolver> resolver);
+
+    // STATISTICS
+    size_t size() const;
+    uint64_t hits() const;
+    uint64_t misses() const;
+};
+
+}   /* autocom */
@@ -0,0 +1,113 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief C++ handle around IRecordInfo.
+ */
+
+#pragma once
+
+#include <autocom/typeinfo.h>
+#include <autocom/view.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace autocom
+{
+// TYPES
+// -----
+
+typedef SharedPointer<IRecordInfo> IRecordInfoPtr;
+
+// FUNCTIONS
+// ---------
+
+/** \brief Create new handle to IRecordInfo object from ITypeInfo.
+ */
+IRecordInfo * newRecordInfo(ITypeInfo *info);
+
+/** \brief Create new handle to IRecordInfo object from a VT_RECORD SAFEARRAY.
+ */
+IRecordInfo * newRecordInfo(const SAFEARRAY *array);
+
+// OBJECTS
+// -------
+
+
+/** \brief COM object wrapper for the IRecordInfo model.
+ *
+ *  Describes the layout of a user-defined type, and is required to
+ *  create or validate SAFEARRAYs of VT_RECORD.
+ */
+class RecordInfo
+{
+protected:
+    IRecordInfoPtr ppv = nullptr;
+
+    friend bool operator==(const RecordInfo &left,
+        const RecordInfo &right);
+    friend bool operator!=(const RecordInfo &left,
+        const RecordInfo &right);
+
+public:
+    RecordInfo() = default;
+    RecordInfo(const RecordInfo&) = default;
+    RecordInfo & operator=(const RecordInfo&) = default;
+    RecordInfo(RecordInfo&&) = default;
+    RecordInfo & operator=(RecordInfo&&) = default;
+
+    RecordInfo(IRecordInfo *info);
+    RecordInfo(const TypeInfo &info);
+    RecordInfo(const SAFEARRAY *array);
+    void open(IRecordInfo *info);
+
+    // DATA
+    explicit operator bool() const;
+    IRecordInfo * get() const;
+    ULONG size() const;
+    Guid guid() const;
+    std::string name() const;
+    TypeInfo info() const;
+    std::vector<std::string> fields() const;
+    ULONG offset(const std::string &field) const;
+
+    // WINAPI
+    ULONG GetSize() const;
+    Guid GetGuid() const;
+    std::string GetName() const;
+    TypeInfo GetTypeInfo() const;
+    std::vector<std::string> GetFieldNames() const;
+};
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Check that a C++ struct matches the size of a record.
+ */
+template <typename T>
+void checkRecord(const RecordInfo &info)
+{
+    if (info.size() != sizeof(T)) {
+        throw std::invalid_argument("Record " + info.name() + " has size " + std::to_string(info.size()) + ", C++ struct has size " + std::to_string(sizeof(T)) + ".");
+    }
+}
+
+
+/** \brief Check that a C++ struct member matches the offset of a
+ *  record field.
+ */
+template <typename T, typename U>
+void checkRecord(const RecordInfo &info,
+    const std::string &field,
+    U T::*member)
+{
+    if (info.offset(field) != memberOffset(member)) {
+        throw std::invalid_argument("Record field " + info.name() + "::" + field + " does not match C++ struct offset.");
+    }
+}
+
+}   /* autocom */
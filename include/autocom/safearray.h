@@ -7,11 +7,13 @@
 
 #pragma once
 
+#include <autocom/accounting.h>
 #include <autocom/util/exception.h>
 #include <autocom/util/type.h>
 
 #include <oaidl.h>
 
+#include <string>
 #include <vector>
 
 
@@ -28,9 +30,19 @@ namespace autocom
  */
 VARTYPE getSafeArrayType(const SAFEARRAY *value);
 
+/** \brief Write SAFEARRAY type, bounds and data to a spill file.
+ *
+ *  Only arrays of plain data may be spilled: arrays of BSTR, VARIANT,
+ *  interface or record values hold pointers and are rejected.
+ */
+void spillSafeArray(const SAFEARRAY *array,
+    const std::string &path);
+
 // OBJECTS
 // -------
 
+struct ConvertOptions;
+
 
 /** \brief C++ wrapper around SAFEARRAYBOUND.
  */
@@ -74,6 +86,7 @@ protected:
     void lock();
     void unlock();
     void checkNull() const;
+    void checkRecord(const SAFEARRAY *other) const;
 
     // INITIALIZERS
     void create(UINT dimensions,
@@ -118,6 +131,8 @@ public:
     SafeArray(const std::vector<T> &other);
     SafeArray(const std::initializer_list<T> other);
     SafeArray(VARIANT &variant);
+    SafeArray(IRecordInfo *record,
+        const size_t size);
     template <typename Iter>
     SafeArray(Iter begin,
         Iter end);
@@ -188,6 +203,15 @@ public:
     void reset();
     void reset(SAFEARRAY *safearray);
     void reset(VARIANT &variant);
+    SAFEARRAY * release();
+
+    // ELEMENT CONVERSION
+    static This convertFrom(const SAFEARRAY *other);
+    static This convertFrom(const SAFEARRAY *other,
+        const ConvertOptions &options);
+
+    // SERIALIZATION
+    void spill(const std::string &path) const;
 
     // CONVERSIONS
     operator LPSAFEARRAY();
@@ -242,13 +266,31 @@ void SafeArray<T>::checkNull() const
 }
 
 
+/** \brief Check record arrays hold elements the size of the C++ struct.
+ *
+ *  Arrays of user-defined types carry their IRecordInfo, so the
+ *  element size is checked before reinterpreting records as `T`.
+ */
+template <typename T>
+void SafeArray<T>::checkRecord(const SAFEARRAY *other) const
+{
+    if (vt != VT_RECORD || !other) {
+        return;
+    } else if (!(other->fFeatures & FADF_RECORD)) {
+        throw std::invalid_argument("SafeArray of records requires a VT_RECORD SAFEARRAY.");
+    } else if (other->cbElements != sizeof(T)) {
+        throw std::invalid_argument("SafeArray record size " + std::to_string(other->cbElements) + " does not match C++ struct size " + std::to_string(sizeof(T)) + ".");
+    }
+}
+
+
 /** \brief Create array.
  */
 template <typename T>
 void SafeArray<T>::create(UINT dimensions,
     SafeArrayBound *bound)
 {
-    array = SafeArrayCreate(vt, dimensions, bound);
+    array = accounting::safeArrayCreate(vt, dimensions, bound, "SafeArray::create()");
     if (!array) {
         throw std::runtime_error("Unhandled exception in SafeArrayCreate, maybe out of memory?\n");
     }
@@ -262,7 +304,7 @@ void SafeArray<T>::close()
 {
     if (array) {
         unlock();
-        SafeArrayDestroy(array);
+        accounting::safeArrayDestroy(array, "SafeArray::close()");
         array = nullptr;
     }
 }
@@ -274,7 +316,7 @@ template <typename T>
 void SafeArray<T>::copy(const SAFEARRAY *in,
     SAFEARRAY **out)
 {
-    if (SafeArrayCopy(in, out) == E_OUTOFMEMORY) {
+    if (accounting::safeArrayCopy(in, out, "SafeArray::copy()") == E_OUTOFMEMORY) {
         throw std::runtime_error("E_OUTOFMEMORY from SafeArrayCopy()\n");
     }
 }
@@ -288,6 +330,7 @@ void SafeArray<T>::assign(VARIANT &variant)
     if (variant.vt & (VT_BYREF)) {
         throw std::runtime_error("Cannot take ownership of value by reference");
     } else if (variant.vt & VT_ARRAY) {
+        checkRecord(variant.parray);
         array = variant.parray;
         variant.parray = nullptr;
         variant.vt = VT_EMPTY;
@@ -393,6 +436,7 @@ auto SafeArray<T>::operator=(const SAFEARRAY *other)
     if (vt != getSafeArrayType(other)) {
         throw std::invalid_argument("Cannot change type of SafeArray");
     }
+    checkRecord(other);
     close();
     if (other) {
         copy(other, &array);
@@ -421,6 +465,7 @@ auto SafeArray<T>::operator=(SAFEARRAY *&&other)
     if (vt != getSafeArrayType(other)) {
         throw std::invalid_argument("Cannot change type of SafeArray");
     }
+    checkRecord(other);
     close();
     array = std::move(other);
     other = nullptr;
@@ -474,6 +519,32 @@ SafeArray<T>::SafeArray(VARIANT &variant)
 }
 
 
+/** \brief Create array of zero-initialized records.
+ */
+template <typename T>
+SafeArray<T>::SafeArray(IRecordInfo *record,
+    const size_t size)
+{
+    if (vt != VT_RECORD) {
+        throw std::invalid_argument("SafeArray from IRecordInfo requires a record type.");
+    }
+
+    SafeArrayBound bound(size);
+    array = accounting::safeArrayCreateEx(vt, 1, &bound, record, "SafeArray(IRecordInfo *, size_t)");
+    if (!array) {
+        throw std::runtime_error("Unhandled exception in SafeArrayCreateEx, maybe out of memory?\n");
+    }
+    try {
+        checkRecord(array);
+    } catch (...) {
+        accounting::safeArrayDestroy(array, "SafeArray(IRecordInfo *, size_t)");
+        array = nullptr;
+        throw;
+    }
+    lock();
+}
+
+
 /** \brief Range constructor.
  */
 template <typename T>
@@ -870,6 +941,7 @@ void SafeArray<T>::reset()
 template <typename T>
 void SafeArray<T>::reset(SAFEARRAY *safearray)
 {
+    checkRecord(safearray);
     close();
     array = safearray;
     lock();
@@ -887,6 +959,33 @@ void SafeArray<T>::reset(VARIANT &variant)
 }
 
 
+/** \brief Unlock and release ownership of the SAFEARRAY.
+ *
+ *  The caller is responsible for destroying the returned array.
+ */
+template <typename T>
+SAFEARRAY * SafeArray<T>::release()
+{
+    SAFEARRAY *released = array;
+    if (array) {
+        unlock();
+        array = nullptr;
+    }
+
+    return released;
+}
+
+
+/** \brief Spill array to file, to be reopened by MappedSafeArray.
+ */
+template <typename T>
+void SafeArray<T>::spill(const std::string &path) const
+{
+    checkNull();
+    spillSafeArray(array, path);
+}
+
+
 /** \brief Convert to SAFEARRAY*.
  */
 template <typename T>
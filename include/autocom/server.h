@@ -0,0 +1,828 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief IDispatch servers implemented by C++ classes.
+ *
+ *  Servers derive from `DispatchImpl<Derived>` and describe their
+ *  members in a static dispatch table:
+ *
+ *  \code
+ *      class Calculator: public autocom::DispatchImpl<Calculator>
+ *      {
+ *      public:
+ *          LONG total = 0;
+ *          LONG add(LONG left, LONG right);
+ *
+ *          AUTOCOM_DISPATCH_BEGIN(Calculator)
+ *              AUTOCOM_DISPATCH_METHOD(L"Add", 1, &Calculator::add)
+ *              AUTOCOM_DISPATCH_PROPERTY(L"Total", 2, &Calculator::total)
+ *          AUTOCOM_DISPATCH_END()
+ *      };
+ *  \endcode
+ *
+ *  Names are resolved by a case-insensitive perfect hash, built on
+ *  first use, and arguments are unpacked from DISPPARAMS with the
+ *  `get(VARIANT&, T&)` overloads, without allocating on the heap.
+ */
+
+#pragma once
+
+#include <autocom/variant.h>
+
+#include <oaidl.h>
+
+#include <atomic>
+#include <exception>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace autocom
+{
+// OBJECTS
+// -------
+
+
+/** \brief Name, identifier and invocation kind of a server member.
+ */
+struct DispatchMember
+{
+    const wchar_t *name;
+    DISPID id;
+    WORD flags;
+};
+
+
+/** \brief Lookup of server members by name and by identifier.
+ *
+ *  Names are placed in a perfect hash table, with the seed searched
+ *  until no two names collide, so a lookup hashes the name once and
+ *  compares a single candidate. Names compare case-insensitively,
+ *  like OLE Automation clients expect.
+ */
+class DispatchIndex
+{
+protected:
+    std::vector<DispatchMember> members;
+    std::vector<LONG> slots;
+    std::vector<LONG> order;
+    ULONG seed = 0;
+
+public:
+    DispatchIndex(std::vector<DispatchMember> &&members);
+
+    LONG find(const wchar_t *name) const;
+    LONG find(const DISPID id,
+        const WORD flags) const;
+
+    const DispatchMember & operator[](const size_t index) const;
+    size_t size() const;
+};
+
+
+/** \brief Entry in the static dispatch table of a server.
+ *
+ *  \param invoke               Unpacks the arguments and calls the member.
+ */
+template <typename Derived>
+struct DispatchEntry
+{
+    typedef HRESULT (*Thunk)(Derived &, DISPPARAMS &, VARIANT *, UINT *);
+
+    const wchar_t *name;
+    DISPID id;
+    WORD flags;
+    Thunk invoke;
+};
+
+
+/** \brief Dispatch table, built once from the entries of a server.
+ */
+template <typename Derived>
+class DispatchTable: public DispatchIndex
+{
+protected:
+    const DispatchEntry<Derived> *entries;
+
+    template <size_t N>
+    static std::vector<DispatchMember> describe(const DispatchEntry<Derived> (&entries)[N]);
+
+public:
+    template <size_t N>
+    DispatchTable(const DispatchEntry<Derived> (&entries)[N]);
+
+    HRESULT invoke(Derived &object,
+        const DISPID id,
+        const WORD flags,
+        DISPPARAMS &params,
+        VARIANT *result,
+        EXCEPINFO *exception,
+        UINT *error) const;
+};
+
+
+/** \brief CRTP base for IDispatch servers.
+ *
+ *  `Derived` must define its members with `AUTOCOM_DISPATCH_BEGIN`.
+ *  Objects are created with a single reference, owned by the caller,
+ *  and deleted when the last reference is released.
+ */
+template <typename Derived>
+class DispatchImpl: public IDispatch
+{
+protected:
+    std::atomic<ULONG> references;
+
+public:
+    DispatchImpl();
+    DispatchImpl(const DispatchImpl&) = delete;
+    DispatchImpl & operator=(const DispatchImpl&) = delete;
+    virtual ~DispatchImpl() = default;
+
+    // IUNKNOWN
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override;
+    virtual ULONG STDMETHODCALLTYPE AddRef() override;
+    virtual ULONG STDMETHODCALLTYPE Release() override;
+
+    // IDISPATCH
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfoCount(UINT *count) override;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfo(UINT index,
+        LCID locale,
+        ITypeInfo **info) override;
+    virtual HRESULT STDMETHODCALLTYPE GetIDsOfNames(REFIID iid,
+        LPOLESTR *names,
+        UINT count,
+        LCID locale,
+        DISPID *ids) override;
+    virtual HRESULT STDMETHODCALLTYPE Invoke(DISPID member,
+        REFIID iid,
+        LCID locale,
+        WORD flags,
+        DISPPARAMS *params,
+        VARIANT *result,
+        EXCEPINFO *exception,
+        UINT *error) override;
+};
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Describe an exception thrown by a server member.
+ *
+ *  Does nothing if `exception` is null.
+ */
+void setExceptionInfo(EXCEPINFO *exception,
+    const wchar_t *source,
+    const char *description);
+
+// HELPERS
+// -------
+
+namespace detail
+{
+
+/** \brief Variant type arguments are coerced to before unpacking.
+ */
+template <typename T>
+struct DispatchArgumentType
+{
+    static constexpr VARTYPE vt = VariantType<T>::vt;
+};
+
+
+template <typename T>
+struct DispatchArgumentType<SafeArray<T>>
+{
+    static constexpr VARTYPE vt = VariantType<SafeArray<T>, true>::vt;
+};
+
+
+/** \brief Unpack argument from a borrowed view of the variant.
+ */
+template <typename T>
+void getArgument(VARIANT &variant,
+    T &value)
+{
+    get(variant, value);
+}
+
+
+/** \brief Unpack boolean argument, which has no `get` overload.
+ */
+inline void getArgument(VARIANT &variant,
+    bool &value)
+{
+    value = variant.boolVal != VARIANT_FALSE;
+}
+
+
+/** \brief Give up a borrowed argument before destruction.
+ *
+ *  Arguments belong to the caller, so owning wrappers must not free
+ *  the value they were unpacked into.
+ */
+template <typename T>
+void releaseArgument(T &value)
+{}
+
+
+inline void releaseArgument(Bstr &value)
+{
+    value.string = nullptr;
+}
+
+
+template <typename T>
+void releaseArgument(SafeArray<T> &value)
+{
+    value.array = nullptr;
+}
+
+
+/** \brief Storage for an argument unpacked from DISPPARAMS.
+ *
+ *  Arguments of the expected type are borrowed, others are coerced
+ *  into a variant owned until the call returns.
+ */
+template <typename T>
+class DispatchArgument
+{
+protected:
+    VARIANT owned;
+    T data = T();
+
+public:
+    static_assert(DispatchArgumentType<T>::vt != VT_USERDEFINED, "Unsupported argument type for dispatch server.");
+
+    DispatchArgument()
+    {
+        VariantInit(&owned);
+    }
+
+    DispatchArgument(const DispatchArgument&) = delete;
+    DispatchArgument & operator=(const DispatchArgument&) = delete;
+
+    ~DispatchArgument()
+    {
+        releaseArgument(data);
+        VariantClear(&owned);
+    }
+
+    HRESULT load(VARIANT &argument)
+    {
+        const VARTYPE vt = DispatchArgumentType<T>::vt;
+        VARIANT view = argument;
+        if (argument.vt != vt) {
+            HRESULT hr = VariantChangeType(&owned, &argument, 0, vt);
+            if (FAILED(hr)) {
+                return hr;
+            }
+            view = owned;
+        }
+
+        try {
+            getArgument(view, data);
+        } catch (std::exception&) {
+            return DISP_E_TYPEMISMATCH;
+        }
+        return S_OK;
+    }
+
+    T & value()
+    {
+        return data;
+    }
+};
+
+
+/** \brief Raw argument, passed without coercion.
+ */
+template <>
+class DispatchArgument<VARIANT*>
+{
+protected:
+    VARIANT *data = nullptr;
+
+public:
+    HRESULT load(VARIANT &argument)
+    {
+        data = &argument;
+        return S_OK;
+    }
+
+    VARIANT *& value()
+    {
+        return data;
+    }
+};
+
+
+/** \brief Raw argument, passed without coercion.
+ */
+template <>
+class DispatchArgument<VARIANT>
+{
+protected:
+    VARIANT *data = nullptr;
+
+public:
+    HRESULT load(VARIANT &argument)
+    {
+        data = &argument;
+        return S_OK;
+    }
+
+    VARIANT & value()
+    {
+        return *data;
+    }
+};
+
+
+/** \brief Store result in the caller's variant, or discard it.
+ */
+template <typename T>
+void setResult(VARIANT *result,
+    T &&value)
+{
+    VARIANT variant;
+    VariantInit(&variant);
+    set(variant, AUTOCOM_FWD(value));
+    if (result) {
+        *result = variant;
+    } else {
+        VariantClear(&variant);
+    }
+}
+
+
+/** \brief Store boolean result as VARIANT_TRUE or VARIANT_FALSE.
+ */
+inline void setResult(VARIANT *result,
+    bool value)
+{
+    if (result) {
+        result->vt = VT_BOOL;
+        result->boolVal = value ? VARIANT_TRUE : VARIANT_FALSE;
+    }
+}
+
+
+/** \brief Call a member and store the result, if any.
+ */
+template <typename R>
+struct DispatchReturn
+{
+    template <typename F>
+    static void call(F &&f,
+        VARIANT *result)
+    {
+        typename std::decay<R>::type value = f();
+        setResult(result, std::move(value));
+    }
+};
+
+
+template <>
+struct DispatchReturn<void>
+{
+    template <typename F>
+    static void call(F &&f,
+        VARIANT *result)
+    {
+        f();
+    }
+};
+
+
+/** \brief Unpack a single argument, in C++ order.
+ *
+ *  DISPPARAMS::rgvarg stores arguments in reverse order.
+ */
+template <typename Argument>
+HRESULT loadArgument(Argument &argument,
+    DISPPARAMS &params,
+    const UINT index,
+    UINT *error)
+{
+    const UINT position = params.cArgs - 1 - index;
+    HRESULT hr = argument.load(params.rgvarg[position]);
+    if (FAILED(hr) && error) {
+        *error = position;
+    }
+    return hr;
+}
+
+
+/** \brief Unpack arguments and call member function.
+ */
+template <
+    typename R,
+    typename... Args,
+    typename Object,
+    typename Member,
+    size_t... Is
+>
+HRESULT invokeFunction(Object &object,
+    Member member,
+    DISPPARAMS &params,
+    VARIANT *result,
+    UINT *error,
+    std::index_sequence<Is...>)
+{
+    if (params.cArgs != sizeof...(Args)) {
+        return DISP_E_BADPARAMCOUNT;
+    }
+
+    std::tuple<DispatchArgument<typename std::decay<Args>::type>...> arguments;
+    HRESULT hr = S_OK;
+    using expand = int[];
+    (void) expand {0, (hr = SUCCEEDED(hr) ? loadArgument(std::get<Is>(arguments), params, Is, error) : hr, 0)...};
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    DispatchReturn<R>::call([&]() -> R {
+        return (object.*member)(std::get<Is>(arguments).value()...);
+    }, result);
+    return S_OK;
+}
+
+
+/** \brief Call a member of a server from DISPPARAMS.
+ */
+template <typename Member>
+struct DispatchCall;
+
+
+template <
+    typename C,
+    typename R,
+    typename... Args
+>
+struct DispatchCall<R (C::*)(Args...)>
+{
+    template <typename Object>
+    static HRESULT invoke(Object &object,
+        R (C::*member)(Args...),
+        DISPPARAMS &params,
+        VARIANT *result,
+        UINT *error)
+    {
+        return invokeFunction<R, Args...>(object, member, params, result, error, std::index_sequence_for<Args...>());
+    }
+};
+
+
+template <
+    typename C,
+    typename R,
+    typename... Args
+>
+struct DispatchCall<R (C::*)(Args...) const>
+{
+    template <typename Object>
+    static HRESULT invoke(Object &object,
+        R (C::*member)(Args...) const,
+        DISPPARAMS &params,
+        VARIANT *result,
+        UINT *error)
+    {
+        return invokeFunction<R, Args...>(object, member, params, result, error, std::index_sequence_for<Args...>());
+    }
+};
+
+
+/** \brief Get or put a data member of a server from DISPPARAMS.
+ */
+template <typename Member>
+struct DispatchData;
+
+
+template <
+    typename C,
+    typename T
+>
+struct DispatchData<T C::*>
+{
+    template <typename Object>
+    static HRESULT get(Object &object,
+        T C::*member,
+        DISPPARAMS &params,
+        VARIANT *result,
+        UINT *error)
+    {
+        if (params.cArgs != 0) {
+            return DISP_E_BADPARAMCOUNT;
+        }
+        T value = object.*member;
+        setResult(result, std::move(value));
+        return S_OK;
+    }
+
+    template <typename Object>
+    static HRESULT put(Object &object,
+        T C::*member,
+        DISPPARAMS &params,
+        VARIANT *result,
+        UINT *error)
+    {
+        if (params.cArgs != 1) {
+            return DISP_E_BADPARAMCOUNT;
+        }
+        DispatchArgument<T> argument;
+        HRESULT hr = loadArgument(argument, params, 0, error);
+        if (SUCCEEDED(hr)) {
+            object.*member = argument.value();
+        }
+        return hr;
+    }
+};
+
+}   /* detail */
+
+
+/** \brief Thunk calling a member function.
+ */
+template <
+    typename Derived,
+    typename Member,
+    Member member
+>
+HRESULT dispatchCall(Derived &object,
+    DISPPARAMS &params,
+    VARIANT *result,
+    UINT *error)
+{
+    return detail::DispatchCall<Member>::invoke(object, member, params, result, error);
+}
+
+
+/** \brief Thunk getting a data member.
+ */
+template <
+    typename Derived,
+    typename Member,
+    Member member
+>
+HRESULT dispatchGet(Derived &object,
+    DISPPARAMS &params,
+    VARIANT *result,
+    UINT *error)
+{
+    return detail::DispatchData<Member>::get(object, member, params, result, error);
+}
+
+
+/** \brief Thunk putting a data member.
+ */
+template <
+    typename Derived,
+    typename Member,
+    Member member
+>
+HRESULT dispatchPut(Derived &object,
+    DISPPARAMS &params,
+    VARIANT *result,
+    UINT *error)
+{
+    return detail::DispatchData<Member>::put(object, member, params, result, error);
+}
+
+// MACROS
+// ------
+
+/** \brief Begin the dispatch table of `Derived`.
+ */
+#define AUTOCOM_DISPATCH_BEGIN(Derived)                                 \
+    friend class autocom::DispatchImpl<Derived>;                        \
+                                                                        \
+    static const autocom::DispatchTable<Derived> & dispatchTable()      \
+    {                                                                   \
+        typedef Derived AutocomServer;                                  \
+        static constexpr autocom::DispatchEntry<Derived> entries[] = {
+
+/** \brief End the dispatch table.
+ */
+#define AUTOCOM_DISPATCH_END()                                          \
+        };                                                              \
+        static const autocom::DispatchTable<AutocomServer> table(entries); \
+        return table;                                                   \
+    }
+
+/** \brief Define a dispatch table entry.
+ */
+#define AUTOCOM_DISPATCH_ENTRY(name, id, flags, thunk, member)          \
+    {name, id, flags, &autocom::thunk<AutocomServer, decltype(member), member>},
+
+/** \brief Expose member function as a method.
+ *
+ *  AUTOCOM_DISPATCH_METHOD(L"Add", 1, &Calculator::add)
+ */
+#define AUTOCOM_DISPATCH_METHOD(name, id, member)                       \
+    AUTOCOM_DISPATCH_ENTRY(name, id, DISPATCH_METHOD, dispatchCall, member)
+
+/** \brief Expose member function as a property getter.
+ */
+#define AUTOCOM_DISPATCH_GET(name, id, member)                          \
+    AUTOCOM_DISPATCH_ENTRY(name, id, DISPATCH_PROPERTYGET, dispatchCall, member)
+
+/** \brief Expose member function as a property setter.
+ *
+ *  The value is the last argument.
+ */
+#define AUTOCOM_DISPATCH_PUT(name, id, member)                          \
+    AUTOCOM_DISPATCH_ENTRY(name, id, DISPATCH_PROPERTYPUT, dispatchCall, member)
+
+/** \brief Expose data member as a read-write property.
+ */
+#define AUTOCOM_DISPATCH_PROPERTY(name, id, member)                     \
+    AUTOCOM_DISPATCH_ENTRY(name, id, DISPATCH_PROPERTYGET, dispatchGet, member) \
+    AUTOCOM_DISPATCH_ENTRY(name, id, DISPATCH_PROPERTYPUT, dispatchPut, member)
+
+// IMPLEMENTATION
+// --------------
+
+
+template <typename Derived>
+template <size_t N>
+std::vector<DispatchMember> DispatchTable<Derived>::describe(const DispatchEntry<Derived> (&entries)[N])
+{
+    std::vector<DispatchMember> members;
+    members.reserve(N);
+    for (const auto &entry: entries) {
+        members.push_back({entry.name, entry.id, entry.flags});
+    }
+    return members;
+}
+
+
+template <typename Derived>
+template <size_t N>
+DispatchTable<Derived>::DispatchTable(const DispatchEntry<Derived> (&entries)[N]):
+    DispatchIndex(describe(entries)),
+    entries(entries)
+{}
+
+
+/** \brief Call member by identifier.
+ *
+ *  Exceptions thrown by the member are reported as DISP_E_EXCEPTION.
+ */
+template <typename Derived>
+HRESULT DispatchTable<Derived>::invoke(Derived &object,
+    const DISPID id,
+    const WORD flags,
+    DISPPARAMS &params,
+    VARIANT *result,
+    EXCEPINFO *exception,
+    UINT *error) const
+{
+    LONG index = find(id, flags);
+    if (index < 0) {
+        return DISP_E_MEMBERNOTFOUND;
+    }
+
+    // only the value of a property put may be named
+    if (params.cNamedArgs) {
+        bool put = flags & (DISPATCH_PROPERTYPUT | DISPATCH_PROPERTYPUTREF);
+        if (!put || params.cNamedArgs != 1 || params.rgdispidNamedArgs[0] != DISPID_PROPERTYPUT) {
+            return DISP_E_NONAMEDARGS;
+        }
+    }
+
+    const auto &entry = entries[index];
+    try {
+        return entry.invoke(object, params, result, error);
+    } catch (std::exception &e) {
+        setExceptionInfo(exception, entry.name, e.what());
+    } catch (...) {
+        setExceptionInfo(exception, entry.name, "Unknown exception.");
+    }
+    return DISP_E_EXCEPTION;
+}
+
+
+template <typename Derived>
+DispatchImpl<Derived>::DispatchImpl():
+    references(1)
+{}
+
+
+template <typename Derived>
+HRESULT STDMETHODCALLTYPE DispatchImpl<Derived>::QueryInterface(REFIID iid,
+    void **ppv)
+{
+    if (!ppv) {
+        return E_POINTER;
+    }
+    if (IsEqualIID(iid, IID_IUnknown) || IsEqualIID(iid, IID_IDispatch)) {
+        *ppv = static_cast<IDispatch*>(this);
+        AddRef();
+        return S_OK;
+    }
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+
+template <typename Derived>
+ULONG STDMETHODCALLTYPE DispatchImpl<Derived>::AddRef()
+{
+    return ++references;
+}
+
+
+template <typename Derived>
+ULONG STDMETHODCALLTYPE DispatchImpl<Derived>::Release()
+{
+    ULONG count = --references;
+    if (count == 0) {
+        delete static_cast<Derived*>(this);
+    }
+    return count;
+}
+
+
+/** \brief Servers do not provide type information.
+ */
+template <typename Derived>
+HRESULT STDMETHODCALLTYPE DispatchImpl<Derived>::GetTypeInfoCount(UINT *count)
+{
+    if (!count) {
+        return E_INVALIDARG;
+    }
+    *count = 0;
+    return S_OK;
+}
+
+
+template <typename Derived>
+HRESULT STDMETHODCALLTYPE DispatchImpl<Derived>::GetTypeInfo(UINT index,
+    LCID locale,
+    ITypeInfo **info)
+{
+    if (info) {
+        *info = nullptr;
+    }
+    return DISP_E_BADINDEX;
+}
+
+
+/** \brief Resolve member name, named arguments are not supported.
+ */
+template <typename Derived>
+HRESULT STDMETHODCALLTYPE DispatchImpl<Derived>::GetIDsOfNames(REFIID iid,
+    LPOLESTR *names,
+    UINT count,
+    LCID locale,
+    DISPID *ids)
+{
+    if (!IsEqualIID(iid, IID_NULL)) {
+        return DISP_E_UNKNOWNINTERFACE;
+    }
+    if (count == 0) {
+        return S_OK;
+    }
+    if (!names || !ids) {
+        return E_INVALIDARG;
+    }
+
+    const auto &table = Derived::dispatchTable();
+    LONG index = table.find(names[0]);
+    ids[0] = index < 0 ? DISPID_UNKNOWN : table[index].id;
+    for (UINT i = 1; i < count; ++i) {
+        ids[i] = DISPID_UNKNOWN;
+    }
+
+    return (index < 0 || count > 1) ? DISP_E_UNKNOWNNAME : S_OK;
+}
+
+
+template <typename Derived>
+HRESULT STDMETHODCALLTYPE DispatchImpl<Derived>::Invoke(DISPID member,
+    REFIID iid,
+    LCID locale,
+    WORD flags,
+    DISPPARAMS *params,
+    VARIANT *result,
+    EXCEPINFO *exception,
+    UINT *error)
+{
+    if (!IsEqualIID(iid, IID_NULL)) {
+        return DISP_E_UNKNOWNINTERFACE;
+    }
+    if (!params) {
+        return E_INVALIDARG;
+    }
+
+    const auto &table = Derived::dispatchTable();
+    return table.invoke(static_cast<Derived&>(*this), member, flags, *params, result, exception, error);
+}
+
+}   /* autocom */
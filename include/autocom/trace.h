@@ -0,0 +1,166 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Opt-in tracing and latency histograms for IDispatch calls.
+ *
+ *  While tracing is enabled, every `IDispatch::Invoke` made through
+ *  AutoCOM is timed and recorded into a ring buffer owned by the
+ *  calling thread, and into a latency histogram for the member. When
+ *  disabled, each call site costs a single relaxed load and branch.
+ */
+
+#pragma once
+
+#include <oaidl.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace autocom
+{
+namespace trace
+{
+// CONSTANTS
+// ---------
+
+/** Set while calls are recorded.
+ */
+extern std::atomic<bool> ENABLED;
+
+/** Events kept by each thread, before the oldest are overwritten.
+ */
+const size_t RING_SIZE = 16384;
+
+// OBJECTS
+// -------
+
+
+/** \brief Recorded call to IDispatch::Invoke.
+ *
+ *  \param start                Nanoseconds since tracing was first
+ *                              enabled.
+ *  \param duration             Wall time in nanoseconds.
+ *  \param name                 Index of the member name, or 0 if the
+ *                              call was made by DISPID.
+ *  \param thread               Index of the recording thread, reused
+ *                              once the thread exits.
+ */
+struct Event
+{
+    uint64_t start;
+    uint64_t duration;
+    DISPID member;
+    HRESULT hr;
+    uint32_t name;
+    uint32_t thread;
+    WORD flags;
+    WORD arguments;
+};
+
+
+/** \brief Log-linear latency histogram, in nanoseconds.
+ *
+ *  Each power of two is split into 16 linear sub-buckets, bounding
+ *  the relative error of recorded values to 1/16.
+ */
+class Histogram
+{
+public:
+    static const size_t SUB_BUCKETS = 16;
+    static const size_t BUCKETS = 64 * SUB_BUCKETS;
+
+protected:
+    std::array<uint64_t, BUCKETS> counts;
+    uint64_t samples = 0;
+    uint64_t accumulated = 0;
+    uint64_t low = UINT64_MAX;
+    uint64_t high = 0;
+
+public:
+    Histogram();
+
+    void record(const uint64_t value);
+    void merge(const Histogram &other);
+
+    static size_t bucket(const uint64_t value);
+    static uint64_t lower(const size_t bucket);
+
+    // STATISTICS
+    uint64_t count() const;
+    uint64_t sum() const;
+    uint64_t minimum() const;
+    uint64_t maximum() const;
+    double mean() const;
+    uint64_t percentile(const double percent) const;
+};
+
+
+/** \brief Aggregated latencies for a single member.
+ */
+struct MemberStatistics
+{
+    std::string name;
+    DISPID member;
+    uint64_t failures;
+    Histogram latency;
+};
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Check if calls are recorded.
+ */
+inline bool enabled()
+{
+    return ENABLED.load(std::memory_order_relaxed);
+}
+
+/** \brief Start or stop recording calls.
+ */
+void enable(const bool value = true);
+
+/** \brief Discard recorded events and histograms.
+ */
+void clear();
+
+/** \brief Call and record IDispatch::Invoke.
+ *
+ *  \param name                 Member name, or null if called by DISPID.
+ */
+HRESULT invoke(IDispatch *dispatch,
+    const DISPID member,
+    const wchar_t *name,
+    const WORD flags,
+    DISPPARAMS *params,
+    VARIANT *result,
+    EXCEPINFO *exception = nullptr,
+    UINT *error = nullptr);
+
+/** \brief Get name of member, from the index in an event.
+ */
+std::string name(const uint32_t index);
+
+/** \brief Get events retained by every thread, ordered by start time.
+ */
+std::vector<Event> events();
+
+/** \brief Get latency histograms, aggregated over threads, by member.
+ */
+std::vector<MemberStatistics> statistics();
+
+/** \brief Serialize retained events in the Chrome trace-event format.
+ */
+std::string chromeTrace();
+
+/** \brief Write retained events to a Chrome trace-event JSON file.
+ */
+void writeChromeTrace(const std::string &path);
+
+}   /* trace */
+}   /* autocom */
@@ -13,6 +13,9 @@
 
 #include <oaidl.h>
 
+#include <string>
+#include <vector>
+
 
 namespace autocom
 {
@@ -78,6 +81,7 @@ class TypeInfo
 protected:
     ITypeInfoPtr ppv = nullptr;
 
+    friend class RecordInfo;
     friend bool operator==(const TypeInfo &left,
         const TypeInfo &right);
     friend bool operator!=(const TypeInfo &left,
@@ -104,9 +108,11 @@ public:
     INT flags(const UINT index) const;
     DllEntry entry(const MEMBERID id,
         const INVOKEKIND invocation) const;
+    std::vector<std::string> names(const MEMBERID id) const;
 
     // WINAPI
     Documentation GetDocumentation(const MEMBERID id) const;
+    std::vector<std::string> GetNames(const MEMBERID id) const;
     TypeInfo GetRefTypeInfo(const HREFTYPE type) const;
     HREFTYPE GetRefTypeOfImplType(const UINT index) const;
     INT GetImplTypeFlags(const UINT index) const;
@@ -313,6 +319,7 @@ public:
     const VARIANT & variant() const;
     WORD flags() const;
     VARKIND kind() const;
+    ULONG offset() const;
 
     // WINAPI
     MEMBERID memid() const;
@@ -320,6 +327,7 @@ public:
     const VARIANT & lpvarValue() const;
     WORD wVarFlags() const;
     VARKIND varkind() const;
+    ULONG oInst() const;
 };
 
 
@@ -474,6 +482,7 @@ public:
     TypeDesc type() const;
     IdlDesc idl() const;
     ParamDesc param() const;
+    USHORT flags() const;
 
     // WINAPI
     TypeDesc tdesc() const;
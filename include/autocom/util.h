@@ -11,7 +11,9 @@
 #include <autocom/util/define.h>
 #include <autocom/util/enum.h>
 #include <autocom/util/exception.h>
+#include <autocom/util/result.h>
 #include <autocom/util/sfinae.h>
 #include <autocom/util/shared_ptr.h>
 #include <autocom/util/type.h>
+#include <autocom/util/unicode.h>
 #include <autocom/util/variadic.h>
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <wtypes.h>
+
 #include <stdexcept>
 #include <string>
 #include <typeinfo>
@@ -72,4 +74,24 @@ public:
 };
 
 
+/** \brief Wraps a failed HRESULT from a COM call.
+ */
+class ComResultError: public std::exception
+{
+protected:
+    std::string message;
+    HRESULT hr;
+
+    virtual const char *what() const throw()
+    {
+        return message.data();
+    }
+
+public:
+    ComResultError(const HRESULT hr);
+
+    HRESULT code() const;
+};
+
+
 }   /* autocom */
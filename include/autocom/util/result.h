@@ -0,0 +1,262 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Value or HRESULT returned from a COM call.
+ */
+
+#pragma once
+
+#include <autocom/util/exception.h>
+
+#include <wtypes.h>
+#include <winerror.h>
+
+#include <utility>
+
+
+namespace autocom
+{
+// OBJECTS
+// -------
+
+
+/** \brief Value returned from a COM call, or the HRESULT on failure.
+ *
+ *  Checking a result never throws or allocates, so failures stay
+ *  cheap for calls that are expected to fail. Accessing the value of
+ *  a failed result throws ComResultError.
+ */
+template <typename T>
+class Result
+{
+protected:
+    HRESULT hr = E_FAIL;
+    T item = T();
+
+public:
+    typedef T value_type;
+
+    Result() = default;
+    Result(const Result&) = default;
+    Result & operator=(const Result&) = default;
+    Result(Result&&) = default;
+    Result & operator=(Result&&) = default;
+
+    Result(const HRESULT hr);
+    Result(const HRESULT hr,
+        const T &item);
+    Result(const HRESULT hr,
+        T &&item);
+
+    // DATA
+    explicit operator bool() const;
+    bool succeeded() const;
+    bool failed() const;
+    HRESULT code() const;
+    T & value() &;
+    const T & value() const &;
+    T && value() &&;
+    T valueOr(const T &other) const &;
+    T valueOr(T &&other) &&;
+};
+
+
+/** \brief HRESULT returned from a COM call without a value.
+ */
+template <>
+class Result<void>
+{
+protected:
+    HRESULT hr = E_FAIL;
+
+public:
+    typedef void value_type;
+
+    Result() = default;
+    Result(const Result&) = default;
+    Result & operator=(const Result&) = default;
+    Result(Result&&) = default;
+    Result & operator=(Result&&) = default;
+
+    Result(const HRESULT hr);
+
+    // DATA
+    explicit operator bool() const;
+    bool succeeded() const;
+    bool failed() const;
+    HRESULT code() const;
+    void value() const;
+};
+
+// IMPLEMENTATION
+// --------------
+
+
+/** \brief Initialize result from HRESULT, without a value.
+ */
+template <typename T>
+Result<T>::Result(const HRESULT hr):
+    hr(hr)
+{}
+
+
+/** \brief Initialize result from HRESULT and copied value.
+ */
+template <typename T>
+Result<T>::Result(const HRESULT hr,
+        const T &item):
+    hr(hr),
+    item(item)
+{}
+
+
+/** \brief Initialize result from HRESULT and moved value.
+ */
+template <typename T>
+Result<T>::Result(const HRESULT hr,
+        T &&item):
+    hr(hr),
+    item(std::move(item))
+{}
+
+
+/** \brief Check if the call succeeded.
+ */
+template <typename T>
+Result<T>::operator bool() const
+{
+    return succeeded();
+}
+
+
+/** \brief Check if the call succeeded.
+ */
+template <typename T>
+bool Result<T>::succeeded() const
+{
+    return SUCCEEDED(hr);
+}
+
+
+/** \brief Check if the call failed.
+ */
+template <typename T>
+bool Result<T>::failed() const
+{
+    return FAILED(hr);
+}
+
+
+/** \brief Get HRESULT from the call.
+ */
+template <typename T>
+HRESULT Result<T>::code() const
+{
+    return hr;
+}
+
+
+/** \brief Get value, throwing if the call failed.
+ */
+template <typename T>
+T & Result<T>::value() &
+{
+    if (failed()) {
+        throw ComResultError(hr);
+    }
+    return item;
+}
+
+
+/** \brief Get value, throwing if the call failed.
+ */
+template <typename T>
+const T & Result<T>::value() const &
+{
+    if (failed()) {
+        throw ComResultError(hr);
+    }
+    return item;
+}
+
+
+/** \brief Move value out of result, throwing if the call failed.
+ */
+template <typename T>
+T && Result<T>::value() &&
+{
+    if (failed()) {
+        throw ComResultError(hr);
+    }
+    return std::move(item);
+}
+
+
+/** \brief Get value, or a fallback if the call failed.
+ */
+template <typename T>
+T Result<T>::valueOr(const T &other) const &
+{
+    return succeeded() ? item : other;
+}
+
+
+/** \brief Move value out of result, or a fallback if the call failed.
+ */
+template <typename T>
+T Result<T>::valueOr(T &&other) &&
+{
+    return succeeded() ? std::move(item) : std::move(other);
+}
+
+
+/** \brief Initialize result from HRESULT.
+ */
+inline Result<void>::Result(const HRESULT hr):
+    hr(hr)
+{}
+
+
+/** \brief Check if the call succeeded.
+ */
+inline Result<void>::operator bool() const
+{
+    return succeeded();
+}
+
+
+/** \brief Check if the call succeeded.
+ */
+inline bool Result<void>::succeeded() const
+{
+    return SUCCEEDED(hr);
+}
+
+
+/** \brief Check if the call failed.
+ */
+inline bool Result<void>::failed() const
+{
+    return FAILED(hr);
+}
+
+
+/** \brief Get HRESULT from the call.
+ */
+inline HRESULT Result<void>::code() const
+{
+    return hr;
+}
+
+
+/** \brief Throw if the call failed.
+ */
+inline void Result<void>::value() const
+{
+    if (failed()) {
+        throw ComResultError(hr);
+    }
+}
+
+}   /* autocom */
@@ -278,6 +278,24 @@ struct VariantType<SafeArray<T>, true>
 };
 
 
+/** \brief Specialize VARIANT array elements.
+ */
+template <>
+struct VariantType<VARIANT, true>
+{
+    static constexpr VARTYPE vt = VT_VARIANT;
+};
+
+
+/** \brief Specialize Variant array elements.
+ */
+template <>
+struct VariantType<Variant, true>
+{
+    static constexpr VARTYPE vt = VT_VARIANT;
+};
+
+
 // GENERIC
 /** CANNOT specialize the generic SAFEARRAY class, since SafeArrayGetVartype
  *  is the best way to determine the vartype.
@@ -289,8 +307,10 @@ AUTOCOM_SPECIALIZER(CHAR, VT_I1);
 AUTOCOM_SPECIALIZER(UCHAR, VT_UI1);
 AUTOCOM_SPECIALIZER(SHORT, VT_I2);
 AUTOCOM_SPECIALIZER(USHORT, VT_UI2);
+#if !defined(AUTOCOM_LONG_IS_INT)
 AUTOCOM_SPECIALIZER(INT, VT_INT);
 AUTOCOM_SPECIALIZER(UINT, VT_UINT);
+#endif          // AUTOCOM_LONG_IS_INT
 AUTOCOM_SPECIALIZER(LONG, VT_I4);
 AUTOCOM_SPECIALIZER(ULONG, VT_UI4);
 AUTOCOM_SPECIALIZER(LONGLONG, VT_I8);
@@ -0,0 +1,35 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Conversions between UTF-8 and wide strings.
+ *
+ *  `wchar_t` is UTF-16 on Windows and UTF-32 elsewhere, so wide
+ *  strings cannot be passed to the UTF-16 codecs directly.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+namespace autocom
+{
+// FUNCTIONS
+// ---------
+
+/** \brief Convert UTF-8 string to a wide string.
+ */
+std::wstring utf8ToWide(const std::string &string);
+
+/** \brief Convert wide character array to UTF-8.
+ */
+std::string wideToUtf8(const wchar_t *string,
+    const size_t length);
+
+/** \brief Convert null-terminated wide string to UTF-8.
+ */
+std::string wideToUtf8(const wchar_t *string);
+
+}   /* autocom */
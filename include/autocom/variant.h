@@ -310,8 +310,10 @@ AUTOCOM_PRIMITIVE_SETTER(CHAR);
 AUTOCOM_PRIMITIVE_SETTER(UCHAR);
 AUTOCOM_PRIMITIVE_SETTER(SHORT);
 AUTOCOM_PRIMITIVE_SETTER(USHORT);
+#if !defined(AUTOCOM_LONG_IS_INT)
 AUTOCOM_PRIMITIVE_SETTER(INT);
 AUTOCOM_PRIMITIVE_SETTER(UINT);
+#endif          // AUTOCOM_LONG_IS_INT
 AUTOCOM_PRIMITIVE_SETTER(LONG);
 AUTOCOM_PRIMITIVE_SETTER(ULONG);
 AUTOCOM_PRIMITIVE_SETTER(LONGLONG);
@@ -559,8 +561,10 @@ AUTOCOM_GETTER(CHAR);
 AUTOCOM_GETTER(UCHAR);
 AUTOCOM_GETTER(SHORT);
 AUTOCOM_GETTER(USHORT);
+#if !defined(AUTOCOM_LONG_IS_INT)
 AUTOCOM_GETTER(INT);
 AUTOCOM_GETTER(UINT);
+#endif          // AUTOCOM_LONG_IS_INT
 AUTOCOM_GETTER(LONG);
 AUTOCOM_GETTER(ULONG);
 AUTOCOM_GETTER(FLOAT);
@@ -0,0 +1,769 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Read-only, non-owning view over SafeArray data.
+ */
+
+#pragma once
+
+#include <autocom/safearray.h>
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace autocom
+{
+// FUNCTIONS
+// ---------
+
+
+/** \brief Get byte offset of a data member, like `offsetof`, from a
+ *  pointer to member.
+ */
+template <typename T, typename U>
+size_t memberOffset(U T::*member)
+{
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    const auto *object = reinterpret_cast<const T*>(&storage);
+    const auto *field = &(object->*member);
+    return reinterpret_cast<const char*>(field) - reinterpret_cast<const char*>(object);
+}
+
+// OBJECTS
+// -------
+
+
+/** \brief Random-access iterator over elements separated by a fixed
+ *  byte stride.
+ */
+template <typename T>
+class StridedIterator
+{
+protected:
+    typedef StridedIterator<T> This;
+
+    const char *pointer_ = nullptr;
+    size_t stride = sizeof(T);
+
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef const T& reference;
+
+    StridedIterator() = default;
+    StridedIterator(const This&) = default;
+    This & operator=(const This&) = default;
+
+    StridedIterator(const char *data,
+        const size_t stride);
+
+    reference operator*() const;
+    pointer operator->() const;
+    reference operator[](const difference_type n) const;
+
+    This & operator++();
+    This operator++(int);
+    This & operator--();
+    This operator--(int);
+    This & operator+=(const difference_type n);
+    This & operator-=(const difference_type n);
+    This operator+(const difference_type n) const;
+    This operator-(const difference_type n) const;
+    difference_type operator-(const This &other) const;
+
+    bool operator==(const This &other) const;
+    bool operator!=(const This &other) const;
+    bool operator<(const This &other) const;
+    bool operator<=(const This &other) const;
+    bool operator>(const This &other) const;
+    bool operator>=(const This &other) const;
+};
+
+
+/** \brief Read-only view over a single field of an array of records.
+ *
+ *  Provides a zero-copy, struct-of-arrays projection: elements are
+ *  read in place from each record, `stride` bytes apart.
+ */
+template <typename T>
+class StridedView
+{
+protected:
+    const char *first = nullptr;
+    size_t length = 0;
+    size_t stride_ = sizeof(T);
+
+public:
+    typedef T value_type;
+    typedef const T& const_reference;
+    typedef StridedIterator<T> const_iterator;
+    typedef const_iterator iterator;
+
+    StridedView() = default;
+    StridedView(const StridedView&) = default;
+    StridedView & operator=(const StridedView&) = default;
+
+    StridedView(const T *data,
+        const size_t size,
+        const size_t stride);
+
+    // CAPACITY
+    size_t size() const;
+    size_t stride() const;
+    bool empty() const;
+    bool contiguous() const;
+
+    // ITERATORS
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    // ELEMENT ACCESS
+    const_reference operator[](const size_t index) const;
+    const_reference at(const size_t index) const;
+    const T * data() const;
+
+    // CONVERSIONS
+    void copy(T *out) const;
+    std::vector<T> vector() const;
+};
+
+
+/** \brief Read-only view over contiguous SafeArray data.
+ *
+ *  Views do not own the underlying memory, and are invalidated when
+ *  the source array is destroyed, resized or unlocked. Bounds are
+ *  stored in SAFEARRAY order, with the least significant dimension
+ *  last.
+ */
+template <typename T>
+class SafeArrayView
+{
+protected:
+    typedef SafeArrayView<T> This;
+
+    const T *first = nullptr;
+    std::vector<SafeArrayBound> bounds;
+
+public:
+    // MEMBER TYPES
+    // ------------
+    typedef T value_type;
+    typedef const T* pointer;
+    typedef const T* const_pointer;
+    typedef const T& reference;
+    typedef const T& const_reference;
+    typedef const_pointer iterator;
+    typedef const_pointer const_iterator;
+    typedef std::reverse_iterator<const_iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+    static constexpr VARTYPE vt = VariantType<T, true>::vt;
+
+    SafeArrayView() = default;
+    SafeArrayView(const This&) = default;
+    This & operator=(const This&) = default;
+    SafeArrayView(This&&) = default;
+    This & operator=(This&&) = default;
+
+    SafeArrayView(const SafeArray<T> &array);
+    SafeArrayView(const SAFEARRAY *array);
+    SafeArrayView(const_pointer data,
+        std::vector<SafeArrayBound> bounds);
+
+    // CAPACITY
+    size_t size(const LONG dimension = -1) const;
+    USHORT dimensions() const;
+    const SafeArrayBound & bound(const USHORT dimension) const;
+    bool empty() const;
+
+    // ITERATORS
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+    const_iterator cbegin() const noexcept;
+    const_iterator cend() const noexcept;
+    const_reverse_iterator rbegin() const noexcept;
+    const_reverse_iterator rend() const noexcept;
+    const_reverse_iterator crbegin() const noexcept;
+    const_reverse_iterator crend() const noexcept;
+
+    // ELEMENT ACCESS
+    const_reference operator[](const size_t index) const;
+    const_reference at(const size_t index) const;
+    const_reference front() const;
+    const_reference back() const;
+    const_pointer data() const;
+
+    // PROJECTIONS
+    template <typename U, typename Owner = T>
+    StridedView<U> column(U Owner::*member) const;
+};
+
+// IMPLEMENTATION
+// --------------
+
+
+/** \brief Initialize from address of first element and byte stride.
+ */
+template <typename T>
+StridedIterator<T>::StridedIterator(const char *data,
+        const size_t stride):
+    pointer_(data),
+    stride(stride)
+{}
+
+
+/** \brief Dereference iterator.
+ */
+template <typename T>
+auto StridedIterator<T>::operator*() const
+    -> reference
+{
+    return *reinterpret_cast<pointer>(pointer_);
+}
+
+
+/** \brief Dereference iterator.
+ */
+template <typename T>
+auto StridedIterator<T>::operator->() const
+    -> pointer
+{
+    return reinterpret_cast<pointer>(pointer_);
+}
+
+
+/** \brief Get element at offset from iterator.
+ */
+template <typename T>
+auto StridedIterator<T>::operator[](const difference_type n) const
+    -> reference
+{
+    return *reinterpret_cast<pointer>(pointer_ + n * difference_type(stride));
+}
+
+
+/** \brief Pre-increment iterator.
+ */
+template <typename T>
+auto StridedIterator<T>::operator++()
+    -> This &
+{
+    pointer_ += stride;
+    return *this;
+}
+
+
+/** \brief Post-increment iterator.
+ */
+template <typename T>
+auto StridedIterator<T>::operator++(int)
+    -> This
+{
+    This copy(*this);
+    pointer_ += stride;
+    return copy;
+}
+
+
+/** \brief Pre-decrement iterator.
+ */
+template <typename T>
+auto StridedIterator<T>::operator--()
+    -> This &
+{
+    pointer_ -= stride;
+    return *this;
+}
+
+
+/** \brief Post-decrement iterator.
+ */
+template <typename T>
+auto StridedIterator<T>::operator--(int)
+    -> This
+{
+    This copy(*this);
+    pointer_ -= stride;
+    return copy;
+}
+
+
+/** \brief Advance iterator.
+ */
+template <typename T>
+auto StridedIterator<T>::operator+=(const difference_type n)
+    -> This &
+{
+    pointer_ += n * difference_type(stride);
+    return *this;
+}
+
+
+/** \brief Move iterator backwards.
+ */
+template <typename T>
+auto StridedIterator<T>::operator-=(const difference_type n)
+    -> This &
+{
+    pointer_ -= n * difference_type(stride);
+    return *this;
+}
+
+
+/** \brief Get advanced iterator.
+ */
+template <typename T>
+auto StridedIterator<T>::operator+(const difference_type n) const
+    -> This
+{
+    return This(*this) += n;
+}
+
+
+/** \brief Get iterator moved backwards.
+ */
+template <typename T>
+auto StridedIterator<T>::operator-(const difference_type n) const
+    -> This
+{
+    return This(*this) -= n;
+}
+
+
+/** \brief Get distance between iterators.
+ */
+template <typename T>
+auto StridedIterator<T>::operator-(const This &other) const
+    -> difference_type
+{
+    return (pointer_ - other.pointer_) / difference_type(stride);
+}
+
+
+/** \brief Equality operator.
+ */
+template <typename T>
+bool StridedIterator<T>::operator==(const This &other) const
+{
+    return pointer_ == other.pointer_;
+}
+
+
+/** \brief Inequality operator.
+ */
+template <typename T>
+bool StridedIterator<T>::operator!=(const This &other) const
+{
+    return pointer_ != other.pointer_;
+}
+
+
+/** \brief Less-than operator.
+ */
+template <typename T>
+bool StridedIterator<T>::operator<(const This &other) const
+{
+    return pointer_ < other.pointer_;
+}
+
+
+/** \brief Less-than-or-equal operator.
+ */
+template <typename T>
+bool StridedIterator<T>::operator<=(const This &other) const
+{
+    return pointer_ <= other.pointer_;
+}
+
+
+/** \brief Greater-than operator.
+ */
+template <typename T>
+bool StridedIterator<T>::operator>(const This &other) const
+{
+    return pointer_ > other.pointer_;
+}
+
+
+/** \brief Greater-than-or-equal operator.
+ */
+template <typename T>
+bool StridedIterator<T>::operator>=(const This &other) const
+{
+    return pointer_ >= other.pointer_;
+}
+
+
+/** \brief Initialize from first element, count and byte stride.
+ */
+template <typename T>
+StridedView<T>::StridedView(const T *data,
+        const size_t size,
+        const size_t stride):
+    first(reinterpret_cast<const char*>(data)),
+    length(size),
+    stride_(stride)
+{}
+
+
+/** \brief Get number of elements.
+ */
+template <typename T>
+size_t StridedView<T>::size() const
+{
+    return length;
+}
+
+
+/** \brief Get byte distance between consecutive elements.
+ */
+template <typename T>
+size_t StridedView<T>::stride() const
+{
+    return stride_;
+}
+
+
+/** \brief Check if view is empty.
+ */
+template <typename T>
+bool StridedView<T>::empty() const
+{
+    return length == 0;
+}
+
+
+/** \brief Check if elements are packed without gaps.
+ */
+template <typename T>
+bool StridedView<T>::contiguous() const
+{
+    return stride_ == sizeof(T);
+}
+
+
+/** \brief Get iterator at beginning of view.
+ */
+template <typename T>
+auto StridedView<T>::begin() const
+    -> const_iterator
+{
+    return const_iterator(first, stride_);
+}
+
+
+/** \brief Get iterator past end of view.
+ */
+template <typename T>
+auto StridedView<T>::end() const
+    -> const_iterator
+{
+    return const_iterator(first + length * stride_, stride_);
+}
+
+
+/** \brief Get element at index.
+ */
+template <typename T>
+auto StridedView<T>::operator[](const size_t index) const
+    -> const_reference
+{
+    return *reinterpret_cast<const T*>(first + index * stride_);
+}
+
+
+/** \brief Get element at index, with bounds checking.
+ */
+template <typename T>
+auto StridedView<T>::at(const size_t index) const
+    -> const_reference
+{
+    if (index >= length) {
+        throw std::out_of_range("StridedView:: Index is out of bounds");
+    }
+    return operator[](index);
+}
+
+
+/** \brief Get pointer to first element.
+ */
+template <typename T>
+const T * StridedView<T>::data() const
+{
+    return reinterpret_cast<const T*>(first);
+}
+
+
+/** \brief Gather elements into contiguous buffer of `size()` elements.
+ */
+template <typename T>
+void StridedView<T>::copy(T *out) const
+{
+    const char *src = first;
+    for (size_t i = 0; i < length; ++i, src += stride_) {
+        out[i] = *reinterpret_cast<const T*>(src);
+    }
+}
+
+
+/** \brief Gather elements into vector.
+ */
+template <typename T>
+std::vector<T> StridedView<T>::vector() const
+{
+    std::vector<T> out(length);
+    copy(out.data());
+    return out;
+}
+
+
+/** \brief Initialize view from locked SafeArray.
+ */
+template <typename T>
+SafeArrayView<T>::SafeArrayView(const SafeArray<T> &array):
+    SafeArrayView(array.array)
+{}
+
+
+/** \brief Initialize view from locked SAFEARRAY.
+ *
+ *  \warning The SAFEARRAY must stay locked for the lifetime of the view.
+ */
+template <typename T>
+SafeArrayView<T>::SafeArrayView(const SAFEARRAY *array)
+{
+    if (array) {
+        if (vt != getSafeArrayType(array)) {
+            throw std::invalid_argument("SafeArrayView type does not match SAFEARRAY.");
+        } else if (vt == VT_RECORD && array->cbElements != sizeof(T)) {
+            throw std::invalid_argument("SafeArrayView record size " + std::to_string(array->cbElements) + " does not match C++ struct size " + std::to_string(sizeof(T)) + ".");
+        }
+        first = reinterpret_cast<const_pointer>(array->pvData);
+        bounds.assign(array->rgsabound, array->rgsabound + array->cDims);
+    }
+}
+
+
+/** \brief Initialize view from raw data and bounds.
+ */
+template <typename T>
+SafeArrayView<T>::SafeArrayView(const_pointer data,
+        std::vector<SafeArrayBound> bounds):
+    first(data),
+    bounds(std::move(bounds))
+{}
+
+
+/** \brief Get number of elements in view, or in a single dimension.
+ */
+template <typename T>
+size_t SafeArrayView<T>::size(const LONG dimension) const
+{
+    if (dimension >= static_cast<LONG>(bounds.size())) {
+        throw std::out_of_range("SafeArrayView:: Size requested is out of bounds");
+    }
+
+    if (dimension < 0) {
+        if (bounds.empty()) {
+            return 0;
+        }
+        size_t size = 1;
+        for (const auto &bound: bounds) {
+            size *= bound.cElements;
+        }
+        return size;
+    }
+    return bounds[dimension].cElements;
+}
+
+
+/** \brief Get number of dimensions.
+ */
+template <typename T>
+USHORT SafeArrayView<T>::dimensions() const
+{
+    return static_cast<USHORT>(bounds.size());
+}
+
+
+/** \brief Get bounds for a single dimension.
+ */
+template <typename T>
+const SafeArrayBound & SafeArrayView<T>::bound(const USHORT dimension) const
+{
+    return bounds.at(dimension);
+}
+
+
+/** \brief Check if view is empty.
+ */
+template <typename T>
+bool SafeArrayView<T>::empty() const
+{
+    return size(-1) == 0;
+}
+
+
+/** \brief Get iterator at beginning of view.
+ */
+template <typename T>
+auto SafeArrayView<T>::begin() const noexcept
+    -> const_iterator
+{
+    return first;
+}
+
+
+/** \brief Get iterator past end of view.
+ */
+template <typename T>
+auto SafeArrayView<T>::end() const noexcept
+    -> const_iterator
+{
+    return first + size(-1);
+}
+
+
+/** \brief Get iterator at beginning of view.
+ */
+template <typename T>
+auto SafeArrayView<T>::cbegin() const noexcept
+    -> const_iterator
+{
+    return begin();
+}
+
+
+/** \brief Get iterator past end of view.
+ */
+template <typename T>
+auto SafeArrayView<T>::cend() const noexcept
+    -> const_iterator
+{
+    return end();
+}
+
+
+/** \brief Get iterator at reverse beginning of view.
+ */
+template <typename T>
+auto SafeArrayView<T>::rbegin() const noexcept
+    -> const_reverse_iterator
+{
+    return const_reverse_iterator(end());
+}
+
+
+/** \brief Get iterator past reverse end of view.
+ */
+template <typename T>
+auto SafeArrayView<T>::rend() const noexcept
+    -> const_reverse_iterator
+{
+    return const_reverse_iterator(begin());
+}
+
+
+/** \brief Get iterator at reverse beginning of view.
+ */
+template <typename T>
+auto SafeArrayView<T>::crbegin() const noexcept
+    -> const_reverse_iterator
+{
+    return rbegin();
+}
+
+
+/** \brief Get iterator past reverse end of view.
+ */
+template <typename T>
+auto SafeArrayView<T>::crend() const noexcept
+    -> const_reverse_iterator
+{
+    return rend();
+}
+
+
+/** \brief Get element at flat index.
+ */
+template <typename T>
+auto SafeArrayView<T>::operator[](const size_t index) const
+    -> const_reference
+{
+    return first[index];
+}
+
+
+/** \brief Get element at flat index, with bounds checking.
+ */
+template <typename T>
+auto SafeArrayView<T>::at(const size_t index) const
+    -> const_reference
+{
+    if (index >= size(-1)) {
+        throw std::out_of_range("SafeArrayView:: Index is out of bounds");
+    }
+    return first[index];
+}
+
+
+/** \brief Get first element in view.
+ */
+template <typename T>
+auto SafeArrayView<T>::front() const
+    -> const_reference
+{
+    return *begin();
+}
+
+
+/** \brief Get last element in view.
+ */
+template <typename T>
+auto SafeArrayView<T>::back() const
+    -> const_reference
+{
+    return *(end() - 1);
+}
+
+
+/** \brief Get access to underlying buffer.
+ */
+template <typename T>
+auto SafeArrayView<T>::data() const
+    -> const_pointer
+{
+    return first;
+}
+
+
+/** \brief Project a single record field as a strided view.
+ *
+ *  \code
+ *      auto mz = view.column(&MS_PrecursorInfo::dMonoIsoMZ);
+ *  \endcode
+ */
+template <typename T>
+template <typename U, typename Owner>
+StridedView<U> SafeArrayView<T>::column(U Owner::*member) const
+{
+    if (!first) {
+        return StridedView<U>();
+    }
+    return StridedView<U>(&(first->*member), size(-1), sizeof(T));
+}
+
+
+/** \brief Write implementation for constexpr.
+ */
+template <typename T>
+constexpr VARTYPE SafeArrayView<T>::vt;
+
+}   /* autocom */
@@ -0,0 +1,260 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Single-threaded apartment worker threads.
+ *
+ *  Apartment-threaded servers may only be called from the thread
+ *  which created them, and that thread must pump messages. Each
+ *  `StaWorker` owns a thread in its own STA, and runs submitted calls
+ *  from its message loop. An `StaPool` spreads objects over several
+ *  workers, and pins each object to the worker which created it.
+ */
+
+#pragma once
+
+#include <autocom/com.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace autocom
+{
+// OBJECTS
+// -------
+
+template <typename T>
+class Pinned;
+
+
+/** \brief Thread in its own single-threaded apartment.
+ *
+ *  Calls submitted from other threads are queued and run in order
+ *  from the worker's message loop. Calls submitted from the worker
+ *  itself run immediately, to avoid waiting on the worker's own
+ *  queue.
+ */
+class StaWorker
+{
+protected:
+    typedef std::function<void()> Task;
+
+    std::thread thread;
+    DWORD id = 0;
+    mutable std::mutex mutex;
+    std::deque<Task> tasks;
+    bool stopped = false;
+
+    void run(std::promise<DWORD> ready,
+        const ApartmentConfig config);
+    void drain();
+    void post(Task &&task);
+
+public:
+    explicit StaWorker(const DWORD flags = COINIT_DISABLE_OLE1DDE);
+    StaWorker(const StaWorker&) = delete;
+    StaWorker & operator=(const StaWorker&) = delete;
+    ~StaWorker();
+
+    void stop();
+
+    // CALLS
+    template <typename F>
+    auto submit(F &&function) -> std::future<typename std::result_of<F()>::type>;
+
+    template <typename F>
+    auto invoke(F &&function) -> typename std::result_of<F()>::type;
+
+    // DATA
+    bool current() const;
+    size_t pending() const;
+};
+
+
+/** \brief Fixed-size pool of STA workers.
+ */
+class StaPool
+{
+protected:
+    std::vector<std::unique_ptr<StaWorker>> workers;
+    std::atomic<size_t> next;
+
+public:
+    explicit StaPool(size_t size = 0,
+        const DWORD flags = COINIT_DISABLE_OLE1DDE);
+    StaPool(const StaPool&) = delete;
+    StaPool & operator=(const StaPool&) = delete;
+
+    size_t size() const;
+    StaWorker & worker(const size_t index);
+    StaWorker & route();
+
+    template <typename F>
+    auto pin(F &&factory) -> Pinned<typename std::result_of<F()>::type>;
+};
+
+
+/** \brief Object pinned to the STA worker which created it.
+ *
+ *  Calls run on the owning worker, and the object is destroyed on
+ *  the owning worker once the last copy is released. The worker must
+ *  outlive every pinned object.
+ */
+template <typename T>
+class Pinned
+{
+protected:
+    StaWorker *owner = nullptr;
+    std::shared_ptr<T> object;
+
+public:
+    Pinned() = default;
+    Pinned(const Pinned&) = default;
+    Pinned & operator=(const Pinned&) = default;
+    Pinned(Pinned&&) = default;
+    Pinned & operator=(Pinned&&) = default;
+
+    Pinned(StaWorker &worker,
+        T *object);
+
+    // CALLS
+    template <typename F>
+    auto submit(F &&function) -> std::future<typename std::result_of<F(T&)>::type>;
+
+    template <typename F>
+    auto invoke(F &&function) -> typename std::result_of<F(T&)>::type;
+
+    // DATA
+    StaWorker & worker() const;
+    explicit operator bool() const;
+};
+
+
+// IMPLEMENTATION
+// --------------
+
+
+/** \brief Run function on the worker thread.
+ */
+template <typename F>
+auto StaWorker::submit(F &&function)
+    -> std::future<typename std::result_of<F()>::type>
+{
+    typedef typename std::result_of<F()>::type Result;
+
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+    auto future = task->get_future();
+    if (current()) {
+        (*task)();
+    } else {
+        post([task]() { (*task)(); });
+    }
+
+    return future;
+}
+
+
+/** \brief Run function on the worker thread, and wait for the result.
+ */
+template <typename F>
+auto StaWorker::invoke(F &&function)
+    -> typename std::result_of<F()>::type
+{
+    return submit(std::forward<F>(function)).get();
+}
+
+
+/** \brief Create object on the next worker, and pin it there.
+ *
+ *  \param factory              Returns the object by value, and is
+ *                              called on the owning worker.
+ */
+template <typename F>
+auto StaPool::pin(F &&factory)
+    -> Pinned<typename std::result_of<F()>::type>
+{
+    typedef typename std::result_of<F()>::type Object;
+
+    StaWorker &owner = route();
+    auto &function = factory;
+    Object *object = owner.invoke([&function]() {
+        return new Object(function());
+    });
+
+    return Pinned<Object>(owner, object);
+}
+
+
+/** \brief Take ownership of object created on worker.
+ */
+template <typename T>
+Pinned<T>::Pinned(StaWorker &worker,
+        T *object):
+    owner(&worker)
+{
+    StaWorker *destination = owner;
+    this->object.reset(object, [destination](T *pointer) {
+        try {
+            destination->submit([pointer]() {
+                delete pointer;
+            });
+        } catch (...) {
+            // worker stopped, and the object's apartment is gone
+        }
+    });
+}
+
+
+/** \brief Run function with the object on the owning worker.
+ */
+template <typename T>
+template <typename F>
+auto Pinned<T>::submit(F &&function)
+    -> std::future<typename std::result_of<F(T&)>::type>
+{
+    auto target = object;
+    auto call = std::forward<F>(function);
+    return owner->submit([target, call]() mutable {
+        return call(*target);
+    });
+}
+
+
+/** \brief Run function with the object on the owning worker, and wait
+ *  for the result.
+ */
+template <typename T>
+template <typename F>
+auto Pinned<T>::invoke(F &&function)
+    -> typename std::result_of<F(T&)>::type
+{
+    return submit(std::forward<F>(function)).get();
+}
+
+
+/** \brief Get owning worker.
+ */
+template <typename T>
+StaWorker & Pinned<T>::worker() const
+{
+    return *owner;
+}
+
+
+/** \brief Check if pinned object is valid.
+ */
+template <typename T>
+Pinned<T>::operator bool() const
+{
+    return bool(object);
+}
+
+}   /* autocom */
@@ -0,0 +1,268 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Allocation accounting for Bstr, Variant and SafeArray lifetimes.
+ */
+
+#include <autocom/accounting.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+namespace accounting
+{
+namespace
+{
+// CONSTANTS
+// ---------
+
+const char * const NAMES[ACCOUNT_CALLS] = {
+    "SysAllocString",
+    "SysFreeString",
+    "SafeArrayCreate",
+    "SafeArrayDestroy",
+    "SafeArrayCopy",
+    "VariantClear",
+    "VariantCopy",
+};
+
+// OBJECTS
+// -------
+
+typedef std::vector<std::pair<const char*, Counts>> Table;
+
+/** Counts of the current thread, by call site.
+ *
+ *  Call sites are few, so a linear scan comparing the tag pointers
+ *  first is faster than hashing. Identical literals from separate
+ *  translation units may not share an address, so equal tags are
+ *  merged by value.
+ */
+thread_local Table TABLE;
+
+// HELPERS
+// -------
+
+
+bool equalTag(const char *left,
+    const char *right)
+{
+    return left == right || std::strcmp(left, right) == 0;
+}
+
+
+const Counts * find(const Table &table,
+    const char *tag)
+{
+    for (const auto &entry: table) {
+        if (equalTag(entry.first, tag)) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+
+Counts & lookup(Table &table,
+    const char *tag)
+{
+    for (auto &entry: table) {
+        if (equalTag(entry.first, tag)) {
+            return entry.second;
+        }
+    }
+    table.emplace_back(tag, Counts());
+    return table.back().second;
+}
+
+
+/** \brief Subtract counts recorded before a snapshot.
+ */
+Counts difference(const Counts &current,
+    const Counts *previous)
+{
+    Counts counts = current;
+    if (previous) {
+        for (size_t i = 0; i < ACCOUNT_CALLS; ++i) {
+            counts.calls[i] -= previous->calls[i];
+        }
+    }
+    return counts;
+}
+
+}   /* anonymous */
+
+// OBJECTS
+// -------
+
+
+uint64_t & Counts::operator[](const AccountedCall call)
+{
+    return calls.at(call);
+}
+
+
+const uint64_t & Counts::operator[](const AccountedCall call) const
+{
+    return calls.at(call);
+}
+
+
+/** \brief Get number of BSTRs and SAFEARRAYs allocated.
+ */
+uint64_t Counts::allocations() const
+{
+    return calls[ACCOUNT_SYSALLOCSTRING] + calls[ACCOUNT_SAFEARRAYCREATE] + calls[ACCOUNT_SAFEARRAYCOPY];
+}
+
+
+/** \brief Get number of counted calls.
+ */
+uint64_t Counts::total() const
+{
+    uint64_t sum = 0;
+    for (uint64_t count: calls) {
+        sum += count;
+    }
+    return sum;
+}
+
+
+/** \brief Start counting from the current state of the thread.
+ */
+Scope::Scope():
+    start(TABLE)
+{}
+
+
+/** \brief Restart counting from the current state of the thread.
+ */
+void Scope::reset()
+{
+    start = TABLE;
+}
+
+
+/** \brief Get calls made since the scope started, over all call sites.
+ */
+Counts Scope::counts() const
+{
+    Counts counts;
+    for (const auto &entry: TABLE) {
+        auto delta = difference(entry.second, find(start, entry.first));
+        for (size_t i = 0; i < ACCOUNT_CALLS; ++i) {
+            counts.calls[i] += delta.calls[i];
+        }
+    }
+    return counts;
+}
+
+
+/** \brief Get calls of one kind made since the scope started.
+ */
+uint64_t Scope::count(const AccountedCall call) const
+{
+    return counts()[call];
+}
+
+
+/** \brief Get calls of one kind made from a call site.
+ */
+uint64_t Scope::count(const AccountedCall call,
+    const std::string &tag) const
+{
+    const Counts *current = find(TABLE, tag.data());
+    if (!current) {
+        return 0;
+    }
+    return difference(*current, find(start, tag.data()))[call];
+}
+
+
+/** \brief Get call sites used since the scope started, ordered by tag.
+ */
+std::vector<Site> Scope::sites() const
+{
+    std::vector<Site> list;
+    for (const auto &entry: TABLE) {
+        auto delta = difference(entry.second, find(start, entry.first));
+        if (delta.total()) {
+            list.emplace_back(Site {entry.first, delta});
+        }
+    }
+    std::sort(list.begin(), list.end(), [](const Site &left, const Site &right) {
+        return left.tag < right.tag;
+    });
+
+    return list;
+}
+
+
+/** \brief Summarize calls made since the scope started.
+ *
+ *  Each line lists a call site, followed by its non-zero counts.
+ */
+std::string Scope::report() const
+{
+    std::ostringstream stream;
+    for (const auto &site: sites()) {
+        stream << site.tag << ":";
+        const char *separator = " ";
+        for (size_t i = 0; i < ACCOUNT_CALLS; ++i) {
+            if (site.counts.calls[i]) {
+                stream << separator << NAMES[i] << " " << site.counts.calls[i];
+                separator = ", ";
+            }
+        }
+        stream << "\n";
+    }
+
+    return stream.str();
+}
+
+// FUNCTIONS
+// ---------
+
+
+void record(const AccountedCall call,
+    const char *tag)
+{
+    ++lookup(TABLE, tag).calls[call];
+}
+
+
+const char * name(const AccountedCall call)
+{
+    if (call < 0 || call >= ACCOUNT_CALLS) {
+        throw std::invalid_argument("Unknown accounted call.");
+    }
+    return NAMES[call];
+}
+
+
+std::vector<Site> threadSites()
+{
+    std::vector<Site> list;
+    for (const auto &entry: TABLE) {
+        list.emplace_back(Site {entry.first, entry.second});
+    }
+    return list;
+}
+
+}   /* accounting */
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
@@ -0,0 +1,262 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Cross-apartment interface references.
+ */
+
+#include <autocom/apartment.h>
+#include <autocom/util/exception.h>
+
+#include <objbase.h>
+
+#include <atomic>
+#include <unordered_map>
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+// OBJECTS
+// -------
+
+
+/** \brief Registration shared by copies of a handle.
+ */
+struct ApartmentHandle::State
+{
+    std::shared_ptr<InterfaceTable> table;
+    IID iid;
+    DWORD cookie = 0;
+    bool registered = false;
+    uint64_t id = 0;
+
+    ~State()
+    {
+        if (registered) {
+            table->revokeInterface(cookie);
+        }
+    }
+};
+
+namespace
+{
+// OBJECTS
+// -------
+
+
+/** \brief Proxy unmarshalled by the current thread.
+ */
+struct Proxy
+{
+    std::weak_ptr<void> owner;
+    SharedPointer<IUnknown> unknown;
+};
+
+// CONSTANTS
+// ---------
+
+/** Unique identifiers for handle registrations, never reused.
+ */
+std::atomic<uint64_t> NEXT_ID(1);
+
+/** Proxies unmarshalled by the current thread, by registration.
+ */
+thread_local std::unordered_map<uint64_t, Proxy> PROXIES;
+
+// HELPERS
+// -------
+
+
+/** \brief Release proxies of revoked registrations.
+ */
+void sweepProxies()
+{
+    for (auto it = PROXIES.begin(); it != PROXIES.end(); ) {
+        if (it->second.owner.expired()) {
+            it = PROXIES.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+}   /* anonymous */
+
+
+/** \brief Get the Global Interface Table, creating it on first use.
+ */
+HRESULT GlobalInterfaceTable::open()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (table) {
+        return S_OK;
+    }
+
+    return CoCreateInstance(CLSID_StdGlobalInterfaceTable, nullptr, CLSCTX_INPROC_SERVER, IID_IGlobalInterfaceTable, (void **) &table);
+}
+
+
+/** \brief Destructor.
+ */
+GlobalInterfaceTable::~GlobalInterfaceTable()
+{
+    if (table) {
+        table->Release();
+    }
+}
+
+
+/** \brief Get table shared by the process.
+ */
+std::shared_ptr<InterfaceTable> GlobalInterfaceTable::global()
+{
+    static std::shared_ptr<InterfaceTable> table = std::make_shared<GlobalInterfaceTable>();
+    return table;
+}
+
+
+/** \brief Register interface in the Global Interface Table.
+ */
+HRESULT GlobalInterfaceTable::registerInterface(IUnknown *unknown,
+    REFIID iid,
+    DWORD &cookie)
+{
+    HRESULT hr = open();
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    return table->RegisterInterfaceInGlobal(unknown, iid, &cookie);
+}
+
+
+/** \brief Unmarshal interface from the Global Interface Table.
+ */
+HRESULT GlobalInterfaceTable::getInterface(DWORD cookie,
+    REFIID iid,
+    void **ppv)
+{
+    HRESULT hr = open();
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    return table->GetInterfaceFromGlobal(cookie, iid, ppv);
+}
+
+
+/** \brief Revoke interface from the Global Interface Table.
+ */
+HRESULT GlobalInterfaceTable::revokeInterface(DWORD cookie)
+{
+    HRESULT hr = open();
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    return table->RevokeInterfaceFromGlobal(cookie);
+}
+
+
+/** \brief Register interface in the calling apartment.
+ */
+ApartmentHandle::ApartmentHandle(IUnknown *unknown,
+    REFIID iid,
+    std::shared_ptr<InterfaceTable> table)
+{
+    open(unknown, iid, std::move(table));
+}
+
+
+/** \brief Register interface in the calling apartment.
+ *
+ *  The interface must be valid in the calling apartment, and the
+ *  table holds its own reference until the registration is revoked.
+ */
+void ApartmentHandle::open(IUnknown *unknown,
+    REFIID iid,
+    std::shared_ptr<InterfaceTable> table)
+{
+    auto registration = std::make_shared<State>();
+    registration->table = std::move(table);
+    registration->iid = iid;
+    registration->id = NEXT_ID.fetch_add(1, std::memory_order_relaxed);
+
+    HRESULT hr = registration->table->registerInterface(unknown, iid, registration->cookie);
+    if (FAILED(hr)) {
+        throw ComResultError(hr);
+    }
+    registration->registered = true;
+    state = std::move(registration);
+}
+
+
+/** \brief Release registration, revoking it with the last copy.
+ */
+void ApartmentHandle::reset()
+{
+    if (state && state.use_count() == 1) {
+        PROXIES.erase(state->id);
+    }
+    state.reset();
+}
+
+
+/** \brief Get proxy for the calling thread.
+ *
+ *  The proxy is unmarshalled on the first call from each thread,
+ *  and cached for later calls.
+ */
+SharedPointer<IUnknown> ApartmentHandle::get() const
+{
+    if (!state) {
+        return SharedPointer<IUnknown>();
+    }
+
+    auto it = PROXIES.find(state->id);
+    if (it != PROXIES.end()) {
+        return it->second.unknown;
+    }
+
+    sweepProxies();
+    void *ppv = nullptr;
+    HRESULT hr = state->table->getInterface(state->cookie, state->iid, &ppv);
+    if (FAILED(hr)) {
+        throw ComResultError(hr);
+    }
+
+    SharedPointer<IUnknown> unknown(static_cast<IUnknown*>(ppv));
+    PROXIES.emplace(state->id, Proxy {state, unknown});
+
+    return unknown;
+}
+
+
+/** \brief Check if handle holds a registration.
+ */
+ApartmentHandle::operator bool() const
+{
+    return bool(state);
+}
+
+
+/** \brief Release every proxy cached by the calling thread.
+ *
+ *  Proxies are invalid once the thread leaves its apartment, so
+ *  this is called when the thread's COM context is uninitialized.
+ */
+void ApartmentHandle::clearThread()
+{
+    PROXIES.clear();
+}
+
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
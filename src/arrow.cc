@@ -0,0 +1,728 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Apache Arrow C Data Interface export.
+ */
+
+#include <autocom/arrow.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+namespace
+{
+// OBJECTS
+// -------
+
+
+/** \brief Private data for exported arrays.
+ *
+ *  Owns heap buffers allocated during export, and the source
+ *  SAFEARRAY for zero-copy exports.
+ */
+struct ArrayData
+{
+    SAFEARRAY *array = nullptr;
+    bool locked = false;
+    const void *buffers[3] = {nullptr, nullptr, nullptr};
+    void *memory[3] = {nullptr, nullptr, nullptr};
+    std::vector<ArrowArray*> children;
+
+    ~ArrayData();
+};
+
+
+/** \brief Private data for exported schemas.
+ */
+struct SchemaData
+{
+    std::string format;
+    std::string name;
+    std::vector<ArrowSchema*> children;
+};
+
+
+/** \brief Free buffers and release the SAFEARRAY.
+ */
+ArrayData::~ArrayData()
+{
+    for (void *ptr: memory) {
+        std::free(ptr);
+    }
+    if (array) {
+        if (locked) {
+            SafeArrayUnlock(array);
+        }
+        SafeArrayDestroy(array);
+    }
+}
+
+// HELPERS
+// -------
+
+
+/** \brief Allocate export buffer, throwing on failure.
+ */
+void * allocate(const size_t size)
+{
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+
+/** \brief Get number of elements across all dimensions.
+ */
+size_t elements(const SAFEARRAY *array)
+{
+    size_t size = 1;
+    for (USHORT i = 0; i < array->cDims; ++i) {
+        size *= array->rgsabound[i].cElements;
+    }
+    return size;
+}
+
+
+/** \brief Get storage width for numeric VARTYPEs.
+ */
+size_t width(const VARTYPE vt)
+{
+    switch (vt) {
+        case VT_I1:
+        case VT_UI1:
+            return 1;
+        case VT_I2:
+        case VT_UI2:
+        case VT_BOOL:
+            return 2;
+        case VT_I4:
+        case VT_UI4:
+        case VT_INT:
+        case VT_UINT:
+        case VT_R4:
+        case VT_ERROR:
+            return 4;
+        case VT_I8:
+        case VT_UI8:
+        case VT_R8:
+        case VT_DATE:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+
+/** \brief Check if 4 UTF-16 code units are ASCII.
+ */
+inline bool isAscii4(const OLECHAR *s)
+{
+    return static_cast<uint32_t>(s[0] | s[1] | s[2] | s[3]) < 0x80;
+}
+
+
+/** \brief Check if code unit is a leading surrogate.
+ */
+inline bool isHighSurrogate(const uint32_t c)
+{
+    return sizeof(OLECHAR) == 2 && c >= 0xD800 && c <= 0xDBFF;
+}
+
+
+/** \brief Check if code unit is a trailing surrogate.
+ */
+inline bool isLowSurrogate(const uint32_t c)
+{
+    return sizeof(OLECHAR) == 2 && c >= 0xDC00 && c <= 0xDFFF;
+}
+
+
+/** \brief Get number of UTF-8 bytes required for a wide string.
+ *
+ *  Unpaired surrogates are counted as U+FFFD.
+ */
+size_t utf8Length(const OLECHAR *s,
+    const size_t n)
+{
+    size_t bytes = 0;
+    size_t i = 0;
+    while (i < n) {
+        if (i + 4 <= n && isAscii4(s + i)) {
+            bytes += 4;
+            i += 4;
+            continue;
+        }
+
+        const uint32_t c = static_cast<uint32_t>(s[i]);
+        if (c < 0x80) {
+            bytes += 1;
+        } else if (c < 0x800) {
+            bytes += 2;
+        } else if (isHighSurrogate(c) && i + 1 < n && isLowSurrogate(s[i+1])) {
+            bytes += 4;
+            ++i;
+        } else if (c >= 0x10000 && c <= 0x10FFFF) {
+            bytes += 4;
+        } else {
+            bytes += 3;
+        }
+        ++i;
+    }
+
+    return bytes;
+}
+
+
+/** \brief Encode wide string to UTF-8, returning the end of the output.
+ */
+char * utf8Encode(const OLECHAR *s,
+    const size_t n,
+    char *out)
+{
+    size_t i = 0;
+    while (i < n) {
+        if (i + 4 <= n && isAscii4(s + i)) {
+            out[0] = static_cast<char>(s[i]);
+            out[1] = static_cast<char>(s[i+1]);
+            out[2] = static_cast<char>(s[i+2]);
+            out[3] = static_cast<char>(s[i+3]);
+            out += 4;
+            i += 4;
+            continue;
+        }
+
+        uint32_t c = static_cast<uint32_t>(s[i]);
+        if (isHighSurrogate(c) && i + 1 < n && isLowSurrogate(s[i+1])) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (static_cast<uint32_t>(s[i+1]) - 0xDC00);
+            ++i;
+        } else if (isHighSurrogate(c) || isLowSurrogate(c) || c > 0x10FFFF) {
+            c = 0xFFFD;
+        }
+        ++i;
+
+        if (c < 0x80) {
+            *out++ = static_cast<char>(c);
+        } else if (c < 0x800) {
+            *out++ = static_cast<char>(0xC0 | (c >> 6));
+            *out++ = static_cast<char>(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            *out++ = static_cast<char>(0xE0 | (c >> 12));
+            *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            *out++ = static_cast<char>(0xF0 | (c >> 18));
+            *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+
+    return out;
+}
+
+
+/** \brief Release exported schema and children.
+ */
+void releaseSchema(ArrowSchema *schema)
+{
+    auto *data = static_cast<SchemaData*>(schema->private_data);
+    for (auto *child: data->children) {
+        if (child->release) {
+            child->release(child);
+        }
+        delete child;
+    }
+    delete data;
+    schema->release = nullptr;
+}
+
+
+/** \brief Release exported array and children.
+ */
+void releaseArray(ArrowArray *array)
+{
+    auto *data = static_cast<ArrayData*>(array->private_data);
+    for (auto *child: data->children) {
+        if (child->release) {
+            child->release(child);
+        }
+        delete child;
+    }
+    delete data;
+    array->release = nullptr;
+}
+
+
+/** \brief Initialize schema with format and name.
+ */
+void initSchema(ArrowSchema *schema,
+    const char *format,
+    const std::string &name,
+    const int64_t flags,
+    std::unique_ptr<SchemaData> data = nullptr)
+{
+    if (!data) {
+        data.reset(new SchemaData);
+    }
+    data->format = format;
+    data->name = name;
+
+    schema->format = data->format.data();
+    schema->name = data->name.data();
+    schema->metadata = nullptr;
+    schema->flags = flags;
+    schema->n_children = data->children.size();
+    schema->children = data->children.empty() ? nullptr : data->children.data();
+    schema->dictionary = nullptr;
+    schema->release = releaseSchema;
+    schema->private_data = data.release();
+}
+
+
+/** \brief Initialize array from private data.
+ */
+void initArray(ArrowArray *out,
+    std::unique_ptr<ArrayData> data,
+    const int64_t length,
+    const int64_t nulls,
+    const int64_t buffers)
+{
+    out->length = length;
+    out->null_count = nulls;
+    out->offset = 0;
+    out->n_buffers = buffers;
+    out->n_children = data->children.size();
+    out->buffers = data->buffers;
+    out->children = data->children.empty() ? nullptr : data->children.data();
+    out->dictionary = nullptr;
+    out->release = releaseArray;
+    out->private_data = data.release();
+}
+
+
+/** \brief Build UTF-8 string buffers from wide strings.
+ *
+ *  The first pass computes exact byte offsets, the second pass
+ *  transcodes directly into a single data allocation. Offsets are
+ *  narrowed in-place to 32-bits unless the data exceeds 2GB.
+ *
+ *  \return             Arrow format for the buffers ("u" or "U").
+ */
+template <typename Accessor>
+const char * buildUtf8(ArrayData &data,
+    const size_t length,
+    Accessor accessor)
+{
+    auto *offsets = static_cast<int64_t*>(allocate((length + 1) * sizeof(int64_t)));
+    data.memory[1] = offsets;
+
+    int64_t total = 0;
+    offsets[0] = 0;
+    for (size_t i = 0; i < length; ++i) {
+        BSTR string = accessor(i);
+        if (string) {
+            total += utf8Length(string, SysStringLen(string));
+        }
+        offsets[i+1] = total;
+    }
+
+    auto *buffer = static_cast<char*>(allocate(total));
+    data.memory[2] = buffer;
+    char *it = buffer;
+    for (size_t i = 0; i < length; ++i) {
+        BSTR string = accessor(i);
+        if (string) {
+            it = utf8Encode(string, SysStringLen(string), it);
+        }
+    }
+
+    const char *format = "U";
+    if (total <= std::numeric_limits<int32_t>::max()) {
+        // each narrow write is at or before its corresponding read
+        auto *narrow = reinterpret_cast<int32_t*>(offsets);
+        for (size_t i = 0; i <= length; ++i) {
+            narrow[i] = static_cast<int32_t>(offsets[i]);
+        }
+        format = "u";
+    }
+    data.buffers[1] = data.memory[1];
+    data.buffers[2] = data.memory[2];
+
+    return format;
+}
+
+
+/** \brief Build validity bitmap from predicate, returning null count.
+ */
+template <typename Predicate>
+int64_t buildValidity(ArrayData &data,
+    const size_t length,
+    Predicate valid)
+{
+    auto *bitmap = static_cast<uint8_t*>(allocate((length + 7) / 8));
+    std::memset(bitmap, 0, (length + 7) / 8);
+
+    int64_t nulls = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (valid(i)) {
+            bitmap[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+        } else {
+            ++nulls;
+        }
+    }
+
+    if (nulls) {
+        data.memory[0] = bitmap;
+        data.buffers[0] = bitmap;
+    } else {
+        std::free(bitmap);
+    }
+
+    return nulls;
+}
+
+
+/** \brief Pack VARIANT_BOOL values into an Arrow bitmap.
+ */
+template <typename Accessor>
+void buildBitmap(ArrayData &data,
+    const size_t length,
+    Accessor accessor)
+{
+    auto *bitmap = static_cast<uint8_t*>(allocate((length + 7) / 8));
+    data.memory[1] = bitmap;
+    data.buffers[1] = bitmap;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint8_t byte = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            byte |= static_cast<uint8_t>((accessor(i + j) != VARIANT_FALSE) << j);
+        }
+        bitmap[i / 8] = byte;
+    }
+    if (i < length) {
+        uint8_t byte = 0;
+        for (size_t j = 0; i + j < length; ++j) {
+            byte |= static_cast<uint8_t>((accessor(i + j) != VARIANT_FALSE) << j);
+        }
+        bitmap[i / 8] = byte;
+    }
+}
+
+
+/** \brief Check if VARIANT holds a null value.
+ */
+inline bool isNull(const VARIANT &variant)
+{
+    return variant.vt == VT_EMPTY || variant.vt == VT_NULL;
+}
+
+
+/** \brief Coerced view of a VARIANT in a column.
+ *
+ *  Values matching the column type are read in-place, and others are
+ *  converted into a local copy.
+ */
+class Coerced
+{
+protected:
+    VARIANT local;
+    const VARIANT *value = nullptr;
+
+public:
+    Coerced(const VARIANT &variant,
+        const VARTYPE vt)
+    {
+        VariantInit(&local);
+        if (variant.vt == vt) {
+            value = &variant;
+        } else if (SUCCEEDED(VariantChangeType(&local, const_cast<VARIANT*>(&variant), 0, vt))) {
+            value = &local;
+        } else {
+            throw ComTypeError(std::to_string(vt), std::to_string(variant.vt), "exportArrow");
+        }
+    }
+
+    ~Coerced()
+    {
+        VariantClear(&local);
+    }
+
+    const VARIANT & operator*() const
+    {
+        return *value;
+    }
+};
+
+
+/** \brief Export a column of VARIANTs via an accessor.
+ */
+template <typename Accessor>
+void exportColumn(const size_t length,
+    Accessor accessor,
+    ArrowArray *out,
+    ArrowSchema *schema,
+    const std::string &name)
+{
+    // infer column type from first non-null value
+    VARTYPE vt = VT_NULL;
+    for (size_t i = 0; i < length; ++i) {
+        const VARIANT &variant = accessor(i);
+        if (!isNull(variant)) {
+            vt = variant.vt & ~VT_BYREF;
+            break;
+        }
+    }
+
+    std::unique_ptr<ArrayData> data(new ArrayData);
+    if (vt == VT_NULL) {
+        initArray(out, std::move(data), length, length, 0);
+        initSchema(schema, "n", name, ARROW_FLAG_NULLABLE);
+        return;
+    }
+
+    const char *format = arrowFormat(vt);
+    if (!format) {
+        throw ComTypeError("Arrow-compatible VARTYPE", std::to_string(vt), "exportArrow");
+    }
+
+    auto nulls = buildValidity(*data, length, [&](size_t i) {
+        return !isNull(accessor(i));
+    });
+
+    if (vt == VT_BSTR) {
+        format = buildUtf8(*data, length, [&](size_t i) -> BSTR {
+            const VARIANT &variant = accessor(i);
+            if (isNull(variant)) {
+                return nullptr;
+            } else if (variant.vt == VT_BSTR) {
+                return variant.bstrVal;
+            }
+            // converted values are held by a thread-local scratch
+            // variant, valid until the next call
+            static thread_local Variant scratch;
+            scratch.clear();
+            if (FAILED(VariantChangeType(&scratch, const_cast<VARIANT*>(&variant), 0, VT_BSTR))) {
+                throw ComTypeError("VT_BSTR", std::to_string(variant.vt), "exportArrow");
+            }
+            return scratch.bstrVal;
+        });
+        initArray(out, std::move(data), length, nulls, 3);
+    } else if (vt == VT_BOOL) {
+        buildBitmap(*data, length, [&](size_t i) -> VARIANT_BOOL {
+            const VARIANT &variant = accessor(i);
+            return isNull(variant) ? VARIANT_FALSE : (*Coerced(variant, vt)).boolVal;
+        });
+        initArray(out, std::move(data), length, nulls, 2);
+    } else {
+        // all numeric members of the VARIANT union share an address
+        const size_t size = width(vt);
+        auto *buffer = static_cast<char*>(allocate(length * size));
+        data->memory[1] = buffer;
+        data->buffers[1] = buffer;
+        for (size_t i = 0; i < length; ++i) {
+            const VARIANT &variant = accessor(i);
+            if (isNull(variant)) {
+                std::memset(buffer + i * size, 0, size);
+            } else {
+                std::memcpy(buffer + i * size, &(*Coerced(variant, vt)).llVal, size);
+            }
+        }
+        initArray(out, std::move(data), length, nulls, 2);
+    }
+
+    initSchema(schema, format, name, ARROW_FLAG_NULLABLE);
+}
+
+}   /* anonymous */
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Get Arrow format string for a VARTYPE.
+ *
+ *  VT_DATE is exported as a double (days since 1899-12-30), and
+ *  VT_ERROR as a 32-bit integer.
+ */
+const char * arrowFormat(const VARTYPE vt)
+{
+    switch (vt) {
+        case VT_I1:
+            return "c";
+        case VT_UI1:
+            return "C";
+        case VT_I2:
+            return "s";
+        case VT_UI2:
+            return "S";
+        case VT_I4:
+        case VT_INT:
+        case VT_ERROR:
+            return "i";
+        case VT_UI4:
+        case VT_UINT:
+            return "I";
+        case VT_I8:
+            return "l";
+        case VT_UI8:
+            return "L";
+        case VT_R4:
+            return "f";
+        case VT_R8:
+        case VT_DATE:
+            return "g";
+        case VT_BOOL:
+            return "b";
+        case VT_BSTR:
+            return "u";
+        default:
+            return nullptr;
+    }
+}
+
+
+/** \brief Export SAFEARRAY to Arrow, taking ownership of the array.
+ */
+void exportArrow(SAFEARRAY *&&array,
+    ArrowArray *out,
+    ArrowSchema *schema,
+    const std::string &name)
+{
+    std::unique_ptr<ArrayData> data(new ArrayData);
+    data->array = array;
+    array = nullptr;
+    if (!data->array) {
+        throw std::invalid_argument("Cannot export null SAFEARRAY.");
+    }
+    if (FAILED(SafeArrayLock(data->array))) {
+        throw ComFunctionError("SafeArrayLock()");
+    }
+    data->locked = true;
+
+    const VARTYPE vt = getSafeArrayType(data->array);
+    const size_t length = elements(data->array);
+    void *pv = data->array->pvData;
+
+    if (vt == VT_VARIANT) {
+        // values are copied, so the array is released after export
+        auto *variants = static_cast<const VARIANT*>(pv);
+        exportColumn(length, [variants](size_t i) -> const VARIANT & {
+            return variants[i];
+        }, out, schema, name);
+        return;
+    }
+
+    const char *format = arrowFormat(vt);
+    if (!format) {
+        throw ComTypeError("Arrow-compatible VARTYPE", std::to_string(vt), "exportArrow");
+    }
+
+    if (vt == VT_BSTR) {
+        auto *strings = static_cast<const BSTR*>(pv);
+        format = buildUtf8(*data, length, [strings](size_t i) {
+            return strings[i];
+        });
+        // strings are copied, release the array early
+        SafeArrayUnlock(data->array);
+        SafeArrayDestroy(data->array);
+        data->array = nullptr;
+        initArray(out, std::move(data), length, 0, 3);
+    } else if (vt == VT_BOOL) {
+        auto *values = static_cast<const VARIANT_BOOL*>(pv);
+        buildBitmap(*data, length, [values](size_t i) {
+            return values[i];
+        });
+        initArray(out, std::move(data), length, 0, 2);
+    } else {
+        // zero-copy, the array is destroyed in the release callback
+        data->buffers[1] = pv;
+        initArray(out, std::move(data), length, 0, 2);
+    }
+
+    initSchema(schema, format, name, 0);
+}
+
+
+/** \brief Export VARIANT column to Arrow.
+ */
+void exportArrow(const VARIANT *column,
+    const size_t length,
+    ArrowArray *out,
+    ArrowSchema *schema,
+    const std::string &name)
+{
+    exportColumn(length, [column](size_t i) -> const VARIANT & {
+        return column[i];
+    }, out, schema, name);
+}
+
+
+/** \brief Export Variant rows to an Arrow struct array.
+ */
+void exportArrow(const std::vector<VariantList> &rows,
+    const std::vector<std::string> &names,
+    ArrowArray *out,
+    ArrowSchema *schema)
+{
+    for (const auto &row: rows) {
+        if (row.size() != names.size()) {
+            throw std::invalid_argument("Row length does not match number of fields.");
+        }
+    }
+
+    std::unique_ptr<ArrayData> data(new ArrayData);
+    std::unique_ptr<SchemaData> fields(new SchemaData);
+    auto cleanup = [&]() {
+        for (auto *child: data->children) {
+            if (child->release) {
+                child->release(child);
+            }
+            delete child;
+        }
+        data->children.clear();
+        for (auto *child: fields->children) {
+            if (child->release) {
+                child->release(child);
+            }
+            delete child;
+        }
+        fields->children.clear();
+    };
+
+    try {
+        for (size_t j = 0; j < names.size(); ++j) {
+            data->children.push_back(new ArrowArray());
+            fields->children.push_back(new ArrowSchema());
+            exportColumn(rows.size(), [&rows, j](size_t i) -> const VARIANT & {
+                return rows[i][j];
+            }, data->children.back(), fields->children.back(), names[j]);
+        }
+    } catch (...) {
+        cleanup();
+        throw;
+    }
+
+    initArray(out, std::move(data), rows.size(), 0, 1);
+    initSchema(schema, "+s", "", 0, std::move(fields));
+}
+
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
@@ -6,7 +6,7 @@
  */
 
 #include <autocom/bstr.h>
-#include <pycpp/string/codec.h>
+#include <autocom/util/unicode.h>
 #include <cassert>
 #include <cwchar>
 
@@ -67,7 +67,7 @@ Bstr::~Bstr()
 /** \brief Copy constructor.
  */
 Bstr::Bstr(const BSTR &other):
-    string(SysAllocStringLen(other, SysStringLen(other)))
+    string(accounting::sysAllocStringLen(other, SysStringLen(other), "Bstr(const BSTR &)"))
 {}
 
 
@@ -76,7 +76,7 @@ Bstr::Bstr(const BSTR &other):
 Bstr & Bstr::operator=(const BSTR &other)
 {
     clear();
-    string = SysAllocStringLen(other, SysStringLen(other));
+    string = accounting::sysAllocStringLen(other, SysStringLen(other), "Bstr::operator=(const BSTR &)");
     return *this;
 }
 
@@ -105,16 +105,15 @@ Bstr & Bstr::operator=(BSTR &&other)
  */
 Bstr::Bstr(const std::string &string)
 {
-    auto wide = codec_utf8_utf16(string);
-    auto *data = reinterpret_cast<const wchar_t*>(wide.data());
-    this->string = SysAllocStringLen(data, wide.size());
+    auto wide = utf8ToWide(string);
+    this->string = accounting::sysAllocStringLen(wide.data(), wide.size(), "Bstr(const std::string &)");
 }
 
 
 /** \brief Initialize string from wide string.
  */
 Bstr::Bstr(const std::wstring &string):
-    string(SysAllocStringLen(string.data(), string.size()))
+    string(accounting::sysAllocStringLen(string.data(), string.size(), "Bstr(const std::wstring &)"))
 {}
 
 
@@ -130,9 +129,8 @@ Bstr::Bstr(VARIANT &variant)
  */
 Bstr::Bstr(const char *cstring)
 {
-    auto wide = codec_utf8_utf16(cstring);
-    auto *data = reinterpret_cast<const wchar_t*>(wide.data());
-    this->string = SysAllocStringLen(data, wide.size());
+    auto wide = utf8ToWide(cstring);
+    this->string = accounting::sysAllocStringLen(wide.data(), wide.size(), "Bstr(const char *)");
 }
 
 
@@ -140,7 +138,7 @@ Bstr::Bstr(const char *cstring)
  */
 Bstr::Bstr(const wchar_t *cstring)
 {
-    this->string = SysAllocStringLen(cstring, wcslen(cstring));
+    this->string = accounting::sysAllocStringLen(cstring, wcslen(cstring), "Bstr(const wchar_t *)");
 }
 
 
@@ -148,9 +146,8 @@ Bstr::Bstr(const wchar_t *cstring)
  */
 Bstr::Bstr(const char *array, const size_t length)
 {
-    auto wide = codec_utf8_utf16(std::string(array, length));
-    auto *data = reinterpret_cast<const wchar_t*>(wide.data());
-    this->string = SysAllocStringLen(data, wide.size());
+    auto wide = utf8ToWide(std::string(array, length));
+    this->string = accounting::sysAllocStringLen(wide.data(), wide.size(), "Bstr(const char *, size_t)");
 }
 
 
@@ -158,7 +155,7 @@ Bstr::Bstr(const char *array, const size_t length)
  */
 Bstr::Bstr(const wchar_t *array, const size_t length)
 {
-    this->string = SysAllocStringLen(array, length);
+    this->string = accounting::sysAllocStringLen(array, length, "Bstr(const wchar_t *, size_t)");
 }
 
 
@@ -295,7 +292,7 @@ size_t Bstr::length() const
 void Bstr::clear()
 {
     if (string) {
-        SysFreeString(string);
+        accounting::sysFreeString(string, "Bstr::clear()");
         string = nullptr;
     }
 }
@@ -384,7 +381,7 @@ auto Bstr::back() const
 BSTR Bstr::copy() const
 {
     if (string) {
-        return SysAllocStringLen(string, SysStringLen(string));
+        return accounting::sysAllocStringLen(string, SysStringLen(string), "Bstr::copy()");
     }
 
     return nullptr;
@@ -398,7 +395,7 @@ void Bstr::push_back(const wchar_t c)
     std::wstring wide(string, size());
     wide.push_back(c);
     clear();
-    string = SysAllocStringLen(wide.data(), wide.size());
+    string = accounting::sysAllocStringLen(wide.data(), wide.size(), "Bstr::push_back()");
 }
 
 
@@ -478,8 +475,7 @@ Bstr::operator BSTR() const
  */
 Bstr::operator std::string() const
 {
-    auto *data = reinterpret_cast<const char16_t*>(string);
-    return codec_utf16_utf8(std::u16string(data, size()));
+    return wideToUtf8(string, size());
 }
 
 
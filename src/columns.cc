@@ -0,0 +1,118 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Struct-of-arrays gather kernels.
+ */
+
+#include <autocom/columns.h>
+
+#include <climits>
+#include <cstring>
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#elif defined(AUTOCOM_AVX2)
+#   error "AUTOCOM_AVX2 requires compiling for AVX2."
+#endif
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+// FUNCTIONS
+// ---------
+
+#if defined(__AVX2__)
+
+
+/** \brief Gather 32-bit fields, 8 records per iteration.
+ */
+void gatherColumn32(const void *records,
+    const size_t stride,
+    const size_t count,
+    void *column)
+{
+    auto *in = static_cast<const BYTE*>(records);
+    auto *out = static_cast<BYTE*>(column);
+
+    size_t i = 0;
+    if (stride <= INT_MAX / 8) {
+        const __m256i index = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(stride)));
+        for (; i + 8 <= count; i += 8) {
+            __m256i value = _mm256_i32gather_epi32(reinterpret_cast<const int*>(in + i * stride), index, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4), value);
+        }
+    }
+    for (; i < count; ++i) {
+        std::memcpy(out + i * 4, in + i * stride, 4);
+    }
+}
+
+
+/** \brief Gather 64-bit fields, 4 records per iteration.
+ */
+void gatherColumn64(const void *records,
+    const size_t stride,
+    const size_t count,
+    void *column)
+{
+    auto *in = static_cast<const BYTE*>(records);
+    auto *out = static_cast<BYTE*>(column);
+
+    size_t i = 0;
+    if (stride <= INT_MAX / 4) {
+        const __m128i index = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(static_cast<int>(stride)));
+        for (; i + 4 <= count; i += 4) {
+            __m256i value = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(in + i * stride), index, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 8), value);
+        }
+    }
+    for (; i < count; ++i) {
+        std::memcpy(out + i * 8, in + i * stride, 8);
+    }
+}
+
+#else
+
+
+/** \brief Gather 32-bit fields.
+ */
+void gatherColumn32(const void *records,
+    const size_t stride,
+    const size_t count,
+    void *column)
+{
+    auto *in = static_cast<const BYTE*>(records);
+    auto *out = static_cast<BYTE*>(column);
+    for (size_t i = 0; i < count; ++i) {
+        std::memcpy(out + i * 4, in + i * stride, 4);
+    }
+}
+
+
+/** \brief Gather 64-bit fields.
+ */
+void gatherColumn64(const void *records,
+    const size_t stride,
+    const size_t count,
+    void *column)
+{
+    auto *in = static_cast<const BYTE*>(records);
+    auto *out = static_cast<BYTE*>(column);
+    for (size_t i = 0; i < count; ++i) {
+        std::memcpy(out + i * 8, in + i * stride, 8);
+    }
+}
+
+#endif
+
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
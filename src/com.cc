@@ -5,9 +5,12 @@
  *  \brief Base definitions for COM objects.
  */
 
+#include <autocom/apartment.h>
 #include <autocom/com.h>
 #include <autocom/util/exception.h>
+#include <string>
 #include <thread>
+#include <utility>
 
 
 namespace autocom
@@ -19,20 +22,102 @@ namespace autocom
  */
 thread_local long COUNT = 0;
 
+/** Whether the current thread must balance CoInitializeEx.
+ */
+thread_local bool OWNER = false;
+
+/** Apartment settings for the current thread.
+ */
+thread_local ApartmentConfig CONFIG;
+
+// HELPERS
+// -------
+
+namespace
+{
+
+/** \brief Copy string from an exception, if any.
+ */
+BSTR copyString(const BSTR string)
+{
+    return string ? SysAllocStringLen(string, SysStringLen(string)) : nullptr;
+}
+
+
+/** \brief Free strings from an exception, and reset it.
+ */
+void clearException(EXCEPINFO &exception)
+{
+    SysFreeString(exception.bstrSource);
+    SysFreeString(exception.bstrDescription);
+    SysFreeString(exception.bstrHelpFile);
+    exception = EXCEPINFO();
+}
+
+
+/** \brief Convert string from an error object, if any.
+ */
+std::wstring errorString(IErrorInfo *info,
+    HRESULT (STDMETHODCALLTYPE IErrorInfo::*method)(BSTR*))
+{
+    BSTR string = nullptr;
+    if (!info || FAILED((info->*method)(&string)) || !string) {
+        return std::wstring();
+    }
+
+    std::wstring value(string, SysStringLen(string));
+    SysFreeString(string);
+    return value;
+}
+
+}   /* anonymous */
+
 // FUNCTIONS
 // ---------
 
 
+/** \brief Set apartment for the current thread.
+ */
+void configureApartment(const ApartmentConfig &config)
+{
+    if (COUNT > 0 && config.model != CONFIG.model) {
+        throw std::runtime_error("Cannot change apartment of an initialized thread.");
+    }
+    CONFIG = config;
+}
+
+
+/** \brief Get apartment settings for the current thread.
+ */
+ApartmentConfig apartmentConfig()
+{
+    return CONFIG;
+}
+
+
 /** \brief Initialize COM context for current thread.
+ *
+ *  Neutral threads keep any apartment they already belong to, while
+ *  threads configured for an explicit apartment throw if they belong
+ *  to another one.
  */
 void initialize()
 {
-    if (COUNT <= 0) {
-        CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-        COUNT = 1;
-    } else {
+    if (COUNT > 0) {
         ++COUNT;
+        return;
     }
+
+    DWORD coinit = CONFIG.model == APARTMENT_STA ? COINIT_APARTMENTTHREADED : COINIT_MULTITHREADED;
+    HRESULT hr = CoInitializeEx(nullptr, coinit | CONFIG.flags);
+    if (hr == RPC_E_CHANGED_MODE && CONFIG.model == APARTMENT_NEUTRAL) {
+        OWNER = false;
+    } else if (FAILED(hr)) {
+        throw ComResultError(hr);
+    } else {
+        OWNER = true;
+    }
+    COUNT = 1;
 }
 
 
@@ -40,11 +125,15 @@ void initialize()
  */
 void uninitialize()
 {
-    if (COUNT <= 1) {
-        CoUninitialize();
-        COUNT = 0;
-    } else {
+    if (COUNT > 1) {
         --COUNT;
+    } else if (COUNT == 1) {
+        ApartmentHandle::clearThread();
+        if (OWNER) {
+            CoUninitialize();
+        }
+        COUNT = 0;
+        OWNER = false;
     }
 }
 
@@ -69,6 +158,176 @@ Function DispatchBase::getFunction(const Bstr &name)
 }
 
 
+/** \brief Get dispatch identifier from function identifier, without throwing.
+ */
+HRESULT DispatchBase::getFunction(const Bstr &name,
+    Function &id)
+{
+    LPOLESTR string = const_cast<wchar_t*>(name.data());
+    return ppv->GetIDsOfNames(IID_NULL, &string, 1, LOCALE_USER_DEFAULT, &id);
+}
+
+
+/** \brief Initialize empty error details.
+ */
+DispatchError::DispatchError():
+    exception()
+{}
+
+
+/** \brief Initialize empty error details for member.
+ */
+DispatchError::DispatchError(const Function id):
+    id(id),
+    exception()
+{}
+
+
+/** \brief Copy error details, including the exception strings.
+ */
+DispatchError::DispatchError(const DispatchError &other):
+    id(other.id),
+    index(other.index),
+    exception(other.exception),
+    info(other.info)
+{
+    exception.bstrSource = copyString(other.exception.bstrSource);
+    exception.bstrDescription = copyString(other.exception.bstrDescription);
+    exception.bstrHelpFile = copyString(other.exception.bstrHelpFile);
+}
+
+
+/** \brief Copy error details, including the exception strings.
+ */
+DispatchError & DispatchError::operator=(const DispatchError &other)
+{
+    if (this != &other) {
+        DispatchError copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+
+/** \brief Move error details.
+ */
+DispatchError::DispatchError(DispatchError &&other):
+    id(other.id),
+    index(other.index),
+    exception(other.exception),
+    info(std::move(other.info))
+{
+    other.exception = EXCEPINFO();
+}
+
+
+/** \brief Move error details.
+ */
+DispatchError & DispatchError::operator=(DispatchError &&other)
+{
+    if (this != &other) {
+        clearException(exception);
+        id = other.id;
+        index = other.index;
+        exception = other.exception;
+        info = std::move(other.info);
+        other.exception = EXCEPINFO();
+    }
+    return *this;
+}
+
+
+/** \brief Free exception strings.
+ */
+DispatchError::~DispatchError()
+{
+    clearException(exception);
+}
+
+
+/** \brief Keep the error object set by the server for a failed call.
+ *
+ *  DISP_E_EXCEPTION is described by the EXCEPINFO, and otherwise the
+ *  error object is only taken if the server supports error objects
+ *  for IDispatch, so a stale one left by an unrelated call is never
+ *  reported. Taking the error object only transfers a reference, and
+ *  prevents it from being reported for a later call.
+ */
+void DispatchError::capture(IDispatch *dispatch,
+    const HRESULT hr)
+{
+    if (SUCCEEDED(hr) || hr == DISP_E_EXCEPTION || !dispatch) {
+        return;
+    }
+
+    ISupportErrorInfo *support = nullptr;
+    if (FAILED(dispatch->QueryInterface(IID_ISupportErrorInfo, (void**) &support))) {
+        return;
+    }
+    HRESULT supported = support->InterfaceSupportsErrorInfo(IID_IDispatch);
+    support->Release();
+
+    IErrorInfo *error = nullptr;
+    if (supported == S_OK && GetErrorInfo(0, &error) == S_OK) {
+        info.reset(error);
+    }
+}
+
+
+/** \brief Fill in exception deferred by the server.
+ */
+void DispatchError::fillIn() const
+{
+    if (exception.pfnDeferredFillIn) {
+        auto fill = exception.pfnDeferredFillIn;
+        exception.pfnDeferredFillIn = nullptr;
+        fill(&exception);
+    }
+}
+
+
+/** \brief Get dispatch identifier of the member called.
+ */
+Function DispatchError::member() const
+{
+    return id;
+}
+
+
+/** \brief Get index of the bad argument, in DISPPARAMS order.
+ *
+ *  Only set for DISP_E_TYPEMISMATCH and DISP_E_PARAMNOTFOUND.
+ */
+UINT DispatchError::argument() const
+{
+    return index;
+}
+
+
+/** \brief Get source of the exception or error object, if any.
+ */
+std::wstring DispatchError::source() const
+{
+    fillIn();
+    if (exception.bstrSource) {
+        return std::wstring(exception.bstrSource, SysStringLen(exception.bstrSource));
+    }
+    return errorString(info.get(), &IErrorInfo::GetSource);
+}
+
+
+/** \brief Get description of the exception or error object, if any.
+ */
+std::wstring DispatchError::description() const
+{
+    fillIn();
+    if (exception.bstrDescription) {
+        return std::wstring(exception.bstrDescription, SysStringLen(exception.bstrDescription));
+    }
+    return errorString(info.get(), &IErrorInfo::GetDescription);
+}
+
+
 /** \brief Equality operator.
  */
 bool operator==(const DispatchBase &left,
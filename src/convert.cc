@@ -0,0 +1,838 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Typed SafeArray element conversions.
+ */
+
+#include <autocom/convert.h>
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#elif defined(AUTOCOM_AVX2)
+#   error "AUTOCOM_AVX2 requires compiling for AVX2."
+#endif
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+namespace
+{
+// CONSTANTS
+// ---------
+
+/** \brief OLE Automation date of the Unix epoch, 1970-01-01.
+ */
+static constexpr DOUBLE UNIX_EPOCH_DATE = 25569.0;
+static constexpr DOUBLE SECONDS_PER_DAY = 86400.0;
+
+// OBJECTS
+// -------
+
+
+/** \brief Lock SAFEARRAY data for the lifetime of the object.
+ */
+struct DataLock
+{
+    SAFEARRAY *array;
+    const void *data = nullptr;
+
+    DataLock(const SAFEARRAY *array);
+    ~DataLock();
+};
+
+
+DataLock::DataLock(const SAFEARRAY *array):
+    array(const_cast<SAFEARRAY*>(array))
+{
+    void *pv = nullptr;
+    if (FAILED(SafeArrayAccessData(this->array, &pv))) {
+        throw ComFunctionError("SafeArrayAccessData()");
+    }
+    data = pv;
+}
+
+
+DataLock::~DataLock()
+{
+    SafeArrayUnaccessData(array);
+}
+
+
+/** \brief Kind of element, used to select the conversion.
+ */
+template <typename T>
+struct Kind
+{
+    static constexpr int value = std::is_same<T, bool>::value ? 2 : std::is_floating_point<T>::value ? 1 : 0;
+};
+
+
+/** \brief Per-element conversion, specialized by source and target kind.
+ *
+ *  `fits` checks the value is representable, `saturate` clamps it and
+ *  `wrap` truncates it to the target width.
+ */
+template <
+    typename From,
+    typename To,
+    int FromKind = Kind<From>::value,
+    int ToKind = Kind<To>::value
+>
+struct Convert;
+
+
+/** \brief Integer to integer conversions.
+ */
+template <typename From, typename To>
+struct Convert<From, To, 0, 0>
+{
+    static bool fits(const From value)
+    {
+        typedef std::numeric_limits<To> limits;
+        if (std::is_signed<From>::value && value < 0) {
+            return std::is_signed<To>::value && LONGLONG(value) >= LONGLONG(limits::lowest());
+        }
+        return ULONGLONG(value) <= ULONGLONG(limits::max());
+    }
+
+    static To saturate(const From value)
+    {
+        typedef std::numeric_limits<To> limits;
+        if (fits(value)) {
+            return To(value);
+        }
+        return value < 0 ? limits::lowest() : limits::max();
+    }
+
+    static To wrap(const From value)
+    {
+        return To(value);
+    }
+};
+
+
+/** \brief Integer to floating-point conversions, always representable.
+ */
+template <typename From, typename To>
+struct Convert<From, To, 0, 1>
+{
+    static bool fits(const From)
+    {
+        return true;
+    }
+
+    static To saturate(const From value)
+    {
+        return To(value);
+    }
+
+    static To wrap(const From value)
+    {
+        return To(value);
+    }
+};
+
+
+/** \brief Floating-point to integer conversions, truncating towards zero.
+ */
+template <typename From, typename To>
+struct Convert<From, To, 1, 0>
+{
+    /** \brief Exclusive upper bound, a power of 2 exactly representable.
+     */
+    static constexpr DOUBLE upper()
+    {
+        return DOUBLE(std::numeric_limits<To>::max() / 2 + 1) * 2.0;
+    }
+
+    static bool fits(const From value)
+    {
+        const DOUBLE lower = DOUBLE(std::numeric_limits<To>::lowest());
+        if (std::is_signed<To>::value) {
+            return value >= lower && value < upper();
+        }
+        return value > -1.0 && value < upper();
+    }
+
+    static To saturate(const From value)
+    {
+        typedef std::numeric_limits<To> limits;
+        if (fits(value)) {
+            return To(value);
+        } else if (value != value) {
+            return To(0);
+        }
+        return value < 0 ? limits::lowest() : limits::max();
+    }
+
+    /** \brief Wraps values within the 64-bit range, saturating beyond it.
+     */
+    static To wrap(const From value)
+    {
+        if (fits(value)) {
+            return To(value);
+        }
+        return To(Convert<From, LONGLONG>::saturate(value));
+    }
+};
+
+
+/** \brief Floating-point to floating-point conversions.
+ *
+ *  Infinities and NaN are representable, only finite values larger
+ *  than the target range overflow.
+ */
+template <typename From, typename To>
+struct Convert<From, To, 1, 1>
+{
+    static bool fits(const From value)
+    {
+        return sizeof(To) >= sizeof(From) || std::isinf(value) || !(std::fabs(value) > std::numeric_limits<To>::max());
+    }
+
+    static To saturate(const From value)
+    {
+        typedef std::numeric_limits<To> limits;
+        if (fits(value)) {
+            return To(value);
+        }
+        return value < 0 ? limits::lowest() : limits::max();
+    }
+
+    static To wrap(const From value)
+    {
+        return To(value);
+    }
+};
+
+
+/** \brief Conversions to bool, any non-zero value is true.
+ */
+template <typename From, int FromKind>
+struct Convert<From, bool, FromKind, 2>
+{
+    static bool fits(const From)
+    {
+        return true;
+    }
+
+    static bool saturate(const From value)
+    {
+        return value != 0;
+    }
+
+    static bool wrap(const From value)
+    {
+        return value != 0;
+    }
+};
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Convert a range of elements with fixed policies.
+ *
+ *  Errors are accumulated without branching, so the loop vectorizes,
+ *  and raised after the pass.
+ */
+template <
+    typename From,
+    typename To,
+    OverflowPolicy Overflow,
+    NanPolicy Nan
+>
+void convertRange(const From *in,
+    To *out,
+    const size_t count)
+{
+    typedef Convert<From, To> converter;
+
+    bool overflow = false;
+    bool nan = false;
+    for (size_t i = 0; i < count; ++i) {
+        From value = in[i];
+        if (Nan == NanPolicy::Throw) {
+            nan |= value != value;
+        } else if (Nan == NanPolicy::Zero) {
+            value = value != value ? From(0) : value;
+        }
+
+        if (Overflow == OverflowPolicy::Throw) {
+            overflow |= !converter::fits(value);
+            out[i] = converter::wrap(value);
+        } else if (Overflow == OverflowPolicy::Saturate) {
+            out[i] = converter::saturate(value);
+        } else {
+            out[i] = converter::wrap(value);
+        }
+    }
+
+    if (nan) {
+        throw std::domain_error("Cannot convert NaN SafeArray element.");
+    } else if (overflow) {
+        throw std::overflow_error("SafeArray element overflows the target type.");
+    }
+}
+
+
+/** \brief Select the template instantiation for the NaN policy.
+ */
+template <typename From, typename To, OverflowPolicy Overflow>
+void convertRange(const From *in,
+    To *out,
+    const size_t count,
+    const NanPolicy nan)
+{
+    switch (nan) {
+        case NanPolicy::Propagate:
+            convertRange<From, To, Overflow, NanPolicy::Propagate>(in, out, count);
+            break;
+        case NanPolicy::Throw:
+            convertRange<From, To, Overflow, NanPolicy::Throw>(in, out, count);
+            break;
+        case NanPolicy::Zero:
+            convertRange<From, To, Overflow, NanPolicy::Zero>(in, out, count);
+            break;
+    }
+}
+
+
+/** \brief Select the template instantiation for the conversion policies.
+ */
+template <typename From, typename To>
+void convertRange(const From *in,
+    To *out,
+    const size_t count,
+    const ConvertOptions &options)
+{
+    switch (options.overflow) {
+        case OverflowPolicy::Throw:
+            convertRange<From, To, OverflowPolicy::Throw>(in, out, count, options.nan);
+            break;
+        case OverflowPolicy::Saturate:
+            convertRange<From, To, OverflowPolicy::Saturate>(in, out, count, options.nan);
+            break;
+        case OverflowPolicy::Wrap:
+            convertRange<From, To, OverflowPolicy::Wrap>(in, out, count, options.nan);
+            break;
+    }
+}
+
+
+/** \brief Convert VARIANT_BOOL elements, VARIANT_TRUE is 1.
+ */
+template <typename To>
+void convertBool(const VARIANT_BOOL *in,
+    To *out,
+    const size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = To(in[i] != VARIANT_FALSE);
+    }
+}
+
+
+#if defined(__AVX2__)
+
+
+/** \brief Widen `float` to `double`, 8 elements per iteration.
+ */
+void widen(const FLOAT *in,
+    DOUBLE *out,
+    const size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 value = _mm256_loadu_ps(in + i);
+        _mm256_storeu_pd(out + i, _mm256_cvtps_pd(_mm256_castps256_ps128(value)));
+        _mm256_storeu_pd(out + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(value, 1)));
+    }
+    for (; i < count; ++i) {
+        out[i] = in[i];
+    }
+}
+
+
+/** \brief Sign-extend 16-bit to 32-bit integers, 16 elements per iteration.
+ */
+template <typename To>
+void widen(const SHORT *in,
+    To *out,
+    const size_t count)
+{
+    static_assert(sizeof(To) == 4, "Must widen to 32-bit integers.");
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i low = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(value));
+        __m256i high = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(value, 1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 8), high);
+    }
+    for (; i < count; ++i) {
+        out[i] = in[i];
+    }
+}
+
+
+/** \brief Convert VARIANT_BOOL to `bool`, 32 elements per iteration.
+ */
+void widen(const VARIANT_BOOL *in,
+    bool *out,
+    const size_t count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 16));
+        // 0xFFFF for false lanes, packed to bytes and lane-fixed
+        __m256i packed = _mm256_packs_epi16(_mm256_cmpeq_epi16(first, zero), _mm256_cmpeq_epi16(second, zero));
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_andnot_si256(packed, one));
+    }
+    for (; i < count; ++i) {
+        out[i] = in[i] != VARIANT_FALSE;
+    }
+}
+
+#else
+
+
+/** \brief Widen `float` to `double`.
+ */
+void widen(const FLOAT *in,
+    DOUBLE *out,
+    const size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = in[i];
+    }
+}
+
+
+/** \brief Sign-extend 16-bit to 32-bit integers.
+ */
+template <typename To>
+void widen(const SHORT *in,
+    To *out,
+    const size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = in[i];
+    }
+}
+
+
+/** \brief Convert VARIANT_BOOL to `bool`.
+ */
+void widen(const VARIANT_BOOL *in,
+    bool *out,
+    const size_t count)
+{
+    convertBool(in, out, count);
+}
+
+#endif
+
+
+/** \brief Use lossless SIMD kernels where one exists for the pair.
+ *
+ *  Returns false if the generic conversion must be used.
+ */
+template <typename To>
+bool convertFast(const void *, VARTYPE, To *, size_t, const ConvertOptions &)
+{
+    return false;
+}
+
+
+bool convertFast(const void *in,
+    const VARTYPE vt,
+    DOUBLE *out,
+    const size_t count,
+    const ConvertOptions &options)
+{
+    if (vt != VT_R4 || options.nan != NanPolicy::Propagate) {
+        return false;
+    }
+    widen(reinterpret_cast<const FLOAT*>(in), out, count);
+    return true;
+}
+
+
+#if !defined(AUTOCOM_LONG_IS_INT)
+bool convertFast(const void *in,
+    const VARTYPE vt,
+    INT *out,
+    const size_t count,
+    const ConvertOptions &)
+{
+    if (vt != VT_I2) {
+        return false;
+    }
+    widen(reinterpret_cast<const SHORT*>(in), out, count);
+    return true;
+}
+#endif          // AUTOCOM_LONG_IS_INT
+
+
+bool convertFast(const void *in,
+    const VARTYPE vt,
+    LONG *out,
+    const size_t count,
+    const ConvertOptions &)
+{
+    if (vt != VT_I2) {
+        return false;
+    }
+    widen(reinterpret_cast<const SHORT*>(in), out, count);
+    return true;
+}
+
+
+bool convertFast(const void *in,
+    const VARTYPE vt,
+    bool *out,
+    const size_t count,
+    const ConvertOptions &)
+{
+    if (vt != VT_BOOL) {
+        return false;
+    }
+    widen(reinterpret_cast<const VARIANT_BOOL*>(in), out, count);
+    return true;
+}
+
+
+/** \brief Dispatch on the source element type.
+ */
+template <typename To>
+void convertData(const void *in,
+    const VARTYPE vt,
+    To *out,
+    const size_t count,
+    const ConvertOptions &options)
+{
+    if (convertFast(in, vt, out, count, options)) {
+        return;
+    }
+
+    switch (vt) {
+        case VT_I1:
+            convertRange(reinterpret_cast<const CHAR*>(in), out, count, options);
+            break;
+        case VT_UI1:
+            convertRange(reinterpret_cast<const UCHAR*>(in), out, count, options);
+            break;
+        case VT_I2:
+            convertRange(reinterpret_cast<const SHORT*>(in), out, count, options);
+            break;
+        case VT_UI2:
+            convertRange(reinterpret_cast<const USHORT*>(in), out, count, options);
+            break;
+        case VT_I4:
+            convertRange(reinterpret_cast<const LONG*>(in), out, count, options);
+            break;
+        case VT_UI4:
+            convertRange(reinterpret_cast<const ULONG*>(in), out, count, options);
+            break;
+        case VT_INT:
+            convertRange(reinterpret_cast<const INT*>(in), out, count, options);
+            break;
+        case VT_UINT:
+            convertRange(reinterpret_cast<const UINT*>(in), out, count, options);
+            break;
+        case VT_I8:
+            convertRange(reinterpret_cast<const LONGLONG*>(in), out, count, options);
+            break;
+        case VT_UI8:
+            convertRange(reinterpret_cast<const ULONGLONG*>(in), out, count, options);
+            break;
+        case VT_R4:
+            convertRange(reinterpret_cast<const FLOAT*>(in), out, count, options);
+            break;
+        case VT_R8:
+        case VT_DATE:
+            convertRange(reinterpret_cast<const DOUBLE*>(in), out, count, options);
+            break;
+        case VT_BOOL:
+            convertBool(reinterpret_cast<const VARIANT_BOOL*>(in), out, count);
+            break;
+        default:
+            throw ComTypeError("numeric SAFEARRAY", std::to_string(vt), "convertElements");
+    }
+}
+
+
+/** \brief Lock the source array and convert its elements.
+ */
+template <typename To>
+void convertInto(const SAFEARRAY *array,
+    To *out,
+    const ConvertOptions &options)
+{
+    if (!array) {
+        throw std::invalid_argument("Cannot convert null SAFEARRAY.");
+    }
+
+    VARTYPE vt = getSafeArrayType(array);
+    DataLock lock(array);
+    convertData(lock.data, vt, out, safeArrayElements(array), options);
+}
+
+
+/** \brief Convert OLE Automation date to fractional seconds since the epoch.
+ *
+ *  Negative dates store the time of day as a positive fraction, so
+ *  -1.25 is 06:00 on 1899-12-29.
+ */
+DOUBLE dateToSeconds(const DATE date)
+{
+    DOUBLE day = std::trunc(date);
+    DOUBLE days = day + std::fabs(date - day);
+    return (days - UNIX_EPOCH_DATE) * SECONDS_PER_DAY;
+}
+
+}   /* anonymous */
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Get total number of elements in all dimensions of a SAFEARRAY.
+ */
+size_t safeArrayElements(const SAFEARRAY *array)
+{
+    size_t count = 1;
+    for (USHORT i = 0; i < array->cDims; ++i) {
+        count *= array->rgsabound[i].cElements;
+    }
+
+    return count;
+}
+
+
+/** \brief Convert OLE Automation date to a system clock time point.
+ */
+TimePoint dateToTimePoint(const DATE date)
+{
+    typedef TimePoint::duration Duration;
+    typedef std::chrono::duration<DOUBLE> Seconds;
+
+    return TimePoint(std::chrono::duration_cast<Duration>(Seconds(dateToSeconds(date))));
+}
+
+
+/** \brief Convert system clock time point to an OLE Automation date.
+ */
+DATE timePointToDate(const TimePoint &point)
+{
+    typedef std::chrono::duration<DOUBLE> Seconds;
+
+    DOUBLE days = std::chrono::duration_cast<Seconds>(point.time_since_epoch()).count() / SECONDS_PER_DAY + UNIX_EPOCH_DATE;
+    DOUBLE day = std::floor(days);
+    if (day < 0) {
+        // time of day is stored as a positive fraction
+        return day - (days - day);
+    }
+    return days;
+}
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    CHAR *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    UCHAR *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    SHORT *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    USHORT *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+#if !defined(AUTOCOM_LONG_IS_INT)
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    INT *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    UINT *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+#endif          // AUTOCOM_LONG_IS_INT
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    LONG *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    ULONG *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    LONGLONG *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    ULONGLONG *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    FLOAT *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert SAFEARRAY elements into a caller-provided buffer.
+ */
+void convertElements(const SAFEARRAY *array,
+    DOUBLE *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert SAFEARRAY elements to `bool`, any non-zero is true.
+ */
+void convertElements(const SAFEARRAY *array,
+    bool *out,
+    const ConvertOptions &options)
+{
+    convertInto(array, out, options);
+}
+
+
+/** \brief Convert VT_DATE SAFEARRAY elements to time points.
+ *
+ *  Dates are converted to clock ticks in blocks, so the range and NaN
+ *  checks share the integer conversion kernel.
+ */
+void convertElements(const SAFEARRAY *array,
+    TimePoint *out,
+    const ConvertOptions &options)
+{
+    typedef TimePoint::duration Duration;
+    typedef Duration::rep Rep;
+    typedef Duration::period Period;
+    static constexpr size_t BLOCK = 256;
+
+    if (!array) {
+        throw std::invalid_argument("Cannot convert null SAFEARRAY.");
+    }
+    VARTYPE vt = getSafeArrayType(array);
+    if (vt != VT_DATE) {
+        throw ComTypeError("VT_DATE", std::to_string(vt), "convertElements");
+    }
+
+    // NaN cannot be represented as a time point
+    ConvertOptions policy = options;
+    if (policy.nan == NanPolicy::Propagate) {
+        policy.nan = NanPolicy::Throw;
+    }
+
+    DataLock lock(array);
+    auto *dates = reinterpret_cast<const DATE*>(lock.data);
+    size_t count = safeArrayElements(array);
+    DOUBLE ticks[BLOCK];
+    Rep reps[BLOCK];
+    for (size_t begin = 0; begin < count; begin += BLOCK) {
+        size_t length = std::min(BLOCK, count - begin);
+        for (size_t i = 0; i < length; ++i) {
+            ticks[i] = dateToSeconds(dates[begin + i]) * Period::den / Period::num;
+        }
+        convertRange(ticks, reps, length, policy);
+        for (size_t i = 0; i < length; ++i) {
+            out[begin + i] = TimePoint(Duration(reps[i]));
+        }
+    }
+}
+
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
@@ -6,6 +6,7 @@
  */
 
 #include <autocom/enum.h>
+#include <autocom/trace.h>
 #include <autocom/util/exception.h>
 
 
@@ -22,7 +23,12 @@ IEnumVARIANT * newEnumVariant(IDispatch *dispatch)
     DISPPARAMS dp = {nullptr, nullptr, 0, 0};
     Variant result;
 
-    HRESULT hr = dispatch->Invoke(DISPID_NEWENUM, IID_NULL, LOCALE_USER_DEFAULT, FROM_ENUM(GET), &dp, &result, nullptr, nullptr);
+    HRESULT hr;
+    if (trace::enabled()) {
+        hr = trace::invoke(dispatch, DISPID_NEWENUM, L"_NewEnum", FROM_ENUM(GET), &dp, &result);
+    } else {
+        hr = dispatch->Invoke(DISPID_NEWENUM, IID_NULL, LOCALE_USER_DEFAULT, FROM_ENUM(GET), &dp, &result, nullptr, nullptr);
+    }
     if (FAILED(hr)) {
         throw ComMethodError("IDispatch", "Invoke(DISPID_NEWENUM, ...)");
     }
@@ -0,0 +1,707 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Event sinks for connection points.
+ */
+
+#include <autocom/events.h>
+#include <autocom/server.h>
+#include <autocom/util/exception.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+
+namespace autocom
+{
+// OBJECTS
+// -------
+
+
+/** \brief IDispatch implementation receiving the events of a sink.
+ *
+ *  Handlers are sorted by DISPID, for a binary search per event.
+ */
+class EventDispatch: public IDispatch
+{
+protected:
+    typedef std::pair<DISPID, EventHandler> Handler;
+
+    std::atomic<ULONG> references;
+    std::vector<Handler> handlers;
+    EventQueue *queue = nullptr;
+    IID iid = IID_NULL;
+
+    friend class EventSink;
+
+public:
+    EventDispatch();
+    virtual ~EventDispatch() = default;
+
+    // IUNKNOWN
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override;
+    virtual ULONG STDMETHODCALLTYPE AddRef() override;
+    virtual ULONG STDMETHODCALLTYPE Release() override;
+
+    // IDISPATCH
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfoCount(UINT *count) override;
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfo(UINT index,
+        LCID locale,
+        ITypeInfo **info) override;
+    virtual HRESULT STDMETHODCALLTYPE GetIDsOfNames(REFIID iid,
+        LPOLESTR *names,
+        UINT count,
+        LCID locale,
+        DISPID *ids) override;
+    virtual HRESULT STDMETHODCALLTYPE Invoke(DISPID member,
+        REFIID iid,
+        LCID locale,
+        WORD flags,
+        DISPPARAMS *params,
+        VARIANT *result,
+        EXCEPINFO *exception,
+        UINT *error) override;
+};
+
+
+namespace
+{
+// CONSTANTS
+// ---------
+
+const INT DEFAULT_SOURCE = IMPLTYPEFLAG_FDEFAULT | IMPLTYPEFLAG_FSOURCE;
+
+// HELPERS
+// -------
+
+
+/** \brief Get kind, implemented types and GUID of type information.
+ */
+bool typeAttributes(ITypeInfo *info,
+    TYPEKIND &kind,
+    WORD &interfaces,
+    GUID &guid)
+{
+    TYPEATTR *attr;
+    if (FAILED(info->GetTypeAttr(&attr))) {
+        return false;
+    }
+    kind = attr->typekind;
+    interfaces = attr->cImplTypes;
+    guid = attr->guid;
+    info->ReleaseTypeAttr(attr);
+
+    return true;
+}
+
+
+/** \brief Find implemented type of a coclass, or null if not found.
+ *
+ *  \param mask                 Implemented type flags to compare.
+ *  \param flags                Expected flags, after the mask.
+ */
+ITypeInfo * newImplementedType(ITypeInfo *coclass,
+    const INT mask,
+    const INT flags)
+{
+    TYPEKIND kind;
+    WORD interfaces;
+    GUID guid;
+    if (!typeAttributes(coclass, kind, interfaces, guid) || kind != TKIND_COCLASS) {
+        return nullptr;
+    }
+
+    for (UINT i = 0; i < interfaces; ++i) {
+        INT implemented;
+        HREFTYPE reference;
+        ITypeInfo *info;
+        if (FAILED(coclass->GetImplTypeFlags(i, &implemented)) || (implemented & mask) != flags) {
+            continue;
+        }
+        if (SUCCEEDED(coclass->GetRefTypeOfImplType(i, &reference)) && SUCCEEDED(coclass->GetRefTypeInfo(reference, &info))) {
+            return info;
+        }
+    }
+
+    return nullptr;
+}
+
+
+/** \brief Check if the default interface of a coclass has the GUID.
+ */
+bool isDefaultInterface(ITypeInfo *coclass,
+    const GUID &guid)
+{
+    ITypeInfo *info = newImplementedType(coclass, DEFAULT_SOURCE, IMPLTYPEFLAG_FDEFAULT);
+    if (!info) {
+        return false;
+    }
+
+    TYPEKIND kind;
+    WORD interfaces;
+    GUID id;
+    bool equal = typeAttributes(info, kind, interfaces, id) && IsEqualGUID(id, guid);
+    info->Release();
+
+    return equal;
+}
+
+
+/** \brief Search type library of object for its coclass.
+ */
+ITypeInfo * findClassInfo(IDispatch *dispatch)
+{
+    ITypeInfo *info;
+    if (FAILED(dispatch->GetTypeInfo(0, LOCALE_USER_DEFAULT, &info))) {
+        return nullptr;
+    }
+
+    TYPEKIND kind;
+    WORD interfaces;
+    GUID guid;
+    ITypeLib *tlib = nullptr;
+    UINT index;
+    bool valid = typeAttributes(info, kind, interfaces, guid);
+    valid = valid && SUCCEEDED(info->GetContainingTypeLib(&tlib, &index));
+    info->Release();
+    if (!valid) {
+        return nullptr;
+    }
+
+    ITypeInfo *coclass = nullptr;
+    UINT count = tlib->GetTypeInfoCount();
+    for (UINT i = 0; i < count && !coclass; ++i) {
+        if (FAILED(tlib->GetTypeInfoType(i, &kind)) || kind != TKIND_COCLASS) {
+            continue;
+        }
+        if (SUCCEEDED(tlib->GetTypeInfo(i, &info))) {
+            if (isDefaultInterface(info, guid)) {
+                coclass = info;
+            } else {
+                info->Release();
+            }
+        }
+    }
+    tlib->Release();
+
+    return coclass;
+}
+
+
+/** \brief Get coclass of object, or null if not found.
+ */
+ITypeInfo * newClassInfo(IDispatch *dispatch)
+{
+    IProvideClassInfo *provider;
+    if (SUCCEEDED(dispatch->QueryInterface(IID_IProvideClassInfo, (void**) &provider))) {
+        ITypeInfo *info = nullptr;
+        HRESULT hr = provider->GetClassInfo(&info);
+        provider->Release();
+        if (SUCCEEDED(hr)) {
+            return info;
+        }
+    }
+
+    return findClassInfo(dispatch);
+}
+
+
+/** \brief Round queue capacity up to a power of 2.
+ */
+size_t ringSize(const size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    return size;
+}
+
+}   /* anonymous */
+
+// FUNCTIONS
+// ---------
+
+
+ITypeInfo * newSourceTypeInfo(IDispatch *dispatch)
+{
+    ITypeInfo *coclass = newClassInfo(dispatch);
+    if (!coclass) {
+        throw ComMethodError("IProvideClassInfo", "GetClassInfo(...)");
+    }
+
+    ITypeInfo *source = newImplementedType(coclass, DEFAULT_SOURCE, DEFAULT_SOURCE);
+    coclass->Release();
+    if (!source) {
+        throw ComMethodError("ITypeInfo", "GetRefTypeOfImplType(...)");
+    }
+
+    return source;
+}
+
+// OBJECTS
+// -------
+
+
+EventDispatch::EventDispatch():
+    references(1)
+{}
+
+
+/** \brief Answer IDispatch, and the source interface.
+ */
+HRESULT STDMETHODCALLTYPE EventDispatch::QueryInterface(REFIID iid,
+    void **ppv)
+{
+    if (!ppv) {
+        return E_POINTER;
+    }
+    if (IsEqualIID(iid, IID_IUnknown) || IsEqualIID(iid, IID_IDispatch) || IsEqualIID(iid, this->iid)) {
+        *ppv = static_cast<IDispatch*>(this);
+        AddRef();
+        return S_OK;
+    }
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+
+ULONG STDMETHODCALLTYPE EventDispatch::AddRef()
+{
+    return ++references;
+}
+
+
+ULONG STDMETHODCALLTYPE EventDispatch::Release()
+{
+    ULONG count = --references;
+    if (count == 0) {
+        delete this;
+    }
+    return count;
+}
+
+
+HRESULT STDMETHODCALLTYPE EventDispatch::GetTypeInfoCount(UINT *count)
+{
+    if (!count) {
+        return E_INVALIDARG;
+    }
+    *count = 0;
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE EventDispatch::GetTypeInfo(UINT index,
+    LCID locale,
+    ITypeInfo **info)
+{
+    if (info) {
+        *info = nullptr;
+    }
+    return DISP_E_BADINDEX;
+}
+
+
+HRESULT STDMETHODCALLTYPE EventDispatch::GetIDsOfNames(REFIID iid,
+    LPOLESTR *names,
+    UINT count,
+    LCID locale,
+    DISPID *ids)
+{
+    for (UINT i = 0; ids && i < count; ++i) {
+        ids[i] = DISPID_UNKNOWN;
+    }
+    return DISP_E_UNKNOWNNAME;
+}
+
+
+/** \brief Queue the event, then call its handler.
+ */
+HRESULT STDMETHODCALLTYPE EventDispatch::Invoke(DISPID member,
+    REFIID iid,
+    LCID locale,
+    WORD flags,
+    DISPPARAMS *params,
+    VARIANT *result,
+    EXCEPINFO *exception,
+    UINT *error)
+{
+    if (!params) {
+        return E_INVALIDARG;
+    }
+    if (queue) {
+        queue->push(member, *params);
+    }
+
+    auto it = std::lower_bound(handlers.begin(), handlers.end(), member, [](const Handler &handler, DISPID id) {
+        return handler.first < id;
+    });
+    if (it == handlers.end() || it->first != member) {
+        return S_OK;
+    }
+
+    try {
+        it->second(*params);
+        return S_OK;
+    } catch (std::exception &e) {
+        setExceptionInfo(exception, L"EventSink", e.what());
+    } catch (...) {
+        setExceptionInfo(exception, L"EventSink", "Unknown exception.");
+    }
+    return DISP_E_EXCEPTION;
+}
+
+
+/** \brief Create queue with capacity rounded up to a power of 2.
+ */
+EventQueue::EventQueue(const size_t capacity):
+    slots(ringSize(capacity)),
+    mask(slots.size() - 1),
+    head(0),
+    tail(0),
+    drops(0)
+{
+    for (size_t i = 0; i < slots.size(); ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+
+/** \brief Copy event into the queue, or drop it if the queue is full.
+ *
+ *  Safe to call from any number of producer threads. A slot is free
+ *  for position `p` once its sequence is `p`, and holds an event once
+ *  its sequence is `p + 1`. Events whose arguments cannot be copied
+ *  still publish their slot, which the consumer skips.
+ */
+bool EventQueue::push(const DISPID id,
+    const DISPPARAMS &params)
+{
+    size_t position = tail.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true) {
+        slot = &slots[position & mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+        if (difference == 0) {
+            if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    // publish the claimed slot on every exit, so the consumer never
+    // waits on a slot abandoned by a failed copy
+    struct Publish
+    {
+        EventQueue &queue;
+        Slot &slot;
+        size_t sequence;
+
+        ~Publish()
+        {
+            if (!slot.copied) {
+                for (Variant &argument: slot.event.arguments) {
+                    argument.clear();
+                }
+                queue.drops.fetch_add(1, std::memory_order_relaxed);
+            }
+            slot.sequence.store(sequence, std::memory_order_release);
+        }
+    } publish = {*this, *slot, position + 1};
+
+    Event &event = slot->event;
+    event.id = id;
+    slot->copied = false;
+    try {
+        event.arguments.resize(params.cArgs);
+    } catch (...) {
+        return false;
+    }
+    for (UINT i = 0; i < params.cArgs; ++i) {
+        if (FAILED(VariantCopyInd(&event.arguments[i], &params.rgvarg[params.cArgs - 1 - i]))) {
+            return false;
+        }
+    }
+    slot->copied = true;
+
+    return true;
+}
+
+
+/** \brief Move the oldest event into `event`, if any.
+ *
+ *  Must only be called by the consumer thread. The storage of
+ *  `event` is recycled into the queue. Returns false while the
+ *  oldest slot is still being written.
+ */
+bool EventQueue::pop(Event &event)
+{
+    while (true) {
+        size_t position = head.load(std::memory_order_relaxed);
+        Slot &slot = slots[position & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+
+        bool copied = slot.copied;
+        if (copied) {
+            std::swap(event, slot.event);
+            for (Variant &argument: slot.event.arguments) {
+                argument.clear();
+            }
+        }
+        head.store(position + 1, std::memory_order_release);
+        slot.sequence.store(position + slots.size(), std::memory_order_release);
+        if (copied) {
+            return true;
+        }
+    }
+}
+
+
+bool EventQueue::empty() const
+{
+    return size() == 0;
+}
+
+
+size_t EventQueue::size() const
+{
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+}
+
+
+size_t EventQueue::capacity() const
+{
+    return slots.size();
+}
+
+
+/** \brief Get number of events dropped while the queue was full.
+ */
+size_t EventQueue::dropped() const
+{
+    return drops.load(std::memory_order_relaxed);
+}
+
+
+EventSink::EventSink():
+    sink(new EventDispatch)
+{}
+
+
+EventSink::EventSink(EventSink &&other):
+    sink(std::move(other.sink)),
+    point(std::move(other.point)),
+    info(std::move(other.info)),
+    cookie(other.cookie)
+{
+    other.cookie = 0;
+}
+
+
+EventSink & EventSink::operator=(EventSink &&other)
+{
+    close();
+    sink = std::move(other.sink);
+    point = std::move(other.point);
+    info = std::move(other.info);
+    cookie = other.cookie;
+    other.cookie = 0;
+    return *this;
+}
+
+
+EventSink::~EventSink()
+{
+    close();
+}
+
+
+EventSink::EventSink(IDispatch *source):
+    EventSink()
+{
+    open(source);
+}
+
+
+EventSink::EventSink(IUnknown *source,
+    const Guid &iid):
+    EventSink()
+{
+    open(source, iid);
+}
+
+
+/** \brief Find connection point for the default source interface.
+ *
+ *  Handlers may then be registered by name.
+ */
+void EventSink::open(IDispatch *source)
+{
+    SharedPointer<ITypeInfo> sourceInfo(newSourceTypeInfo(source));
+
+    TYPEKIND kind;
+    WORD interfaces;
+    GUID guid;
+    if (!typeAttributes(sourceInfo.get(), kind, interfaces, guid)) {
+        throw ComMethodError("ITypeInfo", "GetTypeAttr(...)");
+    }
+
+    open(source, Guid(guid));
+    info = std::move(sourceInfo);
+}
+
+
+/** \brief Find connection point for the source interface.
+ */
+void EventSink::open(IUnknown *source,
+    const Guid &iid)
+{
+    close();
+
+    IConnectionPointContainer *container;
+    if (FAILED(source->QueryInterface(IID_IConnectionPointContainer, (void**) &container))) {
+        throw ComMethodError("IUnknown", "QueryInterface(IID_IConnectionPointContainer, ...)");
+    }
+
+    IConnectionPoint *connection;
+    HRESULT hr = container->FindConnectionPoint(iid.get(), &connection);
+    container->Release();
+    if (FAILED(hr)) {
+        throw ComMethodError("IConnectionPointContainer", "FindConnectionPoint(...)");
+    }
+
+    point.reset(connection);
+    sink->iid = iid.get();
+}
+
+
+/** \brief Disconnect from the source, keeping the handlers.
+ */
+void EventSink::close()
+{
+    unadvise();
+    point.reset();
+    info.reset();
+}
+
+
+/** \brief Register handler for event.
+ */
+void EventSink::on(const DISPID id,
+    EventHandler handler)
+{
+    if (advised()) {
+        throw std::logic_error("Event handlers must be registered before advising.");
+    }
+
+    auto &handlers = sink->handlers;
+    auto it = std::lower_bound(handlers.begin(), handlers.end(), id, [](const EventDispatch::Handler &item, DISPID value) {
+        return item.first < value;
+    });
+    if (it != handlers.end() && it->first == id) {
+        it->second = std::move(handler);
+    } else {
+        handlers.emplace(it, id, std::move(handler));
+    }
+}
+
+
+/** \brief Register handler for event by name, resolved once.
+ */
+void EventSink::on(const std::wstring &name,
+    EventHandler handler)
+{
+    if (!info) {
+        throw std::invalid_argument("Event names require type information for the source interface.");
+    }
+
+    LPOLESTR names = const_cast<LPOLESTR>(name.data());
+    DISPID id;
+    if (FAILED(info->GetIDsOfNames(&names, 1, &id))) {
+        throw ComMethodError("ITypeInfo", "GetIDsOfNames(...)");
+    }
+    on(id, std::move(handler));
+}
+
+
+/** \brief Copy every event into `queue`, or stop if null.
+ *
+ *  Events may be delivered on several threads, but the queue must
+ *  be drained by a single thread.
+ */
+void EventSink::forward(EventQueue *queue)
+{
+    if (advised()) {
+        throw std::logic_error("Event queues must be set before advising.");
+    }
+    sink->queue = queue;
+}
+
+
+/** \brief Start receiving events.
+ */
+void EventSink::advise()
+{
+    if (!point) {
+        throw std::logic_error("EventSink is not open.");
+    }
+    if (cookie) {
+        return;
+    }
+    if (FAILED(point->Advise(sink.get(), &cookie))) {
+        cookie = 0;
+        throw ComMethodError("IConnectionPoint", "Advise(...)");
+    }
+}
+
+
+/** \brief Stop receiving events.
+ */
+void EventSink::unadvise()
+{
+    if (cookie) {
+        point->Unadvise(cookie);
+        cookie = 0;
+    }
+}
+
+
+bool EventSink::advised() const
+{
+    return cookie != 0;
+}
+
+
+EventSink::operator bool() const
+{
+    return bool(point);
+}
+
+
+Guid EventSink::iid() const
+{
+    return Guid(sink->iid);
+}
+
+
+/** \brief Get sink, to pass to servers which take callback objects.
+ */
+IDispatch * EventSink::dispatch() const
+{
+    return sink.get();
+}
+
+}   /* autocom */
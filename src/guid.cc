@@ -6,11 +6,189 @@
  */
 
 #include <autocom/guid.h>
-#include <pycpp/string/codec.h>
+#include <autocom/progid.h>
+#include <autocom/util/unicode.h>
+
+#include <objbase.h>
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#elif defined(AUTOCOM_AVX2)
+#   error "AUTOCOM_AVX2 requires compiling for AVX2."
+#endif
 
 
 namespace autocom
 {
+namespace
+{
+// CONSTANTS
+// ---------
+
+const char UPPER_DIGITS[] = "0123456789ABCDEF";
+const char LOWER_DIGITS[] = "0123456789abcdef";
+
+// HELPERS
+// -------
+
+
+/** \brief Get GUID bytes in string order, with big-endian Data1-3.
+ */
+void toBytes(const GUID &id,
+    unsigned char *bytes)
+{
+    bytes[0] = static_cast<unsigned char>(id.Data1 >> 24);
+    bytes[1] = static_cast<unsigned char>(id.Data1 >> 16);
+    bytes[2] = static_cast<unsigned char>(id.Data1 >> 8);
+    bytes[3] = static_cast<unsigned char>(id.Data1);
+    bytes[4] = static_cast<unsigned char>(id.Data2 >> 8);
+    bytes[5] = static_cast<unsigned char>(id.Data2);
+    bytes[6] = static_cast<unsigned char>(id.Data3 >> 8);
+    bytes[7] = static_cast<unsigned char>(id.Data3);
+    std::memcpy(bytes + 8, id.Data4, 8);
+}
+
+
+/** \brief Set GUID from bytes in string order.
+ */
+void fromBytes(const unsigned char *bytes,
+    GUID &id)
+{
+    id.Data1 = (ULONG(bytes[0]) << 24) | (ULONG(bytes[1]) << 16) | (ULONG(bytes[2]) << 8) | ULONG(bytes[3]);
+    id.Data2 = static_cast<unsigned short>((bytes[4] << 8) | bytes[5]);
+    id.Data3 = static_cast<unsigned short>((bytes[6] << 8) | bytes[7]);
+    std::memcpy(id.Data4, bytes + 8, 8);
+}
+
+
+/** \brief Copy 32 digits from "XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX".
+ */
+void compactDigits(const char *string,
+    char *digits)
+{
+    std::memcpy(digits, string, 8);
+    std::memcpy(digits + 8, string + 9, 4);
+    std::memcpy(digits + 12, string + 14, 4);
+    std::memcpy(digits + 16, string + 19, 4);
+    std::memcpy(digits + 20, string + 24, 12);
+}
+
+
+/** \brief Write 32 digits as "XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX".
+ */
+void expandDigits(const char *digits,
+    char *string)
+{
+    std::memcpy(string, digits, 8);
+    string[8] = '-';
+    std::memcpy(string + 9, digits + 8, 4);
+    string[13] = '-';
+    std::memcpy(string + 14, digits + 12, 4);
+    string[18] = '-';
+    std::memcpy(string + 19, digits + 16, 4);
+    string[23] = '-';
+    std::memcpy(string + 24, digits + 20, 12);
+}
+
+
+#if defined(__AVX2__)
+
+
+/** \brief Encode 16 bytes as 32 hex digits, using byte shuffles.
+ */
+void encodeHex(const unsigned char *bytes,
+    char *digits,
+    const char *table)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i lookup = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    __m128i high = _mm_and_si128(_mm_srli_epi16(value, 4), mask);
+    __m128i low = _mm_and_si128(value, mask);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(digits), _mm_shuffle_epi8(lookup, _mm_unpacklo_epi8(high, low)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(digits + 16), _mm_shuffle_epi8(lookup, _mm_unpackhi_epi8(high, low)));
+}
+
+
+/** \brief Decode and validate 32 hex digits of either case.
+ */
+bool decodeHex(const char *digits,
+    unsigned char *bytes)
+{
+    __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(digits));
+    // unsigned wraparound maps out-of-range characters above 9 or 5
+    __m256i digit = _mm256_sub_epi8(value, _mm256_set1_epi8('0'));
+    __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(value, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i isAlpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+    if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isAlpha)) != -1) {
+        return false;
+    }
+
+    // combine nibble pairs as high * 16 + low
+    __m256i nibbles = _mm256_blendv_epi8(_mm256_add_epi8(alpha, _mm256_set1_epi8(10)), digit, isDigit);
+    __m256i pairs = _mm256_maddubs_epi16(nibbles, _mm256_set1_epi16(0x0110));
+    __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(pairs), _mm256_extracti128_si256(pairs, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), packed);
+
+    return true;
+}
+
+#else
+
+
+/** \brief Encode 16 bytes as 32 hex digits.
+ */
+void encodeHex(const unsigned char *bytes,
+    char *digits,
+    const char *table)
+{
+    for (size_t i = 0; i < 16; ++i) {
+        digits[2 * i] = table[bytes[i] >> 4];
+        digits[2 * i + 1] = table[bytes[i] & 0x0F];
+    }
+}
+
+
+/** \brief Get value of hex digit, or -1 if invalid.
+ */
+int hexNibble(const char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+
+/** \brief Decode and validate 32 hex digits of either case.
+ */
+bool decodeHex(const char *digits,
+    unsigned char *bytes)
+{
+    for (size_t i = 0; i < 16; ++i) {
+        int high = hexNibble(digits[2 * i]);
+        int low = hexNibble(digits[2 * i + 1]);
+        if ((high | low) < 0) {
+            return false;
+        }
+        bytes[i] = static_cast<unsigned char>((high << 4) | low);
+    }
+
+    return true;
+}
+
+#endif
+
+}   /* anonymous */
+
 // HELPERS
 // -------
 
@@ -50,27 +228,107 @@ auto TO_LPIID(GUID *guid)
     return reinterpret_cast<LPIID>(guid);
 }
 
+// FUNCTIONS
+// ---------
+
+
+/** \brief Parse GUID string, with or without braces, at runtime.
+ */
+bool readGuid(const char *string,
+    const size_t length,
+    GUID &id)
+{
+    if (length == 38) {
+        if (string[0] != '{' || string[37] != '}') {
+            return false;
+        }
+        return readGuid(string + 1, 36, id);
+    }
+    if (length != 36 || string[8] != '-' || string[13] != '-' || string[18] != '-' || string[23] != '-') {
+        return false;
+    }
+
+    char digits[32];
+    unsigned char bytes[16];
+    compactDigits(string, digits);
+    if (!decodeHex(digits, bytes)) {
+        return false;
+    }
+    fromBytes(bytes, id);
+
+    return true;
+}
+
+
+/** \brief Write GUID to buffer of at least 38 characters.
+ */
+size_t formatGuid(const GUID &id,
+    char *buffer,
+    const GuidFormat format)
+{
+    const bool braced = format == GUID_BRACED_UPPER || format == GUID_BRACED_LOWER;
+    const bool lower = format == GUID_LOWER || format == GUID_BRACED_LOWER;
+
+    unsigned char bytes[16];
+    char digits[32];
+    toBytes(id, bytes);
+    encodeHex(bytes, digits, lower ? LOWER_DIGITS : UPPER_DIGITS);
+
+    if (braced) {
+        buffer[0] = '{';
+        expandDigits(digits, buffer + 1);
+        buffer[37] = '}';
+        return 38;
+    }
+    expandDigits(digits, buffer);
+
+    return 36;
+}
+
 // OBJECTS
 // -------
 
 
 /** \brief Open GUID from wide-string identifier.
+ *
+ *  GUID strings are parsed without COM, while other strings are
+ *  looked up as a ProgID through the process-wide cache. Unknown
+ *  ProgIDs give a null GUID, whether or not the failure is cached.
  */
 void Guid::open(const Bstr &string)
 {
     if (!string.empty() && string.front() == L'{') {
-        CLSIDFromString(string, TO_LPCLSID(&id));
+        // GUID strings are ASCII, narrow before parsing
+        char narrow[38];
+        const size_t length = string.size();
+        bool ascii = length == 38;
+        for (size_t i = 0; ascii && i < length; ++i) {
+            ascii = string.at(i) < 0x80;
+            narrow[i] = static_cast<char>(string.at(i));
+        }
+        if (!ascii || !readGuid(narrow, length, id)) {
+            throw std::invalid_argument("Invalid GUID string.");
+        }
     } else {
-        CLSIDFromProgID(string, TO_LPCLSID(&id));
+        if (FAILED(ProgIdCache::global().resolve(string.data(), string.size(), id))) {
+            id = GUID_NULL;
+        }
     }
 }
 
 
-/** \brief Initializer list constructor.
+/** \brief Open GUID from narrow-string identifier.
  */
-Guid::Guid(const GUID &guid):
-    id(guid)
-{}
+void Guid::open(const char *array,
+    const size_t length)
+{
+    if (readGuid(array, length, id)) {
+        return;
+    } else if (length && array[0] == '{') {
+        throw std::invalid_argument("Invalid GUID string.");
+    }
+    open(Bstr(array, length));
+}
 
 
 /** \brief Initializer from existing Bstr wrapper.
@@ -85,7 +343,7 @@ Guid::Guid(const Bstr &string)
  */
 Guid::Guid(const char *cstring)
 {
-    open(Bstr(cstring));
+    open(cstring, std::strlen(cstring));
 }
 
 
@@ -94,7 +352,7 @@ Guid::Guid(const char *cstring)
 Guid::Guid(const char *array,
     const size_t length)
 {
-    open(Bstr(array, length));
+    open(array, length);
 }
 
 
@@ -102,7 +360,7 @@ Guid::Guid(const char *array,
  */
 Guid::Guid(const std::string &string)
 {
-    open(string);
+    open(string.data(), string.size());
 }
 
 
@@ -157,7 +415,7 @@ std::string Guid::toProgid()
         return "";
     }
 
-    std::string narrow = codec_utf16_utf8(reinterpret_cast<char16_t*>(progid));
+    std::string narrow = wideToUtf8(progid);
     CoTaskMemFree(progid);
 
     return narrow;
@@ -190,7 +448,7 @@ std::string Guid::toClsid()
         return "";
     }
 
-    std::string narrow = codec_utf16_utf8(reinterpret_cast<char16_t*>(clsid));
+    std::string narrow = wideToUtf8(clsid);
     CoTaskMemFree(clsid);
 
     return narrow;
@@ -201,8 +459,7 @@ std::string Guid::toClsid()
  */
 Guid Guid::fromIid(const std::string &string)
 {
-    auto u16 = codec_utf8_utf16(string);
-    return fromIid(reinterpret_cast<const wchar_t*>(u16.data()));
+    return fromIid(utf8ToWide(string));
 }
 
 
@@ -227,7 +484,7 @@ std::string Guid::toIid()
         return "";
     }
 
-    std::string narrow = codec_utf16_utf8(reinterpret_cast<char16_t*>(iid));
+    std::string narrow = wideToUtf8(iid);
     CoTaskMemFree(iid);
 
     return narrow;
@@ -237,16 +494,12 @@ std::string Guid::toIid()
 /** \brief Export GUID to UUID representation.
  *
  *  guid.uuid() -> "00000000-0000-0000-C000-000000000046"
+ *  guid.uuid(GUID_BRACED_LOWER) -> "{00000000-0000-0000-c000-000000000046}"
  */
-std::string Guid::uuid() const
+std::string Guid::uuid(const GuidFormat format) const
 {
-    // 36 characters + null character
-    char *buffer = new char[37];
-    const size_t size = snprintf(buffer, 37, "%08lX-%04hX-%04hX-%02hhX%02hhX-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX", id.Data1, id.Data2, id.Data3, id.Data4[0], id.Data4[1], id.Data4[2], id.Data4[3], id.Data4[4], id.Data4[5], id.Data4[6], id.Data4[7]);
-    std::string output(buffer, size);
-    delete[] buffer;
-
-    return output;
+    char buffer[38];
+    return std::string(buffer, formatGuid(id, buffer, format));
 }
 
 
@@ -259,7 +512,7 @@ std::string Guid::define(const std::string &prefix,
     const std::string &name) const
 {
     char *buffer = new char[75];
-    const size_t size = snprintf(buffer, 75, "0x%08lX, 0x%04hX, 0x%04hX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX", id.Data1, id.Data2, id.Data3, id.Data4[0], id.Data4[1], id.Data4[2], id.Data4[3], id.Data4[4], id.Data4[5], id.Data4[6], id.Data4[7]);
+    const size_t size = snprintf(buffer, 75, "0x%08lX, 0x%04hX, 0x%04hX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX", static_cast<unsigned long>(id.Data1), id.Data2, id.Data3, id.Data4[0], id.Data4[1], id.Data4[2], id.Data4[3], id.Data4[4], id.Data4[5], id.Data4[6], id.Data4[7]);
     std::string output(buffer, size);
     delete[] buffer;
 
@@ -267,21 +520,17 @@ std::string Guid::define(const std::string &prefix,
 }
 
 
-/** \brief Equality operator.
+/** \brief Export GUID to constexpr constant representation.
+ *
+ *  guid.constant() -> "constexpr GUID IID_IUnknown = {0x00000000, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};"
  */
-bool operator==(const Guid &left,
-    const Guid &right)
+std::string Guid::constant(const std::string &prefix,
+    const std::string &name) const
 {
-    return left.id == right.id;
-}
+    char buffer[80];
+    const size_t size = snprintf(buffer, 80, "{0x%08lX, 0x%04hX, 0x%04hX, {0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX, 0x%02hhX}}", static_cast<unsigned long>(id.Data1), id.Data2, id.Data3, id.Data4[0], id.Data4[1], id.Data4[2], id.Data4[3], id.Data4[4], id.Data4[5], id.Data4[6], id.Data4[7]);
 
-
-/** \brief Inequality operator.
- */
-bool operator!=(const Guid &left,
-    const Guid &right)
-{
-    return !operator==(left, right);
+    return "constexpr GUID " + prefix + "_" + name + " = " + std::string(buffer, size) + ";";
 }
 
 
@@ -58,9 +58,9 @@ const DispatchBase * Iterator::operator->() const
 Iterator & Iterator::operator++()
 {
     VARIANT result;
-    ULONG fetched;
+    ULONG fetched = 0;
     auto ev = ppv.lock();
-    if (ev && SUCCEEDED(ev->Next(1, &result, &fetched))) {
+    if (ev && SUCCEEDED(ev->Next(1, &result, &fetched)) && fetched == 1) {
         dispatch.open(result.pdispVal);
     } else {
         dispatch.open(nullptr);
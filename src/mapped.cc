@@ -0,0 +1,380 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Memory-mapped SafeArray spill files.
+ */
+
+#include <autocom/mapped.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+namespace
+{
+// CONSTANTS
+// ---------
+
+/** Spill files start with a fixed header, followed by one bound per
+ *  dimension, with the data aligned to a cache line. All fields are
+ *  stored in native byte order.
+ */
+const char SPILL_MAGIC[8] = {'A', 'C', 'S', 'P', 'I', 'L', 'L', '\0'};
+const uint32_t SPILL_VERSION = 1;
+const uint64_t SPILL_ALIGNMENT = 64;
+
+// OBJECTS
+// -------
+
+
+/** \brief Fixed-size spill file header.
+ */
+struct SpillHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint16_t vt;
+    uint16_t dimensions;
+    uint32_t element;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t count;
+};
+
+
+/** \brief Serialized dimension bound.
+ */
+struct SpillBound
+{
+    uint32_t elements;
+    int32_t lower;
+};
+
+static_assert(sizeof(SpillHeader) == 40, "Unexpected spill header size.");
+static_assert(sizeof(SpillBound) == 8, "Unexpected spill bound size.");
+
+// HELPERS
+// -------
+
+
+/** \brief Get byte offset of spilled data.
+ */
+uint64_t dataOffset(const uint16_t dimensions)
+{
+    uint64_t offset = sizeof(SpillHeader) + dimensions * sizeof(SpillBound);
+    return (offset + SPILL_ALIGNMENT - 1) & ~(SPILL_ALIGNMENT - 1);
+}
+
+
+/** \brief Throw on malformed spill file.
+ */
+void invalidSpill(const char *reason)
+{
+    throw std::runtime_error(std::string("Invalid SafeArray spill file: ") + reason);
+}
+
+}   /* anonymous */
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Write SAFEARRAY type, bounds and data to a spill file.
+ */
+void spillSafeArray(const SAFEARRAY *array,
+    const std::string &path)
+{
+    if (!array) {
+        throw std::invalid_argument("Cannot spill null SAFEARRAY.");
+    }
+    const USHORT pointers = FADF_BSTR | FADF_UNKNOWN | FADF_DISPATCH | FADF_VARIANT | FADF_RECORD;
+    if (array->fFeatures & pointers) {
+        throw std::invalid_argument("Cannot spill SAFEARRAY holding pointers.");
+    }
+
+    SpillHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SPILL_MAGIC, sizeof(SPILL_MAGIC));
+    header.version = SPILL_VERSION;
+    header.vt = getSafeArrayType(array);
+    header.dimensions = array->cDims;
+    header.element = array->cbElements;
+    header.offset = dataOffset(array->cDims);
+    header.count = 1;
+
+    std::vector<SpillBound> bounds(array->cDims);
+    for (USHORT i = 0; i < array->cDims; ++i) {
+        bounds[i].elements = array->rgsabound[i].cElements;
+        bounds[i].lower = array->rgsabound[i].lLbound;
+        header.count *= array->rgsabound[i].cElements;
+    }
+
+    std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw std::runtime_error("Unable to open spill file: " + path);
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(bounds.data()), bounds.size() * sizeof(SpillBound));
+    const char padding[SPILL_ALIGNMENT] = {};
+    stream.write(padding, header.offset - sizeof(header) - bounds.size() * sizeof(SpillBound));
+
+    auto *safearray = const_cast<SAFEARRAY*>(array);
+    if (FAILED(SafeArrayLock(safearray))) {
+        throw ComFunctionError("SafeArrayLock()");
+    }
+    stream.write(reinterpret_cast<const char*>(array->pvData), header.count * header.element);
+    SafeArrayUnlock(safearray);
+
+    stream.flush();
+    if (!stream) {
+        throw std::runtime_error("Unable to write spill file: " + path);
+    }
+}
+
+
+/** \brief Validate and parse the header of a mapped spill file.
+ */
+SpillLayout readSpill(const MappedFile &file)
+{
+    const auto *bytes = reinterpret_cast<const char*>(file.data());
+    if (!bytes || file.size() < sizeof(SpillHeader)) {
+        invalidSpill("file is too small");
+    }
+
+    SpillHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, SPILL_MAGIC, sizeof(SPILL_MAGIC)) != 0) {
+        invalidSpill("bad magic");
+    } else if (header.version != SPILL_VERSION) {
+        invalidSpill("unsupported version");
+    } else if (header.dimensions == 0 || header.element == 0) {
+        invalidSpill("empty layout");
+    } else if (header.offset != dataOffset(header.dimensions)) {
+        invalidSpill("bad data offset");
+    } else if (header.offset > file.size()) {
+        invalidSpill("file is truncated");
+    }
+
+    SpillLayout layout;
+    layout.vt = header.vt;
+    layout.element = header.element;
+    layout.bounds.resize(header.dimensions);
+
+    uint64_t count = 1;
+    const auto *bound = bytes + sizeof(SpillHeader);
+    for (auto &item: layout.bounds) {
+        SpillBound spilled;
+        std::memcpy(&spilled, bound, sizeof(spilled));
+        bound += sizeof(spilled);
+        item.cElements = spilled.elements;
+        item.lLbound = spilled.lower;
+        if (spilled.elements && count > UINT64_MAX / spilled.elements) {
+            invalidSpill("element count overflows");
+        }
+        count *= spilled.elements;
+    }
+
+    if (count != header.count) {
+        invalidSpill("bounds do not match element count");
+    } else if (count > (file.size() - header.offset) / header.element) {
+        invalidSpill("file is truncated");
+    }
+    layout.data = bytes + header.offset;
+
+    return layout;
+}
+
+// OBJECTS
+// -------
+
+
+/** \brief Move constructor.
+ */
+MappedFile::MappedFile(MappedFile &&other)
+{
+    operator=(std::move(other));
+}
+
+
+/** \brief Move assignment operator.
+ */
+MappedFile & MappedFile::operator=(MappedFile &&other)
+{
+    if (this != &other) {
+        close();
+        address = other.address;
+        length = other.length;
+        other.address = nullptr;
+        other.length = 0;
+    }
+
+    return *this;
+}
+
+
+/** \brief Unmap file.
+ */
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+
+/** \brief Map file from path.
+ */
+MappedFile::MappedFile(const std::string &path)
+{
+    open(path);
+}
+
+
+#if defined(_WIN32)
+
+
+/** \brief Map file read-only. The file and mapping handles are closed
+ *  once the view exists, since the view keeps the mapping alive.
+ */
+void MappedFile::open(const std::string &path)
+{
+    close();
+
+    HANDLE handle = CreateFileA(path.data(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Unable to open mapped file: " + path);
+    }
+
+    LARGE_INTEGER bytes;
+    if (!GetFileSizeEx(handle, &bytes)) {
+        CloseHandle(handle);
+        throw std::runtime_error("Unable to get size of mapped file: " + path);
+    }
+    if (bytes.QuadPart == 0) {
+        CloseHandle(handle);
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (!mapping) {
+        throw std::runtime_error("Unable to create file mapping: " + path);
+    }
+
+    address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!address) {
+        throw std::runtime_error("Unable to map view of file: " + path);
+    }
+    length = static_cast<size_t>(bytes.QuadPart);
+}
+
+
+/** \brief Unmap file.
+ */
+void MappedFile::close()
+{
+    if (address) {
+        UnmapViewOfFile(address);
+        address = nullptr;
+        length = 0;
+    }
+}
+
+
+#else
+
+
+/** \brief Map file read-only. The descriptor is closed once the
+ *  mapping exists, since the mapping keeps the file alive.
+ */
+void MappedFile::open(const std::string &path)
+{
+    close();
+
+    int descriptor = ::open(path.data(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("Unable to open mapped file: " + path);
+    }
+
+    struct stat info;
+    if (fstat(descriptor, &info) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error("Unable to get size of mapped file: " + path);
+    }
+    if (info.st_size == 0) {
+        ::close(descriptor);
+        return;
+    }
+
+    void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Unable to map file: " + path);
+    }
+    madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+
+    address = mapped;
+    length = static_cast<size_t>(info.st_size);
+}
+
+
+/** \brief Unmap file.
+ */
+void MappedFile::close()
+{
+    if (address) {
+        munmap(address, length);
+        address = nullptr;
+        length = 0;
+    }
+}
+
+
+#endif
+
+
+/** \brief Get address of mapped data.
+ */
+const void * MappedFile::data() const
+{
+    return address;
+}
+
+
+/** \brief Get number of mapped bytes.
+ */
+size_t MappedFile::size() const
+{
+    return length;
+}
+
+
+/** \brief Check if a file is mapped.
+ */
+bool MappedFile::isOpen() const
+{
+    return address != nullptr;
+}
+
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
@@ -0,0 +1,202 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Size-class allocator for BSTR and SAFEARRAY memory.
+ */
+
+#include "allocator.h"
+
+#include <cstdlib>
+#include <cstring>
+
+
+namespace autocom
+{
+namespace ole
+{
+namespace
+{
+// CONSTANTS
+// ---------
+
+/** Size classes are powers of two, from 32 bytes to 4 KiB, headers
+ *  included.
+ */
+const size_t SMALLEST_CLASS = 32;
+const uint32_t SIZE_CLASSES = 8;
+const uint32_t LARGE_CLASS = SIZE_CLASSES;
+
+/** Maximum number of cached blocks per thread and size class.
+ */
+const size_t CACHE_DEPTH = 64;
+
+// OBJECTS
+// -------
+
+
+/** \brief Header preceding each block.
+ */
+struct Header
+{
+    uint32_t sizeClass;
+    uint32_t size;
+};
+
+static_assert(sizeof(Header) == ALLOCATION_HEADER, "Unexpected allocation header size.");
+
+
+/** \brief Freed blocks of the current thread, by size class.
+ */
+struct Cache
+{
+    void *blocks[SIZE_CLASSES][CACHE_DEPTH];
+    size_t counts[SIZE_CLASSES] = {};
+
+    Cache();
+    ~Cache();
+};
+
+
+/** \brief Lifetime of the thread's cache.
+ *
+ *  Thread-local automation values may be destroyed after the cache,
+ *  during thread exit, and must then bypass it.
+ */
+enum CacheState
+{
+    CACHE_UNUSED    = 0,
+    CACHE_LIVE      = 1,
+    CACHE_DESTROYED = 2,
+};
+
+thread_local CacheState STATE = CACHE_UNUSED;
+thread_local Cache CACHE;
+
+// HELPERS
+// -------
+
+
+Cache::Cache()
+{
+    STATE = CACHE_LIVE;
+}
+
+
+Cache::~Cache()
+{
+    STATE = CACHE_DESTROYED;
+    for (uint32_t i = 0; i < SIZE_CLASSES; ++i) {
+        for (size_t j = 0; j < counts[i]; ++j) {
+            std::free(blocks[i][j]);
+        }
+    }
+}
+
+
+Cache * threadCache()
+{
+    if (STATE == CACHE_DESTROYED) {
+        return nullptr;
+    }
+    return &CACHE;
+}
+
+
+/** \brief Get smallest size class holding `bytes`, with the header.
+ */
+uint32_t sizeClass(const size_t bytes)
+{
+    size_t total = bytes + ALLOCATION_HEADER;
+    size_t size = SMALLEST_CLASS;
+    for (uint32_t i = 0; i < SIZE_CLASSES; ++i, size <<= 1) {
+        if (total <= size) {
+            return i;
+        }
+    }
+    return LARGE_CLASS;
+}
+
+
+size_t classSize(const uint32_t index)
+{
+    return SMALLEST_CLASS << index;
+}
+
+
+Header * header(const void *block)
+{
+    return reinterpret_cast<Header*>(const_cast<char*>(static_cast<const char*>(block)) - ALLOCATION_HEADER);
+}
+
+}   /* anonymous */
+
+// FUNCTIONS
+// ---------
+
+
+void * allocate(const size_t bytes)
+{
+    if (bytes > UINT32_MAX - ALLOCATION_HEADER) {
+        return nullptr;
+    }
+
+    uint32_t index = sizeClass(bytes);
+    void *memory = nullptr;
+    if (index != LARGE_CLASS) {
+        Cache *cache = threadCache();
+        if (cache && cache->counts[index]) {
+            memory = cache->blocks[index][--cache->counts[index]];
+        } else {
+            memory = std::malloc(classSize(index));
+        }
+    } else {
+        memory = std::malloc(bytes + ALLOCATION_HEADER);
+    }
+    if (!memory) {
+        return nullptr;
+    }
+
+    auto *head = static_cast<Header*>(memory);
+    head->sizeClass = index;
+    head->size = static_cast<uint32_t>(bytes);
+    return static_cast<char*>(memory) + ALLOCATION_HEADER;
+}
+
+
+void * allocateZeroed(const size_t bytes)
+{
+    void *block = allocate(bytes);
+    if (block) {
+        std::memset(block, 0, bytes);
+    }
+    return block;
+}
+
+
+void deallocate(void *block)
+{
+    if (!block) {
+        return;
+    }
+
+    Header *head = header(block);
+    uint32_t index = head->sizeClass;
+    if (index != LARGE_CLASS) {
+        Cache *cache = threadCache();
+        if (cache && cache->counts[index] < CACHE_DEPTH) {
+            cache->blocks[index][cache->counts[index]++] = head;
+            return;
+        }
+    }
+    std::free(head);
+}
+
+
+size_t allocatedSize(const void *block)
+{
+    return header(block)->size;
+}
+
+}   /* ole */
+}   /* autocom */
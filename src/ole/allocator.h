@@ -0,0 +1,53 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Size-class allocator for BSTR and SAFEARRAY memory.
+ *
+ *  Automation values are short-lived and small, and are usually freed
+ *  on the thread which allocated them, so each thread keeps a bounded
+ *  cache of freed blocks for each size class, like the BSTR cache of
+ *  oleaut32. Larger blocks go straight to the system allocator.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace autocom
+{
+namespace ole
+{
+// CONSTANTS
+// ---------
+
+/** Bytes before each block, recording its size class. Keeps blocks
+ *  aligned to 8 bytes, enough for any automation type.
+ */
+const size_t ALLOCATION_HEADER = 8;
+
+// FUNCTIONS
+// ---------
+
+/** \brief Allocate `bytes` of uninitialized memory.
+ *
+ *  \return                     Block, or nullptr if out of memory.
+ */
+void * allocate(const size_t bytes);
+
+/** \brief Allocate `bytes` of zeroed memory.
+ */
+void * allocateZeroed(const size_t bytes);
+
+/** \brief Free block from `allocate`, caching it for reuse.
+ */
+void deallocate(void *block);
+
+/** \brief Get bytes requested for block from `allocate`.
+ */
+size_t allocatedSize(const void *block);
+
+}   /* ole */
+}   /* autocom */
@@ -0,0 +1,134 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable BSTR allocation.
+ *
+ *  BSTRs use the Windows layout: a 32-bit byte length, followed by
+ *  the characters and a null terminator, with the BSTR pointing to the
+ *  first character.
+ */
+
+#include "allocator.h"
+
+#include <oleauto.h>
+
+#include <cstring>
+#include <cwchar>
+
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Allocate BSTR of `bytes`, leaving the content uninitialized.
+ */
+BSTR allocateString(const size_t bytes)
+{
+    if (bytes > UINT32_MAX - sizeof(uint32_t) - sizeof(OLECHAR)) {
+        return nullptr;
+    }
+
+    void *block = autocom::ole::allocate(sizeof(uint32_t) + bytes + sizeof(OLECHAR));
+    if (!block) {
+        return nullptr;
+    }
+
+    auto *prefix = static_cast<uint32_t*>(block);
+    *prefix = static_cast<uint32_t>(bytes);
+    auto *data = reinterpret_cast<char*>(prefix + 1);
+    std::memset(data + bytes, 0, sizeof(OLECHAR));
+
+    return reinterpret_cast<BSTR>(data);
+}
+
+
+uint32_t * lengthPrefix(BSTR string)
+{
+    return reinterpret_cast<uint32_t*>(string) - 1;
+}
+
+}   /* anonymous */
+
+// FUNCTIONS
+// ---------
+
+
+BSTR SysAllocString(const OLECHAR *string)
+{
+    if (!string) {
+        return nullptr;
+    }
+    return SysAllocStringLen(string, static_cast<UINT>(std::wcslen(string)));
+}
+
+
+/** \brief Allocate BSTR of `length` characters, copied from `string`.
+ *
+ *  Characters are zeroed when `string` is null.
+ */
+BSTR SysAllocStringLen(const OLECHAR *string,
+    UINT length)
+{
+    size_t bytes = size_t(length) * sizeof(OLECHAR);
+    BSTR bstr = allocateString(bytes);
+    if (bstr) {
+        if (string) {
+            std::memcpy(bstr, string, bytes);
+        } else {
+            std::memset(bstr, 0, bytes);
+        }
+    }
+    return bstr;
+}
+
+
+BSTR SysAllocStringByteLen(LPCSTR string,
+    UINT length)
+{
+    BSTR bstr = allocateString(length);
+    if (bstr) {
+        if (string) {
+            std::memcpy(bstr, string, length);
+        } else {
+            std::memset(bstr, 0, length);
+        }
+    }
+    return bstr;
+}
+
+
+INT SysReAllocStringLen(BSTR *bstr,
+    const OLECHAR *string,
+    UINT length)
+{
+    BSTR copy = SysAllocStringLen(string, length);
+    if (!copy) {
+        return FALSE;
+    }
+    SysFreeString(*bstr);
+    *bstr = copy;
+    return TRUE;
+}
+
+
+void SysFreeString(BSTR string)
+{
+    if (string) {
+        autocom::ole::deallocate(lengthPrefix(string));
+    }
+}
+
+
+UINT SysStringLen(BSTR string)
+{
+    return string ? *lengthPrefix(string) / sizeof(OLECHAR) : 0;
+}
+
+
+UINT SysStringByteLen(BSTR string)
+{
+    return string ? *lengthPrefix(string) : 0;
+}
@@ -0,0 +1,569 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable COM runtime and interface identifiers.
+ */
+
+#include <dispex.h>
+#include <objbase.h>
+#include <ocidl.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+
+// GUIDS
+// -----
+
+const GUID GUID_NULL = {0x00000000, 0x0000, 0x0000, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}};
+const IID IID_NULL = {0x00000000, 0x0000, 0x0000, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}};
+const CLSID CLSID_NULL = {0x00000000, 0x0000, 0x0000, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}};
+
+const IID IID_IUnknown = {0x00000000, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const IID IID_IClassFactory = {0x00000001, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const IID IID_IRecordInfo = {0x0000002F, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const IID IID_IGlobalInterfaceTable = {0x00000146, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const IID IID_IDispatch = {0x00020400, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const IID IID_ITypeInfo = {0x00020401, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const IID IID_ITypeLib = {0x00020402, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const IID IID_ITypeComp = {0x00020403, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const IID IID_IEnumVARIANT = {0x00020404, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+const IID IID_IErrorInfo = {0x1CF2B120, 0x547D, 0x101B, {0x8E, 0x65, 0x08, 0x00, 0x2B, 0x2B, 0xD1, 0x19}};
+const IID IID_ISupportErrorInfo = {0xDF0B3D60, 0x548F, 0x101B, {0x8E, 0x65, 0x08, 0x00, 0x2B, 0x2B, 0xD1, 0x19}};
+const IID IID_IProvideClassInfo = {0xB196B283, 0xBAB4, 0x101A, {0xB6, 0x9C, 0x00, 0xAA, 0x00, 0x34, 0x1D, 0x07}};
+const IID IID_IConnectionPointContainer = {0xB196B284, 0xBAB4, 0x101A, {0xB6, 0x9C, 0x00, 0xAA, 0x00, 0x34, 0x1D, 0x07}};
+const IID IID_IEnumConnectionPoints = {0xB196B285, 0xBAB4, 0x101A, {0xB6, 0x9C, 0x00, 0xAA, 0x00, 0x34, 0x1D, 0x07}};
+const IID IID_IConnectionPoint = {0xB196B286, 0xBAB4, 0x101A, {0xB6, 0x9C, 0x00, 0xAA, 0x00, 0x34, 0x1D, 0x07}};
+const IID IID_IEnumConnections = {0xB196B287, 0xBAB4, 0x101A, {0xB6, 0x9C, 0x00, 0xAA, 0x00, 0x34, 0x1D, 0x07}};
+const IID IID_IObjectIdentity = {0xCA04B7E6, 0x0D21, 0x11D1, {0x8C, 0xC5, 0x00, 0xC0, 0x4F, 0xC2, 0xB0, 0x85}};
+
+const CLSID CLSID_StdGlobalInterfaceTable = {0x00000323, 0x0000, 0x0000, {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46}};
+
+
+namespace
+{
+// CONSTANTS
+// ---------
+
+/** Characters in a braced GUID, without the null terminator.
+ */
+const int GUID_LENGTH = 38;
+
+// OBJECTS
+// -------
+
+
+/** \brief Initialization state of the calling thread.
+ */
+struct Apartment
+{
+    ULONG count = 0;
+    DWORD model = COINIT_MULTITHREADED;
+};
+
+thread_local Apartment APARTMENT;
+
+
+/** \brief Process-wide Global Interface Table.
+ *
+ *  Every thread shares the process, so the table stores the object
+ *  itself, and `GetInterfaceFromGlobal` returns a new reference to
+ *  the requested interface.
+ */
+class GlobalInterfaceTable: public IGlobalInterfaceTable
+{
+public:
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **object) override;
+    ULONG STDMETHODCALLTYPE AddRef() override;
+    ULONG STDMETHODCALLTYPE Release() override;
+
+    HRESULT STDMETHODCALLTYPE RegisterInterfaceInGlobal(IUnknown *object,
+        REFIID iid,
+        DWORD *cookie) override;
+    HRESULT STDMETHODCALLTYPE RevokeInterfaceFromGlobal(DWORD cookie) override;
+    HRESULT STDMETHODCALLTYPE GetInterfaceFromGlobal(DWORD cookie,
+        REFIID iid,
+        void **object) override;
+
+private:
+    std::mutex mutex;
+    DWORD next = 1;
+    std::unordered_map<DWORD, IUnknown*> objects;
+};
+
+
+HRESULT STDMETHODCALLTYPE GlobalInterfaceTable::QueryInterface(REFIID iid,
+    void **object)
+{
+    if (!object) {
+        return E_POINTER;
+    } else if (iid == IID_IUnknown || iid == IID_IGlobalInterfaceTable) {
+        *object = static_cast<IGlobalInterfaceTable*>(this);
+        return S_OK;
+    }
+
+    *object = nullptr;
+    return E_NOINTERFACE;
+}
+
+
+/** The table lives for the duration of the process.
+ */
+ULONG STDMETHODCALLTYPE GlobalInterfaceTable::AddRef()
+{
+    return 2;
+}
+
+
+ULONG STDMETHODCALLTYPE GlobalInterfaceTable::Release()
+{
+    return 1;
+}
+
+
+HRESULT STDMETHODCALLTYPE GlobalInterfaceTable::RegisterInterfaceInGlobal(IUnknown *object,
+    REFIID iid,
+    DWORD *cookie)
+{
+    if (!object || !cookie) {
+        return E_INVALIDARG;
+    }
+
+    IUnknown *reference = nullptr;
+    HRESULT hr = object->QueryInterface(iid, (void**) &reference);
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    *cookie = next++;
+    objects[*cookie] = reference;
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE GlobalInterfaceTable::RevokeInterfaceFromGlobal(DWORD cookie)
+{
+    IUnknown *object;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = objects.find(cookie);
+        if (it == objects.end()) {
+            return E_INVALIDARG;
+        }
+        object = it->second;
+        objects.erase(it);
+    }
+
+    object->Release();
+    return S_OK;
+}
+
+
+HRESULT STDMETHODCALLTYPE GlobalInterfaceTable::GetInterfaceFromGlobal(DWORD cookie,
+    REFIID iid,
+    void **object)
+{
+    if (!object) {
+        return E_INVALIDARG;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = objects.find(cookie);
+    if (it == objects.end()) {
+        *object = nullptr;
+        return E_INVALIDARG;
+    }
+    return it->second->QueryInterface(iid, object);
+}
+
+
+GlobalInterfaceTable GLOBAL_INTERFACE_TABLE;
+
+thread_local IErrorInfo *ERROR_INFO = nullptr;
+
+// HELPERS
+// -------
+
+
+int hexDigit(const OLECHAR c)
+{
+    if (c >= L'0' && c <= L'9') {
+        return c - L'0';
+    } else if (c >= L'a' && c <= L'f') {
+        return c - L'a' + 10;
+    } else if (c >= L'A' && c <= L'F') {
+        return c - L'A' + 10;
+    }
+    return -1;
+}
+
+
+/** \brief Parse `digits` hexadecimal characters, advancing the string.
+ */
+bool parseHex(LPCOLESTR &string,
+    const int digits,
+    uint32_t &value)
+{
+    value = 0;
+    for (int i = 0; i < digits; ++i) {
+        int digit = hexDigit(*string++);
+        if (digit < 0) {
+            return false;
+        }
+        value = (value << 4) | static_cast<uint32_t>(digit);
+    }
+    return true;
+}
+
+
+bool parseSeparator(LPCOLESTR &string,
+    const OLECHAR separator)
+{
+    return *string++ == separator;
+}
+
+
+/** \brief Parse braced GUID, `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}`.
+ */
+bool parseGuid(LPCOLESTR string,
+    GUID &guid)
+{
+    uint32_t value;
+    if (!string || !parseSeparator(string, L'{')) {
+        return false;
+    }
+
+    if (!parseHex(string, 8, value)) {
+        return false;
+    }
+    guid.Data1 = value;
+    if (!parseSeparator(string, L'-') || !parseHex(string, 4, value)) {
+        return false;
+    }
+    guid.Data2 = static_cast<uint16_t>(value);
+    if (!parseSeparator(string, L'-') || !parseHex(string, 4, value)) {
+        return false;
+    }
+    guid.Data3 = static_cast<uint16_t>(value);
+    if (!parseSeparator(string, L'-')) {
+        return false;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        if (i == 2 && !parseSeparator(string, L'-')) {
+            return false;
+        } else if (!parseHex(string, 2, value)) {
+            return false;
+        }
+        guid.Data4[i] = static_cast<uint8_t>(value);
+    }
+
+    return parseSeparator(string, L'}') && *string == 0;
+}
+
+
+/** \brief Allocate braced GUID string with CoTaskMemAlloc.
+ */
+HRESULT allocateGuidString(REFGUID guid,
+    LPOLESTR *string)
+{
+    if (!string) {
+        return E_INVALIDARG;
+    }
+
+    *string = static_cast<LPOLESTR>(CoTaskMemAlloc((GUID_LENGTH + 1) * sizeof(OLECHAR)));
+    if (!*string) {
+        return E_OUTOFMEMORY;
+    }
+    StringFromGUID2(guid, *string, GUID_LENGTH + 1);
+    return S_OK;
+}
+
+}   /* anonymous */
+
+// FUNCTIONS
+// ---------
+
+
+HRESULT CoInitialize(LPVOID reserved)
+{
+    return CoInitializeEx(reserved, COINIT_APARTMENTTHREADED);
+}
+
+
+/** \brief Count initialization of the calling thread.
+ *
+ *  \return                     S_FALSE if already initialized, or
+ *                              RPC_E_CHANGED_MODE with another model.
+ */
+HRESULT CoInitializeEx(LPVOID reserved,
+    DWORD flags)
+{
+    (void) reserved;
+    DWORD model = flags & COINIT_APARTMENTTHREADED;
+    if (APARTMENT.count && APARTMENT.model != model) {
+        return RPC_E_CHANGED_MODE;
+    }
+
+    APARTMENT.model = model;
+    return APARTMENT.count++ ? S_FALSE : S_OK;
+}
+
+
+void CoUninitialize()
+{
+    if (APARTMENT.count) {
+        --APARTMENT.count;
+    }
+}
+
+
+/** \brief Create an object, only for CLSID_StdGlobalInterfaceTable.
+ */
+HRESULT CoCreateInstance(REFCLSID clsid,
+    LPUNKNOWN outer,
+    DWORD context,
+    REFIID iid,
+    LPVOID *ppv)
+{
+    (void) context;
+    if (!ppv) {
+        return E_POINTER;
+    }
+
+    *ppv = nullptr;
+    if (outer) {
+        return CLASS_E_NOAGGREGATION;
+    } else if (clsid != CLSID_StdGlobalInterfaceTable) {
+        return REGDB_E_CLASSNOTREG;
+    }
+
+    return GLOBAL_INTERFACE_TABLE.QueryInterface(iid, ppv);
+}
+
+
+LPVOID CoTaskMemAlloc(size_t size)
+{
+    return std::malloc(size ? size : 1);
+}
+
+
+LPVOID CoTaskMemRealloc(LPVOID pointer,
+    size_t size)
+{
+    return std::realloc(pointer, size ? size : 1);
+}
+
+
+void CoTaskMemFree(LPVOID pointer)
+{
+    std::free(pointer);
+}
+
+
+/** \brief Parse a CLSID string, since there is no registry for ProgIDs.
+ */
+HRESULT CLSIDFromProgID(LPCOLESTR progid,
+    LPCLSID clsid)
+{
+    if (!progid || !clsid) {
+        return E_INVALIDARG;
+    } else if (parseGuid(progid, *clsid)) {
+        return S_OK;
+    }
+
+    *clsid = CLSID_NULL;
+    return CO_E_CLASSSTRING;
+}
+
+
+HRESULT ProgIDFromCLSID(REFCLSID clsid,
+    LPOLESTR *progid)
+{
+    (void) clsid;
+    if (!progid) {
+        return E_INVALIDARG;
+    }
+
+    *progid = nullptr;
+    return REGDB_E_CLASSNOTREG;
+}
+
+
+HRESULT CLSIDFromString(LPCOLESTR string,
+    LPCLSID clsid)
+{
+    if (!clsid) {
+        return E_INVALIDARG;
+    } else if (!string || !*string) {
+        *clsid = CLSID_NULL;
+        return S_OK;
+    } else if (parseGuid(string, *clsid)) {
+        return S_OK;
+    }
+
+    *clsid = CLSID_NULL;
+    return CO_E_CLASSSTRING;
+}
+
+
+HRESULT StringFromCLSID(REFCLSID clsid,
+    LPOLESTR *string)
+{
+    return allocateGuidString(clsid, string);
+}
+
+
+HRESULT IIDFromString(LPCOLESTR string,
+    LPIID iid)
+{
+    if (!iid) {
+        return E_INVALIDARG;
+    } else if (!string) {
+        *iid = IID_NULL;
+        return S_OK;
+    } else if (parseGuid(string, *iid)) {
+        return S_OK;
+    }
+
+    *iid = IID_NULL;
+    return E_INVALIDARG;
+}
+
+
+HRESULT StringFromIID(REFIID iid,
+    LPOLESTR *string)
+{
+    return allocateGuidString(iid, string);
+}
+
+
+/** \brief Write braced GUID, returning characters including the terminator.
+ */
+int StringFromGUID2(REFGUID guid,
+    LPOLESTR string,
+    int length)
+{
+    if (!string || length < GUID_LENGTH + 1) {
+        return 0;
+    }
+
+    char buffer[GUID_LENGTH + 1];
+    snprintf(buffer, sizeof(buffer), "{%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X}",
+        guid.Data1, guid.Data2, guid.Data3,
+        guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3],
+        guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+    for (int i = 0; i <= GUID_LENGTH; ++i) {
+        string[i] = static_cast<OLECHAR>(buffer[i]);
+    }
+
+    return GUID_LENGTH + 1;
+}
+
+
+HRESULT GetRecordInfoFromTypeInfo(ITypeInfo *info,
+    IRecordInfo **record)
+{
+    (void) info;
+    if (record) {
+        *record = nullptr;
+    }
+    return E_NOTIMPL;
+}
+
+
+HRESULT LoadTypeLib(LPCOLESTR file,
+    ITypeLib **tlib)
+{
+    return LoadTypeLibEx(file, REGKIND_NONE, tlib);
+}
+
+
+HRESULT LoadTypeLibEx(LPCOLESTR file,
+    REGKIND kind,
+    ITypeLib **tlib)
+{
+    (void) file;
+    (void) kind;
+    if (!tlib) {
+        return E_INVALIDARG;
+    }
+
+    *tlib = nullptr;
+    return TYPE_E_CANTLOADLIBRARY;
+}
+
+
+HRESULT LoadRegTypeLib(REFGUID guid,
+    WORD major,
+    WORD minor,
+    LCID locale,
+    ITypeLib **tlib)
+{
+    (void) guid;
+    (void) major;
+    (void) minor;
+    (void) locale;
+    if (!tlib) {
+        return E_INVALIDARG;
+    }
+
+    *tlib = nullptr;
+    return TYPE_E_LIBNOTREGISTERED;
+}
+
+
+HRESULT QueryPathOfRegTypeLib(REFGUID guid,
+    USHORT major,
+    USHORT minor,
+    LCID locale,
+    BSTR *path)
+{
+    (void) guid;
+    (void) major;
+    (void) minor;
+    (void) locale;
+    if (!path) {
+        return E_INVALIDARG;
+    }
+
+    *path = nullptr;
+    return TYPE_E_LIBNOTREGISTERED;
+}
+
+
+/** \brief Take the error object of the calling thread.
+ */
+HRESULT GetErrorInfo(ULONG reserved,
+    IErrorInfo **info)
+{
+    (void) reserved;
+    if (!info) {
+        return E_INVALIDARG;
+    }
+
+    *info = ERROR_INFO;
+    ERROR_INFO = nullptr;
+    return *info ? S_OK : S_FALSE;
+}
+
+
+/** \brief Replace the error object of the calling thread.
+ */
+HRESULT SetErrorInfo(ULONG reserved,
+    IErrorInfo *info)
+{
+    (void) reserved;
+    if (info) {
+        info->AddRef();
+    }
+    if (ERROR_INFO) {
+        ERROR_INFO->Release();
+    }
+    ERROR_INFO = info;
+    return S_OK;
+}
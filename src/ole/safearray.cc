@@ -0,0 +1,872 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable SAFEARRAY allocation and access.
+ *
+ *  Descriptors use the Windows layout, including the 16 bytes before
+ *  the descriptor, which hold the interface IID, the IRecordInfo, or
+ *  the element VARTYPE, depending on the features. Bounds are stored
+ *  from the rightmost dimension, and elements are column-major, so
+ *  the leftmost index varies fastest.
+ */
+
+#include "allocator.h"
+
+#include <objbase.h>
+
+#include <cstring>
+
+
+namespace
+{
+// CONSTANTS
+// ---------
+
+/** Bytes before the descriptor, for the IID, IRecordInfo or VARTYPE.
+ */
+const size_t DESCRIPTOR_PREFIX = 16;
+
+/** Features owned by the descriptor, rather than by the data.
+ */
+const USHORT TYPE_FEATURES = FADF_RECORD | FADF_HAVEIID | FADF_HAVEVARTYPE
+    | FADF_BSTR | FADF_UNKNOWN | FADF_DISPATCH | FADF_VARIANT;
+
+/** Features for arrays with memory the array does not own.
+ */
+const USHORT STATIC_FEATURES = FADF_AUTO | FADF_STATIC | FADF_EMBEDDED;
+
+const ULONG MAXIMUM_LOCKS = 65535;
+
+// HELPERS
+// -------
+
+
+char * prefix(SAFEARRAY *array)
+{
+    return reinterpret_cast<char*>(array) - DESCRIPTOR_PREFIX;
+}
+
+
+GUID & hiddenIid(SAFEARRAY *array)
+{
+    return *reinterpret_cast<GUID*>(prefix(array));
+}
+
+
+IRecordInfo *& hiddenRecordInfo(SAFEARRAY *array)
+{
+    return *reinterpret_cast<IRecordInfo**>(reinterpret_cast<char*>(array) - sizeof(IRecordInfo*));
+}
+
+
+DWORD & hiddenVartype(SAFEARRAY *array)
+{
+    return *reinterpret_cast<DWORD*>(reinterpret_cast<char*>(array) - sizeof(DWORD));
+}
+
+
+/** \brief Get element size, or 0 for unsupported element types.
+ */
+ULONG elementSize(const VARTYPE vt)
+{
+    switch (vt) {
+        case VT_I1:
+        case VT_UI1:
+            return 1;
+        case VT_I2:
+        case VT_UI2:
+        case VT_BOOL:
+            return 2;
+        case VT_I4:
+        case VT_UI4:
+        case VT_INT:
+        case VT_UINT:
+        case VT_R4:
+        case VT_ERROR:
+            return 4;
+        case VT_I8:
+        case VT_UI8:
+        case VT_R8:
+        case VT_CY:
+        case VT_DATE:
+            return 8;
+        case VT_BSTR:
+        case VT_UNKNOWN:
+        case VT_DISPATCH:
+        case VT_INT_PTR:
+        case VT_UINT_PTR:
+            return sizeof(void*);
+        case VT_VARIANT:
+            return sizeof(VARIANT);
+        case VT_DECIMAL:
+            return sizeof(DECIMAL);
+        default:
+            return 0;
+    }
+}
+
+
+/** \brief Get number of elements in the array.
+ */
+size_t elementCount(const SAFEARRAY *array)
+{
+    size_t count = 1;
+    for (USHORT i = 0; i < array->cDims; ++i) {
+        count *= array->rgsabound[i].cElements;
+    }
+    return count;
+}
+
+
+size_t descriptorSize(const UINT dimensions)
+{
+    return DESCRIPTOR_PREFIX + sizeof(SAFEARRAY) + (dimensions - 1) * sizeof(SAFEARRAYBOUND);
+}
+
+
+/** \brief Set features, and the hidden type, for the element type.
+ */
+HRESULT setElementType(SAFEARRAY *array,
+    const VARTYPE vt,
+    PVOID extra)
+{
+    array->fFeatures &= ~TYPE_FEATURES;
+    std::memset(prefix(array), 0, DESCRIPTOR_PREFIX);
+
+    switch (vt) {
+        case VT_BSTR:
+            array->fFeatures |= FADF_BSTR;
+            break;
+        case VT_UNKNOWN:
+            array->fFeatures |= FADF_UNKNOWN | FADF_HAVEIID;
+            hiddenIid(array) = extra ? *static_cast<GUID*>(extra) : IID_IUnknown;
+            return S_OK;
+        case VT_DISPATCH:
+            array->fFeatures |= FADF_DISPATCH | FADF_HAVEIID;
+            hiddenIid(array) = extra ? *static_cast<GUID*>(extra) : IID_IDispatch;
+            return S_OK;
+        case VT_VARIANT:
+            array->fFeatures |= FADF_VARIANT;
+            break;
+        case VT_RECORD: {
+            auto *info = static_cast<IRecordInfo*>(extra);
+            array->fFeatures |= FADF_RECORD;
+            if (info) {
+                info->AddRef();
+                hiddenRecordInfo(array) = info;
+                if (FAILED(info->GetSize(&array->cbElements))) {
+                    return E_INVALIDARG;
+                }
+            }
+            return S_OK;
+        }
+        default:
+            break;
+    }
+
+    array->fFeatures |= FADF_HAVEVARTYPE;
+    hiddenVartype(array) = vt;
+    return S_OK;
+}
+
+
+/** \brief Release BSTRs, interfaces, variants or records in the data.
+ */
+void clearElements(SAFEARRAY *array,
+    const size_t first,
+    const size_t last)
+{
+    char *data = static_cast<char*>(array->pvData);
+    if (!data) {
+        return;
+    }
+
+    if (array->fFeatures & FADF_BSTR) {
+        auto *items = reinterpret_cast<BSTR*>(data);
+        for (size_t i = first; i < last; ++i) {
+            SysFreeString(items[i]);
+            items[i] = nullptr;
+        }
+    } else if (array->fFeatures & (FADF_UNKNOWN | FADF_DISPATCH)) {
+        auto *items = reinterpret_cast<IUnknown**>(data);
+        for (size_t i = first; i < last; ++i) {
+            if (items[i]) {
+                items[i]->Release();
+                items[i] = nullptr;
+            }
+        }
+    } else if (array->fFeatures & FADF_VARIANT) {
+        auto *items = reinterpret_cast<VARIANT*>(data);
+        for (size_t i = first; i < last; ++i) {
+            VariantClear(&items[i]);
+        }
+    } else if (array->fFeatures & FADF_RECORD) {
+        IRecordInfo *info = hiddenRecordInfo(array);
+        for (size_t i = first; info && i < last; ++i) {
+            info->RecordClear(data + i * array->cbElements);
+        }
+    }
+}
+
+
+/** \brief Copy elements, duplicating BSTRs, interfaces, variants and records.
+ */
+HRESULT copyElements(SAFEARRAY *source,
+    SAFEARRAY *destination)
+{
+    size_t count = elementCount(source);
+    char *from = static_cast<char*>(source->pvData);
+    char *to = static_cast<char*>(destination->pvData);
+    if (!count) {
+        return S_OK;
+    } else if (!from || !to) {
+        return E_INVALIDARG;
+    }
+
+    if (source->fFeatures & FADF_BSTR) {
+        auto *input = reinterpret_cast<BSTR*>(from);
+        auto *output = reinterpret_cast<BSTR*>(to);
+        for (size_t i = 0; i < count; ++i) {
+            SysFreeString(output[i]);
+            output[i] = nullptr;
+            if (input[i]) {
+                output[i] = SysAllocStringByteLen(reinterpret_cast<LPCSTR>(input[i]), SysStringByteLen(input[i]));
+                if (!output[i]) {
+                    return E_OUTOFMEMORY;
+                }
+            }
+        }
+    } else if (source->fFeatures & (FADF_UNKNOWN | FADF_DISPATCH)) {
+        auto *input = reinterpret_cast<IUnknown**>(from);
+        auto *output = reinterpret_cast<IUnknown**>(to);
+        for (size_t i = 0; i < count; ++i) {
+            if (input[i]) {
+                input[i]->AddRef();
+            }
+            if (output[i]) {
+                output[i]->Release();
+            }
+            output[i] = input[i];
+        }
+    } else if (source->fFeatures & FADF_VARIANT) {
+        auto *input = reinterpret_cast<VARIANT*>(from);
+        auto *output = reinterpret_cast<VARIANT*>(to);
+        for (size_t i = 0; i < count; ++i) {
+            HRESULT hr = VariantCopy(&output[i], &input[i]);
+            if (FAILED(hr)) {
+                return hr;
+            }
+        }
+    } else if (source->fFeatures & FADF_RECORD) {
+        IRecordInfo *info = hiddenRecordInfo(source);
+        for (size_t i = 0; info && i < count; ++i) {
+            size_t offset = i * source->cbElements;
+            HRESULT hr = info->RecordCopy(from + offset, to + offset);
+            if (FAILED(hr)) {
+                return hr;
+            }
+        }
+    } else {
+        std::memcpy(to, from, count * source->cbElements);
+    }
+
+    return S_OK;
+}
+
+
+/** \brief Get byte offset of the element at `indices`.
+ */
+HRESULT cellOffset(SAFEARRAY *array,
+    const LONG *indices,
+    size_t &offset)
+{
+    size_t cell = 0;
+    size_t stride = 1;
+    for (USHORT i = 0; i < array->cDims; ++i) {
+        const SAFEARRAYBOUND &bound = array->rgsabound[array->cDims - 1 - i];
+        LONG index = indices[i] - bound.lLbound;
+        if (index < 0 || ULONG(index) >= bound.cElements) {
+            return DISP_E_BADINDEX;
+        }
+        cell += size_t(index) * stride;
+        stride *= bound.cElements;
+    }
+    offset = cell * array->cbElements;
+    return S_OK;
+}
+
+
+/** \brief Create array of an element type, which may need `extra`.
+ */
+SAFEARRAY * createArray(const VARTYPE vt,
+    const UINT dimensions,
+    const SAFEARRAYBOUND *bounds,
+    PVOID extra)
+{
+    if (!bounds || !dimensions) {
+        return nullptr;
+    }
+    if (vt == VT_RECORD) {
+        if (!extra) {
+            return nullptr;
+        }
+    } else if (!elementSize(vt)) {
+        return nullptr;
+    }
+
+    SAFEARRAY *array;
+    if (FAILED(SafeArrayAllocDescriptor(dimensions, &array))) {
+        return nullptr;
+    }
+    array->cbElements = elementSize(vt);
+    if (FAILED(setElementType(array, vt, extra))) {
+        SafeArrayDestroyDescriptor(array);
+        return nullptr;
+    }
+
+    // store bounds from the rightmost dimension
+    for (UINT i = 0; i < dimensions; ++i) {
+        array->rgsabound[dimensions - 1 - i] = bounds[i];
+    }
+    if (FAILED(SafeArrayAllocData(array))) {
+        SafeArrayDestroyDescriptor(array);
+        return nullptr;
+    }
+
+    return array;
+}
+
+}   /* anonymous */
+
+// FUNCTIONS
+// ---------
+
+
+SAFEARRAY * SafeArrayCreate(VARTYPE vt,
+    UINT dimensions,
+    SAFEARRAYBOUND *bounds)
+{
+    if (vt == VT_RECORD) {
+        return nullptr;
+    }
+    return createArray(vt, dimensions, bounds, nullptr);
+}
+
+
+/** \brief Create array, with the IRecordInfo for VT_RECORD, or the IID
+ *  for VT_UNKNOWN and VT_DISPATCH.
+ */
+SAFEARRAY * SafeArrayCreateEx(VARTYPE vt,
+    UINT dimensions,
+    SAFEARRAYBOUND *bounds,
+    PVOID extra)
+{
+    return createArray(vt, dimensions, bounds, extra);
+}
+
+
+SAFEARRAY * SafeArrayCreateVector(VARTYPE vt,
+    LONG lower,
+    ULONG elements)
+{
+    SAFEARRAYBOUND bound = {elements, lower};
+    return SafeArrayCreate(vt, 1, &bound);
+}
+
+
+HRESULT SafeArrayAllocDescriptor(UINT dimensions,
+    SAFEARRAY **out)
+{
+    if (!out) {
+        return E_POINTER;
+    } else if (dimensions == 0 || dimensions > 65535) {
+        return E_INVALIDARG;
+    }
+
+    void *block = autocom::ole::allocateZeroed(descriptorSize(dimensions));
+    if (!block) {
+        *out = nullptr;
+        return E_OUTOFMEMORY;
+    }
+
+    auto *array = reinterpret_cast<SAFEARRAY*>(static_cast<char*>(block) + DESCRIPTOR_PREFIX);
+    array->cDims = static_cast<USHORT>(dimensions);
+    *out = array;
+
+    return S_OK;
+}
+
+
+HRESULT SafeArrayAllocDescriptorEx(VARTYPE vt,
+    UINT dimensions,
+    SAFEARRAY **out)
+{
+    HRESULT hr = SafeArrayAllocDescriptor(dimensions, out);
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    (*out)->cbElements = elementSize(vt);
+    if (vt != VT_RECORD) {
+        setElementType(*out, vt, nullptr);
+    } else {
+        (*out)->fFeatures |= FADF_RECORD;
+    }
+
+    return S_OK;
+}
+
+
+HRESULT SafeArrayAllocData(SAFEARRAY *array)
+{
+    if (!array) {
+        return E_INVALIDARG;
+    }
+
+    size_t bytes = elementCount(array) * array->cbElements;
+    array->pvData = autocom::ole::allocateZeroed(bytes);
+    return array->pvData ? S_OK : E_OUTOFMEMORY;
+}
+
+
+HRESULT SafeArrayDestroyDescriptor(SAFEARRAY *array)
+{
+    if (!array) {
+        return S_OK;
+    } else if (array->cLocks) {
+        return DISP_E_ARRAYISLOCKED;
+    }
+
+    if (array->fFeatures & FADF_RECORD) {
+        IRecordInfo *info = hiddenRecordInfo(array);
+        if (info) {
+            info->Release();
+        }
+    }
+    autocom::ole::deallocate(prefix(array));
+
+    return S_OK;
+}
+
+
+HRESULT SafeArrayDestroyData(SAFEARRAY *array)
+{
+    if (!array) {
+        return E_INVALIDARG;
+    } else if (array->cLocks) {
+        return DISP_E_ARRAYISLOCKED;
+    }
+
+    clearElements(array, 0, elementCount(array));
+    if (!(array->fFeatures & STATIC_FEATURES)) {
+        autocom::ole::deallocate(array->pvData);
+        array->pvData = nullptr;
+    }
+
+    return S_OK;
+}
+
+
+HRESULT SafeArrayDestroy(SAFEARRAY *array)
+{
+    if (!array) {
+        return S_OK;
+    }
+
+    HRESULT hr = SafeArrayDestroyData(array);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    return SafeArrayDestroyDescriptor(array);
+}
+
+
+HRESULT SafeArrayCopy(SAFEARRAY *array,
+    SAFEARRAY **out)
+{
+    if (!out) {
+        return E_INVALIDARG;
+    }
+    *out = nullptr;
+    if (!array) {
+        return S_OK;
+    }
+
+    SAFEARRAY *copy;
+    HRESULT hr = SafeArrayAllocDescriptor(array->cDims, &copy);
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    std::memcpy(prefix(copy), prefix(array), descriptorSize(array->cDims));
+    copy->fFeatures &= ~STATIC_FEATURES;
+    copy->cLocks = 0;
+    copy->pvData = nullptr;
+    if (copy->fFeatures & FADF_RECORD) {
+        IRecordInfo *info = hiddenRecordInfo(copy);
+        if (info) {
+            info->AddRef();
+        }
+    }
+
+    hr = SafeArrayAllocData(copy);
+    if (SUCCEEDED(hr)) {
+        hr = copyElements(array, copy);
+    }
+    if (FAILED(hr)) {
+        SafeArrayDestroy(copy);
+        return hr;
+    }
+
+    *out = copy;
+    return S_OK;
+}
+
+
+/** \brief Copy data to an array of identical shape.
+ */
+HRESULT SafeArrayCopyData(SAFEARRAY *source,
+    SAFEARRAY *destination)
+{
+    if (!source || !destination) {
+        return E_INVALIDARG;
+    } else if (source->cDims != destination->cDims || source->cbElements != destination->cbElements) {
+        return E_INVALIDARG;
+    }
+    for (USHORT i = 0; i < source->cDims; ++i) {
+        if (source->rgsabound[i].cElements != destination->rgsabound[i].cElements) {
+            return E_INVALIDARG;
+        }
+    }
+
+    return copyElements(source, destination);
+}
+
+
+/** \brief Change the bounds of the rightmost dimension.
+ *
+ *  Elements past the new bound are released, and new elements are
+ *  zeroed.
+ */
+HRESULT SafeArrayRedim(SAFEARRAY *array,
+    SAFEARRAYBOUND *bound)
+{
+    if (!array || !bound) {
+        return E_INVALIDARG;
+    } else if (array->cLocks || (array->fFeatures & FADF_FIXEDSIZE)) {
+        return DISP_E_ARRAYISLOCKED;
+    }
+
+    SAFEARRAYBOUND &last = array->rgsabound[0];
+    size_t inner = 1;
+    for (USHORT i = 1; i < array->cDims; ++i) {
+        inner *= array->rgsabound[i].cElements;
+    }
+    size_t previous = inner * last.cElements;
+    size_t current = inner * bound->cElements;
+
+    if (current != previous) {
+        if (current < previous) {
+            clearElements(array, current, previous);
+        }
+        void *data = autocom::ole::allocateZeroed(current * array->cbElements);
+        if (!data && current) {
+            return E_OUTOFMEMORY;
+        }
+        if (array->pvData) {
+            size_t kept = current < previous ? current : previous;
+            std::memcpy(data, array->pvData, kept * array->cbElements);
+            autocom::ole::deallocate(array->pvData);
+        }
+        array->pvData = data;
+    }
+    last = *bound;
+
+    return S_OK;
+}
+
+
+UINT SafeArrayGetDim(SAFEARRAY *array)
+{
+    return array ? array->cDims : 0;
+}
+
+
+UINT SafeArrayGetElemsize(SAFEARRAY *array)
+{
+    return array ? array->cbElements : 0;
+}
+
+
+/** \brief Get upper bound of a 1-based dimension.
+ */
+HRESULT SafeArrayGetUBound(SAFEARRAY *array,
+    UINT dimension,
+    LONG *bound)
+{
+    if (!array || !bound) {
+        return E_INVALIDARG;
+    } else if (dimension == 0 || dimension > array->cDims) {
+        return DISP_E_BADINDEX;
+    }
+
+    const SAFEARRAYBOUND &item = array->rgsabound[array->cDims - dimension];
+    *bound = item.lLbound + LONG(item.cElements) - 1;
+    return S_OK;
+}
+
+
+/** \brief Get lower bound of a 1-based dimension.
+ */
+HRESULT SafeArrayGetLBound(SAFEARRAY *array,
+    UINT dimension,
+    LONG *bound)
+{
+    if (!array || !bound) {
+        return E_INVALIDARG;
+    } else if (dimension == 0 || dimension > array->cDims) {
+        return DISP_E_BADINDEX;
+    }
+
+    *bound = array->rgsabound[array->cDims - dimension].lLbound;
+    return S_OK;
+}
+
+
+HRESULT SafeArrayLock(SAFEARRAY *array)
+{
+    if (!array) {
+        return E_INVALIDARG;
+    }
+    if (__atomic_add_fetch(&array->cLocks, 1, __ATOMIC_ACQ_REL) > MAXIMUM_LOCKS) {
+        __atomic_sub_fetch(&array->cLocks, 1, __ATOMIC_ACQ_REL);
+        return E_UNEXPECTED;
+    }
+    return S_OK;
+}
+
+
+HRESULT SafeArrayUnlock(SAFEARRAY *array)
+{
+    if (!array) {
+        return E_INVALIDARG;
+    }
+
+    ULONG locks = __atomic_load_n(&array->cLocks, __ATOMIC_ACQUIRE);
+    do {
+        if (locks == 0) {
+            return E_UNEXPECTED;
+        }
+    } while (!__atomic_compare_exchange_n(&array->cLocks, &locks, locks - 1, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    return S_OK;
+}
+
+
+HRESULT SafeArrayAccessData(SAFEARRAY *array,
+    void **data)
+{
+    if (!array || !data) {
+        return E_INVALIDARG;
+    }
+
+    HRESULT hr = SafeArrayLock(array);
+    *data = SUCCEEDED(hr) ? array->pvData : nullptr;
+    return hr;
+}
+
+
+HRESULT SafeArrayUnaccessData(SAFEARRAY *array)
+{
+    return SafeArrayUnlock(array);
+}
+
+
+HRESULT SafeArrayPtrOfIndex(SAFEARRAY *array,
+    LONG *indices,
+    void **data)
+{
+    if (!array || !indices || !data) {
+        return E_INVALIDARG;
+    }
+
+    size_t offset;
+    HRESULT hr = cellOffset(array, indices, offset);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    *data = static_cast<char*>(array->pvData) + offset;
+
+    return S_OK;
+}
+
+
+HRESULT SafeArrayGetElement(SAFEARRAY *array,
+    LONG *indices,
+    void *value)
+{
+    void *cell;
+    HRESULT hr = SafeArrayPtrOfIndex(array, indices, &cell);
+    if (FAILED(hr) || !value) {
+        return FAILED(hr) ? hr : E_INVALIDARG;
+    }
+
+    if (array->fFeatures & FADF_BSTR) {
+        BSTR item = *static_cast<BSTR*>(cell);
+        BSTR copy = nullptr;
+        if (item) {
+            copy = SysAllocStringByteLen(reinterpret_cast<LPCSTR>(item), SysStringByteLen(item));
+            if (!copy) {
+                return E_OUTOFMEMORY;
+            }
+        }
+        *static_cast<BSTR*>(value) = copy;
+    } else if (array->fFeatures & (FADF_UNKNOWN | FADF_DISPATCH)) {
+        IUnknown *item = *static_cast<IUnknown**>(cell);
+        if (item) {
+            item->AddRef();
+        }
+        *static_cast<IUnknown**>(value) = item;
+    } else if (array->fFeatures & FADF_VARIANT) {
+        auto *variant = static_cast<VARIANT*>(value);
+        VariantInit(variant);
+        return VariantCopy(variant, static_cast<VARIANT*>(cell));
+    } else if (array->fFeatures & FADF_RECORD) {
+        IRecordInfo *info = hiddenRecordInfo(array);
+        return info ? info->RecordCopy(cell, value) : E_INVALIDARG;
+    } else {
+        std::memcpy(value, cell, array->cbElements);
+    }
+
+    return S_OK;
+}
+
+
+HRESULT SafeArrayPutElement(SAFEARRAY *array,
+    LONG *indices,
+    void *value)
+{
+    void *cell;
+    HRESULT hr = SafeArrayPtrOfIndex(array, indices, &cell);
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    if (array->fFeatures & FADF_BSTR) {
+        auto item = static_cast<BSTR>(value);
+        BSTR copy = nullptr;
+        if (item) {
+            copy = SysAllocStringByteLen(reinterpret_cast<LPCSTR>(item), SysStringByteLen(item));
+            if (!copy) {
+                return E_OUTOFMEMORY;
+            }
+        }
+        SysFreeString(*static_cast<BSTR*>(cell));
+        *static_cast<BSTR*>(cell) = copy;
+    } else if (array->fFeatures & (FADF_UNKNOWN | FADF_DISPATCH)) {
+        auto *item = static_cast<IUnknown*>(value);
+        auto *&target = *static_cast<IUnknown**>(cell);
+        if (item) {
+            item->AddRef();
+        }
+        if (target) {
+            target->Release();
+        }
+        target = item;
+    } else if (array->fFeatures & FADF_VARIANT) {
+        return VariantCopy(static_cast<VARIANT*>(cell), static_cast<VARIANT*>(value));
+    } else if (array->fFeatures & FADF_RECORD) {
+        IRecordInfo *info = hiddenRecordInfo(array);
+        return info ? info->RecordCopy(value, cell) : E_INVALIDARG;
+    } else if (value) {
+        std::memcpy(cell, value, array->cbElements);
+    } else {
+        return E_INVALIDARG;
+    }
+
+    return S_OK;
+}
+
+
+HRESULT SafeArrayGetVartype(SAFEARRAY *array,
+    VARTYPE *vt)
+{
+    if (!array || !vt) {
+        return E_INVALIDARG;
+    }
+
+    if (array->fFeatures & FADF_RECORD) {
+        *vt = VT_RECORD;
+    } else if ((array->fFeatures & (FADF_HAVEIID | FADF_DISPATCH)) == (FADF_HAVEIID | FADF_DISPATCH)) {
+        *vt = VT_DISPATCH;
+    } else if (array->fFeatures & FADF_HAVEIID) {
+        *vt = VT_UNKNOWN;
+    } else if (array->fFeatures & FADF_HAVEVARTYPE) {
+        *vt = static_cast<VARTYPE>(hiddenVartype(array));
+    } else {
+        return E_INVALIDARG;
+    }
+
+    return S_OK;
+}
+
+
+HRESULT SafeArraySetRecordInfo(SAFEARRAY *array,
+    IRecordInfo *info)
+{
+    if (!array || !(array->fFeatures & FADF_RECORD)) {
+        return E_INVALIDARG;
+    }
+
+    IRecordInfo *&current = hiddenRecordInfo(array);
+    if (info) {
+        info->AddRef();
+    }
+    if (current) {
+        current->Release();
+    }
+    current = info;
+
+    return S_OK;
+}
+
+
+HRESULT SafeArrayGetRecordInfo(SAFEARRAY *array,
+    IRecordInfo **info)
+{
+    if (!array || !info || !(array->fFeatures & FADF_RECORD)) {
+        return E_INVALIDARG;
+    }
+
+    *info = hiddenRecordInfo(array);
+    if (*info) {
+        (*info)->AddRef();
+    }
+
+    return S_OK;
+}
+
+
+HRESULT SafeArraySetIID(SAFEARRAY *array,
+    REFGUID iid)
+{
+    if (!array || !(array->fFeatures & FADF_HAVEIID)) {
+        return E_INVALIDARG;
+    }
+
+    hiddenIid(array) = iid;
+    return S_OK;
+}
+
+
+HRESULT SafeArrayGetIID(SAFEARRAY *array,
+    GUID *iid)
+{
+    if (!array || !iid || !(array->fFeatures & FADF_HAVEIID)) {
+        return E_INVALIDARG;
+    }
+
+    *iid = hiddenIid(array);
+    return S_OK;
+}
@@ -0,0 +1,1062 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Portable VARIANT lifetime and type coercion.
+ *
+ *  Coercion follows oleaut32: integers are range-checked, floating
+ *  point values are rounded half to even, VT_BOOL is -1 or 0, and
+ *  objects are coerced through their value property. Strings and
+ *  dates are locale-independent: dates are formatted as ISO 8601, and
+ *  parsed as either ISO 8601 or `M/D/YYYY`.
+ */
+
+#include <objbase.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <string>
+
+
+namespace
+{
+// CONSTANTS
+// ---------
+
+const int MAXIMUM_SCALE = 28;
+const int CURRENCY_SCALE = 4;
+
+/** Days between the OLE epoch, 1899-12-30, and the Unix epoch.
+ */
+const LONGLONG UNIX_EPOCH_DAYS = 25569;
+const LONGLONG SECONDS_PER_DAY = 86400;
+
+/** OLE dates from 100-01-01 to 9999-12-31.
+ */
+const DOUBLE MINIMUM_DATE = -657434.0;
+const DOUBLE MAXIMUM_DATE = 2958466.0;
+
+// OBJECTS
+// -------
+
+typedef __int128 Int128;
+typedef unsigned __int128 UInt128;
+
+
+/** \brief Numeric value of a variant.
+ *
+ *  Exact values, from integers, currencies, decimals and numeric
+ *  strings, are `mantissa / 10^scale`. Floating-point values and
+ *  dates are `real`.
+ */
+struct Number
+{
+    bool exact = true;
+    Int128 mantissa = 0;
+    int scale = 0;
+    DOUBLE real = 0;
+};
+
+// HELPERS
+// -------
+
+
+UInt128 power10(const int exponent)
+{
+    UInt128 value = 1;
+    for (int i = 0; i < exponent; ++i) {
+        value *= 10;
+    }
+    return value;
+}
+
+
+/** \brief Divide and round half to even.
+ */
+Int128 divideRound(const Int128 value,
+    const UInt128 divisor)
+{
+    bool negative = value < 0;
+    UInt128 magnitude = negative ? UInt128(-value) : UInt128(value);
+    UInt128 quotient = magnitude / divisor;
+    UInt128 remainder = magnitude % divisor;
+    UInt128 twice = remainder * 2;
+    if (twice > divisor || (twice == divisor && (quotient & 1))) {
+        ++quotient;
+    }
+    return negative ? -Int128(quotient) : Int128(quotient);
+}
+
+
+/** \brief Rescale exact value, rounding half to even.
+ *
+ *  \return                     False on overflow.
+ */
+bool rescale(const Number &number,
+    const int scale,
+    Int128 &out)
+{
+    if (number.scale > scale) {
+        out = divideRound(number.mantissa, power10(number.scale - scale));
+        return true;
+    }
+
+    // 10^38 is the largest power of 10 in 128 bits
+    Int128 value = number.mantissa;
+    for (int i = number.scale; i < scale; ++i) {
+        if (value > Int128(UInt128(-1) >> 2) / 10 || value < -(Int128(UInt128(-1) >> 2) / 10)) {
+            return false;
+        }
+        value *= 10;
+    }
+    out = value;
+    return true;
+}
+
+
+DOUBLE toReal(const Number &number)
+{
+    if (!number.exact) {
+        return number.real;
+    }
+    long double value = static_cast<long double>(number.mantissa);
+    return static_cast<DOUBLE>(value / static_cast<long double>(power10(number.scale)));
+}
+
+
+Int128 decimalMantissa(const DECIMAL &decimal)
+{
+    UInt128 magnitude = (UInt128(decimal.Hi32) << 64) | decimal.Lo64;
+    return decimal.sign & DECIMAL_NEG ? -Int128(magnitude) : Int128(magnitude);
+}
+
+
+/** \brief Store exact value as DECIMAL, dropping digits if required.
+ */
+HRESULT toDecimal(Number number,
+    DECIMAL &decimal)
+{
+    const UInt128 limit = UInt128(1) << 96;
+    while (number.scale > MAXIMUM_SCALE) {
+        number.mantissa = divideRound(number.mantissa, 10);
+        --number.scale;
+    }
+    while (number.scale < 0) {
+        if (number.mantissa >= Int128(limit) || number.mantissa <= -Int128(limit)) {
+            return DISP_E_OVERFLOW;
+        }
+        number.mantissa *= 10;
+        ++number.scale;
+    }
+
+    bool negative = number.mantissa < 0;
+    UInt128 magnitude = negative ? UInt128(-number.mantissa) : UInt128(number.mantissa);
+    while (magnitude >= limit && number.scale > 0) {
+        magnitude = UInt128(divideRound(Int128(magnitude), 10));
+        --number.scale;
+    }
+    if (magnitude >= limit) {
+        return DISP_E_OVERFLOW;
+    }
+
+    decimal.wReserved = 0;
+    decimal.scale = static_cast<BYTE>(number.scale);
+    decimal.sign = negative ? DECIMAL_NEG : 0;
+    decimal.Hi32 = static_cast<ULONG>(magnitude >> 64);
+    decimal.Lo64 = static_cast<ULONGLONG>(magnitude);
+    return S_OK;
+}
+
+
+/** \brief Parse a number, keeping it exact when possible.
+ */
+bool parseNumber(const std::wstring &string,
+    Number &number)
+{
+    const wchar_t *first = string.c_str();
+    while (std::iswspace(*first)) {
+        ++first;
+    }
+
+    const wchar_t *p = first;
+    bool negative = false;
+    if (*p == L'+' || *p == L'-') {
+        negative = *p++ == L'-';
+    }
+
+    UInt128 mantissa = 0;
+    int digits = 0;
+    int scale = 0;
+    bool exact = true;
+    bool seen = false;
+    bool point = false;
+    for (; (*p >= L'0' && *p <= L'9') || (*p == L'.' && !point); ++p) {
+        if (*p == L'.') {
+            point = true;
+            continue;
+        }
+        seen = true;
+        if (mantissa == 0 && *p == L'0') {
+            scale += point;
+            continue;
+        }
+        if (digits < 29) {
+            mantissa = mantissa * 10 + UInt128(*p - L'0');
+            scale += point;
+            ++digits;
+        } else {
+            exact = false;
+            scale -= !point;
+        }
+    }
+    if (!seen) {
+        return false;
+    }
+
+    if (*p == L'e' || *p == L'E') {
+        wchar_t *end;
+        long exponent = std::wcstol(p + 1, &end, 10);
+        if (end == p + 1) {
+            return false;
+        }
+        p = end;
+        if (exponent > 1000 || exponent < -1000) {
+            exact = false;
+        } else {
+            scale -= static_cast<int>(exponent);
+        }
+    }
+    while (std::iswspace(*p)) {
+        ++p;
+    }
+    if (*p) {
+        return false;
+    }
+
+    number = Number();
+    if (exact && scale >= -9 && scale <= 2 * MAXIMUM_SCALE) {
+        number.mantissa = negative ? -Int128(mantissa) : Int128(mantissa);
+        number.scale = scale;
+        if (scale < 0) {
+            Int128 value;
+            rescale(number, 0, value);
+            number.mantissa = value;
+            number.scale = 0;
+        }
+    } else {
+        number.exact = false;
+        number.real = std::wcstod(first, nullptr);
+    }
+
+    return true;
+}
+
+
+/** \brief Format exact value, without trailing fractional zeros.
+ */
+std::wstring formatExact(const Number &number)
+{
+    bool negative = number.mantissa < 0;
+    UInt128 magnitude = negative ? UInt128(-number.mantissa) : UInt128(number.mantissa);
+
+    std::wstring digits;
+    do {
+        digits.insert(digits.begin(), wchar_t(L'0' + int(magnitude % 10)));
+        magnitude /= 10;
+    } while (magnitude);
+
+    if (number.scale > 0) {
+        size_t scale = static_cast<size_t>(number.scale);
+        if (digits.size() <= scale) {
+            digits.insert(0, scale - digits.size() + 1, L'0');
+        }
+        digits.insert(digits.size() - scale, 1, L'.');
+        while (digits.back() == L'0') {
+            digits.pop_back();
+        }
+        if (digits.back() == L'.') {
+            digits.pop_back();
+        }
+    }
+    if (negative && digits != L"0") {
+        digits.insert(digits.begin(), L'-');
+    }
+
+    return digits;
+}
+
+
+std::wstring formatReal(const DOUBLE value,
+    const int precision)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*G", precision, value);
+    return std::wstring(buffer, buffer + std::strlen(buffer));
+}
+
+
+/** \brief Convert days since 1970-01-01 to a civil date.
+ */
+void civilFromDays(LONGLONG days,
+    LONGLONG &year,
+    unsigned &month,
+    unsigned &day)
+{
+    days += 719468;
+    LONGLONG era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned doe = static_cast<unsigned>(days - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = LONGLONG(yoe) + era * 400 + (month <= 2);
+}
+
+
+/** \brief Convert a civil date to days since 1970-01-01.
+ */
+LONGLONG daysFromCivil(LONGLONG year,
+    const unsigned month,
+    const unsigned day)
+{
+    year -= month <= 2;
+    LONGLONG era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yoe = static_cast<unsigned>(year - era * 400);
+    unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + LONGLONG(doe) - 719468;
+}
+
+
+/** \brief Format OLE date, where the fraction is the absolute time of day.
+ */
+std::wstring formatDate(const DATE date)
+{
+    DOUBLE whole = std::trunc(date);
+    auto seconds = static_cast<LONGLONG>(std::llround(std::fabs(date - whole) * SECONDS_PER_DAY));
+    auto days = static_cast<LONGLONG>(whole);
+    if (seconds >= SECONDS_PER_DAY) {
+        seconds -= SECONDS_PER_DAY;
+        days += date < 0 ? -1 : 1;
+    }
+
+    LONGLONG year;
+    unsigned month, day;
+    civilFromDays(days - UNIX_EPOCH_DAYS, year, month, day);
+
+    char buffer[64];
+    if (seconds) {
+        snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u %02lld:%02lld:%02lld", year, month, day,
+            seconds / 3600, (seconds / 60) % 60, seconds % 60);
+    } else {
+        snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u", year, month, day);
+    }
+    return std::wstring(buffer, buffer + std::strlen(buffer));
+}
+
+
+/** \brief Parse `YYYY-MM-DD` or `M/D/YYYY`, with an optional time.
+ */
+bool parseDate(const std::wstring &string,
+    DATE &date)
+{
+    std::string narrow;
+    for (wchar_t c: string) {
+        if (c < 0 || c > 0x7F) {
+            return false;
+        }
+        narrow.push_back(static_cast<char>(c));
+    }
+
+    int year, month, day;
+    int hour = 0, minute = 0, second = 0;
+    int used = 0;
+    const char *text = narrow.c_str();
+    while (*text == ' ') {
+        ++text;
+    }
+    if (sscanf(text, "%4d-%2d-%2d%n", &year, &month, &day, &used) == 3) {
+    } else if (sscanf(text, "%2d/%2d/%4d%n", &month, &day, &year, &used) == 3) {
+    } else {
+        return false;
+    }
+
+    text += used;
+    if (*text == 'T' || *text == ' ') {
+        used = 0;
+        int fields = sscanf(text + 1, "%2d:%2d%n:%2d%n", &hour, &minute, &used, &second, &used);
+        if (fields < 2) {
+            return false;
+        }
+        text += 1 + used;
+        while (*text == ' ') {
+            ++text;
+        }
+        if ((text[0] == 'P' || text[0] == 'p') && (text[1] == 'M' || text[1] == 'm') && hour < 12) {
+            hour += 12;
+            text += 2;
+        } else if ((text[0] == 'A' || text[0] == 'a') && (text[1] == 'M' || text[1] == 'm')) {
+            hour = hour == 12 ? 0 : hour;
+            text += 2;
+        }
+    }
+    while (*text == ' ') {
+        ++text;
+    }
+    if (*text || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+
+    LONGLONG days = daysFromCivil(year, month, day) + UNIX_EPOCH_DAYS;
+    DOUBLE time = DOUBLE(hour * 3600 + minute * 60 + second) / SECONDS_PER_DAY;
+    date = days < 0 ? days - time : days + time;
+
+    return true;
+}
+
+
+bool equalInsensitive(const std::wstring &string,
+    const wchar_t *literal)
+{
+    size_t first = string.find_first_not_of(L' ');
+    size_t last = string.find_last_not_of(L' ');
+    if (first == std::wstring::npos) {
+        return false;
+    }
+    size_t length = std::wcslen(literal);
+    if (last - first + 1 != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (std::towlower(string[first + i]) != std::towlower(literal[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/** \brief Get a shallow, non-owning view of the value of a VT_BYREF variant.
+ */
+HRESULT dereference(const VARIANT &source,
+    VARIANT &value)
+{
+    if (!(source.vt & VT_BYREF)) {
+        value = source;
+        return S_OK;
+    }
+
+    VARTYPE vt = source.vt & ~VT_BYREF;
+    if (!source.byref) {
+        return E_INVALIDARG;
+    } else if (vt == VT_VARIANT) {
+        return dereference(*source.pvarVal, value);
+    }
+
+    VariantInit(&value);
+    value.vt = vt;
+    if (vt & VT_ARRAY) {
+        value.parray = *source.pparray;
+        return S_OK;
+    }
+
+    switch (vt) {
+        case VT_I1:
+        case VT_UI1:
+            value.bVal = *source.pbVal;
+            break;
+        case VT_I2:
+        case VT_UI2:
+        case VT_BOOL:
+            value.iVal = *source.piVal;
+            break;
+        case VT_I4:
+        case VT_UI4:
+        case VT_INT:
+        case VT_UINT:
+        case VT_R4:
+        case VT_ERROR:
+            value.lVal = *source.plVal;
+            break;
+        case VT_I8:
+        case VT_UI8:
+        case VT_R8:
+        case VT_CY:
+        case VT_DATE:
+            value.llVal = *source.pllVal;
+            break;
+        case VT_BSTR:
+            value.bstrVal = *source.pbstrVal;
+            break;
+        case VT_UNKNOWN:
+        case VT_DISPATCH:
+            value.punkVal = *source.ppunkVal;
+            break;
+        case VT_DECIMAL:
+            value.decVal = *source.pdecVal;
+            value.vt = VT_DECIMAL;
+            break;
+        default:
+            return DISP_E_BADVARTYPE;
+    }
+
+    return S_OK;
+}
+
+
+/** \brief Get numeric value, or DISP_E_TYPEMISMATCH.
+ */
+HRESULT readNumber(const VARIANT &value,
+    Number &number)
+{
+    number = Number();
+    switch (value.vt) {
+        case VT_EMPTY:
+            break;
+        case VT_I1:
+            number.mantissa = value.cVal;
+            break;
+        case VT_I2:
+            number.mantissa = value.iVal;
+            break;
+        case VT_I4:
+        case VT_INT:
+            number.mantissa = value.lVal;
+            break;
+        case VT_I8:
+            number.mantissa = value.llVal;
+            break;
+        case VT_UI1:
+            number.mantissa = value.bVal;
+            break;
+        case VT_UI2:
+            number.mantissa = value.uiVal;
+            break;
+        case VT_UI4:
+        case VT_UINT:
+            number.mantissa = value.ulVal;
+            break;
+        case VT_UI8:
+            number.mantissa = value.ullVal;
+            break;
+        case VT_BOOL:
+            number.mantissa = value.boolVal ? -1 : 0;
+            break;
+        case VT_CY:
+            number.mantissa = value.cyVal.int64;
+            number.scale = CURRENCY_SCALE;
+            break;
+        case VT_DECIMAL:
+            if (value.decVal.scale > MAXIMUM_SCALE) {
+                return E_INVALIDARG;
+            }
+            number.mantissa = decimalMantissa(value.decVal);
+            number.scale = value.decVal.scale;
+            break;
+        case VT_R4:
+            number.exact = false;
+            number.real = value.fltVal;
+            break;
+        case VT_R8:
+        case VT_DATE:
+            number.exact = false;
+            number.real = value.dblVal;
+            break;
+        case VT_BSTR: {
+            std::wstring string(value.bstrVal ? value.bstrVal : L"", SysStringLen(value.bstrVal));
+            DATE date;
+            if (!parseNumber(string, number)) {
+                if (!parseDate(string, date)) {
+                    return DISP_E_TYPEMISMATCH;
+                }
+                number.exact = false;
+                number.real = date;
+            }
+            break;
+        }
+        default:
+            return DISP_E_TYPEMISMATCH;
+    }
+
+    return S_OK;
+}
+
+
+/** \brief Round to an integer in [minimum, maximum].
+ */
+HRESULT toInteger(const Number &number,
+    const Int128 minimum,
+    const Int128 maximum,
+    Int128 &out)
+{
+    if (number.exact) {
+        rescale(number, 0, out);
+    } else {
+        DOUBLE rounded = std::nearbyint(number.real);
+        if (std::isnan(rounded) || rounded < -9.3e18 || rounded > 1.85e19) {
+            return DISP_E_OVERFLOW;
+        }
+        out = rounded < 0 ? Int128(static_cast<LONGLONG>(rounded)) : Int128(static_cast<ULONGLONG>(rounded));
+    }
+
+    return out < minimum || out > maximum ? DISP_E_OVERFLOW : S_OK;
+}
+
+
+/** \brief Write numeric value to a variant of type `vt`.
+ */
+HRESULT writeNumber(const Number &number,
+    const VARTYPE vt,
+    const USHORT flags,
+    VARIANT &result)
+{
+    Int128 integer;
+    HRESULT hr = S_OK;
+    result.vt = vt;
+
+    switch (vt) {
+        case VT_I1:
+            hr = toInteger(number, INT8_MIN, INT8_MAX, integer);
+            result.cVal = static_cast<CHAR>(integer);
+            break;
+        case VT_I2:
+            hr = toInteger(number, INT16_MIN, INT16_MAX, integer);
+            result.iVal = static_cast<SHORT>(integer);
+            break;
+        case VT_I4:
+        case VT_INT:
+            hr = toInteger(number, INT32_MIN, INT32_MAX, integer);
+            result.lVal = static_cast<LONG>(integer);
+            break;
+        case VT_I8:
+            hr = toInteger(number, INT64_MIN, INT64_MAX, integer);
+            result.llVal = static_cast<LONGLONG>(integer);
+            break;
+        case VT_UI1:
+            hr = toInteger(number, 0, UINT8_MAX, integer);
+            result.bVal = static_cast<BYTE>(integer);
+            break;
+        case VT_UI2:
+            hr = toInteger(number, 0, UINT16_MAX, integer);
+            result.uiVal = static_cast<USHORT>(integer);
+            break;
+        case VT_UI4:
+        case VT_UINT:
+            hr = toInteger(number, 0, UINT32_MAX, integer);
+            result.ulVal = static_cast<ULONG>(integer);
+            break;
+        case VT_UI8:
+            hr = toInteger(number, 0, UINT64_MAX, integer);
+            result.ullVal = static_cast<ULONGLONG>(integer);
+            break;
+        case VT_BOOL:
+            result.boolVal = (number.exact ? number.mantissa != 0 : number.real != 0) ? VARIANT_TRUE : VARIANT_FALSE;
+            break;
+        case VT_R4: {
+            DOUBLE value = toReal(number);
+            if (std::isfinite(value) && std::fabs(value) > FLT_MAX) {
+                hr = DISP_E_OVERFLOW;
+            }
+            result.fltVal = static_cast<FLOAT>(value);
+            break;
+        }
+        case VT_R8:
+            result.dblVal = toReal(number);
+            break;
+        case VT_DATE:
+            result.date = toReal(number);
+            if (!(result.date >= MINIMUM_DATE && result.date < MAXIMUM_DATE)) {
+                hr = DISP_E_OVERFLOW;
+            }
+            break;
+        case VT_CY:
+            if (number.exact) {
+                if (!rescale(number, CURRENCY_SCALE, integer) || integer < INT64_MIN || integer > INT64_MAX) {
+                    hr = DISP_E_OVERFLOW;
+                }
+            } else {
+                Number scaled;
+                scaled.exact = false;
+                scaled.real = number.real * 10000;
+                hr = toInteger(scaled, INT64_MIN, INT64_MAX, integer);
+            }
+            result.cyVal.int64 = static_cast<LONGLONG>(integer);
+            break;
+        case VT_DECIMAL: {
+            Number exact = number;
+            if (!number.exact) {
+                if (!std::isfinite(number.real)) {
+                    return DISP_E_OVERFLOW;
+                }
+                // keep the 15 significant digits of a double
+                std::wstring string = formatReal(number.real, 15);
+                if (!parseNumber(string, exact) || !exact.exact) {
+                    return DISP_E_OVERFLOW;
+                }
+            }
+            DECIMAL decimal;
+            hr = toDecimal(exact, decimal);
+            result.decVal = decimal;
+            result.vt = VT_DECIMAL;
+            break;
+        }
+        case VT_BSTR:
+            return E_UNEXPECTED;
+        default:
+            return DISP_E_BADVARTYPE;
+    }
+
+    (void) flags;
+    if (FAILED(hr)) {
+        VariantInit(&result);
+    }
+    return hr;
+}
+
+
+/** \brief Format a variant as a string.
+ */
+HRESULT writeString(const VARIANT &value,
+    const USHORT flags,
+    VARIANT &result)
+{
+    std::wstring string;
+    Number number;
+
+    switch (value.vt) {
+        case VT_EMPTY:
+            break;
+        case VT_BOOL:
+            if (flags & (VARIANT_ALPHABOOL | VARIANT_LOCALBOOL)) {
+                string = value.boolVal ? L"True" : L"False";
+            } else {
+                string = value.boolVal ? L"-1" : L"0";
+            }
+            break;
+        case VT_R4:
+            string = formatReal(value.fltVal, 7);
+            break;
+        case VT_R8:
+            string = formatReal(value.dblVal, 15);
+            break;
+        case VT_DATE:
+            if (!(value.date >= MINIMUM_DATE && value.date < MAXIMUM_DATE)) {
+                return DISP_E_OVERFLOW;
+            }
+            string = formatDate(value.date);
+            break;
+        default: {
+            HRESULT hr = readNumber(value, number);
+            if (FAILED(hr)) {
+                return hr;
+            }
+            string = formatExact(number);
+            break;
+        }
+    }
+
+    result.vt = VT_BSTR;
+    result.bstrVal = SysAllocStringLen(string.data(), static_cast<UINT>(string.size()));
+    return result.bstrVal ? S_OK : E_OUTOFMEMORY;
+}
+
+
+/** \brief Coerce a VT_BSTR to VT_BOOL, accepting "True" and "False".
+ */
+HRESULT stringToBool(const VARIANT &value,
+    VARIANT &result)
+{
+    std::wstring string(value.bstrVal ? value.bstrVal : L"", SysStringLen(value.bstrVal));
+    result.vt = VT_BOOL;
+    if (equalInsensitive(string, L"true")) {
+        result.boolVal = VARIANT_TRUE;
+        return S_OK;
+    } else if (equalInsensitive(string, L"false")) {
+        result.boolVal = VARIANT_FALSE;
+        return S_OK;
+    }
+
+    Number number;
+    if (!parseNumber(string, number)) {
+        VariantInit(&result);
+        return DISP_E_TYPEMISMATCH;
+    }
+    return writeNumber(number, VT_BOOL, 0, result);
+}
+
+
+/** \brief Fetch the value property of an object.
+ */
+HRESULT valueProperty(IDispatch *dispatch,
+    VARIANT &result)
+{
+    if (!dispatch) {
+        return DISP_E_TYPEMISMATCH;
+    }
+
+    DISPPARAMS params = {nullptr, nullptr, 0, 0};
+    VariantInit(&result);
+    HRESULT hr = dispatch->Invoke(DISPID_VALUE, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_PROPERTYGET, &params, &result, nullptr, nullptr);
+    return FAILED(hr) ? DISP_E_TYPEMISMATCH : S_OK;
+}
+
+
+/** \brief Coerce a dereferenced value, into an empty `result`.
+ */
+HRESULT coerce(const VARIANT &value,
+    const USHORT flags,
+    const VARTYPE vt,
+    VARIANT &result)
+{
+    if (value.vt == vt) {
+        return VariantCopy(&result, &value);
+    }
+
+    switch (vt) {
+        case VT_EMPTY:
+            return S_OK;
+        case VT_NULL:
+            if (value.vt != VT_EMPTY) {
+                return DISP_E_TYPEMISMATCH;
+            }
+            result.vt = VT_NULL;
+            return S_OK;
+        case VT_UNKNOWN:
+        case VT_DISPATCH: {
+            if (value.vt != VT_UNKNOWN && value.vt != VT_DISPATCH) {
+                return DISP_E_TYPEMISMATCH;
+            } else if (!value.punkVal) {
+                result.vt = vt;
+                result.punkVal = nullptr;
+                return S_OK;
+            }
+            IUnknown *object = nullptr;
+            if (FAILED(value.punkVal->QueryInterface(vt == VT_DISPATCH ? IID_IDispatch : IID_IUnknown, (void**) &object))) {
+                return DISP_E_TYPEMISMATCH;
+            }
+            result.vt = vt;
+            result.punkVal = object;
+            return S_OK;
+        }
+        default:
+            break;
+    }
+
+    if ((value.vt & ~VT_TYPEMASK) || (vt & ~VT_TYPEMASK)) {
+        return DISP_E_TYPEMISMATCH;
+    } else if (value.vt == VT_DISPATCH) {
+        if (flags & VARIANT_NOVALUEPROP) {
+            return DISP_E_TYPEMISMATCH;
+        }
+        VARIANT property;
+        HRESULT hr = valueProperty(value.pdispVal, property);
+        if (SUCCEEDED(hr)) {
+            hr = property.vt == VT_DISPATCH ? DISP_E_TYPEMISMATCH : coerce(property, flags, vt, result);
+        }
+        VariantClear(&property);
+        return hr;
+    } else if (vt == VT_BSTR) {
+        return writeString(value, flags, result);
+    } else if (value.vt == VT_BSTR && vt == VT_BOOL) {
+        return stringToBool(value, result);
+    }
+
+    Number number;
+    HRESULT hr = readNumber(value, number);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    return writeNumber(number, vt, flags, result);
+}
+
+}   /* anonymous */
+
+// FUNCTIONS
+// ---------
+
+
+void VariantInit(VARIANTARG *variant)
+{
+    variant->vt = VT_EMPTY;
+    variant->wReserved1 = 0;
+    variant->wReserved2 = 0;
+    variant->wReserved3 = 0;
+}
+
+
+/** \brief Release the value owned by a variant, and set it to VT_EMPTY.
+ */
+HRESULT VariantClear(VARIANTARG *variant)
+{
+    if (!variant) {
+        return E_INVALIDARG;
+    }
+
+    VARTYPE vt = variant->vt;
+    if (!(vt & VT_BYREF)) {
+        if (vt & VT_ARRAY) {
+            HRESULT hr = SafeArrayDestroy(variant->parray);
+            if (FAILED(hr)) {
+                return hr;
+            }
+        } else {
+            switch (vt) {
+                case VT_BSTR:
+                    SysFreeString(variant->bstrVal);
+                    break;
+                case VT_UNKNOWN:
+                case VT_DISPATCH:
+                    if (variant->punkVal) {
+                        variant->punkVal->Release();
+                    }
+                    break;
+                case VT_RECORD:
+                    if (variant->pRecInfo) {
+                        variant->pRecInfo->RecordDestroy(variant->pvRecord);
+                        variant->pRecInfo->Release();
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    VariantInit(variant);
+    return S_OK;
+}
+
+
+/** \brief Free the destination, and copy the source into it.
+ *
+ *  BSTRs, arrays and records are duplicated, interfaces are AddRef'd,
+ *  and VT_BYREF variants copy the reference.
+ */
+HRESULT VariantCopy(VARIANTARG *destination,
+    const VARIANTARG *source)
+{
+    if (!destination || !source) {
+        return E_INVALIDARG;
+    } else if (destination == source) {
+        return S_OK;
+    }
+
+    VARIANT copy = *source;
+    if (!(copy.vt & VT_BYREF)) {
+        if (copy.vt & VT_ARRAY) {
+            HRESULT hr = SafeArrayCopy(source->parray, &copy.parray);
+            if (FAILED(hr)) {
+                return hr;
+            }
+        } else {
+            switch (copy.vt) {
+                case VT_BSTR:
+                    if (source->bstrVal) {
+                        copy.bstrVal = SysAllocStringByteLen(reinterpret_cast<LPCSTR>(source->bstrVal), SysStringByteLen(source->bstrVal));
+                        if (!copy.bstrVal) {
+                            return E_OUTOFMEMORY;
+                        }
+                    }
+                    break;
+                case VT_UNKNOWN:
+                case VT_DISPATCH:
+                    if (copy.punkVal) {
+                        copy.punkVal->AddRef();
+                    }
+                    break;
+                case VT_RECORD:
+                    if (!copy.pRecInfo) {
+                        return E_INVALIDARG;
+                    } else if (FAILED(copy.pRecInfo->RecordCreateCopy(source->pvRecord, &copy.pvRecord))) {
+                        return E_OUTOFMEMORY;
+                    }
+                    copy.pRecInfo->AddRef();
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    VariantClear(destination);
+    *destination = copy;
+    return S_OK;
+}
+
+
+/** \brief Copy the value referenced by a VT_BYREF variant.
+ */
+HRESULT VariantCopyInd(VARIANT *destination,
+    const VARIANTARG *source)
+{
+    if (!destination || !source) {
+        return E_INVALIDARG;
+    }
+
+    VARIANT value;
+    HRESULT hr = dereference(*source, value);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    VARIANT copy;
+    VariantInit(&copy);
+    hr = VariantCopy(&copy, &value);
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    VariantClear(destination);
+    *destination = copy;
+    return S_OK;
+}
+
+
+HRESULT VariantChangeType(VARIANTARG *destination,
+    const VARIANTARG *source,
+    USHORT flags,
+    VARTYPE vt)
+{
+    return VariantChangeTypeEx(destination, source, LOCALE_USER_DEFAULT, flags, vt);
+}
+
+
+/** \brief Coerce a variant to `vt`, which may be in-place.
+ *
+ *  The destination is only modified on success.
+ */
+HRESULT VariantChangeTypeEx(VARIANTARG *destination,
+    const VARIANTARG *source,
+    LCID locale,
+    USHORT flags,
+    VARTYPE vt)
+{
+    (void) locale;
+    if (!destination || !source) {
+        return E_INVALIDARG;
+    } else if (vt & VT_BYREF) {
+        return DISP_E_BADVARTYPE;
+    }
+
+    VARIANT value;
+    HRESULT hr = dereference(*source, value);
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    VARIANT result;
+    VariantInit(&result);
+    hr = coerce(value, flags, vt, result);
+    if (FAILED(hr)) {
+        VariantClear(&result);
+        return hr;
+    }
+
+    VariantClear(destination);
+    *destination = result;
+    return S_OK;
+}
@@ -0,0 +1,816 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Parallel element-wise algorithms over SafeArray data.
+ */
+
+#include <autocom/parallel.h>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#elif defined(AUTOCOM_AVX2)
+#   error "AUTOCOM_AVX2 requires compiling for AVX2."
+#endif
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+namespace parallel
+{
+namespace
+{
+// CONSTANTS
+// ---------
+
+const size_t CACHE_LINE = 64;
+const size_t CHUNKS_PER_THREAD = 4;
+const size_t MINIMUM_CHUNK_BYTES = 16384;
+
+/** Set on pool worker threads, so nested calls run serially rather
+ *  than waiting on a pool they occupy.
+ */
+thread_local bool IN_POOL = false;
+
+}   /* anonymous */
+
+// OBJECTS
+// -------
+
+
+/** \brief Mutex-protected deque of task indexes.
+ *
+ *  Padded by a cache line to avoid false sharing between neighbouring
+ *  queues, without requiring over-aligned allocation.
+ */
+struct WorkQueue
+{
+    std::mutex mutex;
+    std::deque<size_t> items;
+    char padding[CACHE_LINE];
+};
+
+
+/** \brief Start worker threads. The calling thread is counted as a
+ *  worker, so `size - 1` threads are started.
+ */
+ThreadPool::ThreadPool(size_t size)
+{
+    if (size == 0) {
+        size = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    queues.reset(new WorkQueue[size]);
+    threads.reserve(size - 1);
+    for (size_t i = 1; i < size; ++i) {
+        threads.emplace_back(&ThreadPool::worker, this, i);
+    }
+}
+
+
+/** \brief Stop and join worker threads.
+ */
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+
+/** \brief Get number of workers, including the calling thread.
+ */
+size_t ThreadPool::size() const
+{
+    return threads.size() + 1;
+}
+
+
+/** \brief Pop task from own queue, or steal from another.
+ */
+bool ThreadPool::pop(const size_t index,
+    size_t &task)
+{
+    const size_t count = size();
+    {
+        WorkQueue &own = queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.items.empty()) {
+            task = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < count; ++i) {
+        WorkQueue &victim = queues[(index + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty()) {
+            task = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/** \brief Run tasks until every queue is empty.
+ */
+void ThreadPool::work(Job &current,
+    const size_t index)
+{
+    size_t task;
+    while (pop(index, task)) {
+        try {
+            (*current.task)(task);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!current.error) {
+                current.error = std::current_exception();
+            }
+        }
+        if (current.remaining.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+}
+
+
+/** \brief Worker thread loop.
+ */
+void ThreadPool::worker(const size_t index)
+{
+    IN_POOL = true;
+    size_t seen = 0;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] {
+            return stop || (job && generation != seen);
+        });
+        if (stop) {
+            return;
+        }
+
+        seen = generation;
+        Job *current = job;
+        ++active;
+        lock.unlock();
+        work(*current, index);
+        lock.lock();
+        --active;
+        done.notify_all();
+    }
+}
+
+
+/** \brief Run `task(i)` for every `i` in `[0, count)`, blocking until
+ *  all tasks finish. The first exception thrown by a task is rethrown.
+ */
+void ThreadPool::run(const size_t count,
+    const Task &task)
+{
+    if (count == 0) {
+        return;
+    } else if (IN_POOL || threads.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> serial(run_mutex);
+    Job current;
+    current.task = &task;
+    current.remaining = count;
+
+    // contiguous ranges per queue keep neighbouring chunks on one core
+    const size_t workers = size();
+    for (size_t i = 0; i < workers; ++i) {
+        WorkQueue &queue = queues[i];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (size_t j = i * count / workers; j < (i + 1) * count / workers; ++j) {
+            queue.items.push_back(j);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &current;
+        ++generation;
+    }
+    wake.notify_all();
+
+    IN_POOL = true;
+    work(current, 0);
+    IN_POOL = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] {
+        return current.remaining == 0 && active == 0;
+    });
+    job = nullptr;
+    lock.unlock();
+
+    if (current.error) {
+        std::rethrow_exception(current.error);
+    }
+}
+
+
+/** \brief Get process-wide thread pool, sized to the hardware.
+ */
+ThreadPool & ThreadPool::global()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Split elements into cache-line-aligned chunks.
+ */
+std::vector<Chunk> chunks(const void *data,
+    const size_t count,
+    const size_t element,
+    const size_t threads)
+{
+    const size_t line = std::max<size_t>(1, CACHE_LINE / element);
+    const size_t minimum = std::max<size_t>(line, MINIMUM_CHUNK_BYTES / element);
+    size_t grain = std::max(minimum, count / (threads * CHUNKS_PER_THREAD));
+    grain = (grain + line - 1) / line * line;
+
+    if (count <= grain || threads <= 1) {
+        return {Chunk {0, count}};
+    }
+
+    // first chunk ends on a cache-line boundary
+    size_t head = 0;
+    auto address = reinterpret_cast<uintptr_t>(data);
+    if (address % element == 0) {
+        head = ((CACHE_LINE - address % CACHE_LINE) % CACHE_LINE) / element;
+    }
+
+    std::vector<Chunk> list;
+    list.reserve((count - head) / grain + 2);
+    size_t begin = 0;
+    size_t end = head + grain;
+    while (begin < count) {
+        end = std::min(end, count);
+        list.push_back(Chunk {begin, end});
+        begin = end;
+        end += grain;
+    }
+
+    return list;
+}
+
+// KERNELS
+// -------
+
+namespace kernel
+{
+
+#if defined(__AVX2__)
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Horizontal sum of 4 doubles.
+ */
+double hsum(__m256d value)
+{
+    __m128d low = _mm256_castpd256_pd128(value);
+    __m128d high = _mm256_extractf128_pd(value, 1);
+    low = _mm_add_pd(low, high);
+    return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+
+/** \brief Horizontal sum of 4 64-bit integers.
+ */
+int64_t hsum(__m256i value)
+{
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), value);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+
+/** \brief Minimum of vector lanes.
+ */
+template <typename T, size_t N>
+T laneMinimum(const T (&lanes)[N])
+{
+    T value = lanes[0];
+    for (size_t i = 1; i < N; ++i) {
+        if (lanes[i] < value) {
+            value = lanes[i];
+        }
+    }
+    return value;
+}
+
+
+/** \brief Maximum of vector lanes.
+ */
+template <typename T, size_t N>
+T laneMaximum(const T (&lanes)[N])
+{
+    T value = lanes[0];
+    for (size_t i = 1; i < N; ++i) {
+        if (lanes[i] > value) {
+            value = lanes[i];
+        }
+    }
+    return value;
+}
+
+
+/** \brief Merge per-lane argmax results, preferring the first index.
+ *
+ *  Lanes with a negative index never found a candidate.
+ */
+template <typename T, typename I, size_t N>
+size_t laneArgmax(const T (&values)[N],
+    const I (&indexes)[N],
+    const size_t none)
+{
+    size_t best = none;
+    T value = T();
+    for (size_t i = 0; i < N; ++i) {
+        if (indexes[i] < 0) {
+            continue;
+        }
+        const size_t index = static_cast<size_t>(indexes[i]);
+        if (best == none || values[i] > value || (values[i] == value && index < best)) {
+            best = index;
+            value = values[i];
+        }
+    }
+    return best;
+}
+
+}   /* anonymous */
+
+
+/** \brief Sum doubles with four independent vector accumulators.
+ */
+double sum(const double *data,
+    const size_t count)
+{
+    __m256d total[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        total[0] = _mm256_add_pd(total[0], _mm256_loadu_pd(data + i));
+        total[1] = _mm256_add_pd(total[1], _mm256_loadu_pd(data + i + 4));
+        total[2] = _mm256_add_pd(total[2], _mm256_loadu_pd(data + i + 8));
+        total[3] = _mm256_add_pd(total[3], _mm256_loadu_pd(data + i + 12));
+    }
+    double value = hsum(_mm256_add_pd(_mm256_add_pd(total[0], total[1]), _mm256_add_pd(total[2], total[3])));
+    for (; i < count; ++i) {
+        value += data[i];
+    }
+    return value;
+}
+
+
+/** \brief Sum floats, widening to double.
+ */
+double sum(const float *data,
+    const size_t count)
+{
+    __m256d total[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 value = _mm256_loadu_ps(data + i);
+        total[0] = _mm256_add_pd(total[0], _mm256_cvtps_pd(_mm256_castps256_ps128(value)));
+        total[1] = _mm256_add_pd(total[1], _mm256_cvtps_pd(_mm256_extractf128_ps(value, 1)));
+    }
+    double value = hsum(_mm256_add_pd(total[0], total[1]));
+    for (; i < count; ++i) {
+        value += data[i];
+    }
+    return value;
+}
+
+
+/** \brief Sum 32-bit integers, widening to 64-bit.
+ */
+int64_t sum(const int32_t *data,
+    const size_t count)
+{
+    __m256i total[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        total[0] = _mm256_add_epi64(total[0], _mm256_cvtepi32_epi64(_mm256_castsi256_si128(value)));
+        total[1] = _mm256_add_epi64(total[1], _mm256_cvtepi32_epi64(_mm256_extracti128_si256(value, 1)));
+    }
+    int64_t value = hsum(_mm256_add_epi64(total[0], total[1]));
+    for (; i < count; ++i) {
+        value += data[i];
+    }
+    return value;
+}
+
+
+/** \brief Minimum double, ignoring NaN.
+ *
+ *  `_mm256_min_pd` returns the second operand if either is NaN, so
+ *  NaN elements never replace the accumulator. Inputs with no value
+ *  below infinity defer to the scalar kernel for NaN handling.
+ */
+double minimum(const double *data,
+    const size_t count)
+{
+    const double limit = std::numeric_limits<double>::infinity();
+    __m256d best = _mm256_set1_pd(limit);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        best = _mm256_min_pd(_mm256_loadu_pd(data + i), best);
+    }
+
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, best);
+    double value = laneMinimum(lanes);
+    for (; i < count; ++i) {
+        if (data[i] < value) {
+            value = data[i];
+        }
+    }
+    return value == limit ? minimum<double>(data, count) : value;
+}
+
+
+/** \brief Minimum float, ignoring NaN.
+ */
+float minimum(const float *data,
+    const size_t count)
+{
+    const float limit = std::numeric_limits<float>::infinity();
+    __m256 best = _mm256_set1_ps(limit);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        best = _mm256_min_ps(_mm256_loadu_ps(data + i), best);
+    }
+
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, best);
+    float value = laneMinimum(lanes);
+    for (; i < count; ++i) {
+        if (data[i] < value) {
+            value = data[i];
+        }
+    }
+    return value == limit ? minimum<float>(data, count) : value;
+}
+
+
+/** \brief Minimum 32-bit integer.
+ */
+int32_t minimum(const int32_t *data,
+    const size_t count)
+{
+    __m256i best = _mm256_set1_epi32(std::numeric_limits<int32_t>::max());
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        best = _mm256_min_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), best);
+    }
+
+    alignas(32) int32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), best);
+    int32_t value = laneMinimum(lanes);
+    for (; i < count; ++i) {
+        if (data[i] < value) {
+            value = data[i];
+        }
+    }
+    return value;
+}
+
+
+/** \brief Maximum double, ignoring NaN.
+ */
+double maximum(const double *data,
+    const size_t count)
+{
+    const double limit = -std::numeric_limits<double>::infinity();
+    __m256d best = _mm256_set1_pd(limit);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        best = _mm256_max_pd(_mm256_loadu_pd(data + i), best);
+    }
+
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, best);
+    double value = laneMaximum(lanes);
+    for (; i < count; ++i) {
+        if (data[i] > value) {
+            value = data[i];
+        }
+    }
+    return value == limit ? maximum<double>(data, count) : value;
+}
+
+
+/** \brief Maximum float, ignoring NaN.
+ */
+float maximum(const float *data,
+    const size_t count)
+{
+    const float limit = -std::numeric_limits<float>::infinity();
+    __m256 best = _mm256_set1_ps(limit);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        best = _mm256_max_ps(_mm256_loadu_ps(data + i), best);
+    }
+
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, best);
+    float value = laneMaximum(lanes);
+    for (; i < count; ++i) {
+        if (data[i] > value) {
+            value = data[i];
+        }
+    }
+    return value == limit ? maximum<float>(data, count) : value;
+}
+
+
+/** \brief Maximum 32-bit integer.
+ */
+int32_t maximum(const int32_t *data,
+    const size_t count)
+{
+    __m256i best = _mm256_set1_epi32(std::numeric_limits<int32_t>::min());
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        best = _mm256_max_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), best);
+    }
+
+    alignas(32) int32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), best);
+    int32_t value = laneMaximum(lanes);
+    for (; i < count; ++i) {
+        if (data[i] > value) {
+            value = data[i];
+        }
+    }
+    return value;
+}
+
+
+/** \brief Index of first maximum double, ignoring NaN.
+ *
+ *  Each lane tracks its own maximum and index with strict comparisons,
+ *  so lanes keep their first occurrence. Inputs with no value above
+ *  negative infinity defer to the scalar kernel.
+ */
+size_t argmax(const double *data,
+    const size_t count)
+{
+    const double limit = -std::numeric_limits<double>::infinity();
+    __m256d best = _mm256_set1_pd(limit);
+    __m256i index = _mm256_set1_epi64x(-1);
+    __m256i current = _mm256_setr_epi64x(0, 1, 2, 3);
+    const __m256i step = _mm256_set1_epi64x(4);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d value = _mm256_loadu_pd(data + i);
+        __m256d mask = _mm256_cmp_pd(value, best, _CMP_GT_OQ);
+        best = _mm256_blendv_pd(best, value, mask);
+        index = _mm256_blendv_epi8(index, current, _mm256_castpd_si256(mask));
+        current = _mm256_add_epi64(current, step);
+    }
+
+    alignas(32) double values[4];
+    alignas(32) int64_t indexes[4];
+    _mm256_store_pd(values, best);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indexes), index);
+    size_t found = laneArgmax(values, indexes, count);
+    for (; i < count; ++i) {
+        if (data[i] > (found == count ? limit : data[found])) {
+            found = i;
+        }
+    }
+    return found == count ? argmax<double>(data, count) : found;
+}
+
+
+/** \brief Index of first maximum float, ignoring NaN.
+ */
+size_t argmax(const float *data,
+    const size_t count)
+{
+    if (count > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        return argmax<float>(data, count);
+    }
+
+    const float limit = -std::numeric_limits<float>::infinity();
+    __m256 best = _mm256_set1_ps(limit);
+    __m256i index = _mm256_set1_epi32(-1);
+    __m256i current = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 value = _mm256_loadu_ps(data + i);
+        __m256 mask = _mm256_cmp_ps(value, best, _CMP_GT_OQ);
+        best = _mm256_blendv_ps(best, value, mask);
+        index = _mm256_blendv_epi8(index, current, _mm256_castps_si256(mask));
+        current = _mm256_add_epi32(current, step);
+    }
+
+    alignas(32) float values[8];
+    alignas(32) int32_t indexes[8];
+    _mm256_store_ps(values, best);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indexes), index);
+    size_t found = laneArgmax(values, indexes, count);
+    for (; i < count; ++i) {
+        if (data[i] > (found == count ? limit : data[found])) {
+            found = i;
+        }
+    }
+    return found == count ? argmax<float>(data, count) : found;
+}
+
+
+/** \brief Index of first maximum 32-bit integer.
+ */
+size_t argmax(const int32_t *data,
+    const size_t count)
+{
+    if (count > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        return argmax<int32_t>(data, count);
+    }
+
+    const int32_t limit = std::numeric_limits<int32_t>::min();
+    __m256i best = _mm256_set1_epi32(limit);
+    __m256i index = _mm256_set1_epi32(-1);
+    __m256i current = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i mask = _mm256_cmpgt_epi32(value, best);
+        best = _mm256_blendv_epi8(best, value, mask);
+        index = _mm256_blendv_epi8(index, current, mask);
+        current = _mm256_add_epi32(current, step);
+    }
+
+    alignas(32) int32_t values[8];
+    alignas(32) int32_t indexes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(values), best);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indexes), index);
+    size_t found = laneArgmax(values, indexes, count);
+    for (; i < count; ++i) {
+        if (data[i] > (found == count ? limit : data[found])) {
+            found = i;
+        }
+    }
+    return found == count ? argmax<int32_t>(data, count) : found;
+}
+
+
+#else
+
+
+/** \brief Sum doubles.
+ */
+double sum(const double *data,
+    const size_t count)
+{
+    return sum<double>(data, count);
+}
+
+
+/** \brief Sum floats, widening to double.
+ */
+double sum(const float *data,
+    const size_t count)
+{
+    return sum<float>(data, count);
+}
+
+
+/** \brief Sum 32-bit integers, widening to 64-bit.
+ */
+int64_t sum(const int32_t *data,
+    const size_t count)
+{
+    return sum<int32_t>(data, count);
+}
+
+
+/** \brief Minimum double, ignoring NaN.
+ */
+double minimum(const double *data,
+    const size_t count)
+{
+    return minimum<double>(data, count);
+}
+
+
+/** \brief Minimum float, ignoring NaN.
+ */
+float minimum(const float *data,
+    const size_t count)
+{
+    return minimum<float>(data, count);
+}
+
+
+/** \brief Minimum 32-bit integer.
+ */
+int32_t minimum(const int32_t *data,
+    const size_t count)
+{
+    return minimum<int32_t>(data, count);
+}
+
+
+/** \brief Maximum double, ignoring NaN.
+ */
+double maximum(const double *data,
+    const size_t count)
+{
+    return maximum<double>(data, count);
+}
+
+
+/** \brief Maximum float, ignoring NaN.
+ */
+float maximum(const float *data,
+    const size_t count)
+{
+    return maximum<float>(data, count);
+}
+
+
+/** \brief Maximum 32-bit integer.
+ */
+int32_t maximum(const int32_t *data,
+    const size_t count)
+{
+    return maximum<int32_t>(data, count);
+}
+
+
+/** \brief Index of first maximum double, ignoring NaN.
+ */
+size_t argmax(const double *data,
+    const size_t count)
+{
+    return argmax<double>(data, count);
+}
+
+
+/** \brief Index of first maximum float, ignoring NaN.
+ */
+size_t argmax(const float *data,
+    const size_t count)
+{
+    return argmax<float>(data, count);
+}
+
+
+/** \brief Index of first maximum 32-bit integer.
+ */
+size_t argmax(const int32_t *data,
+    const size_t count)
+{
+    return argmax<int32_t>(data, count);
+}
+
+
+#endif
+
+}   /* kernel */
+}   /* parallel */
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
@@ -0,0 +1,390 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Cached ProgID to CLSID resolution.
+ */
+
+#include <autocom/progid.h>
+
+#include <objbase.h>
+
+#include <cstring>
+#include <cwchar>
+#include <limits>
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+// OBJECTS
+// -------
+
+
+/** \brief Cached lookup for a single ProgID.
+ *
+ *  The key and link are immutable once the entry is published. The
+ *  value is only written under the cache mutex, and readers retry
+ *  while `sequence` is odd or changes during the read.
+ */
+struct ProgIdCache::Entry
+{
+    std::wstring progid;
+    size_t hash;
+    Entry *next;
+
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint64_t> low;
+    std::atomic<uint64_t> high;
+    std::atomic<int32_t> hr;
+    std::atomic<int64_t> expires;
+};
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief FNV-1a hash of a wide string.
+ */
+size_t hashProgId(const wchar_t *progid,
+    const size_t length)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<uint64_t>(progid[i]);
+        hash *= 0x100000001B3ULL;
+    }
+    return static_cast<size_t>(hash);
+}
+
+
+/** \brief Get current time in clock ticks.
+ */
+int64_t now()
+{
+    return ProgIdCache::Clock::now().time_since_epoch().count();
+}
+
+
+/** \brief Read consistent value from entry.
+ *
+ *  \return                     False if the entry has expired.
+ */
+template <typename Entry>
+bool readEntry(const Entry &entry,
+    const int64_t time,
+    GUID &clsid,
+    HRESULT &hr)
+{
+    uint32_t before;
+    uint32_t after;
+    uint64_t low;
+    uint64_t high;
+    int32_t code;
+    int64_t expires;
+    do {
+        before = entry.sequence.load(std::memory_order_acquire);
+        low = entry.low.load(std::memory_order_relaxed);
+        high = entry.high.load(std::memory_order_relaxed);
+        code = entry.hr.load(std::memory_order_relaxed);
+        expires = entry.expires.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = entry.sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    if (time >= expires) {
+        return false;
+    }
+    std::memcpy(&clsid, &low, sizeof(low));
+    std::memcpy(reinterpret_cast<char*>(&clsid) + sizeof(low), &high, sizeof(high));
+    hr = static_cast<HRESULT>(code);
+
+    return true;
+}
+
+
+/** \brief Write value to entry. Requires the cache mutex.
+ */
+template <typename Entry>
+void writeEntry(Entry &entry,
+    const GUID &clsid,
+    const HRESULT hr,
+    const int64_t expires)
+{
+    static_assert(sizeof(GUID) == 2 * sizeof(uint64_t), "GUID must be 16 bytes.");
+
+    uint64_t low;
+    uint64_t high;
+    std::memcpy(&low, &clsid, sizeof(low));
+    std::memcpy(&high, reinterpret_cast<const char*>(&clsid) + sizeof(low), sizeof(high));
+
+    const uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.low.store(low, std::memory_order_relaxed);
+    entry.high.store(high, std::memory_order_relaxed);
+    entry.hr.store(static_cast<int32_t>(hr), std::memory_order_relaxed);
+    entry.expires.store(expires, std::memory_order_relaxed);
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+
+/** \brief Mark entry as expired. Requires the cache mutex.
+ */
+template <typename Entry>
+void expireEntry(Entry &entry)
+{
+    const uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.expires.store(std::numeric_limits<int64_t>::min(), std::memory_order_relaxed);
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+}   /* anonymous */
+
+
+/** \brief Resolve ProgID from the registry.
+ */
+HRESULT RegistryResolver::resolve(const std::wstring &progid,
+    GUID &clsid)
+{
+    return CLSIDFromProgID(progid.data(), &clsid);
+}
+
+
+/** \brief Find entry for ProgID, without locking.
+ */
+auto ProgIdCache::find(const wchar_t *progid,
+        const size_t length,
+        const size_t hash) const
+    -> Entry*
+{
+    Entry *entry = buckets[hash % BUCKETS].load(std::memory_order_acquire);
+    for (; entry; entry = entry->next) {
+        if (entry->hash == hash && entry->progid.size() == length && std::wmemcmp(entry->progid.data(), progid, length) == 0) {
+            return entry;
+        }
+    }
+
+    return nullptr;
+}
+
+
+/** \brief Store lookup result, unless the cache changed since lookup.
+ */
+void ProgIdCache::store(const wchar_t *progid,
+    const size_t length,
+    const size_t hash,
+    const GUID &clsid,
+    const HRESULT hr,
+    const int64_t expires,
+    const uint64_t version)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (version != generation) {
+        return;
+    }
+
+    Entry *entry = find(progid, length, hash);
+    if (!entry) {
+        auto &bucket = buckets[hash % BUCKETS];
+        entry = new Entry;
+        entry->progid.assign(progid, length);
+        entry->hash = hash;
+        entry->next = bucket.load(std::memory_order_relaxed);
+        entry->sequence.store(0, std::memory_order_relaxed);
+        writeEntry(*entry, clsid, hr, expires);
+        bucket.store(entry, std::memory_order_release);
+    } else {
+        writeEntry(*entry, clsid, hr, expires);
+    }
+}
+
+
+/** \brief Initialize cache with resolver backend and lifetimes.
+ *
+ *  \param ttl                  Lifetime of successful lookups.
+ *  \param negativeTtl          Lifetime of failed lookups.
+ */
+ProgIdCache::ProgIdCache(std::shared_ptr<ProgIdResolver> resolver,
+        const Duration ttl,
+        const Duration negativeTtl):
+    backend(std::move(resolver)),
+    positive(ttl.count()),
+    negative(negativeTtl.count()),
+    hitCount(0),
+    missCount(0)
+{
+    for (auto &bucket: buckets) {
+        bucket.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+
+/** \brief Destructor.
+ */
+ProgIdCache::~ProgIdCache()
+{
+    for (auto &bucket: buckets) {
+        Entry *entry = bucket.load(std::memory_order_relaxed);
+        while (entry) {
+            Entry *next = entry->next;
+            delete entry;
+            entry = next;
+        }
+    }
+}
+
+
+/** \brief Get cache shared by the process, backed by the registry.
+ */
+ProgIdCache & ProgIdCache::global()
+{
+    static ProgIdCache cache;
+    return cache;
+}
+
+
+/** \brief Resolve ProgID, from the cache if the entry is fresh.
+ *
+ *  Failed lookups are cached as well, and return the same HRESULT
+ *  until they expire.
+ */
+HRESULT ProgIdCache::resolve(const wchar_t *progid,
+    const size_t length,
+    GUID &clsid)
+{
+    const size_t hash = hashProgId(progid, length);
+    const int64_t time = now();
+
+    HRESULT hr;
+    Entry *entry = find(progid, length, hash);
+    if (entry && readEntry(*entry, time, clsid, hr)) {
+        hitCount.fetch_add(1, std::memory_order_relaxed);
+        return hr;
+    }
+    missCount.fetch_add(1, std::memory_order_relaxed);
+
+    // resolve without the lock, since backends may be slow
+    std::shared_ptr<ProgIdResolver> current;
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = backend;
+        version = generation;
+    }
+
+    GUID id = {};
+    hr = current->resolve(std::wstring(progid, length), id);
+    const int64_t lifetime = SUCCEEDED(hr) ? positive.load() : negative.load();
+    store(progid, length, hash, id, hr, time + lifetime, version);
+    clsid = id;
+
+    return hr;
+}
+
+
+/** \brief Resolve ProgID, from the cache if the entry is fresh.
+ */
+HRESULT ProgIdCache::resolve(const std::wstring &progid,
+    GUID &clsid)
+{
+    return resolve(progid.data(), progid.size(), clsid);
+}
+
+
+/** \brief Force the next lookup of ProgID to use the backend.
+ */
+void ProgIdCache::invalidate(const std::wstring &progid)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ++generation;
+    Entry *entry = find(progid.data(), progid.size(), hashProgId(progid.data(), progid.size()));
+    if (entry) {
+        expireEntry(*entry);
+    }
+}
+
+
+/** \brief Force the next lookup of every ProgID to use the backend.
+ *
+ *  Entries are expired rather than freed, since concurrent readers
+ *  may still hold them.
+ */
+void ProgIdCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ++generation;
+    for (auto &bucket: buckets) {
+        for (Entry *entry = bucket.load(std::memory_order_relaxed); entry; entry = entry->next) {
+            expireEntry(*entry);
+        }
+    }
+}
+
+
+/** \brief Set lifetimes of new entries.
+ */
+void ProgIdCache::ttl(const Duration ttl,
+    const Duration negativeTtl)
+{
+    positive.store(ttl.count());
+    negative.store(negativeTtl.count());
+}
+
+
+/** \brief Replace resolver backend, and expire every entry.
+ */
+void ProgIdCache::resolver(std::shared_ptr<ProgIdResolver> resolver)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        backend = std::move(resolver);
+    }
+    clear();
+}
+
+
+/** \brief Get number of cached ProgIDs, including expired entries.
+ */
+size_t ProgIdCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto &bucket: buckets) {
+        for (Entry *entry = bucket.load(std::memory_order_relaxed); entry; entry = entry->next) {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+
+/** \brief Get number of lookups served from the cache.
+ */
+uint64_t ProgIdCache::hits() const
+{
+    return hitCount.load(std::memory_order_relaxed);
+}
+
+
+/** \brief Get number of lookups which used the backend.
+ */
+uint64_t ProgIdCache::misses() const
+{
+    return missCount.load(std::memory_order_relaxed);
+}
+
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
@@ -0,0 +1,259 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief C++ handle around IRecordInfo.
+ */
+
+#include <autocom/bstr.h>
+#include <autocom/record.h>
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+// FUNCTIONS
+// ---------
+
+
+/** \brief Create new handle to IRecordInfo object from ITypeInfo.
+ */
+IRecordInfo * newRecordInfo(ITypeInfo *info)
+{
+    IRecordInfo *ppv = nullptr;
+    if (FAILED(GetRecordInfoFromTypeInfo(info, &ppv))) {
+        throw ComFunctionError("GetRecordInfoFromTypeInfo()");
+    }
+
+    return ppv;
+}
+
+
+/** \brief Create new handle to IRecordInfo object from a VT_RECORD SAFEARRAY.
+ */
+IRecordInfo * newRecordInfo(const SAFEARRAY *array)
+{
+    IRecordInfo *ppv = nullptr;
+    if (FAILED(SafeArrayGetRecordInfo(const_cast<SAFEARRAY*>(array), &ppv))) {
+        throw ComFunctionError("SafeArrayGetRecordInfo()");
+    }
+
+    return ppv;
+}
+
+// OBJECTS
+// -------
+
+
+/** \brief Equality operator, true if both describe the same type.
+ */
+bool operator==(const RecordInfo &left,
+    const RecordInfo &right)
+{
+    if (left.ppv == right.ppv) {
+        return true;
+    } else if (!left.ppv || !right.ppv) {
+        return false;
+    }
+    return left.ppv->IsMatchingType(right.ppv.get()) != FALSE;
+}
+
+
+/** \brief Inequality operator.
+ */
+bool operator!=(const RecordInfo &left,
+    const RecordInfo &right)
+{
+    return !operator==(left, right);
+}
+
+
+/** \brief Initialize class from pointer.
+ */
+RecordInfo::RecordInfo(IRecordInfo *info)
+{
+    open(info);
+}
+
+
+/** \brief Initialize from TypeInfo for a TKIND_RECORD type.
+ */
+RecordInfo::RecordInfo(const TypeInfo &info)
+{
+    open(newRecordInfo(info.ppv.get()));
+}
+
+
+/** \brief Initialize from the record type of a SAFEARRAY.
+ */
+RecordInfo::RecordInfo(const SAFEARRAY *array)
+{
+    open(newRecordInfo(array));
+}
+
+
+/** \brief Open handle to IRecordInfo model.
+ */
+void RecordInfo::open(IRecordInfo *info)
+{
+    ppv.reset(info);
+}
+
+
+/** \brief Check if RecordInfo is valid.
+ */
+RecordInfo::operator bool() const
+{
+    return bool(ppv);
+}
+
+
+/** \brief Get underlying IRecordInfo, without adding a reference.
+ */
+IRecordInfo * RecordInfo::get() const
+{
+    return ppv.get();
+}
+
+
+/** \brief Get size of record in bytes.
+ */
+ULONG RecordInfo::size() const
+{
+    ULONG size;
+    if (FAILED(ppv->GetSize(&size))) {
+        throw ComMethodError("IRecordInfo", "GetSize(...)");
+    }
+
+    return size;
+}
+
+
+/** \brief Get GUID of record type.
+ */
+Guid RecordInfo::guid() const
+{
+    GUID guid;
+    if (FAILED(ppv->GetGuid(&guid))) {
+        throw ComMethodError("IRecordInfo", "GetGuid(...)");
+    }
+
+    return Guid(guid);
+}
+
+
+/** \brief Get name of record type.
+ */
+std::string RecordInfo::name() const
+{
+    Bstr name;
+    if (FAILED(ppv->GetName(&name.data()))) {
+        throw ComMethodError("IRecordInfo", "GetName(...)");
+    }
+
+    return std::string(name);
+}
+
+
+/** \brief Get TypeInfo describing record.
+ */
+TypeInfo RecordInfo::info() const
+{
+    ITypeInfo *info = nullptr;
+    if (FAILED(ppv->GetTypeInfo(&info))) {
+        throw ComMethodError("IRecordInfo", "GetTypeInfo(...)");
+    }
+
+    return TypeInfo(info);
+}
+
+
+/** \brief Get names of record fields, in declaration order.
+ */
+std::vector<std::string> RecordInfo::fields() const
+{
+    ULONG count = 0;
+    if (FAILED(ppv->GetFieldNames(&count, nullptr))) {
+        throw ComMethodError("IRecordInfo", "GetFieldNames(...)");
+    }
+
+    std::vector<BSTR> names(count, nullptr);
+    if (FAILED(ppv->GetFieldNames(&count, names.data()))) {
+        throw ComMethodError("IRecordInfo", "GetFieldNames(...)");
+    }
+
+    std::vector<std::string> fields;
+    fields.reserve(count);
+    for (BSTR &name: names) {
+        fields.emplace_back(std::string(Bstr(std::move(name))));
+    }
+
+    return fields;
+}
+
+
+/** \brief Get byte offset of a record field.
+ */
+ULONG RecordInfo::offset(const std::string &field) const
+{
+    auto typeinfo = info();
+    auto attr = typeinfo.attr();
+    for (WORD index = 0; index < attr.variables(); ++index) {
+        auto vd = typeinfo.vardesc(index);
+        if (vd.kind() == VAR_PERINSTANCE && typeinfo.documentation(vd.id()).name == field) {
+            return vd.offset();
+        }
+    }
+
+    throw std::invalid_argument("Record " + name() + " has no field " + field + ".");
+}
+
+
+/** \brief Get size of record in bytes.
+ */
+ULONG RecordInfo::GetSize() const
+{
+    return size();
+}
+
+
+/** \brief Get GUID of record type.
+ */
+Guid RecordInfo::GetGuid() const
+{
+    return guid();
+}
+
+
+/** \brief Get name of record type.
+ */
+std::string RecordInfo::GetName() const
+{
+    return name();
+}
+
+
+/** \brief Get TypeInfo describing record.
+ */
+TypeInfo RecordInfo::GetTypeInfo() const
+{
+    return info();
+}
+
+
+/** \brief Get names of record fields, in declaration order.
+ */
+std::vector<std::string> RecordInfo::GetFieldNames() const
+{
+    return fields();
+}
+
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
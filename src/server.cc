@@ -0,0 +1,210 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief IDispatch servers implemented by C++ classes.
+ */
+
+#include <autocom/server.h>
+#include <autocom/util/unicode.h>
+
+#include <oleauto.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cwctype>
+#include <stdexcept>
+
+
+namespace autocom
+{
+namespace
+{
+// CONSTANTS
+// ---------
+
+const uint32_t FNV_OFFSET = 2166136261u;
+const uint32_t FNV_PRIME = 16777619u;
+const ULONG MAX_SEEDS = 256;
+
+// HELPERS
+// -------
+
+
+/** \brief Fold character case, with a fast path for ASCII.
+ */
+inline wchar_t foldCase(const wchar_t c)
+{
+    if (c < 0x80) {
+        return (c >= L'A' && c <= L'Z') ? c + (L'a' - L'A') : c;
+    }
+    return static_cast<wchar_t>(std::towlower(c));
+}
+
+
+/** \brief Case-insensitive FNV-1a hash of a name.
+ */
+uint32_t hashName(const wchar_t *name,
+    const ULONG seed)
+{
+    uint32_t hash = FNV_OFFSET ^ seed;
+    for (; *name; ++name) {
+        hash ^= static_cast<uint32_t>(foldCase(*name));
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+
+/** \brief Compare member names, ignoring case.
+ */
+bool equalName(const wchar_t *left,
+    const wchar_t *right)
+{
+    for (; *left && *right; ++left, ++right) {
+        if (foldCase(*left) != foldCase(*right)) {
+            return false;
+        }
+    }
+    return *left == *right;
+}
+
+
+/** \brief Place each name in a distinct slot, or return false.
+ */
+bool placeNames(const std::vector<DispatchMember> &members,
+    const std::vector<LONG> &names,
+    const ULONG seed,
+    std::vector<LONG> &slots)
+{
+    const size_t mask = slots.size() - 1;
+    std::fill(slots.begin(), slots.end(), -1);
+    for (LONG index: names) {
+        LONG &slot = slots[hashName(members[index].name, seed) & mask];
+        if (slot >= 0) {
+            return false;
+        }
+        slot = index;
+    }
+    return true;
+}
+
+}   /* anonymous */
+
+// OBJECTS
+// -------
+
+
+/** \brief Build the name and identifier lookups.
+ *
+ *  Members sharing a name, such as the getter and setter of a
+ *  property, must share an identifier.
+ */
+DispatchIndex::DispatchIndex(std::vector<DispatchMember> &&members):
+    members(std::move(members))
+{
+    // unique names, mapped to the first member with that name
+    std::vector<LONG> names;
+    for (size_t i = 0; i < this->members.size(); ++i) {
+        const DispatchMember &member = this->members[i];
+        auto it = std::find_if(names.begin(), names.end(), [&](LONG index) {
+            return equalName(this->members[index].name, member.name);
+        });
+        if (it == names.end()) {
+            names.push_back(static_cast<LONG>(i));
+        } else if (this->members[*it].id != member.id) {
+            throw std::invalid_argument("Dispatch members with the same name have different identifiers.");
+        }
+    }
+
+    // perfect hash, with at least twice as many slots as names
+    size_t size = 1;
+    while (size < 2 * names.size()) {
+        size <<= 1;
+    }
+    slots.resize(size);
+    while (!placeNames(this->members, names, seed, slots)) {
+        if (++seed == MAX_SEEDS) {
+            seed = 0;
+            slots.resize(slots.size() << 1);
+        }
+    }
+
+    // members sorted by identifier
+    order.resize(this->members.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<LONG>(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [this](LONG left, LONG right) {
+        return this->members[left].id < this->members[right].id;
+    });
+}
+
+
+/** \brief Find first member with name, or -1 if not found.
+ */
+LONG DispatchIndex::find(const wchar_t *name) const
+{
+    if (!name) {
+        return -1;
+    }
+
+    LONG index = slots[hashName(name, seed) & (slots.size() - 1)];
+    if (index >= 0 && equalName(members[index].name, name)) {
+        return index;
+    }
+    return -1;
+}
+
+
+/** \brief Find member by identifier supporting any of the flags.
+ *
+ *  Clients commonly request DISPATCH_METHOD | DISPATCH_PROPERTYGET,
+ *  so the flags match if any of them is supported by the member.
+ */
+LONG DispatchIndex::find(const DISPID id,
+    const WORD flags) const
+{
+    auto it = std::lower_bound(order.begin(), order.end(), id, [this](LONG index, DISPID value) {
+        return members[index].id < value;
+    });
+    for (; it != order.end() && members[*it].id == id; ++it) {
+        if (members[*it].flags & flags) {
+            return *it;
+        }
+    }
+    return -1;
+}
+
+
+const DispatchMember & DispatchIndex::operator[](const size_t index) const
+{
+    return members[index];
+}
+
+
+size_t DispatchIndex::size() const
+{
+    return members.size();
+}
+
+// FUNCTIONS
+// ---------
+
+
+void setExceptionInfo(EXCEPINFO *exception,
+    const wchar_t *source,
+    const char *description)
+{
+    if (!exception) {
+        return;
+    }
+
+    std::wstring wide = utf8ToWide(description);
+    *exception = EXCEPINFO();
+    exception->bstrSource = SysAllocString(source);
+    exception->bstrDescription = SysAllocStringLen(wide.data(), static_cast<UINT>(wide.size()));
+    exception->scode = E_FAIL;
+}
+
+}   /* autocom */
@@ -0,0 +1,686 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Opt-in tracing and latency histograms for IDispatch calls.
+ */
+
+#include <autocom/trace.h>
+#include <autocom/util/unicode.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef _MSC_VER
+#   include <intrin.h>
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+namespace trace
+{
+// CONSTANTS
+// ---------
+
+std::atomic<bool> ENABLED(false);
+
+namespace
+{
+// OBJECTS
+// -------
+
+typedef std::chrono::steady_clock Clock;
+
+
+/** \brief Event slot, published through a sequence lock.
+ *
+ *  `call` packs the DISPID and HRESULT, and `detail` packs the name
+ *  index, flags and argument count.
+ */
+struct Slot
+{
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> start;
+    std::atomic<uint64_t> duration;
+    std::atomic<uint64_t> call;
+    std::atomic<uint64_t> detail;
+};
+
+
+/** \brief Latencies for a member, recorded by a single thread.
+ */
+struct Aggregate
+{
+    DISPID member = 0;
+    uint32_t name = 0;
+    uint64_t failures = 0;
+    Histogram latency;
+};
+
+
+/** \brief Events and histograms recorded by a single thread.
+ *
+ *  Only the owning thread writes slots, so publishing an event takes
+ *  no locks. The histogram mutex is taken for every call, but is only
+ *  contended while aggregating. Rings of exited threads are reused by
+ *  new threads, and `owned` is guarded by the registry mutex.
+ */
+struct Ring
+{
+    uint32_t thread = 0;
+    bool owned = true;
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> floor;
+    std::unique_ptr<Slot[]> slots;
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Aggregate> aggregates;
+
+    Ring():
+        head(0),
+        floor(0),
+        slots(new Slot[RING_SIZE])
+    {
+        for (size_t i = 0; i < RING_SIZE; ++i) {
+            slots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+
+/** \brief Rings and member names shared by every thread.
+ *
+ *  \param retired              Histograms of exited threads.
+ */
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::unordered_map<uint64_t, Aggregate> retired;
+    std::vector<std::string> names;
+    std::unordered_map<std::wstring, uint32_t> indexes;
+    std::atomic<int64_t> epoch;
+
+    Registry():
+        names(1),
+        epoch(0)
+    {}
+};
+
+// HELPERS
+// -------
+
+/** Names interned by the current thread.
+ */
+thread_local std::unordered_map<std::wstring, uint32_t> NAMES;
+
+
+/** \brief Ring owned by the current thread, released on thread exit.
+ */
+struct LocalRing
+{
+    std::shared_ptr<Ring> ring;
+
+    ~LocalRing();
+};
+
+thread_local LocalRing RING;
+
+
+/** \brief Get registry, constructed on first use.
+ */
+Registry & registry()
+{
+    static Registry registry;
+    return registry;
+}
+
+
+/** \brief Add histograms to aggregates keyed by member.
+ */
+void mergeAggregates(std::unordered_map<uint64_t, Aggregate> &merged,
+    const std::unordered_map<uint64_t, Aggregate> &aggregates)
+{
+    for (const auto &item: aggregates) {
+        Aggregate &aggregate = merged[item.first];
+        aggregate.member = item.second.member;
+        aggregate.name = item.second.name;
+        aggregate.failures += item.second.failures;
+        aggregate.latency.merge(item.second.latency);
+    }
+}
+
+
+/** \brief Retire histograms and return ring to the registry.
+ *
+ *  Events stay readable until another thread reuses the ring.
+ */
+LocalRing::~LocalRing()
+{
+    if (!ring) {
+        return;
+    }
+
+    auto &shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    {
+        std::lock_guard<std::mutex> local(ring->mutex);
+        mergeAggregates(shared.retired, ring->aggregates);
+        ring->aggregates.clear();
+    }
+    ring->owned = false;
+}
+
+
+/** \brief Get index of the highest set bit of a non-zero value.
+ */
+size_t highestBit(const uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32))) {
+        return index + 32;
+    }
+    _BitScanReverse(&index, static_cast<unsigned long>(value));
+    return index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+
+/** \brief Get ring for the current thread, registering it on first use.
+ *
+ *  Rings of exited threads are reused before allocating a new one,
+ *  discarding their events, so memory is bounded by the number of
+ *  concurrent threads. Thread indexes are reused along with rings.
+ */
+Ring & localRing()
+{
+    if (!RING.ring) {
+        auto &shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        auto it = std::find_if(shared.rings.begin(), shared.rings.end(), [](const std::shared_ptr<Ring> &ring) {
+            return !ring->owned;
+        });
+        if (it != shared.rings.end()) {
+            RING.ring = *it;
+            RING.ring->owned = true;
+            RING.ring->floor.store(RING.ring->head.load(std::memory_order_relaxed), std::memory_order_release);
+        } else {
+            auto ring = std::make_shared<Ring>();
+            shared.rings.push_back(ring);
+            ring->thread = shared.rings.size();
+            RING.ring = std::move(ring);
+        }
+    }
+
+    return *RING.ring;
+}
+
+
+/** \brief Get index of member name, interning it on first use.
+ */
+uint32_t intern(const wchar_t *name)
+{
+    std::wstring key(name);
+    auto it = NAMES.find(key);
+    if (it != NAMES.end()) {
+        return it->second;
+    }
+
+    auto &shared = registry();
+    uint32_t index;
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        auto global = shared.indexes.find(key);
+        if (global != shared.indexes.end()) {
+            index = global->second;
+        } else {
+            index = shared.names.size();
+            shared.names.emplace_back(wideToUtf8(name));
+            shared.indexes.emplace(key, index);
+        }
+    }
+    NAMES.emplace(std::move(key), index);
+
+    return index;
+}
+
+
+/** \brief Get key of member in histogram maps.
+ */
+uint64_t memberKey(const DISPID member,
+    const uint32_t name)
+{
+    if (name) {
+        return (uint64_t(1) << 32) | name;
+    }
+    return static_cast<uint32_t>(member);
+}
+
+
+/** \brief Publish event to the current thread's ring, and histogram.
+ */
+void record(Ring &ring,
+    const Event &event)
+{
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    Slot &slot = ring.slots[head % RING_SIZE];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.start.store(event.start, std::memory_order_relaxed);
+    slot.duration.store(event.duration, std::memory_order_relaxed);
+    slot.call.store((uint64_t(static_cast<uint32_t>(event.member)) << 32) | static_cast<uint32_t>(event.hr), std::memory_order_relaxed);
+    slot.detail.store((uint64_t(event.name) << 32) | (uint64_t(event.flags) << 16) | event.arguments, std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    ring.head.store(head + 1, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    Aggregate &aggregate = ring.aggregates[memberKey(event.member, event.name)];
+    aggregate.member = event.member;
+    aggregate.name = event.name;
+    aggregate.failures += FAILED(event.hr);
+    aggregate.latency.record(event.duration);
+}
+
+
+/** \brief Read events retained by ring, skipping overwritten slots.
+ */
+void readRing(const Ring &ring,
+    std::vector<Event> &events)
+{
+    const uint64_t head = ring.head.load(std::memory_order_acquire);
+    uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+    first = std::max(first, ring.floor.load(std::memory_order_acquire));
+
+    for (uint64_t i = first; i < head; ++i) {
+        const Slot &slot = ring.slots[i % RING_SIZE];
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        Event event;
+        event.start = slot.start.load(std::memory_order_relaxed);
+        event.duration = slot.duration.load(std::memory_order_relaxed);
+        const uint64_t call = slot.call.load(std::memory_order_relaxed);
+        const uint64_t detail = slot.detail.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+        if ((before & 1) || before != after || ring.head.load(std::memory_order_acquire) > i + RING_SIZE) {
+            continue;
+        }
+
+        event.member = static_cast<DISPID>(call >> 32);
+        event.hr = static_cast<HRESULT>(call & 0xFFFFFFFF);
+        event.name = static_cast<uint32_t>(detail >> 32);
+        event.flags = static_cast<WORD>(detail >> 16);
+        event.arguments = static_cast<WORD>(detail);
+        event.thread = ring.thread;
+        events.push_back(event);
+    }
+}
+
+
+/** \brief Get snapshot of registered rings.
+ */
+std::vector<std::shared_ptr<Ring>> rings()
+{
+    auto &shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    return shared.rings;
+}
+
+
+/** \brief Get label of a member, falling back to its DISPID.
+ */
+std::string label(const DISPID member,
+    const uint32_t index)
+{
+    if (index) {
+        return name(index);
+    }
+    return "DISPID " + std::to_string(member);
+}
+
+
+/** \brief Append string to JSON output, with escapes.
+ */
+void writeJsonString(std::string &output,
+    const std::string &string)
+{
+    output += '"';
+    for (char c: string) {
+        if (c == '"' || c == '\\') {
+            output += '\\';
+            output += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            output += escape;
+        } else {
+            output += c;
+        }
+    }
+    output += '"';
+}
+
+}   /* anonymous */
+
+// OBJECTS
+// -------
+
+
+/** \brief Initialize empty histogram.
+ */
+Histogram::Histogram()
+{
+    counts.fill(0);
+}
+
+
+/** \brief Get bucket index of value.
+ */
+size_t Histogram::bucket(const uint64_t value)
+{
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+
+    const size_t exponent = highestBit(value);
+    const size_t sub = static_cast<size_t>(value >> (exponent - 4)) & (SUB_BUCKETS - 1);
+    return (exponent - 3) * SUB_BUCKETS + sub;
+}
+
+
+/** \brief Get smallest value in bucket.
+ */
+uint64_t Histogram::lower(const size_t bucket)
+{
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+
+    const size_t exponent = bucket / SUB_BUCKETS + 3;
+    const uint64_t sub = bucket % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub) << (exponent - 4);
+}
+
+
+/** \brief Add value to histogram.
+ */
+void Histogram::record(const uint64_t value)
+{
+    ++counts[bucket(value)];
+    ++samples;
+    accumulated += value;
+    low = std::min(low, value);
+    high = std::max(high, value);
+}
+
+
+/** \brief Add values from another histogram.
+ */
+void Histogram::merge(const Histogram &other)
+{
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        counts[i] += other.counts[i];
+    }
+    samples += other.samples;
+    accumulated += other.accumulated;
+    low = std::min(low, other.low);
+    high = std::max(high, other.high);
+}
+
+
+/** \brief Get number of values.
+ */
+uint64_t Histogram::count() const
+{
+    return samples;
+}
+
+
+/** \brief Get sum of values.
+ */
+uint64_t Histogram::sum() const
+{
+    return accumulated;
+}
+
+
+/** \brief Get smallest value, or 0 if empty.
+ */
+uint64_t Histogram::minimum() const
+{
+    return samples ? low : 0;
+}
+
+
+/** \brief Get largest value.
+ */
+uint64_t Histogram::maximum() const
+{
+    return high;
+}
+
+
+/** \brief Get mean of values, or 0 if empty.
+ */
+double Histogram::mean() const
+{
+    return samples ? double(accumulated) / samples : 0;
+}
+
+
+/** \brief Get upper bound of the bucket holding the percentile.
+ *
+ *  \param percent              Percentile, from 0 to 100.
+ */
+uint64_t Histogram::percentile(const double percent) const
+{
+    if (!samples) {
+        return 0;
+    }
+
+    const double clamped = std::min(std::max(percent, 0.0), 100.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100 * samples)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            const uint64_t upper = i + 1 < BUCKETS ? lower(i + 1) - 1 : high;
+            return std::min(std::max(upper, low), high);
+        }
+    }
+
+    return high;
+}
+
+// FUNCTIONS
+// ---------
+
+
+/** \brief Start or stop recording calls.
+ *
+ *  Event start times are relative to the first time tracing is
+ *  enabled.
+ */
+void enable(const bool value)
+{
+    if (value) {
+        int64_t expected = 0;
+        registry().epoch.compare_exchange_strong(expected, Clock::now().time_since_epoch().count());
+    }
+    ENABLED.store(value, std::memory_order_relaxed);
+}
+
+
+/** \brief Discard recorded events and histograms.
+ */
+void clear()
+{
+    auto &shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    for (const auto &ring: shared.rings) {
+        ring->floor.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+        std::lock_guard<std::mutex> local(ring->mutex);
+        ring->aggregates.clear();
+    }
+    shared.retired.clear();
+}
+
+
+/** \brief Call and record IDispatch::Invoke.
+ */
+HRESULT invoke(IDispatch *dispatch,
+    const DISPID member,
+    const wchar_t *name,
+    const WORD flags,
+    DISPPARAMS *params,
+    VARIANT *result,
+    EXCEPINFO *exception,
+    UINT *error)
+{
+    Ring &ring = localRing();
+    Event event;
+    event.member = member;
+    event.name = name ? intern(name) : 0;
+    event.flags = flags;
+    event.arguments = params ? static_cast<WORD>(params->cArgs) : 0;
+    event.thread = ring.thread;
+
+    const auto start = Clock::now();
+    event.hr = dispatch->Invoke(member, IID_NULL, LOCALE_USER_DEFAULT, flags, params, result, exception, error);
+    const auto end = Clock::now();
+
+    const auto epoch = Clock::time_point(Clock::duration(registry().epoch.load(std::memory_order_relaxed)));
+    event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count();
+    event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    record(ring, event);
+
+    return event.hr;
+}
+
+
+/** \brief Get name of member, from the index in an event.
+ */
+std::string name(const uint32_t index)
+{
+    auto &shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    return shared.names.at(index);
+}
+
+
+/** \brief Get events retained by every thread, ordered by start time.
+ */
+std::vector<Event> events()
+{
+    std::vector<Event> list;
+    for (const auto &ring: rings()) {
+        readRing(*ring, list);
+    }
+    std::stable_sort(list.begin(), list.end(), [](const Event &left, const Event &right) {
+        return left.start < right.start;
+    });
+
+    return list;
+}
+
+
+/** \brief Get latency histograms, aggregated over threads, by member.
+ *
+ *  Members are ordered by total time spent in calls, descending.
+ */
+std::vector<MemberStatistics> statistics()
+{
+    // hold the registry, so exiting threads are not counted twice
+    std::unordered_map<uint64_t, Aggregate> merged;
+    {
+        auto &shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (const auto &ring: shared.rings) {
+            std::lock_guard<std::mutex> local(ring->mutex);
+            mergeAggregates(merged, ring->aggregates);
+        }
+        mergeAggregates(merged, shared.retired);
+    }
+
+    std::vector<MemberStatistics> list;
+    list.reserve(merged.size());
+    for (const auto &item: merged) {
+        list.push_back(MemberStatistics {label(item.second.member, item.second.name), item.second.member, item.second.failures, item.second.latency});
+    }
+    std::sort(list.begin(), list.end(), [](const MemberStatistics &left, const MemberStatistics &right) {
+        return left.latency.sum() > right.latency.sum();
+    });
+
+    return list;
+}
+
+
+/** \brief Serialize retained events in the Chrome trace-event format.
+ *
+ *  Each call is a complete ("X") event, with times in microseconds.
+ */
+std::string chromeTrace()
+{
+    auto list = events();
+    std::vector<std::string> labels;
+    {
+        auto &shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        labels = shared.names;
+    }
+
+    std::string output = "{\"traceEvents\":[";
+    char buffer[192];
+    for (size_t i = 0; i < list.size(); ++i) {
+        const Event &event = list[i];
+        if (i) {
+            output += ',';
+        }
+        output += "\n{\"name\":";
+        writeJsonString(output, event.name ? labels.at(event.name) : label(event.member, 0));
+        snprintf(buffer, sizeof(buffer),
+            ",\"cat\":\"com\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,"
+            "\"args\":{\"dispid\":%ld,\"flags\":%u,\"arguments\":%u,\"hr\":\"0x%08X\"}}",
+            event.start / 1000.0, event.duration / 1000.0, event.thread,
+            static_cast<long>(event.member), event.flags, event.arguments, static_cast<unsigned>(event.hr));
+        output += buffer;
+    }
+    output += "\n]}\n";
+
+    return output;
+}
+
+
+/** \brief Write retained events to a Chrome trace-event JSON file.
+ */
+void writeChromeTrace(const std::string &path)
+{
+    std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw std::runtime_error("Unable to write trace file: " + path);
+    }
+    stream << chromeTrace();
+}
+
+}   /* trace */
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
@@ -13,6 +13,14 @@
 
 namespace autocom
 {
+// CONSTANTS
+// ---------
+
+/** Upper bound on the names of a member: its own name and one per
+ *  parameter.
+ */
+const UINT MAX_MEMBER_NAMES = 256;
+
 // FUNCTIONS
 // ---------
 
@@ -269,6 +277,29 @@ DllEntry TypeInfo::entry(const MEMBERID id,
 }
 
 
+/** \brief Get name of member, followed by the names of its parameters.
+ *
+ *  The value parameter of property put functions has no name, so
+ *  fewer names than parameters may be returned.
+ */
+std::vector<std::string> TypeInfo::names(const MEMBERID id) const
+{
+    BSTR array[MAX_MEMBER_NAMES];
+    UINT count = 0;
+    if (FAILED(ppv->GetNames(id, array, MAX_MEMBER_NAMES, &count))) {
+        throw ComMethodError("ITypeInfo", "GetNames()");
+    }
+
+    std::vector<std::string> list;
+    list.reserve(count);
+    for (UINT index = 0; index < count; ++index) {
+        list.emplace_back(std::string(Bstr(std::move(array[index]))));
+    }
+
+    return list;
+}
+
+
 /** \brief Get documentation from TypeInfo.
  */
 Documentation TypeInfo::GetDocumentation(const MEMBERID id) const
@@ -277,6 +308,14 @@ Documentation TypeInfo::GetDocumentation(const MEMBERID id) const
 }
 
 
+/** \brief Get name of member and names of its parameters.
+ */
+std::vector<std::string> TypeInfo::GetNames(const MEMBERID id) const
+{
+    return names(id);
+}
+
+
 /** \brief Get type info from reference to other type.
  */
 TypeInfo TypeInfo::GetRefTypeInfo(const HREFTYPE type) const
@@ -850,6 +889,15 @@ VARKIND VarDesc::kind() const
 }
 
 
+/** \brief Byte offset of variable in instance (only if kind() is VAR_PERINSTANCE).
+ */
+ULONG VarDesc::offset() const
+{
+    assert(kind() == VAR_PERINSTANCE);
+    return desc->oInst;
+}
+
+
 /** \brief Variable member ID.
  */
 MEMBERID VarDesc::memid() const
@@ -890,6 +938,14 @@ VARKIND VarDesc::varkind() const
 }
 
 
+/** \brief Byte offset of variable in instance (only if kind() is VAR_PERINSTANCE).
+ */
+ULONG VarDesc::oInst() const
+{
+    return offset();
+}
+
+
 /** \brief Open FUNCDESC from ITypeInfo.
  */
 FuncDesc::FuncDesc(const ITypeInfoPtr &info,
@@ -1286,6 +1342,14 @@ ParamDesc ElemDesc::param() const
 }
 
 
+/** \brief Get IDL parameter flags, such as PARAMFLAG_FRETVAL.
+ */
+USHORT ElemDesc::flags() const
+{
+    return desc.paramdesc.wParamFlags;
+}
+
+
 /** \brief Get type description.
  */
 TypeDesc ElemDesc::tdesc() const
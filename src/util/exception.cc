@@ -7,6 +7,8 @@
 
 #include <autocom/util/exception.h>
 
+#include <cstdio>
+
 
 namespace autocom
 {
@@ -38,4 +40,23 @@ ComTypeError::ComTypeError(const std::string &expected,
 {}
 
 
+/** \brief Construct exception with message.
+ */
+ComResultError::ComResultError(const HRESULT hr):
+    hr(hr)
+{
+    char code[16];
+    snprintf(code, sizeof(code), "0x%08X", static_cast<unsigned int>(hr));
+    message = std::string("AutoCOM: COM call failed with HRESULT ") + code + ".";
+}
+
+
+/** \brief Get failed HRESULT.
+ */
+HRESULT ComResultError::code() const
+{
+    return hr;
+}
+
+
 }   /* autocom */
@@ -67,8 +67,10 @@ AUTOCOM_SPECIALIZER(CHAR);
 AUTOCOM_SPECIALIZER(UCHAR);
 AUTOCOM_SPECIALIZER(SHORT);
 AUTOCOM_SPECIALIZER(USHORT);
+#if !defined(AUTOCOM_LONG_IS_INT)
 AUTOCOM_SPECIALIZER(INT);
 AUTOCOM_SPECIALIZER(UINT);
+#endif          // AUTOCOM_LONG_IS_INT
 AUTOCOM_SPECIALIZER(LONG);
 AUTOCOM_SPECIALIZER(ULONG);
 AUTOCOM_SPECIALIZER(LONGLONG);
@@ -0,0 +1,51 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Conversions between UTF-8 and wide strings.
+ */
+
+#include <autocom/util/unicode.h>
+#include <pycpp/string/codec.h>
+
+#include <cwchar>
+
+
+namespace autocom
+{
+// FUNCTIONS
+// ---------
+
+
+std::wstring utf8ToWide(const std::string &string)
+{
+#if defined(_WIN32)
+    auto wide = codec_utf8_utf16(string);
+#else
+    auto wide = codec_utf8_utf32(string);
+#endif
+    static_assert(sizeof(wide[0]) == sizeof(wchar_t), "Codec must match wchar_t.");
+
+    return std::wstring(reinterpret_cast<const wchar_t*>(wide.data()), wide.size());
+}
+
+
+std::string wideToUtf8(const wchar_t *string,
+    const size_t length)
+{
+#if defined(_WIN32)
+    auto *data = reinterpret_cast<const char16_t*>(string);
+    return codec_utf16_utf8(std::u16string(data, length));
+#else
+    auto *data = reinterpret_cast<const char32_t*>(string);
+    return codec_utf32_utf8(std::u32string(data, length));
+#endif
+}
+
+
+std::string wideToUtf8(const wchar_t *string)
+{
+    return wideToUtf8(string, wcslen(string));
+}
+
+}   /* autocom */
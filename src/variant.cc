@@ -7,7 +7,7 @@
 
 #include <autocom/safearray.h>
 #include <autocom/variant.h>
-#include <pycpp/string/codec.h>
+#include <autocom/util/unicode.h>
 
 #ifdef _MSC_VER
 #   pragma warning(push)
@@ -186,9 +186,8 @@ void set(VARIANT &variant,
 void set(VARIANT &variant, const char *value)
 {
     variant.vt = VT_BSTR;
-    auto u16 = codec_utf8_utf16(value);
-    auto* data = reinterpret_cast<const wchar_t*>(u16.data());
-    variant.bstrVal = SysAllocStringLen(data, u16.size());
+    auto wide = utf8ToWide(value);
+    variant.bstrVal = accounting::sysAllocStringLen(wide.data(), wide.size(), "set(VARIANT &, const char *)");
 }
 
 /** \brief Overload from character literals.
@@ -197,7 +196,7 @@ void set(VARIANT &variant,
     const wchar_t *value)
 {
     variant.vt = VT_BSTR;
-    variant.bstrVal = SysAllocStringLen(value, wcslen(value));
+    variant.bstrVal = accounting::sysAllocStringLen(value, wcslen(value), "set(VARIANT &, const wchar_t *)");
 }
 
 
@@ -387,8 +386,10 @@ AUTOCOM_PRIMITIVE_SETTER(CHAR, cVal)
 AUTOCOM_PRIMITIVE_SETTER(UCHAR, bVal)
 AUTOCOM_PRIMITIVE_SETTER(SHORT, iVal)
 AUTOCOM_PRIMITIVE_SETTER(USHORT, uiVal)
+#if !defined(AUTOCOM_LONG_IS_INT)
 AUTOCOM_PRIMITIVE_SETTER(INT, intVal)
 AUTOCOM_PRIMITIVE_SETTER(UINT, uintVal)
+#endif          // AUTOCOM_LONG_IS_INT
 AUTOCOM_PRIMITIVE_SETTER(LONG, lVal)
 AUTOCOM_PRIMITIVE_SETTER(ULONG, ulVal)
 AUTOCOM_PRIMITIVE_SETTER(LONGLONG, llVal)
@@ -722,8 +723,10 @@ AUTOCOM_GETTER(CHAR, cVal)
 AUTOCOM_GETTER(UCHAR, bVal)
 AUTOCOM_GETTER(SHORT, iVal)
 AUTOCOM_GETTER(USHORT, uiVal)
+#if !defined(AUTOCOM_LONG_IS_INT)
 AUTOCOM_GETTER(INT, intVal)
 AUTOCOM_GETTER(UINT, uintVal)
+#endif          // AUTOCOM_LONG_IS_INT
 AUTOCOM_GETTER(LONG, lVal)
 AUTOCOM_GETTER(ULONG, ulVal)
 AUTOCOM_GETTER(FLOAT, fltVal)
@@ -793,7 +796,8 @@ Variant::~Variant()
  */
 Variant::Variant(const Variant &other)
 {
-    VariantCopy(this, const_cast<Variant*>(&other));
+    VariantInit(this);
+    accounting::variantCopy(this, &other, "Variant(const Variant &)");
 }
 
 
@@ -801,7 +805,7 @@ Variant::Variant(const Variant &other)
  */
 Variant & Variant::operator=(const Variant &other)
 {
-    VariantCopy(this, const_cast<Variant*>(&other));
+    accounting::variantCopy(this, &other, "Variant::operator=(const Variant &)");
     return *this;
 }
 
@@ -837,7 +841,7 @@ void Variant::init()
  */
 void Variant::clear()
 {
-    VariantClear(this);
+    accounting::variantClear(this, "Variant::clear()");
 }
 
 
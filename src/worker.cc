@@ -0,0 +1,225 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoCOM
+ *  \brief Single-threaded apartment worker threads.
+ */
+
+#include <autocom/util/exception.h>
+#include <autocom/worker.h>
+
+#include <windows.h>
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#   pragma warning(push)
+#   pragma warning(disable:4267)
+#endif          // MSVC
+
+
+namespace autocom
+{
+namespace
+{
+// CONSTANTS
+// ---------
+
+/** Thread message which wakes a worker to run queued tasks.
+ */
+const UINT WM_AUTOCOM_TASK = WM_APP + 0x41;
+
+}   /* anonymous */
+
+// OBJECTS
+// -------
+
+
+/** \brief Initialize the apartment, then pump messages until stopped.
+ */
+void StaWorker::run(std::promise<DWORD> ready,
+    const ApartmentConfig config)
+{
+    try {
+        configureApartment(config);
+        initialize();
+    } catch (...) {
+        ready.set_exception(std::current_exception());
+        return;
+    }
+
+    // create the message queue before other threads post to it
+    MSG message;
+    PeekMessage(&message, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    ready.set_value(GetCurrentThreadId());
+
+    while (GetMessage(&message, nullptr, 0, 0) > 0) {
+        if (message.hwnd == nullptr && message.message == WM_AUTOCOM_TASK) {
+            drain();
+        } else {
+            TranslateMessage(&message);
+            DispatchMessage(&message);
+        }
+    }
+
+    drain();
+    uninitialize();
+}
+
+
+/** \brief Run queued tasks until the queue is empty.
+ */
+void StaWorker::drain()
+{
+    while (true) {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+
+/** \brief Queue task, and wake the worker if it may be idle.
+ *
+ *  A wake message is only posted when the queue was empty, since
+ *  the worker drains every queued task once woken.
+ */
+void StaWorker::post(Task &&task)
+{
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopped) {
+            throw std::runtime_error("STA worker is stopped.");
+        }
+        wake = tasks.empty();
+        tasks.emplace_back(std::move(task));
+    }
+
+    if (wake && !PostThreadMessage(id, WM_AUTOCOM_TASK, 0, 0)) {
+        throw ComFunctionError("PostThreadMessage()");
+    }
+}
+
+
+/** \brief Start worker thread in a new STA.
+ *
+ *  \param flags                Additional COINIT flags.
+ */
+StaWorker::StaWorker(const DWORD flags)
+{
+    ApartmentConfig config;
+    config.model = APARTMENT_STA;
+    config.flags = flags;
+
+    std::promise<DWORD> ready;
+    auto future = ready.get_future();
+    thread = std::thread(&StaWorker::run, this, std::move(ready), config);
+    try {
+        id = future.get();
+    } catch (...) {
+        thread.join();
+        throw;
+    }
+}
+
+
+/** \brief Stop and join worker thread.
+ */
+StaWorker::~StaWorker()
+{
+    stop();
+}
+
+
+/** \brief Run queued tasks, then stop and join the worker thread.
+ *
+ *  Cannot be called from the worker itself.
+ */
+void StaWorker::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopped) {
+            return;
+        }
+        stopped = true;
+    }
+
+    if (current()) {
+        throw std::runtime_error("Cannot stop STA worker from its own thread.");
+    }
+    PostThreadMessage(id, WM_QUIT, 0, 0);
+    thread.join();
+}
+
+
+/** \brief Check if the calling thread is the worker.
+ */
+bool StaWorker::current() const
+{
+    return std::this_thread::get_id() == thread.get_id();
+}
+
+
+/** \brief Get number of queued tasks.
+ */
+size_t StaWorker::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size();
+}
+
+
+/** \brief Start workers, one per hardware thread by default.
+ */
+StaPool::StaPool(size_t size,
+        const DWORD flags):
+    next(0)
+{
+    if (size == 0) {
+        size = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        workers.emplace_back(new StaWorker(flags));
+    }
+}
+
+
+/** \brief Get number of workers.
+ */
+size_t StaPool::size() const
+{
+    return workers.size();
+}
+
+
+/** \brief Get worker by index.
+ */
+StaWorker & StaPool::worker(const size_t index)
+{
+    return *workers.at(index);
+}
+
+
+/** \brief Get worker for a new object, in round-robin order.
+ */
+StaWorker & StaPool::route()
+{
+    return *workers[next.fetch_add(1, std::memory_order_relaxed) % workers.size()];
+}
+
+}   /* autocom */
+
+#ifdef _MSC_VER
+#   pragma warning(pop)
+#endif          // MSVC
@@ -0,0 +1,275 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Type library description cache test suite.
+ */
+
+#include <cache.h>
+#include <write.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+namespace com = autocom;
+
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Type library attributes for a fixed library.
+ */
+struct FakeAttr
+{
+    com::Guid guid() const
+    {
+        GUID id = {0x12345678, 0x1234, 0x5678, {1, 2, 3, 4, 5, 6, 7, 8}};
+        return com::Guid(id);
+    }
+
+    WORD major() const
+    {
+        return 2;
+    }
+
+    WORD minor() const
+    {
+        return 1;
+    }
+
+    LCID lcid() const
+    {
+        return 0x409;
+    }
+};
+
+
+/** \brief Write file with contents.
+ */
+void writeFile(const std::string &path,
+    const std::string &contents)
+{
+    std::ofstream stream(path, std::ios::binary);
+    stream << contents;
+}
+
+
+/** \brief Create small description covering each item type.
+ */
+com::TypeLibDescription createDescription()
+{
+    com::TypeLibDescription tlib;
+    tlib.guid = FakeAttr().guid();
+    tlib.major = 2;
+    tlib.minor = 1;
+    tlib.documentation.name = "Shapes";
+    tlib.documentation.doc = "Shape library";
+    tlib.documentation.help = 7;
+
+    auto &description = tlib.description;
+    com::detail::Enum color;
+    color.name = "Color";
+    color.values.resize(2);
+    color.values[0].name = "Red";
+    color.values[0].value = "0";
+    color.values[1].name = "Green";
+    color.values[1].value = "1";
+    description.enums.emplace_back(color);
+
+    com::detail::Record point;
+    point.name = "Point";
+    point.size = 8;
+    point.fields.emplace_back("SHORT", "[4]", "x");
+    point.offsets.emplace_back(0);
+    description.records.emplace_back(point);
+
+    com::detail::Function move;
+    move.decorator = "virtual";
+    move.returns = com::detail::Parameter("HRESULT");
+    move.name = "Move";
+    move.doc = "Move shape.";
+    move.id = 0x60020000;
+    move.offset = 28;
+    move.args.emplace_back("LONG", "", "x");
+    move.args.emplace_back("SAFEARRAY**", "", "y");
+    move.args.back().flags = PARAMFLAG_FOUT;
+    move.args.back().element = "DOUBLE";
+
+    com::detail::Interface shape;
+    shape.name = "IShape";
+    shape.iid = tlib.guid;
+    shape.flags = 0x1040;
+    shape.base = "IDispatch";
+    shape.object = "IDispatch";
+    shape.functions.emplace_back(move);
+    description.interfaces.emplace_back(shape);
+
+    com::detail::CoClass coclass;
+    coclass.name = "Shape";
+    coclass.clsid = tlib.guid;
+    coclass.flags = 2;
+    coclass.interfaces.emplace_back("IShape");
+    coclass.added.emplace("IShape");
+    description.coclasses.emplace_back(coclass);
+
+    com::detail::Alias alias;
+    alias.parameter = com::detail::Parameter("Point");
+    alias.name = "Coord";
+    description.aliases.emplace_back(alias);
+    description.bases.emplace("IShape", "IDispatch");
+
+    return tlib;
+}
+
+
+/** \brief Create key for a fixed type library file.
+ */
+com::DescriptionKey createKey(const std::string &path,
+    const std::string &contents)
+{
+    writeFile(path, contents);
+    com::DescriptionKey key(FakeAttr(), path);
+    std::remove(path.data());
+
+    return key;
+}
+
+}   /* anonymous */
+
+// TESTS
+// -----
+
+
+TEST(DescriptionCache, Key)
+{
+    auto key = createKey("cache_key.tlb", "MSFT");
+    EXPECT_EQ(key.major, 2);
+    EXPECT_EQ(key.lcid, 0x409);
+    EXPECT_EQ(key.size, 4);
+    EXPECT_EQ(key.filename(), "autocom-" + FakeAttr().guid().uuid() + "-2.1-0409.cache");
+
+    EXPECT_TRUE(key == createKey("cache_key.tlb", "MSFT"));
+    EXPECT_TRUE(key != createKey("cache_key.tlb", "MSFt"));
+
+    // the generator build is part of the key
+    EXPECT_NE(key.generator, 0);
+    EXPECT_EQ(key.generator, com::generatorBuildId());
+    auto other = key;
+    other.generator ^= 1;
+    EXPECT_TRUE(key != other);
+}
+
+
+TEST(DescriptionCache, Imports)
+{
+    const std::string path = "cache_imports.tlb";
+    const std::string import = "cache_imported.tlb";
+    writeFile(path, "MSFT");
+    writeFile(import, "MSFT");
+    com::DescriptionKey key(FakeAttr(), path, {import});
+    EXPECT_EQ(key.imports, com::hashFiles({import}));
+    EXPECT_NE(key.imports, com::DescriptionKey(FakeAttr(), path).imports);
+
+    // changing an imported library invalidates the cache
+    writeFile(import, "MSFt");
+    EXPECT_TRUE(key != com::DescriptionKey(FakeAttr(), path, {import}));
+    writeFile(import, "MSFT");
+    EXPECT_TRUE(key == com::DescriptionKey(FakeAttr(), path, {import}));
+
+    std::remove(import.data());
+    std::remove(path.data());
+}
+
+
+TEST(DescriptionCache, RoundTrip)
+{
+    auto key = createKey("cache_round.tlb", "MSFT");
+    auto tlib = createDescription();
+    auto data = com::serializeDescription(key, tlib);
+
+    com::TypeLibDescription copy;
+    ASSERT_TRUE(com::deserializeDescription(data.data(), data.size(), key, copy));
+    EXPECT_TRUE(copy.guid == tlib.guid);
+    EXPECT_EQ(copy.major, 2);
+    EXPECT_EQ(copy.minor, 1);
+    EXPECT_EQ(copy.documentation.name, "Shapes");
+    EXPECT_EQ(copy.documentation.doc, "Shape library");
+    EXPECT_EQ(copy.documentation.help, 7);
+
+    auto &description = copy.description;
+    ASSERT_EQ(description.enums.size(), 1);
+    EXPECT_EQ(description.enums[0].header(), tlib.description.enums[0].header());
+    ASSERT_EQ(description.records.size(), 1);
+    EXPECT_EQ(description.records[0].header(), tlib.description.records[0].header());
+    EXPECT_EQ(description.records[0].offsets, tlib.description.records[0].offsets);
+    ASSERT_EQ(description.interfaces.size(), 1);
+    EXPECT_EQ(description.interfaces[0].header(), tlib.description.interfaces[0].header());
+    EXPECT_EQ(description.interfaces[0].functions[0].id, 0x60020000);
+    EXPECT_EQ(description.interfaces[0].functions[0].offset, 28);
+    EXPECT_EQ(description.interfaces[0].functions[0].args[1].flags, PARAMFLAG_FOUT);
+    EXPECT_EQ(description.interfaces[0].functions[0].args[1].element, "DOUBLE");
+    ASSERT_EQ(description.coclasses.size(), 1);
+    EXPECT_EQ(description.coclasses[0].header(), tlib.description.coclasses[0].header());
+    EXPECT_EQ(description.coclasses[0].added.count("IShape"), 1);
+    ASSERT_EQ(description.aliases.size(), 1);
+    EXPECT_EQ(description.aliases[0].header(), tlib.description.aliases[0].header());
+    EXPECT_EQ(description.bases.at("IShape"), "IDispatch");
+
+    // serialization is deterministic
+    EXPECT_EQ(com::serializeDescription(key, copy), data);
+}
+
+
+TEST(DescriptionCache, Stale)
+{
+    auto key = createKey("cache_stale.tlb", "MSFT");
+    auto other = createKey("cache_stale.tlb", "MSFT-changed");
+    auto data = com::serializeDescription(key, createDescription());
+
+    com::TypeLibDescription copy;
+    EXPECT_TRUE(!com::deserializeDescription(data.data(), data.size(), other, copy));
+
+    // different format version
+    data[8] ^= 0xFF;
+    EXPECT_TRUE(!com::deserializeDescription(data.data(), data.size(), key, copy));
+
+    // truncated data
+    data[8] ^= 0xFF;
+    EXPECT_THROW(com::deserializeDescription(data.data(), data.size() - 1, key, copy), std::runtime_error);
+}
+
+
+TEST(DescriptionCache, File)
+{
+    const std::string path = "cache_description.cache";
+    auto key = createKey("cache_file.tlb", "MSFT");
+    auto tlib = createDescription();
+
+    com::TypeLibDescription copy;
+    EXPECT_TRUE(!com::readDescriptionCache(path, key, copy));
+    com::writeDescriptionCache(path, key, tlib);
+    EXPECT_TRUE(com::readDescriptionCache(path, key, copy));
+    EXPECT_EQ(copy.documentation.name, "Shapes");
+
+    // corrupt caches are misses
+    writeFile(path, "ACOMDESC");
+    EXPECT_TRUE(!com::readDescriptionCache(path, key, copy));
+    std::remove(path.data());
+}
+
+
+TEST(WriteIfChanged, Unchanged)
+{
+    const std::string path = "write_if_changed.hpp";
+    std::remove(path.data());
+
+    EXPECT_TRUE(com::writeIfChanged(path, "#pragma once\r\n"));
+    EXPECT_TRUE(!com::writeIfChanged(path, "#pragma once\r\n"));
+    EXPECT_TRUE(com::writeIfChanged(path, "#pragma once\r\n\r\n"));
+    EXPECT_TRUE(com::writeIfChanged(path, "#pragma once\n"));
+    std::remove(path.data());
+}
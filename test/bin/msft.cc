@@ -0,0 +1,860 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Native MSFT type library reader test suite.
+ */
+
+#include <msft.h>
+#include <parse.h>
+#include <write.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace com = autocom;
+
+
+namespace
+{
+// HELPERS
+// -------
+
+/** \brief Little-endian byte buffer for a synthetic MSFT image.
+ */
+struct Buffer
+{
+    std::string bytes;
+
+    INT size() const
+    {
+        return INT(bytes.size());
+    }
+
+    void i32(const INT value)
+    {
+        bytes.append(reinterpret_cast<const char*>(&value), 4);
+    }
+
+    void i16(const SHORT value)
+    {
+        bytes.append(reinterpret_cast<const char*>(&value), 2);
+    }
+
+    void raw(const std::string &value)
+    {
+        bytes += value;
+        while (bytes.size() % 4) {
+            bytes.push_back('\0');
+        }
+    }
+};
+
+
+/** \brief Add name table entry and return its offset.
+ */
+INT addName(Buffer &table,
+    const std::string &name)
+{
+    INT offset = table.size();
+    table.i32(-1);
+    table.i32(-1);
+    table.i32(INT(name.size()));
+    table.raw(name);
+    return offset;
+}
+
+
+/** \brief Add GUID table entry and return its offset.
+ */
+INT addGuid(Buffer &table,
+    const GUID &guid)
+{
+    INT offset = table.size();
+    table.bytes.append(reinterpret_cast<const char*>(&guid), sizeof(GUID));
+    table.i32(-1);
+    table.i32(-1);
+    return offset;
+}
+
+
+/** \brief Inline data type for a base VARTYPE.
+ */
+INT inlineType(const VARTYPE vt)
+{
+    return INT(0x80000000 | (vt << 16) | vt);
+}
+
+
+/** \brief Write bytes to file.
+ */
+void writeFile(const std::string &path,
+    const std::string &bytes)
+{
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(bytes.data(), bytes.size());
+}
+
+
+/** \brief Read file contents.
+ */
+std::string readFile(const std::string &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << stream.rdbuf();
+    return contents.str();
+}
+
+
+/** \brief Create a synthetic MSFT image.
+ *
+ *  The library defines:
+ *      enum Color { Red = 0, Green = 1 };
+ *      struct Point { LONG x; DOUBLE y; SHORT data[4]; };
+ *      typedef Point Coord;
+ *      interface IShape: IDispatch { HRESULT Move(LONG, DOUBLE*); };
+ */
+std::string createImage()
+{
+    const GUID libid = {0x12345678, 0x1234, 0x5678, {1, 2, 3, 4, 5, 6, 7, 8}};
+    const GUID iid = {0x87654321, 0x4321, 0x8765, {8, 7, 6, 5, 4, 3, 2, 1}};
+    const INT count = 4;
+
+    Buffer names, guids, typedescs, arrays, impinfo, impfiles;
+    INT library = addName(names, "ShapeLib");
+    INT color = addName(names, "Color");
+    INT red = addName(names, "Red");
+    INT green = addName(names, "Green");
+    INT point = addName(names, "Point");
+    INT x = addName(names, "x");
+    INT y = addName(names, "y");
+    INT data = addName(names, "data");
+    INT coord = addName(names, "Coord");
+    INT shape = addName(names, "IShape");
+    INT move = addName(names, "Move");
+    INT dx = addName(names, "dx");
+    INT dy = addName(names, "dy");
+    INT libguid = addGuid(guids, libid);
+    INT shapeguid = addGuid(guids, iid);
+    INT dispatchguid = addGuid(guids, IID_IDispatch);
+
+    // DOUBLE*, SHORT[4], Point
+    typedescs.i16(VT_PTR);
+    typedescs.i16(0);
+    typedescs.i16(VT_R8);
+    typedescs.i16(-1);
+    typedescs.i16(VT_CARRAY);
+    typedescs.i16(0);
+    typedescs.i16(0);
+    typedescs.i16(0);
+    typedescs.i16(VT_USERDEFINED);
+    typedescs.i16(0);
+    typedescs.i32(0x64);
+    arrays.i16(VT_I2);
+    arrays.i16(-1);
+    arrays.i16(1);
+    arrays.i16(0);
+    arrays.i32(4);
+    arrays.i32(0);
+
+    // IDispatch imported from stdole2.tlb by GUID
+    impinfo.i32(0x010000);
+    impinfo.i32(0);
+    impinfo.i32(dispatchguid);
+    impfiles.i32(-1);
+    impfiles.i32(0);
+    impfiles.i32(0x00020002);
+    impfiles.i16(SHORT(11 << 2));
+    impfiles.raw("stdole2.tlb");
+
+    // member blocks: records, then member IDs, names and record offsets
+    Buffer colors;
+    colors.i32(40);
+    for (INT value = 0; value < 2; ++value) {
+        colors.i16(20);
+        colors.i16(0);
+        colors.i32(inlineType(VT_I4));
+        colors.i32(0);
+        colors.i16(VAR_CONST);
+        colors.i16(0);
+        colors.i32(INT(0x80000000 | (VT_I4 << 26) | value));
+    }
+    colors.i32(0x40000000);
+    colors.i32(0x40000001);
+    colors.i32(red);
+    colors.i32(green);
+    colors.i32(0);
+    colors.i32(20);
+
+    Buffer fields;
+    INT types[3] = {inlineType(VT_I4), inlineType(VT_R8), 8};
+    INT offsets[3] = {0, 8, 16};
+    fields.i32(60);
+    for (INT i = 0; i < 3; ++i) {
+        fields.i16(20);
+        fields.i16(0);
+        fields.i32(types[i]);
+        fields.i32(0);
+        fields.i16(VAR_PERINSTANCE);
+        fields.i16(0);
+        fields.i32(offsets[i]);
+    }
+    for (INT i = 0; i < 3; ++i) {
+        fields.i32(0x40000000 + i);
+    }
+    fields.i32(x);
+    fields.i32(y);
+    fields.i32(data);
+    for (INT i = 0; i < 3; ++i) {
+        fields.i32(20 * i);
+    }
+
+    Buffer methods;
+    methods.i32(48);
+    methods.i32(48);
+    methods.i32(inlineType(VT_HRESULT));
+    methods.i32(0);
+    methods.i16(28);
+    methods.i16(0);
+    methods.i32(FUNC_PUREVIRTUAL | (INVOKE_FUNC << 3) | (CC_STDCALL << 8));
+    methods.i16(2);
+    methods.i16(0);
+    methods.i32(inlineType(VT_I4));
+    methods.i32(dx);
+    methods.i32(PARAMFLAG_FIN);
+    methods.i32(0);
+    methods.i32(dy);
+    methods.i32(PARAMFLAG_FOUT);
+    methods.i32(0x60000000);
+    methods.i32(move);
+    methods.i32(0);
+
+    // layout: header, typeinfo offsets, segment directory, segments
+    std::vector<Buffer*> segments = {
+        nullptr, &impinfo, &impfiles, nullptr,
+        nullptr, &guids, nullptr, &names,
+        nullptr, &typedescs, &arrays, nullptr,
+        nullptr, nullptr, nullptr,
+    };
+    Buffer typeinfos;
+    typeinfos.bytes.resize(count * 0x64);
+    segments.front() = &typeinfos;
+    INT position = 0x54 + 4 * count + 15 * 16;
+    std::vector<INT> starts;
+    for (auto *segment: segments) {
+        starts.push_back(segment ? position : -1);
+        position += segment ? segment->size() : 0;
+    }
+    INT colorsOffset = position;
+    INT fieldsOffset = colorsOffset + colors.size();
+    INT methodsOffset = fieldsOffset + fields.size();
+
+    Buffer image;
+    image.i32(0x5446534D);
+    image.i32(0x00010002);
+    image.i32(libguid);
+    image.i32(0x409);
+    image.i32(0);
+    image.i32(SYS_WIN32);
+    image.i32(MAKELONG(1, 2));
+    image.i32(0);
+    image.i32(count);
+    image.i32(-1);
+    image.i32(0);
+    image.i32(0);
+    image.i32(13);
+    image.i32(names.size());
+    image.i32(library);
+    image.i32(-1);
+    image.i32(-1);
+    image.i32(0);
+    image.i32(0);
+    image.i32(-1);
+    image.i32(1);
+    for (INT i = 0; i < count; ++i) {
+        image.i32(i * 0x64);
+    }
+    for (size_t i = 0; i < segments.size(); ++i) {
+        image.i32(starts[i]);
+        image.i32(segments[i] ? segments[i]->size() : 0);
+        image.i32(-1);
+        image.i32(0x0F);
+    }
+
+    // type infos
+    struct Info
+    {
+        TYPEKIND kind;
+        INT members;
+        INT elements;
+        INT guid;
+        INT name;
+        SHORT interfaces;
+        SHORT vtbl;
+        INT size;
+        INT datatype;
+    };
+    Info infos[4] = {
+        {TKIND_ENUM, colorsOffset, MAKELONG(0, 2), -1, color, 0, 0, 4, -1},
+        {TKIND_RECORD, fieldsOffset, MAKELONG(0, 3), -1, point, 0, 0, 24, -1},
+        {TKIND_ALIAS, 0, 0, -1, coord, 0, 0, 24, 16},
+        {TKIND_INTERFACE, methodsOffset, MAKELONG(1, 0), shapeguid, shape, 1, 32, 4, 1},
+    };
+    typeinfos.bytes.clear();
+    for (const auto &info: infos) {
+        Buffer entry;
+        entry.i32(info.kind | (3 << 11));
+        entry.i32(info.members);
+        for (size_t i = 0; i < 4; ++i) {
+            entry.i32(0);
+        }
+        entry.i32(info.elements);
+        for (size_t i = 0; i < 4; ++i) {
+            entry.i32(0);
+        }
+        entry.i32(info.guid);
+        entry.i32(0);
+        entry.i32(info.name);
+        entry.i32(MAKELONG(1, 0));
+        entry.i32(-1);
+        entry.i32(0);
+        entry.i32(0);
+        entry.i32(-1);
+        entry.i16(info.interfaces);
+        entry.i16(info.vtbl);
+        entry.i32(info.size);
+        entry.i32(info.datatype);
+        entry.i32(-1);
+        entry.i32(0);
+        entry.i32(0);
+        typeinfos.bytes += entry.bytes;
+    }
+    for (auto *segment: segments) {
+        if (segment) {
+            image.bytes += segment->bytes;
+        }
+    }
+    image.bytes += colors.bytes + fields.bytes + methods.bytes;
+
+    return image.bytes;
+}
+
+
+/** \brief Wrap an MSFT image as the TYPELIB resource of a PE32 image.
+ */
+std::string createDll(const std::string &tlb)
+{
+    // resource directory: type, name and language levels
+    Buffer resources;
+    const INT names = 24, languages = 48, leaf = 72, name = 88, data = 104;
+    const INT rva = 0x1000;
+    INT levels[3][2] = {
+        {name | INT(0x80000000), names | INT(0x80000000)},
+        {1, languages | INT(0x80000000)},
+        {0x409, leaf},
+    };
+    for (size_t level = 0; level < 3; ++level) {
+        for (size_t i = 0; i < 3; ++i) {
+            resources.i32(0);
+        }
+        // the type is named, the name and language are IDs
+        resources.i16(level == 0 ? 1 : 0);
+        resources.i16(level == 0 ? 0 : 1);
+        resources.i32(levels[level][0]);
+        resources.i32(levels[level][1]);
+    }
+    resources.i32(rva + data);
+    resources.i32(INT(tlb.size()));
+    resources.i32(0);
+    resources.i32(0);
+    resources.i16(7);
+    for (char c: std::string("TYPELIB")) {
+        resources.i16(c);
+    }
+    resources.raw(tlb);
+
+    Buffer image;
+    image.bytes = std::string(0x40, '\0');
+    image.bytes[0] = 'M';
+    image.bytes[1] = 'Z';
+    image.bytes[0x3C] = 0x40;
+    image.i32(0x00004550);
+    image.i16(0x14C);
+    image.i16(1);
+    image.i32(0);
+    image.i32(0);
+    image.i32(0);
+    image.i16(224);
+    image.i16(0x2102);
+
+    // optional header, with the resource data directory
+    Buffer optional;
+    optional.bytes = std::string(224, '\0');
+    optional.bytes[0] = 0x0B;
+    optional.bytes[1] = 0x01;
+    std::memcpy(&optional.bytes[96 + 16], &rva, 4);
+    INT size = resources.size();
+    std::memcpy(&optional.bytes[96 + 20], &size, 4);
+    image.bytes += optional.bytes;
+
+    image.raw(".rsrc");
+    image.i32(size);
+    image.i32(rva);
+    image.i32(size);
+    image.i32(0x200);
+    for (size_t i = 0; i < 4; ++i) {
+        image.i32(0);
+    }
+    image.bytes.resize(0x200, '\0');
+    image.bytes += resources.bytes;
+
+    return image.bytes;
+}
+
+
+/** \brief Parse library on `pool`, and read back the headers written.
+ */
+template <typename Library>
+std::vector<std::string> parseHeaders(const Library &tlib,
+    com::parallel::ThreadPool &pool)
+{
+    com::TypeLibDescription description;
+    description.parse(tlib, pool);
+    std::string ns = "shapes";
+    std::string directory = ".";
+    com::Files files;
+    com::writeHeaders(description, ns, directory, files);
+
+    std::vector<std::string> contents;
+    for (const auto &path: files.headers) {
+        contents.emplace_back(readFile(path));
+        std::remove(path.data());
+    }
+    return contents;
+}
+
+}   /* anonymous */
+
+// TESTS
+// -----
+
+
+TEST(Msft, Library)
+{
+    const std::string path = "msft_library.tlb";
+    writeFile(path, createImage());
+
+    com::msft::TypeLib tlib(path);
+    auto attr = tlib.attr();
+    EXPECT_EQ(attr.guid().uuid(), "12345678-1234-5678-0102-030405060708");
+    EXPECT_EQ(attr.lcid(), 0x409);
+    EXPECT_EQ(attr.syskind(), SYS_WIN32);
+    EXPECT_EQ(attr.major(), 1);
+    EXPECT_EQ(attr.minor(), 2);
+    EXPECT_EQ(tlib.documentation(-1).name, "ShapeLib");
+    EXPECT_EQ(tlib.count(), 4);
+    EXPECT_THROW(tlib.info(4), com::ComMethodError);
+
+    auto info = tlib.info(3);
+    EXPECT_EQ(info.typelib(), tlib);
+    EXPECT_EQ(info.attr().kind(), TKIND_INTERFACE);
+    EXPECT_EQ(info.attr().vtblSize(), 8 * sizeof(void*));
+    EXPECT_EQ(info.info(info.reference(0)).documentation(-1).name, "IDispatch");
+    EXPECT_THROW(info.reference(-1), com::ComMethodError);
+
+    std::remove(path.data());
+}
+
+
+TEST(Msft, Imports)
+{
+    const std::string path = "msft_imports.tlb";
+    const std::string import = "stdole2.tlb";
+    writeFile(path, createImage());
+    EXPECT_TRUE(com::msft::TypeLib(path, {"."}).imports().empty());
+
+    // imported libraries found on the search path are listed once
+    writeFile(import, createImage());
+    com::msft::TypeLib tlib(path, {"."});
+    ASSERT_EQ(tlib.imports().size(), 1);
+    EXPECT_EQ(tlib.imports().front(), "./stdole2.tlb");
+
+    std::remove(import.data());
+    std::remove(path.data());
+}
+
+TEST(Msft, Members)
+{
+    const std::string path = "msft_members.tlb";
+    writeFile(path, createImage());
+    com::msft::TypeLib tlib(path);
+
+    auto color = tlib.info(0);
+    EXPECT_EQ(color.attr().variables(), 2);
+    EXPECT_EQ(color.vardesc(1).kind(), VAR_CONST);
+    EXPECT_EQ(color.vardesc(1).variant().lVal, 1);
+    EXPECT_EQ(color.documentation(color.vardesc(1).id()).name, "Green");
+
+    auto point = tlib.info(1);
+    EXPECT_EQ(point.attr().size(), 24);
+    EXPECT_EQ(point.attr().alignment(), 3);
+    EXPECT_EQ(point.vardesc(1).offset(), 8);
+    auto array = point.vardesc(2).element().type();
+    EXPECT_EQ(array.vt(), VT_CARRAY);
+    EXPECT_EQ(array.array().type().vt(), VT_I2);
+    EXPECT_EQ(array.array().bound(0).cElements, 4);
+
+    auto alias = tlib.info(2).attr().alias();
+    EXPECT_EQ(alias.vt(), VT_USERDEFINED);
+    EXPECT_EQ(tlib.info(2).info(alias.reference()), point);
+
+    auto function = tlib.info(3).funcdesc(0);
+    EXPECT_EQ(function.invocation(), INVOKE_FUNC);
+    EXPECT_EQ(function.decoration(), CC_STDCALL);
+    EXPECT_EQ(function.offset(), 7 * sizeof(void*));
+    EXPECT_EQ(function.returnType().type().vt(), VT_HRESULT);
+    EXPECT_EQ(function.args(), 2);
+    EXPECT_EQ(function.arg(1).type().vt(), VT_PTR);
+    EXPECT_EQ(function.arg(1).type().pointer().vt(), VT_R8);
+    EXPECT_EQ(function.arg(1).flags(), PARAMFLAG_FOUT);
+    EXPECT_EQ(tlib.info(3).documentation(function.id()).name, "Move");
+    EXPECT_EQ(tlib.info(3).names(function.id()), std::vector<std::string>({"Move", "dx", "dy"}));
+
+    std::remove(path.data());
+}
+
+
+TEST(Msft, Description)
+{
+    const std::string path = "msft_description.tlb";
+    writeFile(path, createImage());
+
+    com::TypeLibDescription description;
+    description.parse(com::msft::TypeLib(path));
+    const auto &items = description.description;
+    ASSERT_EQ(items.enums.size(), 1);
+    EXPECT_EQ(items.enums.front().header(), "enum Color\r\n{\r\n    Red = 0,\r\n    Green = 1,\r\n};\r\n");
+    ASSERT_EQ(items.records.size(), 1);
+    EXPECT_EQ(items.records.front().fields.back().header(), "SHORT data[4]");
+    ASSERT_EQ(items.aliases.size(), 1);
+    EXPECT_EQ(items.aliases.front().header(), "typedef Point Coord;");
+    ASSERT_EQ(items.interfaces.size(), 1);
+    EXPECT_EQ(items.interfaces.front().base, "IDispatch");
+    EXPECT_EQ(items.interfaces.front().functions.front().definition(), "Move(LONG dx, DOUBLE* dy)");
+    EXPECT_NE(items.interfaces.front().header().find("inline autocom::Result<DOUBLE> Move(LONG dx)"), std::string::npos);
+
+    std::remove(path.data());
+}
+
+
+TEST(Msft, Resource)
+{
+    const std::string path = "msft_resource.dll";
+    auto dll = createDll(createImage());
+    writeFile(path, dll);
+
+    auto resource = com::msft::findTypeLibResource(dll.data(), dll.size());
+    EXPECT_EQ(resource.first, 0x200 + 104);
+    EXPECT_EQ(dll.substr(resource.first, 4), "MSFT");
+    EXPECT_EQ(com::msft::findTypeLibResource(dll.data(), dll.size(), 1), resource);
+    EXPECT_THROW(com::msft::findTypeLibResource(dll.data(), dll.size(), 2), std::runtime_error);
+
+    com::msft::TypeLib tlib(path);
+    EXPECT_EQ(tlib.documentation(-1).name, "ShapeLib");
+    EXPECT_EQ(tlib.info(1).documentation(-1).name, "Point");
+
+    std::remove(path.data());
+}
+
+
+TEST(Msft, Invalid)
+{
+    const std::string path = "msft_invalid.tlb";
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << "SLTG and a few more bytes to read";
+    }
+    try {
+        com::msft::TypeLib tlib(path);
+        ADD_FAILURE() << "SLTG library was read.";
+    } catch (std::runtime_error &error) {
+        // not read natively, but loadable through COM
+        EXPECT_NE(std::string(error.what()).find("-progid"), std::string::npos);
+    }
+
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << "MSFT";
+    }
+    EXPECT_THROW(com::msft::TypeLib {path}, std::runtime_error);
+
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << "MZ but not a portable executable image";
+    }
+    EXPECT_THROW(com::msft::TypeLib {path}, std::runtime_error);
+    std::remove(path.data());
+}
+
+
+TEST(Msft, Fixtures)
+{
+    // checked-in images, so reader changes are tested against fixed bytes
+    com::msft::TypeLib tlib("test/data/shapelib.tlb");
+    EXPECT_EQ(tlib.attr().guid().uuid(), "12345678-1234-5678-0102-030405060708");
+    EXPECT_EQ(tlib.documentation(-1).name, "ShapeLib");
+    ASSERT_EQ(tlib.count(), 4);
+    EXPECT_EQ(tlib.info(3).documentation(-1).name, "IShape");
+
+    com::msft::TypeLib dll("test/data/shapelib.dll");
+    EXPECT_EQ(dll.attr().guid(), tlib.attr().guid());
+    EXPECT_EQ(dll.info(1).attr().size(), 24);
+
+    // headers are written next to each other, on any platform
+    com::TypeLibDescription description;
+    description.parse(dll);
+    std::string ns = "shapes";
+    std::string directory = ".";
+    com::Files files;
+    com::writeHeaders(description, ns, directory, files);
+    ASSERT_EQ(files.headers.size(), 2);
+    EXPECT_EQ(files.headers.front(), "./ShapeLib.hpp");
+    EXPECT_EQ(files.headers.back(), "./12345678-1234-5678-0102-030405060708.hpp");
+    for (const auto &path: files.headers) {
+        EXPECT_NE(readFile(path).find("#include"), std::string::npos);
+        std::remove(path.data());
+    }
+}
+
+
+TEST(Msft, Expected)
+{
+    // both fixtures give the header committed with them
+    auto expected = readFile("test/data/shapelib.hpp");
+    ASSERT_FALSE(expected.empty());
+
+    com::parallel::ThreadPool pool(1);
+    for (const auto path: {"test/data/shapelib.tlb", "test/data/shapelib.dll"}) {
+        auto headers = parseHeaders(com::msft::TypeLib(path), pool);
+        ASSERT_EQ(headers.size(), 2);
+        EXPECT_EQ(headers.back(), expected) << path;
+    }
+}
+
+
+
+TEST(Msft, Threads)
+{
+    // parallel parses write the same headers as a serial parse
+    com::msft::TypeLib tlib("test/data/shapelib.tlb");
+    com::parallel::ThreadPool serial(1);
+    com::parallel::ThreadPool parallel(4);
+    auto expected = parseHeaders(tlib, serial);
+    ASSERT_EQ(expected.size(), 2);
+    EXPECT_EQ(parseHeaders(tlib, parallel), expected);
+}
+
+#if defined(_WIN32)
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Write ShapeLib to `path` with oleaut32's CreateTypeLib2.
+ *
+ *  Mirrors `test/data/shapelib.idl`, so the reader is tested against
+ *  images from an independent writer.
+ */
+void createShapeLib(const std::wstring &path)
+{
+    ICreateTypeLib2 *lib;
+    ASSERT_TRUE(SUCCEEDED(CreateTypeLib2(SYS_WIN32, path.data(), &lib)));
+    GUID libid = {0x12345678, 0x1234, 0x5678, {1, 2, 3, 4, 5, 6, 7, 8}};
+    lib->SetGuid(libid);
+    lib->SetName(const_cast<LPOLESTR>(L"ShapeLib"));
+    lib->SetVersion(1, 2);
+    lib->SetLcid(0x409);
+
+    // enum Color { Red = 0, Green = 1 };
+    ICreateTypeInfo *color;
+    ASSERT_TRUE(SUCCEEDED(lib->CreateTypeInfo(const_cast<LPOLESTR>(L"Color"), TKIND_ENUM, &color)));
+    const wchar_t *values[] = {L"Red", L"Green"};
+    for (UINT i = 0; i < 2; ++i) {
+        VARIANT value;
+        value.vt = VT_I4;
+        value.lVal = LONG(i);
+        VARDESC desc = {};
+        desc.memid = 0x40000000 + i;
+        desc.lpvarValue = &value;
+        desc.elemdescVar.tdesc.vt = VT_I4;
+        desc.varkind = VAR_CONST;
+        ASSERT_TRUE(SUCCEEDED(color->AddVarDesc(i, &desc)));
+        color->SetVarName(i, const_cast<LPOLESTR>(values[i]));
+    }
+    color->LayOut();
+    color->Release();
+
+    // struct Point { long x; double y; short data[4]; };
+    ICreateTypeInfo *point;
+    ASSERT_TRUE(SUCCEEDED(lib->CreateTypeInfo(const_cast<LPOLESTR>(L"Point"), TKIND_RECORD, &point)));
+    ARRAYDESC array = {};
+    array.tdescElem.vt = VT_I2;
+    array.cDims = 1;
+    array.rgbounds[0].cElements = 4;
+    const wchar_t *fields[] = {L"x", L"y", L"data"};
+    for (UINT i = 0; i < 3; ++i) {
+        VARDESC desc = {};
+        desc.memid = 0x40000000 + i;
+        desc.varkind = VAR_PERINSTANCE;
+        desc.elemdescVar.tdesc.vt = i == 0 ? VT_I4 : VT_R8;
+        if (i == 2) {
+            desc.elemdescVar.tdesc.vt = VT_CARRAY;
+            desc.elemdescVar.tdesc.lpadesc = &array;
+        }
+        ASSERT_TRUE(SUCCEEDED(point->AddVarDesc(i, &desc)));
+        point->SetVarName(i, const_cast<LPOLESTR>(fields[i]));
+    }
+    point->SetAlignment(8);
+    ASSERT_TRUE(SUCCEEDED(point->LayOut()));
+
+    // typedef struct Point Coord;
+    ITypeInfo *pointInfo;
+    ASSERT_TRUE(SUCCEEDED(point->QueryInterface(IID_ITypeInfo, (void**) &pointInfo)));
+    ICreateTypeInfo *coord;
+    ASSERT_TRUE(SUCCEEDED(lib->CreateTypeInfo(const_cast<LPOLESTR>(L"Coord"), TKIND_ALIAS, &coord)));
+    TYPEDESC alias = {};
+    alias.vt = VT_USERDEFINED;
+    ASSERT_TRUE(SUCCEEDED(coord->AddRefTypeInfo(pointInfo, &alias.hreftype)));
+    coord->SetTypeDescAlias(&alias);
+    coord->LayOut();
+    coord->Release();
+    pointInfo->Release();
+    point->Release();
+
+    // interface IShape: IDispatch
+    ITypeLib *stdole;
+    ASSERT_TRUE(SUCCEEDED(LoadTypeLibEx(L"stdole2.tlb", REGKIND_NONE, &stdole)));
+    ITypeInfo *dispatch;
+    ASSERT_TRUE(SUCCEEDED(stdole->GetTypeInfoOfGuid(IID_IDispatch, &dispatch)));
+    ICreateTypeInfo *shape;
+    ASSERT_TRUE(SUCCEEDED(lib->CreateTypeInfo(const_cast<LPOLESTR>(L"IShape"), TKIND_INTERFACE, &shape)));
+    GUID iid = {0x87654321, 0x4321, 0x8765, {8, 7, 6, 5, 4, 3, 2, 1}};
+    shape->SetGuid(iid);
+    HREFTYPE base;
+    ASSERT_TRUE(SUCCEEDED(shape->AddRefTypeInfo(dispatch, &base)));
+    shape->AddImplType(0, base);
+
+    // HRESULT Move([in] long dx, [out, retval] double *dy);
+    TYPEDESC pointee = {};
+    pointee.vt = VT_R8;
+    ELEMDESC params[2] = {};
+    params[0].tdesc.vt = VT_I4;
+    params[0].paramdesc.wParamFlags = PARAMFLAG_FIN;
+    params[1].tdesc.vt = VT_PTR;
+    params[1].tdesc.lptdesc = &pointee;
+    params[1].paramdesc.wParamFlags = PARAMFLAG_FOUT | PARAMFLAG_FRETVAL;
+    FUNCDESC function = {};
+    function.memid = 0x60020000;
+    function.lprgelemdescParam = params;
+    function.funckind = FUNC_PUREVIRTUAL;
+    function.invkind = INVOKE_FUNC;
+    function.callconv = CC_STDCALL;
+    function.cParams = 2;
+    function.elemdescFunc.tdesc.vt = VT_HRESULT;
+    ASSERT_TRUE(SUCCEEDED(shape->AddFuncDesc(0, &function)));
+    LPOLESTR names[] = {const_cast<LPOLESTR>(L"Move"), const_cast<LPOLESTR>(L"dx"), const_cast<LPOLESTR>(L"dy")};
+    shape->SetFuncAndParamNames(0, names, 3);
+    ASSERT_TRUE(SUCCEEDED(shape->LayOut()));
+    shape->Release();
+    dispatch->Release();
+    stdole->Release();
+
+    ASSERT_TRUE(SUCCEEDED(lib->SaveAllChanges()));
+    lib->Release();
+}
+
+}   /* anonymous */
+
+// TESTS
+// -----
+
+
+TEST(Msft, CreateTypeLib2)
+{
+    // the native reader and oleaut32 agree on a library oleaut32 wrote
+    const std::string path = "msft_createtypelib2.tlb";
+    createShapeLib(L"msft_createtypelib2.tlb");
+    if (HasFatalFailure()) {
+        return;
+    }
+
+    ITypeLib *ppv;
+    ASSERT_TRUE(SUCCEEDED(LoadTypeLibEx(L"msft_createtypelib2.tlb", REGKIND_NONE, &ppv)));
+    com::parallel::ThreadPool pool(1);
+    auto expected = parseHeaders(com::TypeLib(ppv), pool);
+    auto actual = parseHeaders(com::msft::TypeLib(path), pool);
+    ASSERT_EQ(actual.size(), 2);
+    EXPECT_EQ(actual, expected);
+    EXPECT_NE(actual.back().find("struct Point"), std::string::npos);
+    EXPECT_NE(actual.back().find("Move(LONG dx, DOUBLE* dy)"), std::string::npos);
+
+    std::remove(path.data());
+}
+
+
+TEST(Msft, Stdole)
+{
+    // compare with oleaut32 for a library present on every system
+    char directory[MAX_PATH];
+    ASSERT_TRUE(GetSystemDirectoryA(directory, MAX_PATH));
+    const std::string path = std::string(directory) + "\\stdole2.tlb";
+
+    ITypeLib *ppv;
+    ASSERT_TRUE(SUCCEEDED(LoadTypeLibEx(L"stdole2.tlb", REGKIND_NONE, &ppv)));
+    com::TypeLib expected(ppv);
+    com::msft::TypeLib actual(path);
+
+    EXPECT_EQ(actual.attr().guid(), expected.attr().guid());
+    EXPECT_EQ(actual.documentation(-1).name, expected.documentation(-1).name);
+    ASSERT_EQ(actual.count(), expected.count());
+    for (UINT index = 0; index < actual.count(); ++index) {
+        auto left = actual.info(index);
+        auto right = expected.info(index);
+        EXPECT_EQ(left.documentation(-1).name, right.documentation(-1).name);
+        EXPECT_EQ(left.attr().kind(), right.attr().kind());
+        EXPECT_EQ(left.attr().guid(), right.attr().guid());
+        EXPECT_EQ(left.attr().functions(), right.attr().functions());
+        EXPECT_EQ(left.attr().variables(), right.attr().variables());
+        for (WORD i = 0; i < left.attr().functions(); ++i) {
+            auto id = left.funcdesc(i).id();
+            EXPECT_EQ(id, right.funcdesc(i).id());
+            EXPECT_EQ(left.documentation(id).name, right.documentation(id).name);
+            EXPECT_EQ(left.funcdesc(i).args(), right.funcdesc(i).args());
+        }
+    }
+}
+
+
+TEST(Msft, ComThreads)
+{
+    // pool tasks enter COM to read a library loaded by oleaut32
+    ITypeLib *ppv;
+    ASSERT_TRUE(SUCCEEDED(LoadTypeLibEx(L"test/data/shapelib.tlb", REGKIND_NONE, &ppv)));
+    com::TypeLib tlib(ppv);
+
+    com::parallel::ThreadPool serial(1);
+    com::parallel::ThreadPool parallel(4);
+    auto expected = parseHeaders(tlib, serial);
+    ASSERT_EQ(expected.size(), 2);
+    EXPECT_EQ(parseHeaders(tlib, parallel), expected);
+}
+
+#endif          // WIN32
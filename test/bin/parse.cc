@@ -66,6 +66,47 @@ TEST(Function, Header)
 }
 
 
+TEST(Function, Wrapper)
+{
+    com::detail::Function value;
+    value.decorator = "__stdcall";
+    value.returns.type = "HRESULT";
+    value.name = "GetName";
+    value.args.resize(2);
+    value.args[0].type = "LONG";
+    value.args[0].name = "index";
+    value.args[0].flags = PARAMFLAG_FIN;
+    value.args[1].type = "BSTR*";
+    value.args[1].name = "name";
+    value.args[1].flags = PARAMFLAG_FOUT | PARAMFLAG_FRETVAL;
+
+    EXPECT_EQ(value.wrapper(),
+        "    inline autocom::Result<autocom::Bstr> GetName(LONG index)\r\n"
+        "    {\r\n"
+        "        BSTR retval_ {};\r\n"
+        "        HRESULT hr_ = GetName(index, &retval_);\r\n"
+        "        return autocom::Result<autocom::Bstr>(hr_, autocom::Bstr(std::move(retval_)));\r\n"
+        "    }\r\n");
+
+    // typed SAFEARRAY is moved into the wrapper
+    value.args[1].type = "SAFEARRAY**";
+    value.args[1].element = "DOUBLE";
+    EXPECT_NE(value.wrapper().find("autocom::SafeArray<DOUBLE>(std::move(retval_))"), std::string::npos);
+
+    // a single [out] parameter is returned
+    value.args[1].type = "LONG*";
+    value.args[1].flags = PARAMFLAG_FOUT;
+    EXPECT_NE(value.wrapper().find("inline autocom::Result<LONG> GetName(LONG index)"), std::string::npos);
+
+    // no wrapper for [in] parameters, or other return types
+    value.args[1].flags = PARAMFLAG_FIN | PARAMFLAG_FOUT;
+    EXPECT_EQ(value.wrapper(), "");
+    value.args[1].flags = PARAMFLAG_FRETVAL;
+    value.returns.type = "void";
+    EXPECT_EQ(value.wrapper(), "");
+}
+
+
 TEST(Enum, Header)
 {
     com::detail::Enum value;
@@ -98,7 +139,45 @@ TEST(Record, Header)
     value.fields[0].type = "LONG";
     value.fields[0].name = "value";
 
-    EXPECT_EQ(value.header(), "struct Record\r\n{\r\n    LONG value;\r\n};\r\nstatic_assert(sizeof(Record) == 4, \"AutoCOM: Invalid struct size.\");\r\n");
+    EXPECT_EQ(value.header().find("struct Record\r\n{\r\n    LONG value;\r\n};\r\nstatic_assert(sizeof(Record) == 4, \"AutoCOM: Invalid struct size.\");\r\n\r\nstruct RecordColumns\r\n"), 0);
+}
+
+
+TEST(Record, Offsets)
+{
+    com::detail::Record value;
+    value.name = "Record";
+    value.size = 2 * sizeof(LONG);
+    value.fields.resize(2);
+    value.fields[0].type = "LONG";
+    value.fields[0].name = "first";
+    value.fields[1].type = "LONG";
+    value.fields[1].name = "second";
+    value.offsets = {0, 4};
+
+    auto header = value.header();
+    EXPECT_NE(header.find("static_assert(offsetof(Record, first) == 0, \"AutoCOM: Invalid field offset.\");\r\n"), std::string::npos);
+    EXPECT_NE(header.find("static_assert(offsetof(Record, second) == 4, \"AutoCOM: Invalid field offset.\");\r\n"), std::string::npos);
+}
+
+
+TEST(Record, Columns)
+{
+    com::detail::Record value;
+    value.name = "Record";
+    value.size = 2 * sizeof(LONG);
+    value.fields.emplace_back("LONG", "", "first");
+    value.fields.emplace_back("SHORT", "[2]", "second");
+
+    auto columns = value.columns();
+    EXPECT_NE(columns.find("struct RecordColumns\r\n{\r\n    autocom::Column<decltype(Record::first)> first;\r\n    autocom::Column<decltype(Record::second)> second;\r\n};\r\n"), std::string::npos);
+    EXPECT_NE(columns.find("constexpr size_t RecordOffsets[] = {offsetof(Record, first), offsetof(Record, second)};\r\n"), std::string::npos);
+    EXPECT_NE(columns.find("inline void toColumns(const Record *records, size_t count, RecordColumns &columns)\r\n"), std::string::npos);
+    EXPECT_NE(columns.find("autocom::scatterColumns(records, RecordOffsets, columns.first, columns.second);\r\n"), std::string::npos);
+
+    // records without fields have no columns
+    value.fields.clear();
+    EXPECT_EQ(value.columns(), "");
 }
 
 
@@ -114,6 +193,42 @@ TEST(Interface, Header)
 }
 
 
+TEST(Interface, Resolve)
+{
+    auto function = [](const std::string &name, const SHORT offset) {
+        com::detail::Function value;
+        value.name = name;
+        value.offset = offset;
+        return value;
+    };
+
+    com::detail::InterfaceMap bases;
+    com::detail::Interface parent;
+    parent.name = "IParent";
+    parent.base = "IDispatch";
+    parent.functions = {function("Second", 2), function("Invoke", 6), function("First", 1)};
+    parent.resolve(bases);
+    EXPECT_EQ(parent.object, "IDispatch");
+    ASSERT_EQ(parent.functions.size(), 2);
+    EXPECT_EQ(parent.functions.front().name, "First");
+
+    // derived interfaces find the Windows object through their base
+    com::detail::Interface child;
+    child.name = "IChild";
+    child.base = "IParent";
+    child.functions = {function("Invoke", 6), function("Third", 3)};
+    child.resolve(bases);
+    EXPECT_EQ(child.object, "IDispatch");
+    EXPECT_EQ(child.functions.size(), 1);
+    EXPECT_EQ(bases.at("IChild"), "IDispatch");
+
+    com::detail::Interface orphan;
+    orphan.name = "IOrphan";
+    orphan.base = "IMissing";
+    EXPECT_THROW(orphan.resolve(bases), std::out_of_range);
+}
+
+
 TEST(Dispatch, Header)
 {
     // TODO: implement
@@ -128,6 +243,22 @@ TEST(CoClass, Header)
 }
 
 
+TEST(CoClass, ConstexprGuid)
+{
+    GUID id = {0x1D23188D, 0x53FE, 0x4C25, {0xB0, 0x32, 0xDC, 0x70, 0xAC, 0xDB, 0xDC, 0x02}};
+    com::detail::CoClass value;
+    value.name = "Shape";
+    value.clsid = com::Guid(id);
+    value.interfaces.emplace_back("IShape");
+
+    com::detail::CONSTEXPR_GUIDS = true;
+    auto header = value.header();
+    com::detail::CONSTEXPR_GUIDS = false;
+    EXPECT_EQ(header.find("constexpr GUID CLSID_Shape = {0x1D23188D, 0x53FE, 0x4C25, {0xB0, 0x32, 0xDC, 0x70, 0xAC, 0xDB, 0xDC, 0x02}};\r\n"), 0);
+    EXPECT_EQ(value.header().find("DEFINE_GUID(CLSID_Shape, 0x1D23188D, "), 0);
+}
+
+
 TEST(Alias, Header)
 {
     com::detail::Alias value;
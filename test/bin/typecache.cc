@@ -0,0 +1,206 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Memoized type description cache test suite.
+ */
+
+#include <typecache.h>
+#include <gtest/gtest.h>
+
+namespace com = autocom;
+
+
+namespace
+{
+// CONSTANTS
+// ---------
+
+/** Types from `ANONYMOUS` have null GUIDs, and types from `DUAL`
+ *  share the GUID of the type `DUAL` before them, with a different
+ *  TYPEKIND, like the halves of a dual interface.
+ */
+const HREFTYPE DUAL = 50;
+const HREFTYPE ANONYMOUS = 100;
+
+// HELPERS
+// -------
+
+/** \brief Number of calls made to the underlying type description.
+ */
+struct Calls
+{
+    int attr = 0;
+    int documentation = 0;
+    int vardesc = 0;
+    int funcdesc = 0;
+    int info = 0;
+};
+
+
+/** \brief Attributes of a fake type with two functions and variables.
+ */
+struct FakeAttr
+{
+    HREFTYPE type = 0;
+
+    com::Guid guid() const
+    {
+        GUID id = {};
+        if (type < ANONYMOUS) {
+            id.Data1 = type % DUAL + 1;
+        }
+        return com::Guid(id);
+    }
+
+    TYPEKIND kind() const
+    {
+        return type < DUAL ? TKIND_DISPATCH : TKIND_INTERFACE;
+    }
+
+    WORD functions() const
+    {
+        return 2;
+    }
+
+    WORD variables() const
+    {
+        return 2;
+    }
+};
+
+
+/** \brief Fake type description counting each lookup.
+ */
+struct FakeInfo
+{
+    Calls *calls = nullptr;
+    HREFTYPE type = 0;
+
+    int typelib() const
+    {
+        return 0;
+    }
+
+    FakeAttr attr() const
+    {
+        ++calls->attr;
+        return FakeAttr {type};
+    }
+
+    com::Documentation documentation(const MEMBERID id) const
+    {
+        ++calls->documentation;
+        com::Documentation documentation;
+        documentation.name = std::to_string(type) + ":" + std::to_string(id);
+        return documentation;
+    }
+
+    UINT vardesc(const UINT index) const
+    {
+        ++calls->vardesc;
+        return index + 10;
+    }
+
+    UINT funcdesc(const UINT index) const
+    {
+        ++calls->funcdesc;
+        return index + 20;
+    }
+
+    FakeInfo info(const HREFTYPE type) const
+    {
+        ++calls->info;
+        return FakeInfo {calls, type};
+    }
+
+    HREFTYPE reference(const UINT index) const
+    {
+        return index + 1;
+    }
+
+    INT flags(const UINT /*index*/) const
+    {
+        return 0;
+    }
+};
+
+}   /* anonymous */
+
+// TESTS
+// -----
+
+
+TEST(TypeInfoCache, Memoize)
+{
+    Calls calls;
+    com::TypeInfoCache<FakeInfo> cache;
+    auto info = cache.add(FakeInfo {&calls, 0});
+    EXPECT_EQ(calls.attr, 1);
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(info.attr().variables(), 2);
+        EXPECT_EQ(info.documentation(-1).name, "0:-1");
+        EXPECT_EQ(info.documentation(5).name, "0:5");
+        EXPECT_EQ(info.vardesc(1), 11);
+        EXPECT_EQ(info.funcdesc(0), 20);
+    }
+    EXPECT_EQ(calls.attr, 1);
+    EXPECT_EQ(calls.documentation, 2);
+    EXPECT_EQ(calls.vardesc, 1);
+    EXPECT_EQ(calls.funcdesc, 1);
+    EXPECT_THROW(info.vardesc(2), std::out_of_range);
+    EXPECT_THROW(info.funcdesc(2), std::out_of_range);
+}
+
+
+TEST(TypeInfoCache, References)
+{
+    Calls calls;
+    com::TypeInfoCache<FakeInfo> cache;
+    auto info = cache.add(FakeInfo {&calls, 0});
+
+    // references are resolved once per type
+    for (int i = 0; i < 3; ++i) {
+        auto base = info.info(info.reference(0));
+        EXPECT_EQ(base.documentation(-1).name, "1:-1");
+    }
+    EXPECT_EQ(calls.info, 1);
+    EXPECT_EQ(calls.attr, 2);
+    EXPECT_EQ(calls.documentation, 1);
+    EXPECT_EQ(cache.size(), 2);
+
+    // documentation is keyed by type, not only by member ID
+    EXPECT_EQ(info.info(7).documentation(-1).name, "7:-1");
+    EXPECT_EQ(info.documentation(-1).name, "0:-1");
+    EXPECT_EQ(cache.size(), 3);
+}
+
+
+TEST(TypeInfoCache, Identity)
+{
+    Calls calls;
+    com::TypeInfoCache<FakeInfo> cache;
+    auto info = cache.add(FakeInfo {&calls, 0});
+    auto other = cache.add(FakeInfo {&calls, 1});
+
+    // types reached from different types share an entry
+    EXPECT_EQ(info.info(5).funcdesc(0), 20);
+    EXPECT_EQ(other.info(5).funcdesc(0), 20);
+    cache.add(FakeInfo {&calls, 5});
+    EXPECT_EQ(calls.funcdesc, 1);
+    EXPECT_EQ(cache.size(), 3);
+
+    // the halves of a dual interface do not
+    EXPECT_EQ(info.info(DUAL + 5).documentation(-1).name, "55:-1");
+    EXPECT_EQ(cache.size(), 4);
+
+    // types without a GUID are identified by name, fetched once per
+    // reference, which is the documentation of the entry
+    calls.documentation = 0;
+    EXPECT_EQ(info.info(ANONYMOUS).documentation(-1).name, "100:-1");
+    EXPECT_EQ(other.info(ANONYMOUS).documentation(-1).name, "100:-1");
+    EXPECT_EQ(info.info(ANONYMOUS + 1).documentation(-1).name, "101:-1");
+    EXPECT_EQ(calls.documentation, 3);
+    EXPECT_EQ(cache.size(), 6);
+}
@@ -0,0 +1,172 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Header writer test suite.
+ */
+
+#include <write.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace com = autocom;
+
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Create description with by-value and pointer references.
+ */
+com::TypeLibDescription createDescription()
+{
+    com::TypeLibDescription tlib;
+    GUID id = {0x12345678, 0x1234, 0x5678, {1, 2, 3, 4, 5, 6, 7, 8}};
+    tlib.guid = com::Guid(id);
+    tlib.documentation.name = "Shapes";
+
+    auto &description = tlib.description;
+    com::detail::Record point;
+    point.name = "Point";
+    point.size = 4;
+    point.fields.emplace_back("SHORT", "", "x");
+    point.fields.emplace_back("SHORT", "", "y");
+    description.records.emplace_back(point);
+
+    com::detail::Record rect;
+    rect.name = "Rect";
+    rect.size = 8;
+    rect.fields.emplace_back("Coord", "", "min");
+    rect.fields.emplace_back("Point", "", "max");
+    rect.fields.emplace_back("Rect*", "", "next");
+    description.records.emplace_back(rect);
+
+    com::detail::Alias coord;
+    coord.parameter = com::detail::Parameter("Point");
+    coord.name = "Coord";
+    description.aliases.emplace_back(coord);
+
+    com::detail::Function bounds;
+    bounds.returns = com::detail::Parameter("HRESULT");
+    bounds.name = "Bounds";
+    bounds.id = 1;
+    bounds.offset = 28;
+    bounds.args.emplace_back("Rect", "", "arg0");
+    bounds.args.emplace_back("IShape*", "", "arg1");
+
+    com::detail::Interface shape;
+    shape.name = "IShape";
+    shape.flags = 0;
+    shape.base = "IUnknown";
+    shape.object = "IUnknown";
+    shape.functions.emplace_back(bounds);
+    description.interfaces.emplace_back(shape);
+
+    com::detail::Interface circle;
+    circle.name = "ICircle";
+    circle.flags = 0;
+    circle.base = "IShape";
+    circle.object = "IUnknown";
+    description.interfaces.emplace_back(circle);
+
+    com::detail::CoClass coclass;
+    coclass.name = "Circle";
+    coclass.flags = 0;
+    coclass.interfaces.emplace_back("ICircle");
+    description.coclasses.emplace_back(coclass);
+
+    return tlib;
+}
+
+
+/** \brief Read file contents.
+ */
+std::string readFile(const std::string &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << stream.rdbuf();
+    return contents.str();
+}
+
+}   /* anonymous */
+
+// TESTS
+// -----
+
+
+TEST(Shard, Dependencies)
+{
+    auto graph = com::shardDependencies(createDescription());
+    typedef std::vector<std::string> Names;
+
+    EXPECT_EQ(graph.at("Point"), Names());
+    EXPECT_EQ(graph.at("Rect"), Names({"Point"}));
+    EXPECT_EQ(graph.at("IShape"), Names({"Rect"}));
+    EXPECT_EQ(graph.at("ICircle"), Names({"IShape"}));
+    EXPECT_EQ(graph.at("Circle"), Names({"ICircle"}));
+}
+
+
+TEST(Shard, Output)
+{
+    auto tlib = createDescription();
+    typedef std::vector<std::string> Names;
+
+    // pointer arguments only need forward declarations
+    com::detail::Function next;
+    next.returns = com::detail::Parameter("HRESULT");
+    next.name = "Next";
+    next.id = 2;
+    next.offset = 32;
+    next.args.emplace_back("Point*", "", "arg0");
+    next.args.back().flags = PARAMFLAG_FIN;
+    tlib.description.interfaces[0].functions.emplace_back(next);
+    EXPECT_EQ(com::shardDependencies(tlib).at("IShape"), Names({"Rect"}));
+
+    // the wrapper returns the output record by value
+    com::detail::Function center;
+    center.returns = com::detail::Parameter("HRESULT");
+    center.name = "Center";
+    center.id = 3;
+    center.offset = 36;
+    center.args.emplace_back("Coord*", "", "arg0");
+    center.args.back().flags = PARAMFLAG_FOUT | PARAMFLAG_FRETVAL;
+    tlib.description.interfaces[0].functions.emplace_back(center);
+    EXPECT_NE(center.wrapper().find("Coord retval_ {};"), std::string::npos);
+    EXPECT_EQ(com::shardDependencies(tlib).at("IShape"), Names({"Rect", "Point"}));
+}
+
+
+TEST(Shard, Headers)
+{
+    auto tlib = createDescription();
+    std::string ns = "shapes";
+    std::string directory = ".";
+
+    com::Files files;
+    com::writeShardedHeaders(tlib, ns, directory, files);
+    EXPECT_EQ(files.headers.size(), 8);
+    EXPECT_EQ(files.changed.size(), files.headers.size());
+
+    // shards only include their dependencies
+    auto shape = readFile(directory + "/" + tlib.guid.uuid() + "_IShape.hpp");
+    EXPECT_NE(shape.find("_Rect.hpp\"\r\n"), std::string::npos);
+    EXPECT_EQ(shape.find("_Point.hpp\""), std::string::npos);
+    EXPECT_NE(shape.find("namespace IShape_NS"), std::string::npos);
+
+    // unchanged headers are not rewritten
+    com::Files again;
+    com::writeShardedHeaders(tlib, ns, directory, again);
+    EXPECT_EQ(again.headers, files.headers);
+    EXPECT_TRUE(again.changed.empty());
+
+    for (const auto &path: files.headers) {
+        std::remove(path.data());
+    }
+}
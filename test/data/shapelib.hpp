@@ -0,0 +1,109 @@
+/**
+ *            **DO NOT EDIT THIS FILE**              
+ *  This file was automatically generated by AutoCOM.
+ *  Any changes to this file will be overwritten.    
+ */
+
+#include <autocom.h>
+#include <cstddef>
+
+namespace shapes
+{
+
+DEFINE_GUID(CLSID_ShapeLib, 0x12345678, 0x1234, 0x5678, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08);
+
+// ENUMS
+// -----
+
+enum Color
+{
+    Red = 0,
+    Green = 1,
+};
+
+
+// FORWARD
+// -------
+
+struct Point;
+struct IShape;
+typedef Point Coord;
+
+// UNIONS
+// ------
+
+
+// STRUCTS
+// -------
+
+struct Point
+{
+    LONG x;
+    DOUBLE y;
+    SHORT data[4];
+};
+static_assert(sizeof(Point) == 24, "AutoCOM: Invalid struct size.");
+static_assert(offsetof(Point, x) == 0, "AutoCOM: Invalid field offset.");
+static_assert(offsetof(Point, y) == 8, "AutoCOM: Invalid field offset.");
+static_assert(offsetof(Point, data) == 16, "AutoCOM: Invalid field offset.");
+
+struct PointColumns
+{
+    autocom::Column<decltype(Point::x)> x;
+    autocom::Column<decltype(Point::y)> y;
+    autocom::Column<decltype(Point::data)> data;
+};
+constexpr size_t PointOffsets[] = {offsetof(Point, x), offsetof(Point, y), offsetof(Point, data)};
+
+inline void toColumns(const Point *records, size_t count, PointColumns &columns)
+{
+    autocom::gatherColumns(records, count, PointOffsets, columns.x, columns.y, columns.data);
+}
+
+inline void fromColumns(const PointColumns &columns, Point *records)
+{
+    autocom::scatterColumns(records, PointOffsets, columns.x, columns.y, columns.data);
+}
+
+
+// INTERFACES
+// ----------
+
+DEFINE_GUID(IID_IShape, 0x87654321, 0x4321, 0x8765, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01);
+
+struct IShape: IDispatch
+{
+    static constexpr IID const &iid = IID_IShape;
+    static constexpr WORD flags = 0;
+    virtual HRESULT __stdcall Move(LONG dx, DOUBLE* dy);
+    inline autocom::Result<DOUBLE> Move(LONG dx)
+    {
+        DOUBLE retval_ {};
+        HRESULT hr_ = Move(dx, &retval_);
+        return autocom::Result<DOUBLE>(hr_, retval_);
+    }
+};
+
+
+// DISPATCHERS
+// -----------
+
+
+// COCLASSES
+// ---------
+
+
+namespace signatures{
+// SIGNATURES
+// ----------
+
+namespace IShape_NS
+{
+constexpr size_t Move_0_ArgCount = 2;
+typedef HRESULT Move_0_Returns;
+typedef LONG Move_0_Arg0;
+typedef DOUBLE* Move_0_Arg1;
+}    /* IShape_NS */
+
+}   /* signatures */
+}   /* shapes */
@@ -0,0 +1,105 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Allocation accounting test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+namespace com = autocom;
+namespace accounting = autocom::accounting;
+
+
+// HELPERS
+// -------
+
+
+/** \brief Expected count, which is zero unless accounting is enabled.
+ */
+uint64_t expected(const uint64_t count)
+{
+    return accounting::ENABLED ? count : 0;
+}
+
+// TESTS
+// -----
+
+
+TEST(Accounting, Bstr)
+{
+    accounting::Scope scope;
+    {
+        com::Bstr text(std::string("text"));
+        com::Bstr copy(text);
+    }
+
+    EXPECT_EQ(scope.count(accounting::ACCOUNT_SYSALLOCSTRING), expected(2));
+    EXPECT_EQ(scope.count(accounting::ACCOUNT_SYSFREESTRING), expected(2));
+    EXPECT_EQ(scope.count(accounting::ACCOUNT_SYSALLOCSTRING, "Bstr::copy()"), expected(1));
+    EXPECT_EQ(scope.count(accounting::ACCOUNT_SYSALLOCSTRING, "Bstr(const std::string &)"), expected(1));
+    EXPECT_EQ(scope.counts().allocations(), expected(2));
+}
+
+
+TEST(Accounting, Variant)
+{
+    accounting::Scope scope;
+    {
+        com::Variant variant;
+        variant.set(LONG(1));
+        com::Variant copy(variant);
+    }
+
+    EXPECT_EQ(scope.count(accounting::ACCOUNT_VARIANTCOPY), expected(1));
+    EXPECT_EQ(scope.count(accounting::ACCOUNT_VARIANTCLEAR), expected(3));
+    EXPECT_EQ(scope.counts().allocations(), 0);
+}
+
+
+TEST(Accounting, SafeArray)
+{
+    accounting::Scope outer;
+    {
+        com::SafeArray<INT> array = {3, 4, 5};
+        accounting::Scope inner;
+        com::SafeArray<INT> copy(array);
+        EXPECT_EQ(inner.count(accounting::ACCOUNT_SAFEARRAYCOPY), expected(1));
+        EXPECT_EQ(inner.count(accounting::ACCOUNT_SAFEARRAYCREATE), 0);
+    }
+
+    EXPECT_EQ(outer.count(accounting::ACCOUNT_SAFEARRAYCREATE), expected(1));
+    EXPECT_EQ(outer.count(accounting::ACCOUNT_SAFEARRAYDESTROY), expected(2));
+    EXPECT_EQ(outer.counts().allocations(), expected(2));
+}
+
+
+TEST(Accounting, Report)
+{
+    accounting::Scope scope;
+    EXPECT_TRUE(scope.sites().empty());
+    EXPECT_EQ(scope.report(), "");
+
+    accounting::record(accounting::ACCOUNT_SYSALLOCSTRING, "site");
+    accounting::record(accounting::ACCOUNT_SYSALLOCSTRING, "site");
+    accounting::record(accounting::ACCOUNT_VARIANTCLEAR, "site");
+    EXPECT_EQ(scope.report(), "site: SysAllocString 2, VariantClear 1\n");
+
+    // counts are per thread
+    std::thread thread([]() {
+        accounting::record(accounting::ACCOUNT_SYSFREESTRING, "site");
+    });
+    thread.join();
+    auto sites = scope.sites();
+    ASSERT_EQ(sites.size(), 1);
+    EXPECT_EQ(sites[0].tag, "site");
+    EXPECT_EQ(sites[0].counts.total(), 3);
+
+    scope.reset();
+    EXPECT_TRUE(scope.sites().empty());
+    EXPECT_EQ(std::string(accounting::name(accounting::ACCOUNT_VARIANTCOPY)), "VariantCopy");
+}
@@ -0,0 +1,221 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Cross-apartment interface reference test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace com = autocom;
+
+
+// HELPERS
+// -------
+
+
+/** \brief Reference-counted object, without real COM.
+ */
+struct FakeObject: IUnknown
+{
+    std::atomic<ULONG> references;
+
+    FakeObject():
+        references(1)
+    {}
+
+    virtual ~FakeObject() = default;
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override
+    {
+        AddRef();
+        *ppv = this;
+        return S_OK;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++references;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG count = --references;
+        if (count == 0) {
+            delete this;
+        }
+        return count;
+    }
+};
+
+
+/** \brief Proxy which must be released by the thread which created it.
+ */
+struct FakeProxy: FakeObject
+{
+    IUnknown *target;
+    std::thread::id owner;
+    std::atomic<int> &violations;
+
+    FakeProxy(IUnknown *target,
+            std::atomic<int> &violations):
+        target(target),
+        owner(std::this_thread::get_id()),
+        violations(violations)
+    {
+        target->AddRef();
+    }
+
+    ~FakeProxy()
+    {
+        if (owner != std::this_thread::get_id()) {
+            ++violations;
+        }
+        target->Release();
+    }
+};
+
+
+/** \brief Interface table where each thread is its own apartment.
+ */
+struct FakeApartment: com::InterfaceTable
+{
+    std::mutex mutex;
+    std::map<DWORD, IUnknown*> objects;
+    DWORD next = 1;
+    std::atomic<int> unmarshals;
+    std::atomic<int> violations;
+    bool fail = false;
+
+    FakeApartment():
+        unmarshals(0),
+        violations(0)
+    {}
+
+    virtual HRESULT registerInterface(IUnknown *unknown,
+        REFIID iid,
+        DWORD &cookie) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        unknown->AddRef();
+        cookie = next++;
+        objects[cookie] = unknown;
+        return S_OK;
+    }
+
+    virtual HRESULT getInterface(DWORD cookie,
+        REFIID iid,
+        void **ppv) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = objects.find(cookie);
+        if (fail || it == objects.end()) {
+            return E_FAIL;
+        }
+        ++unmarshals;
+        *ppv = static_cast<IUnknown*>(new FakeProxy(it->second, violations));
+        return S_OK;
+    }
+
+    virtual HRESULT revokeInterface(DWORD cookie) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = objects.find(cookie);
+        if (it == objects.end()) {
+            return E_FAIL;
+        }
+        it->second->Release();
+        objects.erase(it);
+        return S_OK;
+    }
+};
+
+// TESTS
+// -----
+
+
+TEST(AgileRef, Unmarshal)
+{
+    auto apartment = std::make_shared<FakeApartment>();
+    auto object = new FakeObject;
+    com::AgileRef<IUnknown> ref(object, IID_IUnknown, apartment);
+
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; ++i) {
+        threads.emplace_back([&]() {
+            auto first = ref.get();
+            for (size_t j = 0; j < 100; ++j) {
+                auto proxy = ref.get();
+                auto fake = static_cast<FakeProxy*>(proxy.get());
+                if (proxy != first || fake->target != object || fake->owner != std::this_thread::get_id()) {
+                    ++failures;
+                }
+            }
+            first.reset();
+            com::ApartmentHandle::clearThread();
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(apartment->unmarshals, 4);
+    EXPECT_EQ(apartment->violations, 0);
+    EXPECT_EQ(object->references, 2);
+
+    ref.reset();
+    EXPECT_EQ(object->references, 1);
+    object->Release();
+}
+
+
+TEST(AgileRef, Revoke)
+{
+    auto apartment = std::make_shared<FakeApartment>();
+    auto object = new FakeObject;
+    {
+        com::ApartmentHandle handle(object, IID_IUnknown, apartment);
+        com::ApartmentHandle copy = handle;
+        EXPECT_TRUE(bool(copy.get()));
+        handle.reset();
+        EXPECT_TRUE(bool(copy.get()));
+        EXPECT_EQ(apartment->unmarshals, 1);
+        EXPECT_EQ(object->references, 3);
+    }
+
+    // stale proxies are released on the next unmarshal
+    EXPECT_TRUE(apartment->objects.empty());
+    com::ApartmentHandle other(object, IID_IUnknown, apartment);
+    other.get();
+    EXPECT_EQ(object->references, 3);
+    other.reset();
+    EXPECT_EQ(object->references, 1);
+    EXPECT_EQ(apartment->violations, 0);
+    object->Release();
+}
+
+
+TEST(AgileRef, Failure)
+{
+    auto apartment = std::make_shared<FakeApartment>();
+    auto object = new FakeObject;
+    com::AgileRef<IUnknown> ref(object, IID_IUnknown, apartment);
+
+    apartment->fail = true;
+    EXPECT_THROW(ref.get(), com::ComResultError);
+    EXPECT_TRUE(!com::AgileRef<IUnknown>().get());
+
+    ref.reset();
+    object->Release();
+}
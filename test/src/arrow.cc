@@ -0,0 +1,123 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Arrow export test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace com = autocom;
+
+
+// TESTS
+// -----
+
+
+TEST(Arrow, Numeric)
+{
+    com::SafeArray<INT> array = {3, 4, 5};
+    auto *data = array.data();
+
+    ArrowArray out;
+    ArrowSchema schema;
+    com::exportArrow(std::move(array), &out, &schema, "values");
+    EXPECT_EQ(array.array, nullptr);
+    EXPECT_STREQ(schema.format, "i");
+    EXPECT_STREQ(schema.name, "values");
+    EXPECT_EQ(out.length, 3);
+    EXPECT_EQ(out.null_count, 0);
+    EXPECT_EQ(out.n_buffers, 2);
+    EXPECT_EQ(out.buffers[1], data);
+
+    auto *values = static_cast<const INT*>(out.buffers[1]);
+    EXPECT_EQ(values[0], 3);
+    EXPECT_EQ(values[2], 5);
+
+    out.release(&out);
+    schema.release(&schema);
+    EXPECT_EQ(out.release, nullptr);
+    EXPECT_EQ(schema.release, nullptr);
+}
+
+
+TEST(Arrow, Bstr)
+{
+    com::SafeArray<BSTR> array = {
+        SysAllocString(L"ab"),
+        SysAllocString(L"\u00E9"),
+        SysAllocString(L""),
+    };
+
+    ArrowArray out;
+    ArrowSchema schema;
+    com::exportArrow(std::move(array), &out, &schema);
+    EXPECT_STREQ(schema.format, "u");
+    EXPECT_EQ(out.length, 3);
+    EXPECT_EQ(out.n_buffers, 3);
+
+    auto *offsets = static_cast<const int32_t*>(out.buffers[1]);
+    auto *data = static_cast<const char*>(out.buffers[2]);
+    EXPECT_EQ(offsets[0], 0);
+    EXPECT_EQ(offsets[1], 2);
+    EXPECT_EQ(offsets[2], 4);
+    EXPECT_EQ(offsets[3], 4);
+    EXPECT_EQ(std::memcmp(data, "ab\xC3\xA9", 4), 0);
+
+    out.release(&out);
+    schema.release(&schema);
+}
+
+
+TEST(Arrow, VariantColumn)
+{
+    std::vector<com::Variant> column(3);
+    column[0].set(LONG(1));
+    column[2].set(SHORT(3));
+
+    ArrowArray out;
+    ArrowSchema schema;
+    com::exportArrow(column.data(), column.size(), &out, &schema);
+    EXPECT_STREQ(schema.format, "i");
+    EXPECT_EQ(schema.flags, ARROW_FLAG_NULLABLE);
+    EXPECT_EQ(out.length, 3);
+    EXPECT_EQ(out.null_count, 1);
+
+    auto *validity = static_cast<const uint8_t*>(out.buffers[0]);
+    auto *values = static_cast<const LONG*>(out.buffers[1]);
+    EXPECT_EQ(validity[0], 0x5);
+    EXPECT_EQ(values[0], 1);
+    EXPECT_EQ(values[2], 3);
+
+    out.release(&out);
+    schema.release(&schema);
+}
+
+
+TEST(Arrow, VariantRows)
+{
+    std::vector<com::VariantList> rows(2, com::VariantList(2));
+    rows[0][0].set(LONG(1));
+    rows[0][1].set(L"first");
+    rows[1][0].set(LONG(2));
+    rows[1][1].set(L"second");
+
+    ArrowArray out;
+    ArrowSchema schema;
+    com::exportArrow(rows, {"id", "name"}, &out, &schema);
+    EXPECT_STREQ(schema.format, "+s");
+    EXPECT_EQ(schema.n_children, 2);
+    EXPECT_EQ(out.n_children, 2);
+    EXPECT_EQ(out.length, 2);
+    EXPECT_STREQ(schema.children[0]->name, "id");
+    EXPECT_STREQ(schema.children[1]->format, "u");
+
+    auto *offsets = static_cast<const int32_t*>(out.children[1]->buffers[1]);
+    EXPECT_EQ(offsets[2], 11);
+
+    out.release(&out);
+    schema.release(&schema);
+}
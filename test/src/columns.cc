@@ -0,0 +1,143 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Struct-of-arrays record column test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstring>
+
+namespace com = autocom;
+
+
+// HELPERS
+// -------
+
+
+/** \brief Record with numeric, array and pointer fields.
+ */
+struct Sample
+{
+    LONG id;
+    SHORT flags[2];
+    DOUBLE value;
+    BSTR name;
+    BYTE kind;
+};
+
+
+struct SampleColumns
+{
+    com::Column<decltype(Sample::id)> id;
+    com::Column<decltype(Sample::flags)> flags;
+    com::Column<decltype(Sample::value)> value;
+    com::Column<decltype(Sample::name)> name;
+    com::Column<decltype(Sample::kind)> kind;
+};
+constexpr size_t SampleOffsets[] = {offsetof(Sample, id), offsetof(Sample, flags), offsetof(Sample, value), offsetof(Sample, name), offsetof(Sample, kind)};
+
+
+/** \brief Create records spanning several partial blocks.
+ */
+std::vector<Sample> createSamples(const size_t count)
+{
+    std::vector<Sample> samples(count);
+    for (size_t i = 0; i < count; ++i) {
+        samples[i].id = LONG(i) - 50;
+        samples[i].flags[0] = SHORT(i);
+        samples[i].flags[1] = SHORT(-i);
+        samples[i].value = i * 0.5;
+        samples[i].name = reinterpret_cast<BSTR>(i * 16);
+        samples[i].kind = BYTE(i);
+    }
+
+    return samples;
+}
+
+
+/** \brief Check gather kernel against byte copies, for full and partial blocks.
+ */
+template <size_t Width>
+void checkGather(void (*gather)(const void*, size_t, size_t, void*))
+{
+    for (size_t stride: {Width, Width + 4, Width + 5, size_t(40)}) {
+        for (size_t count = 0; count < 21; ++count) {
+            std::vector<BYTE> records(stride * count + Width);
+            for (size_t i = 0; i < records.size(); ++i) {
+                records[i] = BYTE(i * 7 + count);
+            }
+            std::vector<BYTE> column(Width * count + 1, 0xCD);
+            gather(records.data(), stride, count, column.data());
+            for (size_t i = 0; i < count; ++i) {
+                EXPECT_EQ(std::memcmp(&column[i * Width], &records[i * stride], Width), 0);
+            }
+            EXPECT_EQ(column.back(), 0xCD);
+        }
+    }
+}
+
+// TESTS
+// -----
+
+
+TEST(Columns, Kernels)
+{
+    checkGather<4>(com::gatherColumn32);
+    checkGather<8>(com::gatherColumn64);
+}
+
+
+TEST(Columns, Gather)
+{
+    auto samples = createSamples(139);
+
+    SampleColumns columns;
+    com::gatherColumns(samples.data(), samples.size(), SampleOffsets, columns.id, columns.flags, columns.value, columns.name, columns.kind);
+    ASSERT_EQ(columns.id.size(), 139);
+    ASSERT_EQ(columns.kind.size(), 139);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        EXPECT_EQ(columns.id[i], samples[i].id);
+        EXPECT_EQ(columns.flags[i][0], samples[i].flags[0]);
+        EXPECT_EQ(columns.flags[i][1], samples[i].flags[1]);
+        EXPECT_EQ(columns.value[i], samples[i].value);
+        EXPECT_EQ(columns.name[i], samples[i].name);
+        EXPECT_EQ(columns.kind[i], samples[i].kind);
+    }
+}
+
+
+TEST(Columns, Scatter)
+{
+    auto samples = createSamples(71);
+
+    SampleColumns columns;
+    com::gatherColumns(samples.data(), samples.size(), SampleOffsets, columns.id, columns.flags, columns.value, columns.name, columns.kind);
+
+    std::vector<Sample> copy(samples.size());
+    com::scatterColumns(copy.data(), SampleOffsets, columns.id, columns.flags, columns.value, columns.name, columns.kind);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        EXPECT_EQ(copy[i].id, samples[i].id);
+        EXPECT_EQ(copy[i].flags[1], samples[i].flags[1]);
+        EXPECT_EQ(copy[i].value, samples[i].value);
+        EXPECT_EQ(copy[i].name, samples[i].name);
+        EXPECT_EQ(copy[i].kind, samples[i].kind);
+    }
+
+    // columns of different lengths
+    columns.kind.pop_back();
+    EXPECT_THROW(com::scatterColumns(copy.data(), SampleOffsets, columns.id, columns.flags, columns.value, columns.name, columns.kind), std::invalid_argument);
+}
+
+
+TEST(Columns, Empty)
+{
+    SampleColumns columns;
+    columns.id.resize(4);
+    com::gatherColumns(static_cast<const Sample*>(nullptr), 0, SampleOffsets, columns.id, columns.value);
+    EXPECT_TRUE(columns.id.empty());
+    EXPECT_TRUE(columns.value.empty());
+}
@@ -0,0 +1,157 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief SafeArray element conversion test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+
+namespace com = autocom;
+
+
+// TESTS
+// -----
+
+
+TEST(Convert, Widen)
+{
+    std::vector<FLOAT> floats(37);
+    for (size_t i = 0; i < floats.size(); ++i) {
+        floats[i] = FLOAT(i) * 0.5f - 3.0f;
+    }
+    com::SafeArray<FLOAT> source(floats);
+    auto doubles = com::SafeArray<DOUBLE>::convertFrom(source);
+    ASSERT_EQ(doubles.size(), floats.size());
+    for (size_t i = 0; i < floats.size(); ++i) {
+        EXPECT_EQ(doubles[i], floats[i]);
+    }
+
+    // 16-element blocks and a tail
+    std::vector<SHORT> values(37);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = SHORT(i * 1771 - 32768);
+    }
+    values.back() = 32767;
+    com::SafeArray<SHORT> shorts(values);
+    auto longs = com::SafeArray<LONG>::convertFrom(shorts);
+    ASSERT_EQ(longs.size(), values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(longs[i], values[i]);
+    }
+    EXPECT_EQ(longs.front(), -32768);
+    EXPECT_EQ(longs.back(), 32767);
+
+    com::SafeArray<DOUBLE> same = {1.0, 2.0};
+    EXPECT_EQ(com::SafeArray<DOUBLE>::convertFrom(same).back(), 2.0);
+}
+
+
+TEST(Convert, Bool)
+{
+    SAFEARRAY *array = SafeArrayCreateVector(VT_BOOL, 0, 70);
+    VARIANT_BOOL *data;
+    ASSERT_TRUE(SUCCEEDED(SafeArrayAccessData(array, (void**) &data)));
+    for (size_t i = 0; i < 70; ++i) {
+        data[i] = i % 3 ? VARIANT_TRUE : VARIANT_FALSE;
+    }
+    SafeArrayUnaccessData(array);
+
+    bool values[70];
+    com::convertElements(array, values);
+    for (size_t i = 0; i < 70; ++i) {
+        EXPECT_EQ(values[i], i % 3 != 0);
+    }
+
+    auto ints = com::convertArray<INT>(array);
+    EXPECT_EQ(ints[0], 0);
+    EXPECT_EQ(ints[1], 1);
+    SafeArrayDestroy(array);
+}
+
+
+TEST(Convert, ToBool)
+{
+    com::SafeArray<LONG> source = {0, 1, 2, 0, 5};
+    auto bools = com::SafeArray<bool>::convertFrom(source);
+    LPSAFEARRAY array = bools;
+    ASSERT_EQ(com::getSafeArrayType(array), VT_BOOL);
+
+    // elements are stored as VARIANT_BOOL
+    VARIANT_BOOL *data;
+    ASSERT_TRUE(SUCCEEDED(SafeArrayAccessData(array, (void**) &data)));
+    const VARIANT_BOOL expected[] = {VARIANT_FALSE, VARIANT_TRUE, VARIANT_TRUE, VARIANT_FALSE, VARIANT_TRUE};
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(data[i], expected[i]) << i;
+    }
+    SafeArrayUnaccessData(array);
+}
+
+
+TEST(Convert, Overflow)
+{
+    com::SafeArray<LONG> source = {1, 200, -200, 70000};
+    EXPECT_THROW(com::SafeArray<CHAR>::convertFrom(source), std::overflow_error);
+
+    com::ConvertOptions options;
+    options.overflow = com::OverflowPolicy::Saturate;
+    auto saturated = com::SafeArray<CHAR>::convertFrom(source, options);
+    EXPECT_EQ(saturated[0], 1);
+    EXPECT_EQ(saturated[1], 127);
+    EXPECT_EQ(saturated[2], -128);
+    EXPECT_EQ(com::convertArray<UCHAR>(source, options)[2], 0);
+
+    options.overflow = com::OverflowPolicy::Wrap;
+    EXPECT_EQ(com::SafeArray<SHORT>::convertFrom(source, options)[3], SHORT(70000));
+}
+
+
+TEST(Convert, NaN)
+{
+    const DOUBLE nan = std::numeric_limits<DOUBLE>::quiet_NaN();
+    com::SafeArray<DOUBLE> source = {1.5, nan, -2.5, 1e300};
+    EXPECT_THROW(com::SafeArray<FLOAT>::convertFrom(source), std::overflow_error);
+
+    com::ConvertOptions options;
+    options.overflow = com::OverflowPolicy::Saturate;
+    auto floats = com::SafeArray<FLOAT>::convertFrom(source, options);
+    EXPECT_TRUE(std::isnan(floats[1]));
+    EXPECT_EQ(floats[3], std::numeric_limits<FLOAT>::max());
+
+    options.nan = com::NanPolicy::Zero;
+    auto ints = com::SafeArray<INT>::convertFrom(source, options);
+    EXPECT_EQ(ints[0], 1);
+    EXPECT_EQ(ints[1], 0);
+    EXPECT_EQ(ints[2], -2);
+    EXPECT_EQ(ints[3], std::numeric_limits<INT>::max());
+
+    options.nan = com::NanPolicy::Throw;
+    EXPECT_THROW(com::convertArray<DOUBLE>(source, options), std::domain_error);
+}
+
+
+TEST(Convert, Date)
+{
+    SAFEARRAY *array = SafeArrayCreateVector(VT_DATE, 0, 3);
+    DATE *data;
+    ASSERT_TRUE(SUCCEEDED(SafeArrayAccessData(array, (void**) &data)));
+    data[0] = 25569.0;
+    data[1] = 25569.5;
+    data[2] = -1.25;
+    SafeArrayUnaccessData(array);
+
+    auto points = com::convertArray<com::TimePoint>(array);
+    EXPECT_EQ(points[0].time_since_epoch().count(), 0);
+    EXPECT_EQ(std::chrono::duration_cast<std::chrono::seconds>(points[1].time_since_epoch()).count(), 43200);
+    EXPECT_EQ(com::timePointToDate(points[1]), 25569.5);
+    EXPECT_EQ(com::timePointToDate(points[2]), -1.25);
+    EXPECT_EQ(com::dateToTimePoint(25569.5), points[1]);
+    SafeArrayDestroy(array);
+
+    com::SafeArray<DOUBLE> doubles = {0.0};
+    EXPECT_THROW(com::convertArray<com::TimePoint>(doubles), com::ComTypeError);
+}
@@ -0,0 +1,651 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Connection point event sink test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace com = autocom;
+
+
+namespace
+{
+// CONSTANTS
+// ---------
+
+const IID IID_FakeEvents = {0x6A1C2F3E, 0x8D4B, 0x4E5F, {0x9A, 0x0B, 0x1C, 0x2D, 0x3E, 0x4F, 0x50, 0x61}};
+const IID IID_FakeSource = {0x6A1C2F3F, 0x8D4B, 0x4E5F, {0x9A, 0x0B, 0x1C, 0x2D, 0x3E, 0x4F, 0x50, 0x61}};
+
+const DISPID EVENT_PROGRESS = 1;
+const DISPID EVENT_DONE = 2;
+
+// OBJECTS
+// -------
+
+
+/** \brief Type information for the fake coclass, or one of its interfaces.
+ *
+ *  Only the members used to discover the source interface, and to
+ *  resolve event names, are implemented.
+ */
+class FakeTypeInfo: public ITypeInfo
+{
+protected:
+    ULONG references = 1;
+    TYPEKIND kind;
+    GUID guid;
+    std::vector<std::pair<INT, FakeTypeInfo*>> implemented;
+    std::vector<std::wstring> names;
+
+public:
+    FakeTypeInfo(TYPEKIND kind,
+            const GUID &guid,
+            std::vector<std::wstring> names = {}):
+        kind(kind),
+        guid(guid),
+        names(std::move(names))
+    {}
+
+    virtual ~FakeTypeInfo()
+    {
+        for (auto &item: implemented) {
+            item.second->Release();
+        }
+    }
+
+    void implement(const INT flags,
+        FakeTypeInfo *info)
+    {
+        implemented.emplace_back(flags, info);
+    }
+
+    // IUNKNOWN
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override
+    {
+        return E_NOINTERFACE;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++references;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG count = --references;
+        if (count == 0) {
+            delete this;
+        }
+        return count;
+    }
+
+    // ITYPEINFO
+    virtual HRESULT STDMETHODCALLTYPE GetTypeAttr(TYPEATTR **attr) override
+    {
+        *attr = new TYPEATTR();
+        (*attr)->guid = guid;
+        (*attr)->typekind = kind;
+        (*attr)->cImplTypes = static_cast<WORD>(implemented.size());
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetTypeComp(ITypeComp **comp) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetFuncDesc(UINT index,
+        FUNCDESC **desc) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetVarDesc(UINT index,
+        VARDESC **desc) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetNames(MEMBERID member,
+        BSTR *names,
+        UINT maximum,
+        UINT *count) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetRefTypeOfImplType(UINT index,
+        HREFTYPE *type) override
+    {
+        if (index >= implemented.size()) {
+            return TYPE_E_ELEMENTNOTFOUND;
+        }
+        *type = index;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetImplTypeFlags(UINT index,
+        INT *flags) override
+    {
+        if (index >= implemented.size()) {
+            return TYPE_E_ELEMENTNOTFOUND;
+        }
+        *flags = implemented[index].first;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetIDsOfNames(LPOLESTR *names,
+        UINT count,
+        MEMBERID *ids) override
+    {
+        for (size_t i = 0; i < this->names.size(); ++i) {
+            if (this->names[i] == names[0]) {
+                ids[0] = static_cast<MEMBERID>(i + 1);
+                return S_OK;
+            }
+        }
+        return DISP_E_UNKNOWNNAME;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Invoke(PVOID instance,
+        MEMBERID member,
+        WORD flags,
+        DISPPARAMS *params,
+        VARIANT *result,
+        EXCEPINFO *exception,
+        UINT *error) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetDocumentation(MEMBERID member,
+        BSTR *name,
+        BSTR *doc,
+        DWORD *context,
+        BSTR *file) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetDllEntry(MEMBERID member,
+        INVOKEKIND kind,
+        BSTR *dll,
+        BSTR *name,
+        WORD *ordinal) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetRefTypeInfo(HREFTYPE type,
+        ITypeInfo **info) override
+    {
+        if (type >= implemented.size()) {
+            return TYPE_E_ELEMENTNOTFOUND;
+        }
+        *info = implemented[type].second;
+        (*info)->AddRef();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE AddressOfMember(MEMBERID member,
+        INVOKEKIND kind,
+        PVOID *ppv) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateInstance(IUnknown *outer,
+        REFIID iid,
+        PVOID *ppv) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetMops(MEMBERID member,
+        BSTR *mops) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetContainingTypeLib(ITypeLib **tlib,
+        UINT *index) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual void STDMETHODCALLTYPE ReleaseTypeAttr(TYPEATTR *attr) override
+    {
+        delete attr;
+    }
+
+    virtual void STDMETHODCALLTYPE ReleaseFuncDesc(FUNCDESC *desc) override
+    {}
+
+    virtual void STDMETHODCALLTYPE ReleaseVarDesc(VARDESC *desc) override
+    {}
+};
+
+
+/** \brief Server raising events, which is its own connection point.
+ */
+class FakeSource: public com::DispatchImpl<FakeSource>,
+    public IConnectionPointContainer,
+    public IConnectionPoint,
+    public IProvideClassInfo
+{
+protected:
+    std::vector<IDispatch*> sinks;
+
+    /** \brief Raise Progress(percent, status), then Done() at 100.
+     */
+    void fire(LONG percent,
+        BSTR status)
+    {
+        VARIANT arguments[2];
+        arguments[0].vt = VT_BSTR;
+        arguments[0].bstrVal = status;
+        arguments[1].vt = VT_I4;
+        arguments[1].lVal = percent;
+        DISPPARAMS progress = {arguments, nullptr, 2, 0};
+        DISPPARAMS done = {nullptr, nullptr, 0, 0};
+
+        for (IDispatch *sink: sinks) {
+            if (sink) {
+                sink->Invoke(EVENT_PROGRESS, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &progress, nullptr, nullptr, nullptr);
+                if (percent == 100) {
+                    sink->Invoke(EVENT_DONE, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &done, nullptr, nullptr, nullptr);
+                }
+            }
+        }
+    }
+
+public:
+    size_t connections() const
+    {
+        size_t count = 0;
+        for (IDispatch *sink: sinks) {
+            count += sink != nullptr;
+        }
+        return count;
+    }
+
+    AUTOCOM_DISPATCH_BEGIN(FakeSource)
+        AUTOCOM_DISPATCH_METHOD(L"Fire", 1, &FakeSource::fire)
+    AUTOCOM_DISPATCH_END()
+
+    ~FakeSource()
+    {
+        for (IDispatch *sink: sinks) {
+            if (sink) {
+                sink->Release();
+            }
+        }
+    }
+
+    // IUNKNOWN
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override
+    {
+        if (IsEqualIID(iid, IID_IConnectionPointContainer)) {
+            *ppv = static_cast<IConnectionPointContainer*>(this);
+        } else if (IsEqualIID(iid, IID_IProvideClassInfo)) {
+            *ppv = static_cast<IProvideClassInfo*>(this);
+        } else {
+            return DispatchImpl::QueryInterface(iid, ppv);
+        }
+        AddRef();
+        return S_OK;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return DispatchImpl::AddRef();
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release() override
+    {
+        return DispatchImpl::Release();
+    }
+
+    // ICONNECTIONPOINTCONTAINER
+    virtual HRESULT STDMETHODCALLTYPE EnumConnectionPoints(IEnumConnectionPoints **points) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE FindConnectionPoint(REFIID iid,
+        IConnectionPoint **point) override
+    {
+        if (!IsEqualIID(iid, IID_FakeEvents)) {
+            *point = nullptr;
+            return CONNECT_E_NOCONNECTION;
+        }
+        *point = static_cast<IConnectionPoint*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    // ICONNECTIONPOINT
+    virtual HRESULT STDMETHODCALLTYPE GetConnectionInterface(IID *iid) override
+    {
+        *iid = IID_FakeEvents;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetConnectionPointContainer(IConnectionPointContainer **container) override
+    {
+        *container = static_cast<IConnectionPointContainer*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Advise(IUnknown *sink,
+        DWORD *cookie) override
+    {
+        IDispatch *dispatch;
+        if (FAILED(sink->QueryInterface(IID_FakeEvents, (void**) &dispatch))) {
+            return CONNECT_E_CANNOTCONNECT;
+        }
+        sinks.push_back(dispatch);
+        *cookie = static_cast<DWORD>(sinks.size());
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Unadvise(DWORD cookie) override
+    {
+        if (cookie == 0 || cookie > sinks.size() || !sinks[cookie - 1]) {
+            return CONNECT_E_NOCONNECTION;
+        }
+        sinks[cookie - 1]->Release();
+        sinks[cookie - 1] = nullptr;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE EnumConnections(IEnumConnections **connections) override
+    {
+        return E_NOTIMPL;
+    }
+
+    // IPROVIDECLASSINFO
+    virtual HRESULT STDMETHODCALLTYPE GetClassInfo(ITypeInfo **info) override
+    {
+        FakeTypeInfo *coclass = new FakeTypeInfo(TKIND_COCLASS, IID_NULL);
+        coclass->implement(IMPLTYPEFLAG_FDEFAULT, new FakeTypeInfo(TKIND_DISPATCH, IID_FakeSource));
+        coclass->implement(IMPLTYPEFLAG_FSOURCE, new FakeTypeInfo(TKIND_DISPATCH, IID_NULL));
+        coclass->implement(IMPLTYPEFLAG_FDEFAULT | IMPLTYPEFLAG_FSOURCE, new FakeTypeInfo(TKIND_DISPATCH, IID_FakeEvents, {L"Progress", L"Done"}));
+        *info = coclass;
+        return S_OK;
+    }
+};
+
+}   /* anonymous */
+
+// TESTS
+// -----
+
+
+TEST(EventSink, SourceTypeInfo)
+{
+    FakeSource *source = new FakeSource;
+    ITypeInfo *info = com::newSourceTypeInfo(source);
+    TYPEATTR *attr;
+    ASSERT_EQ(info->GetTypeAttr(&attr), S_OK);
+    EXPECT_TRUE(IsEqualIID(attr->guid, IID_FakeEvents));
+    info->ReleaseTypeAttr(attr);
+    EXPECT_EQ(info->Release(), 0);
+
+    EXPECT_EQ(source->Release(), 0);
+}
+
+
+TEST(EventSink, Handlers)
+{
+    FakeSource *source = new FakeSource;
+    source->AddRef();
+    com::DispatchBase dispatch(source);
+
+    LONG percent = 0;
+    std::wstring status;
+    bool done = false;
+    {
+        com::EventSink sink(source);
+        EXPECT_TRUE(bool(sink));
+        EXPECT_EQ(sink.iid(), com::Guid(IID_FakeEvents));
+
+        sink.on(L"Progress", [&](DISPPARAMS &params) {
+            percent = params.rgvarg[1].lVal;
+            status = params.rgvarg[0].bstrVal;
+        });
+        sink.on(EVENT_DONE, [&](DISPPARAMS &params) {
+            done = true;
+        });
+        EXPECT_THROW(sink.on(L"Cancel", [](DISPPARAMS&) {}), com::ComMethodError);
+
+        // events are only delivered while advised
+        EXPECT_TRUE(dispatch.method(L"Fire", 10, L"ignored"));
+        EXPECT_EQ(percent, 0);
+
+        sink.advise();
+        EXPECT_TRUE(sink.advised());
+        EXPECT_EQ(source->connections(), 1);
+        EXPECT_THROW(sink.on(EVENT_PROGRESS, [](DISPPARAMS&) {}), std::logic_error);
+
+        EXPECT_TRUE(dispatch.method(L"Fire", 50, L"working"));
+        EXPECT_EQ(percent, 50);
+        EXPECT_EQ(status, L"working");
+        EXPECT_FALSE(done);
+        EXPECT_TRUE(dispatch.method(L"Fire", 100, L"finished"));
+        EXPECT_TRUE(done);
+
+        sink.unadvise();
+        EXPECT_EQ(source->connections(), 0);
+        EXPECT_TRUE(dispatch.method(L"Fire", 75, L"ignored"));
+        EXPECT_EQ(percent, 100);
+
+        // the sink disconnects on destruction
+        sink.advise();
+        EXPECT_EQ(source->connections(), 1);
+    }
+    EXPECT_EQ(source->connections(), 0);
+
+    dispatch.reset();
+    EXPECT_EQ(source->Release(), 0);
+}
+
+
+TEST(EventSink, Queue)
+{
+    FakeSource *source = new FakeSource;
+    com::DispatchBase dispatch(source);
+    com::EventQueue queue(2);
+    com::EventSink sink(static_cast<IDispatch*>(source), com::Guid(IID_FakeEvents));
+    EXPECT_THROW(sink.on(L"Progress", [](DISPPARAMS&) {}), std::invalid_argument);
+    sink.forward(&queue);
+    sink.advise();
+
+    dispatch.method(L"Fire", 1, L"first");
+    dispatch.method(L"Fire", 2, L"second");
+    dispatch.method(L"Fire", 3, L"third");
+    EXPECT_EQ(queue.size(), 2);
+    EXPECT_EQ(queue.dropped(), 1);
+
+    // arguments are copied, in call order
+    com::Event event;
+    ASSERT_TRUE(queue.pop(event));
+    EXPECT_EQ(event.id, EVENT_PROGRESS);
+    ASSERT_EQ(event.arguments.size(), 2);
+    EXPECT_EQ(event.arguments[0].lVal, 1);
+    EXPECT_EQ(std::wstring(event.arguments[1].bstrVal), L"first");
+    ASSERT_TRUE(queue.pop(event));
+    EXPECT_EQ(event.arguments[0].lVal, 2);
+    EXPECT_FALSE(queue.pop(event));
+    EXPECT_TRUE(queue.empty());
+}
+
+
+TEST(EventSink, Errors)
+{
+    FakeSource *source = new FakeSource;
+
+    com::EventSink sink;
+    EXPECT_FALSE(bool(sink));
+    EXPECT_THROW(sink.advise(), std::logic_error);
+    EXPECT_THROW(sink.open(static_cast<IDispatch*>(source), com::Guid(IID_FakeSource)), com::ComMethodError);
+    EXPECT_FALSE(bool(sink));
+
+    sink.open(static_cast<IDispatch*>(source), com::Guid(IID_FakeEvents));
+    EXPECT_TRUE(bool(sink));
+    sink.close();
+    EXPECT_FALSE(bool(sink));
+
+    EXPECT_EQ(source->Release(), 0);
+}
+
+
+TEST(EventSink, Exceptions)
+{
+    com::EventSink sink;
+    sink.on(EVENT_PROGRESS, [](DISPPARAMS&) {
+        throw std::runtime_error("Handler failed.");
+    });
+    sink.on(EVENT_DONE, [](DISPPARAMS&) {
+        throw 42;
+    });
+
+    // exceptions must not cross the COM boundary
+    DISPPARAMS params = {nullptr, nullptr, 0, 0};
+    EXCEPINFO exception;
+    EXPECT_EQ(sink.dispatch()->Invoke(EVENT_PROGRESS, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &params, nullptr, &exception, nullptr), DISP_E_EXCEPTION);
+    EXPECT_EQ(std::wstring(exception.bstrDescription), L"Handler failed.");
+    SysFreeString(exception.bstrSource);
+    SysFreeString(exception.bstrDescription);
+
+    EXPECT_EQ(sink.dispatch()->Invoke(EVENT_DONE, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &params, nullptr, &exception, nullptr), DISP_E_EXCEPTION);
+    EXPECT_EQ(std::wstring(exception.bstrDescription), L"Unknown exception.");
+    SysFreeString(exception.bstrSource);
+    SysFreeString(exception.bstrDescription);
+}
+
+
+TEST(EventQueue, Threads)
+{
+    const LONG count = 10000;
+    com::EventQueue queue(64);
+    EXPECT_EQ(queue.capacity(), 64);
+
+    std::thread producer([&]() {
+        VARIANT argument;
+        argument.vt = VT_I4;
+        DISPPARAMS params = {&argument, nullptr, 1, 0};
+        for (LONG i = 0; i < count; ++i) {
+            argument.lVal = i;
+            while (!queue.push(EVENT_PROGRESS, params)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    com::Event event;
+    LONG expected = 0;
+    while (expected < count) {
+        if (queue.pop(event)) {
+            ASSERT_EQ(event.arguments[0].lVal, expected);
+            ++expected;
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
+
+
+TEST(EventQueue, Producers)
+{
+    // events delivered concurrently, as in the multithreaded apartment
+    const LONG count = 5000;
+    const LONG threads = 4;
+    com::EventQueue queue(64);
+
+    std::vector<std::thread> producers;
+    for (LONG thread = 0; thread < threads; ++thread) {
+        producers.emplace_back([&queue, count, thread]() {
+            VARIANT arguments[2];
+            arguments[0].vt = VT_I4;
+            arguments[1].vt = VT_I4;
+            arguments[1].lVal = thread;
+            DISPPARAMS params = {arguments, nullptr, 2, 0};
+            for (LONG i = 0; i < count; ++i) {
+                arguments[0].lVal = i;
+                while (!queue.push(EVENT_PROGRESS, params)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // each producer's events arrive intact and in order
+    com::Event event;
+    std::vector<LONG> expected(threads, 0);
+    for (LONG received = 0; received < threads * count; ) {
+        if (queue.pop(event)) {
+            ASSERT_EQ(event.arguments.size(), 2);
+            LONG thread = event.arguments[0].lVal;
+            ASSERT_TRUE(thread >= 0 && thread < threads);
+            ASSERT_EQ(event.arguments[1].lVal, expected[thread]);
+            ++expected[thread];
+            ++received;
+        }
+    }
+    for (auto &producer: producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+
+TEST(EventQueue, CopyFailure)
+{
+    com::EventQueue queue(4);
+    VARIANT arguments[2];
+    arguments[0].vt = VT_BYREF | VT_I4;
+    arguments[0].plVal = nullptr;
+    arguments[1].vt = VT_BSTR;
+    arguments[1].bstrVal = SysAllocString(L"copied");
+    DISPPARAMS params = {arguments, nullptr, 2, 0};
+
+    // the dangling reference fails after the string is copied
+    EXPECT_FALSE(queue.push(EVENT_PROGRESS, params));
+    EXPECT_EQ(queue.dropped(), 1);
+
+    LONG value = 7;
+    arguments[0].plVal = &value;
+    EXPECT_TRUE(queue.push(EVENT_DONE, params));
+
+    // the failed slot is skipped, and reused
+    com::Event event;
+    ASSERT_TRUE(queue.pop(event));
+    EXPECT_EQ(event.id, EVENT_DONE);
+    ASSERT_EQ(event.arguments.size(), 2);
+    EXPECT_EQ(std::wstring(event.arguments[0].bstrVal), L"copied");
+    EXPECT_EQ(event.arguments[1].vt, VT_I4);
+    EXPECT_EQ(event.arguments[1].lVal, 7);
+    EXPECT_FALSE(queue.pop(event));
+    EXPECT_TRUE(queue.empty());
+
+    for (LONG i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.push(EVENT_DONE, params));
+    }
+    EXPECT_FALSE(queue.push(EVENT_DONE, params));
+    EXPECT_EQ(queue.dropped(), 2);
+
+    SysFreeString(arguments[1].bstrVal);
+}
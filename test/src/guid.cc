@@ -8,6 +8,11 @@
 #include <autocom.h>
 #include <gtest/gtest.h>
 
+#include <cctype>
+#include <cstdio>
+#include <map>
+#include <unordered_set>
+
 
 // TESTS
 // -----
@@ -15,9 +20,14 @@
 
 TEST(GuidTest, Constructor)
 {
+    autocom::Guid guid;
+
+    // ProgIDs are resolved through the registry
+#if defined(_WIN32)
     std::string progid = "VBScript.RegExp";
-    auto guid = autocom::Guid::fromProgid(progid);
+    guid = autocom::Guid::fromProgid(progid);
     EXPECT_EQ(progid, guid.toProgid());
+#endif
 
     std::string clsid = "{1D23188D-53FE-4C25-B032-DC70ACDBDC02}";
     guid = autocom::Guid::fromClsid(clsid);
@@ -27,3 +37,130 @@ TEST(GuidTest, Constructor)
     guid = autocom::Guid::fromIid(iid);
     EXPECT_EQ(iid, guid.toIid());
 }
+
+
+TEST(GuidTest, Literal)
+{
+    using namespace autocom::literals;
+
+    constexpr auto guid = "{1D23188D-53FE-4C25-B032-DC70ACDBDC02}"_guid;
+    static_assert(guid.get().Data1 == 0x1D23188D, "Data1 parsed at compile time.");
+    static_assert(guid == "1d23188d-53fe-4c25-b032-dc70acdbdc02"_guid, "Braces and case are optional.");
+    static_assert(guid != "{11B488A0-69B1-41FC-A660-FE8DF2A31F5B}"_guid, "Distinct GUIDs compare unequal.");
+
+    EXPECT_EQ(guid.get().Data2, 0x53FE);
+    EXPECT_EQ(guid.get().Data3, 0x4C25);
+    EXPECT_EQ(guid.get().Data4[0], 0xB0);
+    EXPECT_EQ(guid.get().Data4[7], 0x02);
+    EXPECT_EQ(guid.uuid(), "1D23188D-53FE-4C25-B032-DC70ACDBDC02");
+    EXPECT_EQ(guid.constant("CLSID", "RegExp"), "constexpr GUID CLSID_RegExp = {0x1D23188D, 0x53FE, 0x4C25, {0xB0, 0x32, 0xDC, 0x70, 0xAC, 0xDB, 0xDC, 0x02}};");
+}
+
+
+TEST(GuidTest, Invalid)
+{
+    EXPECT_THROW(autocom::parseGuid("{1D23188D-53FE-4C25-B032-DC70ACDBDC02", 37), std::invalid_argument);
+    EXPECT_THROW(autocom::parseGuid("1D23188D-53FE-4C25-B032-DC70ACDBDC0G", 36), std::invalid_argument);
+    EXPECT_THROW(autocom::parseGuid("1D23188D_53FE-4C25-B032-DC70ACDBDC02", 36), std::invalid_argument);
+}
+
+
+TEST(GuidTest, Format)
+{
+    using namespace autocom::literals;
+
+    auto guid = "{1D23188D-53FE-4C25-B032-DC70ACDBDC02}"_guid;
+    EXPECT_EQ(guid.uuid(), "1D23188D-53FE-4C25-B032-DC70ACDBDC02");
+    EXPECT_EQ(guid.uuid(autocom::GUID_LOWER), "1d23188d-53fe-4c25-b032-dc70acdbdc02");
+    EXPECT_EQ(guid.uuid(autocom::GUID_BRACED_UPPER), "{1D23188D-53FE-4C25-B032-DC70ACDBDC02}");
+    EXPECT_EQ(guid.uuid(autocom::GUID_BRACED_LOWER), "{1d23188d-53fe-4c25-b032-dc70acdbdc02}");
+}
+
+
+TEST(GuidTest, Parse)
+{
+    using namespace autocom::literals;
+
+    GUID id;
+    auto guid = "{1D23188D-53FE-4C25-B032-DC70ACDBDC02}"_guid;
+    ASSERT_TRUE(autocom::readGuid("{1d23188d-53fe-4c25-b032-dc70acdbdc02}", 38, id));
+    EXPECT_TRUE(autocom::Guid(id) == guid);
+    ASSERT_TRUE(autocom::readGuid("1D23188D-53FE-4C25-B032-DC70ACDBDC02", 36, id));
+    EXPECT_TRUE(autocom::Guid(id) == guid);
+    EXPECT_TRUE(autocom::Guid("{1D23188D-53FE-4C25-B032-DC70ACDBDC02}") == guid);
+    EXPECT_TRUE(autocom::Guid(L"{1D23188D-53FE-4C25-B032-DC70ACDBDC02}") == guid);
+
+    EXPECT_TRUE(!autocom::readGuid("{1D23188D-53FE-4C25-B032-DC70ACDBDC02)", 38, id));
+    EXPECT_TRUE(!autocom::readGuid("1D23188D-53FE-4C25-B032-DC70ACDBDC0:", 36, id));
+    EXPECT_TRUE(!autocom::readGuid("1D23188D-53FE-4C25-B032-DC70ACDBDC0g", 36, id));
+    EXPECT_THROW(autocom::Guid("{1D23188D-53FE-4C25-B032-DC70ACDBDC0g}"), std::invalid_argument);
+}
+
+
+TEST(GuidTest, Kernels)
+{
+    // round-trip pseudo-random GUIDs through both cases
+    uint32_t state = 12345;
+    for (size_t n = 0; n < 64; ++n) {
+        GUID id;
+        auto *bytes = reinterpret_cast<unsigned char*>(&id);
+        for (size_t i = 0; i < sizeof(GUID); ++i) {
+            state = state * 1103515245 + 12345;
+            bytes[i] = static_cast<unsigned char>(state >> 16);
+        }
+
+        char expected[37];
+        std::snprintf(expected, sizeof(expected), "%08lx-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+            static_cast<unsigned long>(id.Data1), id.Data2, id.Data3,
+            id.Data4[0], id.Data4[1], id.Data4[2], id.Data4[3],
+            id.Data4[4], id.Data4[5], id.Data4[6], id.Data4[7]);
+        char buffer[38];
+        ASSERT_EQ(autocom::formatGuid(id, buffer, autocom::GUID_LOWER), 36);
+        EXPECT_EQ(std::string(buffer, 36), expected);
+
+        GUID parsed;
+        ASSERT_TRUE(autocom::readGuid(buffer, 36, parsed));
+        EXPECT_TRUE(autocom::Guid(parsed) == autocom::Guid(id));
+        autocom::formatGuid(id, buffer, autocom::GUID_UPPER);
+        ASSERT_TRUE(autocom::readGuid(buffer, 36, parsed));
+        EXPECT_TRUE(autocom::Guid(parsed) == autocom::Guid(id));
+    }
+
+    // every character at every digit, against the constexpr parser
+    const std::string base = "1D23188D-53FE-4C25-B032-DC70ACDBDC02";
+    for (size_t position = 0; position < base.size(); ++position) {
+        if (base[position] == '-') {
+            continue;
+        }
+        for (int c = 1; c < 256; ++c) {
+            std::string string = base;
+            string[position] = static_cast<char>(c);
+            GUID id;
+            bool valid = std::isxdigit(c) != 0;
+            ASSERT_EQ(autocom::readGuid(string.data(), string.size(), id), valid) << position << " " << c;
+            if (valid) {
+                EXPECT_TRUE(autocom::Guid(id) == autocom::Guid(autocom::parseGuid(string.data(), string.size())));
+            }
+        }
+    }
+}
+
+
+TEST(GuidTest, Hash)
+{
+    using namespace autocom::literals;
+
+    constexpr auto first = "{00000000-0000-0000-C000-000000000046}"_guid;
+    constexpr auto second = "{00000000-0000-0000-C000-000000000047}"_guid;
+    constexpr auto third = "{00020400-0000-0000-C000-000000000046}"_guid;
+    static_assert(first.hash() != second.hash(), "Hash is computed at compile time.");
+    static_assert(first < second && second < third, "Ordered like strings.");
+
+    std::unordered_set<autocom::Guid> set = {first, second, third, first};
+    EXPECT_EQ(set.size(), 3);
+    EXPECT_EQ(std::hash<autocom::Guid>()(first), size_t(first.hash()));
+
+    std::map<autocom::Guid, int> map = {{third, 3}, {first, 1}, {second, 2}};
+    EXPECT_EQ(map.begin()->second, 1);
+    EXPECT_EQ(map.rbegin()->second, 3);
+}
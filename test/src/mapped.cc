@@ -0,0 +1,160 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Memory-mapped SafeArray test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace com = autocom;
+
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Read file into a string.
+ */
+std::string readFile(const std::string &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+
+/** \brief Replace file with `bytes`.
+ */
+void writeFile(const std::string &path,
+    const std::string &bytes)
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream.write(bytes.data(), bytes.size());
+}
+
+
+/** \brief Overwrite an integer at `offset`, in native byte order.
+ */
+template <typename T>
+void patch(std::string &bytes,
+    const size_t offset,
+    const T value)
+{
+    std::memcpy(&bytes[offset], &value, sizeof(value));
+}
+
+}   /* anonymous */
+
+
+// TESTS
+// -----
+
+
+TEST(MappedSafeArray, Spill)
+{
+    const std::string path = "mapped_spill.bin";
+    com::SafeArray<DOUBLE> array = {1.5, 2.5, 3.5, 4.5};
+    array.spill(path);
+
+    {
+        com::MappedSafeArray<DOUBLE> mapped(path);
+        EXPECT_TRUE(mapped.isOpen());
+        EXPECT_EQ(mapped.size(), 4);
+        EXPECT_EQ(mapped.dimensions(), 1);
+        EXPECT_EQ(mapped.front(), 1.5);
+        EXPECT_EQ(mapped.back(), 4.5);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(mapped.data()) % 64, 0);
+
+        std::vector<DOUBLE> copy(mapped.begin(), mapped.end());
+        EXPECT_EQ(copy, std::vector<DOUBLE>({1.5, 2.5, 3.5, 4.5}));
+
+        const com::SafeArrayView<DOUBLE> &view = mapped.view();
+        EXPECT_EQ(view.at(2), 3.5);
+        EXPECT_THROW(view.at(4), std::out_of_range);
+    }
+
+    EXPECT_THROW(com::MappedSafeArray<INT> {path}, std::invalid_argument);
+    std::remove(path.data());
+}
+
+
+TEST(MappedSafeArray, Invalid)
+{
+    const std::string path = "mapped_invalid.bin";
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream << "not a spill file, but long enough for a header";
+    }
+
+    EXPECT_THROW(com::MappedSafeArray<DOUBLE> {path}, std::runtime_error);
+    EXPECT_THROW(com::MappedSafeArray<DOUBLE>("missing.bin"), std::runtime_error);
+    std::remove(path.data());
+}
+
+
+TEST(MappedSafeArray, Truncated)
+{
+    const std::string path = "mapped_truncated.bin";
+    com::SafeArray<DOUBLE> array = {1.5, 2.5, 3.5, 4.5};
+    array.spill(path);
+    const std::string bytes = readFile(path);
+
+    // header without bounds, and bounds without all the data
+    writeFile(path, bytes.substr(0, 40));
+    EXPECT_THROW(com::MappedSafeArray<DOUBLE> {path}, std::runtime_error);
+    writeFile(path, bytes.substr(0, bytes.size() - 1));
+    EXPECT_THROW(com::MappedSafeArray<DOUBLE> {path}, std::runtime_error);
+
+    writeFile(path, bytes);
+    EXPECT_EQ(com::MappedSafeArray<DOUBLE>(path).size(), 4);
+    std::remove(path.data());
+}
+
+
+TEST(MappedSafeArray, OversizedCount)
+{
+    const std::string path = "mapped_oversized.bin";
+    com::SafeArray<DOUBLE> array = {1.5, 2.5, 3.5, 4.5};
+    array.spill(path);
+    std::string bytes = readFile(path);
+
+    // count * element wraps around to zero
+    patch(bytes, 14, uint16_t(2));
+    patch(bytes, 32, uint64_t(1) << 61);
+    patch(bytes, 40, uint32_t(1) << 31);
+    patch(bytes, 48, uint32_t(1) << 30);
+    writeFile(path, bytes);
+    EXPECT_THROW(com::MappedSafeArray<DOUBLE> {path}, std::runtime_error);
+
+    // product of the bounds overflows
+    patch(bytes, 14, uint16_t(3));
+    patch(bytes, 48, uint32_t(1) << 31);
+    patch(bytes, 56, uint32_t(1) << 31);
+    writeFile(path, bytes);
+    EXPECT_THROW(com::MappedSafeArray<DOUBLE> {path}, std::runtime_error);
+
+    // element count too large for the file
+    patch(bytes, 14, uint16_t(1));
+    patch(bytes, 32, uint64_t(1000));
+    patch(bytes, 40, uint32_t(1000));
+    writeFile(path, bytes);
+    EXPECT_THROW(com::MappedSafeArray<DOUBLE> {path}, std::runtime_error);
+    std::remove(path.data());
+}
+
+
+TEST(MappedSafeArray, Pointers)
+{
+    com::SafeArray<BSTR> array = {SysAllocString(L"value")};
+    EXPECT_THROW(array.spill("mapped_pointers.bin"), std::invalid_argument);
+}
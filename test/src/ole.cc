@@ -0,0 +1,272 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Portable OLE Automation runtime test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace com = autocom;
+
+
+namespace
+{
+// HELPERS
+// -------
+
+
+std::wstring changeToString(VARIANT &variant,
+    const USHORT flags = 0)
+{
+    VARIANT result;
+    VariantInit(&result);
+    EXPECT_EQ(VariantChangeType(&result, &variant, flags, VT_BSTR), S_OK);
+    std::wstring string(result.bstrVal, SysStringLen(result.bstrVal));
+    VariantClear(&result);
+
+    return string;
+}
+
+
+VARIANT fromString(const wchar_t *string)
+{
+    VARIANT variant;
+    variant.vt = VT_BSTR;
+    variant.bstrVal = SysAllocString(string);
+    return variant;
+}
+
+}   /* anonymous */
+
+// TESTS
+// -----
+
+
+TEST(Ole, Layout)
+{
+    EXPECT_EQ(sizeof(GUID), 16);
+    EXPECT_EQ(sizeof(DECIMAL), 16);
+    EXPECT_EQ(sizeof(CY), 8);
+    EXPECT_EQ(sizeof(VARIANT), 8 + 2 * sizeof(void*));
+    EXPECT_EQ(offsetof(VARIANT, lVal), 8);
+}
+
+
+TEST(Ole, Bstr)
+{
+    BSTR bstr = SysAllocString(L"data");
+    EXPECT_EQ(SysStringLen(bstr), 4);
+    EXPECT_EQ(SysStringByteLen(bstr), 4 * sizeof(OLECHAR));
+    EXPECT_EQ(reinterpret_cast<uint32_t*>(bstr)[-1], 4 * sizeof(OLECHAR));
+    EXPECT_EQ(bstr[4], 0);
+
+    EXPECT_TRUE(SysReAllocStringLen(&bstr, L"longer data", 11));
+    EXPECT_EQ(std::wstring(bstr), L"longer data");
+    SysFreeString(bstr);
+
+    BSTR bytes = SysAllocStringByteLen("abc", 3);
+    EXPECT_EQ(SysStringByteLen(bytes), 3);
+    EXPECT_EQ(std::memcmp(bytes, "abc", 4), 0);
+    SysFreeString(bytes);
+
+    EXPECT_EQ(SysStringLen(nullptr), 0);
+    SysFreeString(nullptr);
+}
+
+
+TEST(Ole, BstrCache)
+{
+    BSTR first = SysAllocString(L"cached");
+    SysFreeString(first);
+    BSTR second = SysAllocString(L"reused");
+    EXPECT_EQ(first, second);
+    SysFreeString(second);
+}
+
+
+TEST(Ole, SafeArrayBounds)
+{
+    SAFEARRAYBOUND bounds[2] = {{3, 0}, {4, 1}};
+    SAFEARRAY *array = SafeArrayCreate(VT_I4, 2, bounds);
+    ASSERT_NE(array, nullptr);
+    EXPECT_EQ(SafeArrayGetDim(array), 2);
+    EXPECT_EQ(SafeArrayGetElemsize(array), 4);
+
+    LONG lower, upper;
+    EXPECT_EQ(SafeArrayGetLBound(array, 2, &lower), S_OK);
+    EXPECT_EQ(SafeArrayGetUBound(array, 2, &upper), S_OK);
+    EXPECT_EQ(lower, 1);
+    EXPECT_EQ(upper, 4);
+    EXPECT_EQ(SafeArrayGetUBound(array, 3, &upper), DISP_E_BADINDEX);
+
+    LONG indices[2] = {1, 2};
+    LONG value = 7;
+    EXPECT_EQ(SafeArrayPutElement(array, indices, &value), S_OK);
+    LONG *data;
+    EXPECT_EQ(SafeArrayAccessData(array, (void**) &data), S_OK);
+    EXPECT_EQ(data[1 + 3 * 1], 7);
+    EXPECT_EQ(SafeArrayDestroy(array), DISP_E_ARRAYISLOCKED);
+    EXPECT_EQ(SafeArrayUnaccessData(array), S_OK);
+
+    indices[1] = 5;
+    EXPECT_EQ(SafeArrayGetElement(array, indices, &value), DISP_E_BADINDEX);
+
+    VARTYPE vt;
+    EXPECT_EQ(SafeArrayGetVartype(array, &vt), S_OK);
+    EXPECT_EQ(vt, VT_I4);
+    EXPECT_EQ(SafeArrayDestroy(array), S_OK);
+}
+
+
+TEST(Ole, SafeArrayCopy)
+{
+    SAFEARRAY *array = SafeArrayCreateVector(VT_BSTR, 0, 2);
+    ASSERT_NE(array, nullptr);
+    LONG index = 1;
+    BSTR bstr = SysAllocString(L"value");
+    EXPECT_EQ(SafeArrayPutElement(array, &index, bstr), S_OK);
+    SysFreeString(bstr);
+
+    SAFEARRAY *copy;
+    EXPECT_EQ(SafeArrayCopy(array, &copy), S_OK);
+    EXPECT_EQ(SafeArrayDestroy(array), S_OK);
+
+    BSTR value;
+    EXPECT_EQ(SafeArrayGetElement(copy, &index, &value), S_OK);
+    EXPECT_EQ(std::wstring(value), L"value");
+    SysFreeString(value);
+
+    SAFEARRAYBOUND bound = {4, 0};
+    EXPECT_EQ(SafeArrayRedim(copy, &bound), S_OK);
+    EXPECT_EQ(copy->rgsabound[0].cElements, 4);
+    index = 3;
+    EXPECT_EQ(SafeArrayGetElement(copy, &index, &value), S_OK);
+    EXPECT_EQ(value, nullptr);
+    EXPECT_EQ(SafeArrayDestroy(copy), S_OK);
+}
+
+
+TEST(Ole, ChangeTypeNumeric)
+{
+    VARIANT variant, result;
+    VariantInit(&result);
+
+    variant.vt = VT_R8;
+    variant.dblVal = 2.5;
+    EXPECT_EQ(VariantChangeType(&result, &variant, 0, VT_I4), S_OK);
+    EXPECT_EQ(result.lVal, 2);
+    variant.dblVal = 3.5;
+    EXPECT_EQ(VariantChangeType(&result, &variant, 0, VT_I4), S_OK);
+    EXPECT_EQ(result.lVal, 4);
+
+    variant.vt = VT_I4;
+    variant.lVal = 300;
+    EXPECT_EQ(VariantChangeType(&result, &variant, 0, VT_UI1), DISP_E_OVERFLOW);
+    EXPECT_EQ(VariantChangeType(&result, &variant, 0, VT_BOOL), S_OK);
+    EXPECT_EQ(result.boolVal, VARIANT_TRUE);
+    EXPECT_EQ(VariantChangeType(&result, &variant, 0, VT_CY), S_OK);
+    EXPECT_EQ(result.cyVal.int64, 3000000);
+
+    variant.vt = VT_NULL;
+    EXPECT_EQ(VariantChangeType(&result, &variant, 0, VT_I4), DISP_E_TYPEMISMATCH);
+}
+
+
+TEST(Ole, ChangeTypeString)
+{
+    VARIANT variant;
+    variant.vt = VT_I4;
+    variant.lVal = -42;
+    EXPECT_EQ(changeToString(variant), L"-42");
+
+    variant.vt = VT_BOOL;
+    variant.boolVal = VARIANT_TRUE;
+    EXPECT_EQ(changeToString(variant), L"-1");
+    EXPECT_EQ(changeToString(variant, VARIANT_ALPHABOOL), L"True");
+
+    variant.vt = VT_R8;
+    variant.dblVal = 0.1;
+    EXPECT_EQ(changeToString(variant), L"0.1");
+
+    variant.vt = VT_DATE;
+    variant.date = 36526.5;
+    EXPECT_EQ(changeToString(variant), L"2000-01-01 12:00:00");
+
+    // in-place conversion from strings
+    variant = fromString(L" 12.50 ");
+    EXPECT_EQ(VariantChangeType(&variant, &variant, 0, VT_DECIMAL), S_OK);
+    EXPECT_EQ(variant.vt, VT_DECIMAL);
+    EXPECT_EQ(variant.decVal.scale, 2);
+    EXPECT_EQ(variant.decVal.Lo64, 1250);
+
+    variant = fromString(L"true");
+    EXPECT_EQ(VariantChangeType(&variant, &variant, 0, VT_BOOL), S_OK);
+    EXPECT_EQ(variant.boolVal, VARIANT_TRUE);
+
+    variant = fromString(L"1/1/2000");
+    EXPECT_EQ(VariantChangeType(&variant, &variant, 0, VT_DATE), S_OK);
+    EXPECT_EQ(variant.date, 36526.0);
+
+    variant = fromString(L"text");
+    EXPECT_EQ(VariantChangeType(&variant, &variant, 0, VT_I4), DISP_E_TYPEMISMATCH);
+    EXPECT_EQ(variant.vt, VT_BSTR);
+    VariantClear(&variant);
+}
+
+
+TEST(Ole, VariantCopy)
+{
+    VARIANT source = fromString(L"copy");
+    VARIANT destination;
+    VariantInit(&destination);
+    EXPECT_EQ(VariantCopy(&destination, &source), S_OK);
+    EXPECT_NE(destination.bstrVal, source.bstrVal);
+    EXPECT_EQ(std::wstring(destination.bstrVal), L"copy");
+
+    VARIANT reference;
+    reference.vt = VT_BSTR | VT_BYREF;
+    reference.pbstrVal = &source.bstrVal;
+    EXPECT_EQ(VariantCopyInd(&destination, &reference), S_OK);
+    EXPECT_EQ(destination.vt, VT_BSTR);
+    EXPECT_NE(destination.bstrVal, source.bstrVal);
+
+    VariantClear(&destination);
+    VariantClear(&source);
+    EXPECT_EQ(source.vt, VT_EMPTY);
+}
+
+
+TEST(Ole, Guid)
+{
+    OLECHAR string[39];
+    EXPECT_EQ(StringFromGUID2(IID_IDispatch, string, 39), 39);
+    EXPECT_EQ(std::wstring(string), L"{00020400-0000-0000-C000-000000000046}");
+
+    IID iid;
+    EXPECT_EQ(IIDFromString(string, &iid), S_OK);
+    EXPECT_TRUE(IsEqualIID(iid, IID_IDispatch));
+    EXPECT_EQ(CLSIDFromString(L"{bad}", &iid), CO_E_CLASSSTRING);
+
+    CLSID clsid;
+    EXPECT_EQ(CLSIDFromProgID(L"VBScript.RegExp", &clsid), CO_E_CLASSSTRING);
+}
+
+
+TEST(Ole, Initialize)
+{
+    std::thread thread([]() {
+        EXPECT_EQ(CoInitializeEx(nullptr, COINIT_MULTITHREADED), S_OK);
+        EXPECT_EQ(CoInitializeEx(nullptr, COINIT_MULTITHREADED), S_FALSE);
+        EXPECT_EQ(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED), RPC_E_CHANGED_MODE);
+        CoUninitialize();
+        CoUninitialize();
+    });
+    thread.join();
+}
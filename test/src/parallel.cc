@@ -0,0 +1,158 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Parallel algorithm test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace com = autocom;
+
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Check typed kernels against the generic scalar kernels.
+ *
+ *  Counts cover empty inputs, partial vectors and vector tails, and
+ *  values repeat so the first maximum must be kept.
+ */
+template <typename T>
+void checkKernels()
+{
+    namespace kernel = com::parallel::kernel;
+
+    for (size_t count = 0; count < 70; ++count) {
+        std::vector<T> data(count);
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = static_cast<T>(static_cast<int>((i * 37) % 23) - 11);
+        }
+
+        EXPECT_EQ(kernel::sum(data.data(), count), kernel::sum<T>(data.data(), count)) << count;
+        EXPECT_EQ(kernel::argmax(data.data(), count), kernel::argmax<T>(data.data(), count)) << count;
+        if (count) {
+            EXPECT_EQ(kernel::minimum(data.data(), count), kernel::minimum<T>(data.data(), count)) << count;
+            EXPECT_EQ(kernel::maximum(data.data(), count), kernel::maximum<T>(data.data(), count)) << count;
+        }
+    }
+}
+
+}   /* anonymous */
+
+
+// TESTS
+// -----
+
+
+TEST(ThreadPool, Run)
+{
+    com::parallel::ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+
+    std::vector<std::atomic<int>> hits(1000);
+    for (int i = 0; i < 10; ++i) {
+        pool.run(hits.size(), [&](size_t index) {
+            ++hits[index];
+        });
+    }
+    for (const auto &hit: hits) {
+        EXPECT_EQ(hit, 10);
+    }
+
+    EXPECT_THROW(pool.run(100, [](size_t index) {
+        if (index == 50) {
+            throw std::runtime_error("");
+        }
+    }), std::runtime_error);
+}
+
+
+TEST(Parallel, Chunks)
+{
+    auto *data = reinterpret_cast<const void*>(uintptr_t(0x1008));
+    auto list = com::parallel::chunks(data, 100000, sizeof(DOUBLE), 8);
+    ASSERT_GT(list.size(), 1);
+    EXPECT_EQ(list.front().begin, 0);
+    EXPECT_EQ(list.back().end, 100000);
+    for (size_t i = 1; i < list.size(); ++i) {
+        EXPECT_EQ(list[i].begin, list[i-1].end);
+        EXPECT_EQ((0x1008 + list[i].begin * sizeof(DOUBLE)) % 64, 0);
+    }
+
+    EXPECT_EQ(com::parallel::chunks(data, 10, sizeof(DOUBLE), 8).size(), 1);
+}
+
+
+TEST(Parallel, Algorithms)
+{
+    com::parallel::ThreadPool pool(4);
+    std::vector<INT> values(100003);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = INT(i % 1000) - 500;
+    }
+    com::SafeArray<INT> array(values);
+
+    EXPECT_EQ(com::parallel::sum(array, pool), -51497);
+    EXPECT_EQ(com::parallel::minimum(array, pool), -500);
+    EXPECT_EQ(com::parallel::maximum(array, pool), 499);
+    EXPECT_EQ(com::parallel::argmax(array, pool), 999);
+    EXPECT_EQ(com::parallel::reduce(array, INT(0), [](INT x, INT y) {
+        return x + y;
+    }, pool), -51497);
+
+    com::parallel::transform(array, [](INT x) {
+        return x * 2;
+    }, pool);
+    EXPECT_EQ(com::parallel::sum(array, pool), -102994);
+
+    com::SafeArray<DOUBLE> output(std::vector<DOUBLE>(values.size()));
+    com::parallel::transform(array, output, [](INT x) {
+        return DOUBLE(x) / 2;
+    }, pool);
+    EXPECT_EQ(com::parallel::sum(output, pool), -51497.0);
+
+    std::atomic<size_t> count(0);
+    com::parallel::for_each(com::SafeArrayView<DOUBLE>(output), [&](DOUBLE) {
+        ++count;
+    }, pool);
+    EXPECT_EQ(count, values.size());
+}
+
+
+TEST(Parallel, Kernels)
+{
+    checkKernels<double>();
+    checkKernels<float>();
+    checkKernels<int32_t>();
+}
+
+
+TEST(Parallel, NaN)
+{
+    const DOUBLE nan = std::numeric_limits<DOUBLE>::quiet_NaN();
+    com::SafeArray<DOUBLE> array = {nan, 1.0, 7.0, nan, 7.0, -2.0, 3.0, nan, 5.0};
+    EXPECT_EQ(com::parallel::argmax(array), 2);
+    EXPECT_EQ(com::parallel::maximum(array), 7.0);
+    EXPECT_EQ(com::parallel::minimum(array), -2.0);
+    EXPECT_TRUE(std::isnan(com::parallel::sum(array)));
+
+    com::SafeArray<DOUBLE> empty = {nan, nan};
+    EXPECT_EQ(com::parallel::argmax(empty), empty.size());
+
+    // across several chunks
+    com::parallel::ThreadPool pool(4);
+    com::SafeArray<DOUBLE> large(std::vector<DOUBLE>(1 << 16, nan));
+    EXPECT_EQ(com::parallel::argmax(large, pool), large.size());
+    EXPECT_TRUE(std::isnan(com::parallel::maximum(empty)));
+}
@@ -0,0 +1,203 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Object pool test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace com = autocom;
+
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Server which counts live instances and uses.
+ */
+struct Server
+{
+    static std::atomic<int> instances;
+    int calls = 0;
+
+    Server()
+    {
+        ++instances;
+    }
+
+    ~Server()
+    {
+        --instances;
+    }
+};
+
+std::atomic<int> Server::instances(0);
+
+}   /* anonymous */
+
+// TESTS
+// -----
+
+
+TEST(ObjectPool, Reuse)
+{
+    {
+        com::ObjectPool<Server> pool;
+        Server *server;
+        {
+            auto lease = pool.acquire();
+            ASSERT_TRUE(bool(lease));
+            lease->calls++;
+            server = lease.get();
+        }
+        auto lease = pool.acquire();
+        EXPECT_EQ(lease.get(), server);
+        EXPECT_EQ(lease->calls, 1);
+        EXPECT_EQ(Server::instances, 1);
+
+        // broken servers are not returned
+        lease.discard();
+        EXPECT_TRUE(!lease);
+        EXPECT_EQ(Server::instances, 0);
+
+        auto other = pool.acquire();
+        EXPECT_EQ(Server::instances, 1);
+        other.release();
+        pool.clear();
+        EXPECT_EQ(Server::instances, 0);
+        EXPECT_EQ(pool.statistics().acquisitions, 3);
+    }
+    EXPECT_EQ(Server::instances, 0);
+}
+
+
+TEST(ObjectPool, Reset)
+{
+    com::ObjectPool<Server> pool([]() {
+        return std::unique_ptr<Server>(new Server);
+    }, 0, com::POOL_SHARED, [](Server &server) {
+        if (server.calls > 1) {
+            throw std::runtime_error("Cannot reset server.");
+        }
+        server.calls = 0;
+    });
+
+    {
+        auto lease = pool.acquire();
+        lease->calls = 1;
+    }
+    {
+        auto lease = pool.acquire();
+        EXPECT_EQ(lease->calls, 0);
+        lease->calls = 2;
+    }
+    EXPECT_EQ(pool.statistics().created, 0);
+}
+
+
+TEST(ObjectPool, Capacity)
+{
+    com::ObjectPool<Server> pool(1);
+    auto lease = pool.acquire();
+    auto empty = pool.acquire(std::chrono::milliseconds(10));
+    EXPECT_TRUE(!empty);
+
+    std::thread thread([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        lease.release();
+    });
+    auto waited = pool.acquire();
+    thread.join();
+    EXPECT_TRUE(bool(waited));
+
+    auto statistics = pool.statistics();
+    EXPECT_EQ(statistics.created, 1);
+    EXPECT_EQ(statistics.leased, 1);
+    EXPECT_EQ(statistics.waits, 1);
+    EXPECT_EQ(statistics.timeouts, 1);
+    EXPECT_TRUE(statistics.maxWaitSeconds > 0);
+    EXPECT_TRUE(statistics.utilization > 0.5);
+}
+
+
+TEST(ObjectPool, Affinity)
+{
+    com::ObjectPool<Server> pool(0, com::POOL_THREAD);
+    Server *server;
+    {
+        auto lease = pool.acquire();
+        server = lease.get();
+    }
+
+    Server *other;
+    std::thread thread([&]() {
+        {
+            auto lease = pool.acquire();
+            other = lease.get();
+        }
+        pool.clear();
+    });
+    thread.join();
+
+    EXPECT_TRUE(other != server);
+    EXPECT_EQ(pool.acquire().get(), server);
+    EXPECT_EQ(pool.statistics().created, 1);
+}
+
+
+TEST(ObjectPool, AffinityCapacity)
+{
+    // a capped pool would block on the idle instance of the other thread
+    EXPECT_THROW(com::ObjectPool<Server>(1, com::POOL_THREAD), std::invalid_argument);
+
+    com::ObjectPool<Server> pool(0, com::POOL_THREAD);
+    std::thread thread([&]() {
+        pool.acquire();
+    });
+    thread.join();
+
+    auto lease = pool.acquire(std::chrono::milliseconds(10));
+    EXPECT_TRUE(bool(lease));
+    auto statistics = pool.statistics();
+    EXPECT_EQ(statistics.created, 2);
+    EXPECT_EQ(statistics.idle, 1);
+    EXPECT_EQ(statistics.timeouts, 0);
+}
+
+
+TEST(ObjectPool, Concurrent)
+{
+    com::ObjectPool<Server> pool(2);
+    std::atomic<int> active(0);
+    std::atomic<int> failures(0);
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; ++i) {
+        threads.emplace_back([&]() {
+            for (size_t j = 0; j < 1000; ++j) {
+                auto lease = pool.acquire();
+                if (++active > 2) {
+                    ++failures;
+                }
+                lease->calls++;
+                --active;
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(failures, 0);
+    EXPECT_TRUE(pool.statistics().created <= 2);
+    EXPECT_EQ(pool.statistics().acquisitions, 4000);
+}
@@ -0,0 +1,140 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief ProgID resolution cache test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace com = autocom;
+
+
+// HELPERS
+// -------
+
+
+/** \brief In-memory resolver which counts backend lookups.
+ */
+struct MemoryResolver: com::ProgIdResolver
+{
+    std::atomic<int> calls;
+
+    MemoryResolver():
+        calls(0)
+    {}
+
+    virtual HRESULT resolve(const std::wstring &progid,
+        GUID &clsid) override
+    {
+        ++calls;
+        if (progid == L"VBScript.RegExp") {
+            clsid = com::parseGuid("{3F4DACA4-160D-11D2-A8E9-00104B365C9F}", 38);
+            return S_OK;
+        }
+        return E_FAIL;
+    }
+};
+
+// TESTS
+// -----
+
+
+TEST(ProgIdCache, Resolve)
+{
+    auto resolver = std::make_shared<MemoryResolver>();
+    com::ProgIdCache cache(resolver);
+
+    GUID clsid;
+    EXPECT_EQ(cache.resolve(L"VBScript.RegExp", clsid), S_OK);
+    EXPECT_EQ(cache.resolve(L"VBScript.RegExp", clsid), S_OK);
+    EXPECT_EQ(com::Guid(clsid).uuid(), "3F4DACA4-160D-11D2-A8E9-00104B365C9F");
+    EXPECT_EQ(resolver->calls, 1);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.misses(), 1);
+
+    // failures are cached
+    EXPECT_EQ(cache.resolve(L"Missing.Server", clsid), E_FAIL);
+    EXPECT_EQ(cache.resolve(L"Missing.Server", clsid), E_FAIL);
+    EXPECT_EQ(resolver->calls, 2);
+    EXPECT_EQ(cache.size(), 2);
+}
+
+
+TEST(ProgIdCache, Expire)
+{
+    auto resolver = std::make_shared<MemoryResolver>();
+    com::ProgIdCache cache(resolver, std::chrono::minutes(10), std::chrono::seconds(0));
+
+    GUID clsid;
+    cache.resolve(L"Missing.Server", clsid);
+    cache.resolve(L"Missing.Server", clsid);
+    EXPECT_EQ(resolver->calls, 2);
+
+    cache.resolve(L"VBScript.RegExp", clsid);
+    cache.invalidate(L"VBScript.RegExp");
+    cache.resolve(L"VBScript.RegExp", clsid);
+    EXPECT_EQ(resolver->calls, 4);
+
+    cache.clear();
+    cache.resolve(L"VBScript.RegExp", clsid);
+    EXPECT_EQ(resolver->calls, 5);
+
+    // new backends do not see stale entries
+    auto other = std::make_shared<MemoryResolver>();
+    cache.resolver(other);
+    cache.resolve(L"VBScript.RegExp", clsid);
+    EXPECT_EQ(other->calls, 1);
+}
+
+
+TEST(ProgIdCache, Concurrent)
+{
+    auto resolver = std::make_shared<MemoryResolver>();
+    com::ProgIdCache cache(resolver);
+
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; ++i) {
+        threads.emplace_back([&]() {
+            GUID clsid;
+            for (size_t j = 0; j < 10000; ++j) {
+                if (cache.resolve(L"VBScript.RegExp", clsid) != S_OK || clsid.Data1 != 0x3F4DACA4) {
+                    ++failures;
+                }
+                if (j % 1000 == 0) {
+                    cache.invalidate(L"VBScript.RegExp");
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(failures, 0);
+    EXPECT_EQ(cache.hits() + cache.misses(), 40000);
+}
+
+
+TEST(ProgIdCache, Guid)
+{
+    auto resolver = std::make_shared<MemoryResolver>();
+    auto &cache = com::ProgIdCache::global();
+    cache.resolver(resolver);
+
+    EXPECT_EQ(com::Guid(L"VBScript.RegExp").get().Data1, 0x3F4DACA4);
+
+    // unknown ProgIDs give a null GUID, also from the negative entry
+    EXPECT_EQ(com::Guid(L"Missing.ProgId"), com::Guid(GUID_NULL));
+    EXPECT_EQ(com::Guid(L"Missing.ProgId"), com::Guid(GUID_NULL));
+    EXPECT_EQ(resolver->calls, 2);
+
+    cache.resolver(std::make_shared<com::RegistryResolver>());
+}
@@ -0,0 +1,331 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief COM call result test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace com = autocom;
+
+
+namespace
+{
+// OBJECTS
+// -------
+
+
+/** \brief Server with a property that rejects some values.
+ */
+class Counter: public com::DispatchImpl<Counter>
+{
+protected:
+    LONG count = 0;
+
+    LONG add(LONG left, LONG right)
+    {
+        return left + right;
+    }
+
+    BSTR name() const
+    {
+        return SysAllocString(L"Counter");
+    }
+
+    LONG getCount() const
+    {
+        return count;
+    }
+
+    void setCount(LONG value)
+    {
+        if (value < 0) {
+            throw std::invalid_argument("Count cannot be negative.");
+        }
+        count = value;
+    }
+
+public:
+    AUTOCOM_DISPATCH_BEGIN(Counter)
+        AUTOCOM_DISPATCH_METHOD(L"Add", 1, &Counter::add)
+        AUTOCOM_DISPATCH_METHOD(L"Name", 2, &Counter::name)
+        AUTOCOM_DISPATCH_GET(L"Count", 3, &Counter::getCount)
+        AUTOCOM_DISPATCH_PUT(L"Count", 3, &Counter::setCount)
+    AUTOCOM_DISPATCH_END()
+};
+
+
+/** \brief Counter which reports failures through error objects.
+ */
+class ReportingCounter: public Counter,
+    public ISupportErrorInfo
+{
+public:
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override
+    {
+        if (ppv && IsEqualIID(iid, IID_ISupportErrorInfo)) {
+            *ppv = static_cast<ISupportErrorInfo*>(this);
+            AddRef();
+            return S_OK;
+        }
+        return Counter::QueryInterface(iid, ppv);
+    }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return Counter::AddRef();
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release() override
+    {
+        return Counter::Release();
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE InterfaceSupportsErrorInfo(REFIID iid) override
+    {
+        return IsEqualIID(iid, IID_IDispatch) ? S_OK : S_FALSE;
+    }
+};
+
+
+/** \brief Error object left by a server for the calling thread.
+ */
+class FakeErrorInfo: public IErrorInfo
+{
+protected:
+    ULONG references = 1;
+
+public:
+    virtual ~FakeErrorInfo() = default;
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override
+    {
+        return E_NOINTERFACE;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++references;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG count = --references;
+        if (count == 0) {
+            delete this;
+        }
+        return count;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetGUID(GUID *guid) override
+    {
+        *guid = IID_NULL;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetSource(BSTR *source) override
+    {
+        *source = SysAllocString(L"Fake.Server");
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetDescription(BSTR *description) override
+    {
+        *description = SysAllocString(L"Member is unavailable.");
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetHelpFile(BSTR *file) override
+    {
+        *file = nullptr;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetHelpContext(DWORD *context) override
+    {
+        *context = 0;
+        return S_OK;
+    }
+};
+
+}   /* anonymous */
+
+
+// TESTS
+// -----
+
+
+TEST(Result, Value)
+{
+    com::Result<std::string> result(S_OK, std::string("value"));
+    EXPECT_TRUE(bool(result));
+    EXPECT_TRUE(result.succeeded());
+    EXPECT_EQ(result.code(), S_OK);
+    EXPECT_EQ(result.value(), "value");
+    EXPECT_EQ(result.valueOr("other"), "value");
+
+    auto moved = std::move(result).value();
+    EXPECT_EQ(moved, "value");
+}
+
+
+TEST(Result, Failure)
+{
+    com::Result<LONG> result(E_NOTIMPL);
+    EXPECT_FALSE(bool(result));
+    EXPECT_TRUE(result.failed());
+    EXPECT_EQ(result.code(), E_NOTIMPL);
+    EXPECT_EQ(result.valueOr(5), 5);
+    EXPECT_THROW(result.value(), com::ComResultError);
+
+    try {
+        result.value();
+    } catch (com::ComResultError &error) {
+        EXPECT_EQ(error.code(), E_NOTIMPL);
+    }
+
+    // default results have failed
+    EXPECT_TRUE(com::Result<LONG>().failed());
+}
+
+
+TEST(Result, Void)
+{
+    com::Result<void> success(S_FALSE);
+    EXPECT_TRUE(success.succeeded());
+    success.value();
+
+    com::Result<void> failure(E_FAIL);
+    EXPECT_TRUE(failure.failed());
+    EXPECT_THROW(failure.value(), com::ComResultError);
+}
+
+
+TEST(Result, Bstr)
+{
+    // wrappers move output BSTRs without copying
+    BSTR output = SysAllocString(L"name");
+    com::Result<com::Bstr> result(S_OK, com::Bstr(std::move(output)));
+    EXPECT_EQ(output, nullptr);
+    EXPECT_EQ(std::string(result.value()), "name");
+}
+
+
+TEST(DispatchResult, Value)
+{
+    com::DispatchBase dispatch(new Counter);
+
+    auto sum = dispatch.tryMethod<LONG>(L"Add", 2, 3);
+    EXPECT_TRUE(bool(sum));
+    EXPECT_EQ(sum.value(), 5);
+    EXPECT_EQ(sum.member(), 1);
+
+    // results are variants by default, and converted otherwise
+    auto name = dispatch.tryMethod(2);
+    EXPECT_EQ(name.value().vt, VT_BSTR);
+    EXPECT_EQ(std::wstring(name.value().bstrVal), L"Counter");
+    EXPECT_EQ(dispatch.tryGet<DOUBLE>(L"Count").value(), 0.0);
+
+    EXPECT_TRUE(dispatch.tryPut(L"Count", 4).succeeded());
+    EXPECT_EQ(dispatch.tryGet<LONG>(3).valueOr(0), 4);
+}
+
+
+TEST(DispatchResult, Failure)
+{
+    com::DispatchBase dispatch(new Counter);
+
+    auto missing = dispatch.tryGet<LONG>(42);
+    EXPECT_EQ(missing.code(), DISP_E_MEMBERNOTFOUND);
+    EXPECT_EQ(missing.member(), 42);
+    EXPECT_EQ(missing.valueOr(-1), -1);
+    EXPECT_EQ(missing.description(), L"");
+    EXPECT_THROW(missing.value(), com::ComResultError);
+
+    auto unknown = dispatch.tryGet(L"Total");
+    EXPECT_EQ(unknown.code(), DISP_E_UNKNOWNNAME);
+    EXPECT_EQ(unknown.member(), DISPID_UNKNOWN);
+
+    EXPECT_EQ(dispatch.tryMethod(L"Add", 1).code(), DISP_E_BADPARAMCOUNT);
+
+    // bad arguments are reported in DISPPARAMS order
+    auto argument = dispatch.tryMethod<LONG>(L"Add", L"one", 1);
+    EXPECT_EQ(argument.code(), DISP_E_TYPEMISMATCH);
+    EXPECT_EQ(argument.argument(), 1);
+
+    // results that cannot be converted fail
+    EXPECT_EQ(dispatch.tryMethod<LONG>(L"Name").code(), DISP_E_TYPEMISMATCH);
+}
+
+
+TEST(DispatchResult, Exception)
+{
+    com::DispatchBase dispatch(new Counter);
+
+    auto result = dispatch.tryPut(L"Count", -1);
+    EXPECT_EQ(result.code(), DISP_E_EXCEPTION);
+    EXPECT_EQ(result.member(), 3);
+    EXPECT_EQ(result.source(), L"Count");
+    EXPECT_EQ(result.description(), L"Count cannot be negative.");
+
+    // copies own their exception strings
+    com::DispatchResult<void> copy(result);
+    result = com::DispatchResult<void>();
+    EXPECT_EQ(copy.description(), L"Count cannot be negative.");
+    EXPECT_EQ(result.description(), L"");
+
+    com::DispatchResult<void> moved(std::move(copy));
+    EXPECT_EQ(moved.source(), L"Count");
+}
+
+
+TEST(DispatchResult, ErrorInfo)
+{
+    com::DispatchBase dispatch(new ReportingCounter);
+
+    FakeErrorInfo *info = new FakeErrorInfo;
+    SetErrorInfo(0, info);
+    auto result = dispatch.tryGet<LONG>(42);
+    EXPECT_TRUE(result.failed());
+    EXPECT_EQ(result.source(), L"Fake.Server");
+    EXPECT_EQ(result.description(), L"Member is unavailable.");
+
+    // the error object is taken from the thread
+    IErrorInfo *current = nullptr;
+    EXPECT_EQ(GetErrorInfo(0, &current), S_FALSE);
+
+    result = com::DispatchResult<LONG>();
+    EXPECT_EQ(info->Release(), 0);
+}
+
+
+TEST(DispatchResult, StaleErrorInfo)
+{
+    // servers without ISupportErrorInfo never report error objects
+    com::DispatchBase counter(new Counter);
+    FakeErrorInfo *info = new FakeErrorInfo;
+    SetErrorInfo(0, info);
+    auto missing = counter.tryGet<LONG>(42);
+    EXPECT_EQ(missing.code(), DISP_E_MEMBERNOTFOUND);
+    EXPECT_EQ(missing.description(), L"");
+
+    // exceptions are described by EXCEPINFO alone
+    com::DispatchBase reporting(new ReportingCounter);
+    auto negative = reporting.tryPut(L"Count", -1);
+    EXPECT_EQ(negative.code(), DISP_E_EXCEPTION);
+    EXPECT_EQ(negative.description(), L"Count cannot be negative.");
+
+    // the stale error object is left on the thread
+    IErrorInfo *current = nullptr;
+    ASSERT_EQ(GetErrorInfo(0, &current), S_OK);
+    EXPECT_EQ(current, info);
+    current->Release();
+    EXPECT_EQ(info->Release(), 0);
+}
@@ -51,5 +51,72 @@ TEST(SafeArray, Stl)
 TEST(SafeArray, Type)
 {
      EXPECT_EQ(com::SafeArray<X>::vt, VT_RECORD);
+#if !defined(AUTOCOM_LONG_IS_INT)
      EXPECT_EQ(com::SafeArray<INT>::vt, VT_INT);
+#endif          // AUTOCOM_LONG_IS_INT
+}
+
+
+TEST(SafeArrayView, Stl)
+{
+    com::SafeArray<INT> array = {3, 4, 5};
+    com::SafeArrayView<INT> view(array);
+    EXPECT_EQ(view.size(), 3);
+    EXPECT_EQ(view.dimensions(), 1);
+    EXPECT_EQ(view.front(), 3);
+    EXPECT_EQ(view.back(), 5);
+    EXPECT_EQ(view.data(), array.data());
+    EXPECT_THROW(view.at(3), std::out_of_range);
+    EXPECT_THROW(com::SafeArrayView<DOUBLE>(array.array), std::invalid_argument);
+}
+
+
+TEST(SafeArray, Record)
+{
+    VARIANT variant;
+    variant.vt = VT_ARRAY | VT_I4;
+    variant.parray = SafeArrayCreateVector(VT_I4, 0, 3);
+    EXPECT_THROW(com::SafeArray<X> array(variant), std::invalid_argument);
+    EXPECT_EQ(variant.vt, VT_ARRAY | VT_I4);
+    VariantClear(&variant);
+}
+
+
+TEST(SafeArrayView, Column)
+{
+    struct Peak { DOUBLE mz; DOUBLE intensity; LONG charge; };
+    std::vector<Peak> peaks = {{100.5, 10.0, 1}, {200.5, 20.0, 2}, {300.5, 5.0, 3}};
+    com::SafeArrayView<Peak> view(peaks.data(), {com::SafeArrayBound(peaks.size())});
+
+    auto mz = view.column(&Peak::mz);
+    EXPECT_EQ(mz.size(), 3);
+    EXPECT_EQ(mz.stride(), sizeof(Peak));
+    EXPECT_FALSE(mz.contiguous());
+    EXPECT_EQ(mz[1], 200.5);
+    EXPECT_EQ(&mz[2], &peaks[2].mz);
+    EXPECT_EQ(mz.end() - mz.begin(), 3);
+
+    auto charge = view.column(&Peak::charge).vector();
+    EXPECT_EQ(charge, std::vector<LONG>({1, 2, 3}));
+    EXPECT_EQ(com::memberOffset(&Peak::intensity), offsetof(Peak, intensity));
+}
+
+
+TEST(SafeArrayView, RecordSize)
+{
+    struct Peak { DOUBLE mz; DOUBLE intensity; LONG charge; };
+    Peak peaks[2] = {{100.5, 10.0, 1}, {200.5, 20.0, 2}};
+    SAFEARRAY array = {};
+    array.cDims = 1;
+    array.fFeatures = FADF_RECORD;
+    array.cbElements = 2 * sizeof(DOUBLE);
+    array.pvData = peaks;
+    array.rgsabound[0].cElements = 2;
+
+    // a mismatched layout would stride through the wrong records
+    EXPECT_THROW(com::SafeArrayView<Peak> view(&array), std::invalid_argument);
+
+    array.cbElements = sizeof(Peak);
+    com::SafeArrayView<Peak> view(&array);
+    EXPECT_EQ(view.column(&Peak::charge).vector(), std::vector<LONG>({1, 2}));
 }
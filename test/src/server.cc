@@ -0,0 +1,218 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief IDispatch server test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace com = autocom;
+
+
+namespace
+{
+// OBJECTS
+// -------
+
+
+/** \brief Server exercising methods, accessors and data members.
+ */
+class Calculator: public com::DispatchImpl<Calculator>
+{
+protected:
+    DOUBLE scale = 1;
+
+    LONG add(LONG left, LONG right)
+    {
+        return left + right;
+    }
+
+    DOUBLE multiply(DOUBLE value) const
+    {
+        return value * scale;
+    }
+
+    BSTR name(BSTR prefix) const
+    {
+        std::wstring string(prefix, SysStringLen(prefix));
+        string += L"Calculator";
+        return SysAllocStringLen(string.data(), static_cast<UINT>(string.size()));
+    }
+
+    bool positive(LONG value) const
+    {
+        return value > 0;
+    }
+
+    DOUBLE getScale() const
+    {
+        return scale;
+    }
+
+    void setScale(DOUBLE value)
+    {
+        if (value == 0) {
+            throw std::invalid_argument("Scale cannot be zero.");
+        }
+        scale = value;
+    }
+
+public:
+    LONG total = 0;
+
+    AUTOCOM_DISPATCH_BEGIN(Calculator)
+        AUTOCOM_DISPATCH_METHOD(L"Add", 1, &Calculator::add)
+        AUTOCOM_DISPATCH_METHOD(L"Multiply", 2, &Calculator::multiply)
+        AUTOCOM_DISPATCH_METHOD(L"Name", 3, &Calculator::name)
+        AUTOCOM_DISPATCH_METHOD(L"Positive", 4, &Calculator::positive)
+        AUTOCOM_DISPATCH_GET(L"Scale", 5, &Calculator::getScale)
+        AUTOCOM_DISPATCH_PUT(L"Scale", 5, &Calculator::setScale)
+        AUTOCOM_DISPATCH_PROPERTY(L"Total", 6, &Calculator::total)
+    AUTOCOM_DISPATCH_END()
+};
+
+}   /* anonymous */
+
+// TESTS
+// -----
+
+
+TEST(DispatchImpl, GetIDsOfNames)
+{
+    Calculator *calculator = new Calculator;
+    LPOLESTR names[2] = {const_cast<LPOLESTR>(L"multiply"), const_cast<LPOLESTR>(L"value")};
+    DISPID ids[2];
+
+    EXPECT_EQ(calculator->GetIDsOfNames(IID_NULL, names, 1, LOCALE_USER_DEFAULT, ids), S_OK);
+    EXPECT_EQ(ids[0], 2);
+    EXPECT_EQ(calculator->GetIDsOfNames(IID_NULL, names, 2, LOCALE_USER_DEFAULT, ids), DISP_E_UNKNOWNNAME);
+    EXPECT_EQ(ids[0], 2);
+    EXPECT_EQ(ids[1], DISPID_UNKNOWN);
+    EXPECT_EQ(calculator->GetIDsOfNames(IID_NULL, names + 1, 1, LOCALE_USER_DEFAULT, ids), DISP_E_UNKNOWNNAME);
+    EXPECT_EQ(ids[0], DISPID_UNKNOWN);
+
+    // every member resolves, whatever the case
+    for (const wchar_t *name: {L"ADD", L"Name", L"positive", L"scale", L"toTAL"}) {
+        names[0] = const_cast<LPOLESTR>(name);
+        EXPECT_EQ(calculator->GetIDsOfNames(IID_NULL, names, 1, LOCALE_USER_DEFAULT, ids), S_OK);
+    }
+
+    EXPECT_EQ(calculator->Release(), 0);
+}
+
+
+TEST(DispatchImpl, Invoke)
+{
+    com::DispatchBase dispatch(new Calculator);
+
+    LONG sum = 0;
+    EXPECT_TRUE(dispatch.method(L"Add", 2, 3));
+    EXPECT_EQ(dispatch.methodV(L"Add", 2, 3).lVal, 5);
+
+    // arguments are coerced to the parameter type
+    com::Variant product = dispatch.methodV(L"Multiply", 4);
+    EXPECT_EQ(product.vt, VT_R8);
+    EXPECT_EQ(product.dblVal, 4.0);
+    com::Variant sumV = dispatch.methodV(L"Add", L"7", 1.0);
+    sumV.get(sum);
+    EXPECT_EQ(sum, 8);
+
+    com::Variant name = dispatch.methodV(L"Name", L"My ");
+    EXPECT_EQ(std::wstring(name.bstrVal), L"My Calculator");
+
+    com::Variant positive = dispatch.methodV(L"Positive", 3);
+    EXPECT_EQ(positive.vt, VT_BOOL);
+    EXPECT_EQ(positive.boolVal, VARIANT_TRUE);
+}
+
+
+TEST(DispatchImpl, Properties)
+{
+    Calculator *calculator = new Calculator;
+    calculator->AddRef();
+    com::DispatchBase dispatch(calculator);
+
+    DOUBLE scale = 0;
+    EXPECT_TRUE(dispatch.put(L"Scale", 2.5));
+    EXPECT_TRUE(dispatch.get(L"Scale", scale));
+    EXPECT_EQ(scale, 2.5);
+    EXPECT_EQ(dispatch.methodV(L"Multiply", 2).dblVal, 5.0);
+
+    LONG total = 0;
+    EXPECT_TRUE(dispatch.put(L"Total", 12));
+    EXPECT_EQ(calculator->total, 12);
+    EXPECT_TRUE(dispatch.get(L"Total", total));
+    EXPECT_EQ(total, 12);
+
+    dispatch.reset();
+    EXPECT_EQ(calculator->Release(), 0);
+}
+
+
+TEST(DispatchImpl, Errors)
+{
+    Calculator *calculator = new Calculator;
+    VARIANT arguments[2];
+    arguments[0].vt = VT_I4;
+    arguments[0].lVal = 1;
+    arguments[1].vt = VT_NULL;
+    DISPPARAMS dp = {arguments, nullptr, 2, 0};
+    VARIANT result;
+    VariantInit(&result);
+    UINT error = 0;
+
+    // unknown members and kinds
+    EXPECT_EQ(calculator->Invoke(42, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &dp, &result, nullptr, &error), DISP_E_MEMBERNOTFOUND);
+    EXPECT_EQ(calculator->Invoke(1, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_PROPERTYPUT, &dp, &result, nullptr, &error), DISP_E_MEMBERNOTFOUND);
+
+    // argument count and types
+    dp.cArgs = 1;
+    EXPECT_EQ(calculator->Invoke(1, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &dp, &result, nullptr, &error), DISP_E_BADPARAMCOUNT);
+    dp.cArgs = 2;
+    EXPECT_EQ(calculator->Invoke(1, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &dp, &result, nullptr, &error), DISP_E_TYPEMISMATCH);
+    EXPECT_EQ(error, 1);
+
+    // named arguments other than the value of a put
+    DISPID named = 0;
+    dp.rgdispidNamedArgs = &named;
+    dp.cNamedArgs = 1;
+    EXPECT_EQ(calculator->Invoke(1, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &dp, &result, nullptr, &error), DISP_E_NONAMEDARGS);
+
+    // exceptions thrown by the member
+    EXCEPINFO exception;
+    arguments[0].vt = VT_R8;
+    arguments[0].dblVal = 0;
+    named = DISPID_PROPERTYPUT;
+    dp.cArgs = 1;
+    EXPECT_EQ(calculator->Invoke(5, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_PROPERTYPUT, &dp, nullptr, &exception, &error), DISP_E_EXCEPTION);
+    EXPECT_EQ(std::wstring(exception.bstrSource), L"Scale");
+    EXPECT_EQ(std::wstring(exception.bstrDescription), L"Scale cannot be zero.");
+    SysFreeString(exception.bstrSource);
+    SysFreeString(exception.bstrDescription);
+
+    EXPECT_EQ(calculator->Release(), 0);
+}
+
+
+TEST(DispatchImpl, QueryInterface)
+{
+    Calculator *calculator = new Calculator;
+    IDispatch *dispatch = nullptr;
+    EXPECT_EQ(calculator->QueryInterface(IID_IDispatch, (void**) &dispatch), S_OK);
+    EXPECT_EQ(dispatch, calculator);
+    EXPECT_EQ(dispatch->Release(), 1);
+
+    IUnknown *unknown = nullptr;
+    EXPECT_EQ(calculator->QueryInterface(IID_IEnumVARIANT, (void**) &unknown), E_NOINTERFACE);
+    EXPECT_EQ(unknown, nullptr);
+
+    UINT count = 1;
+    EXPECT_EQ(calculator->GetTypeInfoCount(&count), S_OK);
+    EXPECT_EQ(count, 0);
+    EXPECT_EQ(calculator->Release(), 0);
+}
@@ -0,0 +1,215 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief IDispatch tracing test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace com = autocom;
+
+
+// HELPERS
+// -------
+
+
+/** \brief Dispatch object which fails calls to negative DISPIDs.
+ */
+struct FakeDispatch: IDispatch
+{
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+        void **ppv) override
+    {
+        return E_NOINTERFACE;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return 1;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release() override
+    {
+        return 1;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfoCount(UINT *count) override
+    {
+        *count = 0;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetTypeInfo(UINT index,
+        LCID locale,
+        ITypeInfo **info) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetIDsOfNames(REFIID iid,
+        LPOLESTR *names,
+        UINT count,
+        LCID locale,
+        DISPID *ids) override
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Invoke(DISPID member,
+        REFIID iid,
+        LCID locale,
+        WORD flags,
+        DISPPARAMS *params,
+        VARIANT *result,
+        EXCEPINFO *exception,
+        UINT *error) override
+    {
+        return member < 0 ? DISP_E_MEMBERNOTFOUND : S_OK;
+    }
+};
+
+// TESTS
+// -----
+
+
+TEST(Trace, Histogram)
+{
+    com::trace::Histogram histogram;
+    EXPECT_EQ(histogram.percentile(50), 0);
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        histogram.record(i * 1000);
+    }
+
+    EXPECT_EQ(histogram.count(), 1000);
+    EXPECT_EQ(histogram.minimum(), 1000);
+    EXPECT_EQ(histogram.maximum(), 1000000);
+    EXPECT_EQ(histogram.mean(), 500500);
+    for (double percent: {1.0, 50.0, 90.0, 99.0}) {
+        const double exact = percent * 10000;
+        const double value = double(histogram.percentile(percent));
+        EXPECT_TRUE(value >= exact && value <= exact * 17 / 16);
+    }
+    EXPECT_EQ(histogram.percentile(100), 1000000);
+
+    // buckets are contiguous
+    for (size_t i = 1; i < 200; ++i) {
+        EXPECT_EQ(com::trace::Histogram::bucket(com::trace::Histogram::lower(i)), i);
+        EXPECT_EQ(com::trace::Histogram::bucket(com::trace::Histogram::lower(i) - 1), i - 1);
+    }
+}
+
+
+TEST(Trace, Record)
+{
+    FakeDispatch dispatch;
+    com::trace::enable();
+    com::trace::clear();
+
+    // keep both threads alive, since exited threads' rings are reused
+    DISPPARAMS params = {nullptr, nullptr, 0, 0};
+    std::atomic<int> running(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 2; ++i) {
+        threads.emplace_back([&]() {
+            for (size_t j = 0; j < 100; ++j) {
+                com::trace::invoke(&dispatch, 1, L"Value", DISPATCH_PROPERTYGET, &params, nullptr);
+            }
+            EXPECT_EQ(com::trace::invoke(&dispatch, -5, nullptr, DISPATCH_METHOD, &params, nullptr), DISP_E_MEMBERNOTFOUND);
+            ++running;
+            while (running < 2) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    com::trace::enable(false);
+
+    auto events = com::trace::events();
+    ASSERT_EQ(events.size(), 202);
+    for (size_t i = 1; i < events.size(); ++i) {
+        EXPECT_TRUE(events[i - 1].start <= events[i].start);
+    }
+
+    auto statistics = com::trace::statistics();
+    ASSERT_EQ(statistics.size(), 2);
+    for (const auto &member: statistics) {
+        if (member.member == 1) {
+            EXPECT_EQ(member.name, "Value");
+            EXPECT_EQ(member.latency.count(), 200);
+            EXPECT_EQ(member.failures, 0);
+        } else {
+            EXPECT_EQ(member.name, "DISPID -5");
+            EXPECT_EQ(member.latency.count(), 2);
+            EXPECT_EQ(member.failures, 2);
+        }
+    }
+
+    auto trace = com::trace::chromeTrace();
+    EXPECT_EQ(trace.find("{\"traceEvents\":["), 0);
+    EXPECT_NE(trace.find("\"name\":\"Value\",\"cat\":\"com\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(trace.find("\"hr\":\"0x80020003\""), std::string::npos);
+
+    com::trace::clear();
+    EXPECT_TRUE(com::trace::events().empty());
+    EXPECT_TRUE(com::trace::statistics().empty());
+}
+
+
+TEST(Trace, Overwrite)
+{
+    FakeDispatch dispatch;
+    com::trace::enable();
+    com::trace::clear();
+
+    DISPPARAMS params = {nullptr, nullptr, 0, 0};
+    for (size_t i = 0; i < com::trace::RING_SIZE + 10; ++i) {
+        com::trace::invoke(&dispatch, 2, nullptr, DISPATCH_METHOD, &params, nullptr);
+    }
+    com::trace::enable(false);
+
+    EXPECT_EQ(com::trace::events().size(), com::trace::RING_SIZE);
+    EXPECT_EQ(com::trace::statistics().front().latency.count(), com::trace::RING_SIZE + 10);
+    com::trace::clear();
+}
+
+
+TEST(Trace, Recycle)
+{
+    FakeDispatch dispatch;
+    com::trace::enable();
+    com::trace::clear();
+
+    // rings of exited threads are reused, keeping their histograms
+    DISPPARAMS params = {nullptr, nullptr, 0, 0};
+    std::vector<uint32_t> indexes;
+    for (size_t i = 0; i < 4; ++i) {
+        std::thread thread([&]() {
+            for (size_t j = 0; j < 10; ++j) {
+                com::trace::invoke(&dispatch, 3, nullptr, DISPATCH_METHOD, &params, nullptr);
+            }
+        });
+        thread.join();
+
+        auto events = com::trace::events();
+        ASSERT_EQ(events.size(), 10);
+        indexes.push_back(events.front().thread);
+    }
+    com::trace::enable(false);
+
+    EXPECT_EQ(indexes, std::vector<uint32_t>(4, indexes.front()));
+    auto statistics = com::trace::statistics();
+    ASSERT_EQ(statistics.size(), 1);
+    EXPECT_EQ(statistics.front().latency.count(), 40);
+
+    com::trace::clear();
+    EXPECT_TRUE(com::trace::statistics().empty());
+}
@@ -70,8 +70,10 @@ TEST(VariantType, Types)
     TEST_VARIANT_TYPE(UCHAR, VT_UI1)();
     TEST_VARIANT_TYPE(SHORT, VT_I2)();
     TEST_VARIANT_TYPE(USHORT, VT_UI2)();
+#if !defined(AUTOCOM_LONG_IS_INT)
     TEST_VARIANT_TYPE(INT, VT_INT)();
     TEST_VARIANT_TYPE(UINT, VT_UINT)();
+#endif          // AUTOCOM_LONG_IS_INT
     TEST_VARIANT_TYPE(LONG, VT_I4)();
     TEST_VARIANT_TYPE(ULONG, VT_UI4)();
     TEST_VARIANT_TYPE(LONGLONG, VT_I8)();
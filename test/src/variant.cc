@@ -146,8 +146,10 @@ TEST(Variant, Set)
     TEST_SET(UCHAR)(variant, VT_UI1);
     TEST_SET(SHORT)(variant, VT_I2);
     TEST_SET(USHORT)(variant, VT_UI2);
+#if !defined(AUTOCOM_LONG_IS_INT)
     TEST_SET(INT)(variant, VT_INT);
     TEST_SET(UINT)(variant, VT_UINT);
+#endif          // AUTOCOM_LONG_IS_INT
     TEST_SET(LONG)(variant, VT_I4);
     TEST_SET(ULONG)(variant, VT_UI4);
     TEST_SET(FLOAT)(variant, VT_R4);
@@ -0,0 +1,166 @@
+//  :copyright: (c) 2016 The Regents of the University of California.
+//  :license: MIT, see LICENSE.md for more details.
+/*
+ *  \addtogroup AutoComTests
+ *  \brief Apartment configuration and STA worker test suite.
+ */
+
+#include <autocom.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace com = autocom;
+
+
+namespace
+{
+// HELPERS
+// -------
+
+
+/** \brief Apartment-threaded object, which records misuse.
+ */
+struct Server
+{
+    static std::atomic<int> violations;
+    std::thread::id owner;
+    int calls = 0;
+
+    Server():
+        owner(std::this_thread::get_id())
+    {}
+
+    Server(const Server &other):
+        owner(std::this_thread::get_id()),
+        calls(other.calls)
+    {}
+
+    ~Server()
+    {
+        check();
+    }
+
+    void check() const
+    {
+        if (owner != std::this_thread::get_id()) {
+            ++violations;
+        }
+    }
+};
+
+std::atomic<int> Server::violations(0);
+
+}   /* anonymous */
+
+// TESTS
+// -----
+
+
+TEST(Apartment, Configure)
+{
+    std::thread thread([]() {
+        com::ApartmentConfig config;
+        config.model = com::APARTMENT_STA;
+        com::configureApartment(config);
+        com::initialize();
+        EXPECT_EQ(com::apartmentConfig().model, com::APARTMENT_STA);
+
+        config.model = com::APARTMENT_MTA;
+        EXPECT_THROW(com::configureApartment(config), std::runtime_error);
+        com::uninitialize();
+
+        com::configureApartment(config);
+        EXPECT_EQ(com::apartmentConfig().model, com::APARTMENT_MTA);
+    });
+    thread.join();
+}
+
+
+TEST(StaWorker, Submit)
+{
+    com::StaWorker worker;
+    auto id = worker.invoke([]() {
+        return std::this_thread::get_id();
+    });
+    EXPECT_NE(id, std::this_thread::get_id());
+    EXPECT_EQ(worker.invoke([]() { return com::apartmentConfig().model; }), com::APARTMENT_STA);
+
+    // calls run in order, and nested calls do not wait on the queue
+    std::vector<int> order;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.emplace_back(worker.submit([&order, i]() {
+            order.push_back(i);
+        }));
+    }
+    for (auto &future: futures) {
+        future.get();
+    }
+    ASSERT_EQ(order.size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+    EXPECT_EQ(worker.invoke([&worker]() {
+        return worker.invoke([]() { return 1; });
+    }), 1);
+
+    EXPECT_THROW(worker.invoke([]() -> int {
+        throw std::runtime_error("Server failed.");
+    }), std::runtime_error);
+}
+
+
+TEST(StaWorker, Stop)
+{
+    com::StaWorker worker;
+    std::atomic<int> calls(0);
+    for (int i = 0; i < 10; ++i) {
+        worker.submit([&calls]() { ++calls; });
+    }
+    worker.stop();
+    EXPECT_EQ(calls, 10);
+    EXPECT_THROW(worker.submit([]() {}), std::runtime_error);
+}
+
+
+TEST(StaPool, Pin)
+{
+    com::StaPool pool(2);
+    EXPECT_EQ(pool.size(), 2);
+
+    std::vector<com::Pinned<Server>> servers;
+    for (int i = 0; i < 4; ++i) {
+        servers.emplace_back(pool.pin([]() { return Server(); }));
+    }
+    EXPECT_EQ(&servers[0].worker(), &servers[2].worker());
+    EXPECT_NE(&servers[0].worker(), &servers[1].worker());
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&servers]() {
+            for (auto &server: servers) {
+                for (int j = 0; j < 50; ++j) {
+                    server.submit([](Server &object) {
+                        object.check();
+                        ++object.calls;
+                    });
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    for (auto &server: servers) {
+        EXPECT_EQ(server.invoke([](Server &object) { return object.calls; }), 200);
+    }
+    servers.clear();
+    pool.worker(0).invoke([]() {});
+    pool.worker(1).invoke([]() {});
+    EXPECT_EQ(Server::violations, 0);
+}